@@ -232,6 +232,8 @@ class OrbitConan(ConanFile):
                 self.name, self._version()), symlinks=True)
             self.copy("OrbitService", src="bin/",
                       dst="{}-{}/opt/developer/tools/".format(self.name, self._version()))
+            self.copy("libOrbitUserSpaceInstrumentation.so", src="lib/",
+                      dst="{}-{}/opt/developer/tools/".format(self.name, self._version()))
             self.copy("NOTICE",
                       dst="{}-{}/usr/share/doc/{}/".format(self.name, self._version(), self.name))
             self.copy("LICENSE",
@@ -281,6 +283,7 @@ chmod -v 4775 /opt/developer/tools/OrbitService
         self.copy("NOTICE.Chromium.csv")
         self.copy("LICENSE")
         self.copy("libOrbitVulkanLayer.so", src="lib/", dst="lib")
+        self.copy("libOrbitUserSpaceInstrumentation.so", src="lib/", dst="lib")
         self.copy("VkLayer_Orbit_implicit.json", src="lib/", dst="lib")
         self.copy("LinuxTracingIntegrationTests", src="bin/", dst="bin")
         self.copy("LinuxTracingIntegrationTests.debug", src="bin/", dst="bin")
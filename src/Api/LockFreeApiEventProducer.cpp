@@ -0,0 +1,196 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "Api/LockFreeApiEventProducer.h"
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/str_format.h>
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ThreadUtils.h"
+
+namespace orbit_api {
+
+using orbit_producer_side_channel::kSharedMemoryRingBufferNamePrefix;
+using orbit_producer_side_channel::SharedMemoryRecordType;
+using orbit_producer_side_channel::SharedMemoryRingBuffer;
+
+namespace {
+
+// 1 MB per thread. OrbitService reads the ring buffers every millisecond.
+constexpr uint64_t kRingBufferCapacity = 16 * 1024;
+
+}  // namespace
+
+// Everything the producer keeps per thread, grouped so that a single thread_local lookup gives
+// access to all of it. When the thread exits, its ring buffer is closed so that
+// OrbitService drops it once it has read the remaining events.
+struct LockFreeApiEventProducer::ThreadState {
+  ~ThreadState() {
+    if (ring_buffer != nullptr) ring_buffer->Close();
+  }
+
+  std::shared_ptr<SharedMemoryRingBuffer> ring_buffer;
+  bool ring_buffer_creation_failed = false;
+  // Used when events go through the lock-free queue.
+  std::optional<moodycamel::ProducerToken> producer_token;
+  // The capture the following fields refer to.
+  uint64_t capture_id = 0;
+  // Set when the ring buffer was full: the thread then uses the lock-free queue for the rest of the
+  // capture. Switching only once keeps the later events of the thread in order, only the events
+  // around the switch can reach OrbitService out of order.
+  bool ring_buffer_overflowed = false;
+  // The keys of the names that the thread has sent through the transport it currently uses.
+  absl::flat_hash_set<uint64_t> interned_name_keys;
+};
+
+LockFreeApiEventProducer::ThreadState& LockFreeApiEventProducer::GetThreadState(
+    uint64_t capture_id) {
+  thread_local ThreadState thread_state;
+  if (thread_state.capture_id != capture_id) {
+    thread_state.capture_id = capture_id;
+    thread_state.ring_buffer_overflowed = false;
+    thread_state.interned_name_keys.clear();
+  }
+  return thread_state;
+}
+
+void LockFreeApiEventProducer::EnqueueApiEvent(const orbit_api::ApiEvent& api_event) {
+  ThreadState& thread_state = GetThreadState(GetCaptureId());
+  if (!TryWriteToRingBuffer(thread_state, api_event)) EnqueueIntoQueue(thread_state, api_event);
+}
+
+void LockFreeApiEventProducer::EnqueueApiEventWithInternedName(const orbit_api::ApiEvent& api_event,
+                                                               const char* name) {
+  ThreadState& thread_state = GetThreadState(GetCaptureId());
+  const uint64_t key = api_event.encoded_event.InternedNameKey();
+  if (!thread_state.interned_name_keys.contains(key)) {
+    EnqueueInternedName(thread_state, api_event, name);
+  }
+  if (TryWriteToRingBuffer(thread_state, api_event)) return;
+  // OrbitService tells the transports apart, so if the ring buffer was full just now, the name
+  // needs to be sent again through the lock-free queue.
+  if (!thread_state.interned_name_keys.contains(key)) {
+    EnqueueInternedName(thread_state, api_event, name);
+  }
+  EnqueueIntoQueue(thread_state, api_event);
+}
+
+bool LockFreeApiEventProducer::TryWriteToRingBuffer(ThreadState& thread_state,
+                                                    const orbit_api::ApiEvent& api_event) {
+  if (!AreSharedMemoryRingBuffersSupported() || thread_state.ring_buffer_overflowed) return false;
+  SharedMemoryRingBuffer* ring_buffer = thread_state.ring_buffer.get();
+  if (ring_buffer == nullptr) ring_buffer = GetRingBufferOfCurrentThread(thread_state);
+  if (ring_buffer == nullptr) return false;
+  if (ring_buffer->TryWrite(api_event)) return true;
+
+  thread_state.ring_buffer_overflowed = true;
+  thread_state.interned_name_keys.clear();
+  ++num_ring_buffer_overflows_;
+  return false;
+}
+
+void LockFreeApiEventProducer::EnqueueIntoQueue(ThreadState& thread_state,
+                                                const orbit_api::ApiEvent& api_event) {
+  if (!thread_state.producer_token.has_value()) {
+    thread_state.producer_token.emplace(CreateProducerToken());
+  }
+  EnqueueIntermediateEvent(thread_state.producer_token.value(), api_event);
+}
+
+void LockFreeApiEventProducer::EnqueueInternedName(ThreadState& thread_state,
+                                                   const orbit_api::ApiEvent& api_event,
+                                                   const char* name) {
+  constexpr size_t kChunkSize = orbit_api::kMaxEventStringSize - 1;
+  const size_t name_size = std::strlen(name);
+  const bool ring_buffer_overflowed = thread_state.ring_buffer_overflowed;
+  // The last chunk is shorter than kChunkSize, possibly empty.
+  for (size_t offset = 0; offset <= name_size; offset += kChunkSize) {
+    orbit_api::ApiEvent chunk{api_event.pid,
+                              api_event.tid,
+                              api_event.timestamp_ns,
+                              orbit_api::kInternString,
+                              name + offset,
+                              api_event.encoded_event.InternedNameKey(),
+                              static_cast<orbit_api_color>(offset)};
+    if (!TryWriteToRingBuffer(thread_state, chunk)) EnqueueIntoQueue(thread_state, chunk);
+  }
+  // If the ring buffer got full in the middle of the name, the lock-free queue only got its end.
+  if (!ring_buffer_overflowed && thread_state.ring_buffer_overflowed) {
+    EnqueueInternedName(thread_state, api_event, name);
+    return;
+  }
+  thread_state.interned_name_keys.insert(api_event.encoded_event.InternedNameKey());
+}
+
+SharedMemoryRingBuffer* LockFreeApiEventProducer::GetRingBufferOfCurrentThread(
+    ThreadState& thread_state) {
+  if (thread_state.ring_buffer != nullptr) return thread_state.ring_buffer.get();
+  if (thread_state.ring_buffer_creation_failed) return nullptr;
+
+  // The name only helps debugging, OrbitService finds ring buffers by their file descriptors.
+  const std::string name =
+      absl::StrFormat("%s%u", kSharedMemoryRingBufferNamePrefix, ring_buffer_counter_++);
+  ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> ring_buffer =
+      SharedMemoryRingBuffer::Create(name, SharedMemoryRecordType::kApiEvent,
+                                     sizeof(orbit_api::ApiEvent), kRingBufferCapacity);
+  if (ring_buffer.has_error()) {
+    ERROR("Creating shared memory ring buffer, falling back to gRPC: %s",
+          ring_buffer.error().message());
+    thread_state.ring_buffer_creation_failed = true;
+    return nullptr;
+  }
+
+  thread_state.ring_buffer = std::move(ring_buffer.value());
+  absl::MutexLock lock{&ring_buffers_mutex_};
+  ring_buffers_.push_back(thread_state.ring_buffer);
+  return thread_state.ring_buffer.get();
+}
+
+void LockFreeApiEventProducer::OnCaptureStop() {
+  if (AreSharedMemoryRingBuffersSupported()) {
+    // Wait without holding the mutex, so that threads can keep creating their ring buffers.
+    std::vector<std::shared_ptr<SharedMemoryRingBuffer>> ring_buffers;
+    {
+      absl::MutexLock lock{&ring_buffers_mutex_};
+      ring_buffers = ring_buffers_;
+    }
+    constexpr absl::Duration kMaxWaitForRingBuffersToBeRead = absl::Seconds(5);
+    const absl::Time deadline = absl::Now() + kMaxWaitForRingBuffersToBeRead;
+    for (const auto& ring_buffer : ring_buffers) {
+      while (!ring_buffer->IsEmpty() && absl::Now() < deadline) {
+        absl::SleepFor(absl::Milliseconds(1));
+      }
+      if (!ring_buffer->IsEmpty()) {
+        ERROR("OrbitService did not read all events from \"%s\"", ring_buffer->path().string());
+      }
+    }
+
+    // OrbitService drops closed ring buffers once read, they are no longer needed here.
+    absl::MutexLock lock{&ring_buffers_mutex_};
+    ring_buffers_.erase(std::remove_if(ring_buffers_.begin(), ring_buffers_.end(),
+                                       [](const std::shared_ptr<SharedMemoryRingBuffer>& buffer) {
+                                         return buffer->IsClosed();
+                                       }),
+                        ring_buffers_.end());
+  }
+
+  const uint64_t num_ring_buffer_overflows = num_ring_buffer_overflows_.exchange(0);
+  if (num_ring_buffer_overflows > 0) {
+    LOG("The shared memory ring buffers of %u threads were full, they switched to gRPC",
+        num_ring_buffer_overflows);
+  }
+
+  LockFreeBufferCaptureEventProducer::OnCaptureStop();
+}
+
+}  // namespace orbit_api
@@ -10,29 +10,64 @@
 #include "OrbitBase/Profiling.h"
 #include "OrbitBase/ThreadUtils.h"
 
+static orbit_api::LockFreeApiEventProducer& GetProducer() {
+  static orbit_api::LockFreeApiEventProducer producer;
+  return producer;
+}
+
+// The time stamp counter is cheaper to read than CLOCK_MONOTONIC. OrbitService converts its values,
+// and only allows them if the time stamp counter is synchronized across CPUs.
+static uint64_t GetApiEventTimestamp(const orbit_api::LockFreeApiEventProducer& producer) {
+  if (producer.AreTscApiEventTimestampsSupported()) {
+    return orbit_base::ReadTsc() | orbit_api::kTscTimestampBit;
+  }
+  return orbit_base::CaptureTimestampNs();
+}
+
 static void EnqueueApiEvent(orbit_api::EventType type, const char* name = nullptr,
                             uint64_t data = 0, orbit_api_color color = kOrbitColorAuto) {
-  static orbit_api::LockFreeApiEventProducer producer;
+  orbit_api::LockFreeApiEventProducer& producer = GetProducer();
   if (!producer.IsCapturing()) return;
 
   static pid_t pid = orbit_base::GetCurrentProcessId();
   thread_local uint32_t tid = orbit_base::GetCurrentThreadId();
-  uint64_t timestamp_ns = orbit_base::CaptureTimestampNs();
+  uint64_t timestamp_ns = GetApiEventTimestamp(producer);
 
   orbit_api::ApiEvent api_event(pid, tid, timestamp_ns, type, name, data, color);
-  producer.EnqueueIntermediateEvent(api_event);
+  producer.EnqueueApiEvent(api_event);
+}
+
+// Only the key of `name` is copied into the event, unless OrbitService doesn't support interned
+// names.
+static void EnqueueApiEventWithInternedName(orbit_api::EventType type, const char* name,
+                                            uint64_t name_key, uint64_t data,
+                                            orbit_api_color color) {
+  orbit_api::LockFreeApiEventProducer& producer = GetProducer();
+  if (!producer.IsCapturing()) return;
+  if (name == nullptr || !producer.AreInternedApiEventNamesSupported()) {
+    EnqueueApiEvent(type, name, data, color);
+    return;
+  }
+
+  static pid_t pid = orbit_base::GetCurrentProcessId();
+  thread_local uint32_t tid = orbit_base::GetCurrentThreadId();
+  uint64_t timestamp_ns = GetApiEventTimestamp(producer);
+
+  orbit_api::ApiEvent api_event(pid, tid, timestamp_ns, type, /*name=*/nullptr, data, color);
+  api_event.encoded_event.SetInternedNameKey(name_key);
+  producer.EnqueueApiEventWithInternedName(api_event, name);
 }
 
 extern "C" {
 
 void orbit_api_start(const char* name, orbit_api_color color) {
-  EnqueueApiEvent(orbit_api::EventType::kScopeStart, name, /*data=*/0, color);
+  orbit_api_start_interned(name, orbit_api::StringKey(name), color);
 }
 
 void orbit_api_stop() { EnqueueApiEvent(orbit_api::EventType::kScopeStop); }
 
 void orbit_api_start_async(const char* name, uint64_t id, orbit_api_color color) {
-  EnqueueApiEvent(orbit_api::EventType::kScopeStartAsync, name, id, color);
+  orbit_api_start_async_interned(name, orbit_api::StringKey(name), id, color);
 }
 
 void orbit_api_stop_async(uint64_t id) {
@@ -40,27 +75,27 @@ void orbit_api_stop_async(uint64_t id) {
 }
 
 void orbit_api_track_int(const char* name, int value, orbit_api_color color) {
-  EnqueueApiEvent(orbit_api::kTrackInt, name, orbit_api::Encode<uint64_t>(value), color);
+  orbit_api_track_int_interned(name, orbit_api::StringKey(name), value, color);
 }
 
 void orbit_api_track_int64(const char* name, int64_t value, orbit_api_color color) {
-  EnqueueApiEvent(orbit_api::kTrackInt64, name, orbit_api::Encode<uint64_t>(value), color);
+  orbit_api_track_int64_interned(name, orbit_api::StringKey(name), value, color);
 }
 
 void orbit_api_track_uint(const char* name, uint32_t value, orbit_api_color color) {
-  EnqueueApiEvent(orbit_api::kTrackUint, name, orbit_api::Encode<uint64_t>(value), color);
+  orbit_api_track_uint_interned(name, orbit_api::StringKey(name), value, color);
 }
 
 void orbit_api_track_uint64(const char* name, uint64_t value, orbit_api_color color) {
-  EnqueueApiEvent(orbit_api::kTrackUint64, name, orbit_api::Encode<uint64_t>(value), color);
+  orbit_api_track_uint64_interned(name, orbit_api::StringKey(name), value, color);
 }
 
 void orbit_api_track_float(const char* name, float value, orbit_api_color color) {
-  EnqueueApiEvent(orbit_api::kTrackFloat, name, orbit_api::Encode<uint64_t>(value), color);
+  orbit_api_track_float_interned(name, orbit_api::StringKey(name), value, color);
 }
 
 void orbit_api_track_double(const char* name, double value, orbit_api_color color) {
-  EnqueueApiEvent(orbit_api::kTrackDouble, name, orbit_api::Encode<uint64_t>(value), color);
+  orbit_api_track_double_interned(name, orbit_api::StringKey(name), value, color);
 }
 
 void orbit_api_async_string(const char* str, uint64_t id, orbit_api_color color) {
@@ -75,4 +110,49 @@ void orbit_api_async_string(const char* str, uint64_t id, orbit_api_color color)
     str += chunk_size;
   }
 }
+
+void orbit_api_start_interned(const char* name, uint64_t name_key, orbit_api_color color) {
+  EnqueueApiEventWithInternedName(orbit_api::kScopeStart, name, name_key, /*data=*/0, color);
+}
+
+void orbit_api_start_async_interned(const char* name, uint64_t name_key, uint64_t id,
+                                    orbit_api_color color) {
+  EnqueueApiEventWithInternedName(orbit_api::kScopeStartAsync, name, name_key, id, color);
+}
+
+void orbit_api_track_int_interned(const char* name, uint64_t name_key, int value,
+                                  orbit_api_color color) {
+  EnqueueApiEventWithInternedName(orbit_api::kTrackInt, name, name_key,
+                                  orbit_api::Encode<uint64_t>(value), color);
+}
+
+void orbit_api_track_int64_interned(const char* name, uint64_t name_key, int64_t value,
+                                    orbit_api_color color) {
+  EnqueueApiEventWithInternedName(orbit_api::kTrackInt64, name, name_key,
+                                  orbit_api::Encode<uint64_t>(value), color);
+}
+
+void orbit_api_track_uint_interned(const char* name, uint64_t name_key, uint32_t value,
+                                   orbit_api_color color) {
+  EnqueueApiEventWithInternedName(orbit_api::kTrackUint, name, name_key,
+                                  orbit_api::Encode<uint64_t>(value), color);
+}
+
+void orbit_api_track_uint64_interned(const char* name, uint64_t name_key, uint64_t value,
+                                     orbit_api_color color) {
+  EnqueueApiEventWithInternedName(orbit_api::kTrackUint64, name, name_key,
+                                  orbit_api::Encode<uint64_t>(value), color);
+}
+
+void orbit_api_track_float_interned(const char* name, uint64_t name_key, float value,
+                                    orbit_api_color color) {
+  EnqueueApiEventWithInternedName(orbit_api::kTrackFloat, name, name_key,
+                                  orbit_api::Encode<uint64_t>(value), color);
+}
+
+void orbit_api_track_double_interned(const char* name, uint64_t name_key, double value,
+                                     orbit_api_color color) {
+  EnqueueApiEventWithInternedName(orbit_api::kTrackDouble, name, name_key,
+                                  orbit_api::Encode<uint64_t>(value), color);
+}
 }
@@ -28,8 +28,18 @@ enum EventType : uint8_t {
   kTrackFloat = 9,
   kTrackDouble = 10,
   kString = 11,
+  // Registers the name of a kScopeStart, kScopeStartAsync or kTrack* event that only carries the
+  // key of its name, see EncodedEvent::SetInternedNameKey. The name is sent in chunks of up to
+  // kMaxEventStringSize - 1 characters: `data` holds the key, `color` the offset of the chunk in
+  // the name. A chunk shorter than kMaxEventStringSize - 1 characters terminates the name.
+  kInternString = 12,
 };
 
+// If this bit is set in ApiEvent::timestamp_ns, the other bits are a raw value of the time stamp
+// counter (see orbit_base::ReadTsc), which OrbitService converts. Producers only send such
+// timestamps if OrbitService supports them.
+constexpr uint64_t kTscTimestampBit = uint64_t{1} << 63;
+
 constexpr size_t kMaxEventStringSize = 34;
 struct Event {
   uint8_t version;                 // 1
@@ -68,6 +78,26 @@ union EncodedEvent {
   }
   orbit_api::EventType Type() const { return static_cast<orbit_api::EventType>(event.type); }
 
+  // Instead of its name, an event can carry the 64-bit key of a name registered with kInternString
+  // events. Such a name is empty and followed by kInternedNameMarker and the key, so that events
+  // encoded before interning was introduced, whose unused name characters are zero, are not
+  // mistaken for interned ones.
+  void SetInternedNameKey(uint64_t key) {
+    memset(event.name, 0, kMaxEventStringSize);
+    event.name[1] = kInternedNameMarker;
+    std::memcpy(event.name + 2, &key, sizeof(key));
+  }
+  [[nodiscard]] bool HasInternedName() const {
+    return event.name[0] == 0 && event.name[1] == kInternedNameMarker;
+  }
+  [[nodiscard]] uint64_t InternedNameKey() const {
+    uint64_t key = 0;
+    std::memcpy(&key, event.name + 2, sizeof(key));
+    return key;
+  }
+
+  static constexpr char kInternedNameMarker = 1;
+
   Event event;
   uint64_t args[6];
 };
@@ -5,14 +5,36 @@
 #ifndef API_LOCK_FREE_API_EVENT_PRODUCER_H_
 #define API_LOCK_FREE_API_EVENT_PRODUCER_H_
 
+#include <absl/synchronization/mutex.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "Api/EncodedEvent.h"
 #include "OrbitProducer/LockFreeBufferCaptureEventProducer.h"
 #include "ProducerSideChannel/ProducerSideChannel.h"
+#include "ProducerSideChannel/SharedMemoryRingBuffer.h"
 
 namespace orbit_api {
 
 // This class is used to enqueue orbit_api::ApiEvent events from multiple threads and relay them to
 // OrbitService in the form of orbit_grpc_protos::ApiEvent events.
+//
+// If OrbitService supports it, each thread writes its events into its own shared memory ring buffer
+// (orbit_producer_side_channel::SharedMemoryRingBuffer) that OrbitService reads directly: no
+// protobuf is built in the target process and the forwarder thread is not involved. Otherwise, if
+// a ring buffer can't be created, or once it was full, events go through the lock-free queue and
+// gRPC. Then too, each thread enqueues into its own sub-queue, which the forwarder thread drains in
+// bulk. No event is dropped.
+//
+// Events enqueued with EnqueueApiEventWithInternedName only carry the key of their name if
+// OrbitService supports it. The name itself is sent in orbit_api::kInternString events, in the
+// same stream, the first time a thread uses it in a capture.
+//
+// The state of each thread is kept in thread_local storage, so there must only be one instance of
+// this class per process.
 class LockFreeApiEventProducer
     : public orbit_producer::LockFreeBufferCaptureEventProducer<orbit_api::ApiEvent> {
  public:
@@ -22,7 +44,15 @@ class LockFreeApiEventProducer
 
   ~LockFreeApiEventProducer() { ShutdownAndWait(); }
 
+  void EnqueueApiEvent(const orbit_api::ApiEvent& api_event);
+  // `api_event` carries the interned name `name` (see orbit_api::EncodedEvent::SetInternedNameKey).
+  void EnqueueApiEventWithInternedName(const orbit_api::ApiEvent& api_event, const char* name);
+
  protected:
+  // Waits for OrbitService to read the events left in the shared memory ring buffers before
+  // AllEventsSent is sent.
+  void OnCaptureStop() override;
+
   [[nodiscard]] virtual orbit_grpc_protos::ProducerCaptureEvent* TranslateIntermediateEvent(
       orbit_api::ApiEvent&& raw_api_event, google::protobuf::Arena* arena) override {
     auto* capture_event =
@@ -39,6 +69,31 @@ class LockFreeApiEventProducer
     api_event->set_r5(raw_api_event.encoded_event.args[5]);
     return capture_event;
   }
+
+ private:
+  struct ThreadState;
+  // Returns the state of the calling thread, reset if it refers to an earlier capture.
+  [[nodiscard]] static ThreadState& GetThreadState(uint64_t capture_id);
+
+  // Returns the ring buffer of the calling thread, creating it on first use. Returns nullptr if it
+  // can't be created.
+  [[nodiscard]] orbit_producer_side_channel::SharedMemoryRingBuffer* GetRingBufferOfCurrentThread(
+      ThreadState& thread_state);
+  // Returns false if the event needs to go through the lock-free queue instead: ring buffers are
+  // not supported or could not be created, or the one of the thread is (or was) full.
+  [[nodiscard]] bool TryWriteToRingBuffer(ThreadState& thread_state,
+                                          const orbit_api::ApiEvent& api_event);
+  void EnqueueIntoQueue(ThreadState& thread_state, const orbit_api::ApiEvent& api_event);
+  // Sends `name` in kInternString events, through the transport the thread uses.
+  void EnqueueInternedName(ThreadState& thread_state, const orbit_api::ApiEvent& api_event,
+                           const char* name);
+
+  // All ring buffers created, including the ones of threads that have exited but whose events
+  // OrbitService has not read yet.
+  std::vector<std::shared_ptr<orbit_producer_side_channel::SharedMemoryRingBuffer>> ring_buffers_;
+  absl::Mutex ring_buffers_mutex_;
+  std::atomic<uint64_t> ring_buffer_counter_ = 0;
+  std::atomic<uint64_t> num_ring_buffer_overflows_ = 0;
 };
 
 }  // namespace orbit_api
@@ -43,6 +43,14 @@
 // degradation. Reducing overhead is our highest priority and we are actively working on a new
 // implementation that should be at least one order of magnitude faster.
 //
+// Names:
+// In C++, the names of scopes and tracks are identified by a 64-bit key computed with a constexpr
+// hash. For string literals, compilers evaluate it at compile time when optimizing (GCC and Clang
+// from -O1), unoptimized builds hash the name on every call. A name is sent to Orbit once
+// per thread and capture, after which events only carry its key: names are not truncated and are
+// not copied on every event. Note that the "name" arguments of the macros are evaluated twice,
+// once to compute their key.
+//
 // Integration:
 // To integrate the manual instrumentation API in your code base, simply include this header file.
 //
@@ -61,10 +69,6 @@
 // Overview:
 // ORBIT_SCOPE will profile the time between "now" and the end of the current scope.
 //
-// Note:
-// We limit the maximum number of characters of the "name" parameter to "kMaxEventStringSize". This
-// limitation may be lifted as we roll out a new dynamic instrumentation implementation.
-//
 // Example Usage: Profile sections of a function:
 //
 // void MyVeryLongFunction() {
@@ -79,12 +83,12 @@
 // }
 //
 // Parameters:
-// name: [const char*] Label to be displayed on current time slice (kMaxEventStringSize characters).
+// name: [const char*] Label to be displayed on current time slice.
 // col: [orbit_api_color] User-defined color for the current time slice (see orbit_api_color below).
 //
 #ifdef __cplusplus
 #define ORBIT_SCOPE(name) ORBIT_SCOPE_WITH_COLOR(name, kOrbitColorAuto)
-#define ORBIT_SCOPE_WITH_COLOR(name, col) orbit_api::Scope ORBIT_VAR(name, col)
+#define ORBIT_SCOPE_WITH_COLOR(name, col) orbit_api::Scope ORBIT_VAR(orbit_api::Name(name), col)
 #endif
 
 // ORBIT_START/ORBIT_STOP: Profile sections inside a scope.
@@ -96,8 +100,8 @@
 // 1. ORBIT_START and ORBIT_STOP need to be in the same scope. For start and stop operations that
 //    need to happen in different scopes or threads, use ORBIT_ASYNC_START/ORBIT_ASYNC_STOP.
 //
-// 2. We limit the maximum number of characters of the "name" parameter to "kMaxEventStringSize".
-//    This limitation may be lifted as we roll out a new dynamic instrumentation implementation.
+// 2. In C, we limit the maximum number of characters of the "name" parameter to
+//    "kMaxEventStringSize".
 //
 // Example Usage: Profile sections of a function:
 //
@@ -114,11 +118,16 @@
 // }
 //
 // Parameters:
-// name: [const char*] Label to be displayed on current time slice (kMaxEventStringSize characters).
+// name: [const char*] Label to be displayed on current time slice.
 // col: [orbit_api_color] User-defined color for the current time slice (see orbit_api_color below).
 //
-#define ORBIT_START(name) orbit_api_start(name, kOrbitColorAuto)
+#define ORBIT_START(name) ORBIT_START_WITH_COLOR(name, kOrbitColorAuto)
+#ifdef __cplusplus
+#define ORBIT_START_WITH_COLOR(name, color) \
+  orbit_api::CallInterned(orbit_api_start_interned, orbit_api::Name(name), color)
+#else
 #define ORBIT_START_WITH_COLOR(name, color) orbit_api_start(name, color)
+#endif
 #define ORBIT_STOP() orbit_api_stop()
 
 // ORBIT_START_ASYNC/ORBIT_STOP_ASYNC: Profile time spans across scopes or threads.
@@ -129,9 +138,9 @@
 // do not represent hierarchical information.
 //
 // Note:
-// We limit the maximum number of characters of the "name" parameter to "kMaxEventStringSize". This
-// limitation may be lifted as we roll out a new dynamic instrumentation implementation.
-// It is possible however to add per-time-slice strings using the ASYNC_STRING macro.
+// In C, we limit the maximum number of characters of the "name" parameter to
+// "kMaxEventStringSize". It is possible however to add per-time-slice strings using the
+// ASYNC_STRING macro.
 //
 // Example usage: Tracking "File IO" operations.
 // Thread 1: ORBIT_START_ASYNC("File IO", unique_64_bit_id);  // File IO request site.
@@ -146,8 +155,13 @@
 //     ORBIT_START_ASYNC and ORBIT_STOP_ASYNC calls. An id needs to be unique for the current track.
 // col: [orbit_api_color] User-defined color for the current time slice (see orbit_api_color below).
 //
-#define ORBIT_START_ASYNC(name, id) orbit_api_start_async(name, id, kOrbitColorAuto)
+#define ORBIT_START_ASYNC(name, id) ORBIT_START_ASYNC_WITH_COLOR(name, id, kOrbitColorAuto)
+#ifdef __cplusplus
+#define ORBIT_START_ASYNC_WITH_COLOR(name, id, color) \
+  orbit_api::CallInterned(orbit_api_start_async_interned, orbit_api::Name(name), id, color)
+#else
 #define ORBIT_START_ASYNC_WITH_COLOR(name, id, color) orbit_api_start_async(name, id, color)
+#endif
 #define ORBIT_STOP_ASYNC(id) orbit_api_stop_async(id)
 
 // ORBIT_ASYNC_STRING: Provide an additional string for an async time span.
@@ -180,8 +194,8 @@
 // Send values to be plotted over time in a track uniquely identified by "name".
 //
 // Note:
-// We limit the maximum number of characters of the "name" parameter to "kMaxEventStringSize". This
-// limitation may be lifted as we roll out a new dynamic instrumentation implementation.
+// In C, we limit the maximum number of characters of the "name" parameter to
+// "kMaxEventStringSize".
 //
 // Example usage: Graph the state of interesting variables over time:
 //
@@ -202,19 +216,34 @@
 // val: [int, int64_t, uint32_t, uint64_t, float, double] Value to be plotted.
 // col: [orbit_api_color] User-defined color for the current value (see orbit_api_color below).
 //
-#define ORBIT_INT(name, value) orbit_api_track_int(name, value, kOrbitColorAuto)
-#define ORBIT_INT64(name, value) orbit_api_track_int64(name, value, kOrbitColorAuto)
-#define ORBIT_UINT(name, value) orbit_api_track_uint(name, value, kOrbitColorAuto)
-#define ORBIT_UINT64(name, value) orbit_api_track_uint64(name, value, kOrbitColorAuto)
-#define ORBIT_FLOAT(name, value) orbit_api_track_float(name, value, kOrbitColorAuto)
-#define ORBIT_DOUBLE(name, value) orbit_api_track_double(name, value, kOrbitColorAuto)
+#define ORBIT_INT(name, value) ORBIT_INT_WITH_COLOR(name, value, kOrbitColorAuto)
+#define ORBIT_INT64(name, value) ORBIT_INT64_WITH_COLOR(name, value, kOrbitColorAuto)
+#define ORBIT_UINT(name, value) ORBIT_UINT_WITH_COLOR(name, value, kOrbitColorAuto)
+#define ORBIT_UINT64(name, value) ORBIT_UINT64_WITH_COLOR(name, value, kOrbitColorAuto)
+#define ORBIT_FLOAT(name, value) ORBIT_FLOAT_WITH_COLOR(name, value, kOrbitColorAuto)
+#define ORBIT_DOUBLE(name, value) ORBIT_DOUBLE_WITH_COLOR(name, value, kOrbitColorAuto)
 
+#ifdef __cplusplus
+#define ORBIT_INT_WITH_COLOR(name, value, color) \
+  orbit_api::CallInterned(orbit_api_track_int_interned, orbit_api::Name(name), value, color)
+#define ORBIT_INT64_WITH_COLOR(name, value, color) \
+  orbit_api::CallInterned(orbit_api_track_int64_interned, orbit_api::Name(name), value, color)
+#define ORBIT_UINT_WITH_COLOR(name, value, color) \
+  orbit_api::CallInterned(orbit_api_track_uint_interned, orbit_api::Name(name), value, color)
+#define ORBIT_UINT64_WITH_COLOR(name, value, color) \
+  orbit_api::CallInterned(orbit_api_track_uint64_interned, orbit_api::Name(name), value, color)
+#define ORBIT_FLOAT_WITH_COLOR(name, value, color) \
+  orbit_api::CallInterned(orbit_api_track_float_interned, orbit_api::Name(name), value, color)
+#define ORBIT_DOUBLE_WITH_COLOR(name, value, color) \
+  orbit_api::CallInterned(orbit_api_track_double_interned, orbit_api::Name(name), value, color)
+#else
 #define ORBIT_INT_WITH_COLOR(name, value, color) orbit_api_track_int(name, value, color)
 #define ORBIT_INT64_WITH_COLOR(name, value, color) orbit_api_track_int64(name, value, color)
 #define ORBIT_UINT_WITH_COLOR(name, value, color) orbit_api_track_uint(name, value, color)
 #define ORBIT_UINT64_WITH_COLOR(name, value, color) orbit_api_track_uint64(name, value, color)
 #define ORBIT_FLOAT_WITH_COLOR(name, value, color) orbit_api_track_float(name, value, color)
 #define ORBIT_DOUBLE_WITH_COLOR(name, value, color) orbit_api_track_double(name, value, color)
+#endif
 
 #else  // ORBIT_API_ENABLED
 
@@ -293,6 +322,23 @@ void orbit_api_track_uint64(const char* name, uint64_t value, orbit_api_color co
 void orbit_api_track_float(const char* name, float value, orbit_api_color color);
 void orbit_api_track_double(const char* name, double value, orbit_api_color color);
 
+// Variants of the functions above that also take the key of "name", see orbit_api::StringKey.
+void orbit_api_start_interned(const char* name, uint64_t name_key, orbit_api_color color);
+void orbit_api_start_async_interned(const char* name, uint64_t name_key, uint64_t id,
+                                    orbit_api_color color);
+void orbit_api_track_int_interned(const char* name, uint64_t name_key, int value,
+                                  orbit_api_color color);
+void orbit_api_track_int64_interned(const char* name, uint64_t name_key, int64_t value,
+                                    orbit_api_color color);
+void orbit_api_track_uint_interned(const char* name, uint64_t name_key, uint32_t value,
+                                   orbit_api_color color);
+void orbit_api_track_uint64_interned(const char* name, uint64_t name_key, uint64_t value,
+                                     orbit_api_color color);
+void orbit_api_track_float_interned(const char* name, uint64_t name_key, float value,
+                                    orbit_api_color color);
+void orbit_api_track_double_interned(const char* name, uint64_t name_key, double value,
+                                     orbit_api_color color);
+
 #ifdef __cplusplus
 }
 #endif
@@ -342,6 +388,33 @@ class OrbitFunctor {
   OrbitFunctionType func_;
 };
 
+// Calls the "_interned" variant of a function of liborbit.so, or the variant without the key of the
+// name if liborbit.so is too old to have the former.
+template <typename InternedOrbitFunctionType, typename OrbitFunctionType>
+class OrbitInternedFunctor {
+ public:
+  OrbitInternedFunctor() = delete;
+  OrbitInternedFunctor(const char* interned_proc_name, const char* proc_name)
+      : interned_func_(reinterpret_cast<InternedOrbitFunctionType>(
+            orbit_api_get_proc_address(interned_proc_name))),
+        func_(interned_func_ != nullptr
+                  ? nullptr
+                  : reinterpret_cast<OrbitFunctionType>(orbit_api_get_proc_address(proc_name))) {}
+
+  template <typename... Args>
+  inline void operator()(const char* name, uint64_t name_key, const Args&... args) {
+    if (interned_func_ != nullptr) {
+      interned_func_(name, name_key, args...);
+    } else if (func_ != nullptr) {
+      func_(name, args...);
+    }
+  }
+
+ private:
+  InternedOrbitFunctionType interned_func_;
+  OrbitFunctionType func_;
+};
+
 extern "C" {
 
 // In C++, orbit_api_init() does nothing.
@@ -402,6 +475,69 @@ inline void orbit_api_track_double(const char* name, double value, orbit_api_col
   f(name, value, color);
 }
 
+inline void orbit_api_start_interned(const char* name, uint64_t name_key, orbit_api_color color) {
+  static OrbitInternedFunctor<void (*)(const char*, uint64_t, orbit_api_color),
+                              void (*)(const char*, orbit_api_color)>
+      f("orbit_api_start_interned", "orbit_api_start");
+  f(name, name_key, color);
+}
+
+inline void orbit_api_start_async_interned(const char* name, uint64_t name_key, uint64_t id,
+                                           orbit_api_color color) {
+  static OrbitInternedFunctor<void (*)(const char*, uint64_t, uint64_t, orbit_api_color),
+                              void (*)(const char*, uint64_t, orbit_api_color)>
+      f("orbit_api_start_async_interned", "orbit_api_start_async");
+  f(name, name_key, id, color);
+}
+
+inline void orbit_api_track_int_interned(const char* name, uint64_t name_key, int value,
+                                         orbit_api_color color) {
+  static OrbitInternedFunctor<void (*)(const char*, uint64_t, int, orbit_api_color),
+                              void (*)(const char*, int, orbit_api_color)>
+      f("orbit_api_track_int_interned", "orbit_api_track_int");
+  f(name, name_key, value, color);
+}
+
+inline void orbit_api_track_int64_interned(const char* name, uint64_t name_key, int64_t value,
+                                           orbit_api_color color) {
+  static OrbitInternedFunctor<void (*)(const char*, uint64_t, int64_t, orbit_api_color),
+                              void (*)(const char*, int64_t, orbit_api_color)>
+      f("orbit_api_track_int64_interned", "orbit_api_track_int64");
+  f(name, name_key, value, color);
+}
+
+inline void orbit_api_track_uint_interned(const char* name, uint64_t name_key, uint32_t value,
+                                          orbit_api_color color) {
+  static OrbitInternedFunctor<void (*)(const char*, uint64_t, uint32_t, orbit_api_color),
+                              void (*)(const char*, uint32_t, orbit_api_color)>
+      f("orbit_api_track_uint_interned", "orbit_api_track_uint");
+  f(name, name_key, value, color);
+}
+
+inline void orbit_api_track_uint64_interned(const char* name, uint64_t name_key, uint64_t value,
+                                            orbit_api_color color) {
+  static OrbitInternedFunctor<void (*)(const char*, uint64_t, uint64_t, orbit_api_color),
+                              void (*)(const char*, uint64_t, orbit_api_color)>
+      f("orbit_api_track_uint64_interned", "orbit_api_track_uint64");
+  f(name, name_key, value, color);
+}
+
+inline void orbit_api_track_float_interned(const char* name, uint64_t name_key, float value,
+                                           orbit_api_color color) {
+  static OrbitInternedFunctor<void (*)(const char*, uint64_t, float, orbit_api_color),
+                              void (*)(const char*, float, orbit_api_color)>
+      f("orbit_api_track_float_interned", "orbit_api_track_float");
+  f(name, name_key, value, color);
+}
+
+inline void orbit_api_track_double_interned(const char* name, uint64_t name_key, double value,
+                                            orbit_api_color color) {
+  static OrbitInternedFunctor<void (*)(const char*, uint64_t, double, orbit_api_color),
+                              void (*)(const char*, double, orbit_api_color)>
+      f("orbit_api_track_double_interned", "orbit_api_track_double");
+  f(name, name_key, value, color);
+}
+
 }  // extern "C"
 
 #endif  // ORBIT_API_INTERNAL_IMPL
@@ -415,10 +551,41 @@ inline void orbit_api_track_double(const char* name, double value, orbit_api_col
 #define ORBIT_VAR ORBIT_UNIQUE(ORB)
 
 namespace orbit_api {
+
+// 64-bit FNV-1a hash of a null-terminated string, used as the key of the names of scopes and
+// tracks. Being constexpr, optimizing compilers evaluate it at compile time for string literals.
+// This is not guaranteed, as the macros also accept names that are only known at run time.
+constexpr uint64_t StringKey(const char* str) {
+  uint64_t hash = 0xcbf29ce484222325;
+  if (str == nullptr) return hash;
+  for (; *str != 0; ++str) {
+    hash ^= static_cast<uint8_t>(*str);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+// The name of a scope or track together with its key. The macros construct it from their "name"
+// argument, so that the argument is evaluated only once even though both are passed on.
+struct Name {
+  constexpr explicit Name(const char* name) : str(name), key(StringKey(name)) {}
+
+  const char* str;
+  uint64_t key;
+};
+
+template <typename InternedFunctionType, typename... Args>
+inline void CallInterned(InternedFunctionType function, const Name& name, const Args&... args) {
+  function(name.str, name.key, args...);
+}
+
 struct Scope {
-  Scope(const char* name, orbit_api_color color) { orbit_api_start(name, color); }
+  Scope(const Name& name, orbit_api_color color) {
+    orbit_api_start_interned(name.str, name.key, color);
+  }
   ~Scope() { orbit_api_stop(); }
 };
+
 }  // namespace orbit_api
 
 #endif  // __cplusplus
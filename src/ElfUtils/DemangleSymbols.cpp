@@ -0,0 +1,51 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "DemangleSymbols.h"
+
+#include <llvm/Demangle/Demangle.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "OrbitBase/ForEachInParallel.h"
+#include "OrbitBase/Logging.h"
+
+namespace orbit_elf_utils {
+
+namespace {
+
+using orbit_grpc_protos::SymbolInfo;
+
+void DemangleRange(google::protobuf::RepeatedPtrField<SymbolInfo>* symbol_infos, size_t begin,
+                   size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    SymbolInfo* symbol_info = symbol_infos->Mutable(static_cast<int>(i));
+    symbol_info->set_demangled_name(llvm::demangle(symbol_info->name()));
+  }
+}
+
+}  // namespace
+
+void DemangleSymbols(google::protobuf::RepeatedPtrField<SymbolInfo>* symbol_infos,
+                     size_t min_num_symbols_per_range) {
+  CHECK(min_num_symbols_per_range > 0);
+  const size_t num_symbols = symbol_infos->size();
+  const size_t max_num_ranges = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  const size_t num_ranges =
+      std::clamp<size_t>(num_symbols / min_num_symbols_per_range, 1, max_num_ranges);
+  if (num_ranges == 1) {
+    DemangleRange(symbol_infos, 0, num_symbols);
+    return;
+  }
+
+  const size_t range_size = (num_symbols + num_ranges - 1) / num_ranges;
+  orbit_base::ForEachInParallel(num_ranges, [symbol_infos, num_symbols,
+                                             range_size](size_t range_index) {
+    const size_t begin = range_index * range_size;
+    DemangleRange(symbol_infos, begin, std::min(begin + range_size, num_symbols));
+  });
+}
+
+}  // namespace orbit_elf_utils
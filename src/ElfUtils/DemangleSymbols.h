@@ -0,0 +1,27 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ELF_UTILS_DEMANGLE_SYMBOLS_H_
+#define ELF_UTILS_DEMANGLE_SYMBOLS_H_
+
+#include <google/protobuf/repeated_field.h>
+#include <stddef.h>
+
+#include "symbol.pb.h"
+
+namespace orbit_elf_utils {
+
+constexpr size_t kDefaultMinNumSymbolsPerDemanglingRange = 16 * 1024;
+
+// Sets the demangled name of every symbol. Demangling is by far the most expensive part of loading
+// the symbols of a large binary, so the symbols are split into contiguous ranges of at least
+// `min_num_symbols_per_range` symbols that are demangled in parallel. Every range only writes to
+// its own SymbolInfos, so the result does not depend on the scheduling.
+void DemangleSymbols(
+    google::protobuf::RepeatedPtrField<orbit_grpc_protos::SymbolInfo>* symbol_infos,
+    size_t min_num_symbols_per_range = kDefaultMinNumSymbolsPerDemanglingRange);
+
+}  // namespace orbit_elf_utils
+
+#endif  // ELF_UTILS_DEMANGLE_SYMBOLS_H_
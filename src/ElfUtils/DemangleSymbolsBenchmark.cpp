@@ -0,0 +1,55 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares demangling the symbols of a large symbol table on the calling thread only and in
+// parallel, as ElfFile::LoadSymbolsFromSymtab does. The symbols are synthetic C++ functions with a
+// few template and parameter types, so that their demangling cost is close to the one of real code.
+
+#include <absl/strings/str_format.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "DemangleSymbols.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
+#include "symbol.pb.h"
+
+namespace {
+
+using orbit_grpc_protos::SymbolInfo;
+
+constexpr int kNumSymbols = 1'000'000;
+
+// orbit::Class<i>::Function<i>(std::vector<int, std::allocator<int> > const&, char const*)
+std::string GetMangledName(int i) {
+  const std::string class_name = absl::StrFormat("Class%d", i / 100);
+  const std::string function_name = absl::StrFormat("Function%d", i);
+  return absl::StrFormat("_ZN5orbit%d%s%d%sERKSt6vectorIiSaIiEEPKc", class_name.size(),
+                         class_name, function_name.size(), function_name);
+}
+
+[[nodiscard]] double MeasureMs(size_t min_num_symbols_per_range) {
+  google::protobuf::RepeatedPtrField<SymbolInfo> symbol_infos;
+  symbol_infos.Reserve(kNumSymbols);
+  for (int i = 0; i < kNumSymbols; ++i) {
+    symbol_infos.Add()->set_name(GetMangledName(i));
+  }
+  const uint64_t start_ns = orbit_base::CaptureTimestampNs();
+  orbit_elf_utils::DemangleSymbols(&symbol_infos, min_num_symbols_per_range);
+  const uint64_t duration_ns = orbit_base::CaptureTimestampNs() - start_ns;
+  CHECK(symbol_infos.Get(0).demangled_name() != symbol_infos.Get(0).name());
+  return static_cast<double>(duration_ns) / 1'000'000;
+}
+
+}  // namespace
+
+int main() {
+  const double single_thread_ms = MeasureMs(std::numeric_limits<size_t>::max());
+  const double parallel_ms = MeasureMs(orbit_elf_utils::kDefaultMinNumSymbolsPerDemanglingRange);
+  LOG("Demangling %d symbols: %.1f ms on one thread, %.1f ms in parallel (%.1fx)", kNumSymbols,
+      single_thread_ms, parallel_ms, single_thread_ms / parallel_ms);
+  return 0;
+}
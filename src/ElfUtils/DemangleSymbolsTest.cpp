@@ -0,0 +1,51 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_format.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "DemangleSymbols.h"
+#include "symbol.pb.h"
+
+namespace orbit_elf_utils {
+
+using orbit_grpc_protos::SymbolInfo;
+
+namespace {
+
+std::string GetMangledName(int i) {
+  const std::string function_name = absl::StrFormat("Function%d", i);
+  return absl::StrFormat("_ZN5orbit%d%sEv", function_name.size(), function_name);
+}
+
+}  // namespace
+
+TEST(DemangleSymbols, DemanglesSymbolsInParallelInOrder) {
+  constexpr int kNumSymbols = 1000;
+  google::protobuf::RepeatedPtrField<SymbolInfo> symbol_infos;
+  for (int i = 0; i < kNumSymbols; ++i) {
+    symbol_infos.Add()->set_name(GetMangledName(i));
+  }
+  // C symbols are not mangled.
+  symbol_infos.Add()->set_name("main");
+
+  // Small ranges, so that the symbols are split into as many ranges as there are threads.
+  DemangleSymbols(&symbol_infos, /*min_num_symbols_per_range=*/1);
+
+  for (int i = 0; i < kNumSymbols; ++i) {
+    EXPECT_EQ(symbol_infos.Get(i).name(), GetMangledName(i));
+    EXPECT_EQ(symbol_infos.Get(i).demangled_name(), absl::StrFormat("orbit::Function%d()", i));
+  }
+  EXPECT_EQ(symbol_infos.Get(kNumSymbols).demangled_name(), "main");
+}
+
+TEST(DemangleSymbols, EmptySymbols) {
+  google::protobuf::RepeatedPtrField<SymbolInfo> symbol_infos;
+  DemangleSymbols(&symbol_infos, /*min_num_symbols_per_range=*/1);
+  EXPECT_TRUE(symbol_infos.empty());
+}
+
+}  // namespace orbit_elf_utils
@@ -5,6 +5,7 @@
 #include "ElfUtils/ElfFile.h"
 
 #include <absl/base/casts.h>
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
 #include <llvm/ADT/ArrayRef.h>
@@ -13,9 +14,10 @@
 #include <llvm/ADT/iterator_range.h>
 #include <llvm/BinaryFormat/ELF.h>
 #include <llvm/DebugInfo/DWARF/DWARFContext.h>
+#include <llvm/DebugInfo/DWARF/DWARFCompileUnit.h>
 #include <llvm/DebugInfo/DWARF/DWARFDebugLine.h>
+#include <llvm/DebugInfo/DWARF/DWARFDie.h>
 #include <llvm/DebugInfo/DWARF/DWARFFormValue.h>
-#include <llvm/DebugInfo/Symbolize/Symbolize.h>
 #include <llvm/Demangle/Demangle.h>
 #include <llvm/Object/Binary.h>
 #include <llvm/Object/ELF.h>
@@ -29,11 +31,17 @@
 #include <llvm/Support/MathExtras.h>
 #include <llvm/Support/MemoryBuffer.h>
 
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <outcome.hpp>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "DemangleSymbols.h"
 #include "OrbitBase/File.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ReadFileToString.h"
@@ -48,6 +56,117 @@ using orbit_grpc_protos::LineInfo;
 using orbit_grpc_protos::ModuleSymbols;
 using orbit_grpc_protos::SymbolInfo;
 
+// Line information of one compile unit, built when it is first needed. GetLineInfo reports the
+// outermost frame of an address: inside an inlined subroutine that is the call site of the
+// subroutine that was inlined directly into the function, everywhere else it is the row of the
+// line table. So besides the line table, the index holds the address ranges of all inlined
+// subroutines that are not nested in another inlined subroutine, together with their call site.
+class CompileUnitLineInfoIndex {
+ public:
+  CompileUnitLineInfoIndex(llvm::DWARFContext* dwarf_context,
+                           llvm::DWARFCompileUnit* compile_unit)
+      : compile_unit_(compile_unit),
+        line_table_(dwarf_context->getLineTableForUnit(compile_unit)) {
+    CollectInlinedRanges(compile_unit->getUnitDIE(/*ExtractUnitDIEOnly=*/false),
+                         /*is_inside_function=*/false);
+    std::sort(
+        inlined_ranges_.begin(), inlined_ranges_.end(),
+        [](const InlinedRange& lhs, const InlinedRange& rhs) { return lhs.begin < rhs.begin; });
+  }
+
+  [[nodiscard]] std::optional<LineInfo> Lookup(uint64_t address) {
+    if (line_table_ == nullptr) return std::nullopt;
+
+    uint64_t file_index = 0;
+    uint32_t line = 0;
+    auto it = std::upper_bound(
+        inlined_ranges_.begin(), inlined_ranges_.end(), address,
+        [](uint64_t value, const InlinedRange& range) { return value < range.begin; });
+    if (it != inlined_ranges_.begin() && address < std::prev(it)->end) {
+      file_index = std::prev(it)->call_file;
+      line = std::prev(it)->call_line;
+    } else {
+      const uint32_t row_index = line_table_->lookupAddress(
+          {address, llvm::object::SectionedAddress::UndefSection});
+      if (row_index == line_table_->UnknownRowIndex) return std::nullopt;
+      file_index = line_table_->Rows[row_index].File;
+      line = line_table_->Rows[row_index].Line;
+    }
+
+    const std::optional<std::string>& file_name = GetFileName(file_index);
+    if (!file_name.has_value()) return std::nullopt;
+
+    LineInfo line_info;
+    line_info.set_source_file(file_name.value());
+    line_info.set_source_line(line);
+    return line_info;
+  }
+
+ private:
+  struct InlinedRange {
+    uint64_t begin;
+    uint64_t end;
+    uint32_t call_file;
+    uint32_t call_line;
+  };
+
+  void CollectInlinedRanges(const llvm::DWARFDie& die, bool is_inside_function) {
+    for (const llvm::DWARFDie& child : die.children()) {
+      switch (child.getTag()) {
+        case llvm::dwarf::DW_TAG_subprogram:
+          CollectInlinedRanges(child, /*is_inside_function=*/true);
+          break;
+        case llvm::dwarf::DW_TAG_inlined_subroutine:
+          if (is_inside_function) {
+            AddInlinedRanges(child);
+          } else {
+            CollectInlinedRanges(child, is_inside_function);
+          }
+          break;
+        default:
+          CollectInlinedRanges(child, is_inside_function);
+          break;
+      }
+    }
+  }
+
+  void AddInlinedRanges(const llvm::DWARFDie& inlined_subroutine) {
+    uint32_t call_file = 0;
+    uint32_t call_line = 0;
+    uint32_t call_column = 0;
+    uint32_t call_discriminator = 0;
+    inlined_subroutine.getCallerFrame(call_file, call_line, call_column, call_discriminator);
+
+    auto ranges_or_error = inlined_subroutine.getAddressRanges();
+    if (!ranges_or_error) {
+      llvm::consumeError(ranges_or_error.takeError());
+      return;
+    }
+    for (const llvm::DWARFAddressRange& range : ranges_or_error.get()) {
+      if (range.LowPC >= range.HighPC) continue;
+      inlined_ranges_.push_back({range.LowPC, range.HighPC, call_file, call_line});
+    }
+  }
+
+  [[nodiscard]] const std::optional<std::string>& GetFileName(uint64_t file_index) {
+    auto [it, inserted] = file_names_.try_emplace(file_index);
+    if (inserted) {
+      std::string file_name;
+      if (line_table_->getFileNameByIndex(
+              file_index, compile_unit_->getCompilationDir(),
+              llvm::DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath, file_name)) {
+        it->second = std::move(file_name);
+      }
+    }
+    return it->second;
+  }
+
+  llvm::DWARFCompileUnit* compile_unit_;
+  const llvm::DWARFDebugLine::LineTable* line_table_;
+  std::vector<InlinedRange> inlined_ranges_;
+  absl::flat_hash_map<uint64_t, std::optional<std::string>> file_names_;
+};
+
 template <typename ElfT>
 class ElfFileImpl : public ElfFile {
  public:
@@ -55,17 +174,21 @@ class ElfFileImpl : public ElfFile {
               llvm::object::OwningBinary<llvm::object::ObjectFile>&& owning_binary);
 
   [[nodiscard]] ErrorMessageOr<ModuleSymbols> LoadSymbolsFromSymtab() override;
+  [[nodiscard]] ErrorMessageOr<ModuleSymbols> LoadSymbolsFromSymtabWithoutDemangling() override;
   [[nodiscard]] ErrorMessageOr<ModuleSymbols> LoadSymbolsFromDynsym() override;
   [[nodiscard]] ErrorMessageOr<uint64_t> GetLoadBias() const override;
   [[nodiscard]] bool HasSymtab() const override;
   [[nodiscard]] bool HasDynsym() const override;
   [[nodiscard]] bool HasDebugInfo() const override;
   [[nodiscard]] bool HasGnuDebuglink() const override;
+  [[nodiscard]] bool HasGccExceptTable() const override;
   [[nodiscard]] bool Is64Bit() const override;
   [[nodiscard]] std::string GetBuildId() const override;
   [[nodiscard]] std::string GetSoname() const override;
   [[nodiscard]] std::filesystem::path GetFilePath() const override;
   [[nodiscard]] ErrorMessageOr<LineInfo> GetLineInfo(uint64_t address) override;
+  [[nodiscard]] std::vector<ErrorMessageOr<LineInfo>> GetLineInfos(
+      absl::Span<const uint64_t> addresses) override;
   [[nodiscard]] ErrorMessageOr<LineInfo> GetDeclarationLocationOfFunction(
       uint64_t address) override;
   [[nodiscard]] std::optional<GnuDebugLinkInfo> GetGnuDebugLinkInfo() const override;
@@ -74,16 +197,24 @@ class ElfFileImpl : public ElfFile {
   void InitSections();
   void InitDynamicEntries(const llvm::object::ELFFile<ElfT>* elf_file);
   ErrorMessageOr<SymbolInfo> CreateSymbolInfo(const llvm::object::ELFSymbolRef& symbol_ref);
+  ErrorMessageOr<SymbolInfo> CreateSymbolInfoWithoutDemangledName(
+      const llvm::object::ELFSymbolRef& symbol_ref);
+  [[nodiscard]] llvm::DWARFContext* GetDwarfContext();
+  [[nodiscard]] std::optional<LineInfo> LookupLineInfo(uint64_t address);
 
   const std::filesystem::path file_path_;
   llvm::object::OwningBinary<llvm::object::ObjectFile> owning_binary_;
   llvm::object::ELFObjectFile<ElfT>* object_file_;
-  llvm::symbolize::LLVMSymbolizer symbolizer_;
+  // Created on first use and kept, as it caches the parsed debug information.
+  std::unique_ptr<llvm::DWARFContext> dwarf_context_;
+  absl::flat_hash_map<const llvm::DWARFUnit*, std::unique_ptr<CompileUnitLineInfoIndex>>
+      line_info_indices_;
   std::string build_id_;
   std::string soname_;
   bool has_symtab_section_;
   bool has_dynsym_section_;
   bool has_debug_info_section_;
+  bool has_gcc_except_table_section_;
   std::optional<GnuDebugLinkInfo> gnu_debuglink_info_;
 };
 
@@ -138,7 +269,8 @@ ElfFileImpl<ElfT>::ElfFileImpl(std::filesystem::path file_path,
       owning_binary_(std::move(owning_binary)),
       has_symtab_section_(false),
       has_dynsym_section_(false),
-      has_debug_info_section_(false) {
+      has_debug_info_section_(false),
+      has_gcc_except_table_section_(false) {
   object_file_ = llvm::dyn_cast<llvm::object::ELFObjectFile<ElfT>>(owning_binary_.getBinary());
   InitSections();
 }
@@ -243,6 +375,11 @@ void ElfFileImpl<ElfT>::InitSections() {
       continue;
     }
 
+    if (name.str() == ".gcc_except_table") {
+      has_gcc_except_table_section_ = true;
+      continue;
+    }
+
     if (name.str() == ".note.gnu.build-id" && section.sh_type == llvm::ELF::SHT_NOTE) {
       llvm::Error error = llvm::Error::success();
       for (const typename ElfT::Note& note : elf_file->notes(section, error)) {
@@ -275,6 +412,14 @@ void ElfFileImpl<ElfT>::InitSections() {
 template <typename ElfT>
 ErrorMessageOr<SymbolInfo> ElfFileImpl<ElfT>::CreateSymbolInfo(
     const llvm::object::ELFSymbolRef& symbol_ref) {
+  OUTCOME_TRY(symbol_info, CreateSymbolInfoWithoutDemangledName(symbol_ref));
+  symbol_info.set_demangled_name(llvm::demangle(symbol_info.name()));
+  return symbol_info;
+}
+
+template <typename ElfT>
+ErrorMessageOr<SymbolInfo> ElfFileImpl<ElfT>::CreateSymbolInfoWithoutDemangledName(
+    const llvm::object::ELFSymbolRef& symbol_ref) {
   if ((symbol_ref.getFlags() & llvm::object::BasicSymbolRef::SF_Undefined) != 0) {
     return ErrorMessage("Symbol is defined in another object file (SF_Undefined flag is set).");
   }
@@ -292,7 +437,6 @@ ErrorMessageOr<SymbolInfo> ElfFileImpl<ElfT>::CreateSymbolInfo(
   }
   SymbolInfo symbol_info;
   symbol_info.set_name(name);
-  symbol_info.set_demangled_name(llvm::demangle(name));
   symbol_info.set_address(symbol_ref.getValue());
   symbol_info.set_size(symbol_ref.getSize());
   return symbol_info;
@@ -300,6 +444,13 @@ ErrorMessageOr<SymbolInfo> ElfFileImpl<ElfT>::CreateSymbolInfo(
 
 template <typename ElfT>
 ErrorMessageOr<ModuleSymbols> ElfFileImpl<ElfT>::LoadSymbolsFromSymtab() {
+  OUTCOME_TRY(module_symbols, LoadSymbolsFromSymtabWithoutDemangling());
+  DemangleSymbols(module_symbols.mutable_symbol_infos());
+  return module_symbols;
+}
+
+template <typename ElfT>
+ErrorMessageOr<ModuleSymbols> ElfFileImpl<ElfT>::LoadSymbolsFromSymtabWithoutDemangling() {
   if (!has_symtab_section_) {
     return ErrorMessage("ELF file does not have a .symtab section.");
   }
@@ -311,7 +462,7 @@ ErrorMessageOr<ModuleSymbols> ElfFileImpl<ElfT>::LoadSymbolsFromSymtab() {
   module_symbols.set_symbols_file_path(file_path_.string());
 
   for (const llvm::object::ELFSymbolRef& symbol_ref : object_file_->symbols()) {
-    auto symbol_or_error = CreateSymbolInfo(symbol_ref);
+    auto symbol_or_error = CreateSymbolInfoWithoutDemangledName(symbol_ref);
     if (symbol_or_error.has_value()) {
       *module_symbols.add_symbol_infos() = std::move(symbol_or_error.value());
     }
@@ -405,6 +556,11 @@ bool ElfFileImpl<ElfT>::HasGnuDebuglink() const {
   return gnu_debuglink_info_.has_value();
 }
 
+template <typename ElfT>
+bool ElfFileImpl<ElfT>::HasGccExceptTable() const {
+  return has_gcc_except_table_section_;
+}
+
 template <typename ElfT>
 std::string ElfFileImpl<ElfT>::GetBuildId() const {
   return build_id_;
@@ -421,41 +577,74 @@ std::filesystem::path ElfFileImpl<ElfT>::GetFilePath() const {
 }
 
 template <typename ElfT>
-ErrorMessageOr<LineInfo> orbit_elf_utils::ElfFileImpl<ElfT>::GetLineInfo(uint64_t address) {
-  CHECK(has_debug_info_section_);
-  auto line_info_or_error = symbolizer_.symbolizeInlinedCode(
-      object_file_->getFileName(), {address, llvm::object::SectionedAddress::UndefSection});
-  if (!line_info_or_error) {
-    return ErrorMessage(absl::StrFormat(
-        "Unable to get line number info for \"%s\", address=0x%x: %s", object_file_->getFileName(),
-        address, llvm::toString(line_info_or_error.takeError())));
+llvm::DWARFContext* ElfFileImpl<ElfT>::GetDwarfContext() {
+  if (dwarf_context_ == nullptr) {
+    dwarf_context_ = llvm::DWARFContext::create(*owning_binary_.getBinary());
   }
+  return dwarf_context_.get();
+}
 
-  auto& symbolizer_line_info = line_info_or_error.get();
-  const uint32_t number_of_frames = symbolizer_line_info.getNumberOfFrames();
+template <typename ElfT>
+std::optional<LineInfo> ElfFileImpl<ElfT>::LookupLineInfo(uint64_t address) {
+  llvm::DWARFContext* dwarf_context = GetDwarfContext();
+  if (dwarf_context == nullptr) return std::nullopt;
 
-  // Getting back zero frames means there was some kind of problem. We will return a error.
-  if (number_of_frames == 0) {
-    return ErrorMessage(absl::StrFormat("Unable to get line info for address=0x%x", address));
-  }
+  const auto offset = dwarf_context->getDebugAranges()->findAddress(address);
+  auto* const compile_unit = dwarf_context->getCompileUnitForOffset(offset);
+  if (compile_unit == nullptr) return std::nullopt;
 
-  const auto& last_frame = symbolizer_line_info.getFrame(number_of_frames - 1);
+  std::unique_ptr<CompileUnitLineInfoIndex>& index = line_info_indices_[compile_unit];
+  if (index == nullptr) {
+    index = std::make_unique<CompileUnitLineInfoIndex>(dwarf_context, compile_unit);
+  }
+  return index->Lookup(address);
+}
 
-  // This is what symbolizer returns in case of an error. We convert it to a ErrorMessage here.
-  if (last_frame.FileName == "<invalid>" && last_frame.Line == 0) {
+template <typename ElfT>
+ErrorMessageOr<LineInfo> orbit_elf_utils::ElfFileImpl<ElfT>::GetLineInfo(uint64_t address) {
+  CHECK(has_debug_info_section_);
+  std::optional<LineInfo> line_info = LookupLineInfo(address);
+  if (!line_info.has_value()) {
     return ErrorMessage(absl::StrFormat("Unable to get line info for address=0x%x", address));
   }
+  return std::move(line_info.value());
+}
 
-  LineInfo line_info;
-  line_info.set_source_file(last_frame.FileName);
-  line_info.set_source_line(last_frame.Line);
-  return line_info;
+template <typename ElfT>
+std::vector<ErrorMessageOr<LineInfo>> ElfFileImpl<ElfT>::GetLineInfos(
+    absl::Span<const uint64_t> addresses) {
+  CHECK(has_debug_info_section_);
+
+  // Looking the addresses up in increasing order makes consecutive lookups hit the same compile
+  // unit and the same parts of its tables, and resolves duplicate addresses only once.
+  std::vector<size_t> order(addresses.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [addresses](size_t lhs, size_t rhs) { return addresses[lhs] < addresses[rhs]; });
+
+  std::vector<ErrorMessageOr<LineInfo>> line_infos(
+      addresses.size(), ErrorMessage{"Address was not looked up"});
+  for (size_t i = 0; i < order.size(); ++i) {
+    const uint64_t address = addresses[order[i]];
+    if (i > 0 && addresses[order[i - 1]] == address) {
+      line_infos[order[i]] = line_infos[order[i - 1]];
+      continue;
+    }
+    std::optional<LineInfo> line_info = LookupLineInfo(address);
+    if (line_info.has_value()) {
+      line_infos[order[i]] = std::move(line_info.value());
+    } else {
+      line_infos[order[i]] =
+          ErrorMessage(absl::StrFormat("Unable to get line info for address=0x%x", address));
+    }
+  }
+  return line_infos;
 }
 
 template <typename ElfT>
 ErrorMessageOr<LineInfo> orbit_elf_utils::ElfFileImpl<ElfT>::GetDeclarationLocationOfFunction(
     uint64_t address) {
-  const auto dwarf_context = llvm::DWARFContext::create(*owning_binary_.getBinary());
+  llvm::DWARFContext* const dwarf_context = GetDwarfContext();
   if (dwarf_context == nullptr) return ErrorMessage{"Could not read DWARF information."};
 
   const auto offset = dwarf_context->getDebugAranges()->findAddress(address);
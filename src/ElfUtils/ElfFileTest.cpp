@@ -5,6 +5,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <iterator>
 #include <memory>
@@ -54,6 +55,44 @@ TEST(ElfFile, LoadSymbolsFromSymtab) {
   EXPECT_EQ(symbol_info.size(), 45);
 }
 
+TEST(ElfFile, LoadSymbolsFromSymtabWithoutDemangling) {
+  std::filesystem::path file_path =
+      orbit_base::GetExecutableDir() / "testdata" / "line_info_test_binary";
+
+  auto elf_file_result = ElfFile::Create(file_path);
+  ASSERT_TRUE(elf_file_result.has_value()) << elf_file_result.error().message();
+  std::unique_ptr<ElfFile> elf_file = std::move(elf_file_result.value());
+
+  const auto demangled_symbols_result = elf_file->LoadSymbolsFromSymtab();
+  ASSERT_TRUE(demangled_symbols_result.has_value())
+      << demangled_symbols_result.error().message();
+  const auto symbols_result = elf_file->LoadSymbolsFromSymtabWithoutDemangling();
+  ASSERT_TRUE(symbols_result.has_value()) << symbols_result.error().message();
+
+  EXPECT_EQ(symbols_result.value().load_bias(), demangled_symbols_result.value().load_bias());
+  EXPECT_EQ(symbols_result.value().symbols_file_path(), file_path);
+  ASSERT_EQ(symbols_result.value().symbol_infos_size(),
+            demangled_symbols_result.value().symbol_infos_size());
+
+  for (int i = 0; i < symbols_result.value().symbol_infos_size(); ++i) {
+    const SymbolInfo& symbol_info = symbols_result.value().symbol_infos(i);
+    const SymbolInfo& demangled_symbol_info = demangled_symbols_result.value().symbol_infos(i);
+    EXPECT_EQ(symbol_info.name(), demangled_symbol_info.name());
+    EXPECT_EQ(symbol_info.address(), demangled_symbol_info.address());
+    EXPECT_EQ(symbol_info.size(), demangled_symbol_info.size());
+    EXPECT_TRUE(symbol_info.demangled_name().empty());
+  }
+
+  const auto print_hello_world =
+      std::find_if(demangled_symbols_result.value().symbol_infos().begin(),
+                   demangled_symbols_result.value().symbol_infos().end(),
+                   [](const SymbolInfo& symbol_info) {
+                     return symbol_info.name() == "_Z15PrintHelloWorldv";
+                   });
+  ASSERT_NE(print_hello_world, demangled_symbols_result.value().symbol_infos().end());
+  EXPECT_EQ(print_hello_world->demangled_name(), "PrintHelloWorld()");
+}
+
 TEST(ElfFile, LoadSymbolsFromDynsymFails) {
   std::filesystem::path file_path =
       orbit_base::GetExecutableDir() / "testdata" / "hello_world_elf_with_debug_info";
@@ -219,6 +258,17 @@ TEST(ElfFile, DoesNotHaveDebugInfo) {
   EXPECT_FALSE(hello_world.value()->HasDebugInfo());
 }
 
+TEST(ElfFile, HasGccExceptTable) {
+  auto hello_world =
+      ElfFile::Create(orbit_base::GetExecutableDir() / "testdata" / "hello_world_elf");
+  ASSERT_TRUE(hello_world.has_value()) << hello_world.error().message();
+  EXPECT_FALSE(hello_world.value()->HasGccExceptTable());
+
+  auto no_symbols = ElfFile::Create(orbit_base::GetExecutableDir() / "testdata" / "no_symbols_elf");
+  ASSERT_TRUE(no_symbols.has_value()) << no_symbols.error().message();
+  EXPECT_TRUE(no_symbols.value()->HasGccExceptTable());
+}
+
 static void RunLineInfoTest(const char* file_name) {
 #ifdef _WIN32
   constexpr const char* const kSourcePath = "/ssd/local\\hello.cpp";
@@ -329,6 +379,49 @@ TEST(ElfFile, LineInfoInlining) {
             "LineInfoTestBinary.cpp");
 }
 
+TEST(ElfFile, LineInfos) {
+  const std::filesystem::path file_path =
+      orbit_base::GetExecutableDir() / "testdata" / "hello_world_elf_with_debug_info";
+
+  auto hello_world = ElfFile::Create(file_path);
+  ASSERT_TRUE(hello_world.has_value()) << hello_world.error().message();
+
+  const std::vector<uint64_t> addresses = {0x1150, 0x10, 0x1140, 0x1150};
+  std::vector<ErrorMessageOr<orbit_grpc_protos::LineInfo>> line_infos =
+      hello_world.value()->GetLineInfos(addresses);
+  ASSERT_EQ(line_infos.size(), addresses.size());
+
+  ASSERT_TRUE(line_infos[0].has_value()) << line_infos[0].error().message();
+  EXPECT_EQ(line_infos[0].value().source_line(), 4);
+
+  ASSERT_TRUE(line_infos[1].has_error());
+  EXPECT_THAT(line_infos[1].error().message(),
+              testing::HasSubstr("Unable to get line info for address=0x10"));
+
+  ASSERT_TRUE(line_infos[2].has_value()) << line_infos[2].error().message();
+  EXPECT_EQ(line_infos[2].value().source_line(), 3);
+
+  ASSERT_TRUE(line_infos[3].has_value()) << line_infos[3].error().message();
+  EXPECT_EQ(line_infos[3].value().source_line(), 4);
+  EXPECT_EQ(line_infos[3].value().source_file(), line_infos[0].value().source_file());
+}
+
+TEST(ElfFile, LineInfosInlining) {
+  const std::filesystem::path file_path =
+      orbit_base::GetExecutableDir() / "testdata" / "line_info_test_binary";
+
+  auto program = ElfFile::Create(file_path);
+  ASSERT_TRUE(program.has_value()) << program.error().message();
+
+  constexpr uint64_t kFirstInstructionOfInlinedPrintHelloWorld = 0x401141;
+  const std::vector<uint64_t> addresses = {kFirstInstructionOfInlinedPrintHelloWorld};
+  std::vector<ErrorMessageOr<orbit_grpc_protos::LineInfo>> line_infos =
+      program.value()->GetLineInfos(addresses);
+  ASSERT_EQ(line_infos.size(), 1);
+  ASSERT_TRUE(line_infos[0].has_value()) << line_infos[0].error().message();
+  EXPECT_EQ(line_infos[0].value().source_line(), 13);
+}
+
 TEST(ElfFile, CompressedDebugInfo) {
   const std::filesystem::path file_path =
       orbit_base::GetExecutableDir() / "testdata" / "line_info_test_binary_compressed";
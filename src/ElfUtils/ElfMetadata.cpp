@@ -0,0 +1,263 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ElfUtils/ElfMetadata.h"
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+#include <elf.h>
+#include <string.h>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <outcome.hpp>
+#include <string_view>
+#include <vector>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Logging.h"
+
+namespace orbit_elf_utils {
+
+namespace {
+
+// Note and dynamic segments are tiny. Larger ones are not read, as the file is likely corrupted.
+constexpr uint64_t kMaxSegmentSize = 1024 * 1024;
+constexpr size_t kMaxSonameLength = 4096;
+
+struct Elf32Types {
+  using Ehdr = Elf32_Ehdr;
+  using Phdr = Elf32_Phdr;
+  using Dyn = Elf32_Dyn;
+};
+
+struct Elf64Types {
+  using Ehdr = Elf64_Ehdr;
+  using Phdr = Elf64_Phdr;
+  using Dyn = Elf64_Dyn;
+};
+
+ErrorMessageOr<void> ReadExactly(const orbit_base::unique_fd& fd, void* buffer, size_t size,
+                                 uint64_t offset) {
+  OUTCOME_TRY(bytes_read, orbit_base::ReadFullyAtOffset(fd, buffer, size, offset));
+  if (bytes_read != size) {
+    return ErrorMessage(absl::StrFormat(
+        "Unexpected end of file while reading %u bytes at offset %#x", size, offset));
+  }
+  return outcome::success();
+}
+
+ErrorMessageOr<std::string> ReadSegment(const orbit_base::unique_fd& fd, uint64_t offset,
+                                        uint64_t size) {
+  if (size > kMaxSegmentSize) {
+    return ErrorMessage(
+        absl::StrFormat("Segment at offset %#x is too large (%u bytes)", offset, size));
+  }
+  std::string data(size, '\0');
+  OUTCOME_TRY(ReadExactly(fd, data.data(), size, offset));
+  return data;
+}
+
+// Returns the hex encoded GNU build id if `notes` contains one, and an empty string otherwise.
+[[nodiscard]] std::string FindBuildIdInNotes(std::string_view notes, uint64_t alignment) {
+  const auto align = [alignment](uint64_t value) {
+    return (value + alignment - 1) / alignment * alignment;
+  };
+  constexpr std::string_view kGnuNoteName{"GNU\0", 4};
+
+  uint64_t position = 0;
+  while (position + sizeof(Elf32_Nhdr) <= notes.size()) {
+    // Elf32_Nhdr and Elf64_Nhdr have the same layout.
+    Elf32_Nhdr header;
+    memcpy(&header, notes.data() + position, sizeof(header));
+    const uint64_t name_offset = position + sizeof(header);
+    const uint64_t desc_offset = name_offset + align(header.n_namesz);
+    if (desc_offset + header.n_descsz > notes.size()) break;
+
+    if (header.n_type == NT_GNU_BUILD_ID &&
+        notes.substr(name_offset, header.n_namesz) == kGnuNoteName) {
+      std::string build_id;
+      for (char byte : notes.substr(desc_offset, header.n_descsz)) {
+        absl::StrAppend(&build_id, absl::Hex(static_cast<uint8_t>(byte), absl::kZeroPad2));
+      }
+      return build_id;
+    }
+
+    position = desc_offset + align(header.n_descsz);
+  }
+  return "";
+}
+
+template <typename ElfTypes>
+[[nodiscard]] std::optional<uint64_t> VirtualAddressToFileOffset(
+    const std::vector<typename ElfTypes::Phdr>& program_headers, uint64_t address) {
+  for (const typename ElfTypes::Phdr& phdr : program_headers) {
+    if (phdr.p_type != PT_LOAD) continue;
+    if (address < phdr.p_vaddr || address - phdr.p_vaddr >= phdr.p_filesz) continue;
+    return address - phdr.p_vaddr + phdr.p_offset;
+  }
+  return std::nullopt;
+}
+
+// Follows DT_SONAME into the dynamic string table. Like ElfFile, a missing or broken soname is not
+// an error, the module is just reported without one.
+template <typename ElfTypes>
+[[nodiscard]] std::string ReadSoname(const orbit_base::unique_fd& fd,
+                                     const std::vector<typename ElfTypes::Phdr>& program_headers,
+                                     const typename ElfTypes::Phdr& dynamic_phdr,
+                                     const std::filesystem::path& file_path) {
+  ErrorMessageOr<std::string> dynamic_or_error =
+      ReadSegment(fd, dynamic_phdr.p_offset, dynamic_phdr.p_filesz);
+  if (dynamic_or_error.has_error()) {
+    LOG("Unable to read dynamic segment of \"%s\": %s", file_path.string(),
+        dynamic_or_error.error().message());
+    return "";
+  }
+  const std::string& dynamic = dynamic_or_error.value();
+
+  std::optional<uint64_t> soname_offset;
+  std::optional<uint64_t> dynamic_string_table_addr;
+  std::optional<uint64_t> dynamic_string_table_size;
+  for (size_t position = 0; position + sizeof(typename ElfTypes::Dyn) <= dynamic.size();
+       position += sizeof(typename ElfTypes::Dyn)) {
+    typename ElfTypes::Dyn dyn_entry;
+    memcpy(&dyn_entry, dynamic.data() + position, sizeof(dyn_entry));
+    if (dyn_entry.d_tag == DT_NULL) break;
+    switch (dyn_entry.d_tag) {
+      case DT_SONAME:
+        soname_offset.emplace(dyn_entry.d_un.d_val);
+        break;
+      case DT_STRTAB:
+        dynamic_string_table_addr.emplace(dyn_entry.d_un.d_ptr);
+        break;
+      case DT_STRSZ:
+        dynamic_string_table_size.emplace(dyn_entry.d_un.d_val);
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (!soname_offset.has_value() || !dynamic_string_table_addr.has_value() ||
+      !dynamic_string_table_size.has_value()) {
+    return "";
+  }
+
+  if (soname_offset.value() >= dynamic_string_table_size.value()) {
+    ERROR(
+        "Soname offset is out of bounds of the string table (file=\"%s\", offset=%u "
+        "strtab size=%u)",
+        file_path.string(), soname_offset.value(), dynamic_string_table_size.value());
+    return "";
+  }
+
+  std::optional<uint64_t> strtab_offset =
+      VirtualAddressToFileOffset<ElfTypes>(program_headers, dynamic_string_table_addr.value());
+  if (!strtab_offset.has_value()) {
+    LOG("Unable to get dynamic string table from DT_STRTAB in \"%s\"", file_path.string());
+    return "";
+  }
+
+  std::string soname(
+      std::min<uint64_t>(dynamic_string_table_size.value() - soname_offset.value(),
+                         kMaxSonameLength),
+      '\0');
+  ErrorMessageOr<size_t> bytes_read_or_error = orbit_base::ReadFullyAtOffset(
+      fd, soname.data(), soname.size(), strtab_offset.value() + soname_offset.value());
+  if (bytes_read_or_error.has_error()) {
+    LOG("Unable to read soname from \"%s\": %s", file_path.string(),
+        bytes_read_or_error.error().message());
+    return "";
+  }
+  soname.resize(bytes_read_or_error.value());
+
+  const size_t soname_end = soname.find('\0');
+  if (soname_end == std::string::npos) {
+    ERROR("Dynamic string table is not null-terminated (file=\"%s\")", file_path.string());
+    return "";
+  }
+  soname.resize(soname_end);
+  return soname;
+}
+
+template <typename ElfTypes>
+ErrorMessageOr<ElfMetadata> ReadElfMetadataFromFile(const orbit_base::unique_fd& fd,
+                                                    const std::filesystem::path& file_path) {
+  typename ElfTypes::Ehdr elf_header;
+  OUTCOME_TRY(ReadExactly(fd, &elf_header, sizeof(elf_header), 0));
+
+  std::vector<typename ElfTypes::Phdr> program_headers;
+  if (elf_header.e_phnum != 0 && elf_header.e_phentsize == sizeof(typename ElfTypes::Phdr)) {
+    program_headers.resize(elf_header.e_phnum);
+    OUTCOME_TRY(ReadExactly(fd, program_headers.data(),
+                            program_headers.size() * sizeof(typename ElfTypes::Phdr),
+                            elf_header.e_phoff));
+  }
+  if (program_headers.empty()) {
+    return ErrorMessage("Unable to get load bias. No program headers found.");
+  }
+
+  // Find the executable segment and calculate the load bias based on that segment.
+  auto executable_segment = std::find_if(
+      program_headers.begin(), program_headers.end(), [](const typename ElfTypes::Phdr& phdr) {
+        return phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X) != 0;
+      });
+  if (executable_segment == program_headers.end()) {
+    return ErrorMessage("Unable to get load bias. No executable PT_LOAD segment found.");
+  }
+
+  ElfMetadata metadata;
+  metadata.load_bias = executable_segment->p_vaddr - executable_segment->p_offset;
+
+  for (const typename ElfTypes::Phdr& phdr : program_headers) {
+    if (phdr.p_type == PT_NOTE && metadata.build_id.empty()) {
+      OUTCOME_TRY(notes, ReadSegment(fd, phdr.p_offset, phdr.p_filesz));
+      metadata.build_id = FindBuildIdInNotes(notes, phdr.p_align == 8 ? 8 : 4);
+    } else if (phdr.p_type == PT_DYNAMIC && metadata.soname.empty()) {
+      metadata.soname = ReadSoname<ElfTypes>(fd, program_headers, phdr, file_path);
+    }
+  }
+
+  return metadata;
+}
+
+}  // namespace
+
+ErrorMessageOr<ElfMetadata> ReadElfMetadata(const std::filesystem::path& file_path) {
+  OUTCOME_TRY(fd, orbit_base::OpenFileForReading(file_path));
+
+  std::array<unsigned char, EI_NIDENT> ident{};
+  OUTCOME_TRY(bytes_read, orbit_base::ReadFullyAtOffset(fd, ident.data(), ident.size(), 0));
+  if (bytes_read != ident.size() || memcmp(ident.data(), ELFMAG, SELFMAG) != 0) {
+    return ErrorMessage(absl::StrFormat(
+        "Unable to read ELF file \"%s\": The file was not recognized as a valid object file",
+        file_path.string()));
+  }
+  if (ident[EI_DATA] != ELFDATA2LSB) {
+    return ErrorMessage(absl::StrFormat(
+        "Unable to read ELF file \"%s\": Only little endian ELF files are supported",
+        file_path.string()));
+  }
+
+  ErrorMessageOr<ElfMetadata> metadata_or_error = ErrorMessage{"Invalid ELF class"};
+  switch (ident[EI_CLASS]) {
+    case ELFCLASS32:
+      metadata_or_error = ReadElfMetadataFromFile<Elf32Types>(fd, file_path);
+      break;
+    case ELFCLASS64:
+      metadata_or_error = ReadElfMetadataFromFile<Elf64Types>(fd, file_path);
+      break;
+    default:
+      break;
+  }
+  if (metadata_or_error.has_error()) {
+    return ErrorMessage(absl::StrFormat("Unable to read ELF file \"%s\": %s", file_path.string(),
+                                        metadata_or_error.error().message()));
+  }
+  metadata_or_error.value().is_64_bit = ident[EI_CLASS] == ELFCLASS64;
+  return metadata_or_error;
+}
+
+}  // namespace orbit_elf_utils
@@ -0,0 +1,82 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "ElfUtils/ElfMetadata.h"
+#include "OrbitBase/ExecutablePath.h"
+#include "OrbitBase/Result.h"
+
+using orbit_elf_utils::ElfMetadata;
+using orbit_elf_utils::ReadElfMetadata;
+
+TEST(ElfMetadata, HelloWorld) {
+  const std::filesystem::path file_path =
+      orbit_base::GetExecutableDir() / "testdata" / "hello_world_elf";
+
+  ErrorMessageOr<ElfMetadata> metadata = ReadElfMetadata(file_path);
+  ASSERT_TRUE(metadata.has_value()) << metadata.error().message();
+  EXPECT_EQ(metadata.value().build_id, "d12d54bc5b72ccce54a408bdeda65e2530740ac8");
+  EXPECT_EQ(metadata.value().soname, "");
+  EXPECT_EQ(metadata.value().load_bias, 0x0);
+  EXPECT_TRUE(metadata.value().is_64_bit);
+}
+
+TEST(ElfMetadata, StaticExecutable) {
+  const std::filesystem::path file_path =
+      orbit_base::GetExecutableDir() / "testdata" / "no_symbols_elf";
+
+  ErrorMessageOr<ElfMetadata> metadata = ReadElfMetadata(file_path);
+  ASSERT_TRUE(metadata.has_value()) << metadata.error().message();
+  EXPECT_EQ(metadata.value().build_id, "b5413574bbacec6eacb3b89b1012d0e2cd92ec6b");
+  EXPECT_EQ(metadata.value().load_bias, 0x400000);
+}
+
+TEST(ElfMetadata, Soname) {
+  const std::filesystem::path file_path =
+      orbit_base::GetExecutableDir() / "testdata" / "libtest-1.0.so";
+
+  ErrorMessageOr<ElfMetadata> metadata = ReadElfMetadata(file_path);
+  ASSERT_TRUE(metadata.has_value()) << metadata.error().message();
+  EXPECT_EQ(metadata.value().build_id, "2e70049c5cf42e6c5105825b57104af5882a40a2");
+  EXPECT_EQ(metadata.value().soname, "libtest.so");
+  EXPECT_EQ(metadata.value().load_bias, 0x0);
+}
+
+TEST(ElfMetadata, NoBuildId) {
+  const std::filesystem::path file_path =
+      orbit_base::GetExecutableDir() / "testdata" / "hello_world_elf_no_build_id";
+
+  ErrorMessageOr<ElfMetadata> metadata = ReadElfMetadata(file_path);
+  ASSERT_TRUE(metadata.has_value()) << metadata.error().message();
+  EXPECT_EQ(metadata.value().build_id, "");
+}
+
+TEST(ElfMetadata, NoProgramHeaders) {
+  const std::filesystem::path file_path =
+      orbit_base::GetExecutableDir() / "testdata" / "hello_world_elf_no_program_headers";
+
+  ErrorMessageOr<ElfMetadata> metadata = ReadElfMetadata(file_path);
+  ASSERT_TRUE(metadata.has_error());
+  EXPECT_THAT(metadata.error().message(), testing::HasSubstr("No program headers found"));
+}
+
+TEST(ElfMetadata, NotElf) {
+  const std::filesystem::path file_path =
+      orbit_base::GetExecutableDir() / "testdata" / "Makefile";
+
+  ErrorMessageOr<ElfMetadata> metadata = ReadElfMetadata(file_path);
+  ASSERT_TRUE(metadata.has_error());
+  EXPECT_THAT(metadata.error().message(),
+              testing::HasSubstr("The file was not recognized as a valid object file"));
+}
+
+TEST(ElfMetadata, FileDoesNotExist) {
+  ErrorMessageOr<ElfMetadata> metadata = ReadElfMetadata("/not/a/valid/file/path");
+  ASSERT_TRUE(metadata.has_error());
+  EXPECT_THAT(metadata.error().message(), testing::HasSubstr("Unable to open file"));
+}
@@ -4,73 +4,157 @@
 
 #include "ElfUtils/LinuxMap.h"
 
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/match.h>
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_split.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 #include <algorithm>
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <optional>
 #include <outcome.hpp>
 #include <string>
-#include <system_error>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
-#include "ElfUtils/ElfFile.h"
+#include "ElfUtils/ElfMetadata.h"
+#include "OrbitBase/ForEachInParallel.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/SafeStrerror.h"
 
 namespace orbit_elf_utils {
 
-using orbit_elf_utils::ElfFile;
 using orbit_grpc_protos::ModuleInfo;
 
-ErrorMessageOr<ModuleInfo> CreateModule(const std::filesystem::path& module_path,
-                                        uint64_t start_address, uint64_t end_address) {
+namespace {
+
+// Identifies one version of a module file. Replacing or modifying the file changes the key, so
+// cached metadata of the old version is never returned for the new one.
+struct ModuleFileKey {
+  std::string path;
+  dev_t device = 0;
+  ino_t inode = 0;
+  int64_t modification_time_ns = 0;
+  uint64_t size = 0;
+
+  friend bool operator==(const ModuleFileKey& lhs, const ModuleFileKey& rhs) {
+    return lhs.path == rhs.path && lhs.device == rhs.device && lhs.inode == rhs.inode &&
+           lhs.modification_time_ns == rhs.modification_time_ns && lhs.size == rhs.size;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const ModuleFileKey& key) {
+    return H::combine(std::move(h), key.path, key.device, key.inode, key.modification_time_ns,
+                      key.size);
+  }
+};
+
+// The ELF metadata of all module files seen so far, shared by all callers in the process. The
+// same shared objects are mapped by most processes, and the module list of a process is requested
+// repeatedly, so after the first request almost every module is a cache hit.
+class ElfMetadataCache {
+ public:
+  [[nodiscard]] std::optional<ElfMetadata> Find(const ModuleFileKey& key) {
+    absl::MutexLock lock(&mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return std::nullopt;
+    return it->second;
+  }
+
+  void Insert(const ModuleFileKey& key, const ElfMetadata& metadata) {
+    absl::MutexLock lock(&mutex_);
+    // Entries of files that were replaced are never hit again. Start over instead of growing
+    // without bounds.
+    if (entries_.size() >= kMaxNumEntries) entries_.clear();
+    entries_.insert_or_assign(key, metadata);
+  }
+
+ private:
+  static constexpr size_t kMaxNumEntries = 16 * 1024;
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<ModuleFileKey, ElfMetadata> entries_ ABSL_GUARDED_BY(mutex_);
+};
+
+ElfMetadataCache& GetElfMetadataCache() {
+  static auto* cache = new ElfMetadataCache();
+  return *cache;
+}
+
+ErrorMessageOr<ModuleFileKey> GetModuleFileKey(const std::filesystem::path& module_path) {
   // This excludes mapped character or block devices.
   if (absl::StartsWith(module_path.string(), "/dev/")) {
     return ErrorMessage(absl::StrFormat(
         "The module \"%s\" is a character or block device (is in /dev/)", module_path));
   }
 
-  if (!std::filesystem::exists(module_path)) {
-    return ErrorMessage(absl::StrFormat("The module file \"%s\" does not exist", module_path));
-  }
-  std::error_code error;
-  uint64_t file_size = std::filesystem::file_size(module_path, error);
-  if (error) {
+  struct stat stat_buf {};
+  if (stat(module_path.string().c_str(), &stat_buf) != 0) {
+    if (errno == ENOENT) {
+      return ErrorMessage(absl::StrFormat("The module file \"%s\" does not exist", module_path));
+    }
     return ErrorMessage(
-        absl::StrFormat("Unable to get size of \"%s\": %s", module_path, error.message()));
+        absl::StrFormat("Unable to get size of \"%s\": %s", module_path, SafeStrerror(errno)));
   }
 
-  ErrorMessageOr<std::unique_ptr<ElfFile>> elf_file_or_error = ElfFile::Create(module_path);
-  if (elf_file_or_error.has_error()) {
+  ModuleFileKey key;
+  key.path = module_path.string();
+  key.device = stat_buf.st_dev;
+  key.inode = stat_buf.st_ino;
+  key.modification_time_ns = absl::ToUnixNanos(absl::TimeFromTimespec(stat_buf.st_mtim));
+  key.size = stat_buf.st_size;
+  return key;
+}
+
+ErrorMessageOr<ElfMetadata> ReadAndCacheElfMetadata(const ModuleFileKey& key) {
+  ErrorMessageOr<ElfMetadata> metadata_or_error = ReadElfMetadata(key.path);
+  if (metadata_or_error.has_error()) {
     return ErrorMessage(
-        absl::StrFormat("Unable to load module: %s", elf_file_or_error.error().message()));
+        absl::StrFormat("Unable to load module: %s", metadata_or_error.error().message()));
   }
+  GetElfMetadataCache().Insert(key, metadata_or_error.value());
+  return metadata_or_error;
+}
 
-  ErrorMessageOr<uint64_t> load_bias_or_error = elf_file_or_error.value()->GetLoadBias();
-  // Every loadable module contains a load bias.
-  if (load_bias_or_error.has_error()) {
-    return load_bias_or_error.error();
-  }
+ErrorMessageOr<ElfMetadata> GetElfMetadata(const ModuleFileKey& key) {
+  std::optional<ElfMetadata> cached_metadata = GetElfMetadataCache().Find(key);
+  if (cached_metadata.has_value()) return std::move(cached_metadata.value());
+  return ReadAndCacheElfMetadata(key);
+}
 
+[[nodiscard]] ModuleInfo CreateModuleInfo(const ModuleFileKey& key, const ElfMetadata& metadata,
+                                          uint64_t start_address, uint64_t end_address) {
   ModuleInfo module_info;
-  std::string soname = elf_file_or_error.value()->GetSoname();
-  module_info.set_name(soname.empty() ? std::filesystem::path{module_path}.filename().string()
-                                      : soname);
-  module_info.set_file_path(module_path);
-  module_info.set_file_size(file_size);
+  module_info.set_name(metadata.soname.empty()
+                           ? std::filesystem::path{key.path}.filename().string()
+                           : metadata.soname);
+  module_info.set_file_path(key.path);
+  module_info.set_file_size(key.size);
   module_info.set_address_start(start_address);
   module_info.set_address_end(end_address);
-  module_info.set_build_id(elf_file_or_error.value()->GetBuildId());
-  module_info.set_load_bias(load_bias_or_error.value());
-
+  module_info.set_build_id(metadata.build_id);
+  module_info.set_load_bias(metadata.load_bias);
   return module_info;
 }
 
+}  // namespace
+
+ErrorMessageOr<ModuleInfo> CreateModule(const std::filesystem::path& module_path,
+                                        uint64_t start_address, uint64_t end_address) {
+  OUTCOME_TRY(key, GetModuleFileKey(module_path));
+  OUTCOME_TRY(metadata, GetElfMetadata(key));
+  return CreateModuleInfo(key, metadata, start_address, end_address);
+}
+
 ErrorMessageOr<std::vector<ModuleInfo>> ReadModules(int32_t pid) {
   std::filesystem::path proc_maps_path{absl::StrFormat("/proc/%d/maps", pid)};
   OUTCOME_TRY(proc_maps_data, orbit_base::ReadFileToString(proc_maps_path));
@@ -113,19 +197,52 @@ ErrorMessageOr<std::vector<ModuleInfo>> ParseMaps(std::string_view proc_maps_dat
     }
   }
 
-  std::vector<ModuleInfo> result;
+  struct Module {
+    ModuleFileKey key;
+    AddressRange address_range;
+  };
+  std::vector<Module> modules;
   for (const auto& [module_path, address_range] : address_map) {
     // Filter out entries which are not executable
     if (!address_range.is_executable) continue;
 
-    ErrorMessageOr<ModuleInfo> module_info_or_error =
-        CreateModule(module_path, address_range.start_address, address_range.end_address);
-    if (module_info_or_error.has_error()) {
-      ERROR("Unable to create module: %s", module_info_or_error.error().message());
+    ErrorMessageOr<ModuleFileKey> key_or_error = GetModuleFileKey(module_path);
+    if (key_or_error.has_error()) {
+      ERROR("Unable to create module: %s", key_or_error.error().message());
       continue;
     }
+    modules.push_back({std::move(key_or_error.value()), address_range});
+  }
+
+  std::vector<ErrorMessageOr<ElfMetadata>> metadata;
+  metadata.reserve(modules.size());
+  std::vector<size_t> uncached_modules;
+  for (size_t i = 0; i < modules.size(); ++i) {
+    std::optional<ElfMetadata> cached_metadata = GetElfMetadataCache().Find(modules[i].key);
+    if (cached_metadata.has_value()) {
+      metadata.emplace_back(std::move(cached_metadata.value()));
+    } else {
+      metadata.emplace_back(ErrorMessage{"Module was not read"});
+      uncached_modules.push_back(i);
+    }
+  }
 
-    result.push_back(std::move(module_info_or_error.value()));
+  // Reading the headers of a module is dominated by the latency of open and pread, so the modules
+  // that are not cached yet are read concurrently.
+  orbit_base::ForEachInParallel(uncached_modules.size(), [&](size_t i) {
+    const size_t module_index = uncached_modules[i];
+    metadata[module_index] = ReadAndCacheElfMetadata(modules[module_index].key);
+  });
+
+  std::vector<ModuleInfo> result;
+  for (size_t i = 0; i < modules.size(); ++i) {
+    if (metadata[i].has_error()) {
+      ERROR("Unable to create module: %s", metadata[i].error().message());
+      continue;
+    }
+    result.push_back(CreateModuleInfo(modules[i].key, metadata[i].value(),
+                                      modules[i].address_range.start_address,
+                                      modules[i].address_range.end_address));
   }
 
   return result;
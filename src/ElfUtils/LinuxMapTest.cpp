@@ -18,6 +18,7 @@
 #include "ElfUtils/LinuxMap.h"
 #include "OrbitBase/ExecutablePath.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/TemporaryFile.h"
 #include "module.pb.h"
 
 TEST(LinuxMap, CreateModuleHelloWorld) {
@@ -104,6 +105,33 @@ TEST(LinuxMap, CreateModuleFileDoesNotExist) {
   EXPECT_EQ(result.error().message(), "The module file \"/not/a/valid/file/path\" does not exist");
 }
 
+TEST(LinuxMap, CreateModuleAfterFileWasReplaced) {
+  using orbit_elf_utils::CreateModule;
+
+  auto temporary_file_or_error = orbit_base::TemporaryFile::Create();
+  ASSERT_FALSE(temporary_file_or_error.has_error()) << temporary_file_or_error.error().message();
+  const std::filesystem::path module_path = temporary_file_or_error.value().file_path();
+  const std::filesystem::path test_path = orbit_base::GetExecutableDir() / "testdata";
+
+  constexpr uint64_t kStartAddress = 23;
+  constexpr uint64_t kEndAddress = 8004;
+  std::filesystem::copy_file(test_path / "hello_world_elf", module_path,
+                             std::filesystem::copy_options::overwrite_existing);
+  auto result = CreateModule(module_path, kStartAddress, kEndAddress);
+  ASSERT_FALSE(result.has_error()) << result.error().message();
+  EXPECT_EQ(result.value().build_id(), "d12d54bc5b72ccce54a408bdeda65e2530740ac8");
+  EXPECT_EQ(result.value().file_size(), 16616);
+
+  // The metadata of the module is cached. Replacing the file must not return the cached entry.
+  std::filesystem::copy_file(test_path / "libtest-1.0.so", module_path,
+                             std::filesystem::copy_options::overwrite_existing);
+  result = CreateModule(module_path, kStartAddress, kEndAddress);
+  ASSERT_FALSE(result.has_error()) << result.error().message();
+  EXPECT_EQ(result.value().name(), "libtest.so");
+  EXPECT_EQ(result.value().build_id(), "2e70049c5cf42e6c5105825b57104af5882a40a2");
+  EXPECT_EQ(result.value().file_size(), 16128);
+}
+
 TEST(LinuxMap, ReadModules) {
   const auto result = orbit_elf_utils::ReadModules(getpid());
   EXPECT_FALSE(result.has_error()) << result.error().message();
@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "OrbitBase/Result.h"
+#include "absl/types/span.h"
 #include "llvm/Object/Binary.h"
 #include "llvm/Object/ObjectFile.h"
 #include "symbol.pb.h"
@@ -35,8 +36,15 @@ class ElfFile {
   ElfFile() = default;
   virtual ~ElfFile() = default;
 
+  // Demangles the symbol names on multiple threads for large symbol tables. The order of the
+  // returned symbols does not depend on the number of threads.
   [[nodiscard]] virtual ErrorMessageOr<orbit_grpc_protos::ModuleSymbols>
   LoadSymbolsFromSymtab() = 0;
+  // Same as LoadSymbolsFromSymtab, but leaves SymbolInfo::demangled_name empty. Demangling
+  // dominates the loading time for large binaries, so use this when only the mangled names and
+  // the addresses are needed.
+  [[nodiscard]] virtual ErrorMessageOr<orbit_grpc_protos::ModuleSymbols>
+  LoadSymbolsFromSymtabWithoutDemangling() = 0;
   [[nodiscard]] virtual ErrorMessageOr<orbit_grpc_protos::ModuleSymbols>
   LoadSymbolsFromDynsym() = 0;
   // Background and some terminology
@@ -58,12 +66,19 @@ class ElfFile {
   [[nodiscard]] virtual bool HasDynsym() const = 0;
   [[nodiscard]] virtual bool HasDebugInfo() const = 0;
   [[nodiscard]] virtual bool HasGnuDebuglink() const = 0;
+  // Returns true if the file has a .gcc_except_table section, i.e., it contains code that catches
+  // exceptions or runs cleanups while an exception propagates through it.
+  [[nodiscard]] virtual bool HasGccExceptTable() const = 0;
   [[nodiscard]] virtual bool Is64Bit() const = 0;
   [[nodiscard]] virtual std::string GetBuildId() const = 0;
   [[nodiscard]] virtual std::string GetSoname() const = 0;
   [[nodiscard]] virtual std::filesystem::path GetFilePath() const = 0;
   [[nodiscard]] virtual ErrorMessageOr<orbit_grpc_protos::LineInfo> GetLineInfo(
       uint64_t address) = 0;
+  // Returns the same as calling GetLineInfo for each of `addresses`, but resolves all of them in
+  // one pass. Use this when many addresses are needed, e.g. all sampled addresses of a function.
+  [[nodiscard]] virtual std::vector<ErrorMessageOr<orbit_grpc_protos::LineInfo>> GetLineInfos(
+      absl::Span<const uint64_t> addresses) = 0;
   [[nodiscard]] virtual ErrorMessageOr<orbit_grpc_protos::LineInfo>
   GetDeclarationLocationOfFunction(uint64_t address) = 0;
   [[nodiscard]] virtual std::optional<GnuDebugLinkInfo> GetGnuDebugLinkInfo() const = 0;
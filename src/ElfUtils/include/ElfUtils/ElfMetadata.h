@@ -0,0 +1,36 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ELF_UTILS_ELF_METADATA_H_
+#define ELF_UTILS_ELF_METADATA_H_
+
+#include <stdint.h>
+
+#if defined(__linux)
+
+#include <filesystem>
+#include <string>
+
+#include "OrbitBase/Result.h"
+
+namespace orbit_elf_utils {
+
+// The parts of an ELF file that are needed to describe a loaded module.
+struct ElfMetadata {
+  std::string build_id;
+  std::string soname;
+  uint64_t load_bias = 0;
+  bool is_64_bit = false;
+};
+
+// Reads the metadata of the ELF file at `file_path`. Unlike ElfFile::Create, this does not map
+// the file. Only the ELF header, the program headers, the note segments and the dynamic segment
+// are read, so the cost does not depend on the size of the file. The results are the same as the
+// ones of ElfFile::GetBuildId, GetSoname, GetLoadBias and Is64Bit.
+[[nodiscard]] ErrorMessageOr<ElfMetadata> ReadElfMetadata(const std::filesystem::path& file_path);
+
+}  // namespace orbit_elf_utils
+
+#endif  // defined(__linux)
+#endif  // ELF_UTILS_ELF_METADATA_H_
@@ -16,6 +16,8 @@ constexpr int kMissingInfo = -1;
 // Reserved producer IDs.
 constexpr uint64_t kLinuxTracingProducerId = 0;
 constexpr uint64_t kMemoryInfoProducerId = 1;
+// Events read from the shared memory ring buffers of ProducerSideChannel/SharedMemoryRingBuffer.h.
+constexpr uint64_t kSharedMemoryProducerId = 2;
 constexpr uint64_t kExternalProducerStartingId = 1024;
 
 enum class UnwindingMethod { kDwarfUnwinding, kFramePointerUnwinding };
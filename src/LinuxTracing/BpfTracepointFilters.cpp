@@ -0,0 +1,291 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "BpfTracepointFilters.h"
+
+#include <linux/bpf.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "KernelTracepoints.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/SafeStrerror.h"
+
+namespace orbit_linux_tracing {
+
+namespace {
+
+// Key of the entry of the map of tids that records whether the map is full, with a value other than
+// 0. Tids are never this large.
+constexpr uint32_t kFullKey = UINT32_MAX;
+
+int bpf(bpf_cmd cmd, bpf_attr* attr) {
+  return static_cast<int>(syscall(__NR_bpf, cmd, attr, sizeof(*attr)));
+}
+
+[[nodiscard]] bool UpdateMapElement(int map_fd, uint32_t key, uint32_t value) {
+  bpf_attr attr{};
+  attr.map_fd = map_fd;
+  attr.key = reinterpret_cast<uint64_t>(&key);
+  attr.value = reinterpret_cast<uint64_t>(&value);
+  attr.flags = BPF_ANY;
+  return bpf(BPF_MAP_UPDATE_ELEM, &attr) == 0;
+}
+
+[[nodiscard]] std::optional<uint32_t> LookUpMapElement(int map_fd, uint32_t key) {
+  uint32_t value = 0;
+  bpf_attr attr{};
+  attr.map_fd = map_fd;
+  attr.key = reinterpret_cast<uint64_t>(&key);
+  attr.value = reinterpret_cast<uint64_t>(&value);
+  if (bpf(BPF_MAP_LOOKUP_ELEM, &attr) != 0) return std::nullopt;
+  return value;
+}
+
+// Minimal assembler for the few eBPF instructions the programs below need. The programs are
+// assembled here instead of being compiled with clang, so that no eBPF toolchain is needed.
+class BpfProgram {
+ public:
+  // Moves the tgid of the current thread to r0. Overwrites r1 to r5.
+  void LoadCurrentTgid() {
+    Call(BPF_FUNC_get_current_pid_tgid);
+    Emit(BPF_ALU64 | BPF_RSH | BPF_K, BPF_REG_0, 0, 0, 32);
+  }
+
+  // Moves the 32-bit field at `offset` of the tracepoint record to r1. The context, the pointer to
+  // the record, has to be saved to r6 first with SaveContext.
+  void LoadRecordField32(int16_t offset) {
+    Emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_1, BPF_REG_6, offset, 0);
+  }
+
+  void SaveContext() { Emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0); }
+
+  void LoadImmediate(int32_t imm) { Emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_1, 0, 0, imm); }
+
+  // Moves the 32-bit map value r0 points to to r1.
+  void LoadMapValue32() { Emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_1, BPF_REG_0, 0, 0); }
+
+  // Stores `imm` to the 32-bit map value r0 points to.
+  void StoreMapValue32(int32_t imm) { Emit(BPF_ST | BPF_MEM | BPF_W, BPF_REG_0, 0, 0, imm); }
+
+  // Looks up r1 in the map of tids, leaving in r0 a pointer to the value or 0. Overwrites r1 to r5.
+  void LookUpTid(int map_fd) {
+    StoreKey();
+    LoadMapFd(map_fd);
+    LoadStackAddress(BPF_REG_2, kKeyOffset);
+    Call(BPF_FUNC_map_lookup_elem);
+  }
+
+  // Adds r1 to the map of tids, leaving in r0 0 on success. Overwrites r1 to r5.
+  void AddTid(int map_fd) {
+    StoreKey();
+    Emit(BPF_ST | BPF_MEM | BPF_W, BPF_REG_10, 0, kValueOffset, 1);
+    LoadMapFd(map_fd);
+    LoadStackAddress(BPF_REG_2, kKeyOffset);
+    LoadStackAddress(BPF_REG_3, kValueOffset);
+    Emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_4, 0, 0, BPF_ANY);
+    Call(BPF_FUNC_map_update_elem);
+  }
+
+  // Conditional jumps to a label, whose position is set later with SetLabel.
+  void JumpIfEqual(uint8_t reg, int32_t imm, int label) { Jump(BPF_JEQ, reg, imm, label); }
+  void JumpIfNotEqual(uint8_t reg, int32_t imm, int label) { Jump(BPF_JNE, reg, imm, label); }
+
+  [[nodiscard]] int NewLabel() {
+    label_positions_.push_back(-1);
+    return static_cast<int>(label_positions_.size() - 1);
+  }
+  void SetLabel(int label) { label_positions_[label] = static_cast<int>(instructions_.size()); }
+
+  // Returns `keep_record`, 1 to keep the record and 0 to drop it.
+  void Exit(bool keep_record) {
+    Emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, keep_record ? 1 : 0);
+    Emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+  }
+
+  // Returns the file descriptor of the loaded program, or -1.
+  [[nodiscard]] int Load(const char* name) {
+    for (const auto& [instruction_index, label] : jumps_) {
+      instructions_[instruction_index].off =
+          static_cast<int16_t>(label_positions_[label] - instruction_index - 1);
+    }
+
+    std::string verifier_log(4096, '\0');
+    bpf_attr attr{};
+    attr.prog_type = BPF_PROG_TYPE_TRACEPOINT;
+    attr.insns = reinterpret_cast<uint64_t>(instructions_.data());
+    attr.insn_cnt = static_cast<uint32_t>(instructions_.size());
+    attr.license = reinterpret_cast<uint64_t>("BSD");
+    attr.log_buf = reinterpret_cast<uint64_t>(verifier_log.data());
+    attr.log_size = static_cast<uint32_t>(verifier_log.size());
+    attr.log_level = 1;
+    int fd = bpf(BPF_PROG_LOAD, &attr);
+    if (fd == -1) {
+      ERROR("Loading eBPF program for %s: %s\n%s", name, SafeStrerror(errno),
+            verifier_log.c_str());
+    }
+    return fd;
+  }
+
+ private:
+  // Stack offsets of the key and of the value for the map helpers.
+  static constexpr int16_t kKeyOffset = -4;
+  static constexpr int16_t kValueOffset = -8;
+
+  void Emit(uint8_t code, uint8_t dst_reg, uint8_t src_reg, int16_t off, int32_t imm) {
+    bpf_insn instruction{};
+    instruction.code = code;
+    instruction.dst_reg = dst_reg;
+    instruction.src_reg = src_reg;
+    instruction.off = off;
+    instruction.imm = imm;
+    instructions_.push_back(instruction);
+  }
+
+  void Call(int32_t helper) { Emit(BPF_JMP | BPF_CALL, 0, 0, 0, helper); }
+
+  void Jump(uint8_t op, uint8_t reg, int32_t imm, int label) {
+    jumps_.emplace_back(instructions_.size(), label);
+    Emit(BPF_JMP | op | BPF_K, reg, 0, 0, imm);
+  }
+
+  void StoreKey() { Emit(BPF_STX | BPF_MEM | BPF_W, BPF_REG_10, BPF_REG_1, kKeyOffset, 0); }
+
+  void LoadStackAddress(uint8_t reg, int16_t offset) {
+    Emit(BPF_ALU64 | BPF_MOV | BPF_X, reg, BPF_REG_10, 0, 0);
+    Emit(BPF_ALU64 | BPF_ADD | BPF_K, reg, 0, 0, offset);
+  }
+
+  // Loads the map into r1. This takes two instructions.
+  void LoadMapFd(int map_fd) {
+    Emit(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd);
+    Emit(0, 0, 0, 0, 0);
+  }
+
+  std::vector<bpf_insn> instructions_;
+  std::vector<int> label_positions_;
+  // Pairs of the index of a jump instruction and of the label it jumps to.
+  std::vector<std::pair<size_t, int>> jumps_;
+};
+
+// Keeps the record if the tid in one of the fields at `tid_offsets` is in the map of tids, or if
+// the map is full, as the tids of some threads of the target are then missing from it.
+int LoadTidFilterProgram(int map_fd, const std::vector<int16_t>& tid_offsets, const char* name) {
+  BpfProgram program;
+  const int keep_label = program.NewLabel();
+  const int filter_label = program.NewLabel();
+  program.SaveContext();
+  program.LoadImmediate(static_cast<int32_t>(kFullKey));
+  program.LookUpTid(map_fd);
+  program.JumpIfEqual(BPF_REG_0, 0, filter_label);
+  program.LoadMapValue32();
+  program.JumpIfNotEqual(BPF_REG_1, 0, keep_label);
+  program.SetLabel(filter_label);
+  for (int16_t tid_offset : tid_offsets) {
+    program.LoadRecordField32(tid_offset);
+    program.LookUpTid(map_fd);
+    program.JumpIfNotEqual(BPF_REG_0, 0, keep_label);
+  }
+  program.Exit(false);
+  program.SetLabel(keep_label);
+  program.Exit(true);
+  return program.Load(name);
+}
+
+// Adds the tid of new threads created by the target process to the map of tids. The tracepoint is
+// hit in the context of the thread that creates the new one. If the map is full, this marks it as
+// such, so that the other programs stop filtering.
+int LoadTaskNewtaskProgram(int map_fd, pid_t pid, bool filter) {
+  BpfProgram program;
+  const int not_target_label = program.NewLabel();
+  const int keep_label = program.NewLabel();
+  program.SaveContext();
+  program.LoadCurrentTgid();
+  program.JumpIfNotEqual(BPF_REG_0, pid, not_target_label);
+  // This also adds the pids of the processes the target forks. The records about them that are
+  // then let through are filtered in user space.
+  program.LoadRecordField32(offsetof(task_newtask_tracepoint, pid));
+  program.AddTid(map_fd);
+  program.JumpIfEqual(BPF_REG_0, 0, keep_label);
+  program.LoadImmediate(static_cast<int32_t>(kFullKey));
+  program.LookUpTid(map_fd);
+  program.JumpIfEqual(BPF_REG_0, 0, keep_label);
+  program.StoreMapValue32(1);
+  program.SetLabel(keep_label);
+  program.Exit(true);
+  program.SetLabel(not_target_label);
+  program.Exit(!filter);
+  return program.Load("task:task_newtask");
+}
+
+}  // namespace
+
+std::unique_ptr<BpfTracepointFilters> BpfTracepointFilters::Create(pid_t pid,
+                                                                   bool filter_task_newtask) {
+  bpf_attr attr{};
+  attr.map_type = BPF_MAP_TYPE_HASH;
+  attr.key_size = sizeof(uint32_t);
+  attr.value_size = sizeof(uint32_t);
+  // One more entry for the one at kFullKey.
+  attr.max_entries = kMaxTids + 1;
+  int tids_map_fd = bpf(BPF_MAP_CREATE, &attr);
+  if (tids_map_fd == -1) {
+    ERROR("Creating eBPF map, tracepoints won't be filtered in the kernel: %s",
+          SafeStrerror(errno));
+    return nullptr;
+  }
+
+  std::unique_ptr<BpfTracepointFilters> filters{new BpfTracepointFilters{}};
+  filters->tids_map_fd_ = orbit_base::unique_fd{tids_map_fd};
+  if (!UpdateMapElement(tids_map_fd, kFullKey, 0)) {
+    ERROR("Initializing eBPF map, tracepoints won't be filtered in the kernel: %s",
+          SafeStrerror(errno));
+    return nullptr;
+  }
+  filters->task_newtask_program_fd_ =
+      orbit_base::unique_fd{LoadTaskNewtaskProgram(tids_map_fd, pid, filter_task_newtask)};
+  filters->task_rename_program_fd_ = orbit_base::unique_fd{LoadTidFilterProgram(
+      tids_map_fd, {offsetof(task_rename_tracepoint, pid)}, "task:task_rename")};
+  filters->sched_switch_program_fd_ = orbit_base::unique_fd{LoadTidFilterProgram(
+      tids_map_fd,
+      {offsetof(sched_switch_tracepoint, prev_pid), offsetof(sched_switch_tracepoint, next_pid)},
+      "sched:sched_switch")};
+  filters->sched_wakeup_program_fd_ = orbit_base::unique_fd{LoadTidFilterProgram(
+      tids_map_fd, {offsetof(sched_wakeup_tracepoint, pid)}, "sched:sched_wakeup")};
+
+  if (!filters->task_newtask_program_fd_.valid() || !filters->task_rename_program_fd_.valid() ||
+      !filters->sched_switch_program_fd_.valid() || !filters->sched_wakeup_program_fd_.valid()) {
+    ERROR("Loading eBPF programs, tracepoints won't be filtered in the kernel");
+    return nullptr;
+  }
+  return filters;
+}
+
+bool BpfTracepointFilters::AddTids(const std::vector<pid_t>& tids) {
+  for (pid_t tid : tids) {
+    if (!UpdateMapElement(tids_map_fd_.get(), static_cast<uint32_t>(tid), 1)) {
+      ERROR("Adding tid %d to eBPF map: %s", tid, SafeStrerror(errno));
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BpfTracepointFilters::IsFull() const {
+  return LookUpMapElement(tids_map_fd_.get(), kFullKey).value_or(0) != 0;
+}
+
+bool BpfTracepointFilters::ContainsTid(pid_t tid) const {
+  return LookUpMapElement(tids_map_fd_.get(), static_cast<uint32_t>(tid)).has_value();
+}
+
+}  // namespace orbit_linux_tracing
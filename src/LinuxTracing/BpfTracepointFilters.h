@@ -0,0 +1,76 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_TRACING_BPF_TRACEPOINT_FILTERS_H_
+#define LINUX_TRACING_BPF_TRACEPOINT_FILTERS_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "OrbitBase/File.h"
+
+namespace orbit_linux_tracing {
+
+// eBPF programs that, attached to the sched:sched_switch, sched:sched_wakeup, task:task_newtask and
+// task:task_rename tracepoints, drop in the kernel the records that are not about the threads of
+// the target process, so that they are not copied to the ring buffers and read by TracerThread.
+// The tids of the target are kept in an eBPF map: the initial ones are added with AddTids, the ones
+// created later are added by the program attached to task:task_newtask, which has to be attached
+// before the initial tids are listed and before any of the other programs is used.
+//
+// Tids of threads that have exited are not removed: sched:sched_process_exit is hit before the last
+// sched:sched_switch of the thread, whose record is still needed. If the map fills up, which takes
+// kMaxTids threads created by the target during the capture, the programs stop filtering and let
+// all records through, see IsFull.
+//
+// The filtering is only a first pass: a few records not about the target can pass (for example, a
+// tid that was reused by another process), so the visitors still filter by pid as before.
+//
+// A program is attached to the tracepoint and not to a single perf_event_open file descriptor, and
+// it filters the records of all file descriptors of the tracepoint, including those opened by other
+// tools: attach it to one of the file descriptors of the tracepoint only, and don't attach the
+// programs to tracepoints whose records are needed for other processes too.
+class BpfTracepointFilters {
+ public:
+  // Maximum number of tids that can be tracked.
+  static constexpr uint32_t kMaxTids = 1u << 16u;
+
+  // Returns nullptr if the eBPF map or programs can't be created, for example because the kernel
+  // doesn't support eBPF or the process lacks the privileges. Tracepoints then need to be opened
+  // without filters. If `filter_task_newtask` is false, the program for task:task_newtask only
+  // tracks new tids and lets all records through.
+  [[nodiscard]] static std::unique_ptr<BpfTracepointFilters> Create(pid_t pid,
+                                                                    bool filter_task_newtask);
+
+  [[nodiscard]] int task_newtask_program_fd() const { return task_newtask_program_fd_.get(); }
+  [[nodiscard]] int task_rename_program_fd() const { return task_rename_program_fd_.get(); }
+  [[nodiscard]] int sched_switch_program_fd() const { return sched_switch_program_fd_.get(); }
+  [[nodiscard]] int sched_wakeup_program_fd() const { return sched_wakeup_program_fd_.get(); }
+
+  // Returns false if not all tids could be added, in which case the filters must not be used.
+  [[nodiscard]] bool AddTids(const std::vector<pid_t>& tids);
+
+  // Returns whether the program for task:task_newtask failed to add a new tid because the map was
+  // full, in which case the programs have stopped filtering.
+  [[nodiscard]] bool IsFull() const;
+
+  // For tests.
+  [[nodiscard]] bool ContainsTid(pid_t tid) const;
+
+ private:
+  BpfTracepointFilters() = default;
+
+  orbit_base::unique_fd tids_map_fd_;
+  orbit_base::unique_fd task_newtask_program_fd_;
+  orbit_base::unique_fd task_rename_program_fd_;
+  orbit_base::unique_fd sched_switch_program_fd_;
+  orbit_base::unique_fd sched_wakeup_program_fd_;
+};
+
+}  // namespace orbit_linux_tracing
+
+#endif  // LINUX_TRACING_BPF_TRACEPOINT_FILTERS_H_
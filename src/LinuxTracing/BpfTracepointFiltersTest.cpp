@@ -0,0 +1,153 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "BpfTracepointFilters.h"
+#include "LinuxTracingUtils.h"
+#include "OrbitBase/File.h"
+#include "OrbitBase/ThreadUtils.h"
+#include "PerfEventOpen.h"
+
+namespace orbit_linux_tracing {
+
+namespace {
+
+// Counts the records of a tracepoint on all cpus. The records dropped by the eBPF program attached
+// to the tracepoint are not counted.
+class TracepointCounter {
+ public:
+  TracepointCounter(const char* tracepoint_category, const char* tracepoint_name, int program_fd) {
+    for (int cpu = 0; cpu < GetNumCores(); ++cpu) {
+      fds_.emplace_back(tracepoint_event_open(tracepoint_category, tracepoint_name, -1, cpu));
+      if (!fds_.back().valid()) return;
+    }
+    if (fds_.empty() || !perf_event_set_bpf(fds_[0].get(), program_fd)) return;
+    for (const orbit_base::unique_fd& fd : fds_) {
+      perf_event_enable(fd.get());
+    }
+    opened_ = true;
+  }
+
+  [[nodiscard]] bool opened() const { return opened_; }
+
+  [[nodiscard]] uint64_t GetCount() const {
+    uint64_t total_count = 0;
+    for (const orbit_base::unique_fd& fd : fds_) {
+      uint64_t count = 0;
+      EXPECT_EQ(read(fd.get(), &count, sizeof(count)), sizeof(count));
+      total_count += count;
+    }
+    return total_count;
+  }
+
+ private:
+  std::vector<orbit_base::unique_fd> fds_;
+  bool opened_ = false;
+};
+
+// Each sleep causes a sched:sched_switch record with the thread as prev_pid and a
+// sched:sched_wakeup record with the thread as pid.
+constexpr int kNumSleeps = 10;
+
+void SleepRepeatedly() {
+  for (int i = 0; i < kNumSleeps; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+}  // namespace
+
+TEST(BpfTracepointFilters, ContainsAddedTids) {
+  std::unique_ptr<BpfTracepointFilters> filters =
+      BpfTracepointFilters::Create(getpid(), /*filter_task_newtask=*/true);
+  if (filters == nullptr) GTEST_SKIP() << "eBPF is not available";
+
+  const pid_t tid = orbit_base::GetCurrentThreadId();
+  EXPECT_FALSE(filters->ContainsTid(tid));
+  EXPECT_TRUE(filters->AddTids({tid}));
+  EXPECT_TRUE(filters->ContainsTid(tid));
+}
+
+TEST(BpfTracepointFilters, AddsTidsOfNewThreadsOfTheTarget) {
+  std::unique_ptr<BpfTracepointFilters> filters =
+      BpfTracepointFilters::Create(getpid(), /*filter_task_newtask=*/true);
+  if (filters == nullptr) GTEST_SKIP() << "eBPF is not available";
+  int fd = tracepoint_event_open("task", "task_newtask", -1, 0);
+  if (fd == -1) GTEST_SKIP() << "Opening task:task_newtask failed";
+  ASSERT_TRUE(perf_event_set_bpf(fd, filters->task_newtask_program_fd()));
+
+  pid_t new_tid = -1;
+  std::thread thread{[&new_tid] { new_tid = orbit_base::GetCurrentThreadId(); }};
+  thread.join();
+  EXPECT_TRUE(filters->ContainsTid(new_tid));
+  EXPECT_FALSE(filters->IsFull());
+  close(fd);
+}
+
+TEST(BpfTracepointFilters, DropsSchedulingRecordsOfOtherThreadsOnly) {
+  std::unique_ptr<BpfTracepointFilters> filters =
+      BpfTracepointFilters::Create(getpid(), /*filter_task_newtask=*/true);
+  if (filters == nullptr) GTEST_SKIP() << "eBPF is not available";
+  TracepointCounter sched_switch_counter{"sched", "sched_switch",
+                                         filters->sched_switch_program_fd()};
+  TracepointCounter sched_wakeup_counter{"sched", "sched_wakeup",
+                                         filters->sched_wakeup_program_fd()};
+  if (!sched_switch_counter.opened() || !sched_wakeup_counter.opened()) {
+    GTEST_SKIP() << "Opening the scheduling tracepoints failed";
+  }
+
+  // No tid has been added yet, so the records of all threads are dropped.
+  std::thread other_thread{SleepRepeatedly};
+  other_thread.join();
+  EXPECT_EQ(sched_switch_counter.GetCount(), 0);
+  EXPECT_EQ(sched_wakeup_counter.GetCount(), 0);
+
+  ASSERT_TRUE(filters->AddTids({orbit_base::GetCurrentThreadId()}));
+  SleepRepeatedly();
+  EXPECT_GE(sched_switch_counter.GetCount(), kNumSleeps);
+  EXPECT_GE(sched_wakeup_counter.GetCount(), kNumSleeps);
+}
+
+TEST(BpfTracepointFilters, StopsFilteringWhenTheMapIsFull) {
+  std::unique_ptr<BpfTracepointFilters> filters =
+      BpfTracepointFilters::Create(getpid(), /*filter_task_newtask=*/true);
+  if (filters == nullptr) GTEST_SKIP() << "eBPF is not available";
+  int fd = tracepoint_event_open("task", "task_newtask", -1, 0);
+  if (fd == -1) GTEST_SKIP() << "Opening task:task_newtask failed";
+  ASSERT_TRUE(perf_event_set_bpf(fd, filters->task_newtask_program_fd()));
+  TracepointCounter sched_wakeup_counter{"sched", "sched_wakeup",
+                                         filters->sched_wakeup_program_fd()};
+  if (!sched_wakeup_counter.opened()) GTEST_SKIP() << "Opening sched:sched_wakeup failed";
+
+  // Fill the map with tids larger than any real one.
+  std::vector<pid_t> tids;
+  for (uint32_t i = 0; i < BpfTracepointFilters::kMaxTids; ++i) {
+    tids.push_back(static_cast<pid_t>((1u << 22u) + i));
+  }
+  ASSERT_TRUE(filters->AddTids(tids));
+  EXPECT_FALSE(filters->IsFull());
+
+  // The tid of this new thread of the target can't be added, so its records are let through.
+  pid_t new_tid = -1;
+  std::thread thread{[&new_tid] {
+    new_tid = orbit_base::GetCurrentThreadId();
+    SleepRepeatedly();
+  }};
+  thread.join();
+  EXPECT_FALSE(filters->ContainsTid(new_tid));
+  EXPECT_TRUE(filters->IsFull());
+  EXPECT_GE(sched_wakeup_counter.GetCount(), kNumSleeps);
+  close(fd);
+}
+
+}  // namespace orbit_linux_tracing
@@ -49,6 +49,15 @@ perf_event_attr uprobe_event_attr(const char* module, uint64_t function_offset)
 
   return pe;
 }
+
+perf_event_attr uprobe_event_attr(const char* module, uint64_t function_offset, int32_t cpu) {
+  perf_event_attr pe = uprobe_event_attr(module, function_offset);
+  // A thread-bound event only covers the threads created later if it is inherited. The records of
+  // the inherited events go to the ring buffer of the original event.
+  pe.inherit = cpu == -1 ? 1 : 0;
+
+  return pe;
+}
 }  // namespace
 
 int context_switch_event_open(pid_t pid, int32_t cpu) {
@@ -60,6 +69,14 @@ int context_switch_event_open(pid_t pid, int32_t cpu) {
   return generic_event_open(&pe, pid, cpu);
 }
 
+int dummy_event_open(pid_t pid, int32_t cpu) {
+  perf_event_attr pe = generic_event_attr();
+  pe.type = PERF_TYPE_SOFTWARE;
+  pe.config = PERF_COUNT_SW_DUMMY;
+
+  return generic_event_open(&pe, pid, cpu);
+}
+
 int mmap_task_event_open(pid_t pid, int32_t cpu) {
   perf_event_attr pe = generic_event_attr();
   pe.type = PERF_TYPE_SOFTWARE;
@@ -97,7 +114,7 @@ int callchain_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu) {
 
 int uprobes_retaddr_event_open(const char* module, uint64_t function_offset, pid_t pid,
                                int32_t cpu) {
-  perf_event_attr pe = uprobe_event_attr(module, function_offset);
+  perf_event_attr pe = uprobe_event_attr(module, function_offset, cpu);
   pe.config = 0;
   pe.sample_type |= PERF_SAMPLE_REGS_USER | PERF_SAMPLE_STACK_USER;
   pe.sample_regs_user = SAMPLE_REGS_USER_SP_IP_ARGUMENTS;
@@ -111,7 +128,7 @@ int uprobes_retaddr_event_open(const char* module, uint64_t function_offset, pid
 }
 
 int uretprobes_event_open(const char* module, uint64_t function_offset, pid_t pid, int32_t cpu) {
-  perf_event_attr pe = uprobe_event_attr(module, function_offset);
+  perf_event_attr pe = uprobe_event_attr(module, function_offset, cpu);
   pe.config = 1;  // Set bit 0 of config for uretprobe.
 
   pe.sample_type |= PERF_SAMPLE_REGS_USER;
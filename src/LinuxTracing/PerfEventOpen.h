@@ -52,6 +52,17 @@ inline void perf_event_redirect(int from_fd, int to_fd) {
   }
 }
 
+// Attaches an eBPF program to the tracepoint the file descriptor was opened for. Records for which
+// the program returns 0 are dropped, for all perf_event_open file descriptors of the tracepoint.
+inline bool perf_event_set_bpf(int file_descriptor, int program_fd) {
+  int ret = ioctl(file_descriptor, PERF_EVENT_IOC_SET_BPF, program_fd);
+  if (ret != 0) {
+    ERROR("PERF_EVENT_IOC_SET_BPF: %s", SafeStrerror(errno));
+    return false;
+  }
+  return true;
+}
+
 inline uint64_t perf_event_get_id(int file_descriptor) {
   uint64_t id;
   int ret = ioctl(file_descriptor, PERF_EVENT_IOC_ID, &id);
@@ -118,7 +129,12 @@ int stack_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu);
 // perf_event_open for stack sampling using frame pointers.
 int callchain_sample_event_open(uint64_t period_ns, pid_t pid, int32_t cpu);
 
-// perf_event_open for uprobes and uretprobes.
+// perf_event_open for an event that records nothing. Its ring buffer can receive the records of
+// other events through perf_event_redirect.
+int dummy_event_open(pid_t pid, int32_t cpu);
+
+// perf_event_open for uprobes and uretprobes. With cpu -1, the event is bound to the thread `pid`
+// and is inherited by the threads that this thread creates afterwards.
 int uprobes_retaddr_event_open(const char* module, uint64_t function_offset, pid_t pid,
                                int32_t cpu);
 
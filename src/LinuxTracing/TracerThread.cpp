@@ -13,16 +13,19 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <string>
 #include <string_view>
 #include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "Function.h"
 #include "LinuxTracing/TracerListener.h"
 #include "LinuxTracingUtils.h"
+#include "OrbitBase/ForEachInParallel.h"
 #include "OrbitBase/GetProcessIds.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/MakeUniqueForOverwrite.h"
@@ -46,7 +49,8 @@ TracerThread::TracerThread(const CaptureOptions& capture_options)
       target_pid_{capture_options.pid()},
       unwinding_method_{capture_options.unwinding_method()},
       trace_thread_state_{capture_options.trace_thread_state()},
-      trace_gpu_driver_{capture_options.trace_gpu_driver()} {
+      trace_gpu_driver_{capture_options.trace_gpu_driver()},
+      filter_tracepoints_in_kernel_{capture_options.filter_tracepoints_in_kernel()} {
   if (unwinding_method_ != CaptureOptions::kUndefined) {
     std::optional<uint64_t> sampling_period_ns =
         ComputeSamplingPeriodNs(capture_options.samples_per_second());
@@ -85,13 +89,7 @@ TracerThread::TracerThread(const CaptureOptions& capture_options)
 namespace {
 void CloseFileDescriptors(const std::vector<int>& fds) {
   for (int fd : fds) {
-    close(fd);
-  }
-}
-
-void CloseFileDescriptors(const absl::flat_hash_map<int32_t, int>& fds_per_cpu) {
-  for (const auto& pair : fds_per_cpu) {
-    close(pair.second);
+    if (fd >= 0) close(fd);
   }
 }
 }  // namespace
@@ -106,58 +104,68 @@ void TracerThread::InitUprobesEventVisitor() {
 }
 
 bool TracerThread::OpenUprobes(const orbit_linux_tracing::Function& function,
-                               const std::vector<int32_t>& cpus,
-                               absl::flat_hash_map<int32_t, int>* fds_per_cpu) {
+                               const std::vector<UprobesTarget>& targets,
+                               std::vector<int>* fds_per_target) {
   ORBIT_SCOPE_FUNCTION;
   const char* module = function.file_path().c_str();
   const uint64_t offset = function.file_offset();
-  for (int32_t cpu : cpus) {
-    int fd = uprobes_retaddr_event_open(module, offset, -1, cpu);
+  fds_per_target->assign(targets.size(), -1);
+  bool any_opened = targets.empty();
+  for (size_t i = 0; i < targets.size(); ++i) {
+    int fd = uprobes_retaddr_event_open(module, offset, targets[i].pid, targets[i].cpu);
     if (fd < 0) {
-      ERROR("Opening uprobe %s+%#" PRIx64 " on cpu %d", function.file_path(),
-            function.file_offset(), cpu);
+      ERROR("Opening uprobe %s+%#" PRIx64 " on cpu %d for pid %d", function.file_path(),
+            function.file_offset(), targets[i].cpu, targets[i].pid);
+      // A thread might have exited in the meantime, that's fine as long as other threads remain.
+      if (targets[i].cpu == -1) continue;
       return false;
     }
-    (*fds_per_cpu)[cpu] = fd;
+    (*fds_per_target)[i] = fd;
+    any_opened = true;
   }
-  return true;
+  return any_opened;
 }
 
 bool TracerThread::OpenUretprobes(const orbit_linux_tracing::Function& function,
-                                  const std::vector<int32_t>& cpus,
-                                  absl::flat_hash_map<int32_t, int>* fds_per_cpu) {
+                                  const std::vector<UprobesTarget>& targets,
+                                  std::vector<int>* fds_per_target) {
   ORBIT_SCOPE_FUNCTION;
   const char* module = function.file_path().c_str();
   const uint64_t offset = function.file_offset();
-  for (int32_t cpu : cpus) {
-    int fd = uretprobes_event_open(module, offset, -1, cpu);
+  fds_per_target->assign(targets.size(), -1);
+  bool any_opened = targets.empty();
+  for (size_t i = 0; i < targets.size(); ++i) {
+    int fd = uretprobes_event_open(module, offset, targets[i].pid, targets[i].cpu);
     if (fd < 0) {
-      ERROR("Opening uretprobe %s+%#" PRIx64 " on cpu %d", function.file_path(),
-            function.file_offset(), cpu);
+      ERROR("Opening uretprobe %s+%#" PRIx64 " on cpu %d for pid %d", function.file_path(),
+            function.file_offset(), targets[i].cpu, targets[i].pid);
+      if (targets[i].cpu == -1) continue;
       return false;
     }
-    (*fds_per_cpu)[cpu] = fd;
+    (*fds_per_target)[i] = fd;
+    any_opened = true;
   }
-  return true;
+  return any_opened;
 }
 
-void TracerThread::AddUprobesFileDescriptors(
-    const absl::flat_hash_map<int32_t, int>& uprobes_fds_per_cpu,
-    const orbit_linux_tracing::Function& function) {
+void TracerThread::AddUprobesFileDescriptors(const std::vector<int>& uprobes_fds_per_target,
+                                             const orbit_linux_tracing::Function& function) {
   ORBIT_SCOPE_FUNCTION;
-  for (const auto [cpu, fd] : uprobes_fds_per_cpu) {
+  for (int fd : uprobes_fds_per_target) {
+    if (fd < 0) continue;
     uint64_t stream_id = perf_event_get_id(fd);
     uprobes_uretprobes_ids_to_function_.emplace(stream_id, &function);
     uprobes_ids_.insert(stream_id);
     tracing_fds_.push_back(fd);
+    uprobes_fds_.insert(fd);
   }
 }
 
-void TracerThread::AddUretprobesFileDescriptors(
-    const absl::flat_hash_map<int32_t, int>& uretprobes_fds_per_cpu,
-    const orbit_linux_tracing::Function& function) {
+void TracerThread::AddUretprobesFileDescriptors(const std::vector<int>& uretprobes_fds_per_target,
+                                                const orbit_linux_tracing::Function& function) {
   ORBIT_SCOPE_FUNCTION;
-  for (const auto [cpu, fd] : uretprobes_fds_per_cpu) {
+  for (int fd : uretprobes_fds_per_target) {
+    if (fd < 0) continue;
     uint64_t stream_id = perf_event_get_id(fd);
     uprobes_uretprobes_ids_to_function_.emplace(stream_id, &function);
     uretprobes_ids_.insert(stream_id);
@@ -167,74 +175,141 @@ void TracerThread::AddUretprobesFileDescriptors(
 
 bool TracerThread::OpenUserSpaceProbes(const std::vector<int32_t>& cpus) {
   ORBIT_SCOPE_FUNCTION;
-  bool uprobes_event_open_errors = false;
-
-  absl::flat_hash_map<int32_t, std::vector<int>> uprobes_uretpobres_fds_per_cpu;
-  for (const auto& function : instrumented_functions_) {
-    absl::flat_hash_map<int32_t, int> uprobes_fds_per_cpu;
-    absl::flat_hash_map<int32_t, int> uretprobes_fds_per_cpu;
+  const uint64_t open_begin_timestamp_ns = orbit_base::CaptureTimestampNs();
+
+  std::vector<UprobesTarget> targets;
+  const std::vector<pid_t> tids = GetTidsOfProcess(target_pid_);
+  const bool per_thread = ShouldOpenUprobesPerThread(2 * instrumented_functions_.size(),
+                                                     cpus.size(), tids.size(),
+                                                     MAX_PER_CPU_UPROBES_FDS);
+  if (per_thread) {
+    // Threads created from now on by threads that already have their u(ret)probes inherit them.
+    // Threads created while the u(ret)probes are being opened by threads that don't have all of
+    // them yet miss the remaining ones.
+    targets = CreatePerThreadUprobesTargets(
+        tids, [](pid_t tid) { return dummy_event_open(tid, -1); });
+  } else {
+    targets = CreatePerCpuUprobesTargets(cpus);
+  }
 
+  struct FunctionFds {
+    std::vector<int> uprobes_fds_per_target;
+    std::vector<int> uretprobes_fds_per_target;
+    bool success = false;
+  };
+  std::vector<FunctionFds> fds_per_function(instrumented_functions_.size());
+  orbit_base::ForEachInParallel(instrumented_functions_.size(), [&](size_t function_index) {
+    const Function& function = instrumented_functions_[function_index];
+    FunctionFds& function_fds = fds_per_function[function_index];
     if (manual_instrumentation_config_.IsTimerStartFunction(function.function_id())) {
       // Only open uprobes for a "timer start" manual instrumentation function.
-      if (!OpenUprobes(function, cpus, &uprobes_fds_per_cpu)) {
-        CloseFileDescriptors(uprobes_fds_per_cpu);
-        uprobes_event_open_errors = true;
-        continue;
-      }
+      function_fds.success = OpenUprobes(function, targets, &function_fds.uprobes_fds_per_target);
     } else if (manual_instrumentation_config_.IsTimerStopFunction(function.function_id())) {
       // Only open uretprobes for a "timer stop" manual instrumentation
       // function.
-      if (!OpenUretprobes(function, cpus, &uretprobes_fds_per_cpu)) {
-        CloseFileDescriptors(uretprobes_fds_per_cpu);
-        uprobes_event_open_errors = true;
-        continue;
-      }
+      function_fds.success =
+          OpenUretprobes(function, targets, &function_fds.uretprobes_fds_per_target);
     } else {
       // Open both uprobes and uretprobes for regular functions.
-      bool success = OpenUprobes(function, cpus, &uprobes_fds_per_cpu) &&
-                     OpenUretprobes(function, cpus, &uretprobes_fds_per_cpu);
-      if (!success) {
-        CloseFileDescriptors(uprobes_fds_per_cpu);
-        CloseFileDescriptors(uretprobes_fds_per_cpu);
-        uprobes_event_open_errors = true;
-        continue;
-      }
+      function_fds.success =
+          OpenUprobes(function, targets, &function_fds.uprobes_fds_per_target) &&
+          OpenUretprobes(function, targets, &function_fds.uretprobes_fds_per_target);
+    }
+    if (!function_fds.success) {
+      CloseFileDescriptors(function_fds.uprobes_fds_per_target);
+      CloseFileDescriptors(function_fds.uretprobes_fds_per_target);
+    }
+  });
+
+  bool uprobes_event_open_errors = false;
+  size_t num_fds = 0;
+  std::vector<std::vector<int>> uprobes_uretprobes_fds_per_target(targets.size());
+  for (size_t function_index = 0; function_index < instrumented_functions_.size();
+       ++function_index) {
+    const Function& function = instrumented_functions_[function_index];
+    const FunctionFds& function_fds = fds_per_function[function_index];
+    if (!function_fds.success) {
+      uprobes_event_open_errors = true;
+      continue;
     }
 
     // Uretprobe need to be enabled before uprobes as we support temporarily
     // not having a uprobe associated with a uretprobe but not the opposite.
-    AddUretprobesFileDescriptors(uretprobes_fds_per_cpu, function);
-    AddUprobesFileDescriptors(uprobes_fds_per_cpu, function);
-
-    for (const auto& [cpu, fd] : uretprobes_fds_per_cpu) {
-      uprobes_uretpobres_fds_per_cpu[cpu].push_back(fd);
-    }
-    for (const auto& [cpu, fd] : uprobes_fds_per_cpu) {
-      uprobes_uretpobres_fds_per_cpu[cpu].push_back(fd);
+    AddUretprobesFileDescriptors(function_fds.uretprobes_fds_per_target, function);
+    AddUprobesFileDescriptors(function_fds.uprobes_fds_per_target, function);
+
+    for (const std::vector<int>* fds_per_target :
+         {&function_fds.uretprobes_fds_per_target, &function_fds.uprobes_fds_per_target}) {
+      for (size_t target_index = 0; target_index < fds_per_target->size(); ++target_index) {
+        int fd = (*fds_per_target)[target_index];
+        if (fd < 0) continue;
+        uprobes_uretprobes_fds_per_target[target_index].push_back(fd);
+        ++num_fds;
+      }
     }
   }
 
-  OpenUserSpaceProbesRingBuffers(uprobes_uretpobres_fds_per_cpu);
+  OpenUserSpaceProbesRingBuffers(targets, uprobes_uretprobes_fds_per_target);
+
+  if (instrumented_functions_.size() >= LARGE_INSTRUMENTATION_SET_SIZE) {
+    LOG("Opened %u u(ret)probes file descriptors for %u functions on %u %s in %.0f ms", num_fds,
+        instrumented_functions_.size(), targets.size(), per_thread ? "threads" : "cpus",
+        static_cast<double>(orbit_base::CaptureTimestampNs() - open_begin_timestamp_ns) /
+            NS_PER_MILLISECOND);
+  }
 
   return !uprobes_event_open_errors;
 }
 
 void TracerThread::OpenUserSpaceProbesRingBuffers(
-    const absl::flat_hash_map<int32_t, std::vector<int>>& uprobes_uretpobres_fds_per_cpu) {
+    const std::vector<UprobesTarget>& targets,
+    const std::vector<std::vector<int>>& uprobes_uretprobes_fds_per_target) {
   ORBIT_SCOPE_FUNCTION;
-  for (const auto& [/*int32_t*/ cpu, /*std::vector<int>*/ fds] : uprobes_uretpobres_fds_per_cpu) {
+  // Pairs of a file descriptor and the file descriptor of the ring buffer to redirect it to.
+  std::vector<std::pair<int, int>> redirections;
+  for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+    const UprobesTarget& target = targets[target_index];
+    const std::vector<int>& fds = uprobes_uretprobes_fds_per_target[target_index];
+    if (target.ring_buffer_fd >= 0) tracing_fds_.push_back(target.ring_buffer_fd);
     if (fds.empty()) continue;
 
-    // Create a single ring buffer per cpu.
-    int ring_buffer_fd = fds[0];
-    std::string buffer_name = absl::StrFormat("uprobes_uretprobes_%u", cpu);
-    ring_buffers_.emplace_back(ring_buffer_fd, UPROBES_RING_BUFFER_SIZE_KB, buffer_name);
-
-    // Redirect subsequent fds to the cpu specific ring buffer created above.
-    for (size_t i = 1; i < fds.size(); ++i) {
-      perf_event_redirect(fds[i], ring_buffer_fd);
+    const int ring_buffer_fd = GetUprobesRingBufferFd(target, fds);
+    if (target.ring_buffer_fd >= 0) {
+      // A single ring buffer per thread, owned by a dummy event, as the u(ret)probes of the
+      // thread are inherited and the ring buffer of an inherited event can't be mapped.
+      std::string buffer_name = absl::StrFormat("uprobes_uretprobes_tid_%d", target.pid);
+      PerfEventRingBuffer ring_buffer{ring_buffer_fd, PER_THREAD_UPROBES_RING_BUFFER_SIZE_KB,
+                                      buffer_name};
+      if (!ring_buffer.IsOpen()) {
+        ERROR("Opening ring buffer for u(ret)probes of thread %d", target.pid);
+        continue;
+      }
+      ring_buffers_.emplace_back(std::move(ring_buffer));
+      // Threads created by this thread write to this ring buffer too, from other cpus.
+      unordered_ring_buffer_fds_.insert(ring_buffer_fd);
+    } else {
+      // A single ring buffer per cpu, owned by the first u(ret)probe.
+      std::string buffer_name = absl::StrFormat("uprobes_uretprobes_%u", target.cpu);
+      ring_buffers_.emplace_back(ring_buffer_fd, UPROBES_RING_BUFFER_SIZE_KB, buffer_name);
     }
+
+    std::vector<std::pair<int, int>> target_redirections = GetUprobesRedirections(target, fds);
+    redirections.insert(redirections.end(), target_redirections.begin(),
+                        target_redirections.end());
   }
+
+  orbit_base::ForEachInParallel(redirections.size(), [&redirections](size_t index) {
+    perf_event_redirect(redirections[index].first, redirections[index].second);
+  });
+}
+
+void TracerThread::ReportFirstUprobesEventIfNecessary(uint64_t timestamp_ns) {
+  if (!startup_begin_timestamp_ns_.has_value()) return;
+  LOG("First u(ret)probes event %.0f ms after the start of the capture, with %u instrumented "
+      "functions",
+      static_cast<double>(timestamp_ns - startup_begin_timestamp_ns_.value()) / NS_PER_MILLISECOND,
+      instrumented_functions_.size());
+  startup_begin_timestamp_ns_.reset();
 }
 
 bool TracerThread::OpenMmapTask(const std::vector<int32_t>& cpus) {
@@ -341,14 +416,17 @@ namespace {
 
 struct TracepointToOpen {
   TracepointToOpen(const char* tracepoint_category, const char* tracepoint_name,
-                   absl::flat_hash_set<uint64_t>* tracepoint_stream_ids)
+                   absl::flat_hash_set<uint64_t>* tracepoint_stream_ids, int bpf_program_fd = -1)
       : tracepoint_category{tracepoint_category},
         tracepoint_name{tracepoint_name},
-        tracepoint_stream_ids{tracepoint_stream_ids} {}
+        tracepoint_stream_ids{tracepoint_stream_ids},
+        bpf_program_fd{bpf_program_fd} {}
 
   const char* const tracepoint_category;
   const char* const tracepoint_name;
   absl::flat_hash_set<uint64_t>* const tracepoint_stream_ids;
+  // The eBPF program that filters the records of the tracepoint, or -1.
+  const int bpf_program_fd;
 };
 
 }  // namespace
@@ -357,7 +435,7 @@ static bool OpenFileDescriptorsAndRingBuffersForAllTracepoints(
     const std::vector<TracepointToOpen>& tracepoints_to_open, const std::vector<int32_t>& cpus,
     std::vector<int>* tracing_fds, uint64_t ring_buffer_size_kb,
     absl::flat_hash_map<int32_t, int>* tracepoint_ring_buffer_fds_per_cpu_for_redirection,
-    std::vector<PerfEventRingBuffer>* ring_buffers) {
+    std::vector<PerfEventRingBuffer>* ring_buffers, bool* bpf_programs_attached = nullptr) {
   ORBIT_SCOPE_FUNCTION;
   absl::flat_hash_map<size_t, absl::flat_hash_map<int32_t, int>> index_to_tracepoint_fds_per_cpu;
   bool tracepoint_event_open_errors = false;
@@ -399,6 +477,25 @@ static bool OpenFileDescriptorsAndRingBuffersForAllTracepoints(
     }
   }
 
+  // An eBPF program is attached to the tracepoint itself, so attach it to a single file descriptor.
+  for (const auto& index_and_tracepoint_fds_per_cpu : index_to_tracepoint_fds_per_cpu) {
+    const TracepointToOpen& tracepoint =
+        tracepoints_to_open[index_and_tracepoint_fds_per_cpu.first];
+    if (tracepoint.bpf_program_fd == -1 || index_and_tracepoint_fds_per_cpu.second.empty()) {
+      continue;
+    }
+    if (!perf_event_set_bpf(index_and_tracepoint_fds_per_cpu.second.begin()->second,
+                            tracepoint.bpf_program_fd)) {
+      ERROR("Attaching eBPF filter to %s:%s tracepoint", tracepoint.tracepoint_category,
+            tracepoint.tracepoint_name);
+      if (bpf_programs_attached != nullptr) *bpf_programs_attached = false;
+      continue;
+    }
+    LOG("Warning: Attached eBPF filter to %s:%s tracepoint, until the capture stops other perf "
+        "users on the host only receive the records of this tracepoint about the target process",
+        tracepoint.tracepoint_category, tracepoint.tracepoint_name);
+  }
+
   // Redirect on the same ring buffer all the tracepoint events that are open on each CPU.
   for (const auto& index_and_tracepoint_fds_per_cpu : index_to_tracepoint_fds_per_cpu) {
     const size_t tracepoint_index = index_and_tracepoint_fds_per_cpu.first;
@@ -414,11 +511,79 @@ static bool OpenFileDescriptorsAndRingBuffersForAllTracepoints(
   return true;
 }
 
+void TracerThread::InitBpfTracepointFilters() {
+  ORBIT_SCOPE_FUNCTION;
+  if (!filter_tracepoints_in_kernel_) return;
+  // Without thread states, the records of sched:sched_switch are only needed for the scheduling
+  // slices of all processes, and there is nothing to filter.
+  if (trace_context_switches_ && !trace_thread_state_) return;
+  // The names of the threads of other processes are only needed for their scheduling slices.
+  const bool filter_task_newtask =
+      !trace_context_switches_ && !IsInstrumentedTracepoint("task", "task_newtask");
+  bpf_tracepoint_filters_ = BpfTracepointFilters::Create(target_pid_, filter_task_newtask);
+  if (bpf_tracepoint_filters_ != nullptr) {
+    LOG("Filtering the records of scheduling and task tracepoints in the kernel with eBPF");
+  }
+}
+
+bool TracerThread::IsInstrumentedTracepoint(const char* tracepoint_category,
+                                            const char* tracepoint_name) const {
+  return std::any_of(instrumented_tracepoints_.begin(), instrumented_tracepoints_.end(),
+                     [tracepoint_category, tracepoint_name](
+                         const orbit_grpc_protos::TracepointInfo& instrumented_tracepoint) {
+                       return instrumented_tracepoint.category() == tracepoint_category &&
+                              instrumented_tracepoint.name() == tracepoint_name;
+                     });
+}
+
+int TracerThread::GetBpfTracepointFilterProgramFd(const char* tracepoint_category,
+                                                  const char* tracepoint_name,
+                                                  bool filter_records) const {
+  if (bpf_tracepoint_filters_ == nullptr || !filter_records ||
+      IsInstrumentedTracepoint(tracepoint_category, tracepoint_name)) {
+    return -1;
+  }
+  const std::string_view category{tracepoint_category};
+  const std::string_view name{tracepoint_name};
+  if (category == "task" && name == "task_rename") {
+    return bpf_tracepoint_filters_->task_rename_program_fd();
+  }
+  if (category == "sched" && name == "sched_switch") {
+    return bpf_tracepoint_filters_->sched_switch_program_fd();
+  }
+  if (category == "sched" && name == "sched_wakeup") {
+    return bpf_tracepoint_filters_->sched_wakeup_program_fd();
+  }
+  return -1;
+}
+
 bool TracerThread::OpenThreadNameTracepoints(const std::vector<int32_t>& cpus) {
   ORBIT_SCOPE_FUNCTION;
   absl::flat_hash_map<int32_t, int> thread_name_tracepoint_ring_buffer_fds_per_cpu;
+  bool bpf_programs_attached = true;
+  if (!OpenFileDescriptorsAndRingBuffersForAllTracepoints(
+          {{"task", "task_newtask", &task_newtask_ids_,
+            bpf_tracepoint_filters_ != nullptr
+                ? bpf_tracepoint_filters_->task_newtask_program_fd()
+                : -1}},
+          cpus, &tracing_fds_, THREAD_NAMES_RING_BUFFER_SIZE_KB,
+          &thread_name_tracepoint_ring_buffer_fds_per_cpu, &ring_buffers_,
+          &bpf_programs_attached)) {
+    return false;
+  }
+
+  // The tids of the threads the target creates from now on are tracked by the program attached to
+  // task:task_newtask, so list the existing ones only now.
+  if (bpf_tracepoint_filters_ != nullptr &&
+      (!bpf_programs_attached ||
+       !bpf_tracepoint_filters_->AddTids(GetTidsOfProcess(target_pid_)))) {
+    ERROR("Tracking the tids of the target with eBPF, tracepoints won't be filtered in the kernel");
+    bpf_tracepoint_filters_.reset();
+  }
+
   return OpenFileDescriptorsAndRingBuffersForAllTracepoints(
-      {{"task", "task_newtask", &task_newtask_ids_}, {"task", "task_rename", &task_rename_ids_}},
+      {{"task", "task_rename", &task_rename_ids_,
+        GetBpfTracepointFilterProgramFd("task", "task_rename", !trace_context_switches_)}},
       cpus, &tracing_fds_, THREAD_NAMES_RING_BUFFER_SIZE_KB,
       &thread_name_tracepoint_ring_buffer_fds_per_cpu, &ring_buffers_);
 }
@@ -439,11 +604,16 @@ bool TracerThread::OpenContextSwitchAndThreadStateTracepoints(const std::vector<
   ORBIT_SCOPE_FUNCTION;
   std::vector<TracepointToOpen> tracepoints_to_open;
   if (trace_thread_state_ || trace_context_switches_) {
-    tracepoints_to_open.emplace_back("sched", "sched_switch", &sched_switch_ids_);
+    // The context switches of all processes are needed for their scheduling slices.
+    tracepoints_to_open.emplace_back(
+        "sched", "sched_switch", &sched_switch_ids_,
+        GetBpfTracepointFilterProgramFd("sched", "sched_switch", !trace_context_switches_));
   }
   if (trace_thread_state_) {
     // We also need task:task_newtask, but this is already opened by OpenThreadNameTracepoints.
-    tracepoints_to_open.emplace_back("sched", "sched_wakeup", &sched_wakeup_ids_);
+    tracepoints_to_open.emplace_back(
+        "sched", "sched_wakeup", &sched_wakeup_ids_,
+        GetBpfTracepointFilterProgramFd("sched", "sched_wakeup", /*filter_records=*/true));
   }
   if (tracepoints_to_open.empty()) {
     return true;
@@ -509,6 +679,9 @@ bool TracerThread::OpenInstrumentedTracepoints(const std::vector<int32_t>& cpus)
 void TracerThread::Startup() {
   ORBIT_SCOPE_FUNCTION;
   Reset();
+  if (instrumented_functions_.size() >= LARGE_INSTRUMENTATION_SET_SIZE) {
+    startup_begin_timestamp_ns_ = orbit_base::CaptureTimestampNs();
+  }
 
   // perf_event_open refers to cores as "CPUs".
 
@@ -530,7 +703,7 @@ void TracerThread::Startup() {
   }
 
   // As we open two perf_event_open file descriptors (uprobe and uretprobe) per
-  // cpu per instrumented function, increase the maximum number of open files.
+  // cpu (or per thread) per instrumented function, increase the maximum number of open files.
   SetMaxOpenFilesSoftLimit(GetMaxOpenFilesHardLimit());
 
   event_processor_.SetDiscardedOutOfOrderCounter(&stats_.discarded_out_of_order_count);
@@ -559,6 +732,7 @@ void TracerThread::Startup() {
   }
 
   InitSwitchesStatesNamesVisitor();
+  InitBpfTracepointFilters();
   perf_event_open_errors |= !OpenThreadNameTracepoints(all_cpus);
   if (trace_context_switches_ || trace_thread_state_) {
     perf_event_open_errors |= !OpenContextSwitchAndThreadStateTracepoints(all_cpus);
@@ -583,9 +757,17 @@ void TracerThread::Startup() {
         "or to set /proc/sys/kernel/perf_event_paranoid to -1?");
   }
 
-  // Start recording events.
+  // Start recording events. Enable uprobes last, as we support temporarily not having a uprobe
+  // associated with a uretprobe but not the opposite.
+  std::vector<int> fds_to_enable_first;
+  std::vector<int> fds_to_enable_last;
   for (int fd : tracing_fds_) {
-    perf_event_enable(fd);
+    (uprobes_fds_.contains(fd) ? fds_to_enable_last : fds_to_enable_first).push_back(fd);
+  }
+  for (const std::vector<int>* fds_to_enable : {&fds_to_enable_first, &fds_to_enable_last}) {
+    orbit_base::ForEachInParallel(fds_to_enable->size(), [fds_to_enable](size_t index) {
+      perf_event_enable((*fds_to_enable)[index]);
+    });
   }
 
   effective_capture_start_timestamp_ns_ = orbit_base::CaptureTimestampNs();
@@ -832,9 +1014,10 @@ void TracerThread::ProcessSampleEvent(const perf_event_header& header,
     }
 
     event->SetFunction(uprobes_uretprobes_ids_to_function_.at(event->GetStreamId()));
-    event->SetOrderedInFileDescriptor(fd);
+    if (!unordered_ring_buffer_fds_.contains(fd)) event->SetOrderedInFileDescriptor(fd);
     DeferEvent(std::move(event));
     ++stats_.uprobes_count;
+    ReportFirstUprobesEventIfNecessary(time);
 
   } else if (is_uretprobe) {
     auto event = make_unique_for_overwrite<UretprobesPerfEvent>();
@@ -846,9 +1029,10 @@ void TracerThread::ProcessSampleEvent(const perf_event_header& header,
     }
 
     event->SetFunction(uprobes_uretprobes_ids_to_function_.at(event->GetStreamId()));
-    event->SetOrderedInFileDescriptor(fd);
+    if (!unordered_ring_buffer_fds_.contains(fd)) event->SetOrderedInFileDescriptor(fd);
     DeferEvent(std::move(event));
     ++stats_.uprobes_count;
+    ReportFirstUprobesEventIfNecessary(time);
 
   } else if (is_stack_sample) {
     pid_t pid = ReadSampleRecordPid(ring_buffer);
@@ -1046,7 +1230,9 @@ void TracerThread::RetrieveInitialThreadStatesOfTarget() {
 void TracerThread::Reset() {
   ORBIT_SCOPE_FUNCTION;
   tracing_fds_.clear();
+  uprobes_fds_.clear();
   ring_buffers_.clear();
+  unordered_ring_buffer_fds_.clear();
 
   uprobes_uretprobes_ids_to_function_.clear();
   uprobes_ids_.clear();
@@ -1061,8 +1247,14 @@ void TracerThread::Reset() {
   amdgpu_sched_run_job_ids_.clear();
   dma_fence_signaled_ids_.clear();
   ids_to_tracepoint_info_.clear();
+  if (bpf_tracepoint_filters_ != nullptr && bpf_tracepoint_filters_->IsFull()) {
+    ERROR("The target created too many threads to track with eBPF, so tracepoints were not "
+          "filtered in the kernel for part of the capture");
+  }
+  bpf_tracepoint_filters_.reset();
 
   effective_capture_start_timestamp_ns_ = 0;
+  startup_begin_timestamp_ns_.reset();
 
   stop_deferred_thread_ = false;
   deferred_events_.clear();
@@ -19,6 +19,7 @@
 #include <optional>
 #include <vector>
 
+#include "BpfTracepointFilters.h"
 #include "ContextSwitchManager.h"
 #include "Function.h"
 #include "GpuTracepointVisitor.h"
@@ -30,6 +31,7 @@
 #include "PerfEventProcessor.h"
 #include "PerfEventRingBuffer.h"
 #include "SwitchesStatesNamesVisitor.h"
+#include "UprobesTargets.h"
 #include "UprobesUnwindingVisitor.h"
 #include "capture.pb.h"
 
@@ -63,22 +65,32 @@ class TracerThread {
   void ProcessOneRecord(PerfEventRingBuffer* ring_buffer);
   void InitUprobesEventVisitor();
   bool OpenUserSpaceProbes(const std::vector<int32_t>& cpus);
-  bool OpenUprobes(const orbit_linux_tracing::Function& function, const std::vector<int32_t>& cpus,
-                   absl::flat_hash_map<int32_t, int>* fds_per_cpu);
+  bool OpenUprobes(const orbit_linux_tracing::Function& function,
+                   const std::vector<UprobesTarget>& targets, std::vector<int>* fds_per_target);
   bool OpenUretprobes(const orbit_linux_tracing::Function& function,
-                      const std::vector<int32_t>& cpus,
-                      absl::flat_hash_map<int32_t, int>* fds_per_cpu);
+                      const std::vector<UprobesTarget>& targets, std::vector<int>* fds_per_target);
   bool OpenMmapTask(const std::vector<int32_t>& cpus);
   bool OpenSampling(const std::vector<int32_t>& cpus);
 
-  void AddUprobesFileDescriptors(const absl::flat_hash_map<int32_t, int>& uprobes_fds_per_cpu,
+  void AddUprobesFileDescriptors(const std::vector<int>& uprobes_fds_per_target,
                                  const orbit_linux_tracing::Function& function);
 
-  void AddUretprobesFileDescriptors(const absl::flat_hash_map<int32_t, int>& uretprobes_fds_per_cpu,
+  void AddUretprobesFileDescriptors(const std::vector<int>& uretprobes_fds_per_target,
                                     const orbit_linux_tracing::Function& function);
   void OpenUserSpaceProbesRingBuffers(
-      const absl::flat_hash_map<int32_t, std::vector<int>>& uprobes_uretpobres_fds_per_cpu);
-
+      const std::vector<UprobesTarget>& targets,
+      const std::vector<std::vector<int>>& uprobes_uretprobes_fds_per_target);
+  void ReportFirstUprobesEventIfNecessary(uint64_t timestamp_ns);
+
+  void InitBpfTracepointFilters();
+  [[nodiscard]] bool IsInstrumentedTracepoint(const char* tracepoint_category,
+                                              const char* tracepoint_name) const;
+  // Returns the eBPF program that filters the records of the tracepoint in the kernel, or -1 if
+  // eBPF is not available, if `filter_records` is false or if all records of the tracepoint are
+  // needed because it is also an instrumented tracepoint.
+  [[nodiscard]] int GetBpfTracepointFilterProgramFd(const char* tracepoint_category,
+                                                    const char* tracepoint_name,
+                                                    bool filter_records) const;
   bool OpenThreadNameTracepoints(const std::vector<int32_t>& cpus);
   void InitSwitchesStatesNamesVisitor();
   bool OpenContextSwitchAndThreadStateTracepoints(const std::vector<int32_t>& cpus);
@@ -114,6 +126,7 @@ class TracerThread {
   // in case TracerThread::Run's thread is not scheduled for a few tens of
   // milliseconds.
   static constexpr uint64_t UPROBES_RING_BUFFER_SIZE_KB = 8 * 1024;
+  static constexpr uint64_t PER_THREAD_UPROBES_RING_BUFFER_SIZE_KB = 2 * 1024;
   static constexpr uint64_t MMAP_TASK_RING_BUFFER_SIZE_KB = 64;
   static constexpr uint64_t SAMPLING_RING_BUFFER_SIZE_KB = 16 * 1024;
   static constexpr uint64_t THREAD_NAMES_RING_BUFFER_SIZE_KB = 64;
@@ -121,6 +134,14 @@ class TracerThread {
   static constexpr uint64_t GPU_TRACING_RING_BUFFER_SIZE_KB = 256;
   static constexpr uint64_t INSTRUMENTED_TRACEPOINTS_RING_BUFFER_SIZE_KB = 8 * 1024;
 
+  // u(ret)probes are opened per thread instead of per cpu when the per-cpu ones would need more
+  // file descriptors than this and the target has fewer threads than there are cpus. See
+  // ShouldOpenUprobesPerThread.
+  static constexpr uint64_t MAX_PER_CPU_UPROBES_FDS = 32 * 1024;
+  // For at least this many instrumented functions, the time it takes to open the u(ret)probes and
+  // to receive the first event is logged.
+  static constexpr size_t LARGE_INSTRUMENTATION_SET_SIZE = 1000;
+
   static constexpr uint32_t IDLE_TIME_ON_EMPTY_RING_BUFFERS_US = 100;
   static constexpr uint32_t IDLE_TIME_ON_EMPTY_DEFERRED_EVENTS_US = 1000;
 
@@ -132,12 +153,17 @@ class TracerThread {
   ManualInstrumentationConfig manual_instrumentation_config_;
   bool trace_thread_state_;
   bool trace_gpu_driver_;
+  bool filter_tracepoints_in_kernel_;
   std::vector<orbit_grpc_protos::TracepointInfo> instrumented_tracepoints_;
 
   TracerListener* listener_ = nullptr;
 
   std::vector<int> tracing_fds_;
+  // The uprobes among tracing_fds_, which are enabled after all other file descriptors.
+  absl::flat_hash_set<int> uprobes_fds_;
   std::vector<PerfEventRingBuffer> ring_buffers_;
+  // Ring buffers written by several threads on different cpus, whose records are not ordered.
+  absl::flat_hash_set<int> unordered_ring_buffer_fds_;
 
   absl::flat_hash_map<uint64_t, const Function*> uprobes_uretprobes_ids_to_function_;
   absl::flat_hash_set<uint64_t> uprobes_ids_;
@@ -152,8 +178,12 @@ class TracerThread {
   absl::flat_hash_set<uint64_t> amdgpu_sched_run_job_ids_;
   absl::flat_hash_set<uint64_t> dma_fence_signaled_ids_;
   absl::flat_hash_map<uint64_t, orbit_grpc_protos::TracepointInfo> ids_to_tracepoint_info_;
+  // Null if the records of the tracepoints are not filtered in the kernel.
+  std::unique_ptr<BpfTracepointFilters> bpf_tracepoint_filters_;
 
   uint64_t effective_capture_start_timestamp_ns_ = 0;
+  // Set for large instrumentation sets until the first u(ret)probes event has been received.
+  std::optional<uint64_t> startup_begin_timestamp_ns_;
 
   std::atomic<bool> stop_deferred_thread_ = false;
   std::vector<std::unique_ptr<PerfEvent>> deferred_events_;
@@ -0,0 +1,51 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "UprobesTargets.h"
+
+namespace orbit_linux_tracing {
+
+bool ShouldOpenUprobesPerThread(uint64_t num_probes_per_target, size_t num_cpus,
+                                size_t num_threads, uint64_t max_per_cpu_fds) {
+  return num_probes_per_target * num_cpus > max_per_cpu_fds && num_threads < num_cpus;
+}
+
+std::vector<UprobesTarget> CreatePerCpuUprobesTargets(const std::vector<int32_t>& cpus) {
+  std::vector<UprobesTarget> targets;
+  targets.reserve(cpus.size());
+  for (int32_t cpu : cpus) {
+    targets.push_back({-1, cpu});
+  }
+  return targets;
+}
+
+std::vector<UprobesTarget> CreatePerThreadUprobesTargets(
+    const std::vector<pid_t>& tids, const std::function<int(pid_t)>& open_ring_buffer_fd) {
+  std::vector<UprobesTarget> targets;
+  for (pid_t tid : tids) {
+    int ring_buffer_fd = open_ring_buffer_fd(tid);
+    if (ring_buffer_fd < 0) continue;
+    targets.push_back({tid, -1, ring_buffer_fd});
+  }
+  return targets;
+}
+
+int GetUprobesRingBufferFd(const UprobesTarget& target, const std::vector<int>& fds) {
+  if (target.ring_buffer_fd >= 0) return target.ring_buffer_fd;
+  if (fds.empty()) return -1;
+  return fds[0];
+}
+
+std::vector<std::pair<int, int>> GetUprobesRedirections(const UprobesTarget& target,
+                                                        const std::vector<int>& fds) {
+  const int ring_buffer_fd = GetUprobesRingBufferFd(target, fds);
+  std::vector<std::pair<int, int>> redirections;
+  for (int fd : fds) {
+    if (fd == ring_buffer_fd) continue;
+    redirections.emplace_back(fd, ring_buffer_fd);
+  }
+  return redirections;
+}
+
+}  // namespace orbit_linux_tracing
@@ -0,0 +1,60 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LINUX_TRACING_UPROBES_TARGETS_H_
+#define LINUX_TRACING_UPROBES_TARGETS_H_
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace orbit_linux_tracing {
+
+// Where the u(ret)probes of the instrumented functions are opened, one of each per function and
+// target. A per-cpu target (pid -1) records all threads on that cpu. A per-thread target (cpu -1)
+// records the thread `pid` on all cpus, as well as the threads it creates afterwards, as the
+// u(ret)probes are opened with `inherit`.
+struct UprobesTarget {
+  pid_t pid;
+  int32_t cpu;
+  // For a per-thread target, the dummy event that owns the ring buffer of the thread.
+  int ring_buffer_fd = -1;
+};
+
+// Returns whether to open the u(ret)probes per thread of the target process rather than per cpu.
+//
+// PERF_EVENT_IOC_SET_OUTPUT only redirects a per-thread event to an event of the same thread, and
+// the ring buffer of an inherited event can't be mapped. So unlike per-cpu u(ret)probes, which
+// share one ring buffer per cpu, per-thread ones need a ring buffer, and the dummy event that owns
+// it, for every thread. That is only worth it if the per-cpu u(ret)probes would need more than
+// `max_per_cpu_fds` file descriptors, and only if the process has fewer threads than there are
+// cpus, so that the per-thread ones need fewer file descriptors and ring buffers.
+[[nodiscard]] bool ShouldOpenUprobesPerThread(uint64_t num_probes_per_target, size_t num_cpus,
+                                              size_t num_threads, uint64_t max_per_cpu_fds);
+
+[[nodiscard]] std::vector<UprobesTarget> CreatePerCpuUprobesTargets(
+    const std::vector<int32_t>& cpus);
+
+// Returns a target for each thread in `tids` for which `open_ring_buffer_fd` returns a valid file
+// descriptor. It fails for threads that have exited in the meantime.
+[[nodiscard]] std::vector<UprobesTarget> CreatePerThreadUprobesTargets(
+    const std::vector<pid_t>& tids, const std::function<int(pid_t)>& open_ring_buffer_fd);
+
+// Returns the file descriptor of the event that owns the ring buffer of `target`, given the
+// u(ret)probes file descriptors `fds` of the target: the dummy event of a per-thread target, or the
+// first u(ret)probe of a per-cpu target. Returns -1 if there is none.
+[[nodiscard]] int GetUprobesRingBufferFd(const UprobesTarget& target, const std::vector<int>& fds);
+
+// Returns the pairs of a file descriptor in `fds` and the ring buffer file descriptor of `target`
+// to redirect it to, with PERF_EVENT_IOC_SET_OUTPUT.
+[[nodiscard]] std::vector<std::pair<int, int>> GetUprobesRedirections(const UprobesTarget& target,
+                                                                      const std::vector<int>& fds);
+
+}  // namespace orbit_linux_tracing
+
+#endif  // LINUX_TRACING_UPROBES_TARGETS_H_
@@ -0,0 +1,88 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sys/types.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "UprobesTargets.h"
+
+namespace orbit_linux_tracing {
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testing::Pair;
+
+TEST(ShouldOpenUprobesPerThread, OnlyWhenPerCpuFdsExceedTheLimitAndThreadsAreFewerThanCpus) {
+  constexpr uint64_t kMaxPerCpuFds = 1000;
+  // 2 * 8 per-cpu file descriptors are within the limit.
+  EXPECT_FALSE(ShouldOpenUprobesPerThread(2, 8, 1, kMaxPerCpuFds));
+  // 200 * 8 per-cpu file descriptors are above the limit, and there are fewer threads than cpus.
+  EXPECT_TRUE(ShouldOpenUprobesPerThread(200, 8, 1, kMaxPerCpuFds));
+  EXPECT_TRUE(ShouldOpenUprobesPerThread(200, 8, 7, kMaxPerCpuFds));
+  // As many threads as cpus, or more: per-thread u(ret)probes wouldn't need fewer file descriptors.
+  EXPECT_FALSE(ShouldOpenUprobesPerThread(200, 8, 8, kMaxPerCpuFds));
+  EXPECT_FALSE(ShouldOpenUprobesPerThread(200, 8, 100, kMaxPerCpuFds));
+  // Exactly at the limit.
+  EXPECT_FALSE(ShouldOpenUprobesPerThread(125, 8, 1, kMaxPerCpuFds));
+  EXPECT_TRUE(ShouldOpenUprobesPerThread(126, 8, 1, kMaxPerCpuFds));
+}
+
+TEST(CreatePerCpuUprobesTargets, OneTargetPerCpu) {
+  std::vector<UprobesTarget> targets = CreatePerCpuUprobesTargets({0, 2, 3});
+  ASSERT_EQ(targets.size(), 3);
+  for (size_t i = 0; i < targets.size(); ++i) {
+    EXPECT_EQ(targets[i].pid, -1);
+    EXPECT_EQ(targets[i].ring_buffer_fd, -1);
+  }
+  EXPECT_EQ(targets[0].cpu, 0);
+  EXPECT_EQ(targets[1].cpu, 2);
+  EXPECT_EQ(targets[2].cpu, 3);
+}
+
+TEST(CreatePerThreadUprobesTargets, OneTargetPerThreadWithARingBuffer) {
+  std::vector<pid_t> opened_tids;
+  std::vector<UprobesTarget> targets =
+      CreatePerThreadUprobesTargets({10, 11, 12}, [&opened_tids](pid_t tid) {
+        opened_tids.push_back(tid);
+        // Thread 11 has exited in the meantime.
+        return tid == 11 ? -1 : 100 + tid;
+      });
+  EXPECT_THAT(opened_tids, ElementsAre(10, 11, 12));
+  ASSERT_EQ(targets.size(), 2);
+  EXPECT_EQ(targets[0].pid, 10);
+  EXPECT_EQ(targets[0].cpu, -1);
+  EXPECT_EQ(targets[0].ring_buffer_fd, 110);
+  EXPECT_EQ(targets[1].pid, 12);
+  EXPECT_EQ(targets[1].cpu, -1);
+  EXPECT_EQ(targets[1].ring_buffer_fd, 112);
+}
+
+TEST(GetUprobesRedirections, PerThreadTargetRedirectsAllFdsToItsRingBuffer) {
+  const UprobesTarget target{10, -1, 110};
+  EXPECT_EQ(GetUprobesRingBufferFd(target, {5, 6, 7}), 110);
+  EXPECT_THAT(GetUprobesRedirections(target, {5, 6, 7}),
+              ElementsAre(Pair(5, 110), Pair(6, 110), Pair(7, 110)));
+
+  // The ring buffer is owned by the dummy event, even without u(ret)probes.
+  EXPECT_EQ(GetUprobesRingBufferFd(target, {}), 110);
+  EXPECT_THAT(GetUprobesRedirections(target, {}), IsEmpty());
+}
+
+TEST(GetUprobesRedirections, PerCpuTargetRedirectsToItsFirstFd) {
+  const UprobesTarget target{-1, 3};
+  EXPECT_EQ(GetUprobesRingBufferFd(target, {5, 6, 7}), 5);
+  EXPECT_THAT(GetUprobesRedirections(target, {5, 6, 7}), ElementsAre(Pair(6, 5), Pair(7, 5)));
+
+  EXPECT_EQ(GetUprobesRingBufferFd(target, {5}), 5);
+  EXPECT_THAT(GetUprobesRedirections(target, {5}), IsEmpty());
+  EXPECT_EQ(GetUprobesRingBufferFd(target, {}), -1);
+  EXPECT_THAT(GetUprobesRedirections(target, {}), IsEmpty());
+}
+
+}  // namespace orbit_linux_tracing
@@ -94,4 +94,33 @@ ErrorMessageOr<size_t> ReadFully(const unique_fd& fd, void* buffer, size_t size)
   return size - bytes_left;
 }
 
+ErrorMessageOr<size_t> ReadFullyAtOffset(const unique_fd& fd, void* buffer, size_t size,
+                                         int64_t offset) {
+#if defined(_WIN32)
+  if (_lseeki64(fd.get(), offset, SEEK_SET) == -1) {
+    return ErrorMessage{SafeStrerror(errno)};
+  }
+  return ReadFully(fd, buffer, size);
+#else
+  size_t bytes_left = size;
+  auto current_position = static_cast<uint8_t*>(buffer);
+  int64_t current_offset = offset;
+
+  int64_t result = 0;
+  while (bytes_left != 0 &&
+         (result = TEMP_FAILURE_RETRY(
+              pread(fd.get(), current_position, bytes_left, current_offset))) > 0) {
+    bytes_left -= result;
+    current_position += result;
+    current_offset += result;
+  }
+
+  if (result == -1) {
+    return ErrorMessage{SafeStrerror(errno)};
+  }
+
+  return size - bytes_left;
+#endif
+}
+
 }  // namespace orbit_base
\ No newline at end of file
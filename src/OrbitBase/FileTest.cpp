@@ -111,4 +111,32 @@ TEST(File, ReadFullySmoke) {
   EXPECT_STREQ(buf.data(), "");
 }
 
+TEST(File, ReadFullyAtOffsetSmoke) {
+  const auto fd_or_error =
+      OpenFileForReading(GetExecutableDir() / "testdata" / "OrbitBase" / "textfile.bin");
+  ASSERT_FALSE(fd_or_error.has_error()) << fd_or_error.error().message();
+  const auto& fd = fd_or_error.value();
+  ASSERT_TRUE(fd.valid());
+  std::array<char, 64> buf{};
+
+  ErrorMessageOr<size_t> result = ReadFullyAtOffset(fd, buf.data(), 4, 3);
+  ASSERT_FALSE(result.has_error()) << result.error().message();
+  EXPECT_EQ(result.value(), 4);
+  EXPECT_STREQ(buf.data(), "tent");
+
+  buf = {};
+
+  result = ReadFullyAtOffset(fd, buf.data(), buf.size(), 8);
+  ASSERT_FALSE(result.has_error()) << result.error().message();
+  EXPECT_EQ(result.value(), 8);
+  EXPECT_STREQ(buf.data(), "new line");
+
+  buf = {};
+
+  result = ReadFullyAtOffset(fd, buf.data(), buf.size(), 16);
+  ASSERT_FALSE(result.has_error()) << result.error().message();
+  EXPECT_EQ(result.value(), 0);
+  EXPECT_STREQ(buf.data(), "");
+}
+
 }  // namespace orbit_base
\ No newline at end of file
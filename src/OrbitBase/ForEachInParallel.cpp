@@ -0,0 +1,77 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "OrbitBase/ForEachInParallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "OrbitBase/ThreadPool.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace orbit_base {
+
+namespace {
+
+ThreadPool* GetSharedThreadPool() {
+  // The calling thread of ForEachInParallel is the remaining one. The pool is never destroyed, so
+  // that it can be used until the process exits.
+  static ThreadPool* const thread_pool =
+      ThreadPool::Create(1, std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1,
+                         absl::Seconds(1))
+          .release();
+  return thread_pool;
+}
+
+// Shared between the calling thread and the worker threads. A worker can start after all tasks
+// have finished and ForEachInParallel has returned: it then finds no task left and doesn't touch
+// `task`, which might not exist anymore.
+struct SharedState {
+  SharedState(size_t num_tasks, const std::function<void(size_t)>* task)
+      : num_tasks(num_tasks), task(task) {}
+
+  const size_t num_tasks;
+  const std::function<void(size_t)>* const task;
+  std::atomic<size_t> next_task = 0;
+  absl::Mutex mutex;
+  size_t num_finished_tasks ABSL_GUARDED_BY(mutex) = 0;
+};
+
+void RunTasks(SharedState* state) {
+  size_t num_finished_tasks = 0;
+  for (size_t i = state->next_task++; i < state->num_tasks; i = state->next_task++) {
+    (*state->task)(i);
+    ++num_finished_tasks;
+  }
+  if (num_finished_tasks == 0) return;
+  absl::MutexLock lock{&state->mutex};
+  state->num_finished_tasks += num_finished_tasks;
+}
+
+}  // namespace
+
+void ForEachInParallel(size_t num_tasks, const std::function<void(size_t)>& task) {
+  const size_t num_threads =
+      std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(num_tasks, 1));
+  if (num_threads == 1) {
+    for (size_t i = 0; i < num_tasks; ++i) task(i);
+    return;
+  }
+
+  auto state = std::make_shared<SharedState>(num_tasks, &task);
+  for (size_t i = 1; i < num_threads; ++i) {
+    GetSharedThreadPool()->Schedule([state]() { RunTasks(state.get()); });
+  }
+  RunTasks(state.get());
+
+  absl::MutexLock lock{&state->mutex};
+  state->mutex.Await(absl::Condition(
+      +[](SharedState* state) { return state->num_finished_tasks == state->num_tasks; },
+      state.get()));
+}
+
+}  // namespace orbit_base
@@ -0,0 +1,34 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "OrbitBase/ForEachInParallel.h"
+
+namespace orbit_base {
+
+TEST(ForEachInParallel, RunsEveryTaskOnce) {
+  for (size_t num_tasks : {0, 1, 2, 100, 10'000}) {
+    std::vector<std::atomic<int>> num_runs(num_tasks);
+    ForEachInParallel(num_tasks, [&num_runs](size_t i) { ++num_runs[i]; });
+    for (const std::atomic<int>& num_runs_of_task : num_runs) {
+      EXPECT_EQ(num_runs_of_task, 1);
+    }
+  }
+}
+
+TEST(ForEachInParallel, CanBeNested) {
+  constexpr size_t kNumOuterTasks = 64;
+  constexpr size_t kNumInnerTasks = 64;
+  std::atomic<size_t> num_runs = 0;
+  ForEachInParallel(kNumOuterTasks, [&num_runs](size_t /*i*/) {
+    ForEachInParallel(kNumInnerTasks, [&num_runs](size_t /*j*/) { ++num_runs; });
+  });
+  EXPECT_EQ(num_runs, kNumOuterTasks * kNumInnerTasks);
+}
+
+}  // namespace orbit_base
@@ -33,3 +33,26 @@ TEST(OrbitApi, Encoding) {
   EXPECT_EQ(strlen(decoded_event.name), orbit_api::kMaxEventStringSize - 1);
   EXPECT_TRUE(initial_string.find(decoded_event.name) != std::string::npos);
 }
+
+TEST(OrbitApi, InternedNameEncoding) {
+  static_assert(orbit_api::StringKey("name") != orbit_api::StringKey("other name"));
+  constexpr uint64_t kNameKey = orbit_api::StringKey("The quick brown fox jumps over the lazy dog");
+  constexpr uint64_t kData = 42;
+  constexpr orbit_api_color kColor = kOrbitColorAmber;
+
+  orbit_api::EncodedEvent e(orbit_api::kScopeStart, /*name=*/nullptr, kData, kColor);
+  EXPECT_FALSE(e.HasInternedName());
+  e.SetInternedNameKey(kNameKey);
+  orbit_api::EncodedEvent decoded_event(e.args[0], e.args[1], e.args[2], e.args[3], e.args[4],
+                                        e.args[5]);
+
+  EXPECT_TRUE(decoded_event.HasInternedName());
+  EXPECT_EQ(decoded_event.InternedNameKey(), kNameKey);
+  EXPECT_STREQ(decoded_event.event.name, "");
+  EXPECT_EQ(decoded_event.Type(), orbit_api::kScopeStart);
+  EXPECT_EQ(decoded_event.event.data, kData);
+  EXPECT_EQ(decoded_event.event.color, kColor);
+
+  orbit_api::EncodedEvent event_with_name(orbit_api::kScopeStart, "name");
+  EXPECT_FALSE(event_with_name.HasInternedName());
+}
@@ -170,4 +170,44 @@ void orbit_api_track_double(const char* name, double value, orbit_api_color colo
   TrackValue(orbit_api::kTrackDouble, name, orbit_api::Encode<uint64_t>(value), color);
 }
 
+// Introspection scopes are processed in this process, there is no need to intern their names.
+void orbit_api_start_interned(const char* name, uint64_t /*name_key*/, orbit_api_color color) {
+  orbit_api_start(name, color);
+}
+
+void orbit_api_start_async_interned(const char* name, uint64_t /*name_key*/, uint64_t id,
+                                    orbit_api_color color) {
+  orbit_api_start_async(name, id, color);
+}
+
+void orbit_api_track_int_interned(const char* name, uint64_t /*name_key*/, int value,
+                                  orbit_api_color color) {
+  orbit_api_track_int(name, value, color);
+}
+
+void orbit_api_track_int64_interned(const char* name, uint64_t /*name_key*/, int64_t value,
+                                    orbit_api_color color) {
+  orbit_api_track_int64(name, value, color);
+}
+
+void orbit_api_track_uint_interned(const char* name, uint64_t /*name_key*/, uint32_t value,
+                                   orbit_api_color color) {
+  orbit_api_track_uint(name, value, color);
+}
+
+void orbit_api_track_uint64_interned(const char* name, uint64_t /*name_key*/, uint64_t value,
+                                     orbit_api_color color) {
+  orbit_api_track_uint64(name, value, color);
+}
+
+void orbit_api_track_float_interned(const char* name, uint64_t /*name_key*/, float value,
+                                    orbit_api_color color) {
+  orbit_api_track_float(name, value, color);
+}
+
+void orbit_api_track_double_interned(const char* name, uint64_t /*name_key*/, double value,
+                                     orbit_api_color color) {
+  orbit_api_track_double(name, value, color);
+}
+
 #endif
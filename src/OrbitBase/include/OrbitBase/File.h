@@ -87,6 +87,12 @@ ErrorMessageOr<void> WriteFully(const unique_fd& fd, std::string_view content);
 // used for non-blocking reads from sockets/pipes - it does not handle EAGAIN.
 ErrorMessageOr<size_t> ReadFully(const unique_fd& fd, void* buffer, size_t size);
 
+// Same as ReadFully, but reads from `offset` in the file instead of from the current position.
+// On Linux the file position is not changed, so this can be called from multiple threads on
+// the same file descriptor.
+ErrorMessageOr<size_t> ReadFullyAtOffset(const unique_fd& fd, void* buffer, size_t size,
+                                         int64_t offset);
+
 }  // namespace orbit_base
 
 #endif  // ORBIT_BASE_FILE_H_
@@ -0,0 +1,24 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_BASE_FOR_EACH_IN_PARALLEL_H_
+#define ORBIT_BASE_FOR_EACH_IN_PARALLEL_H_
+
+#include <stddef.h>
+
+#include <functional>
+
+namespace orbit_base {
+
+// Runs task(0) ... task(num_tasks - 1) on the calling thread and concurrently on a thread pool
+// shared by the whole process, and returns when all of them have finished. Tasks are handed out
+// one at a time, so `task` should do enough work to amortize the synchronization.
+//
+// The calling thread also runs tasks and never waits for a worker thread to become available, so
+// this can be called from a task of the shared thread pool itself without deadlocking.
+void ForEachInParallel(size_t num_tasks, const std::function<void(size_t)>& task);
+
+}  // namespace orbit_base
+
+#endif  // ORBIT_BASE_FOR_EACH_IN_PARALLEL_H_
@@ -10,6 +10,7 @@
 #else
 #include <stdint.h>
 #include <time.h>
+#include <x86intrin.h>
 #endif
 
 namespace orbit_base {
@@ -37,6 +38,10 @@ constexpr clockid_t kOrbitCaptureClock = CLOCK_MONOTONIC;
   return 1000000000LL * ts.tv_sec + ts.tv_nsec;
 }
 
+// Reads the time stamp counter of the calling CPU. This is cheaper than CaptureTimestampNs(), but
+// the value needs to be converted before being placed on the capture timeline.
+[[nodiscard]] inline uint64_t ReadTsc() { return __rdtsc(); }
+
 #endif
 
 // Estimates the clock resolution for debugging purposes. Should only be used to display this
@@ -72,6 +72,10 @@ void ApiEventProcessor::ProcessApiEvent(const orbit_api::ApiEvent& api_event) {
     case orbit_api::kString:
       ProcessTrackingEvent(api_event);
       break;
+    case orbit_api::kInternString:
+      // OrbitService resolves interned names and doesn't forward these events.
+      ERROR("Unexpected kInternString ApiEvent");
+      break;
     case orbit_api::kNone:
       UNREACHABLE();
   }
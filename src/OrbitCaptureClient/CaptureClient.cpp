@@ -68,7 +68,8 @@ Future<ErrorMessageOr<CaptureListener::CaptureOutcome>> CaptureClient::Capture(
     TracepointInfoSet selected_tracepoints, absl::flat_hash_set<uint64_t> frame_track_function_ids,
     double samples_per_second, UnwindingMethod unwinding_method, bool collect_thread_state,
     bool enable_introspection, uint64_t max_local_marker_depth_per_command_buffer,
-    bool collect_memory_info, uint64_t memory_sampling_period_ns) {
+    bool collect_memory_info, uint64_t memory_sampling_period_ns,
+    bool enable_user_space_instrumentation, bool filter_tracepoints_in_kernel) {
   absl::MutexLock lock(&state_mutex_);
   if (state_ != State::kStopped) {
     return {
@@ -89,13 +90,14 @@ Future<ErrorMessageOr<CaptureListener::CaptureOutcome>> CaptureClient::Capture(
        selected_functions = std::move(selected_functions), selected_tracepoints,
        frame_track_function_ids = std::move(frame_track_function_ids), collect_thread_state,
        samples_per_second, unwinding_method, enable_introspection,
-       max_local_marker_depth_per_command_buffer, collect_memory_info,
-       memory_sampling_period_ns]() mutable {
+       max_local_marker_depth_per_command_buffer, collect_memory_info, memory_sampling_period_ns,
+       enable_user_space_instrumentation, filter_tracepoints_in_kernel]() mutable {
         return CaptureSync(std::move(process), module_manager, std::move(selected_functions),
                            std::move(selected_tracepoints), std::move(frame_track_function_ids),
                            samples_per_second, unwinding_method, collect_thread_state,
                            enable_introspection, max_local_marker_depth_per_command_buffer,
-                           collect_memory_info, memory_sampling_period_ns);
+                           collect_memory_info, memory_sampling_period_ns,
+                           enable_user_space_instrumentation, filter_tracepoints_in_kernel);
       });
 
   return capture_result;
@@ -107,7 +109,8 @@ ErrorMessageOr<CaptureListener::CaptureOutcome> CaptureClient::CaptureSync(
     TracepointInfoSet selected_tracepoints, absl::flat_hash_set<uint64_t> frame_track_function_ids,
     double samples_per_second, UnwindingMethod unwinding_method, bool collect_thread_state,
     bool enable_introspection, uint64_t max_local_marker_depth_per_command_buffer,
-    bool collect_memory_info, uint64_t memory_sampling_period_ns) {
+    bool collect_memory_info, uint64_t memory_sampling_period_ns,
+    bool enable_user_space_instrumentation, bool filter_tracepoints_in_kernel) {
   ORBIT_SCOPE_FUNCTION;
   writes_done_failed_ = false;
   try_abort_ = false;
@@ -141,6 +144,10 @@ ErrorMessageOr<CaptureListener::CaptureOutcome> CaptureClient::CaptureSync(
   capture_options->set_trace_gpu_driver(true);
   capture_options->set_max_local_marker_depth_per_command_buffer(
       max_local_marker_depth_per_command_buffer);
+  capture_options->set_dynamic_instrumentation_method(
+      enable_user_space_instrumentation ? CaptureOptions::kUserSpaceInstrumentation
+                                        : CaptureOptions::kKernelUprobes);
+  capture_options->set_filter_tracepoints_in_kernel(filter_tracepoints_in_kernel);
   absl::flat_hash_map<uint64_t, InstrumentedFunction> instrumented_functions;
   for (const auto& [function_id, function] : selected_functions) {
     InstrumentedFunction* instrumented_function = capture_options->add_instrumented_functions();
@@ -152,6 +159,7 @@ ErrorMessageOr<CaptureListener::CaptureOutcome> CaptureClient::CaptureSync(
     instrumented_function->set_file_build_id(function.module_build_id());
     instrumented_function->set_function_id(function_id);
     instrumented_function->set_function_name(function.pretty_name());
+    instrumented_function->set_function_size(function.size());
     instrumented_function->set_function_type(
         InstrumentedFunctionTypeFromOrbitType(function.orbit_type()));
     instrumented_functions.insert_or_assign(function_id, *instrumented_function);
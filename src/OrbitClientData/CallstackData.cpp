@@ -19,8 +19,15 @@ void CallstackData::AddCallstackEvent(CallstackEvent callstack_event) {
   std::lock_guard lock(mutex_);
   CHECK(unique_callstacks_.contains(callstack_event.callstack_id()));
   RegisterTime(callstack_event.time());
-  callstack_events_by_tid_[callstack_event.thread_id()][callstack_event.time()] =
-      std::move(callstack_event);
+  auto [event_it, inserted] =
+      callstack_events_by_tid_[callstack_event.thread_id()].insert_or_assign(
+          callstack_event.time(), std::move(callstack_event));
+  if (inserted) AddCallstackEventToHistograms(event_it->second);
+}
+
+void CallstackData::AddCallstackEventToHistograms(const CallstackEvent& event) {
+  callstack_events_histogram_by_tid_[event.thread_id()].Add(event.time());
+  callstack_events_histogram_.Add(event.time());
 }
 
 void CallstackData::RegisterTime(uint64_t time) {
@@ -151,7 +158,25 @@ void CallstackData::AddCallStackFromKnownCallstackData(const CallstackEvent& eve
 
   // The insertion only happens if the hash isn't already present.
   unique_callstacks_.emplace(callstack_id, std::move(unique_callstack));
-  callstack_events_by_tid_[event.thread_id()][event.time()] = CallstackEvent(event);
+  auto [event_it, inserted] =
+      callstack_events_by_tid_[event.thread_id()].insert_or_assign(event.time(), event);
+  if (inserted) AddCallstackEventToHistograms(event_it->second);
+}
+
+std::optional<std::vector<uint32_t>> CallstackData::GetCallstackEventsCountsInTimeBuckets(
+    uint64_t min_timestamp, uint64_t max_timestamp, size_t num_buckets) const {
+  std::lock_guard lock(mutex_);
+  return callstack_events_histogram_.GetCountsInBuckets(min_timestamp, max_timestamp, num_buckets);
+}
+
+std::optional<std::vector<uint32_t>> CallstackData::GetCallstackEventsOfTidCountsInTimeBuckets(
+    int32_t tid, uint64_t min_timestamp, uint64_t max_timestamp, size_t num_buckets) const {
+  std::lock_guard lock(mutex_);
+  auto histogram_it = callstack_events_histogram_by_tid_.find(tid);
+  if (histogram_it == callstack_events_histogram_by_tid_.end()) {
+    return std::vector<uint32_t>(num_buckets, 0);
+  }
+  return histogram_it->second.GetCountsInBuckets(min_timestamp, max_timestamp, num_buckets);
 }
 
 const CallStack* CallstackData::GetCallStack(CallstackID callstack_id) const {
@@ -247,6 +272,8 @@ void CallstackData::FilterCallstackEventsBasedOnMajorityStart() {
       const CallstackEvent& event = time_and_event_it->second;
       const std::vector<uint64_t>& frames = unique_callstacks_.at(event.callstack_id())->frames();
       if (frames.empty() || *frames.rbegin() != majority_outer_frame) {
+        callstack_events_histogram_by_tid_[event.thread_id()].Remove(event.time());
+        callstack_events_histogram_.Remove(event.time());
         time_and_event_it = callstack_events.erase(time_and_event_it);
       } else {
         ++time_and_event_it;
@@ -47,11 +47,9 @@ bool IsOrbitFunctionFromName(const std::string& function_name) {
   return GetOrbitTypeByName(function_name) != FunctionInfo::kNone;
 }
 
-std::unique_ptr<FunctionInfo> CreateFunctionInfo(const SymbolInfo& symbol_info,
-                                                 const std::string& module_path,
-                                                 const std::string& module_build_id) {
-  auto function_info = std::make_unique<FunctionInfo>();
-
+namespace {
+void FillFunctionInfo(const SymbolInfo& symbol_info, const std::string& module_path,
+                      const std::string& module_build_id, FunctionInfo* function_info) {
   function_info->set_name(symbol_info.name());
   function_info->set_pretty_name(symbol_info.demangled_name());
   function_info->set_address(symbol_info.address());
@@ -61,7 +59,23 @@ std::unique_ptr<FunctionInfo> CreateFunctionInfo(const SymbolInfo& symbol_info,
   function_info->set_module_path(module_path);
   function_info->set_module_build_id(module_build_id);
 
-  SetOrbitTypeFromName(function_info.get());
+  SetOrbitTypeFromName(function_info);
+}
+}  // namespace
+
+std::unique_ptr<FunctionInfo> CreateFunctionInfo(const SymbolInfo& symbol_info,
+                                                 const std::string& module_path,
+                                                 const std::string& module_build_id) {
+  auto function_info = std::make_unique<FunctionInfo>();
+  FillFunctionInfo(symbol_info, module_path, module_build_id, function_info.get());
+  return function_info;
+}
+
+FunctionInfo* CreateFunctionInfo(const SymbolInfo& symbol_info, const std::string& module_path,
+                                 const std::string& module_build_id,
+                                 google::protobuf::Arena* arena) {
+  auto* function_info = google::protobuf::Arena::CreateMessage<FunctionInfo>(arena);
+  FillFunctionInfo(symbol_info, module_path, module_build_id, function_info);
   return function_info;
 }
 
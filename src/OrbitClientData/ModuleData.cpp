@@ -17,6 +17,26 @@
 using orbit_client_protos::FunctionInfo;
 using orbit_grpc_protos::ModuleInfo;
 
+namespace {
+
+// Returns the number of elements in the sorted `addresses` that are less than or equal to
+// `address`, i.e., the index std::upper_bound would return. The loop body compiles to a
+// conditional move, which avoids the branch mispredictions of std::upper_bound on lookups with
+// random addresses.
+size_t CountAddressesAtOrBefore(const std::vector<uint64_t>& addresses, uint64_t address) {
+  if (addresses.empty()) return 0;
+  const uint64_t* base = addresses.data();
+  size_t length = addresses.size();
+  while (length > 1) {
+    const size_t half = length / 2;
+    base = (base[half] <= address) ? base + half : base;
+    length -= half;
+  }
+  return (base - addresses.data()) + (*base <= address ? 1 : 0);
+}
+
+}  // namespace
+
 bool ModuleData::is_loaded() const {
   absl::MutexLock lock(&mutex_);
   return is_loaded_;
@@ -45,11 +65,32 @@ void ModuleData::UpdateIfChanged(ModuleInfo info) {
 
   LOG("Module %s contained symbols. Because the module changed, those are now removed.",
       file_path());
-  functions_.clear();
-  hash_to_function_map_.clear();
+  ClearFunctions();
   is_loaded_ = false;
 }
 
+void ModuleData::ClearFunctions() {
+  hash_to_function_map_.clear();
+  functions_.clear();
+  function_addresses_.clear();
+  functions_arena_.Reset();
+}
+
+void ModuleData::AddFunctionToAddressIndex(FunctionInfo* function) {
+  const uint64_t address = function->address();
+  if (function_addresses_.empty() || function_addresses_.back() < address) {
+    function_addresses_.push_back(address);
+    functions_.push_back(function);
+    return;
+  }
+
+  auto it = std::lower_bound(function_addresses_.begin(), function_addresses_.end(), address);
+  CHECK(*it != address);
+  const size_t index = it - function_addresses_.begin();
+  function_addresses_.insert(it, address);
+  functions_.insert(functions_.begin() + index, function);
+}
+
 const orbit_client_protos::FunctionInfo* ModuleData::FindFunctionByRelativeAddress(
     uint64_t relative_address, bool is_exact) const {
   uint64_t elf_address = relative_address + load_bias();
@@ -59,32 +100,44 @@ const orbit_client_protos::FunctionInfo* ModuleData::FindFunctionByRelativeAddre
 const FunctionInfo* ModuleData::FindFunctionByElfAddress(uint64_t elf_address,
                                                          bool is_exact) const {
   absl::MutexLock lock(&mutex_);
-  if (functions_.empty()) return nullptr;
+  const size_t count = CountAddressesAtOrBefore(function_addresses_, elf_address);
+  if (count == 0) return nullptr;
+
+  const FunctionInfo* function = functions_[count - 1];
+  CHECK(function->address() <= elf_address);
 
   if (is_exact) {
-    auto it = functions_.find(elf_address);
-    return (it != functions_.end()) ? it->second.get() : nullptr;
+    return function->address() == elf_address ? function : nullptr;
   }
 
-  auto it = functions_.upper_bound(elf_address);
-  if (it == functions_.begin()) return nullptr;
-
-  --it;
-  FunctionInfo* function = it->second.get();
-  CHECK(function->address() <= elf_address);
-
   if (function->address() + function->size() < elf_address) return nullptr;
 
   return function;
 }
 
+std::optional<size_t> ModuleData::FindFunctionIndexByElfAddress(uint64_t elf_address) const {
+  absl::MutexLock lock(&mutex_);
+  const size_t count = CountAddressesAtOrBefore(function_addresses_, elf_address);
+  if (count == 0) return std::nullopt;
+
+  const FunctionInfo* function = functions_[count - 1];
+  if (function->address() + function->size() < elf_address) return std::nullopt;
+
+  return count - 1;
+}
+
+const FunctionInfo* ModuleData::GetFunctionByIndex(size_t index) const {
+  absl::MutexLock lock(&mutex_);
+  return index < functions_.size() ? functions_[index] : nullptr;
+}
+
 void ModuleData::AddFunctionInfoWithBuildId(const FunctionInfo& function_info,
                                             const std::string& module_build_id) {
   absl::MutexLock lock(&mutex_);
-  CHECK(functions_.find(function_info.address()) == functions_.end());
-  auto value = std::make_unique<FunctionInfo>(function_info);
-  value->set_module_build_id(module_build_id);
-  functions_.insert_or_assign(function_info.address(), std::move(value));
+  auto* function = google::protobuf::Arena::CreateMessage<FunctionInfo>(&functions_arena_);
+  *function = function_info;
+  function->set_module_build_id(module_build_id);
+  AddFunctionToAddressIndex(function);
   is_loaded_ = true;
 }
 
@@ -92,30 +145,63 @@ void ModuleData::AddSymbols(const orbit_grpc_protos::ModuleSymbols& module_symbo
   absl::MutexLock lock(&mutex_);
   CHECK(!is_loaded_);
 
+  // It happens that the same address has multiple symbol names associated
+  // with it. For example: (all the same address)
+  // __cxxabiv1::__enum_type_info::~__enum_type_info()
+  // __cxxabiv1::__shim_type_info::~__shim_type_info()
+  // __cxxabiv1::__array_type_info::~__array_type_info()
+  // __cxxabiv1::__class_type_info::~__class_type_info()
+  // __cxxabiv1::__pbase_type_info::~__pbase_type_info()
+  // Only the first symbol for each address is kept. The symbols are sorted by address once instead
+  // of inserting them one by one into the index.
+  const int num_symbols = module_symbols.symbol_infos_size();
+  std::vector<int> symbol_indices_by_address(num_symbols);
+  for (int i = 0; i < num_symbols; ++i) {
+    symbol_indices_by_address[i] = i;
+  }
+  std::stable_sort(symbol_indices_by_address.begin(), symbol_indices_by_address.end(),
+                   [&module_symbols](int lhs, int rhs) {
+                     return module_symbols.symbol_infos(lhs).address() <
+                            module_symbols.symbol_infos(rhs).address();
+                   });
+
+  std::vector<bool> is_first_symbol_at_address(num_symbols, false);
   uint32_t address_reuse_counter = 0;
-  uint32_t name_reuse_counter = 0;
-  for (const orbit_grpc_protos::SymbolInfo& symbol_info : module_symbols.symbol_infos()) {
-    auto [inserted_it, success_functions] = functions_.try_emplace(
-        symbol_info.address(),
-        function_utils::CreateFunctionInfo(symbol_info, file_path(), build_id()));
-    FunctionInfo* function = inserted_it->second.get();
-    // It happens that the same address has multiple symbol names associated
-    // with it. For example: (all the same address)
-    // __cxxabiv1::__enum_type_info::~__enum_type_info()
-    // __cxxabiv1::__shim_type_info::~__shim_type_info()
-    // __cxxabiv1::__array_type_info::~__array_type_info()
-    // __cxxabiv1::__class_type_info::~__class_type_info()
-    // __cxxabiv1::__pbase_type_info::~__pbase_type_info()
-    if (success_functions) {
-      const bool success_func_hashes =
-          hash_to_function_map_.try_emplace(function_utils::GetHash(*function), function).second;
-      if (!success_func_hashes) {
-        name_reuse_counter++;
-      }
-    } else {
+  for (size_t i = 0; i < symbol_indices_by_address.size(); ++i) {
+    const int symbol_index = symbol_indices_by_address[i];
+    if (i > 0 && module_symbols.symbol_infos(symbol_indices_by_address[i - 1]).address() ==
+                     module_symbols.symbol_infos(symbol_index).address()) {
       address_reuse_counter++;
+      continue;
     }
+    is_first_symbol_at_address[symbol_index] = true;
   }
+
+  // Create the functions in the original symbol order, so that name collisions are resolved the
+  // same way as before.
+  std::vector<FunctionInfo*> functions_by_symbol_index(num_symbols, nullptr);
+  uint32_t name_reuse_counter = 0;
+  for (int i = 0; i < num_symbols; ++i) {
+    if (!is_first_symbol_at_address[i]) continue;
+    FunctionInfo* function = function_utils::CreateFunctionInfo(
+        module_symbols.symbol_infos(i), file_path(), build_id(), &functions_arena_);
+    functions_by_symbol_index[i] = function;
+    const bool success_func_hashes =
+        hash_to_function_map_.try_emplace(function_utils::GetHash(*function), function).second;
+    if (!success_func_hashes) {
+      name_reuse_counter++;
+    }
+  }
+
+  functions_.reserve(num_symbols - address_reuse_counter);
+  function_addresses_.reserve(num_symbols - address_reuse_counter);
+  for (int symbol_index : symbol_indices_by_address) {
+    FunctionInfo* function = functions_by_symbol_index[symbol_index];
+    if (function == nullptr) continue;
+    functions_.push_back(function);
+    function_addresses_.push_back(function->address());
+  }
+
   if (address_reuse_counter != 0) {
     LOG("Warning: %d absolute addresses are used by more than one symbol", address_reuse_counter);
   }
@@ -136,19 +222,14 @@ const orbit_client_protos::FunctionInfo* ModuleData::FindFunctionFromHash(uint64
 
 std::vector<const FunctionInfo*> ModuleData::GetFunctions() const {
   absl::MutexLock lock(&mutex_);
-  std::vector<const FunctionInfo*> result;
-  result.reserve(functions_.size());
-  for (const auto& pair : functions_) {
-    result.push_back(pair.second.get());
-  }
-  return result;
+  return std::vector<const FunctionInfo*>(functions_.begin(), functions_.end());
 }
 
 std::vector<FunctionInfo> ModuleData::GetOrbitFunctions() const {
   absl::MutexLock lock(&mutex_);
   CHECK(is_loaded_);
   std::vector<FunctionInfo> result;
-  for (const auto& [_, function] : functions_) {
+  for (const FunctionInfo* function : functions_) {
     if (function_utils::IsOrbitFunctionFromType(function->orbit_type())) {
       result.emplace_back(*function);
     }
@@ -10,6 +10,7 @@
 
 #include "OrbitClientData/FunctionUtils.h"
 #include "OrbitClientData/ModuleData.h"
+#include "absl/strings/str_format.h"
 #include "capture_data.pb.h"
 #include "module.pb.h"
 #include "symbol.pb.h"
@@ -161,6 +162,74 @@ TEST(ModuleData, FindFunctionByRelativeAddress) {
   }
 }
 
+TEST(ModuleData, AddSymbolsOutOfOrderAndWithDuplicateAddresses) {
+  ModuleSymbols symbols;
+  auto add_symbol = [&symbols](const std::string& name, uint64_t address) {
+    SymbolInfo* symbol = symbols.add_symbol_infos();
+    symbol->set_name(name);
+    symbol->set_demangled_name(name);
+    symbol->set_address(address);
+    symbol->set_size(10);
+  };
+  add_symbol("third", 300);
+  add_symbol("first", 100);
+  add_symbol("second", 200);
+  add_symbol("first duplicate", 100);
+  add_symbol("fourth", 400);
+
+  ModuleData module{ModuleInfo{}};
+  module.AddSymbols(symbols);
+  ASSERT_TRUE(module.is_loaded());
+
+  // The first symbol at an address wins, and the functions are ordered by address.
+  std::vector<const FunctionInfo*> functions = module.GetFunctions();
+  ASSERT_EQ(functions.size(), 4);
+  EXPECT_EQ(functions[0]->name(), "first");
+  EXPECT_EQ(functions[1]->name(), "second");
+  EXPECT_EQ(functions[2]->name(), "third");
+  EXPECT_EQ(functions[3]->name(), "fourth");
+
+  for (uint64_t address = 0; address < 500; ++address) {
+    const FunctionInfo* result = module.FindFunctionByRelativeAddress(address, false);
+    if (address < 100 || address % 100 > 10) {
+      EXPECT_EQ(result, nullptr) << address;
+      continue;
+    }
+    ASSERT_NE(result, nullptr) << address;
+    EXPECT_EQ(result->address(), address - address % 100);
+
+    const FunctionInfo* exact_result = module.FindFunctionByRelativeAddress(address, true);
+    EXPECT_EQ(exact_result, address % 100 == 0 ? result : nullptr) << address;
+  }
+
+  EXPECT_EQ(module.FindFunctionFromHash(function_utils::GetHash(*functions[0])), functions[0]);
+}
+
+TEST(ModuleData, AddFunctionInfoWithBuildIdOutOfOrder) {
+  ModuleData module{ModuleInfo{}};
+  for (uint64_t address : {300, 100, 400, 200}) {
+    FunctionInfo function_info;
+    function_info.set_name(absl::StrFormat("function at %d", address));
+    function_info.set_address(address);
+    function_info.set_size(10);
+    module.AddFunctionInfoWithBuildId(function_info, "build id");
+  }
+  ASSERT_TRUE(module.is_loaded());
+
+  std::vector<const FunctionInfo*> functions = module.GetFunctions();
+  ASSERT_EQ(functions.size(), 4);
+  for (size_t i = 0; i < functions.size(); ++i) {
+    EXPECT_EQ(functions[i]->address(), 100 * (i + 1));
+    EXPECT_EQ(functions[i]->module_build_id(), "build id");
+  }
+
+  const FunctionInfo* result = module.FindFunctionByElfAddress(205, false);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(result->name(), "function at 200");
+  EXPECT_EQ(module.FindFunctionByElfAddress(205, true), nullptr);
+  EXPECT_EQ(module.FindFunctionByElfAddress(400, true), functions[3]);
+}
+
 TEST(ModuleData, FindFunctionFromHash) {
   ModuleSymbols symbols;
 
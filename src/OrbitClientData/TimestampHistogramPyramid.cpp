@@ -0,0 +1,80 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "OrbitClientData/TimestampHistogramPyramid.h"
+
+#include <algorithm>
+
+#include "OrbitBase/Logging.h"
+
+void TimestampHistogramPyramid::Add(uint64_t timestamp) {
+  pending_timestamps_.push_back(timestamp);
+  if (pending_timestamps_.size() >= kMaxPendingTimestamps) AddPendingTimestampsToBins();
+}
+
+void TimestampHistogramPyramid::AddPendingTimestampsToBins() const {
+  if (pending_timestamps_.empty()) return;
+  std::sort(pending_timestamps_.begin(), pending_timestamps_.end());
+  for (size_t level = 0; level < kBinWidthLog2ByLevel.size(); ++level) {
+    const uint32_t bin_width_log2 = kBinWidthLog2ByLevel[level];
+    auto& counts = counts_by_level_[level];
+    // The bins are visited in increasing order, so each one is inserted right before the hint.
+    auto hint = counts.lower_bound(pending_timestamps_.front() >> bin_width_log2);
+    for (auto it = pending_timestamps_.begin(); it != pending_timestamps_.end();) {
+      const uint64_t bin = *it >> bin_width_log2;
+      const auto bin_end = std::find_if(
+          it, pending_timestamps_.end(),
+          [bin, bin_width_log2](uint64_t timestamp) { return timestamp >> bin_width_log2 != bin; });
+      hint = counts.try_emplace(hint, bin, 0);
+      hint->second += static_cast<uint32_t>(bin_end - it);
+      ++hint;
+      it = bin_end;
+    }
+  }
+  pending_timestamps_.clear();
+}
+
+void TimestampHistogramPyramid::Remove(uint64_t timestamp) {
+  AddPendingTimestampsToBins();
+  for (size_t level = 0; level < kBinWidthLog2ByLevel.size(); ++level) {
+    auto& counts = counts_by_level_[level];
+    auto it = counts.find(timestamp >> kBinWidthLog2ByLevel[level]);
+    CHECK(it != counts.end());
+    CHECK(it->second > 0);
+    if (--it->second == 0) {
+      counts.erase(it);
+    }
+  }
+}
+
+std::optional<std::vector<uint32_t>> TimestampHistogramPyramid::GetCountsInBuckets(
+    uint64_t min_timestamp, uint64_t max_timestamp, size_t num_buckets) const {
+  CHECK(min_timestamp <= max_timestamp);
+  CHECK(num_buckets > 0);
+  AddPendingTimestampsToBins();
+  const double range = static_cast<double>(max_timestamp - min_timestamp) + 1.0;
+  const double bucket_width = range / static_cast<double>(num_buckets);
+  constexpr double kMinBinsPerBucket = 4.0;
+
+  std::optional<size_t> selected_level;
+  for (size_t level = 0; level < kBinWidthLog2ByLevel.size(); ++level) {
+    const auto bin_width = static_cast<double>(uint64_t{1} << kBinWidthLog2ByLevel[level]);
+    if (bin_width * kMinBinsPerBucket > bucket_width) break;
+    selected_level = level;
+  }
+  if (!selected_level.has_value()) return std::nullopt;
+
+  const uint32_t bin_width_log2 = kBinWidthLog2ByLevel[selected_level.value()];
+  const auto& counts = counts_by_level_[selected_level.value()];
+  std::vector<uint32_t> bucket_counts(num_buckets, 0);
+  for (auto it = counts.lower_bound(min_timestamp >> bin_width_log2);
+       it != counts.end() && it->first <= (max_timestamp >> bin_width_log2); ++it) {
+    const uint64_t bin_center = (it->first << bin_width_log2) + (uint64_t{1} << bin_width_log2) / 2;
+    const uint64_t clamped_center = std::clamp(bin_center, min_timestamp, max_timestamp);
+    auto bucket =
+        static_cast<size_t>(static_cast<double>(clamped_center - min_timestamp) / bucket_width);
+    bucket_counts[std::min(bucket, num_buckets - 1)] += it->second;
+  }
+  return bucket_counts;
+}
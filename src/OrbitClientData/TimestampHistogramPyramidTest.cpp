@@ -0,0 +1,95 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+#include "OrbitClientData/TimestampHistogramPyramid.h"
+
+using ::testing::ElementsAre;
+
+namespace {
+
+constexpr uint64_t kOneSecondNs = 1'000'000'000;
+
+uint32_t Sum(const std::vector<uint32_t>& counts) {
+  return std::accumulate(counts.begin(), counts.end(), 0u);
+}
+
+}  // namespace
+
+TEST(TimestampHistogramPyramid, EmptyHistogram) {
+  TimestampHistogramPyramid histogram;
+  std::optional<std::vector<uint32_t>> counts =
+      histogram.GetCountsInBuckets(0, kOneSecondNs - 1, 4);
+  ASSERT_TRUE(counts.has_value());
+  EXPECT_THAT(counts.value(), ElementsAre(0, 0, 0, 0));
+}
+
+TEST(TimestampHistogramPyramid, CountsInBuckets) {
+  TimestampHistogramPyramid histogram;
+  // 10 kHz sampling during one second.
+  for (uint64_t timestamp = kOneSecondNs; timestamp < 2 * kOneSecondNs; timestamp += 100'000) {
+    histogram.Add(timestamp);
+  }
+
+  std::optional<std::vector<uint32_t>> counts =
+      histogram.GetCountsInBuckets(kOneSecondNs, 2 * kOneSecondNs - 1, 1000);
+  ASSERT_TRUE(counts.has_value());
+  EXPECT_EQ(Sum(counts.value()), 10'000);
+  for (uint32_t count : counts.value()) {
+    // Bins and buckets are not aligned, so counts can deviate by the size of a bin.
+    EXPECT_GE(count, 8);
+    EXPECT_LE(count, 12);
+  }
+
+  // Only the first half of the samples is in range, and bins at the end of the range are partially
+  // outside of it.
+  counts = histogram.GetCountsInBuckets(0, kOneSecondNs + kOneSecondNs / 2 - 1, 100);
+  ASSERT_TRUE(counts.has_value());
+  EXPECT_NEAR(Sum(counts.value()), 5'000, 100);
+  EXPECT_EQ(Sum(std::vector<uint32_t>(counts->begin(), counts->begin() + 60)), 0);
+}
+
+TEST(TimestampHistogramPyramid, ReturnsNulloptWhenBucketsAreTooNarrow) {
+  TimestampHistogramPyramid histogram;
+  histogram.Add(1000);
+  EXPECT_FALSE(histogram.GetCountsInBuckets(0, 9'999, 1000).has_value());
+}
+
+TEST(TimestampHistogramPyramid, CountsTimestampsAddedOutOfOrder) {
+  TimestampHistogramPyramid histogram;
+  // More timestamps than are binned in one batch, alternating between two seconds.
+  for (uint64_t i = 0; i < 10'000; ++i) {
+    histogram.Add((1 + i % 2) * kOneSecondNs + kOneSecondNs / 2 + i * 1000);
+  }
+
+  std::optional<std::vector<uint32_t>> counts =
+      histogram.GetCountsInBuckets(0, 4 * kOneSecondNs - 1, 4);
+  ASSERT_TRUE(counts.has_value());
+  EXPECT_THAT(counts.value(), ElementsAre(0, 5'000, 5'000, 0));
+
+  histogram.Add(3 * kOneSecondNs + kOneSecondNs / 2);
+  counts = histogram.GetCountsInBuckets(0, 4 * kOneSecondNs - 1, 4);
+  ASSERT_TRUE(counts.has_value());
+  EXPECT_THAT(counts.value(), ElementsAre(0, 5'000, 5'000, 1));
+}
+
+TEST(TimestampHistogramPyramid, Remove) {
+  TimestampHistogramPyramid histogram;
+  histogram.Add(kOneSecondNs + kOneSecondNs / 2);
+  histogram.Add(kOneSecondNs + kOneSecondNs / 2 + 1);
+  histogram.Add(3 * kOneSecondNs + kOneSecondNs / 2);
+  histogram.Remove(kOneSecondNs + kOneSecondNs / 2 + 1);
+
+  std::optional<std::vector<uint32_t>> counts =
+      histogram.GetCountsInBuckets(0, 4 * kOneSecondNs - 1, 4);
+  ASSERT_TRUE(counts.has_value());
+  EXPECT_THAT(counts.value(), ElementsAre(0, 1, 0, 1));
+}
@@ -12,10 +12,12 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <vector>
 
 #include "Callstack.h"
 #include "CallstackTypes.h"
+#include "TimestampHistogramPyramid.h"
 #include "absl/container/flat_hash_map.h"
 #include "capture_data.pb.h"
 
@@ -66,6 +68,15 @@ class CallstackData {
       int32_t tid, uint64_t min_timestamp, uint64_t max_timestamp,
       const std::function<void(const orbit_client_protos::CallstackEvent&)>& action) const;
 
+  // Returns approximate counts of callstack events in `num_buckets` buckets of equal width
+  // covering [min_timestamp, max_timestamp], without visiting each event. See
+  // TimestampHistogramPyramid::GetCountsInBuckets for details.
+  [[nodiscard]] std::optional<std::vector<uint32_t>> GetCallstackEventsCountsInTimeBuckets(
+      uint64_t min_timestamp, uint64_t max_timestamp, size_t num_buckets) const;
+
+  [[nodiscard]] std::optional<std::vector<uint32_t>> GetCallstackEventsOfTidCountsInTimeBuckets(
+      int32_t tid, uint64_t min_timestamp, uint64_t max_timestamp, size_t num_buckets) const;
+
   [[nodiscard]] uint64_t max_time() const {
     std::lock_guard lock(mutex_);
     return max_time_;
@@ -97,6 +108,7 @@ class CallstackData {
   [[nodiscard]] std::shared_ptr<CallStack> GetCallstackPtr(CallstackID callstack_id) const;
 
   void RegisterTime(uint64_t time);
+  void AddCallstackEventToHistograms(const orbit_client_protos::CallstackEvent& event);
 
   // Use a reentrant mutex so that calls to the ForEach... methods can be nested.
   // E.g., one might want to nest ForEachCallstackEvent and ForEachFrameInCallstack.
@@ -104,6 +116,8 @@ class CallstackData {
   absl::flat_hash_map<CallstackID, std::shared_ptr<CallStack>> unique_callstacks_;
   absl::flat_hash_map<int32_t, std::map<uint64_t, orbit_client_protos::CallstackEvent>>
       callstack_events_by_tid_;
+  absl::flat_hash_map<int32_t, TimestampHistogramPyramid> callstack_events_histogram_by_tid_;
+  TimestampHistogramPyramid callstack_events_histogram_;
 
   uint64_t max_time_ = 0;
   uint64_t min_time_ = std::numeric_limits<uint64_t>::max();
@@ -6,6 +6,7 @@
 #define ORBIT_CLIENT_DATA_FUNCTION_UTILS_H_
 
 #include <absl/container/flat_hash_map.h>
+#include <google/protobuf/arena.h>
 
 #include <cstdint>
 #include <memory>
@@ -44,6 +45,10 @@ namespace function_utils {
 [[nodiscard]] std::unique_ptr<orbit_client_protos::FunctionInfo> CreateFunctionInfo(
     const orbit_grpc_protos::SymbolInfo& symbol_info, const std::string& module_path,
     const std::string& module_build_id);
+// Same as above, but allocates the FunctionInfo on `arena`, which owns the result.
+[[nodiscard]] orbit_client_protos::FunctionInfo* CreateFunctionInfo(
+    const orbit_grpc_protos::SymbolInfo& symbol_info, const std::string& module_path,
+    const std::string& module_build_id, google::protobuf::Arena* arena);
 
 [[nodiscard]] const absl::flat_hash_map<std::string, orbit_client_protos::FunctionInfo::OrbitType>&
 GetFunctionNameToOrbitTypeMap();
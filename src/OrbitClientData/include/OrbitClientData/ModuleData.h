@@ -5,10 +5,13 @@
 #ifndef ORBIT_CLIENT_DATA_MODULE_DATA_H_
 #define ORBIT_CLIENT_DATA_MODULE_DATA_H_
 
+#include <google/protobuf/arena.h>
+
 #include <cinttypes>
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -39,6 +42,12 @@ class ModuleData final {
       uint64_t relative_address, bool is_exact) const;
   [[nodiscard]] const orbit_client_protos::FunctionInfo* FindFunctionByElfAddress(
       uint64_t elf_address, bool is_exact) const;
+  // Like FindFunctionByElfAddress with is_exact == false, but returns the position of the function
+  // among the functions of this module ordered by address. Positions change when functions are
+  // added or removed, so they are only meant for caches that are invalidated then.
+  [[nodiscard]] std::optional<size_t> FindFunctionIndexByElfAddress(uint64_t elf_address) const;
+  // Returns nullptr if `index` is out of range.
+  [[nodiscard]] const orbit_client_protos::FunctionInfo* GetFunctionByIndex(size_t index) const;
   void AddSymbols(const orbit_grpc_protos::ModuleSymbols& module_symbols);
   void AddFunctionInfoWithBuildId(const orbit_client_protos::FunctionInfo& function_info,
                                   const std::string& module_build_id);
@@ -47,10 +56,21 @@ class ModuleData final {
   [[nodiscard]] std::vector<orbit_client_protos::FunctionInfo> GetOrbitFunctions() const;
 
  private:
+  // Inserts `function` into the address index. Functions are usually added in address order, in
+  // which case this is an append.
+  void AddFunctionToAddressIndex(orbit_client_protos::FunctionInfo* function);
+  void ClearFunctions();
+
   mutable absl::Mutex mutex_;
   orbit_grpc_protos::ModuleInfo module_info_;
   bool is_loaded_;
-  std::map<uint64_t, std::unique_ptr<orbit_client_protos::FunctionInfo>> functions_;
+  // Owns all FunctionInfos of this module. Pointers to them stay valid until ClearFunctions.
+  google::protobuf::Arena functions_arena_;
+  // FindFunctionByElfAddress is called for every frame of every callstack, so the functions are
+  // indexed by two parallel arrays sorted by address instead of a tree. The addresses are kept
+  // separately to make the binary search cache friendly.
+  std::vector<uint64_t> function_addresses_;
+  std::vector<orbit_client_protos::FunctionInfo*> functions_;
   // TODO(168799822) This is a map of hash to function used for preset loading. Currently presets
   // are based on a hash of the functions pretty name. This should be changed to not use hashes
   // anymore.
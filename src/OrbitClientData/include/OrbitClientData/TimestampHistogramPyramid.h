@@ -0,0 +1,48 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_CLIENT_DATA_TIMESTAMP_HISTOGRAM_PYRAMID_H_
+#define ORBIT_CLIENT_DATA_TIMESTAMP_HISTOGRAM_PYRAMID_H_
+
+#include <absl/container/btree_map.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <optional>
+#include <vector>
+
+// TimestampHistogramPyramid counts timestamps in bins of several power-of-two widths, so that the
+// number of timestamps per bucket of a time range can be computed without visiting each timestamp.
+// This is used to draw the density of samples when there are many more samples than pixels.
+//
+// Added timestamps are buffered and only binned in batches, when the counts are queried or the
+// buffer is full: sorted, consecutive timestamps mostly fall into the same bins, so a batch takes
+// one btree update per bin and level instead of one per timestamp and level.
+class TimestampHistogramPyramid {
+ public:
+  void Add(uint64_t timestamp);
+  void Remove(uint64_t timestamp);
+
+  // Splits [min_timestamp, max_timestamp] into `num_buckets` buckets of equal width and returns the
+  // number of timestamps in each bucket. Counts are computed from the coarsest bins that are at
+  // most a quarter of a bucket wide, and each bin is attributed to the bucket containing its
+  // center, so counts are approximate at bucket boundaries. Returns std::nullopt if even the
+  // finest bins are too wide.
+  [[nodiscard]] std::optional<std::vector<uint32_t>> GetCountsInBuckets(uint64_t min_timestamp,
+                                                                       uint64_t max_timestamp,
+                                                                       size_t num_buckets) const;
+
+ private:
+  void AddPendingTimestampsToBins() const;
+
+  // Bin widths from 2^14 ns (~16us) to 2^32 ns (~4s).
+  static constexpr std::array<uint32_t, 7> kBinWidthLog2ByLevel = {14, 17, 20, 23, 26, 29, 32};
+  static constexpr size_t kMaxPendingTimestamps = 4096;
+  mutable std::vector<uint64_t> pending_timestamps_;
+  mutable std::array<absl::btree_map<uint64_t, uint32_t>, kBinWidthLog2ByLevel.size()>
+      counts_by_level_;
+};
+
+#endif  // ORBIT_CLIENT_DATA_TIMESTAMP_HISTOGRAM_PYRAMID_H_
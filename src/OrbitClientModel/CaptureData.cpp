@@ -19,6 +19,25 @@ using orbit_client_protos::LinuxAddressInfo;
 using orbit_client_protos::ThreadStateSliceInfo;
 using orbit_grpc_protos::InstrumentedFunction;
 
+void CaptureData::AddThreadStateSlice(ThreadStateSliceInfo state_slice) {
+  absl::MutexLock lock{thread_state_slices_mutex_.get()};
+  std::vector<ThreadStateSliceInfo>& tid_thread_state_slices =
+      thread_state_slices_[state_slice.tid()];
+  if (tid_thread_state_slices.empty() ||
+      tid_thread_state_slices.back().begin_timestamp_ns() <= state_slice.begin_timestamp_ns()) {
+    tid_thread_state_slices.emplace_back(std::move(state_slice));
+    return;
+  }
+
+  auto insertion_it =
+      std::upper_bound(tid_thread_state_slices.begin(), tid_thread_state_slices.end(),
+                       state_slice.begin_timestamp_ns(),
+                       [](uint64_t begin_timestamp, const ThreadStateSliceInfo& slice) {
+                         return begin_timestamp < slice.begin_timestamp_ns();
+                       });
+  tid_thread_state_slices.insert(insertion_it, std::move(state_slice));
+}
+
 void CaptureData::ForEachThreadStateSliceIntersectingTimeRange(
     int32_t thread_id, uint64_t min_timestamp, uint64_t max_timestamp,
     const std::function<void(const ThreadStateSliceInfo&)>& action) const {
@@ -186,27 +205,102 @@ const std::string& CaptureData::GetModulePathByAddress(uint64_t absolute_address
   return module_path;
 }
 
-const FunctionInfo* CaptureData::FindFunctionByAddress(uint64_t absolute_address,
-                                                       bool is_exact) const {
+CaptureData::ResolvedAddress CaptureData::ResolveAddress(uint64_t absolute_address) const {
+  uint64_t generation;
+  {
+    absl::ReaderMutexLock lock(resolved_addresses_mutex_.get());
+    generation = resolved_addresses_generation_;
+    auto it = resolved_addresses_.find(absolute_address);
+    if (it != resolved_addresses_.end() && it->second.generation == generation) {
+      std::optional<ResolvedAddress> resolved_address =
+          GetCachedResolvedAddress(absolute_address, it->second);
+      if (resolved_address.has_value()) return resolved_address.value();
+    }
+  }
+
+  ResolvedAddress resolved_address;
   const auto module_or_error = process_.FindModuleByAddress(absolute_address);
-  if (module_or_error.has_error()) return nullptr;
-  const std::string& module_path = module_or_error.value().file_path();
-  const std::string& module_build_id = module_or_error.value().build_id();
-  const uint64_t module_base_address = module_or_error.value().start();
+  if (!module_or_error.has_error()) {
+    resolved_address.module = module_manager_->GetMutableModuleByPathAndBuildId(
+        module_or_error.value().file_path(), module_or_error.value().build_id());
+  }
+  std::optional<size_t> function_index;
+  if (resolved_address.module != nullptr) {
+    resolved_address.module_base_address = module_or_error.value().start();
+    const uint64_t elf_address = absolute_address - resolved_address.module_base_address +
+                                 resolved_address.module->load_bias();
+    function_index = resolved_address.module->FindFunctionIndexByElfAddress(elf_address);
+    if (function_index.has_value()) {
+      resolved_address.function =
+          resolved_address.module->GetFunctionByIndex(function_index.value());
+    }
+    if (resolved_address.function != nullptr) {
+      resolved_address.offset_in_function = elf_address - resolved_address.function->address();
+    }
+  }
 
-  const ModuleData* module =
-      module_manager_->GetModuleByPathAndBuildId(module_path, module_build_id);
-  if (module == nullptr) return nullptr;
+  absl::MutexLock lock(resolved_addresses_mutex_.get());
+  // Modules or functions might have been freed or changed while resolving without the lock.
+  if (generation != resolved_addresses_generation_) return resolved_address;
+
+  CachedResolvedAddress cached;
+  cached.generation = generation;
+  cached.module_base_address = resolved_address.module_base_address;
+  cached.offset_in_function = resolved_address.offset_in_function;
+  if (resolved_address.module != nullptr) {
+    auto [it, inserted] = resolved_module_indices_.try_emplace(
+        resolved_address.module, static_cast<uint32_t>(resolved_modules_.size()));
+    if (inserted) resolved_modules_.push_back(resolved_address.module);
+    cached.module_index = it->second;
+  }
+  if (resolved_address.function != nullptr) {
+    cached.function_index = static_cast<uint32_t>(function_index.value());
+  }
+  resolved_addresses_.insert_or_assign(absolute_address, cached);
+  return resolved_address;
+}
+
+std::optional<CaptureData::ResolvedAddress> CaptureData::GetCachedResolvedAddress(
+    uint64_t absolute_address, const CachedResolvedAddress& cached) const {
+  ResolvedAddress resolved_address;
+  resolved_address.module_base_address = cached.module_base_address;
+  resolved_address.offset_in_function = cached.offset_in_function;
+  if (cached.module_index == CachedResolvedAddress::kNoModule) return resolved_address;
+
+  resolved_address.module = resolved_modules_[cached.module_index];
+  if (cached.function_index == CachedResolvedAddress::kNoFunction) return resolved_address;
+
+  // Positions of functions change when symbols are loaded, which the caller of
+  // InvalidateResolvedAddresses might not have reported yet.
+  resolved_address.function = resolved_address.module->GetFunctionByIndex(cached.function_index);
+  const uint64_t elf_address =
+      absolute_address - cached.module_base_address + resolved_address.module->load_bias();
+  if (resolved_address.function == nullptr ||
+      resolved_address.function->address() + cached.offset_in_function != elf_address) {
+    return std::nullopt;
+  }
+  return resolved_address;
+}
+
+void CaptureData::InvalidateResolvedAddresses() {
+  absl::MutexLock lock(resolved_addresses_mutex_.get());
+  ++resolved_addresses_generation_;
+  resolved_modules_.clear();
+  resolved_module_indices_.clear();
+}
+
+const FunctionInfo* CaptureData::FindFunctionByAddress(uint64_t absolute_address,
+                                                       bool is_exact) const {
+  const ResolvedAddress resolved_address = ResolveAddress(absolute_address);
+  const FunctionInfo* function = resolved_address.function;
+  if (function == nullptr || !is_exact) return function;
 
-  const uint64_t relative_address = absolute_address - module_base_address;
-  return module->FindFunctionByRelativeAddress(relative_address, is_exact);
+  // The function containing the address is the exact match if it starts at the address.
+  return resolved_address.offset_in_function == 0 ? function : nullptr;
 }
 
 [[nodiscard]] ModuleData* CaptureData::FindModuleByAddress(uint64_t absolute_address) const {
-  const auto result = process_.FindModuleByAddress(absolute_address);
-  if (result.has_error()) return nullptr;
-  return module_manager_->GetMutableModuleByPathAndBuildId(result.value().file_path(),
-                                                           result.value().build_id());
+  return ResolveAddress(absolute_address).module;
 }
 
 uint64_t CaptureData::GetAbsoluteAddress(const orbit_client_protos::FunctionInfo& function) const {
@@ -0,0 +1,169 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "OrbitClientData/ModuleData.h"
+#include "OrbitClientData/ModuleManager.h"
+#include "OrbitClientData/ProcessData.h"
+#include "OrbitClientModel/CaptureData.h"
+#include "capture_data.pb.h"
+#include "module.pb.h"
+#include "symbol.pb.h"
+
+using orbit_client_protos::FunctionInfo;
+using orbit_client_protos::ThreadStateSliceInfo;
+using orbit_grpc_protos::ModuleInfo;
+using orbit_grpc_protos::ModuleSymbols;
+using orbit_grpc_protos::SymbolInfo;
+using ::testing::ElementsAre;
+
+namespace {
+
+ThreadStateSliceInfo MakeThreadStateSlice(int32_t tid, uint64_t begin_timestamp_ns,
+                                          uint64_t end_timestamp_ns) {
+  ThreadStateSliceInfo slice;
+  slice.set_tid(tid);
+  slice.set_thread_state(ThreadStateSliceInfo::kRunning);
+  slice.set_begin_timestamp_ns(begin_timestamp_ns);
+  slice.set_end_timestamp_ns(end_timestamp_ns);
+  return slice;
+}
+
+std::vector<uint64_t> GetBeginTimestampsInRange(const CaptureData& capture_data, int32_t tid,
+                                                uint64_t min_timestamp, uint64_t max_timestamp) {
+  std::vector<uint64_t> begin_timestamps;
+  capture_data.ForEachThreadStateSliceIntersectingTimeRange(
+      tid, min_timestamp, max_timestamp, [&](const ThreadStateSliceInfo& slice) {
+        begin_timestamps.push_back(slice.begin_timestamp_ns());
+      });
+  return begin_timestamps;
+}
+
+}  // namespace
+
+TEST(CaptureData, ThreadStateSlicesAreKeptSorted) {
+  orbit_client_data::ModuleManager module_manager;
+  CaptureData capture_data{ProcessData{}, &module_manager, {}, {}, {}};
+
+  capture_data.AddThreadStateSlice(MakeThreadStateSlice(42, 100, 200));
+  capture_data.AddThreadStateSlice(MakeThreadStateSlice(42, 200, 300));
+  capture_data.AddThreadStateSlice(MakeThreadStateSlice(43, 150, 250));
+  capture_data.AddThreadStateSlice(MakeThreadStateSlice(42, 400, 500));
+  // Out of order.
+  capture_data.AddThreadStateSlice(MakeThreadStateSlice(42, 300, 400));
+  capture_data.AddThreadStateSlice(MakeThreadStateSlice(42, 0, 100));
+
+  EXPECT_TRUE(capture_data.HasThreadStatesForThread(42));
+  EXPECT_FALSE(capture_data.HasThreadStatesForThread(44));
+
+  EXPECT_THAT(GetBeginTimestampsInRange(capture_data, 42, 0, 1000),
+              ElementsAre(0, 100, 200, 300, 400));
+  EXPECT_THAT(GetBeginTimestampsInRange(capture_data, 42, 250, 350), ElementsAre(200, 300));
+  EXPECT_THAT(GetBeginTimestampsInRange(capture_data, 43, 0, 1000), ElementsAre(150));
+  EXPECT_THAT(GetBeginTimestampsInRange(capture_data, 44, 0, 1000), ElementsAre());
+}
+
+TEST(CaptureData, ResolvedAddressesAreInvalidatedWhenSymbolsAreLoaded) {
+  constexpr const char* kModulePath = "/path/to/module";
+  constexpr const char* kBuildId = "build_id";
+  constexpr uint64_t kModuleStart = 0x10000;
+  constexpr uint64_t kLoadBias = 0x1000;
+
+  ModuleInfo module_info;
+  module_info.set_name("module");
+  module_info.set_file_path(kModulePath);
+  module_info.set_build_id(kBuildId);
+  module_info.set_address_start(kModuleStart);
+  module_info.set_address_end(kModuleStart + 0x10000);
+  module_info.set_load_bias(kLoadBias);
+
+  orbit_client_data::ModuleManager module_manager;
+  module_manager.AddOrUpdateModules({module_info});
+  ProcessData process;
+  process.UpdateModuleInfos({module_info});
+  CaptureData capture_data{std::move(process), &module_manager, {}, {}, {}};
+
+  const uint64_t function_absolute_address = kModuleStart + 0x100;
+  EXPECT_EQ(capture_data.FindModuleByAddress(function_absolute_address),
+            module_manager.GetModuleByPathAndBuildId(kModulePath, kBuildId));
+  EXPECT_EQ(capture_data.FindFunctionByAddress(function_absolute_address, false), nullptr);
+  EXPECT_EQ(capture_data.GetFunctionNameByAddress(function_absolute_address),
+            CaptureData::kUnknownFunctionOrModuleName);
+  EXPECT_EQ(capture_data.GetModulePathByAddress(function_absolute_address), kModulePath);
+  EXPECT_EQ(capture_data.FindModuleByAddress(kModuleStart - 1), nullptr);
+
+  ModuleSymbols module_symbols;
+  SymbolInfo* symbol_info = module_symbols.add_symbol_infos();
+  symbol_info->set_name("foo");
+  symbol_info->set_demangled_name("foo()");
+  symbol_info->set_address(kLoadBias + 0x100);
+  symbol_info->set_size(0x10);
+  module_manager.GetMutableModuleByPathAndBuildId(kModulePath, kBuildId)
+      ->AddSymbols(module_symbols);
+  capture_data.InvalidateResolvedAddresses();
+
+  const FunctionInfo* function =
+      capture_data.FindFunctionByAddress(function_absolute_address + 0x8, false);
+  ASSERT_NE(function, nullptr);
+  EXPECT_EQ(function->pretty_name(), "foo()");
+  EXPECT_EQ(capture_data.FindFunctionByAddress(function_absolute_address + 0x8, true), nullptr);
+  EXPECT_EQ(capture_data.FindFunctionByAddress(function_absolute_address, true), function);
+  EXPECT_EQ(capture_data.GetFunctionNameByAddress(function_absolute_address), "foo()");
+  EXPECT_EQ(capture_data.FindFunctionByAddress(function_absolute_address + 0x20, false), nullptr);
+}
+
+TEST(CaptureData, ResolvedAddressesAreVerifiedWhenFunctionsMoved) {
+  constexpr const char* kModulePath = "/path/to/module";
+  constexpr const char* kBuildId = "build_id";
+  constexpr uint64_t kModuleStart = 0x10000;
+  constexpr uint64_t kLoadBias = 0x1000;
+
+  ModuleInfo module_info;
+  module_info.set_name("module");
+  module_info.set_file_path(kModulePath);
+  module_info.set_build_id(kBuildId);
+  module_info.set_address_start(kModuleStart);
+  module_info.set_address_end(kModuleStart + 0x10000);
+  module_info.set_load_bias(kLoadBias);
+
+  orbit_client_data::ModuleManager module_manager;
+  module_manager.AddOrUpdateModules({module_info});
+  ProcessData process;
+  process.UpdateModuleInfos({module_info});
+  CaptureData capture_data{std::move(process), &module_manager, {}, {}, {}};
+  ModuleData* module = module_manager.GetMutableModuleByPathAndBuildId(kModulePath, kBuildId);
+
+  FunctionInfo bar;
+  bar.set_pretty_name("bar()");
+  bar.set_address(kLoadBias + 0x200);
+  bar.set_size(0x10);
+  module->AddFunctionInfoWithBuildId(bar, kBuildId);
+
+  const uint64_t bar_absolute_address = kModuleStart + 0x200;
+  const FunctionInfo* function = capture_data.FindFunctionByAddress(bar_absolute_address, true);
+  ASSERT_NE(function, nullptr);
+  EXPECT_EQ(function->pretty_name(), "bar()");
+
+  // Adding a function before bar() moves it to the next position in the module. Even before the
+  // resolved addresses are invalidated, the cached position must not resolve to the new function.
+  FunctionInfo foo;
+  foo.set_pretty_name("foo()");
+  foo.set_address(kLoadBias + 0x100);
+  foo.set_size(0x10);
+  module->AddFunctionInfoWithBuildId(foo, kBuildId);
+
+  function = capture_data.FindFunctionByAddress(bar_absolute_address, true);
+  ASSERT_NE(function, nullptr);
+  EXPECT_EQ(function->pretty_name(), "bar()");
+  EXPECT_EQ(capture_data.GetFunctionNameByAddress(kModuleStart + 0x108), "foo()");
+
+  capture_data.InvalidateResolvedAddresses();
+  EXPECT_EQ(capture_data.GetFunctionNameByAddress(bar_absolute_address + 0x4), "bar()");
+  EXPECT_EQ(capture_data.FindModuleByAddress(bar_absolute_address), module);
+}
@@ -13,6 +13,7 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
@@ -104,6 +105,10 @@ class CaptureData {
   [[nodiscard]] ModuleData* FindModuleByAddress(uint64_t absolute_address) const;
   [[nodiscard]] uint64_t GetAbsoluteAddress(
       const orbit_client_protos::FunctionInfo& function) const;
+  // The lookups above resolve every absolute address only once and cache the resulting module and
+  // function. This has to be called before functions or modules of this capture are freed, and
+  // again after functions have been added to or removed from a module, e.g., after loading symbols.
+  void InvalidateResolvedAddresses();
 
   static const std::string kUnknownFunctionOrModuleName;
 
@@ -132,10 +137,9 @@ class CaptureData {
     return thread_state_slices_.count(tid) > 0;
   }
 
-  void AddThreadStateSlice(orbit_client_protos::ThreadStateSliceInfo state_slice) {
-    absl::MutexLock lock{thread_state_slices_mutex_.get()};
-    thread_state_slices_[state_slice.tid()].emplace_back(std::move(state_slice));
-  }
+  // Slices of the same thread are kept sorted by timestamp. Slices usually arrive in order and are
+  // simply appended, out-of-order slices are inserted at their position.
+  void AddThreadStateSlice(orbit_client_protos::ThreadStateSliceInfo state_slice);
 
   // Allows the caller to iterate `action` over all the thread state slices of the specified thread
   // in the time range while holding for the whole time the internal mutex, acquired only once.
@@ -226,6 +230,37 @@ class CaptureData {
   }
 
  private:
+  struct ResolvedAddress {
+    // nullptr if the address does not belong to a module known to the ModuleManager.
+    ModuleData* module = nullptr;
+    uint64_t module_base_address = 0;
+    // The function containing the address, nullptr if the module has no symbols for it.
+    const orbit_client_protos::FunctionInfo* function = nullptr;
+    // The distance of the address from the start of `function`.
+    uint64_t offset_in_function = 0;
+  };
+  [[nodiscard]] ResolvedAddress ResolveAddress(uint64_t absolute_address) const;
+
+  // Entries of the cache of ResolveAddress. They hold positions instead of pointers and are only
+  // used while their generation is current, so an entry never refers to freed modules or
+  // functions.
+  struct CachedResolvedAddress {
+    static constexpr uint32_t kNoModule = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t kNoFunction = std::numeric_limits<uint32_t>::max();
+    uint64_t generation = 0;
+    // Position in resolved_modules_.
+    uint32_t module_index = kNoModule;
+    // Position of the function in the functions of the module, see ModuleData::GetFunctionByIndex.
+    uint32_t function_index = kNoFunction;
+    uint64_t module_base_address = 0;
+    uint64_t offset_in_function = 0;
+  };
+  // Returns std::nullopt if the function at the cached position is not the one containing the
+  // address anymore.
+  [[nodiscard]] std::optional<ResolvedAddress> GetCachedResolvedAddress(
+      uint64_t absolute_address, const CachedResolvedAddress& cached) const
+      ABSL_SHARED_LOCKS_REQUIRED(*resolved_addresses_mutex_);
+
   ProcessData process_;
   orbit_client_data::ModuleManager* module_manager_;
   absl::flat_hash_map<uint64_t, orbit_grpc_protos::InstrumentedFunction> instrumented_functions_;
@@ -251,6 +286,19 @@ class CaptureData {
       thread_state_slices_;  // For each thread, assume sorted by timestamp and not overlapping.
   mutable std::unique_ptr<absl::Mutex> thread_state_slices_mutex_ = std::make_unique<absl::Mutex>();
 
+  // Call tree building, the sampling report and tooltips resolve the same addresses over and over
+  // again, so the results of walking the module map and the module's functions are cached.
+  // InvalidateResolvedAddresses starts a new generation: entries of older generations are ignored
+  // and overwritten, and an address resolved concurrently against the old modules is not cached.
+  mutable std::unique_ptr<absl::Mutex> resolved_addresses_mutex_ = std::make_unique<absl::Mutex>();
+  mutable absl::flat_hash_map<uint64_t, CachedResolvedAddress> resolved_addresses_
+      ABSL_GUARDED_BY(*resolved_addresses_mutex_);
+  // The modules referred to by the entries of the current generation.
+  mutable std::vector<ModuleData*> resolved_modules_ ABSL_GUARDED_BY(*resolved_addresses_mutex_);
+  mutable absl::flat_hash_map<const ModuleData*, uint32_t> resolved_module_indices_
+      ABSL_GUARDED_BY(*resolved_addresses_mutex_);
+  uint64_t resolved_addresses_generation_ ABSL_GUARDED_BY(*resolved_addresses_mutex_) = 0;
+
   std::chrono::system_clock::time_point capture_start_time_ = std::chrono::system_clock::now();
 
   absl::flat_hash_set<uint64_t> frame_track_function_ids_;
@@ -0,0 +1,377 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SymbolCacheFile.h"
+
+#include <absl/strings/str_format.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "CoreUtils.h"
+#include "OrbitBase/File.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/SafeStrerror.h"
+#include "OrbitBase/ThreadUtils.h"
+#include "OrbitBase/UniqueResource.h"
+
+#if defined(__linux)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using orbit_grpc_protos::ModuleSymbols;
+using orbit_grpc_protos::SymbolInfo;
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'R', 'B', 'S', 'Y', 'M', 'C', '\0'};
+// Bump this whenever the layout of the file changes, so that stale cache files are regenerated.
+constexpr uint32_t kVersion = 1;
+
+// String sizes are stored as 32-bit integers.
+ErrorMessageOr<uint32_t> GetStringSize(std::string_view str, std::string_view description) {
+  if (str.size() > std::numeric_limits<uint32_t>::max()) {
+    return ErrorMessage{
+        absl::StrFormat("The %s is too long for a symbol cache file: %u bytes", description,
+                        str.size())};
+  }
+  return static_cast<uint32_t>(str.size());
+}
+
+}  // namespace
+
+// All offsets are relative to the beginning of the file, except for name offsets, which are
+// relative to the beginning of the string blob. Integers are stored in host byte order, as cache
+// files never leave the machine they were created on.
+struct SymbolCacheFile::Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t build_id_size;
+  uint64_t build_id_offset;
+  uint64_t symbols_file_path_offset;
+  uint32_t symbols_file_path_size;
+  uint32_t reserved;
+  uint64_t load_bias;
+  uint64_t num_symbols;
+  uint64_t symbol_entries_offset;
+  uint64_t hash_entries_offset;
+  uint64_t string_blob_offset;
+  uint64_t string_blob_size;
+};
+
+struct SymbolCacheFile::SymbolEntry {
+  uint64_t address;
+  uint64_t size;
+  uint64_t name_offset;
+  uint64_t demangled_name_offset;
+  uint32_t name_size;
+  uint32_t demangled_name_size;
+};
+
+struct SymbolCacheFile::HashEntry {
+  uint64_t name_hash;
+  uint64_t symbol_index;
+};
+
+SymbolCacheFile::~SymbolCacheFile() {
+#if defined(__linux)
+  if (is_mapped_) munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+ErrorMessageOr<void> SymbolCacheFile::Write(const std::filesystem::path& file_path,
+                                            std::string_view build_id,
+                                            const ModuleSymbols& module_symbols) {
+  std::vector<const SymbolInfo*> sorted_symbols;
+  sorted_symbols.reserve(module_symbols.symbol_infos_size());
+  for (const SymbolInfo& symbol_info : module_symbols.symbol_infos()) {
+    sorted_symbols.push_back(&symbol_info);
+  }
+  std::stable_sort(sorted_symbols.begin(), sorted_symbols.end(),
+                   [](const SymbolInfo* lhs, const SymbolInfo* rhs) {
+                     return lhs->address() < rhs->address();
+                   });
+
+  std::string string_blob;
+  auto append_string = [&string_blob](std::string_view str) {
+    uint64_t offset = string_blob.size();
+    string_blob.append(str);
+    return offset;
+  };
+
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.build_id_offset = append_string(build_id);
+  OUTCOME_TRY(build_id_size, GetStringSize(build_id, "build id"));
+  header.build_id_size = build_id_size;
+  header.symbols_file_path_offset = append_string(module_symbols.symbols_file_path());
+  OUTCOME_TRY(symbols_file_path_size,
+              GetStringSize(module_symbols.symbols_file_path(), "symbols file path"));
+  header.symbols_file_path_size = symbols_file_path_size;
+  header.load_bias = module_symbols.load_bias();
+  header.num_symbols = sorted_symbols.size();
+
+  std::vector<SymbolEntry> symbol_entries;
+  symbol_entries.reserve(sorted_symbols.size());
+  std::vector<HashEntry> hash_entries;
+  hash_entries.reserve(sorted_symbols.size());
+  for (const SymbolInfo* symbol_info : sorted_symbols) {
+    SymbolEntry entry{};
+    entry.address = symbol_info->address();
+    entry.size = symbol_info->size();
+    entry.name_offset = append_string(symbol_info->name());
+    OUTCOME_TRY(name_size, GetStringSize(symbol_info->name(), "symbol name"));
+    entry.name_size = name_size;
+    // C symbols are not mangled, there is no need to store their names twice.
+    entry.demangled_name_offset = symbol_info->demangled_name() == symbol_info->name()
+                                      ? entry.name_offset
+                                      : append_string(symbol_info->demangled_name());
+    OUTCOME_TRY(demangled_name_size,
+                GetStringSize(symbol_info->demangled_name(), "demangled symbol name"));
+    entry.demangled_name_size = demangled_name_size;
+    hash_entries.push_back({StringHash(symbol_info->name()), symbol_entries.size()});
+    symbol_entries.push_back(entry);
+  }
+  std::sort(hash_entries.begin(), hash_entries.end(),
+            [](const HashEntry& lhs, const HashEntry& rhs) {
+              return std::tie(lhs.name_hash, lhs.symbol_index) <
+                     std::tie(rhs.name_hash, rhs.symbol_index);
+            });
+
+  header.symbol_entries_offset = sizeof(Header);
+  header.hash_entries_offset =
+      header.symbol_entries_offset + symbol_entries.size() * sizeof(SymbolEntry);
+  header.string_blob_offset = header.hash_entries_offset + hash_entries.size() * sizeof(HashEntry);
+  header.string_blob_size = string_blob.size();
+
+  const std::filesystem::path temporary_file_path =
+      absl::StrFormat("%s.%u.%u.tmp", file_path.string(), orbit_base::GetCurrentProcessId(),
+                      orbit_base::GetCurrentThreadId());
+  // Removes the temporary file on every error path, it is released once it has been renamed.
+  orbit_base::unique_resource temporary_file{
+      temporary_file_path, [](const std::filesystem::path& path) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+      }};
+  {
+    OUTCOME_TRY(fd, orbit_base::OpenFileForWriting(temporary_file_path));
+    auto write = [&fd, &temporary_file_path](const void* data,
+                                             size_t size) -> ErrorMessageOr<void> {
+      auto result =
+          orbit_base::WriteFully(fd, std::string_view{static_cast<const char*>(data), size});
+      if (result.has_error()) {
+        return ErrorMessage{absl::StrFormat("Unable to write to \"%s\": %s",
+                                            temporary_file_path.string(),
+                                            result.error().message())};
+      }
+      return outcome::success();
+    };
+    OUTCOME_TRY(write(&header, sizeof(header)));
+    OUTCOME_TRY(write(symbol_entries.data(), symbol_entries.size() * sizeof(SymbolEntry)));
+    OUTCOME_TRY(write(hash_entries.data(), hash_entries.size() * sizeof(HashEntry)));
+    OUTCOME_TRY(write(string_blob.data(), string_blob.size()));
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_file_path, file_path, error);
+  if (error) {
+    return ErrorMessage{absl::StrFormat("Unable to rename \"%s\" to \"%s\": %s",
+                                        temporary_file_path.string(), file_path.string(),
+                                        error.message())};
+  }
+  temporary_file.release();
+  return outcome::success();
+}
+
+ErrorMessageOr<std::unique_ptr<SymbolCacheFile>> SymbolCacheFile::Open(
+    const std::filesystem::path& file_path, std::string_view build_id) {
+  OUTCOME_TRY(fd, orbit_base::OpenFileForReading(file_path));
+
+  std::unique_ptr<SymbolCacheFile> file{new SymbolCacheFile()};
+#if defined(__linux)
+  struct stat file_stat {};
+  if (fstat(fd.get(), &file_stat) != 0) {
+    return ErrorMessage{absl::StrFormat("Unable to stat \"%s\": %s", file_path.string(),
+                                        SafeStrerror(errno))};
+  }
+  file->size_ = file_stat.st_size;
+  if (file->size_ >= sizeof(Header)) {
+    void* data = mmap(nullptr, file->size_, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+    if (data == MAP_FAILED) {
+      return ErrorMessage{absl::StrFormat("Unable to map \"%s\": %s", file_path.string(),
+                                          SafeStrerror(errno))};
+    }
+    file->data_ = static_cast<const char*>(data);
+    file->is_mapped_ = true;
+  }
+#else
+  std::error_code error;
+  file->size_ = std::filesystem::file_size(file_path, error);
+  if (error) {
+    return ErrorMessage{absl::StrFormat("Unable to get size of \"%s\": %s", file_path.string(),
+                                        error.message())};
+  }
+  if (file->size_ >= sizeof(Header)) {
+    file->buffer_ = std::make_unique<char[]>(file->size_);
+    OUTCOME_TRY(bytes_read, orbit_base::ReadFully(fd, file->buffer_.get(), file->size_));
+    if (bytes_read != file->size_) {
+      return ErrorMessage{absl::StrFormat("Unable to read \"%s\": unexpected end of file",
+                                          file_path.string())};
+    }
+    file->data_ = file->buffer_.get();
+  }
+#endif
+
+  auto init_result = file->Init(build_id);
+  if (init_result.has_error()) {
+    return ErrorMessage{absl::StrFormat("Invalid symbol cache file \"%s\": %s", file_path.string(),
+                                        init_result.error().message())};
+  }
+  return file;
+}
+
+ErrorMessageOr<void> SymbolCacheFile::Init(std::string_view build_id) {
+  // The tables are accessed in place, so every table has to start at an 8-byte boundary.
+  static_assert(std::is_trivially_copyable_v<Header>);
+  static_assert(sizeof(Header) % alignof(uint64_t) == 0);
+  static_assert(sizeof(SymbolEntry) % alignof(uint64_t) == 0);
+  static_assert(sizeof(HashEntry) % alignof(uint64_t) == 0);
+
+  if (data_ == nullptr) return ErrorMessage{"File is too small"};
+
+  const Header& file_header = header();
+  if (std::memcmp(file_header.magic, kMagic, sizeof(kMagic)) != 0) {
+    return ErrorMessage{"Wrong magic number"};
+  }
+  if (file_header.version != kVersion) {
+    return ErrorMessage{
+        absl::StrFormat("Unsupported version %u (expected %u)", file_header.version, kVersion)};
+  }
+
+  // The tables must directly follow each other and the blob must end at the end of the file.
+  // Checking the number of symbols by division avoids overflows for corrupted counts.
+  const uint64_t num_symbols = file_header.num_symbols;
+  if (file_header.symbol_entries_offset != sizeof(Header) ||
+      (size_ - sizeof(Header)) / (sizeof(SymbolEntry) + sizeof(HashEntry)) < num_symbols ||
+      file_header.hash_entries_offset !=
+          file_header.symbol_entries_offset + num_symbols * sizeof(SymbolEntry) ||
+      file_header.string_blob_offset !=
+          file_header.hash_entries_offset + num_symbols * sizeof(HashEntry) ||
+      file_header.string_blob_offset > size_ ||
+      file_header.string_blob_size != size_ - file_header.string_blob_offset) {
+    return ErrorMessage{"Table sizes do not match the file size"};
+  }
+
+  auto is_in_blob = [this](uint64_t offset, uint32_t size) {
+    return offset <= header().string_blob_size && size <= header().string_blob_size - offset;
+  };
+  if (!is_in_blob(file_header.build_id_offset, file_header.build_id_size) ||
+      !is_in_blob(file_header.symbols_file_path_offset, file_header.symbols_file_path_size)) {
+    return ErrorMessage{"String offset out of range"};
+  }
+  for (size_t i = 0; i < num_symbols; ++i) {
+    const SymbolEntry& entry = symbol_entries()[i];
+    if (!is_in_blob(entry.name_offset, entry.name_size) ||
+        !is_in_blob(entry.demangled_name_offset, entry.demangled_name_size)) {
+      return ErrorMessage{"String offset out of range"};
+    }
+    if (hash_entries()[i].symbol_index >= num_symbols) {
+      return ErrorMessage{"Symbol index out of range"};
+    }
+  }
+
+  if (GetBuildId() != build_id) {
+    return ErrorMessage{
+        absl::StrFormat("Build id does not match: \"%s\" != \"%s\"", GetBuildId(), build_id)};
+  }
+  return outcome::success();
+}
+
+const SymbolCacheFile::Header& SymbolCacheFile::header() const {
+  return *reinterpret_cast<const Header*>(data_);
+}
+
+const SymbolCacheFile::SymbolEntry* SymbolCacheFile::symbol_entries() const {
+  return reinterpret_cast<const SymbolEntry*>(data_ + header().symbol_entries_offset);
+}
+
+const SymbolCacheFile::HashEntry* SymbolCacheFile::hash_entries() const {
+  return reinterpret_cast<const HashEntry*>(data_ + header().hash_entries_offset);
+}
+
+std::string_view SymbolCacheFile::GetString(uint64_t offset, uint32_t size) const {
+  return std::string_view{data_ + header().string_blob_offset + offset, size};
+}
+
+std::string_view SymbolCacheFile::GetBuildId() const {
+  return GetString(header().build_id_offset, header().build_id_size);
+}
+
+std::string_view SymbolCacheFile::GetSymbolsFilePath() const {
+  return GetString(header().symbols_file_path_offset, header().symbols_file_path_size);
+}
+
+uint64_t SymbolCacheFile::GetLoadBias() const { return header().load_bias; }
+
+size_t SymbolCacheFile::GetNumSymbols() const { return header().num_symbols; }
+
+SymbolCacheFile::Symbol SymbolCacheFile::GetSymbol(size_t index) const {
+  CHECK(index < GetNumSymbols());
+  const SymbolEntry& entry = symbol_entries()[index];
+  return {entry.address, entry.size, GetString(entry.name_offset, entry.name_size),
+          GetString(entry.demangled_name_offset, entry.demangled_name_size)};
+}
+
+std::optional<SymbolCacheFile::Symbol> SymbolCacheFile::FindSymbolByAddress(
+    uint64_t address) const {
+  const SymbolEntry* begin = symbol_entries();
+  const SymbolEntry* end = begin + GetNumSymbols();
+  const SymbolEntry* it = std::upper_bound(
+      begin, end, address,
+      [](uint64_t value, const SymbolEntry& entry) { return value < entry.address; });
+  if (it == begin) return std::nullopt;
+  --it;
+  if (address - it->address >= it->size) return std::nullopt;
+  return GetSymbol(it - begin);
+}
+
+std::optional<SymbolCacheFile::Symbol> SymbolCacheFile::FindSymbolByName(
+    std::string_view name) const {
+  const uint64_t hash = StringHash(name);
+  const HashEntry* begin = hash_entries();
+  const HashEntry* end = begin + GetNumSymbols();
+  const HashEntry* it =
+      std::lower_bound(begin, end, hash, [](const HashEntry& entry, uint64_t value) {
+        return entry.name_hash < value;
+      });
+  for (; it != end && it->name_hash == hash; ++it) {
+    Symbol symbol = GetSymbol(it->symbol_index);
+    if (symbol.name == name) return symbol;
+  }
+  return std::nullopt;
+}
+
+ModuleSymbols SymbolCacheFile::ToModuleSymbols() const {
+  ModuleSymbols module_symbols;
+  module_symbols.set_load_bias(GetLoadBias());
+  module_symbols.set_symbols_file_path(std::string{GetSymbolsFilePath()});
+  module_symbols.mutable_symbol_infos()->Reserve(GetNumSymbols());
+  for (size_t i = 0; i < GetNumSymbols(); ++i) {
+    Symbol symbol = GetSymbol(i);
+    SymbolInfo* symbol_info = module_symbols.add_symbol_infos();
+    symbol_info->set_name(std::string{symbol.name});
+    symbol_info->set_demangled_name(std::string{symbol.demangled_name});
+    symbol_info->set_address(symbol.address);
+    symbol_info->set_size(symbol.size);
+  }
+  return module_symbols;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_CORE_SYMBOL_CACHE_FILE_H_
+#define ORBIT_CORE_SYMBOL_CACHE_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "OrbitBase/Result.h"
+#include "symbol.pb.h"
+
+// SymbolCacheFile is a compact on-disk representation of orbit_grpc_protos::ModuleSymbols that can
+// be memory-mapped and used without parsing. The file consists of a fixed-size header, a table of
+// symbols sorted by address, a table of name hashes sorted by hash, and a blob holding the mangled
+// and demangled names. Opening a file only validates the offsets; names are served as string_views
+// pointing into the mapping.
+class SymbolCacheFile {
+ public:
+  struct Symbol {
+    uint64_t address;
+    uint64_t size;
+    std::string_view name;
+    std::string_view demangled_name;
+  };
+
+  ~SymbolCacheFile();
+  SymbolCacheFile(const SymbolCacheFile&) = delete;
+  SymbolCacheFile& operator=(const SymbolCacheFile&) = delete;
+
+  // Writes `module_symbols` to `file_path`. The file is written under a temporary name first and
+  // then renamed, so that concurrent readers never observe a partially written file.
+  [[nodiscard]] static ErrorMessageOr<void> Write(
+      const std::filesystem::path& file_path, std::string_view build_id,
+      const orbit_grpc_protos::ModuleSymbols& module_symbols);
+
+  // Maps `file_path` into memory. Fails if the file is malformed, was written by a different
+  // version of the format, or does not belong to `build_id`.
+  [[nodiscard]] static ErrorMessageOr<std::unique_ptr<SymbolCacheFile>> Open(
+      const std::filesystem::path& file_path, std::string_view build_id);
+
+  [[nodiscard]] std::string_view GetBuildId() const;
+  [[nodiscard]] std::string_view GetSymbolsFilePath() const;
+  [[nodiscard]] uint64_t GetLoadBias() const;
+
+  [[nodiscard]] size_t GetNumSymbols() const;
+  // Symbols are ordered by address.
+  [[nodiscard]] Symbol GetSymbol(size_t index) const;
+  // Returns the symbol whose range [address, address + size) contains `address`.
+  [[nodiscard]] std::optional<Symbol> FindSymbolByAddress(uint64_t address) const;
+  // Returns the symbol with the mangled name `name`.
+  [[nodiscard]] std::optional<Symbol> FindSymbolByName(std::string_view name) const;
+
+  [[nodiscard]] orbit_grpc_protos::ModuleSymbols ToModuleSymbols() const;
+
+ private:
+  struct Header;
+  struct SymbolEntry;
+  struct HashEntry;
+
+  SymbolCacheFile() = default;
+  [[nodiscard]] ErrorMessageOr<void> Init(std::string_view build_id);
+
+  [[nodiscard]] const Header& header() const;
+  [[nodiscard]] const SymbolEntry* symbol_entries() const;
+  [[nodiscard]] const HashEntry* hash_entries() const;
+  [[nodiscard]] std::string_view GetString(uint64_t offset, uint32_t size) const;
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool is_mapped_ = false;
+  // Holds the file content on platforms where it cannot be memory-mapped.
+  std::unique_ptr<char[]> buffer_;
+};
+
+#endif  // ORBIT_CORE_SYMBOL_CACHE_FILE_H_
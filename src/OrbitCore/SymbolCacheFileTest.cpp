@@ -0,0 +1,199 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "OrbitBase/Result.h"
+#include "OrbitBase/TemporaryFile.h"
+#include "OrbitBase/WriteStringToFile.h"
+#include "SymbolCacheFile.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "symbol.pb.h"
+
+using orbit_grpc_protos::ModuleSymbols;
+using orbit_grpc_protos::SymbolInfo;
+
+namespace {
+
+constexpr const char* kBuildId = "b5413574bbacec6eacb3b89b1012d0e2cd92ec6b";
+
+class SymbolCacheFileTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    // Write to a unique path, so that concurrent runs of the test don't overwrite each other.
+    auto temporary_file_or_error = orbit_base::TemporaryFile::Create();
+    ASSERT_FALSE(temporary_file_or_error.has_error()) << temporary_file_or_error.error().message();
+    temporary_file_ = std::move(temporary_file_or_error.value());
+    file_path_ = temporary_file_->file_path();
+
+    module_symbols_.set_load_bias(0x400000);
+    module_symbols_.set_symbols_file_path("/path/to/symbols.debug");
+    AddSymbol("_Z3foov", "foo()", 0x2000, 0x20);
+    AddSymbol("main", "main", 0x1000, 0x100);
+    AddSymbol("_Z3barv", "bar()", 0x3000, 0x10);
+  }
+
+
+  void AddSymbol(const std::string& name, const std::string& demangled_name, uint64_t address,
+                 uint64_t size) {
+    SymbolInfo* symbol_info = module_symbols_.add_symbol_infos();
+    symbol_info->set_name(name);
+    symbol_info->set_demangled_name(demangled_name);
+    symbol_info->set_address(address);
+    symbol_info->set_size(size);
+  }
+
+  std::optional<orbit_base::TemporaryFile> temporary_file_;
+  std::filesystem::path file_path_;
+  ModuleSymbols module_symbols_;
+};
+
+}  // namespace
+
+TEST_F(SymbolCacheFileTest, WriteAndOpen) {
+  auto write_result = SymbolCacheFile::Write(file_path_, kBuildId, module_symbols_);
+  ASSERT_FALSE(write_result.has_error()) << write_result.error().message();
+
+  auto file_or_error = SymbolCacheFile::Open(file_path_, kBuildId);
+  ASSERT_FALSE(file_or_error.has_error()) << file_or_error.error().message();
+  const SymbolCacheFile& file = *file_or_error.value();
+
+  EXPECT_EQ(file.GetBuildId(), kBuildId);
+  EXPECT_EQ(file.GetSymbolsFilePath(), "/path/to/symbols.debug");
+  EXPECT_EQ(file.GetLoadBias(), 0x400000);
+  ASSERT_EQ(file.GetNumSymbols(), 3);
+
+  // Symbols are sorted by address.
+  EXPECT_EQ(file.GetSymbol(0).name, "main");
+  EXPECT_EQ(file.GetSymbol(0).demangled_name, "main");
+  EXPECT_EQ(file.GetSymbol(0).address, 0x1000);
+  EXPECT_EQ(file.GetSymbol(0).size, 0x100);
+  EXPECT_EQ(file.GetSymbol(1).name, "_Z3foov");
+  EXPECT_EQ(file.GetSymbol(1).demangled_name, "foo()");
+  EXPECT_EQ(file.GetSymbol(2).name, "_Z3barv");
+  EXPECT_EQ(file.GetSymbol(2).demangled_name, "bar()");
+}
+
+TEST_F(SymbolCacheFileTest, FindSymbolByAddress) {
+  ASSERT_FALSE(SymbolCacheFile::Write(file_path_, kBuildId, module_symbols_).has_error());
+  auto file_or_error = SymbolCacheFile::Open(file_path_, kBuildId);
+  ASSERT_FALSE(file_or_error.has_error()) << file_or_error.error().message();
+  const SymbolCacheFile& file = *file_or_error.value();
+
+  EXPECT_FALSE(file.FindSymbolByAddress(0x0fff).has_value());
+  ASSERT_TRUE(file.FindSymbolByAddress(0x1000).has_value());
+  EXPECT_EQ(file.FindSymbolByAddress(0x1000)->name, "main");
+  ASSERT_TRUE(file.FindSymbolByAddress(0x10ff).has_value());
+  EXPECT_EQ(file.FindSymbolByAddress(0x10ff)->name, "main");
+  EXPECT_FALSE(file.FindSymbolByAddress(0x1100).has_value());
+  ASSERT_TRUE(file.FindSymbolByAddress(0x2010).has_value());
+  EXPECT_EQ(file.FindSymbolByAddress(0x2010)->demangled_name, "foo()");
+  EXPECT_FALSE(file.FindSymbolByAddress(0x3010).has_value());
+}
+
+TEST_F(SymbolCacheFileTest, FindSymbolByName) {
+  ASSERT_FALSE(SymbolCacheFile::Write(file_path_, kBuildId, module_symbols_).has_error());
+  auto file_or_error = SymbolCacheFile::Open(file_path_, kBuildId);
+  ASSERT_FALSE(file_or_error.has_error()) << file_or_error.error().message();
+  const SymbolCacheFile& file = *file_or_error.value();
+
+  ASSERT_TRUE(file.FindSymbolByName("_Z3barv").has_value());
+  EXPECT_EQ(file.FindSymbolByName("_Z3barv")->address, 0x3000);
+  ASSERT_TRUE(file.FindSymbolByName("main").has_value());
+  EXPECT_EQ(file.FindSymbolByName("main")->address, 0x1000);
+  EXPECT_FALSE(file.FindSymbolByName("bar()").has_value());
+  EXPECT_FALSE(file.FindSymbolByName("does_not_exist").has_value());
+}
+
+TEST_F(SymbolCacheFileTest, ToModuleSymbols) {
+  ASSERT_FALSE(SymbolCacheFile::Write(file_path_, kBuildId, module_symbols_).has_error());
+  auto file_or_error = SymbolCacheFile::Open(file_path_, kBuildId);
+  ASSERT_FALSE(file_or_error.has_error()) << file_or_error.error().message();
+
+  ModuleSymbols module_symbols = file_or_error.value()->ToModuleSymbols();
+  EXPECT_EQ(module_symbols.load_bias(), module_symbols_.load_bias());
+  EXPECT_EQ(module_symbols.symbols_file_path(), module_symbols_.symbols_file_path());
+  ASSERT_EQ(module_symbols.symbol_infos_size(), 3);
+  EXPECT_EQ(module_symbols.symbol_infos(0).name(), "main");
+  EXPECT_EQ(module_symbols.symbol_infos(1).demangled_name(), "foo()");
+  EXPECT_EQ(module_symbols.symbol_infos(2).address(), 0x3000);
+  EXPECT_EQ(module_symbols.symbol_infos(2).size(), 0x10);
+}
+
+TEST_F(SymbolCacheFileTest, OpenFailsForWrongBuildId) {
+  ASSERT_FALSE(SymbolCacheFile::Write(file_path_, kBuildId, module_symbols_).has_error());
+  auto file_or_error = SymbolCacheFile::Open(file_path_, "other build id");
+  ASSERT_TRUE(file_or_error.has_error());
+  EXPECT_THAT(absl::AsciiStrToLower(file_or_error.error().message()),
+              testing::HasSubstr("build id does not match"));
+}
+
+TEST_F(SymbolCacheFileTest, OpenFailsForInvalidFiles) {
+  {
+    auto file_or_error = SymbolCacheFile::Open(file_path_.string() + ".missing", kBuildId);
+    ASSERT_TRUE(file_or_error.has_error());
+    EXPECT_THAT(absl::AsciiStrToLower(file_or_error.error().message()),
+                testing::HasSubstr("unable to open file"));
+  }
+
+  {
+    ASSERT_FALSE(orbit_base::WriteStringToFile(file_path_, "too small").has_error());
+    auto file_or_error = SymbolCacheFile::Open(file_path_, kBuildId);
+    ASSERT_TRUE(file_or_error.has_error());
+    EXPECT_THAT(absl::AsciiStrToLower(file_or_error.error().message()),
+                testing::HasSubstr("too small"));
+  }
+
+  {
+    ASSERT_FALSE(
+        orbit_base::WriteStringToFile(file_path_, std::string(1024, 'x')).has_error());
+    auto file_or_error = SymbolCacheFile::Open(file_path_, kBuildId);
+    ASSERT_TRUE(file_or_error.has_error());
+    EXPECT_THAT(absl::AsciiStrToLower(file_or_error.error().message()),
+                testing::HasSubstr("wrong magic number"));
+  }
+}
+
+TEST_F(SymbolCacheFileTest, OpenFailsForTruncatedFile) {
+  ASSERT_FALSE(SymbolCacheFile::Write(file_path_, kBuildId, module_symbols_).has_error());
+  std::filesystem::resize_file(file_path_, std::filesystem::file_size(file_path_) - 1);
+
+  auto file_or_error = SymbolCacheFile::Open(file_path_, kBuildId);
+  ASSERT_TRUE(file_or_error.has_error());
+  EXPECT_THAT(absl::AsciiStrToLower(file_or_error.error().message()),
+              testing::HasSubstr("do not match the file size"));
+}
+
+TEST_F(SymbolCacheFileTest, WriteRemovesTemporaryFileOnError) {
+  // Renaming the temporary file to a non-empty directory fails.
+  const std::filesystem::path directory_path = file_path_.string() + ".dir";
+  std::filesystem::create_directories(directory_path / "child");
+
+  EXPECT_TRUE(SymbolCacheFile::Write(directory_path, kBuildId, module_symbols_).has_error());
+  const std::string temporary_file_prefix = directory_path.filename().string() + ".";
+  for (const auto& entry : std::filesystem::directory_iterator(directory_path.parent_path())) {
+    EXPECT_FALSE(absl::StartsWith(entry.path().filename().string(), temporary_file_prefix))
+        << entry.path();
+  }
+  std::filesystem::remove_all(directory_path);
+}
+
+TEST_F(SymbolCacheFileTest, EmptyModuleSymbols) {
+  ModuleSymbols empty_module_symbols;
+  ASSERT_FALSE(SymbolCacheFile::Write(file_path_, kBuildId, empty_module_symbols).has_error());
+  auto file_or_error = SymbolCacheFile::Open(file_path_, kBuildId);
+  ASSERT_FALSE(file_or_error.has_error()) << file_or_error.error().message();
+
+  EXPECT_EQ(file_or_error.value()->GetNumSymbols(), 0);
+  EXPECT_FALSE(file_or_error.value()->FindSymbolByAddress(0x1000).has_value());
+  EXPECT_FALSE(file_or_error.value()->FindSymbolByName("main").has_value());
+}
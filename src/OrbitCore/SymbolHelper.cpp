@@ -24,6 +24,7 @@
 #include "OrbitBase/Tracing.h"
 #include "OrbitBase/WriteStringToFile.h"
 #include "Path.h"
+#include "SymbolCacheFile.h"
 
 using orbit_grpc_protos::ModuleSymbols;
 
@@ -235,11 +236,41 @@ ErrorMessageOr<ModuleSymbols> SymbolHelper::LoadSymbolsFromFile(const fs::path&
   return elf_file_or_error.value()->LoadSymbolsFromSymtab();
 }
 
+ErrorMessageOr<ModuleSymbols> SymbolHelper::LoadSymbolsUsingCache(
+    const fs::path& file_path, const std::string& build_id) const {
+  if (build_id.empty()) return LoadSymbolsFromFile(file_path);
+
+  const fs::path symbol_cache_file_path = GenerateSymbolCacheFileName(build_id);
+  {
+    ORBIT_SCOPE("LoadSymbolsFromSymbolCacheFile");
+    SCOPED_TIMED_LOG("Loading symbols from cache file: %s", symbol_cache_file_path.string());
+    ErrorMessageOr<std::unique_ptr<SymbolCacheFile>> symbol_cache_file_or_error =
+        SymbolCacheFile::Open(symbol_cache_file_path, build_id);
+    if (symbol_cache_file_or_error.has_value()) {
+      ModuleSymbols module_symbols = symbol_cache_file_or_error.value()->ToModuleSymbols();
+      module_symbols.set_symbols_file_path(file_path.string());
+      return module_symbols;
+    }
+    LOG("Unable to use symbol cache file: %s", symbol_cache_file_or_error.error().message());
+  }
+
+  OUTCOME_TRY(module_symbols, LoadSymbolsFromFile(file_path));
+  auto write_result = SymbolCacheFile::Write(symbol_cache_file_path, build_id, module_symbols);
+  if (write_result.has_error()) {
+    ERROR("Unable to write symbol cache file: %s", write_result.error().message());
+  }
+  return module_symbols;
+}
+
 fs::path SymbolHelper::GenerateCachedFileName(const fs::path& file_path) const {
   auto file_name = absl::StrReplaceAll(file_path.string(), {{"/", "_"}});
   return cache_directory_ / file_name;
 }
 
+fs::path SymbolHelper::GenerateSymbolCacheFileName(const std::string& build_id) const {
+  return cache_directory_ / absl::StrFormat("%s.symcache", build_id);
+}
+
 [[nodiscard]] bool SymbolHelper::IsMatchingDebugInfoFile(
     const std::filesystem::path& debuginfo_file_path, uint32_t checksum) {
   std::error_code error;
@@ -30,10 +30,15 @@ class SymbolHelper {
                                                             const std::string& build_id) const;
   [[nodiscard]] static ErrorMessageOr<orbit_grpc_protos::ModuleSymbols> LoadSymbolsFromFile(
       const fs::path& file_path);
+  // Same as LoadSymbolsFromFile, but first tries the symbol cache file for `build_id` in the cache
+  // directory. On a cache miss the symbols are loaded from `file_path` and written to the cache.
+  [[nodiscard]] ErrorMessageOr<orbit_grpc_protos::ModuleSymbols> LoadSymbolsUsingCache(
+      const fs::path& file_path, const std::string& build_id) const;
   [[nodiscard]] static ErrorMessageOr<void> VerifySymbolsFile(const fs::path& symbols_path,
                                                               const std::string& build_id);
 
   [[nodiscard]] fs::path GenerateCachedFileName(const fs::path& file_path) const;
+  [[nodiscard]] fs::path GenerateSymbolCacheFileName(const std::string& build_id) const;
 
   [[nodiscard]] static bool IsMatchingDebugInfoFile(const fs::path& file_path, uint32_t checksum);
   [[nodiscard]] ErrorMessageOr<fs::path> FindDebugInfoFileLocally(std::string_view filename,
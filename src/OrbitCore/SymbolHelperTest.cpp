@@ -5,12 +5,14 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <outcome.hpp>
 #include <string>
 
 #include "OrbitBase/ExecutablePath.h"
 #include "OrbitBase/Result.h"
+#include "OrbitBase/TemporaryFile.h"
 #include "Path.h"
 #include "SymbolHelper.h"
 #include "absl/strings/ascii.h"
@@ -128,6 +130,43 @@ TEST(SymbolHelper, LoadFromFile) {
   }
 }
 
+TEST(SymbolHelper, LoadSymbolsUsingCache) {
+  // The name of the temporary file is unique, use it for a cache directory of this test only.
+  auto temporary_file_or_error = orbit_base::TemporaryFile::Create();
+  ASSERT_FALSE(temporary_file_or_error.has_error()) << temporary_file_or_error.error().message();
+  const fs::path cache_directory = temporary_file_or_error.value().file_path().string() + "_cache";
+  ASSERT_TRUE(fs::create_directory(cache_directory));
+  SymbolHelper symbol_helper{{}, cache_directory, {}};
+  const std::string build_id = "b5413574bbacec6eacb3b89b1012d0e2cd92ec6b";
+  const fs::path symbol_cache_file_path = symbol_helper.GenerateSymbolCacheFileName(build_id);
+
+  const fs::path file_path = testdata_directory / "no_symbols_elf.debug";
+  const auto result_from_file = symbol_helper.LoadSymbolsUsingCache(file_path, build_id);
+  ASSERT_FALSE(result_from_file.has_error()) << result_from_file.error().message();
+  EXPECT_TRUE(fs::exists(symbol_cache_file_path));
+
+  const auto result_from_cache = symbol_helper.LoadSymbolsUsingCache(file_path, build_id);
+  ASSERT_FALSE(result_from_cache.has_error()) << result_from_cache.error().message();
+
+  const ModuleSymbols& symbols_from_file = result_from_file.value();
+  const ModuleSymbols& symbols_from_cache = result_from_cache.value();
+  EXPECT_EQ(symbols_from_cache.symbols_file_path(), file_path);
+  EXPECT_EQ(symbols_from_cache.load_bias(), symbols_from_file.load_bias());
+  ASSERT_EQ(symbols_from_cache.symbol_infos_size(), symbols_from_file.symbol_infos_size());
+  for (const auto& symbol_info : symbols_from_file.symbol_infos()) {
+    EXPECT_TRUE(std::any_of(symbols_from_cache.symbol_infos().begin(),
+                            symbols_from_cache.symbol_infos().end(), [&](const auto& cached) {
+                              return cached.name() == symbol_info.name() &&
+                                     cached.demangled_name() == symbol_info.demangled_name() &&
+                                     cached.address() == symbol_info.address() &&
+                                     cached.size() == symbol_info.size();
+                            }));
+  }
+
+  std::error_code error;
+  fs::remove_all(cache_directory, error);
+}
+
 TEST(SymbolHelper, GenerateCachedFileName) {
   SymbolHelper symbol_helper{{}, Path::CreateOrGetCacheDir(), {}};
   const std::filesystem::path file_path = "/var/data/filename.elf";
@@ -136,6 +175,12 @@ TEST(SymbolHelper, GenerateCachedFileName) {
   EXPECT_EQ(symbol_helper.GenerateCachedFileName(file_path), cache_file_path);
 }
 
+TEST(SymbolHelper, GenerateSymbolCacheFileName) {
+  SymbolHelper symbol_helper{{}, Path::CreateOrGetCacheDir(), {}};
+  EXPECT_EQ(symbol_helper.GenerateSymbolCacheFileName("abcdef"),
+            Path::CreateOrGetCacheDir() / "abcdef.symcache");
+}
+
 TEST(SymbolHelper, VerifySymbolsFile) {
   {
     // valid file containing symbols and matching build id
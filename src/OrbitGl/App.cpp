@@ -94,6 +94,7 @@
 ABSL_DECLARE_FLAG(bool, devmode);
 ABSL_DECLARE_FLAG(bool, local);
 ABSL_DECLARE_FLAG(bool, enable_tracepoint_feature);
+ABSL_DECLARE_FLAG(bool, filter_tracepoints_in_kernel);
 ABSL_DECLARE_FLAG(bool, enable_source_code_view);
 
 using orbit_client_protos::CallstackEvent;
@@ -158,7 +159,8 @@ OrbitApp::OrbitApp(orbit_gl::MainWindowInterface* main_window,
   main_thread_id_ = std::this_thread::get_id();
   data_manager_ = std::make_unique<DataManager>(main_thread_id_);
   module_manager_ = std::make_unique<orbit_client_data::ModuleManager>();
-  manual_instrumentation_manager_ = std::make_unique<ManualInstrumentationManager>();
+  manual_instrumentation_manager_ =
+      std::make_unique<ManualInstrumentationManager>(&string_manager_);
 }
 
 OrbitApp::~OrbitApp() {
@@ -976,12 +978,16 @@ void OrbitApp::StartCapture() {
   bool collect_memory_info = data_manager_->collect_memory_info();
   uint64_t memory_sampling_period_ns = data_manager_->memory_sampling_period_ns();
 
+  bool enable_user_space_instrumentation = data_manager_->enable_user_space_instrumentation();
+  bool filter_tracepoints_in_kernel = absl::GetFlag(FLAGS_filter_tracepoints_in_kernel);
+
   CHECK(capture_client_ != nullptr);
   Future<ErrorMessageOr<CaptureOutcome>> capture_result = capture_client_->Capture(
       thread_pool_.get(), *process, *module_manager_, std::move(selected_functions_map),
       std::move(selected_tracepoints), std::move(frame_track_function_ids), samples_per_second,
       unwinding_method, collect_thread_states, enable_introspection,
-      max_local_marker_depth_per_command_buffer, collect_memory_info, memory_sampling_period_ns);
+      max_local_marker_depth_per_command_buffer, collect_memory_info, memory_sampling_period_ns,
+      enable_user_space_instrumentation, filter_tracepoints_in_kernel);
 
   capture_result.Then(main_thread_executor_, [this](ErrorMessageOr<CaptureOutcome> capture_result) {
     if (capture_result.has_error()) {
@@ -1142,7 +1148,20 @@ orbit_base::Future<ErrorMessageOr<std::filesystem::path>> OrbitApp::RetrieveModu
         absl::StrFormat(R"(Copying debug info file for "%s" from remote: "%s"...)",
                         module_file_path, debug_file_path));
     SCOPED_TIMED_LOG("Copying \"%s\"", debug_file_path);
-    auto scp_result = secure_copy_callback_(debug_file_path, local_debug_file_path.string());
+    const auto copy_start = std::chrono::steady_clock::now();
+    auto progress_callback = [&scoped_status, &module_file_path, copy_start](
+                                 uint64_t bytes_copied, uint64_t bytes_total) {
+      constexpr double kBytesPerMib = 1024.0 * 1024.0;
+      const double seconds =
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - copy_start).count();
+      const double mib_per_second = seconds > 0 ? bytes_copied / kBytesPerMib / seconds : 0;
+      scoped_status.UpdateMessage(absl::StrFormat(
+          R"(Copying debug info file for "%s" from remote: %.1f of %.1f MiB (%.1f MiB/s)...)",
+          module_file_path, bytes_copied / kBytesPerMib, bytes_total / kBytesPerMib,
+          mib_per_second));
+    };
+    auto scp_result = secure_copy_callback_(debug_file_path, local_debug_file_path.string(),
+                                            std::move(progress_callback));
 
     if (scp_result.has_error()) {
       return ErrorMessage{absl::StrFormat("Could not copy debug info file from the remote: %s",
@@ -1347,6 +1366,7 @@ void OrbitApp::AddSymbols(const std::filesystem::path& module_file_path,
   ModuleData* module_data =
       GetMutableModuleByPathAndBuildId(module_file_path.string(), module_build_id);
   module_data->AddSymbols(module_symbols);
+  if (HasCaptureData()) GetMutableCaptureData().InvalidateResolvedAddresses();
 
   const ProcessData* selected_process = GetTargetProcess();
   if (selected_process != nullptr && selected_process->IsModuleLoaded(module_data->file_path())) {
@@ -1371,8 +1391,10 @@ orbit_base::Future<ErrorMessageOr<void>> OrbitApp::LoadSymbols(
   auto scoped_status = CreateScopedStatus(absl::StrFormat(
       R"(Loading symbols for "%s" from file "%s"...)", module_file_path, symbols_path.string()));
 
-  auto load_symbols_from_file = thread_pool_->Schedule(
-      [symbols_path]() { return SymbolHelper::LoadSymbolsFromFile(symbols_path); });
+  auto load_symbols_from_file =
+      thread_pool_->Schedule([this, symbols_path, module_build_id]() {
+        return symbol_helper_.LoadSymbolsUsingCache(symbols_path, module_build_id);
+      });
 
   auto add_symbols =
       [this, module_id, scoped_status = std::move(scoped_status)](
@@ -1572,8 +1594,12 @@ orbit_base::Future<std::vector<ErrorMessageOr<void>>> OrbitApp::ReloadModules(
 
   // This all applies similarly to frame tracks that are based on selected functions.
 
-  // Update modules and get the ones to reload.
+  // Update modules and get the ones to reload. Updating a module frees its functions, so the
+  // addresses resolved by the capture are dropped before, and again after to also drop the ones
+  // resolved concurrently against the old modules.
+  if (HasCaptureData()) GetMutableCaptureData().InvalidateResolvedAddresses();
   std::vector<ModuleData*> modules_to_reload = module_manager_->AddOrUpdateModules(module_infos);
+  if (HasCaptureData()) GetMutableCaptureData().InvalidateResolvedAddresses();
 
   absl::flat_hash_map<std::string, std::vector<uint64_t>> function_hashes_to_hook_map;
   for (const FunctionInfo& func : data_manager_->GetSelectedFunctions()) {
@@ -277,8 +277,10 @@ class OrbitApp final : public DataViewFactory, public CaptureListener {
   void SetClipboardCallback(ClipboardCallback callback) {
     clipboard_callback_ = std::move(callback);
   }
-  using SecureCopyCallback =
-      std::function<ErrorMessageOr<void>(std::string_view, std::string_view)>;
+  // The progress callback receives the number of bytes copied so far and the size of the file.
+  using SecureCopyProgressCallback = std::function<void(uint64_t, uint64_t)>;
+  using SecureCopyCallback = std::function<ErrorMessageOr<void>(
+      std::string_view, std::string_view, SecureCopyProgressCallback)>;
   void SetSecureCopyCallback(SecureCopyCallback callback) {
     secure_copy_callback_ = std::move(callback);
   }
@@ -383,6 +385,12 @@ class OrbitApp final : public DataViewFactory, public CaptureListener {
   [[nodiscard]] uint64_t GetMemoryWarningThresholdKb() const {
     return data_manager_->memory_warning_threshold_kb();
   }
+  void SetEnableUserSpaceInstrumentation(bool enable_user_space_instrumentation) {
+    data_manager_->set_enable_user_space_instrumentation(enable_user_space_instrumentation);
+  }
+  [[nodiscard]] bool GetEnableUserSpaceInstrumentation() const {
+    return data_manager_->enable_user_space_instrumentation();
+  }
 
   // TODO(kuebler): Move them to a separate controler at some point
   void SelectFunction(const orbit_client_protos::FunctionInfo& func);
@@ -94,7 +94,7 @@ void AsyncTrack::OnTimer(const orbit_client_protos::TimerInfo& timer_info) {
 }
 
 void AsyncTrack::SetTimesliceText(const TimerInfo& timer_info, float min_x, float z_offset,
-                                  TextBox* text_box) {
+                                  TextBox* text_box, TextRenderer* text_renderer) {
   std::string time = GetPrettyTime(absl::Nanoseconds(timer_info.end() - timer_info.start()));
   text_box->SetElapsedTimeTextLength(time.length());
 
@@ -109,14 +109,15 @@ void AsyncTrack::SetTimesliceText(const TimerInfo& timer_info, float min_x, floa
   const Vec2& box_size = text_box->GetSize();
   float pos_x = std::max(box_pos[0], min_x);
   float max_size = box_pos[0] + box_size[0] - pos_x;
-  text_renderer_->AddTextTrailingCharsPrioritized(
+  text_renderer->AddTextTrailingCharsPrioritized(
       text_box->GetText().c_str(), pos_x, text_box->GetPos()[1] + layout_->GetTextOffset(),
       GlCanvas::kZValueBox + z_offset, kTextWhite, text_box->GetElapsedTimeTextLength(),
       layout_->CalculateZoomedFontSize(), max_size);
 }
 
 Color AsyncTrack::GetTimerColor(const TimerInfo& timer_info, bool is_selected,
-                                bool is_highlighted) const {
+                                bool is_highlighted,
+                                const orbit_gl::UpdatePrimitivesContext& context) const {
   const Color kInactiveColor(100, 100, 100, 255);
   const Color kSelectionColor(0, 128, 255, 255);
   if (is_highlighted) {
@@ -125,7 +126,7 @@ Color AsyncTrack::GetTimerColor(const TimerInfo& timer_info, bool is_selected,
   if (is_selected) {
     return kSelectionColor;
   }
-  if (!IsTimerActive(timer_info)) {
+  if (!IsTimerActive(timer_info, context)) {
     return kInactiveColor;
   }
 
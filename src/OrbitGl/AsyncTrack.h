@@ -35,9 +35,10 @@ class AsyncTrack final : public TimerTrack {
 
  protected:
   void SetTimesliceText(const orbit_client_protos::TimerInfo& timer, float min_x, float z_offset,
-                        TextBox* text_box) override;
-  [[nodiscard]] Color GetTimerColor(const orbit_client_protos::TimerInfo& timer_info,
-                                    bool is_selected, bool is_highlighted) const override;
+                        TextBox* text_box, TextRenderer* text_renderer) override;
+  [[nodiscard]] Color GetTimerColor(
+      const orbit_client_protos::TimerInfo& timer_info, bool is_selected, bool is_highlighted,
+      const orbit_gl::UpdatePrimitivesContext& context) const override;
 
   // Used for determining what row can receive a new timer with no overlap.
   absl::flat_hash_map<uint32_t, uint64_t> max_span_time_by_depth_;
@@ -9,6 +9,8 @@
 
 #include <algorithm>
 #include <memory>
+#include <numeric>
+#include <optional>
 #include <utility>
 #include <vector>
 
@@ -88,9 +90,11 @@ void CallstackThreadBar::Draw(GlCanvas* canvas, PickingMode picking_mode, float
   }
 }
 
-void CallstackThreadBar::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
+void CallstackThreadBar::UpdatePrimitives(Batcher* batcher,
+                                          const orbit_gl::UpdatePrimitivesContext& context,
+                                          uint64_t min_tick, uint64_t max_tick,
                                           PickingMode picking_mode, float z_offset) {
-  ThreadBar::UpdatePrimitives(batcher, min_tick, max_tick, picking_mode, z_offset);
+  ThreadBar::UpdatePrimitives(batcher, context, min_tick, max_tick, picking_mode, z_offset);
 
   float z = GlCanvas::kZValueEvent + z_offset;
   float track_height = layout_->GetEventTrackHeight();
@@ -101,20 +105,40 @@ void CallstackThreadBar::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, u
   CHECK(capture_data_ != nullptr);
 
   if (!picking) {
-    // Sampling Events
-    auto action_on_callstack_events = [=](const orbit_client_protos::CallstackEvent& event) {
-      const uint64_t time = event.time();
-      CHECK(time >= min_tick && time <= max_tick);
-      Vec2 pos(time_graph_->GetWorldFromTick(time), pos_[1]);
-      batcher->AddVerticalLine(pos, -track_height, z, kWhite);
-    };
-
-    if (thread_id_ == orbit_base::kAllProcessThreadsTid) {
-      capture_data_->GetCallstackData()->ForEachCallstackEventInTimeRange(
-          min_tick, max_tick, action_on_callstack_events);
+    // When there are more samples in view than pixels, draw their density per pixel column using
+    // the precomputed histograms instead of one line per sample.
+    const CallstackData* callstack_data = capture_data_->GetCallstackData();
+    const auto num_columns =
+        static_cast<size_t>(std::max(time_graph_->GetCanvas()->GetWidth(), 1));
+    std::optional<std::vector<uint32_t>> counts_per_column =
+        (thread_id_ == orbit_base::kAllProcessThreadsTid)
+            ? callstack_data->GetCallstackEventsCountsInTimeBuckets(min_tick, max_tick,
+                                                                   num_columns)
+            : callstack_data->GetCallstackEventsOfTidCountsInTimeBuckets(thread_id_, min_tick,
+                                                                        max_tick, num_columns);
+    const uint64_t num_samples_in_view =
+        counts_per_column.has_value()
+            ? std::accumulate(counts_per_column->begin(), counts_per_column->end(), uint64_t{0})
+            : 0;
+
+    if (num_samples_in_view > num_columns) {
+      AddSampleDensityBoxes(batcher, min_tick, max_tick, counts_per_column.value(), z);
     } else {
-      capture_data_->GetCallstackData()->ForEachCallstackEventOfTidInTimeRange(
-          thread_id_, min_tick, max_tick, action_on_callstack_events);
+      // Sampling Events
+      auto action_on_callstack_events = [=](const orbit_client_protos::CallstackEvent& event) {
+        const uint64_t time = event.time();
+        CHECK(time >= min_tick && time <= max_tick);
+        Vec2 pos(time_graph_->GetWorldFromTick(time), pos_[1]);
+        batcher->AddVerticalLine(pos, -track_height, z, kWhite);
+      };
+
+      if (thread_id_ == orbit_base::kAllProcessThreadsTid) {
+        capture_data_->GetCallstackData()->ForEachCallstackEventInTimeRange(
+            min_tick, max_tick, action_on_callstack_events);
+      } else {
+        capture_data_->GetCallstackData()->ForEachCallstackEventOfTidInTimeRange(
+            thread_id_, min_tick, max_tick, action_on_callstack_events);
+      }
     }
 
     // Draw selected events
@@ -151,6 +175,41 @@ void CallstackThreadBar::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, u
   }
 }
 
+void CallstackThreadBar::AddSampleDensityBoxes(Batcher* batcher, uint64_t min_tick,
+                                               uint64_t max_tick,
+                                               const std::vector<uint32_t>& counts_per_bucket,
+                                               float z) {
+  CHECK(!counts_per_bucket.empty());
+  const uint32_t max_count =
+      *std::max_element(counts_per_bucket.begin(), counts_per_bucket.end());
+  if (max_count == 0) return;
+
+  // Even buckets with a single sample need to remain visible.
+  constexpr float kMinAlpha = 64.f;
+  const float track_height = layout_->GetEventTrackHeight();
+  const double ticks_per_bucket =
+      (static_cast<double>(max_tick - min_tick) + 1.0) /
+      static_cast<double>(counts_per_bucket.size());
+
+  for (size_t bucket = 0; bucket < counts_per_bucket.size(); ++bucket) {
+    const uint32_t count = counts_per_bucket[bucket];
+    if (count == 0) continue;
+
+    const uint64_t bucket_min_tick =
+        min_tick + static_cast<uint64_t>(static_cast<double>(bucket) * ticks_per_bucket);
+    const uint64_t bucket_max_tick =
+        min_tick + static_cast<uint64_t>(static_cast<double>(bucket + 1) * ticks_per_bucket);
+    const float world_x = time_graph_->GetWorldFromTick(bucket_min_tick);
+    const float world_width = time_graph_->GetWorldFromTick(bucket_max_tick) - world_x;
+
+    const float alpha = kMinAlpha + (255.f - kMinAlpha) * static_cast<float>(count) /
+                                        static_cast<float>(max_count);
+    const Color color(255, 255, 255, static_cast<uint8_t>(alpha));
+    Box box(Vec2(world_x, pos_[1] - track_height), Vec2(world_width, track_height), z);
+    batcher->AddBox(box, color);
+  }
+}
+
 void CallstackThreadBar::OnRelease() {
   CaptureViewElement::OnRelease();
   SelectCallstacks();
@@ -10,6 +10,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "CoreMath.h"
 #include "OrbitClientData/Callstack.h"
@@ -30,8 +31,9 @@ class CallstackThreadBar : public ThreadBar {
   std::string GetTooltip() const override;
 
   void Draw(GlCanvas* canvas, PickingMode picking_mode, float z_offset = 0) override;
-  void UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
-                        PickingMode picking_mode, float z_offset = 0) override;
+  void UpdatePrimitives(Batcher* batcher, const orbit_gl::UpdatePrimitivesContext& context,
+                        uint64_t min_tick, uint64_t max_tick, PickingMode picking_mode,
+                        float z_offset = 0) override;
 
   void OnPick(int x, int y) override;
   void OnRelease() override;
@@ -49,6 +51,11 @@ class CallstackThreadBar : public ThreadBar {
 
   [[nodiscard]] std::string GetSampleTooltip(const Batcher& batcher, PickingId id) const;
 
+  // Draws one box per bucket of [min_tick, max_tick], whose opacity depends on the number of
+  // samples in the bucket.
+  void AddSampleDensityBoxes(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
+                             const std::vector<uint32_t>& counts_per_bucket, float z);
+
   Color color_;
 };
 
@@ -9,6 +9,7 @@
 #include "OrbitAccessibility/AccessibleInterface.h"
 #include "PickingManager.h"
 #include "TimeGraphLayout.h"
+#include "UpdatePrimitivesContext.h"
 
 class TimeGraph;
 class GlCanvas;
@@ -24,7 +25,8 @@ class CaptureViewElement : public Pickable {
     canvas_ = canvas;
   }
 
-  virtual void UpdatePrimitives(Batcher* /*batcher*/, uint64_t /*min_tick*/, uint64_t /*max_tick*/,
+  virtual void UpdatePrimitives(Batcher* /*batcher*/, const UpdatePrimitivesContext& /*context*/,
+                                uint64_t /*min_tick*/, uint64_t /*max_tick*/,
                                 PickingMode /*picking_mode*/, float /*z_offset*/ = 0){};
 
   [[nodiscard]] TimeGraph* GetTimeGraph() { return time_graph_; }
@@ -301,6 +301,22 @@ void CaptureWindow::PostRender() {
     RequestRedraw();
     GlCanvas::Render(screen_width_, screen_height_);
   }
+
+  // Following the end of the capture used to update the primitives on every frame while capturing.
+  // The primitives are now built in the background between frames instead.
+  if (time_graph_ != nullptr) {
+    time_graph_->StartBackgroundUpdatePrimitives(/*zoom_to_capture_end=*/ShouldAutoZoom());
+  }
+}
+
+void CaptureWindow::PreEvent() { FinishBackgroundUpdatePrimitives(); }
+
+void CaptureWindow::FinishBackgroundUpdatePrimitives() {
+  if (time_graph_ != nullptr) time_graph_->FinishBackgroundUpdatePrimitives();
+}
+
+bool CaptureWindow::IsRedrawNeeded() const {
+  return GlCanvas::IsRedrawNeeded() || (time_graph_ != nullptr && time_graph_->IsRedrawNeeded());
 }
 
 void CaptureWindow::Resize(int width, int height) {
@@ -525,10 +541,6 @@ std::unique_ptr<AccessibleInterface> CaptureWindow::CreateAccessibleInterface()
 
 void CaptureWindow::Draw() {
   ORBIT_SCOPE("CaptureWindow::Draw");
-  if (ShouldAutoZoom()) {
-    ZoomAll();
-  }
-
   // Reset picking manager before each draw.
   picking_manager_.Reset();
 
@@ -742,6 +754,8 @@ static std::string VariableToString(std::string_view name, const T& value) {
 }
 
 void CaptureWindow::RenderImGuiDebugUI() {
+  // This is drawn by the debug canvas, so the events of this window don't hand the update off.
+  FinishBackgroundUpdatePrimitives();
   if (ImGui::CollapsingHeader("Layout Properties")) {
     if (time_graph_ != nullptr && time_graph_->GetLayout().DrawProperties()) {
       RequestUpdatePrimitives();
@@ -783,6 +797,20 @@ void CaptureWindow::RenderImGuiDebugUI() {
       }
     }
   }
+
+  if (ImGui::CollapsingHeader("Frame Times")) {
+    const FrameTimeStatistics& render_times = GetRenderTimeStatistics();
+    ImGui::Text("Render (ms): p50 %.2f, p90 %.2f, p99 %.2f, max %.2f",
+                render_times.GetPercentileNs(50) / 1e6, render_times.GetPercentileNs(90) / 1e6,
+                render_times.GetPercentileNs(99) / 1e6, render_times.GetMaxNs() / 1e6);
+    if (time_graph_ != nullptr) {
+      const FrameTimeStatistics& update_times =
+          time_graph_->GetUpdatePrimitivesTimeStatistics();
+      ImGui::Text("Update primitives (ms): p50 %.2f, p90 %.2f, p99 %.2f, max %.2f",
+                  update_times.GetPercentileNs(50) / 1e6, update_times.GetPercentileNs(90) / 1e6,
+                  update_times.GetPercentileNs(99) / 1e6, update_times.GetMaxNs() / 1e6);
+    }
+  }
 }
 
 void CaptureWindow::RenderText(float layer) {
@@ -53,6 +53,8 @@ class CaptureWindow : public GlCanvas {
   void RenderText(float layer) override;
   void PreRender() override;
   void PostRender() override;
+  void PreEvent() override;
+  [[nodiscard]] bool IsRedrawNeeded() const override;
   void Resize(int width, int height) override;
   void RenderHelpUi();
   void RenderTimeBar();
@@ -72,7 +74,11 @@ class CaptureWindow : public GlCanvas {
   virtual void ToggleRecording();
   void ToggleDrawHelp();
   void set_draw_help(bool draw_help);
-  [[nodiscard]] TimeGraph* GetTimeGraph() { return time_graph_.get(); }
+  // On the UI thread, this waits for the time graph to finish a background update of primitives.
+  [[nodiscard]] TimeGraph* GetTimeGraph() {
+    FinishBackgroundUpdatePrimitives();
+    return time_graph_.get();
+  }
   void CreateTimeGraph(const CaptureData* capture_data);
   void ClearTimeGraph() { time_graph_.reset(nullptr); }
 
@@ -93,6 +99,10 @@ class CaptureWindow : public GlCanvas {
   bool background_clicked_ = false;
 
  private:
+  // The single point where the UI thread hands off a background update of the time graph's
+  // primitives: before any event and before the time graph is accessed from outside this class.
+  void FinishBackgroundUpdatePrimitives();
+
   OrbitApp* app_ = nullptr;
   [[nodiscard]] std::unique_ptr<orbit_accessibility::AccessibleInterface>
   CreateAccessibleInterface() override;
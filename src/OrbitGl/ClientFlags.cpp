@@ -39,5 +39,11 @@ ABSL_FLAG(bool, show_return_values, false, "Show return values on time slices");
 ABSL_FLAG(bool, enable_tracepoint_feature, false,
           "Enable the setting of the panel of kernel tracepoints");
 
+ABSL_FLAG(bool, filter_tracepoints_in_kernel, false,
+          "Drop the scheduling and task tracepoint records of other processes in the kernel with "
+          "eBPF. The filters are attached to the tracepoints themselves, so while a capture runs, "
+          "other perf users on the host lose the sched_switch, sched_wakeup and task_* records "
+          "of other processes");
+
 // TODO(b/181736566): Remove this flag entirely
 ABSL_FLAG(bool, enable_source_code_view, true, "Enable the experimental source code view");
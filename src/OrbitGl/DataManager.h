@@ -108,6 +108,13 @@ class DataManager final {
     return memory_warning_threshold_kb_;
   }
 
+  void set_enable_user_space_instrumentation(bool enable_user_space_instrumentation) {
+    enable_user_space_instrumentation_ = enable_user_space_instrumentation;
+  }
+  [[nodiscard]] bool enable_user_space_instrumentation() const {
+    return enable_user_space_instrumentation_;
+  }
+
  private:
   const std::thread::id main_thread_id_;
   FunctionInfoSet selected_functions_;
@@ -131,6 +138,8 @@ class DataManager final {
   bool collect_memory_info_ = false;
   uint64_t memory_sampling_period_ns_ = 100'000'000;
   uint64_t memory_warning_threshold_kb_ = 1024 * 1024 * 8;
+
+  bool enable_user_space_instrumentation_ = false;
 };
 
 #endif  // ORBIT_GL_DATA_MANAGER_H_
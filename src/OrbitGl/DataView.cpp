@@ -4,12 +4,146 @@
 
 #include "DataView.h"
 
-#include <memory>
+#include <algorithm>
+#include <thread>
 
 #include "App.h"
 #include "OrbitBase/File.h"
+#include "OrbitBase/ForEachInParallel.h"
 #include "OrbitBase/Logging.h"
 
+namespace {
+
+// Smaller ranges are not worth the overhead of handing them to another thread.
+constexpr size_t kMinNumElementsPerRange = 4 * 1024;
+
+[[nodiscard]] size_t GetNumRanges(size_t num_elements) {
+  const size_t max_num_ranges = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  return std::clamp<size_t>(num_elements / kMinNumElementsPerRange, 1, max_num_ranges);
+}
+
+}  // namespace
+
+std::vector<uint64_t> DataView::ParallelFilter(size_t num_elements,
+                                               const std::function<bool(size_t)>& predicate,
+                                               const IndicesUpdate* update) {
+  const size_t num_ranges = GetNumRanges(num_elements);
+  const size_t range_size = (num_elements + num_ranges - 1) / num_ranges;
+
+  std::vector<std::vector<uint64_t>> range_indices(num_ranges);
+  auto filter_range = [&](size_t range_index) {
+    const size_t begin = std::min(range_index * range_size, num_elements);
+    const size_t end = std::min(begin + range_size, num_elements);
+    for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += kMinNumElementsPerRange) {
+      if (update != nullptr && update->IsCanceled()) return;
+      const size_t chunk_end = std::min(chunk_begin + kMinNumElementsPerRange, end);
+      for (size_t i = chunk_begin; i < chunk_end; ++i) {
+        if (predicate(i)) range_indices[range_index].push_back(i);
+      }
+    }
+  };
+
+  if (num_ranges == 1) {
+    filter_range(0);
+    return std::move(range_indices[0]);
+  }
+
+  orbit_base::ForEachInParallel(num_ranges, filter_range);
+
+  size_t num_indices = 0;
+  for (const std::vector<uint64_t>& indices : range_indices) {
+    num_indices += indices.size();
+  }
+  std::vector<uint64_t> result;
+  result.reserve(num_indices);
+  for (const std::vector<uint64_t>& indices : range_indices) {
+    result.insert(result.end(), indices.begin(), indices.end());
+  }
+  return result;
+}
+
+void DataView::ParallelStableSort(std::vector<uint64_t>* indices,
+                                  const std::function<bool(uint64_t, uint64_t)>& comparator,
+                                  const IndicesUpdate* update) {
+  auto is_canceled = [update] { return update != nullptr && update->IsCanceled(); };
+  const size_t num_elements = indices->size();
+  const size_t num_ranges = GetNumRanges(num_elements);
+  if (num_ranges == 1) {
+    if (!is_canceled()) std::stable_sort(indices->begin(), indices->end(), comparator);
+    return;
+  }
+
+  const size_t range_size = (num_elements + num_ranges - 1) / num_ranges;
+  auto range_begin = [indices, num_elements, range_size](size_t range_index) {
+    return indices->begin() + std::min(range_index * range_size, num_elements);
+  };
+
+  orbit_base::ForEachInParallel(num_ranges, [&](size_t range_index) {
+    if (is_canceled()) return;
+    std::stable_sort(range_begin(range_index), range_begin(range_index + 1), comparator);
+  });
+
+  // Merge neighbouring sorted ranges pairwise until only one is left. std::inplace_merge puts
+  // equivalent elements of the left range first, so the merged result stays stable.
+  for (size_t width = 1; width < num_ranges; width *= 2) {
+    if (is_canceled()) return;
+    const size_t num_merges = (num_ranges + 2 * width - 1) / (2 * width);
+    orbit_base::ForEachInParallel(num_merges, [&](size_t merge_index) {
+      if (is_canceled()) return;
+      const size_t first = merge_index * 2 * width;
+      const size_t middle = std::min(first + width, num_ranges);
+      const size_t last = std::min(first + 2 * width, num_ranges);
+      std::inplace_merge(range_begin(first), range_begin(middle), range_begin(last), comparator);
+    });
+  }
+}
+
+void DataView::UpdateIndicesAsync(RefreshMode mode, FilterIndicesFunction filter,
+                                  SortIndicesFunction sort) {
+  CHECK(filter != nullptr);
+  if (current_update_ != nullptr) current_update_->Cancel();
+  auto update = std::make_shared<IndicesUpdate>();
+  current_update_ = update;
+  pending_updates_.erase(
+      std::remove_if(pending_updates_.begin(), pending_updates_.end(),
+                     [](const orbit_base::Future<void>& future) { return future.IsFinished(); }),
+      pending_updates_.end());
+
+  if (mode == RefreshMode::kOnFilter) filter_pending_ = true;
+  const bool refilter = filter_pending_;
+  if (refilter) mode = RefreshMode::kOnFilter;
+  std::optional<std::vector<uint64_t>> initial_indices;
+  if (!refilter) initial_indices = indices_;
+
+  pending_updates_.push_back(app_->GetThreadPool()->Schedule(
+      [this, update, mode, filter = std::move(filter), sort = std::move(sort),
+       initial_indices = std::move(initial_indices)]() mutable {
+        if (update->IsCanceled()) return;
+        std::vector<uint64_t> indices =
+            initial_indices.has_value() ? std::move(initial_indices.value()) : filter(*update);
+        if (sort != nullptr) sort(&indices, *update);
+        if (update->IsCanceled()) return;
+
+        app_->GetMainThreadExecutor()->Schedule(
+            [this, update, mode, indices = std::move(indices)]() mutable {
+              // `this` is only used if the update was not canceled, which the destructor does.
+              if (update->IsCanceled()) return;
+              indices_.swap(indices);
+              filter_pending_ = false;
+              OnIndicesUpdated(mode);
+              if (refresh_callback_) refresh_callback_(mode);
+            });
+      }));
+}
+
+void DataView::CancelAndWaitForPendingUpdates() {
+  if (current_update_ != nullptr) current_update_->Cancel();
+  for (const orbit_base::Future<void>& future : pending_updates_) {
+    future.Wait();
+  }
+  pending_updates_.clear();
+}
+
 void DataView::InitSortingOrders() {
   sorting_orders_.clear();
   for (const auto& column : GetColumns()) {
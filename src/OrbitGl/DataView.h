@@ -8,6 +8,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <atomic>
 #include <filesystem>
 #include <functional>
 #include <memory>
@@ -17,6 +18,7 @@
 #include <vector>
 
 #include "DataViewTypes.h"
+#include "OrbitBase/Future.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Result.h"
 #include "absl/container/flat_hash_set.h"
@@ -44,7 +46,7 @@ class DataView {
   explicit DataView(DataViewType type, OrbitApp* app)
       : update_period_ms_(-1), type_(type), app_{app} {}
 
-  virtual ~DataView() = default;
+  virtual ~DataView() { CancelAndWaitForPendingUpdates(); }
 
   virtual void SetAsMainInstance() {}
   virtual const std::vector<Column>& GetColumns() = 0;
@@ -63,6 +65,10 @@ class DataView {
   // Filter callback set from UI layer.
   using FilterCallback = std::function<void(const std::string&)>;
   void SetUiFilterCallback(FilterCallback callback) { filter_callback_ = std::move(callback); }
+  // Refresh callback set from UI layer. It is called on the main thread when an update started by
+  // UpdateIndicesAsync has replaced the indices.
+  using RefreshCallback = std::function<void(RefreshMode)>;
+  void SetUiRefreshCallback(RefreshCallback callback) { refresh_callback_ = std::move(callback); }
   virtual void OnRefresh(const std::vector<int>& /*visible_selected_indices*/,
                          const RefreshMode& /*mode*/) {}
 
@@ -101,7 +107,49 @@ class DataView {
   void InitSortingOrders();
   virtual void DoSort() {}
   virtual void DoFilter() {}
+
+  // Filtering and sorting of large views run on the thread pool of OrbitApp, so that the UI stays
+  // responsive. DoFilter and DoSort of such views call UpdateIndicesAsync, which cancels the
+  // pending update and starts a new one. The result of an update replaces indices_ on the main
+  // thread, unless the update was canceled in the meantime, and is then passed on to
+  // OnIndicesUpdated and the refresh callback. `filter` and `sort` run on other threads: they may
+  // read the elements of the view, but must not call anything that is restricted to the main
+  // thread (like DataManager). Views therefore call CancelAndWaitForPendingUpdates before they
+  // change their elements and in their destructor.
+  class IndicesUpdate {
+   public:
+    void Cancel() { canceled_ = true; }
+    [[nodiscard]] bool IsCanceled() const { return canceled_.load(std::memory_order_relaxed); }
+
+   private:
+    std::atomic<bool> canceled_ = false;
+  };
+  using FilterIndicesFunction = std::function<std::vector<uint64_t>(const IndicesUpdate& update)>;
+  using SortIndicesFunction =
+      std::function<void(std::vector<uint64_t>* indices, const IndicesUpdate& update)>;
+  // `mode` is kOnFilter when called from DoFilter and kOnSort when called from DoSort. An update
+  // for sorting starts from the current indices, so that sorting stays stable across columns,
+  // unless the result of filtering is still pending. `sort` may be empty.
+  void UpdateIndicesAsync(RefreshMode mode, FilterIndicesFunction filter, SortIndicesFunction sort);
+  void CancelAndWaitForPendingUpdates();
+  virtual void OnIndicesUpdated(RefreshMode /*mode*/) {}
+
+  // Helpers for implementations of DoFilter and DoSort. Large inputs are split into ranges which
+  // are processed on the process-wide thread pool of orbit_base::ForEachInParallel while the
+  // calling thread waits for the result. `predicate` and `comparator` may read the state of the
+  // DataView, but must not call anything that is restricted to the main thread (like DataManager).
+  // Returns the indices in [0, num_elements) for which `predicate` returns true, in order.
+  // Both check `update` between chunks of elements and stop early once it is canceled, in which
+  // case the result is incomplete and must be discarded.
+  [[nodiscard]] static std::vector<uint64_t> ParallelFilter(
+      size_t num_elements, const std::function<bool(size_t index)>& predicate,
+      const IndicesUpdate* update = nullptr);
+  static void ParallelStableSort(std::vector<uint64_t>* indices,
+                                 const std::function<bool(uint64_t a, uint64_t b)>& comparator,
+                                 const IndicesUpdate* update = nullptr);
+
   FilterCallback filter_callback_;
+  RefreshCallback refresh_callback_;
 
   std::vector<uint64_t> indices_;
   std::vector<SortingOrder> sorting_orders_;
@@ -115,6 +163,13 @@ class DataView {
   static const std::string kMenuActionExportToCsv;
 
   OrbitApp* app_ = nullptr;
+
+ private:
+  std::shared_ptr<IndicesUpdate> current_update_;
+  std::vector<orbit_base::Future<void>> pending_updates_;
+  // Whether the result of a filtering update is still pending, so that updates for sorting have to
+  // filter as well.
+  bool filter_pending_ = false;
 };
 
 #endif  // ORBIT_GL_DATA_VIEW_H_
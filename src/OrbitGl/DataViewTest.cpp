@@ -0,0 +1,94 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "DataView.h"
+
+namespace {
+
+// Exposes the protected sort and filter helpers of DataView.
+class TestDataView : public DataView {
+ public:
+  using DataView::IndicesUpdate;
+  using DataView::ParallelFilter;
+  using DataView::ParallelStableSort;
+};
+
+// Large enough to be split into several ranges.
+constexpr size_t kNumElements = 100'003;
+
+}  // namespace
+
+TEST(DataView, ParallelFilterReturnsMatchingIndicesInOrder) {
+  std::vector<uint64_t> expected;
+  for (size_t i = 0; i < kNumElements; ++i) {
+    if (i % 7 == 3) expected.push_back(i);
+  }
+
+  EXPECT_EQ(TestDataView::ParallelFilter(kNumElements, [](size_t i) { return i % 7 == 3; }),
+            expected);
+  EXPECT_TRUE(TestDataView::ParallelFilter(kNumElements, [](size_t) { return false; }).empty());
+  EXPECT_TRUE(TestDataView::ParallelFilter(0, [](size_t) { return true; }).empty());
+  EXPECT_THAT(TestDataView::ParallelFilter(3, [](size_t) { return true; }),
+              testing::ElementsAre(0, 1, 2));
+}
+
+TEST(DataView, ParallelStableSortKeepsOrderOfEqualElements) {
+  std::vector<uint64_t> keys(kNumElements);
+  for (size_t i = 0; i < kNumElements; ++i) {
+    keys[i] = (i * 7919) % 101;
+  }
+  auto comparator = [&keys](uint64_t a, uint64_t b) { return keys[a] < keys[b]; };
+
+  std::vector<uint64_t> indices(kNumElements);
+  std::iota(indices.rbegin(), indices.rend(), 0);
+  std::vector<uint64_t> expected = indices;
+  std::stable_sort(expected.begin(), expected.end(), comparator);
+
+  TestDataView::ParallelStableSort(&indices, comparator);
+  EXPECT_EQ(indices, expected);
+}
+
+TEST(DataView, ParallelStableSortSmallInputs) {
+  auto comparator = [](uint64_t a, uint64_t b) { return a > b; };
+
+  std::vector<uint64_t> empty;
+  TestDataView::ParallelStableSort(&empty, comparator);
+  EXPECT_TRUE(empty.empty());
+
+  std::vector<uint64_t> indices = {3, 1, 2};
+  TestDataView::ParallelStableSort(&indices, comparator);
+  EXPECT_THAT(indices, testing::ElementsAre(3, 2, 1));
+}
+
+TEST(DataView, ParallelFilterAndSortStopOnceCanceled) {
+  TestDataView::IndicesUpdate update;
+  update.Cancel();
+
+  std::atomic<bool> predicate_called = false;
+  EXPECT_TRUE(TestDataView::ParallelFilter(
+                  kNumElements,
+                  [&predicate_called](size_t /*i*/) {
+                    predicate_called = true;
+                    return true;
+                  },
+                  &update)
+                  .empty());
+  EXPECT_FALSE(predicate_called);
+
+  std::vector<uint64_t> indices(kNumElements);
+  std::iota(indices.begin(), indices.end(), 0);
+  const std::vector<uint64_t> unsorted = indices;
+  TestDataView::ParallelStableSort(
+      &indices, [](uint64_t a, uint64_t b) { return a > b; }, &update);
+  EXPECT_EQ(indices, unsorted);
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "FrameTimeStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "OrbitBase/Logging.h"
+
+void FrameTimeStatistics::AddFrameTimeNs(uint64_t frame_time_ns) {
+  if (max_num_frames_ == 0) return;
+  if (frame_times_ns_.size() < max_num_frames_) {
+    frame_times_ns_.push_back(frame_time_ns);
+    return;
+  }
+  frame_times_ns_[next_index_] = frame_time_ns;
+  next_index_ = (next_index_ + 1) % max_num_frames_;
+}
+
+void FrameTimeStatistics::Clear() {
+  frame_times_ns_.clear();
+  next_index_ = 0;
+}
+
+uint64_t FrameTimeStatistics::GetPercentileNs(double percentile) const {
+  CHECK(percentile >= 0.0 && percentile <= 100.0);
+  if (frame_times_ns_.empty()) return 0;
+
+  // Nearest-rank method.
+  size_t rank = static_cast<size_t>(
+      std::ceil(percentile / 100.0 * static_cast<double>(frame_times_ns_.size())));
+  size_t index = rank == 0 ? 0 : rank - 1;
+
+  std::vector<uint64_t> sorted_frame_times = frame_times_ns_;
+  std::nth_element(sorted_frame_times.begin(), sorted_frame_times.begin() + index,
+                   sorted_frame_times.end());
+  return sorted_frame_times[index];
+}
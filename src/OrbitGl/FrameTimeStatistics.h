@@ -0,0 +1,34 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_GL_FRAME_TIME_STATISTICS_H_
+#define ORBIT_GL_FRAME_TIME_STATISTICS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// FrameTimeStatistics keeps the durations of the most recent frames in a ring buffer and computes
+// percentiles over them. It is used to keep track of the responsiveness of the capture window.
+class FrameTimeStatistics {
+ public:
+  explicit FrameTimeStatistics(size_t max_num_frames = 1024) : max_num_frames_(max_num_frames) {}
+
+  void AddFrameTimeNs(uint64_t frame_time_ns);
+  void Clear();
+
+  [[nodiscard]] size_t GetNumFrames() const { return frame_times_ns_.size(); }
+
+  // Returns the smallest recorded frame time such that at least `percentile` percent of the
+  // recorded frames took at most that long, or 0 if no frame was recorded.
+  [[nodiscard]] uint64_t GetPercentileNs(double percentile) const;
+  [[nodiscard]] uint64_t GetMaxNs() const { return GetPercentileNs(100.0); }
+
+ private:
+  size_t max_num_frames_;
+  size_t next_index_ = 0;
+  std::vector<uint64_t> frame_times_ns_;
+};
+
+#endif  // ORBIT_GL_FRAME_TIME_STATISTICS_H_
@@ -0,0 +1,45 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "FrameTimeStatistics.h"
+
+TEST(FrameTimeStatistics, Empty) {
+  FrameTimeStatistics statistics;
+  EXPECT_EQ(statistics.GetNumFrames(), 0);
+  EXPECT_EQ(statistics.GetPercentileNs(50), 0);
+  EXPECT_EQ(statistics.GetMaxNs(), 0);
+}
+
+TEST(FrameTimeStatistics, Percentiles) {
+  FrameTimeStatistics statistics;
+  // Add 100, 99, ..., 1 so that the order of insertion doesn't match the sorted order.
+  for (uint64_t i = 100; i > 0; --i) {
+    statistics.AddFrameTimeNs(i);
+  }
+  EXPECT_EQ(statistics.GetNumFrames(), 100);
+  EXPECT_EQ(statistics.GetPercentileNs(0), 1);
+  EXPECT_EQ(statistics.GetPercentileNs(50), 50);
+  EXPECT_EQ(statistics.GetPercentileNs(90), 90);
+  EXPECT_EQ(statistics.GetPercentileNs(99), 99);
+  EXPECT_EQ(statistics.GetMaxNs(), 100);
+}
+
+TEST(FrameTimeStatistics, OnlyKeepsMostRecentFrames) {
+  FrameTimeStatistics statistics(4);
+  for (uint64_t i = 1; i <= 10; ++i) {
+    statistics.AddFrameTimeNs(100 * i);
+  }
+  EXPECT_EQ(statistics.GetNumFrames(), 4);
+  EXPECT_EQ(statistics.GetPercentileNs(0), 700);
+  EXPECT_EQ(statistics.GetMaxNs(), 1000);
+
+  statistics.Clear();
+  EXPECT_EQ(statistics.GetNumFrames(), 0);
+  statistics.AddFrameTimeNs(5);
+  EXPECT_EQ(statistics.GetMaxNs(), 5);
+}
@@ -100,8 +100,9 @@ float FrameTrack::GetTextBoxHeight(const TimerInfo& timer_info) const {
   return static_cast<float>(ratio) * GetAverageBoxHeight();
 }
 
-Color FrameTrack::GetTimerColor(const orbit_client_protos::TimerInfo& timer_info,
-                                bool /*is_selected*/, bool /*is_highlighted*/) const {
+Color FrameTrack::GetTimerColor(
+    const orbit_client_protos::TimerInfo& timer_info, bool /*is_selected*/,
+    bool /*is_highlighted*/, const orbit_gl::UpdatePrimitivesContext& /*context*/) const {
   Vec4 min_color(76.f, 175.f, 80.f, 255.f);
   Vec4 max_color(63.f, 81.f, 181.f, 255.f);
   Vec4 warn_color(244.f, 67.f, 54.f, 255.f);
@@ -157,7 +158,7 @@ void FrameTrack::OnTimer(const TimerInfo& timer_info) {
 }
 
 void FrameTrack::SetTimesliceText(const TimerInfo& timer_info, float min_x, float z_offset,
-                                  TextBox* text_box) {
+                                  TextBox* text_box, TextRenderer* text_renderer) {
   if (text_box->GetText().empty()) {
     std::string time = GetPrettyTime(absl::Nanoseconds(timer_info.end() - timer_info.start()));
     text_box->SetElapsedTimeTextLength(time.length());
@@ -171,7 +172,7 @@ void FrameTrack::SetTimesliceText(const TimerInfo& timer_info, float min_x, floa
   const Vec2& box_size = text_box->GetSize();
   float pos_x = std::max(box_pos[0], min_x);
   float max_size = box_pos[0] + box_size[0] - pos_x;
-  text_renderer_->AddTextTrailingCharsPrioritized(
+  text_renderer->AddTextTrailingCharsPrioritized(
       text_box->GetText().c_str(), pos_x, text_box->GetPos()[1] + layout_->GetTextOffset(),
       GlCanvas::kZValueBox + z_offset, kTextWhite, text_box->GetElapsedTimeTextLength(),
       layout_->CalculateZoomedFontSize(), max_size);
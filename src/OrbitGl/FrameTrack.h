@@ -40,7 +40,7 @@ class FrameTrack : public TimerTrack {
   [[nodiscard]] float GetHeaderHeight() const override;
 
   void SetTimesliceText(const orbit_client_protos::TimerInfo& timer, float min_x, float z_offset,
-                        TextBox* text_box) override;
+                        TextBox* text_box, TextRenderer* text_renderer) override;
   [[nodiscard]] std::string GetTooltip() const override;
   [[nodiscard]] std::string GetBoxTooltip(const Batcher& batcher, PickingId id) const override;
 
@@ -51,8 +51,9 @@ class FrameTrack : public TimerTrack {
   [[nodiscard]] std::vector<std::shared_ptr<TimerChain>> GetAllSerializableChains() const override;
 
  protected:
-  [[nodiscard]] Color GetTimerColor(const orbit_client_protos::TimerInfo& timer_info,
-                                    bool is_selected, bool is_highlighted) const override;
+  [[nodiscard]] Color GetTimerColor(
+      const orbit_client_protos::TimerInfo& timer_info, bool is_selected, bool is_highlighted,
+      const orbit_gl::UpdatePrimitivesContext& context) const override;
   [[nodiscard]] float GetHeight() const override;
 
  private:
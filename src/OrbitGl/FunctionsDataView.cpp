@@ -7,11 +7,14 @@
 #include <absl/flags/flag.h>
 #include <absl/strings/str_cat.h>
 #include <absl/strings/str_split.h>
+#include <absl/synchronization/mutex.h>
 #include <stddef.h>
 
 #include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <optional>
+#include <utility>
 
 #include "App.h"
 #include "CoreUtils.h"
@@ -23,16 +26,15 @@
 #include "OrbitClientModel/CaptureData.h"
 #include "absl/strings/str_format.h"
 
-#ifdef _WIN32
-#include "oqpi.hpp"
-
-#define OQPI_USE_DEFAULT
-#endif
-
 using orbit_client_protos::FunctionInfo;
 
 ABSL_DECLARE_FLAG(bool, enable_source_code_view);
 
+namespace {
+// Separates the name from the module of a function in the texts of the search index.
+constexpr const char* kSearchTextSeparator = "\n";
+}  // namespace
+
 FunctionsDataView::FunctionsDataView(OrbitApp* app) : DataView(DataViewType::kFunctions, app) {}
 
 const std::string FunctionsDataView::kUnselectedFunctionString = "";
@@ -132,30 +134,28 @@ std::string FunctionsDataView::GetValue(int row, int column) {
   }
 }
 
+FunctionsDataView::~FunctionsDataView() { CancelAndWaitForPendingUpdates(); }
+
 #define ORBIT_FUNC_SORT(Member)                                                          \
-  [&](int a, int b) {                                                                    \
+  [&](uint64_t a, uint64_t b) {                                                          \
     return orbit_core::Compare(functions_[a]->Member, functions_[b]->Member, ascending); \
   }
 
 #define ORBIT_CUSTOM_FUNC_SORT(Func)                                                   \
-  [&](int a, int b) {                                                                  \
+  [&](uint64_t a, uint64_t b) {                                                        \
     return orbit_core::Compare(Func(*functions_[a]), Func(*functions_[b]), ascending); \
   }
 
-void FunctionsDataView::DoSort() {
-  // TODO(antonrohr) This sorting function can take a lot of time when a large
-  // number of functions is used (several seconds). This function is currently
-  // executed on the main thread and therefore freezes the UI and interrupts the
-  // ssh watchdog signals that are sent to the service. Therefore this should
-  // not be called on the main thread and as soon as this is done the watchdog
-  // timeout should be rolled back from 25 seconds to 10 seconds in
-  // OrbitService.h
-  bool ascending = sorting_orders_[sorting_column_] == SortingOrder::kAscending;
-  std::function<bool(int a, int b)> sorter = nullptr;
-
-  switch (sorting_column_) {
+void FunctionsDataView::SortIndices(std::vector<uint64_t>* indices, int sorting_column,
+                                    bool ascending, const std::vector<bool>& is_selected,
+                                    const IndicesUpdate& update) const {
+  std::function<bool(uint64_t a, uint64_t b)> sorter = nullptr;
+
+  switch (sorting_column) {
     case kColumnSelected:
-      sorter = ORBIT_CUSTOM_FUNC_SORT(app_->IsFunctionSelected);
+      sorter = [&](uint64_t a, uint64_t b) {
+        return orbit_core::Compare<bool>(is_selected[a], is_selected[b], ascending);
+      };
       break;
     case kColumnName:
       sorter = ORBIT_CUSTOM_FUNC_SORT(function_utils::GetDisplayName);
@@ -180,10 +180,12 @@ void FunctionsDataView::DoSort() {
   }
 
   if (sorter) {
-    std::stable_sort(indices_.begin(), indices_.end(), sorter);
+    ParallelStableSort(indices, sorter, &update);
   }
 }
 
+void FunctionsDataView::DoSort() { UpdateIndices(RefreshMode::kOnSort); }
+
 const std::string FunctionsDataView::kMenuActionSelect = "Hook";
 const std::string FunctionsDataView::kMenuActionUnselect = "Unhook";
 const std::string FunctionsDataView::kMenuActionEnableFrameTrack = "Enable frame track(s)";
@@ -265,89 +267,97 @@ void FunctionsDataView::OnContextMenu(const std::string& action, int menu_index,
 }
 
 void FunctionsDataView::DoFilter() {
-  m_FilterTokens = absl::StrSplit(ToLower(filter_), ' ');
-
-#ifdef WIN32
-  ParallelFilter();
-#else
-  // TODO: port parallel filtering
-  std::vector<uint64_t> indices;
-  const std::vector<const FunctionInfo*>& functions(functions_);
-  for (size_t i = 0; i < functions.size(); ++i) {
-    auto& function = functions[i];
-    std::string name = ToLower(function_utils::GetDisplayName(*function)) +
-                       function_utils::GetLoadedModuleName(*function);
-
-    bool match = true;
-
-    for (std::string& filter_token : m_FilterTokens) {
-      if (name.find(filter_token) == std::string::npos) {
-        match = false;
-        break;
-      }
-    }
+  // Tokens never contain kSearchTextSeparator, so each of them has to match the name or the
+  // module of a function, and not text spanning both.
+  m_FilterTokens = absl::StrSplit(ToLower(filter_), absl::ByAnyChar(" \n"));
+  UpdateIndices(RefreshMode::kOnFilter);
+}
 
-    if (match) {
-      indices.push_back(i);
-    }
+void FunctionsDataView::IndexNewFunctions() {
+  absl::MutexLock lock(&search_index_mutex_);
+  for (size_t i = search_index_.GetNumTexts(); i < functions_.size(); ++i) {
+    const FunctionInfo& function = *functions_[i];
+    search_index_.Add(absl::StrCat(ToLower(function_utils::GetDisplayName(function)),
+                                   kSearchTextSeparator,
+                                   function_utils::GetLoadedModuleName(function)));
   }
+}
 
-  indices_ = std::move(indices);
-#endif
+std::vector<uint64_t> FunctionsDataView::FilterIndices(
+    const std::vector<std::string>& filter_tokens, const IndicesUpdate& update) const {
+  absl::ReaderMutexLock lock(&search_index_mutex_);
+  // The tasks of ParallelFilter run on other threads, but the lock is held until they are done.
+  const SubstringSearchIndex& search_index = search_index_;
+  auto matches = [&search_index, &filter_tokens](uint64_t index) {
+    return search_index.ContainsAll(index, filter_tokens);
+  };
+
+  std::optional<std::vector<uint64_t>> candidates = search_index.FindCandidates(filter_tokens);
+  if (!candidates.has_value()) {
+    return ParallelFilter(functions_.size(), matches, &update);
+  }
+
+  const std::vector<uint64_t>& candidate_indices = candidates.value();
+  std::vector<uint64_t> indices = ParallelFilter(
+      candidate_indices.size(),
+      [&matches, &candidate_indices](size_t i) { return matches(candidate_indices[i]); }, &update);
+  // ParallelFilter returns positions in `candidate_indices`.
+  for (uint64_t& index : indices) {
+    index = candidate_indices[index];
+  }
+  return indices;
 }
 
-void FunctionsDataView::ParallelFilter() {
-#ifdef _WIN32
-  const std::vector<const FunctionInfo*>& functions(functions_);
-  const auto prio = oqpi::task_priority::normal;
-  auto numWorkers = oqpi::default_helpers::scheduler().workersCount(prio);
-  // int numWorkers = oqpi::thread::hardware_concurrency();
-  std::vector<std::vector<int>> indicesArray;
-  indicesArray.resize(numWorkers);
-
-  oqpi::default_helpers::parallel_for(
-      "FunctionsDataViewParallelFor", functions.size(),
-      [&](int32_t a_BlockIndex, int32_t a_ElementIndex) {
-        std::vector<int>& result = indicesArray[a_BlockIndex];
-        const std::string& name =
-            ToLower(function_utils::GetDisplayName(*functions[a_ElementIndex]));
-        const std::string& module = function_utils::GetLoadedModuleName(*functions[a_ElementIndex]);
-
-        for (std::string& filterToken : m_FilterTokens) {
-          if (name.find(filterToken) == std::string::npos &&
-              module.find(filterToken) == std::string::npos) {
-            return;
-          }
-        }
-
-        result.push_back(a_ElementIndex);
-      });
-
-  std::set<int> indicesSet;
-  for (std::vector<int>& results : indicesArray) {
-    for (int index : results) {
-      indicesSet.insert(index);
+void FunctionsDataView::UpdateIndices(RefreshMode mode) {
+  // Sorting orders are only initialized by the first call of OnSort.
+  const int sorting_column = sorting_column_;
+  const bool sort =
+      sorting_column >= 0 && static_cast<size_t>(sorting_column) < sorting_orders_.size();
+  const bool ascending = sort && sorting_orders_[sorting_column] == SortingOrder::kAscending;
+  // DataManager can only be queried on the main thread, so the selection state is looked up
+  // before sorting.
+  std::vector<bool> is_selected;
+  if (sort && sorting_column == kColumnSelected) {
+    is_selected.reserve(functions_.size());
+    for (const FunctionInfo* function : functions_) {
+      is_selected.push_back(app_->IsFunctionSelected(*function));
     }
   }
 
-  indices_.clear();
-  for (int i : indicesSet) {
-    indices_.push_back(i);
+  SortIndicesFunction sort_indices = nullptr;
+  if (sort) {
+    sort_indices = [this, sorting_column, ascending, is_selected = std::move(is_selected)](
+                       std::vector<uint64_t>* indices, const IndicesUpdate& update) {
+      SortIndices(indices, sorting_column, ascending, is_selected, update);
+    };
   }
-#endif
+  UpdateIndicesAsync(
+      mode,
+      [this, filter_tokens = m_FilterTokens](const IndicesUpdate& update) {
+        IndexNewFunctions();
+        return FilterIndices(filter_tokens, update);
+      },
+      std::move(sort_indices));
 }
 
 void FunctionsDataView::AddFunctions(
     std::vector<const orbit_client_protos::FunctionInfo*> functions) {
+  // Pending updates read functions_ on other threads.
+  CancelAndWaitForPendingUpdates();
+  // The new functions are added to search_index_ by the update triggered by OnDataChanged.
+  // indices_ stays valid as functions are only appended. It is replaced when the update
+  // triggered by OnDataChanged is done.
   functions_.insert(functions_.end(), functions.begin(), functions.end());
-  indices_.resize(functions_.size());
-  for (size_t i = 0; i < indices_.size(); ++i) {
-    indices_[i] = i;
-  }
   OnDataChanged();
 }
 
 void FunctionsDataView::ClearFunctions() {
+  CancelAndWaitForPendingUpdates();
   functions_.clear();
+  {
+    absl::MutexLock lock(&search_index_mutex_);
+    search_index_.Clear();
+  }
+  indices_.clear();
   OnDataChanged();
 }
@@ -7,11 +7,13 @@
 
 #include <absl/flags/declare.h>
 #include <absl/flags/flag.h>
+#include <absl/synchronization/mutex.h>
 
 #include <string>
 #include <vector>
 
 #include "DataView.h"
+#include "SubstringSearchIndex.h"
 #include "capture_data.pb.h"
 
 class OrbitApp;
@@ -19,6 +21,7 @@ class OrbitApp;
 class FunctionsDataView : public DataView {
  public:
   explicit FunctionsDataView(OrbitApp* app);
+  ~FunctionsDataView() override;
 
   static const std::string kUnselectedFunctionString;
   static const std::string kSelectedFunctionString;
@@ -35,13 +38,13 @@ class FunctionsDataView : public DataView {
 
   void OnContextMenu(const std::string& action, int menu_index,
                      const std::vector<int>& item_indices) override;
+  // Both wait for the pending sorting and filtering to be canceled.
   void AddFunctions(std::vector<const orbit_client_protos::FunctionInfo*> functions);
   void ClearFunctions();
 
  protected:
   void DoSort() override;
   void DoFilter() override;
-  void ParallelFilter();
   [[nodiscard]] const orbit_client_protos::FunctionInfo* GetFunction(int row) const {
     return functions_[indices_[row]];
   }
@@ -71,7 +74,20 @@ class FunctionsDataView : public DataView {
                                              const orbit_client_protos::FunctionInfo& function);
   static bool ShouldShowFrameTrackIcon(OrbitApp* app,
                                        const orbit_client_protos::FunctionInfo& function);
+
+  // Updates add the texts of new functions to search_index_ before filtering.
+  void UpdateIndices(RefreshMode mode);
+  void IndexNewFunctions();
+  [[nodiscard]] std::vector<uint64_t> FilterIndices(const std::vector<std::string>& filter_tokens,
+                                                    const IndicesUpdate& update) const;
+  void SortIndices(std::vector<uint64_t>* indices, int sorting_column, bool ascending,
+                   const std::vector<bool>& is_selected, const IndicesUpdate& update) const;
+
   std::vector<const orbit_client_protos::FunctionInfo*> functions_;
+  // Holds the lower case display name and the module name of each function in functions_ that
+  // was indexed by an update so far.
+  mutable absl::Mutex search_index_mutex_;
+  SubstringSearchIndex search_index_ ABSL_GUARDED_BY(search_index_mutex_);
 };
 
 #endif  // ORBIT_GL_FUNCTIONS_DATA_VIEW_H_
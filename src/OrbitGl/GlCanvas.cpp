@@ -397,6 +397,7 @@ void GlCanvas::Render(int width, int height) {
   }
 
   redraw_requested_ = false;
+  Timer render_timer;
   ui_batcher_.StartNewFrame();
 
   PrepareGlState();
@@ -424,6 +425,8 @@ void GlCanvas::Render(int width, int height) {
     im_gui_active_ = ImGui::IsAnyItemActive();
   }
 
+  render_time_statistics_.AddFrameTimeNs(render_timer.ElapsedNanos());
+
   PostRender();
 
   picking_ = false;
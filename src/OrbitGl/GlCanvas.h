@@ -18,6 +18,7 @@
 #include "AccessibleTimeGraph.h"
 #include "Batcher.h"
 #include "CoreMath.h"
+#include "FrameTimeStatistics.h"
 #include "GlUtils.h"
 #include "ImGuiOrbit.h"
 #include "OrbitAccessibility/AccessibleInterface.h"
@@ -42,6 +43,8 @@ class GlCanvas {
   virtual void Render(int width, int height);
   virtual void PreRender(){};
   virtual void PostRender() {}
+  // Called by the widget on the UI thread before the canvas draws or handles input or a menu action.
+  virtual void PreEvent() {}
 
   [[nodiscard]] virtual int GetWidth() const;
   [[nodiscard]] virtual int GetHeight() const;
@@ -131,6 +134,10 @@ class GlCanvas {
   [[nodiscard]] virtual bool IsRedrawNeeded() const;
   void RequestRedraw() { redraw_requested_ = true; }
 
+  [[nodiscard]] const FrameTimeStatistics& GetRenderTimeStatistics() const {
+    return render_time_statistics_;
+  }
+
   [[nodiscard]] bool GetIsMouseOver() const { return is_mouse_over_; }
   void SetIsMouseOver(bool value) { is_mouse_over_ = value; }
 
@@ -205,6 +212,7 @@ class GlCanvas {
   double ref_time_click_;
   TextRenderer text_renderer_;
   Timer update_timer_;
+  FrameTimeStatistics render_time_statistics_;
   PickingManager picking_manager_;
   bool picking_;
   bool double_clicking_;
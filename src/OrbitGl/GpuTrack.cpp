@@ -68,7 +68,6 @@ std::string MapGpuTimelineToTrackLabel(std::string_view timeline) {
 GpuTrack::GpuTrack(CaptureViewElement* parent, TimeGraph* time_graph, TimeGraphLayout* layout,
                    uint64_t timeline_hash, OrbitApp* app, const CaptureData* capture_data)
     : TimerTrack(parent, time_graph, layout, app, capture_data) {
-  text_renderer_ = time_graph->GetTextRenderer();
   timeline_hash_ = timeline_hash;
   string_manager_ = app->GetStringManager();
 
@@ -95,18 +94,20 @@ void GpuTrack::OnTimer(const orbit_client_protos::TimerInfo& timer_info) {
   TimerTrack::OnTimer(timer_info);
 }
 
-bool GpuTrack::IsTimerActive(const TimerInfo& timer_info) const {
-  bool is_same_tid_as_selected = timer_info.thread_id() == app_->selected_thread_id();
+bool GpuTrack::IsTimerActive(const TimerInfo& timer_info,
+                             const orbit_gl::UpdatePrimitivesContext& context) const {
+  bool is_same_tid_as_selected = timer_info.thread_id() == context.selected_thread_id;
   // We do not properly track the PID for GPU jobs and we still want to show
   // all jobs as active when no thread is selected, so this logic is a bit
   // different than SchedulerTrack::IsTimerActive.
-  bool no_thread_selected = app_->selected_thread_id() == orbit_base::kAllProcessThreadsTid;
+  bool no_thread_selected = context.selected_thread_id == orbit_base::kAllProcessThreadsTid;
 
   return is_same_tid_as_selected || no_thread_selected;
 }
 
 Color GpuTrack::GetTimerColor(const TimerInfo& timer_info, bool is_selected,
-                              bool is_highlighted) const {
+                              bool is_highlighted,
+                              const orbit_gl::UpdatePrimitivesContext& context) const {
   const Color kInactiveColor(100, 100, 100, 255);
   const Color kSelectionColor(0, 128, 255, 255);
   if (is_highlighted) {
@@ -115,7 +116,7 @@ Color GpuTrack::GetTimerColor(const TimerInfo& timer_info, bool is_selected,
   if (is_selected) {
     return kSelectionColor;
   }
-  if (!IsTimerActive(timer_info)) {
+  if (!IsTimerActive(timer_info, context)) {
     return kInactiveColor;
   }
   if (timer_info.has_color()) {
@@ -204,7 +205,7 @@ bool GpuTrack::TimerFilter(const TimerInfo& timer_info) const {
 }
 
 void GpuTrack::SetTimesliceText(const TimerInfo& timer_info, float min_x, float z_offset,
-                                TextBox* text_box) {
+                                TextBox* text_box, TextRenderer* text_renderer) {
   if (text_box->GetText().empty()) {
     std::string time = GetPrettyTime(absl::Nanoseconds(timer_info.end() - timer_info.start()));
 
@@ -224,7 +225,7 @@ void GpuTrack::SetTimesliceText(const TimerInfo& timer_info, float min_x, float
   const Vec2& box_size = text_box->GetSize();
   float pos_x = std::max(box_pos[0], min_x);
   float max_size = box_pos[0] + box_size[0] - pos_x;
-  text_renderer_->AddTextTrailingCharsPrioritized(
+  text_renderer->AddTextTrailingCharsPrioritized(
       text_box->GetText().c_str(), pos_x, text_box->GetPos()[1] + layout_->GetTextOffset(),
       GlCanvas::kZValueBox + z_offset, kTextWhite, text_box->GetElapsedTimeTextLength(),
       layout_->CalculateZoomedFontSize(), max_size);
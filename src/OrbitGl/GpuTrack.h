@@ -53,12 +53,14 @@ class GpuTrack : public TimerTrack {
   }
 
  protected:
-  [[nodiscard]] bool IsTimerActive(const orbit_client_protos::TimerInfo& timer) const override;
-  [[nodiscard]] Color GetTimerColor(const orbit_client_protos::TimerInfo& timer, bool is_selected,
-                                    bool is_highlighted) const override;
+  [[nodiscard]] bool IsTimerActive(const orbit_client_protos::TimerInfo& timer,
+                                   const orbit_gl::UpdatePrimitivesContext& context) const override;
+  [[nodiscard]] Color GetTimerColor(
+      const orbit_client_protos::TimerInfo& timer, bool is_selected, bool is_highlighted,
+      const orbit_gl::UpdatePrimitivesContext& context) const override;
   [[nodiscard]] bool TimerFilter(const orbit_client_protos::TimerInfo& timer) const override;
   void SetTimesliceText(const orbit_client_protos::TimerInfo& timer, float min_x, float z_offset,
-                        TextBox* text_box) override;
+                        TextBox* text_box, TextRenderer* text_renderer) override;
   [[nodiscard]] std::string GetBoxTooltip(const Batcher& batcher, PickingId id) const override;
 
  private:
@@ -23,8 +23,10 @@ GraphTrack::GraphTrack(CaptureViewElement* parent, TimeGraph* time_graph, TimeGr
   SetLabel(name);
 }
 
-void GraphTrack::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
-                                  PickingMode picking_mode, float z_offset) {
+void GraphTrack::UpdatePrimitives(Batcher* batcher,
+                                  const orbit_gl::UpdatePrimitivesContext& /*context*/,
+                                  uint64_t min_tick, uint64_t max_tick, PickingMode picking_mode,
+                                  float z_offset) {
   GlCanvas* canvas = time_graph_->GetCanvas();
 
   float track_width = canvas->GetWorldWidth();
@@ -50,6 +50,8 @@ LiveFunctionsDataView::LiveFunctionsDataView(
   LiveFunctionsDataView::OnDataChanged();
 }
 
+LiveFunctionsDataView::~LiveFunctionsDataView() { CancelAndWaitForPendingUpdates(); }
+
 const std::vector<DataView::Column>& LiveFunctionsDataView::GetColumns() {
   static const std::vector<Column> columns = [] {
     std::vector<Column> columns;
@@ -133,62 +135,137 @@ void LiveFunctionsDataView::OnSelect(const std::vector<int>& rows) {
   [&](uint64_t a, uint64_t b) {                                                            \
     return orbit_core::Compare(functions.at(a).Member, functions.at(b).Member, ascending); \
   }
-#define ORBIT_STAT_SORT(Member)                                                         \
-  [&](uint64_t a, uint64_t b) {                                                         \
-    const FunctionStats& stats_a = app_->GetCaptureData().GetFunctionStatsOrDefault(a); \
-    const FunctionStats& stats_b = app_->GetCaptureData().GetFunctionStatsOrDefault(b); \
-    return orbit_core::Compare(stats_a.Member, stats_b.Member, ascending);              \
-  }
+#define ORBIT_STAT(Member) [](const FunctionStats& stats) { return stats.Member; }
 #define ORBIT_CUSTOM_FUNC_SORT(Func)                                                     \
   [&](uint64_t a, uint64_t b) {                                                          \
     return orbit_core::Compare(Func(functions.at(a)), Func(functions.at(b)), ascending); \
   }
 
-void LiveFunctionsDataView::DoSort() {
+void LiveFunctionsDataView::DoSort() { UpdateIndices(RefreshMode::kOnSort); }
+
+void LiveFunctionsDataView::UpdateIndices(RefreshMode mode) {
   if (!app_->HasCaptureData()) {
     CHECK(functions_.empty());
     return;
   }
-  bool ascending = sorting_orders_[sorting_column_] == SortingOrder::kAscending;
-  std::function<bool(uint64_t a, uint64_t b)> sorter = nullptr;
+  // Sorting orders are only initialized by the first call of OnSort.
+  const int sorting_column = sorting_column_;
+  const bool sort =
+      sorting_column >= 0 && static_cast<size_t>(sorting_column) < sorting_orders_.size();
+  const bool ascending = sort && sorting_orders_[sorting_column] == SortingOrder::kAscending;
+
+  // DataManager can only be queried on the main thread, and the statistics change on the main
+  // thread while capturing, so both are looked up before sorting.
+  absl::flat_hash_set<uint64_t> selected_function_ids;
+  std::function<uint64_t(const FunctionStats&)> get_stat = nullptr;
+  if (sort) {
+    switch (sorting_column) {
+      case kColumnSelected:
+        for (const auto& [function_id, function] : functions_) {
+          if (app_->IsFunctionSelected(function)) selected_function_ids.insert(function_id);
+        }
+        break;
+      case kColumnCount:
+        get_stat = ORBIT_STAT(count());
+        break;
+      case kColumnTimeTotal:
+        get_stat = ORBIT_STAT(total_time_ns());
+        break;
+      case kColumnTimeAvg:
+        get_stat = ORBIT_STAT(average_time_ns());
+        break;
+      case kColumnTimeMin:
+        get_stat = ORBIT_STAT(min_ns());
+        break;
+      case kColumnTimeMax:
+        get_stat = ORBIT_STAT(max_ns());
+        break;
+      default:
+        break;
+    }
+  }
+  absl::flat_hash_map<uint64_t, uint64_t> stats;
+  if (get_stat) {
+    const CaptureData& capture_data = app_->GetCaptureData();
+    for (const auto& [function_id, function] : functions_) {
+      stats.emplace(function_id, get_stat(capture_data.GetFunctionStatsOrDefault(function_id)));
+    }
+  }
 
-  const absl::flat_hash_map<uint64_t, FunctionInfo>& functions = functions_;
+  SortIndicesFunction sort_indices = nullptr;
+  if (sort) {
+    sort_indices = [this, sorting_column, ascending,
+                    selected_function_ids = std::move(selected_function_ids),
+                    stats = std::move(stats)](std::vector<uint64_t>* indices,
+                                              const IndicesUpdate& update) {
+      const absl::flat_hash_map<uint64_t, FunctionInfo>& functions = functions_;
+      std::function<bool(uint64_t a, uint64_t b)> sorter = nullptr;
+
+      switch (sorting_column) {
+        case kColumnSelected:
+          sorter = [&](uint64_t a, uint64_t b) {
+            return orbit_core::Compare(selected_function_ids.contains(a),
+                                       selected_function_ids.contains(b), ascending);
+          };
+          break;
+        case kColumnName:
+          sorter = ORBIT_CUSTOM_FUNC_SORT(function_utils::GetDisplayName);
+          break;
+        case kColumnCount:
+        case kColumnTimeTotal:
+        case kColumnTimeAvg:
+        case kColumnTimeMin:
+        case kColumnTimeMax:
+          sorter = [&](uint64_t a, uint64_t b) {
+            return orbit_core::Compare(stats.at(a), stats.at(b), ascending);
+          };
+          break;
+        case kColumnModule:
+          sorter = ORBIT_CUSTOM_FUNC_SORT(function_utils::GetLoadedModuleName);
+          break;
+        case kColumnAddress:
+          sorter = ORBIT_FUNC_SORT(address());
+          break;
+        default:
+          break;
+      }
 
-  switch (sorting_column_) {
-    case kColumnSelected:
-      sorter = ORBIT_CUSTOM_FUNC_SORT(app_->IsFunctionSelected);
-      break;
-    case kColumnName:
-      sorter = ORBIT_CUSTOM_FUNC_SORT(function_utils::GetDisplayName);
-      break;
-    case kColumnCount:
-      sorter = ORBIT_STAT_SORT(count());
-      break;
-    case kColumnTimeTotal:
-      sorter = ORBIT_STAT_SORT(total_time_ns());
-      break;
-    case kColumnTimeAvg:
-      sorter = ORBIT_STAT_SORT(average_time_ns());
-      break;
-    case kColumnTimeMin:
-      sorter = ORBIT_STAT_SORT(min_ns());
-      break;
-    case kColumnTimeMax:
-      sorter = ORBIT_STAT_SORT(max_ns());
-      break;
-    case kColumnModule:
-      sorter = ORBIT_CUSTOM_FUNC_SORT(function_utils::GetLoadedModuleName);
-      break;
-    case kColumnAddress:
-      sorter = ORBIT_FUNC_SORT(address());
-      break;
-    default:
-      break;
+      if (sorter) {
+        ParallelStableSort(indices, sorter, &update);
+      }
+    };
   }
 
-  if (sorter) {
-    std::stable_sort(indices_.begin(), indices_.end(), sorter);
+  std::vector<std::string> tokens = absl::StrSplit(ToLower(filter_), ' ');
+  std::vector<const std::pair<const uint64_t, FunctionInfo>*> entries;
+  entries.reserve(functions_.size());
+  for (const auto& entry : functions_) {
+    entries.push_back(&entry);
   }
+  auto filter_indices = [tokens = std::move(tokens),
+                         entries = std::move(entries)](const IndicesUpdate& update) {
+    std::vector<uint64_t> indices = ParallelFilter(
+        entries.size(),
+        [&entries, &tokens](size_t i) {
+          std::string name = ToLower(function_utils::GetDisplayName(entries[i]->second));
+
+          for (const std::string& filter_token : tokens) {
+            if (name.find(filter_token) == std::string::npos) {
+              return false;
+            }
+          }
+          return true;
+        },
+        &update);
+    // ParallelFilter returns positions in `entries`, the indices of this DataView are function
+    // ids.
+    for (uint64_t& index : indices) {
+      index = entries[index]->first;
+    }
+    return indices;
+  };
+
+  UpdateIndicesAsync(mode, std::move(filter_indices), std::move(sort_indices));
 }
 
 const std::string LiveFunctionsDataView::kMenuActionSelect = "Hook";
@@ -356,35 +433,10 @@ void LiveFunctionsDataView::OnContextMenu(const std::string& action, int menu_in
   }
 }
 
-void LiveFunctionsDataView::DoFilter() {
-  if (!app_->HasCaptureData()) {
-    CHECK(functions_.empty());
-    return;
-  }
-  std::vector<uint64_t> indices;
-
-  std::vector<std::string> tokens = absl::StrSplit(ToLower(filter_), ' ');
-
-  for (const auto& entry : functions_) {
-    uint64_t function_id = entry.first;
-    const FunctionInfo& function = entry.second;
-    std::string name = ToLower(function_utils::GetDisplayName(function));
-
-    bool match = true;
-
-    for (std::string& filter_token : tokens) {
-      if (name.find(filter_token) == std::string::npos) {
-        match = false;
-        break;
-      }
-    }
-
-    if (match) {
-      indices.push_back(function_id);
-    }
-  }
+void LiveFunctionsDataView::DoFilter() { UpdateIndices(RefreshMode::kOnFilter); }
 
-  indices_ = std::move(indices);
+void LiveFunctionsDataView::OnIndicesUpdated(RefreshMode mode) {
+  if (mode != RefreshMode::kOnFilter) return;
 
   // Filter drawn textboxes
   absl::flat_hash_set<uint64_t> visible_function_ids;
@@ -395,6 +447,8 @@ void LiveFunctionsDataView::DoFilter() {
 }
 
 void LiveFunctionsDataView::OnDataChanged() {
+  // Pending updates read functions_ on other threads.
+  CancelAndWaitForPendingUpdates();
   functions_.clear();
   indices_.clear();
 
@@ -27,6 +27,7 @@ class LiveFunctionsDataView : public DataView {
  public:
   explicit LiveFunctionsDataView(LiveFunctionsController* live_functions, OrbitApp* app,
                                  orbit_metrics_uploader::MetricsUploader* metrics_uploader);
+  ~LiveFunctionsDataView() override;
 
   const std::vector<Column>& GetColumns() override;
   int GetDefaultSortingColumn() override { return kColumnCount; }
@@ -52,6 +53,7 @@ class LiveFunctionsDataView : public DataView {
  protected:
   void DoFilter() override;
   void DoSort() override;
+  void OnIndicesUpdated(RefreshMode mode) override;
   [[nodiscard]] uint64_t GetInstrumentedFunctionId(uint32_t row) const;
   [[nodiscard]] const orbit_client_protos::FunctionInfo& GetInstrumentedFunction(
       uint32_t row) const;
@@ -88,6 +90,8 @@ class LiveFunctionsDataView : public DataView {
   static const std::string kMenuActionDisableFrameTrack;
 
  private:
+  void UpdateIndices(RefreshMode mode);
+
   orbit_metrics_uploader::MetricsUploader* metrics_uploader_;
 };
 
@@ -24,7 +24,7 @@ void ManualInstrumentationManager::RemoveAsyncTimerListener(AsyncTimerInfoListen
   async_timer_info_listeners_.erase(listener);
 }
 
-orbit_api::Event ManualInstrumentationManager::ApiEventFromTimerInfo(
+orbit_api::EncodedEvent ManualInstrumentationManager::EncodedEventFromTimerInfo(
     const orbit_client_protos::TimerInfo& timer_info) {
   // On x64 Linux, 6 registers are used for integer argument passing.
   // Manual instrumentation uses those registers to encode orbit_api::Event
@@ -37,8 +37,19 @@ orbit_api::Event ManualInstrumentationManager::ApiEventFromTimerInfo(
   uint64_t arg_3 = timer_info.registers(3);
   uint64_t arg_4 = timer_info.registers(4);
   uint64_t arg_5 = timer_info.registers(5);
-  orbit_api::EncodedEvent encoded_event(arg_0, arg_1, arg_2, arg_3, arg_4, arg_5);
-  return encoded_event.event;
+  return orbit_api::EncodedEvent(arg_0, arg_1, arg_2, arg_3, arg_4, arg_5);
+}
+
+orbit_api::Event ManualInstrumentationManager::ApiEventFromTimerInfo(
+    const orbit_client_protos::TimerInfo& timer_info) {
+  return EncodedEventFromTimerInfo(timer_info).event;
+}
+
+std::string ManualInstrumentationManager::GetApiEventName(
+    const orbit_client_protos::TimerInfo& timer_info) const {
+  orbit_api::EncodedEvent encoded_event = EncodedEventFromTimerInfo(timer_info);
+  if (!encoded_event.HasInternedName()) return encoded_event.event.name;
+  return interned_strings_->Get(encoded_event.InternedNameKey()).value_or("");
 }
 
 void ManualInstrumentationManager::ProcessAsyncTimerDeprecated(
@@ -51,22 +62,22 @@ void ManualInstrumentationManager::ProcessAsyncTimerDeprecated(
     auto it = async_timer_info_start_by_id_.find(event_id);
     if (it != async_timer_info_start_by_id_.end()) {
       const TimerInfo& start_timer_info = it->second;
-      orbit_api::Event start_event = ApiEventFromTimerInfo(start_timer_info);
+      const std::string name = GetApiEventName(start_timer_info);
 
       TimerInfo async_span = start_timer_info;
       async_span.set_end(timer_info.end());
       absl::MutexLock lock(&mutex_);
-      for (auto* listener : async_timer_info_listeners_) (*listener)(start_event.name, async_span);
+      for (auto* listener : async_timer_info_listeners_) (*listener)(name, async_span);
     }
   }
 }
 
 void ManualInstrumentationManager::ProcessAsyncTimer(
     const orbit_client_protos::TimerInfo& timer_info) {
-  orbit_api::Event start_event = ApiEventFromTimerInfo(timer_info);
+  const std::string name = GetApiEventName(timer_info);
   absl::MutexLock lock(&mutex_);
   for (auto* listener : async_timer_info_listeners_) {
-    (*listener)(start_event.name, timer_info);
+    (*listener)(name, timer_info);
   }
 }
 
@@ -20,7 +20,10 @@
 
 class ManualInstrumentationManager {
  public:
-  ManualInstrumentationManager() = default;
+  // `interned_strings` holds the strings received during the capture, which include the interned
+  // names of Orbit API events.
+  explicit ManualInstrumentationManager(const StringManager* interned_strings)
+      : interned_strings_{interned_strings} {}
 
   using AsyncTimerInfoListener = std::function<void(
       const std::string& name, const orbit_client_protos::TimerInfo& timer_info)>;
@@ -35,8 +38,15 @@ class ManualInstrumentationManager {
   }
   [[nodiscard]] static orbit_api::Event ApiEventFromTimerInfo(
       const orbit_client_protos::TimerInfo& timer_info);
+  // Returns the name of the scope or track of a manual instrumentation timer, which is either
+  // encoded in the timer itself or, if it was interned, one of `interned_strings`.
+  [[nodiscard]] std::string GetApiEventName(const orbit_client_protos::TimerInfo& timer_info) const;
 
  private:
+  [[nodiscard]] static orbit_api::EncodedEvent EncodedEventFromTimerInfo(
+      const orbit_client_protos::TimerInfo& timer_info);
+
+  const StringManager* interned_strings_;
   absl::flat_hash_set<AsyncTimerInfoListener*> async_timer_info_listeners_;
   absl::flat_hash_map<uint32_t, orbit_client_protos::TimerInfo> async_timer_info_start_by_id_;
   StringManager string_manager_;
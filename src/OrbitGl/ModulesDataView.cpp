@@ -25,6 +25,8 @@ ABSL_DECLARE_FLAG(bool, enable_frame_pointer_validator);
 
 ModulesDataView::ModulesDataView(OrbitApp* app) : DataView(DataViewType::kModules, app) {}
 
+ModulesDataView::~ModulesDataView() { CancelAndWaitForPendingUpdates(); }
+
 const std::vector<DataView::Column>& ModulesDataView::GetColumns() {
   static const std::vector<Column> columns = [] {
     std::vector<Column> columns;
@@ -41,7 +43,7 @@ const std::vector<DataView::Column>& ModulesDataView::GetColumns() {
 
 std::string ModulesDataView::GetValue(int row, int col) {
   const ModuleData* module = GetModule(row);
-  const ModuleInMemory* memory_space = module_memory_.at(module);
+  const ModuleInMemory& memory_space = module_memory_.at(module);
 
   switch (col) {
     case kColumnName:
@@ -49,7 +51,7 @@ std::string ModulesDataView::GetValue(int row, int col) {
     case kColumnPath:
       return module->file_path();
     case kColumnAddressRange:
-      return memory_space->FormattedAddressRange();
+      return memory_space.FormattedAddressRange();
     case kColumnFileSize:
       return GetPrettySize(module->file_size());
     case kColumnLoaded:
@@ -60,43 +62,90 @@ std::string ModulesDataView::GetValue(int row, int col) {
 }
 
 #define ORBIT_PROC_SORT(Member)                                                      \
-  [&](int a, int b) {                                                                \
+  [&](uint64_t a, uint64_t b) {                                                      \
     return orbit_core::Compare(modules_[a]->Member, modules_[b]->Member, ascending); \
   }
 
-#define ORBIT_MODULE_SPACE_SORT(Member)                                            \
-  [&](int a, int b) {                                                              \
-    return orbit_core::Compare(module_memory_.at(modules_[a])->Member,             \
-                               module_memory_.at(modules_[b])->Member, ascending); \
+#define ORBIT_MODULE_SPACE_SORT(Member)                                          \
+  [&](uint64_t a, uint64_t b) {                                                  \
+    return orbit_core::Compare(module_memory_.at(modules_[a]).Member,            \
+                               module_memory_.at(modules_[b]).Member, ascending); \
   }
 
-void ModulesDataView::DoSort() {
-  bool ascending = sorting_orders_[sorting_column_] == SortingOrder::kAscending;
-  std::function<bool(int a, int b)> sorter = nullptr;
-
-  switch (sorting_column_) {
-    case kColumnName:
-      sorter = ORBIT_PROC_SORT(name());
-      break;
-    case kColumnPath:
-      sorter = ORBIT_PROC_SORT(file_path());
-      break;
-    case kColumnAddressRange:
-      sorter = ORBIT_MODULE_SPACE_SORT(start());
-      break;
-    case kColumnFileSize:
-      sorter = ORBIT_PROC_SORT(file_size());
-      break;
-    case kColumnLoaded:
-      sorter = ORBIT_PROC_SORT(is_loaded());
-      break;
-    default:
-      break;
+void ModulesDataView::DoSort() { UpdateIndices(RefreshMode::kOnSort); }
+
+void ModulesDataView::UpdateIndices(RefreshMode mode) {
+  // Sorting orders are only initialized by the first call of OnSort.
+  const int sorting_column = sorting_column_;
+  const bool sort =
+      sorting_column >= 0 && static_cast<size_t>(sorting_column) < sorting_orders_.size();
+  const bool ascending = sort && sorting_orders_[sorting_column] == SortingOrder::kAscending;
+  // Modules are loaded on the main thread, so whether they are loaded is looked up before
+  // sorting. Otherwise the order could change while sorting.
+  std::vector<bool> is_loaded;
+  if (sort && sorting_column == kColumnLoaded) {
+    is_loaded.reserve(modules_.size());
+    for (const ModuleData* module : modules_) {
+      is_loaded.push_back(module->is_loaded());
+    }
   }
 
-  if (sorter) {
-    std::stable_sort(indices_.begin(), indices_.end(), sorter);
+  SortIndicesFunction sort_indices = nullptr;
+  if (sort) {
+    sort_indices = [this, sorting_column, ascending, is_loaded = std::move(is_loaded)](
+                       std::vector<uint64_t>* indices, const IndicesUpdate& update) {
+      std::function<bool(uint64_t a, uint64_t b)> sorter = nullptr;
+
+      switch (sorting_column) {
+        case kColumnName:
+          sorter = ORBIT_PROC_SORT(name());
+          break;
+        case kColumnPath:
+          sorter = ORBIT_PROC_SORT(file_path());
+          break;
+        case kColumnAddressRange:
+          sorter = ORBIT_MODULE_SPACE_SORT(start());
+          break;
+        case kColumnFileSize:
+          sorter = ORBIT_PROC_SORT(file_size());
+          break;
+        case kColumnLoaded:
+          sorter = [&](uint64_t a, uint64_t b) {
+            return orbit_core::Compare<bool>(is_loaded[a], is_loaded[b], ascending);
+          };
+          break;
+        default:
+          break;
+      }
+
+      if (sorter) {
+        ParallelStableSort(indices, sorter, &update);
+      }
+    };
   }
+
+  std::vector<std::string> tokens = absl::StrSplit(ToLower(filter_), ' ');
+  auto filter_indices = [this, tokens = std::move(tokens)](const IndicesUpdate& update) {
+    return ParallelFilter(
+        modules_.size(),
+        [this, &tokens](size_t i) {
+          const ModuleData* module = modules_[i];
+          const ModuleInMemory& memory_space = module_memory_.at(module);
+          std::string module_string =
+              absl::StrFormat("%s %s", memory_space.FormattedAddressRange(),
+                              absl::AsciiStrToLower(module->file_path()));
+
+          for (const std::string& filter_token : tokens) {
+            if (module_string.find(filter_token) == std::string::npos) {
+              return false;
+            }
+          }
+          return true;
+        },
+        &update);
+  };
+
+  UpdateIndicesAsync(mode, std::move(filter_indices), std::move(sort_indices));
 }
 
 const std::string ModulesDataView::kMenuActionLoadSymbols = "Load Symbols";
@@ -164,41 +213,18 @@ void ModulesDataView::OnDoubleClicked(int index) {
   }
 }
 
-void ModulesDataView::DoFilter() {
-  std::vector<uint64_t> indices;
-  std::vector<std::string> tokens = absl::StrSplit(ToLower(filter_), ' ');
-
-  for (size_t i = 0; i < modules_.size(); ++i) {
-    const ModuleData* module = modules_[i];
-    const ModuleInMemory* memory_space = module_memory_.at(module);
-    std::string module_string = absl::StrFormat("%s %s", memory_space->FormattedAddressRange(),
-                                                absl::AsciiStrToLower(module->file_path()));
-
-    bool match = true;
-
-    for (std::string& filter_token : tokens) {
-      if (module_string.find(filter_token) == std::string::npos) {
-        match = false;
-        break;
-      }
-    }
-
-    if (match) {
-      indices.push_back(i);
-    }
-  }
-
-  indices_ = std::move(indices);
-}
+void ModulesDataView::DoFilter() { UpdateIndices(RefreshMode::kOnFilter); }
 
 void ModulesDataView::UpdateModules(const ProcessData* process) {
+  // Pending updates read modules_ and module_memory_ on other threads.
+  CancelAndWaitForPendingUpdates();
   modules_.clear();
   module_memory_.clear();
   for (const auto& [module_path, module_in_memory] : process->GetMemoryMap()) {
     ModuleData* module =
         app_->GetMutableModuleByPathAndBuildId(module_path, module_in_memory.build_id());
     modules_.push_back(module);
-    module_memory_[module] = &module_in_memory;
+    module_memory_.insert_or_assign(module, module_in_memory);
   }
 
   indices_.resize(modules_.size());
@@ -20,6 +20,7 @@ class OrbitApp;
 class ModulesDataView : public DataView {
  public:
   explicit ModulesDataView(OrbitApp* app);
+  ~ModulesDataView() override;
 
   const std::vector<Column>& GetColumns() override;
   int GetDefaultSortingColumn() override { return kColumnFileSize; }
@@ -44,9 +45,12 @@ class ModulesDataView : public DataView {
 
  private:
   [[nodiscard]] ModuleData* GetModule(uint32_t row) const { return modules_[indices_[row]]; }
+  void UpdateIndices(RefreshMode mode);
 
   std::vector<ModuleData*> modules_;
-  absl::flat_hash_map<const ModuleData*, const ModuleInMemory*> module_memory_;
+  // Holds copies, as updates of the indices read them on other threads while the memory map of
+  // the process can change.
+  absl::flat_hash_map<const ModuleData*, ModuleInMemory> module_memory_;
 
   enum ColumnIndex {
     kColumnName,
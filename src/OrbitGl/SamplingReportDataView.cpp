@@ -38,6 +38,8 @@ ABSL_DECLARE_FLAG(bool, enable_source_code_view);
 SamplingReportDataView::SamplingReportDataView(OrbitApp* app)
     : DataView(DataViewType::kSampling, app), callstack_data_view_(nullptr) {}
 
+SamplingReportDataView::~SamplingReportDataView() { CancelAndWaitForPendingUpdates(); }
+
 const std::vector<DataView::Column>& SamplingReportDataView::GetColumns() {
   static const std::vector<Column> columns = [] {
     std::vector<Column> columns;
@@ -82,80 +84,122 @@ std::string SamplingReportDataView::GetValue(int row, int column) {
 }
 
 #define ORBIT_PROC_SORT(Member)                                                      \
-  [&](int a, int b) {                                                                \
+  [&](uint64_t a, uint64_t b) {                                                      \
     return orbit_core::Compare(functions[a].Member, functions[b].Member, ascending); \
   }
 
-#define ORBIT_CUSTOM_FUNC_SORT(Func)                                               \
-  [&](int a, int b) {                                                              \
-    return orbit_core::Compare(Func(functions[a]), Func(functions[b]), ascending); \
-  }
-
 #define ORBIT_MODULE_NAME_FUNC_SORT                                                        \
-  [&](int a, int b) {                                                                      \
+  [&](uint64_t a, uint64_t b) {                                                            \
     return orbit_core::Compare(std::filesystem::path(functions[a].module_path).filename(), \
                                std::filesystem::path(functions[b].module_path).filename(), \
                                ascending);                                                 \
   }
 
-void SamplingReportDataView::DoSort() {
-  bool ascending = sorting_orders_[sorting_column_] == SortingOrder::kAscending;
-  std::function<bool(int a, int b)> sorter = nullptr;
+void SamplingReportDataView::DoSort() { UpdateIndices(RefreshMode::kOnSort); }
+
+void SamplingReportDataView::UpdateIndices(RefreshMode mode) {
+  // Sorting orders are only initialized by the first call of OnSort.
+  const int sorting_column = sorting_column_;
+  const bool sort =
+      sorting_column >= 0 && static_cast<size_t>(sorting_column) < sorting_orders_.size();
+  const bool ascending = sort && sorting_orders_[sorting_column] == SortingOrder::kAscending;
+  // Looking up whether a function is selected requires the main thread, so it is done before
+  // sorting.
+  std::vector<bool> is_selected;
+  if (sort && sorting_column == kColumnSelected) {
+    is_selected.reserve(functions_.size());
+    for (const SampledFunction& function : functions_) {
+      is_selected.push_back(app_->IsFunctionSelected(function));
+    }
+  }
 
-  std::vector<SampledFunction>& functions = functions_;
+  SortIndicesFunction sort_indices = nullptr;
+  if (sort) {
+    sort_indices = [this, sorting_column, ascending, is_selected = std::move(is_selected)](
+                       std::vector<uint64_t>* indices, const IndicesUpdate& update) {
+      const std::vector<SampledFunction>& functions = functions_;
+      std::function<bool(uint64_t a, uint64_t b)> sorter = nullptr;
+
+      switch (sorting_column) {
+        case kColumnSelected:
+          sorter = [&](uint64_t a, uint64_t b) {
+            return orbit_core::Compare<bool>(is_selected[a], is_selected[b], ascending);
+          };
+          break;
+        case kColumnFunctionName:
+          sorter = ORBIT_PROC_SORT(name);
+          break;
+        case kColumnExclusive:
+          sorter = ORBIT_PROC_SORT(exclusive);
+          break;
+        case kColumnInclusive:
+          sorter = ORBIT_PROC_SORT(inclusive);
+          break;
+        case kColumnModuleName:
+          sorter = ORBIT_MODULE_NAME_FUNC_SORT;
+          break;
+        case kColumnFile:
+          sorter = ORBIT_PROC_SORT(file);
+          break;
+        case kColumnLine:
+          sorter = ORBIT_PROC_SORT(line);
+          break;
+        case kColumnAddress:
+          sorter = ORBIT_PROC_SORT(absolute_address);
+          break;
+        default:
+          break;
+      }
 
-  switch (sorting_column_) {
-    case kColumnSelected:
-      sorter = ORBIT_CUSTOM_FUNC_SORT(app_->IsFunctionSelected);
-      break;
-    case kColumnFunctionName:
-      sorter = ORBIT_PROC_SORT(name);
-      break;
-    case kColumnExclusive:
-      sorter = ORBIT_PROC_SORT(exclusive);
-      break;
-    case kColumnInclusive:
-      sorter = ORBIT_PROC_SORT(inclusive);
-      break;
-    case kColumnModuleName:
-      sorter = ORBIT_MODULE_NAME_FUNC_SORT;
-      break;
-    case kColumnFile:
-      sorter = ORBIT_PROC_SORT(file);
-      break;
-    case kColumnLine:
-      sorter = ORBIT_PROC_SORT(line);
-      break;
-    case kColumnAddress:
-      sorter = ORBIT_PROC_SORT(absolute_address);
-      break;
-    default:
-      break;
-  }
+      if (!sorter) {
+        return;
+      }
 
-  if (!sorter) {
-    return;
-  }
+      const auto fallback_sorter = [&](uint64_t ind_left, uint64_t ind_right) {
+        // `SampledFunction::address` is the absolute function address. Hence it is unique and
+        // qualifies for total ordering.
+        return functions[ind_left].absolute_address < functions[ind_right].absolute_address;
+      };
 
-  const auto fallback_sorter = [&](const auto& ind_left, const auto& ind_right) {
-    // `SampledFunction::address` is the absolute function address. Hence it is unique and qualifies
-    // for total ordering.
-    return functions[ind_left].absolute_address < functions[ind_right].absolute_address;
-  };
+      const auto combined_sorter = [&](uint64_t ind_left, uint64_t ind_right) {
+        if (sorter(ind_left, ind_right)) {
+          return true;
+        }
 
-  const auto combined_sorter = [&](const auto& ind_left, const auto& ind_right) {
-    if (sorter(ind_left, ind_right)) {
-      return true;
-    }
+        if (sorter(ind_right, ind_left)) {
+          return false;
+        }
 
-    if (sorter(ind_right, ind_left)) {
-      return false;
-    }
+        return fallback_sorter(ind_left, ind_right);
+      };
+
+      // The combined order is total, so the stable sort yields the same order as any other sort.
+      ParallelStableSort(indices, combined_sorter, &update);
+    };
+  }
 
-    return fallback_sorter(ind_left, ind_right);
+  std::vector<std::string> tokens = absl::StrSplit(ToLower(filter_), ' ');
+  auto filter_indices = [this, tokens = std::move(tokens)](const IndicesUpdate& update) {
+    return ParallelFilter(
+        functions_.size(),
+        [this, &tokens](size_t i) {
+          const SampledFunction& func = functions_[i];
+          std::string name = ToLower(func.name);
+          std::string module_name =
+              ToLower(std::filesystem::path(func.module_path).filename().string());
+
+          for (const std::string& filter_token : tokens) {
+            if (!(name.find(filter_token) != std::string::npos ||
+                  module_name.find(filter_token) != std::string::npos)) {
+              return false;
+            }
+          }
+          return true;
+        },
+        &update);
   };
 
-  std::sort(indices_.begin(), indices_.end(), combined_sorter);
+  UpdateIndicesAsync(mode, std::move(filter_indices), std::move(sort_indices));
 }
 
 absl::flat_hash_set<const FunctionInfo*> SamplingReportDataView::GetFunctionsFromIndices(
@@ -327,6 +371,8 @@ void SamplingReportDataView::LinkDataView(DataView* data_view) {
 }
 
 void SamplingReportDataView::SetSampledFunctions(const std::vector<SampledFunction>& functions) {
+  // Pending updates read functions_ on other threads.
+  CancelAndWaitForPendingUpdates();
   functions_ = functions;
   RestoreSelectedIndicesAfterFunctionsChanged();
 
@@ -348,33 +394,7 @@ void SamplingReportDataView::SetThreadID(ThreadID tid) {
   }
 }
 
-void SamplingReportDataView::DoFilter() {
-  std::vector<uint64_t> indices;
-
-  std::vector<std::string> tokens = absl::StrSplit(ToLower(filter_), ' ');
-
-  for (size_t i = 0; i < functions_.size(); ++i) {
-    SampledFunction& func = functions_[i];
-    std::string name = ToLower(func.name);
-    std::string module_name = ToLower(std::filesystem::path(func.module_path).filename().string());
-
-    bool match = true;
-
-    for (std::string& filter_token : tokens) {
-      if (!(name.find(filter_token) != std::string::npos ||
-            module_name.find(filter_token) != std::string::npos)) {
-        match = false;
-        break;
-      }
-    }
-
-    if (match) {
-      indices.push_back(i);
-    }
-  }
-
-  indices_ = std::move(indices);
-}
+void SamplingReportDataView::DoFilter() { UpdateIndices(RefreshMode::kOnFilter); }
 
 const SampledFunction& SamplingReportDataView::GetSampledFunction(unsigned int row) const {
   return functions_[indices_[row]];
@@ -22,6 +22,7 @@ class SamplingReport;
 class SamplingReportDataView : public DataView {
  public:
   explicit SamplingReportDataView(OrbitApp* app);
+  ~SamplingReportDataView() override;
 
   const std::vector<Column>& GetColumns() override;
   int GetDefaultSortingColumn() override { return kColumnInclusive; }
@@ -55,6 +56,7 @@ class SamplingReportDataView : public DataView {
   GetModulePathsAndBuildIdsFromIndices(const std::vector<int>& indices) const;
 
  private:
+  void UpdateIndices(RefreshMode mode);
   void UpdateSelectedIndicesAndFunctionIds(const std::vector<int>& selected_indices);
   void RestoreSelectedIndicesAfterFunctionsChanged();
   // The callstack view will be updated according to the visible selected addresses and thread id.
@@ -45,25 +45,27 @@ float SchedulerTrack::GetHeight() const {
          layout_->GetTrackBottomMargin();
 }
 
-bool SchedulerTrack::IsTimerActive(const TimerInfo& timer_info) const {
-  bool is_same_tid_as_selected = timer_info.thread_id() == app_->selected_thread_id();
+bool SchedulerTrack::IsTimerActive(const TimerInfo& timer_info,
+                                   const orbit_gl::UpdatePrimitivesContext& context) const {
+  bool is_same_tid_as_selected = timer_info.thread_id() == context.selected_thread_id;
   CHECK(capture_data_ != nullptr);
   int32_t capture_process_id = capture_data_->process_id();
   bool is_same_pid_as_target =
       capture_process_id == 0 || capture_process_id == timer_info.process_id();
 
-  return is_same_tid_as_selected || (app_->selected_thread_id() == -1 && is_same_pid_as_target);
+  return is_same_tid_as_selected || (context.selected_thread_id == -1 && is_same_pid_as_target);
 }
 
 Color SchedulerTrack::GetTimerColor(const TimerInfo& timer_info, bool is_selected,
-                                    bool is_highlighted) const {
+                                    bool is_highlighted,
+                                    const orbit_gl::UpdatePrimitivesContext& context) const {
   if (is_highlighted) {
     return TimerTrack::kHighlightColor;
   }
   if (is_selected) {
     return kSelectionColor;
   }
-  if (!IsTimerActive(timer_info)) {
+  if (!IsTimerActive(timer_info, context)) {
     return kInactiveColor;
   }
   return TimeGraph::GetThreadColor(timer_info.thread_id());
@@ -36,9 +36,11 @@ class SchedulerTrack final : public TimerTrack {
   [[nodiscard]] Color GetBackgroundColor() const override { return color_; }
 
  protected:
-  [[nodiscard]] bool IsTimerActive(const orbit_client_protos::TimerInfo& timer_info) const override;
-  [[nodiscard]] Color GetTimerColor(const orbit_client_protos::TimerInfo& timer_info,
-                                    bool is_selected, bool is_highlighted) const override;
+  [[nodiscard]] bool IsTimerActive(const orbit_client_protos::TimerInfo& timer_info,
+                                   const orbit_gl::UpdatePrimitivesContext& context) const override;
+  [[nodiscard]] Color GetTimerColor(
+      const orbit_client_protos::TimerInfo& timer_info, bool is_selected, bool is_highlighted,
+      const orbit_gl::UpdatePrimitivesContext& context) const override;
   [[nodiscard]] std::string GetBoxTooltip(const Batcher& batcher, PickingId id) const override;
 
  private:
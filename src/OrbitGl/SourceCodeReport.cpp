@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <limits>
 #include <optional>
+#include <vector>
 
 #include "OrbitBase/Logging.h"
 #include "OrbitClientData/PostProcessedSamplingData.h"
@@ -19,15 +20,24 @@ SourceCodeReport::SourceCodeReport(std::string_view source_file,
                                    const PostProcessedSamplingData& sampling_data,
                                    uint32_t total_samples_in_capture)
     : total_samples_in_capture_(total_samples_in_capture) {
+  const ThreadSampleData* summary = sampling_data.GetSummary();
+  std::vector<uint64_t> sampled_addresses;
+  std::vector<uint32_t> sampled_counts;
   for (size_t offset = 0; offset < function.size(); ++offset) {
-    const ThreadSampleData* summary = sampling_data.GetSummary();
     const auto it = summary->raw_address_count.find(absolute_address + offset);
     if (it == summary->raw_address_count.end()) continue;
+    if (it->second == 0) continue;
+    sampled_addresses.push_back(function.address() + offset);
+    sampled_counts.push_back(it->second);
+  }
+
+  // Resolving all addresses at once is much cheaper than one GetLineInfo call per address.
+  const auto line_infos = elf_file->GetLineInfos(sampled_addresses);
 
-    const uint32_t current_samples = it->second;
-    if (current_samples == 0) continue;
+  for (size_t i = 0; i < sampled_addresses.size(); ++i) {
+    const uint32_t current_samples = sampled_counts[i];
 
-    const auto maybe_current_line_info = elf_file->GetLineInfo(function.address() + offset);
+    const auto& maybe_current_line_info = line_infos[i];
     if (!maybe_current_line_info.has_value()) continue;
 
     const auto& current_line_info = maybe_current_line_info.value();
@@ -35,7 +45,7 @@ SourceCodeReport::SourceCodeReport(std::string_view source_file,
       ERROR(
           "Was trying to gather sampling data for function \"%s\" but the debug information "
           "tells me the function address %#x is defined in a different source file.",
-          function.pretty_name(), function.address() + offset);
+          function.pretty_name(), sampled_addresses[i]);
       ERROR("Expected: %s", source_file);
       ERROR("Actual: %s", current_line_info.source_file());
       continue;
@@ -0,0 +1,97 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SubstringSearchIndex.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "OrbitBase/Logging.h"
+
+namespace {
+constexpr size_t kTrigramSize = 3;
+}  // namespace
+
+uint32_t SubstringSearchIndex::GetTrigramKey(std::string_view trigram) {
+  return static_cast<uint8_t>(trigram[0]) |
+         static_cast<uint32_t>(static_cast<uint8_t>(trigram[1])) << 8 |
+         static_cast<uint32_t>(static_cast<uint8_t>(trigram[2])) << 16;
+}
+
+void SubstringSearchIndex::Add(std::string_view text) {
+  const auto block = static_cast<uint32_t>(GetNumTexts() / kNumTextsPerBlock);
+  for (size_t i = 0; i + kTrigramSize <= text.size(); ++i) {
+    std::vector<uint32_t>& blocks = blocks_by_trigram_[GetTrigramKey(text.substr(i, kTrigramSize))];
+    // Blocks are added in increasing order, so this keeps the posting lists sorted and unique.
+    if (blocks.empty() || blocks.back() != block) {
+      blocks.push_back(block);
+    }
+  }
+
+  blob_.append(text);
+  text_offsets_.push_back(blob_.size());
+}
+
+void SubstringSearchIndex::Clear() {
+  blob_.clear();
+  text_offsets_ = {0};
+  blocks_by_trigram_.clear();
+}
+
+std::string_view SubstringSearchIndex::GetText(size_t index) const {
+  CHECK(index < GetNumTexts());
+  return std::string_view{blob_}.substr(text_offsets_[index],
+                                        text_offsets_[index + 1] - text_offsets_[index]);
+}
+
+bool SubstringSearchIndex::ContainsAll(size_t index,
+                                       const std::vector<std::string>& tokens) const {
+  const std::string_view text = GetText(index);
+  return std::all_of(tokens.begin(), tokens.end(), [text](const std::string& token) {
+    return text.find(token) != std::string_view::npos;
+  });
+}
+
+std::optional<std::vector<uint64_t>> SubstringSearchIndex::FindCandidates(
+    const std::vector<std::string>& tokens) const {
+  std::vector<const std::vector<uint32_t>*> posting_lists;
+  for (const std::string& token : tokens) {
+    const std::string_view token_view{token};
+    for (size_t i = 0; i + kTrigramSize <= token_view.size(); ++i) {
+      auto it = blocks_by_trigram_.find(GetTrigramKey(token_view.substr(i, kTrigramSize)));
+      // No text contains this trigram, so none contains the token.
+      if (it == blocks_by_trigram_.end()) return std::vector<uint64_t>{};
+      posting_lists.push_back(&it->second);
+    }
+  }
+  if (posting_lists.empty()) return std::nullopt;
+
+  // Intersecting the shortest lists first keeps the intermediate results small.
+  std::sort(posting_lists.begin(), posting_lists.end(),
+            [](const std::vector<uint32_t>* lhs, const std::vector<uint32_t>* rhs) {
+              return lhs->size() != rhs->size() ? lhs->size() < rhs->size() : lhs < rhs;
+            });
+  posting_lists.erase(std::unique(posting_lists.begin(), posting_lists.end()),
+                      posting_lists.end());
+
+  std::vector<uint32_t> blocks = *posting_lists[0];
+  std::vector<uint32_t> intersection;
+  for (size_t i = 1; i < posting_lists.size() && !blocks.empty(); ++i) {
+    intersection.clear();
+    std::set_intersection(blocks.begin(), blocks.end(), posting_lists[i]->begin(),
+                          posting_lists[i]->end(), std::back_inserter(intersection));
+    blocks.swap(intersection);
+  }
+
+  std::vector<uint64_t> candidates;
+  candidates.reserve(blocks.size() * kNumTextsPerBlock);
+  const size_t num_texts = GetNumTexts();
+  for (uint32_t block : blocks) {
+    const size_t end = std::min((block + 1) * kNumTextsPerBlock, num_texts);
+    for (size_t index = block * kNumTextsPerBlock; index < end; ++index) {
+      candidates.push_back(index);
+    }
+  }
+  return candidates;
+}
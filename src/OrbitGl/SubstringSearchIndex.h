@@ -0,0 +1,51 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_GL_SUBSTRING_SEARCH_INDEX_H_
+#define ORBIT_GL_SUBSTRING_SEARCH_INDEX_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// SubstringSearchIndex holds a list of texts and answers which of them contain a set of tokens.
+// All texts are stored back to back in a single blob. Consecutive texts are grouped into blocks,
+// and for each trigram that occurs in the texts the index keeps the sorted list of blocks it
+// occurs in. Only the trigrams that occur are stored, so the size of the index grows with the
+// texts. A block is a candidate as a whole, so candidates always have to be verified with
+// ContainsAll.
+class SubstringSearchIndex {
+ public:
+  // Appends `text`. Its index is the number of texts added before.
+  void Add(std::string_view text);
+  void Clear();
+
+  [[nodiscard]] size_t GetNumTexts() const { return text_offsets_.size() - 1; }
+  [[nodiscard]] std::string_view GetText(size_t index) const;
+  [[nodiscard]] bool ContainsAll(size_t index, const std::vector<std::string>& tokens) const;
+
+  // Returns the sorted indices of all texts that can contain all `tokens`. Returns std::nullopt if
+  // the index cannot narrow the search down, which is the case if all tokens are shorter than a
+  // trigram.
+  [[nodiscard]] std::optional<std::vector<uint64_t>> FindCandidates(
+      const std::vector<std::string>& tokens) const;
+
+ private:
+  static constexpr size_t kNumTextsPerBlock = 16;
+
+  [[nodiscard]] static uint32_t GetTrigramKey(std::string_view trigram);
+
+  std::string blob_;
+  // text_offsets_[i] is the start of text i in blob_, the last element is the end of the blob.
+  std::vector<uint64_t> text_offsets_ = {0};
+  // Posting lists of block indices, keyed by the three bytes of the trigram.
+  absl::flat_hash_map<uint32_t, std::vector<uint32_t>> blocks_by_trigram_;
+};
+
+#endif  // ORBIT_GL_SUBSTRING_SEARCH_INDEX_H_
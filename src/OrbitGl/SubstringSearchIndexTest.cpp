@@ -0,0 +1,113 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "SubstringSearchIndex.h"
+#include "absl/strings/str_format.h"
+
+namespace {
+
+[[nodiscard]] std::vector<uint64_t> Find(const SubstringSearchIndex& index,
+                                         const std::vector<std::string>& tokens) {
+  std::vector<uint64_t> result;
+  std::optional<std::vector<uint64_t>> candidates = index.FindCandidates(tokens);
+  if (!candidates.has_value()) {
+    candidates.emplace();
+    for (size_t i = 0; i < index.GetNumTexts(); ++i) candidates->push_back(i);
+  }
+  for (uint64_t candidate : candidates.value()) {
+    if (index.ContainsAll(candidate, tokens)) result.push_back(candidate);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(SubstringSearchIndex, AddAndGetText) {
+  SubstringSearchIndex index;
+  EXPECT_EQ(index.GetNumTexts(), 0);
+
+  index.Add("main");
+  index.Add("");
+  index.Add("foo::bar()");
+  ASSERT_EQ(index.GetNumTexts(), 3);
+  EXPECT_EQ(index.GetText(0), "main");
+  EXPECT_EQ(index.GetText(1), "");
+  EXPECT_EQ(index.GetText(2), "foo::bar()");
+
+  index.Clear();
+  EXPECT_EQ(index.GetNumTexts(), 0);
+}
+
+TEST(SubstringSearchIndex, ShortTokensCannotBeNarrowedDown) {
+  SubstringSearchIndex index;
+  index.Add("main");
+
+  EXPECT_FALSE(index.FindCandidates({}).has_value());
+  EXPECT_FALSE(index.FindCandidates({""}).has_value());
+  EXPECT_FALSE(index.FindCandidates({"ma", "n"}).has_value());
+  EXPECT_TRUE(index.FindCandidates({"ma", "ain"}).has_value());
+}
+
+TEST(SubstringSearchIndex, EmptyIndexHasNoCandidates) {
+  SubstringSearchIndex index;
+  std::optional<std::vector<uint64_t>> candidates = index.FindCandidates({"main"});
+  ASSERT_TRUE(candidates.has_value());
+  EXPECT_TRUE(candidates->empty());
+}
+
+TEST(SubstringSearchIndex, FindsTextsContainingAllTokens) {
+  SubstringSearchIndex index;
+  std::vector<std::string> texts;
+  for (int i = 0; i < 1000; ++i) {
+    texts.push_back(absl::StrFormat("function_%d(int)libfoo%d.so", i, i % 7));
+    index.Add(texts.back());
+  }
+
+  const std::vector<std::vector<std::string>> queries = {
+      {"function_42("}, {"libfoo3"}, {"function_1", "libfoo2"}, {"(int)"},
+      {"_99", "t)"},    {"missing"}, {"function_4", ""},        {"o3.so", "function_9"}};
+  for (const std::vector<std::string>& tokens : queries) {
+    std::vector<uint64_t> expected;
+    for (size_t i = 0; i < texts.size(); ++i) {
+      bool contains_all = true;
+      for (const std::string& token : tokens) {
+        contains_all &= texts[i].find(token) != std::string::npos;
+      }
+      if (contains_all) expected.push_back(i);
+    }
+    EXPECT_EQ(Find(index, tokens), expected) << tokens[0];
+  }
+}
+
+TEST(SubstringSearchIndex, CandidatesAreNarrowedDown) {
+  SubstringSearchIndex index;
+  for (int i = 0; i < 1000; ++i) {
+    index.Add(absl::StrFormat("function_%d", i));
+  }
+  index.Add("unique_name");
+
+  std::optional<std::vector<uint64_t>> candidates = index.FindCandidates({"unique_name"});
+  ASSERT_TRUE(candidates.has_value());
+  EXPECT_THAT(candidates.value(), testing::Contains(1000));
+  EXPECT_LT(candidates->size(), 100);
+}
+
+TEST(SubstringSearchIndex, TokenWithUnknownTrigramHasNoCandidates) {
+  SubstringSearchIndex index;
+  for (int i = 0; i < 100; ++i) {
+    index.Add(absl::StrFormat("function_%d", i));
+  }
+
+  std::optional<std::vector<uint64_t>> candidates = index.FindCandidates({"function_1", "xyz"});
+  ASSERT_TRUE(candidates.has_value());
+  EXPECT_TRUE(candidates->empty());
+}
@@ -4,6 +4,7 @@
 
 #include "TextRenderer.h"
 
+#include <absl/strings/string_view.h>
 #include <float.h>
 #include <freetype-gl/shader.h>
 #include <freetype-gl/vector.h>
@@ -33,9 +34,14 @@ struct vertex_t {
 
 bool TextRenderer::draw_outline_ = false;
 
+// Upper bound on the number of cached glyph runs. Labels change as the user zooms and pans, so
+// the cache is simply dropped when it grows beyond this.
+static constexpr size_t kMaxNumGlyphRuns = 64 * 1024;
+
 TextRenderer::TextRenderer()
     : texture_atlas_(nullptr),
       texture_atlas_changed_(false),
+      num_glyph_runs_(0),
       canvas_(nullptr),
       initialized_(false) {}
 
@@ -125,6 +131,46 @@ texture_glyph_t* TextRenderer::MaybeLoadAndGetGlyph(texture_font_t* font, const
   return texture_font_get_glyph(font, character);
 }
 
+const TextRenderer::GlyphRun& TextRenderer::GetGlyphRun(texture_font_t* font, const char* text) {
+  auto& glyph_runs = glyph_runs_by_font_[font];
+  auto it = glyph_runs.find(absl::string_view(text));
+  if (it != glyph_runs.end()) return it->second;
+
+  if (num_glyph_runs_ >= kMaxNumGlyphRuns) {
+    for (auto& [unused_font, runs] : glyph_runs_by_font_) {
+      runs.clear();
+    }
+    num_glyph_runs_ = 0;
+  }
+
+  GlyphRun run;
+  const size_t text_length = strlen(text);
+  run.glyphs.reserve(text_length);
+  float first_line_width = 0.f;
+  int first_line_height = 0;
+  bool first_line_done = false;
+  for (size_t i = 0; i < text_length; ++i) {
+    texture_glyph_t* glyph = MaybeLoadAndGetGlyph(font, text + i);
+    float kerning = 0.f;
+    if (glyph != nullptr && i > 0) {
+      kerning = texture_glyph_get_kerning(glyph, text + i - 1);
+    }
+    run.glyphs.push_back({glyph, kerning});
+
+    if (first_line_done) continue;
+    if (glyph != nullptr) {
+      first_line_width += kerning + glyph->advance_x;
+      first_line_height = std::max(first_line_height, glyph->offset_y);
+    }
+    if (text[i] == '\n') first_line_done = true;
+  }
+  run.first_line_width = first_line_width;
+  run.first_line_height = first_line_height;
+
+  ++num_glyph_runs_;
+  return glyph_runs.emplace(text, std::move(run)).first->second;
+}
+
 void TextRenderer::RenderLayer(Batcher* /*batcher*/, float layer) {
   ORBIT_SCOPE_FUNCTION;
   if (vertex_buffers_by_layer_.count(layer) == 0) return;
@@ -224,17 +270,26 @@ void TextRenderer::AddTextInternal(texture_font_t* font, const char* text, const
   constexpr std::array<GLuint, 6> kIndices = {0, 1, 2, 0, 2, 3};
   vec2 initial_pen = *pen;
 
-  for (size_t i = 0; i < strlen(text); ++i) {
+  const GlyphRun& run = GetGlyphRun(font, text);
+
+  // Collect the quads of the whole string and push them to the vertex buffer at once, instead of
+  // pushing each glyph individually.
+  std::vector<vertex_t> vertices;
+  std::vector<GLuint> indices;
+  vertices.reserve(4 * run.glyphs.size());
+  indices.reserve(6 * run.glyphs.size());
+
+  for (size_t i = 0; i < run.glyphs.size(); ++i) {
     if (text[i] == '\n') {
       pen->x = initial_pen.x;
       pen->y -= font->height;
       continue;
     }
 
-    texture_glyph_t* glyph = MaybeLoadAndGetGlyph(font, text + i);
+    const GlyphRun::Glyph& run_glyph = run.glyphs[i];
+    texture_glyph_t* glyph = run_glyph.glyph;
     if (glyph != nullptr) {
-      float kerning = (i == 0) ? 0.0f : texture_glyph_get_kerning(glyph, text + i - 1);
-      pen->x += kerning;
+      pen->x += run_glyph.kerning;
 
       float x0 = floorf(pen->x + glyph->offset_x);
       float y0 = floorf(pen->y + glyph->offset_y);
@@ -246,11 +301,6 @@ void TextRenderer::AddTextInternal(texture_font_t* font, const char* text, const
       float s1 = glyph->s1;
       float t1 = glyph->t1;
 
-      vertex_t vertices[4] = {{x0, y0, z, s0, t0, r, g, b, a},
-                              {x0, y1, z, s0, t1, r, g, b, a},
-                              {x1, y1, z, s1, t1, r, g, b, a},
-                              {x1, y0, z, s1, t0, r, g, b, a}};
-
       min_x = std::min(min_x, x0);
       max_x = std::max(max_x, x1);
       min_y = std::min(min_y, y1);
@@ -261,14 +311,27 @@ void TextRenderer::AddTextInternal(texture_font_t* font, const char* text, const
       if (str_width > max_width) {
         break;
       }
-      if (!vertex_buffers_by_layer_.count(z)) {
-        vertex_buffers_by_layer_[z] = vertex_buffer_new("vertex:3f,tex_coord:2f,color:4f");
+
+      const auto first_vertex = static_cast<GLuint>(vertices.size());
+      vertices.push_back({x0, y0, z, s0, t0, r, g, b, a});
+      vertices.push_back({x0, y1, z, s0, t1, r, g, b, a});
+      vertices.push_back({x1, y1, z, s1, t1, r, g, b, a});
+      vertices.push_back({x1, y0, z, s1, t0, r, g, b, a});
+      for (GLuint index : kIndices) {
+        indices.push_back(first_vertex + index);
       }
-      vertex_buffer_push_back(vertex_buffers_by_layer_.at(z), vertices, 4, kIndices.data(), 6);
       pen->x += glyph->advance_x;
     }
   }
 
+  if (!vertices.empty()) {
+    if (!vertex_buffers_by_layer_.count(z)) {
+      vertex_buffers_by_layer_[z] = vertex_buffer_new("vertex:3f,tex_coord:2f,color:4f");
+    }
+    vertex_buffer_push_back(vertex_buffers_by_layer_.at(z), vertices.data(), vertices.size(),
+                            indices.data(), indices.size());
+  }
+
   if (out_text_pos) {
     out_text_pos->x = min_x;
     out_text_pos->y = min_y;
@@ -322,16 +385,12 @@ float TextRenderer::AddTextTrailingCharsPrioritized(const char* text, float x, f
   int max_x = -INT_MAX;
 
   const size_t text_length = strlen(text);
-  texture_font_t* font = GetFont(font_size);
+  const GlyphRun& run = GetGlyphRun(GetFont(font_size), text);
   size_t i;
   for (i = 0; i < text_length; ++i) {
-    texture_glyph_t* glyph = MaybeLoadAndGetGlyph(font, text + i);
+    texture_glyph_t* glyph = run.glyphs[i].glyph;
     if (glyph != nullptr) {
-      float kerning = 0.0f;
-      if (i > 0) {
-        kerning = texture_glyph_get_kerning(glyph, text + i - 1);
-      }
-      temp_pen_x += kerning;
+      temp_pen_x += run.glyphs[i].kerning;
       int x0 = static_cast<int>(temp_pen_x + glyph->offset_x);
       int x1 = static_cast<int>(x0 + glyph->width);
 
@@ -386,42 +445,11 @@ float TextRenderer::GetStringHeight(const char* text, uint32_t font_size) {
 }
 
 int TextRenderer::GetStringWidthScreenSpace(const char* text, uint32_t font_size) {
-  float string_width = 0;
-
-  std::size_t len = strlen(text);
-  for (std::size_t i = 0; i < len; ++i) {
-    texture_font_t* font = GetFont(font_size);
-    texture_glyph_t* glyph = MaybeLoadAndGetGlyph(font, text + i);
-    if (glyph != nullptr) {
-      float kerning = 0.0f;
-      if (i > 0) {
-        kerning = texture_glyph_get_kerning(glyph, text + i - 1);
-      }
-
-      string_width += kerning;
-      string_width += glyph->advance_x;
-    }
-
-    // Only return width of first line.
-    if (text[i] == '\n') break;
-  }
-
-  return static_cast<int>(ceil(string_width));
+  return static_cast<int>(ceil(GetGlyphRun(GetFont(font_size), text).first_line_width));
 }
 
 int TextRenderer::GetStringHeightScreenSpace(const char* text, uint32_t font_size) {
-  int max_height = 0.f;
-  texture_font_t* font = GetFont(font_size);
-  for (std::size_t i = 0; i < strlen(text); ++i) {
-    texture_glyph_t* glyph = MaybeLoadAndGetGlyph(font, text + i);
-    if (glyph != nullptr) {
-      max_height = std::max(max_height, glyph->offset_y);
-    }
-
-    // Only return height of first line.
-    if (text[i] == '\n') break;
-  }
-  return max_height;
+  return GetGlyphRun(GetFont(font_size), text).first_line_height;
 }
 
 std::vector<float> TextRenderer::GetLayers() const {
@@ -6,6 +6,7 @@
 #define ORBIT_GL_TEXT_RENDERER_H_
 
 #include <GteVector.h>
+#include <absl/container/flat_hash_map.h>
 #include <freetype-gl/mat4.h>
 #include <freetype-gl/texture-atlas.h>
 #include <freetype-gl/texture-font.h>
@@ -14,6 +15,7 @@
 #include <stdint.h>
 
 #include <map>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -70,6 +72,22 @@ class TextRenderer {
   void DrawOutline(Batcher* batcher, vertex_buffer_t* buffer);
 
  private:
+  // A GlyphRun caches the glyphs and kerning of a string for a given font, together with the
+  // metrics of its first line. Labels are laid out on every frame, and this avoids repeating the
+  // glyph and kerning lookups in freetype-gl for each character of each label.
+  struct GlyphRun {
+    struct Glyph {
+      texture_glyph_t* glyph;
+      float kerning;
+    };
+    // One entry per byte of the string, glyph is nullptr if there is no glyph for that byte.
+    std::vector<Glyph> glyphs;
+    float first_line_width;
+    int first_line_height;
+  };
+  // The returned reference is only valid until the next call to GetGlyphRun.
+  [[nodiscard]] const GlyphRun& GetGlyphRun(texture_font_t* font, const char* text);
+
   texture_atlas_t* texture_atlas_;
   // Indicates when a change to the texture atlas occurred so that we have to reupload the
   // texture data. Only freetype-gl's texture_font_load_glyph modifies the texture atlas,
@@ -77,6 +95,9 @@ class TextRenderer {
   bool texture_atlas_changed_;
   std::unordered_map<float, vertex_buffer_t*> vertex_buffers_by_layer_;
   std::map<uint32_t, texture_font_t*> fonts_by_size_;
+  absl::flat_hash_map<texture_font_t*, absl::flat_hash_map<std::string, GlyphRun>>
+      glyph_runs_by_font_;
+  size_t num_glyph_runs_;
   GlCanvas* canvas_;
   GLuint shader_;
   mat4 model_;
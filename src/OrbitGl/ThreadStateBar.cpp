@@ -6,7 +6,10 @@
 
 #include <absl/strings/str_format.h>
 
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <optional>
 #include <utility>
 
 #include "App.h"
@@ -141,26 +144,57 @@ static std::string GetThreadStateDescription(ThreadStateSliceInfo::ThreadState s
   }
 }
 
-std::string ThreadStateBar::GetThreadStateSliceTooltip(Batcher* batcher, PickingId id) const {
-  auto user_data = batcher->GetUserData(id);
-  if (user_data == nullptr || user_data->custom_data_ == nullptr) {
-    return "";
-  }
-
-  const auto* thread_state_slice =
-      static_cast<const ThreadStateSliceInfo*>(user_data->custom_data_);
+std::string ThreadStateBar::GetThreadStateSliceTooltip(ThreadStateSliceInfo::ThreadState state) {
   return absl::StrFormat(
       "<b>%s</b><br/>"
       "<i>Thread state</i><br/>"
       "<br/>"
       "%s",
-      GetThreadStateName(thread_state_slice->thread_state()),
-      GetThreadStateDescription(thread_state_slice->thread_state()));
+      GetThreadStateName(state), GetThreadStateDescription(state));
 }
 
-void ThreadStateBar::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
+namespace {
+
+// Accumulates the thread state slices shorter than a pixel that start in the same pixel column,
+// to draw a single box with the state that covers most of the column.
+class PixelColumnThreadStates {
+ public:
+  void Add(const ThreadStateSliceInfo& slice) {
+    duration_by_state_[slice.thread_state()] +=
+        slice.end_timestamp_ns() - slice.begin_timestamp_ns();
+    has_state_[slice.thread_state()] = true;
+    empty_ = false;
+  }
+
+  [[nodiscard]] bool IsEmpty() const { return empty_; }
+
+  // Returns the state with the largest total duration in the column.
+  [[nodiscard]] ThreadStateSliceInfo::ThreadState GetDominantState() const {
+    CHECK(!empty_);
+    std::optional<size_t> dominant_state;
+    for (size_t state = 0; state < duration_by_state_.size(); ++state) {
+      if (!has_state_[state]) continue;
+      if (!dominant_state.has_value() ||
+          duration_by_state_[state] > duration_by_state_[dominant_state.value()]) {
+        dominant_state = state;
+      }
+    }
+    return static_cast<ThreadStateSliceInfo::ThreadState>(dominant_state.value());
+  }
+
+ private:
+  std::array<uint64_t, ThreadStateSliceInfo::ThreadState_ARRAYSIZE> duration_by_state_{};
+  std::array<bool, ThreadStateSliceInfo::ThreadState_ARRAYSIZE> has_state_{};
+  bool empty_ = true;
+};
+
+}  // namespace
+
+void ThreadStateBar::UpdatePrimitives(Batcher* batcher,
+                                      const orbit_gl::UpdatePrimitivesContext& context,
+                                      uint64_t min_tick, uint64_t max_tick,
                                       PickingMode picking_mode, float z_offset) {
-  ThreadBar::UpdatePrimitives(batcher, min_tick, max_tick, picking_mode, z_offset);
+  ThreadBar::UpdatePrimitives(batcher, context, min_tick, max_tick, picking_mode, z_offset);
 
   const GlCanvas* canvas = time_graph_->GetCanvas();
 
@@ -169,51 +203,83 @@ void ThreadStateBar::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint6
   const uint64_t min_time_graph_ns = time_graph_->GetTickFromUs(time_graph_->GetMinTimeUs());
   const float pixel_width_in_world_coords =
       canvas->GetWorldWidth() / static_cast<float>(canvas->GetWidth());
+  const float z = GlCanvas::kZValueEvent + z_offset;
+
+  // The tooltip only depends on the thread state, which is copied into the callback: the boxes
+  // outlive this call, while the slices can be moved by CaptureData when new slices are inserted.
+  auto add_box = [&, batcher](float x0, float width, ThreadStateSliceInfo::ThreadState state) {
+    auto user_data = std::make_unique<PickingUserData>(
+        nullptr, [state](PickingId /*id*/) { return GetThreadStateSliceTooltip(state); });
+    Box box(Vec2{x0, pos_[1]}, Vec2{width, -size_[1]}, z);
+    batcher->AddBox(box, GetThreadStateColor(state), std::move(user_data));
+  };
+
+  // Slices shorter than a pixel are merged per pixel column into the state that covers most of
+  // the column (see PixelColumnThreadStates), and consecutive columns with the same dominant state
+  // are drawn as a single box. This reduces overdraw and the number of boxes when threads switch
+  // state very frequently.
+  auto get_column = [&](uint64_t timestamp_ns) {
+    return (std::max(timestamp_ns, min_time_graph_ns) - min_time_graph_ns) / pixel_delta_ns;
+  };
+  auto get_column_world_x = [&](uint64_t column) {
+    return time_graph_->GetWorldFromTick(min_time_graph_ns + column * pixel_delta_ns);
+  };
+
+  struct ColumnRun {
+    uint64_t first_column;
+    uint64_t last_column;
+    ThreadStateSliceInfo::ThreadState state;
+  };
+  std::optional<ColumnRun> current_run;
+  uint64_t current_column = 0;
+  PixelColumnThreadStates current_column_states;
 
-  uint64_t ignore_until_ns = 0;
+  auto flush_run = [&]() {
+    if (!current_run.has_value()) return;
+    const float num_columns = static_cast<float>(current_run->last_column -
+                                                 current_run->first_column + 1);
+    add_box(get_column_world_x(current_run->first_column),
+            num_columns * pixel_width_in_world_coords, current_run->state);
+    current_run.reset();
+  };
+  auto flush_column = [&]() {
+    if (current_column_states.IsEmpty()) return;
+    const ThreadStateSliceInfo::ThreadState dominant_state =
+        current_column_states.GetDominantState();
+    if (current_run.has_value() && current_run->last_column + 1 == current_column &&
+        current_run->state == dominant_state) {
+      current_run->last_column = current_column;
+    } else {
+      flush_run();
+      current_run = ColumnRun{current_column, current_column, dominant_state};
+    }
+    current_column_states = PixelColumnThreadStates{};
+  };
 
   CHECK(capture_data_ != nullptr);
   capture_data_->ForEachThreadStateSliceIntersectingTimeRange(
       thread_id_, min_tick, max_tick, [&](const ThreadStateSliceInfo& slice) {
-        if (slice.end_timestamp_ns() <= ignore_until_ns) {
-          // Reduce overdraw by not drawing slices whose entire width would only draw over a
-          // previous slice. Similar to TimerTrack::UpdatePrimitives.
+        const uint64_t duration_ns = slice.end_timestamp_ns() - slice.begin_timestamp_ns();
+        if (pixel_delta_ns == 0 || duration_ns > pixel_delta_ns) {
+          flush_column();
+          flush_run();
+          const float x0 = time_graph_->GetWorldFromTick(slice.begin_timestamp_ns());
+          const float x1 = time_graph_->GetWorldFromTick(slice.end_timestamp_ns());
+          // Use AddBox instead of AddVerticalLine even for very short slices, as otherwise the
+          // tops of Boxes and lines wouldn't be properly aligned.
+          add_box(x0, std::max(x1 - x0, pixel_width_in_world_coords), slice.thread_state());
           return;
         }
 
-        const float x0 = time_graph_->GetWorldFromTick(slice.begin_timestamp_ns());
-        const float x1 = time_graph_->GetWorldFromTick(slice.end_timestamp_ns());
-        const float width = x1 - x0;
-
-        const Vec2 pos{x0, pos_[1]};
-        const Vec2 size{width, -size_[1]};
-
-        const Color color = GetThreadStateColor(slice.thread_state());
-
-        auto user_data = std::make_unique<PickingUserData>(nullptr, [&, batcher](PickingId id) {
-          return GetThreadStateSliceTooltip(batcher, id);
-        });
-        user_data->custom_data_ = &slice;
-
-        if (slice.end_timestamp_ns() - slice.begin_timestamp_ns() > pixel_delta_ns) {
-          Box box(pos, size, GlCanvas::kZValueEvent + z_offset);
-          batcher->AddBox(box, color, std::move(user_data));
-        } else {
-          // Make this slice cover an entire pixel and don't draw subsequent slices that would
-          // coincide with the same pixel.
-          // Use AddBox instead of AddVerticalLine as otherwise the tops of Boxes and lines wouldn't
-          // be properly aligned.
-          Box box(pos, {pixel_width_in_world_coords, size[1]}, GlCanvas::kZValueEvent + z_offset);
-          batcher->AddBox(box, color, std::move(user_data));
-
-          if (pixel_delta_ns != 0) {
-            ignore_until_ns =
-                min_time_graph_ns +
-                (slice.begin_timestamp_ns() - min_time_graph_ns) / pixel_delta_ns * pixel_delta_ns +
-                pixel_delta_ns;
-          }
+        const uint64_t column = get_column(slice.begin_timestamp_ns());
+        if (column != current_column) {
+          flush_column();
+          current_column = column;
         }
+        current_column_states.Add(slice);
       });
+  flush_column();
+  flush_run();
 }
 
 void ThreadStateBar::OnPick(int x, int y) {
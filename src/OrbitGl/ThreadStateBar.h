@@ -14,6 +14,7 @@
 #include "CaptureViewElement.h"
 #include "CoreMath.h"
 #include "ThreadBar.h"
+#include "capture_data.pb.h"
 
 namespace orbit_gl {
 
@@ -29,15 +30,17 @@ class ThreadStateBar final : public ThreadBar {
                           ThreadID thread_id);
 
   void Draw(GlCanvas* canvas, PickingMode picking_mode, float z_offset) override;
-  void UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
-                        PickingMode picking_mode, float z_offset) override;
+  void UpdatePrimitives(Batcher* batcher, const orbit_gl::UpdatePrimitivesContext& context,
+                        uint64_t min_tick, uint64_t max_tick, PickingMode picking_mode,
+                        float z_offset) override;
 
   void OnPick(int x, int y) override;
 
   [[nodiscard]] bool IsEmpty() const override;
 
  private:
-  std::string GetThreadStateSliceTooltip(Batcher* batcher, PickingId id) const;
+  [[nodiscard]] static std::string GetThreadStateSliceTooltip(
+      orbit_client_protos::ThreadStateSliceInfo::ThreadState state);
 };
 
 }  // namespace orbit_gl
@@ -119,8 +119,7 @@ std::string ThreadTrack::GetBoxTooltip(const Batcher& batcher, PickingId id) con
   }
 
   if (is_manual) {
-    auto api_event = ManualInstrumentationManager::ApiEventFromTimerInfo(timer_info);
-    function_name = api_event.name;
+    function_name = app_->GetManualInstrumentationManager()->GetApiEventName(timer_info);
   } else {
     function_name = func->function_name();
   }
@@ -139,10 +138,11 @@ std::string ThreadTrack::GetBoxTooltip(const Batcher& batcher, PickingId id) con
           TicksToDuration(text_box->GetTimerInfo().start(), text_box->GetTimerInfo().end())));
 }
 
-bool ThreadTrack::IsTimerActive(const TimerInfo& timer_info) const {
+bool ThreadTrack::IsTimerActive(const TimerInfo& timer_info,
+                                const orbit_gl::UpdatePrimitivesContext& context) const {
   return timer_info.type() == TimerInfo::kIntrospection ||
          timer_info.type() == TimerInfo::kApiEvent ||
-         app_->IsFunctionVisible(timer_info.function_id());
+         context.IsFunctionVisible(timer_info.function_id());
 }
 
 bool ThreadTrack::IsTrackSelected() const {
@@ -180,14 +180,15 @@ bool ThreadTrack::IsTrackSelected() const {
 Color ThreadTrack::GetTimerColor(const TextBox& text_box, const internal::DrawData& draw_data) {
   const TimerInfo& timer_info = text_box.GetTimerInfo();
   uint64_t function_id = timer_info.function_id();
-  bool is_selected = &text_box == draw_data.selected_textbox;
+  bool is_selected = &text_box == draw_data.context->selected_text_box;
   bool is_highlighted = !is_selected && function_id != orbit_grpc_protos::kInvalidFunctionId &&
-                        function_id == draw_data.highlighted_function_id;
-  return GetTimerColor(timer_info, is_selected, is_highlighted);
+                        function_id == draw_data.context->highlighted_function_id;
+  return GetTimerColor(timer_info, is_selected, is_highlighted, *draw_data.context);
 }
 
 Color ThreadTrack::GetTimerColor(const TimerInfo& timer_info, bool is_selected,
-                                 bool is_highlighted) const {
+                                 bool is_highlighted,
+                                 const orbit_gl::UpdatePrimitivesContext& context) const {
   const Color kInactiveColor(100, 100, 100, 255);
   const Color kSelectionColor(0, 128, 255, 255);
   if (is_highlighted) {
@@ -196,7 +197,7 @@ Color ThreadTrack::GetTimerColor(const TimerInfo& timer_info, bool is_selected,
   if (is_selected) {
     return kSelectionColor;
   }
-  if (!IsTimerActive(timer_info)) {
+  if (!IsTimerActive(timer_info, context)) {
     return kInactiveColor;
   }
 
@@ -320,7 +321,7 @@ void ThreadTrack::SetTrackColor(Color color) {
 }
 
 void ThreadTrack::SetTimesliceText(const TimerInfo& timer_info, float min_x, float z_offset,
-                                   TextBox* text_box) {
+                                   TextBox* text_box, TextRenderer* text_renderer) {
   if (text_box->GetText().empty()) {
     std::string time = GetPrettyTime(absl::Nanoseconds(timer_info.end() - timer_info.start()));
     text_box->SetElapsedTimeTextLength(time.length());
@@ -330,8 +331,7 @@ void ThreadTrack::SetTimesliceText(const TimerInfo& timer_info, float min_x, flo
       std::string extra_info = GetExtraInfo(timer_info);
       std::string name;
       if (func->function_type() == InstrumentedFunction::kTimerStart) {
-        auto api_event = ManualInstrumentationManager::ApiEventFromTimerInfo(timer_info);
-        name = api_event.name;
+        name = app_->GetManualInstrumentationManager()->GetApiEventName(timer_info);
       } else {
         name = func->function_name();
       }
@@ -344,10 +344,9 @@ void ThreadTrack::SetTimesliceText(const TimerInfo& timer_info, float min_x, flo
       std::string text = absl::StrFormat("%s %s", api_event.name, time.c_str());
       text_box->SetText(text);
     } else if (timer_info.type() == TimerInfo::kApiEvent) {
-      auto api_event = ManualInstrumentationManager::ApiEventFromTimerInfo(timer_info);
+      std::string name = app_->GetManualInstrumentationManager()->GetApiEventName(timer_info);
       std::string extra_info = GetExtraInfo(timer_info);
-      std::string text =
-          absl::StrFormat("%s %s %s", api_event.name, extra_info.c_str(), time.c_str());
+      std::string text = absl::StrFormat("%s %s %s", name, extra_info.c_str(), time.c_str());
       text_box->SetText(text);
     } else {
       ERROR(
@@ -362,7 +361,7 @@ void ThreadTrack::SetTimesliceText(const TimerInfo& timer_info, float min_x, flo
   const Vec2& box_size = text_box->GetSize();
   float pos_x = std::max(box_pos[0], min_x);
   float max_size = box_pos[0] + box_size[0] - pos_x;
-  text_renderer_->AddTextTrailingCharsPrioritized(
+  text_renderer->AddTextTrailingCharsPrioritized(
       text_box->GetText().c_str(), pos_x, text_box->GetPos()[1] + layout_->GetTextOffset(),
       GlCanvas::kZValueBox + z_offset, kTextWhite, text_box->GetElapsedTimeTextLength(),
       layout_->CalculateZoomedFontSize(), max_size);
@@ -450,16 +449,18 @@ static inline void ResizeTextBox(const internal::DrawData& draw_data, const Time
 // We minimize overdraw when drawing lines for small events by discarding events that would just
 // draw over an already drawn pixel line. When zoomed in enough that all events are drawn as boxes,
 // this has no effect. When zoomed  out, many events will be discarded quickly.
-void ThreadTrack::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
-                                   PickingMode picking_mode, float z_offset) {
+void ThreadTrack::UpdatePrimitives(Batcher* batcher,
+                                   const orbit_gl::UpdatePrimitivesContext& context,
+                                   uint64_t min_tick, uint64_t max_tick, PickingMode picking_mode,
+                                   float z_offset) {
   CHECK(batcher);
   visible_timer_count_ = 0;
-  UpdatePrimitivesOfSubtracks(batcher, min_tick, max_tick, picking_mode, z_offset);
+  UpdatePrimitivesOfSubtracks(batcher, context, min_tick, max_tick, picking_mode, z_offset);
   UpdateBoxHeight();
 
-  const internal::DrawData draw_data = GetDrawData(
-      min_tick, max_tick, z_offset, batcher, time_graph_, collapse_toggle_->IsCollapsed(),
-      app_->selected_text_box(), app_->GetFunctionIdToHighlight());
+  const internal::DrawData draw_data =
+      GetDrawData(min_tick, max_tick, z_offset, batcher, time_graph_,
+                  collapse_toggle_->IsCollapsed(), context);
 
   absl::MutexLock lock(&scope_tree_mutex_);
 
@@ -484,7 +485,8 @@ void ThreadTrack::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t
       const Vec2& size = text_box.GetSize();
 
       if (text_box.Duration() > draw_data.ns_per_pixel) {
-        SetTimesliceText(text_box.GetTimerInfo(), draw_data.world_start_x, z_offset, &text_box);
+        SetTimesliceText(text_box.GetTimerInfo(), draw_data.world_start_x, z_offset, &text_box,
+                         context.text_renderer);
         batcher->AddShadedBox(pos, size, draw_data.z, color, std::move(user_data));
       } else {
         batcher->AddVerticalLine(pos, box_height_, draw_data.z, color, std::move(user_data));
@@ -496,18 +498,21 @@ void ThreadTrack::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t
   }
 }
 
-void ThreadTrack::UpdatePrimitivesOfSubtracks(Batcher* batcher, uint64_t min_tick,
-                                              uint64_t max_tick, PickingMode picking_mode,
-                                              float z_offset) {
+void ThreadTrack::UpdatePrimitivesOfSubtracks(Batcher* batcher,
+                                              const orbit_gl::UpdatePrimitivesContext& context,
+                                              uint64_t min_tick, uint64_t max_tick,
+                                              PickingMode picking_mode, float z_offset) {
   UpdatePositionOfSubtracks();
 
   if (!thread_state_bar_->IsEmpty()) {
-    thread_state_bar_->UpdatePrimitives(batcher, min_tick, max_tick, picking_mode, z_offset);
+    thread_state_bar_->UpdatePrimitives(batcher, context, min_tick, max_tick, picking_mode,
+                                        z_offset);
   }
   if (!event_bar_->IsEmpty()) {
-    event_bar_->UpdatePrimitives(batcher, min_tick, max_tick, picking_mode, z_offset);
+    event_bar_->UpdatePrimitives(batcher, context, min_tick, max_tick, picking_mode, z_offset);
   }
   if (!tracepoint_bar_->IsEmpty()) {
-    tracepoint_bar_->UpdatePrimitives(batcher, min_tick, max_tick, picking_mode, z_offset);
+    tracepoint_bar_->UpdatePrimitives(batcher, context, min_tick, max_tick, picking_mode,
+                                      z_offset);
   }
 }
@@ -39,8 +39,9 @@ class ThreadTrack final : public TimerTrack {
   [[nodiscard]] const TextBox* GetRight(const TextBox* textbox) const override;
 
   void Draw(GlCanvas* canvas, PickingMode picking_mode, float z_offset = 0) override;
-  void UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
-                        PickingMode picking_mode, float z_offset = 0) override;
+  void UpdatePrimitives(Batcher* batcher, const orbit_gl::UpdatePrimitivesContext& context,
+                        uint64_t min_tick, uint64_t max_tick, PickingMode picking_mode,
+                        float z_offset = 0) override;
   void OnTimer(const orbit_client_protos::TimerInfo& timer_info) override;
 
   void OnPick(int x, int y) override;
@@ -52,22 +53,26 @@ class ThreadTrack final : public TimerTrack {
   [[nodiscard]] std::vector<CaptureViewElement*> GetVisibleChildren() override;
 
  protected:
-  [[nodiscard]] bool IsTimerActive(const orbit_client_protos::TimerInfo& timer) const override;
+  [[nodiscard]] bool IsTimerActive(const orbit_client_protos::TimerInfo& timer,
+                                   const orbit_gl::UpdatePrimitivesContext& context) const override;
   [[nodiscard]] bool IsTrackSelected() const override;
 
-  [[nodiscard]] Color GetTimerColor(const orbit_client_protos::TimerInfo& timer, bool is_selected,
-                                    bool is_highlighted) const override;
+  [[nodiscard]] Color GetTimerColor(
+      const orbit_client_protos::TimerInfo& timer, bool is_selected, bool is_highlighted,
+      const orbit_gl::UpdatePrimitivesContext& context) const override;
   [[nodiscard]] Color GetTimerColor(const TextBox& text_box, const internal::DrawData& draw_data);
   void SetTimesliceText(const orbit_client_protos::TimerInfo& timer, float min_x, float z_offset,
-                        TextBox* text_box) override;
+                        TextBox* text_box, TextRenderer* text_renderer) override;
   [[nodiscard]] std::string GetBoxTooltip(const Batcher& batcher, PickingId id) const override;
 
   [[nodiscard]] float GetHeight() const override;
   [[nodiscard]] float GetHeaderHeight() const override;
 
   void UpdatePositionOfSubtracks();
-  void UpdatePrimitivesOfSubtracks(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
-                                   PickingMode picking_mode, float z_offset);
+  void UpdatePrimitivesOfSubtracks(Batcher* batcher,
+                                   const orbit_gl::UpdatePrimitivesContext& context,
+                                   uint64_t min_tick, uint64_t max_tick, PickingMode picking_mode,
+                                   float z_offset);
   void UpdateMinMaxTimestamps();
 
   std::shared_ptr<orbit_gl::ThreadStateBar> thread_state_bar_;
@@ -50,12 +50,16 @@ TimeGraph::TimeGraph(OrbitApp* app, TextRenderer* text_renderer, GlCanvas* canva
     : orbit_gl::CaptureViewElement(nullptr, this, &layout_),
       text_renderer_{text_renderer},
       canvas_{canvas},
-      batcher_(BatcherId::kTimeGraph),
+      front_buffers_{std::make_unique<PrimitiveBuffers>()},
+      back_buffers_{std::make_unique<PrimitiveBuffers>()},
+      ui_thread_id_{std::this_thread::get_id()},
       capture_data_{capture_data},
       app_{app} {
   text_renderer_->SetCanvas(canvas);
-  text_renderer_static_.SetCanvas(canvas);
-  batcher_.SetPickingManager(&canvas->GetPickingManager());
+  for (PrimitiveBuffers* buffers : {front_buffers_.get(), back_buffers_.get()}) {
+    buffers->text_renderer.SetCanvas(canvas);
+    buffers->batcher.SetPickingManager(&canvas->GetPickingManager());
+  }
   track_manager_ = std::make_unique<TrackManager>(this, &GetLayout(), app, capture_data);
 
   async_timer_info_listener_ =
@@ -68,6 +72,7 @@ TimeGraph::TimeGraph(OrbitApp* app, TextRenderer* text_renderer, GlCanvas* canva
 }
 
 TimeGraph::~TimeGraph() {
+  if (background_update_primitives_.has_value()) background_update_primitives_->Wait();
   manual_instrumentation_manager_->RemoveAsyncTimerListener(async_timer_info_listener_.get());
 }
 
@@ -81,12 +86,15 @@ void TimeGraph::UpdateCaptureMinMaxTimestamps() {
 }
 
 void TimeGraph::ZoomAll() {
+  ZoomToCaptureEnd();
+  RequestUpdatePrimitives();
+}
+
+void TimeGraph::ZoomToCaptureEnd() {
   UpdateCaptureMinMaxTimestamps();
   max_time_us_ = TicksToMicroseconds(capture_min_timestamp_, capture_max_timestamp_);
   min_time_us_ = max_time_us_ - (GNumHistorySeconds * 1000 * 1000);
   if (min_time_us_ < 0) min_time_us_ = 0;
-
-  RequestUpdatePrimitives();
 }
 
 void TimeGraph::Zoom(uint64_t min, uint64_t max) {
@@ -310,7 +318,7 @@ void TimeGraph::ProcessTimer(const TimerInfo& timer_info, const InstrumentedFunc
       UNREACHABLE();
   }
 
-  RequestUpdatePrimitives();
+  RequestUpdatePrimitivesForNewData();
 }
 
 void TimeGraph::ProcessOrbitFunctionTimer(FunctionInfo::OrbitType type,
@@ -352,6 +360,7 @@ void TimeGraph::ProcessApiEventTimer(const TimerInfo& timer_info) {
       ProcessValueTrackingTimer(timer_info);
       break;
     case orbit_api::kNone:
+    case orbit_api::kInternString:
       UNREACHABLE();
   }
 }
@@ -390,7 +399,8 @@ void TimeGraph::ProcessValueTrackingTimer(const TimerInfo& timer_info) {
     return;
   }
 
-  GraphTrack* track = track_manager_->GetOrCreateGraphTrack(event.name);
+  const std::string name = manual_instrumentation_manager_->GetApiEventName(timer_info);
+  GraphTrack* track = track_manager_->GetOrCreateGraphTrack(name);
   uint64_t time = timer_info.start();
 
   switch (event.type) {
@@ -576,18 +586,14 @@ const TextBox* TimeGraph::FindPreviousFunctionCall(uint64_t function_id, uint64_
   std::vector<std::shared_ptr<TimerChain>> chains = GetAllThreadTrackTimerChains();
   for (auto& chain : chains) {
     if (!chain) continue;
-    for (const auto& block : *chain) {
-      if (!block.Intersects(previous_box_time, current_time)) continue;
-      for (uint64_t i = 0; i < block.size(); i++) {
-        const TextBox& box = block[i];
-        auto box_time = box.GetTimerInfo().end();
-        if ((box.GetTimerInfo().function_id() == function_id) &&
-            (!thread_id || thread_id.value() == box.GetTimerInfo().thread_id()) &&
-            (box_time < current_time) && (previous_box_time < box_time)) {
-          previous_box = &box;
-          previous_box_time = box_time;
-        }
-      }
+    const TextBox* box = chain->FindLastElementEndingBetween(
+        previous_box_time, current_time, [function_id, thread_id](const TextBox& candidate) {
+          return candidate.GetTimerInfo().function_id() == function_id &&
+                 (!thread_id || thread_id.value() == candidate.GetTimerInfo().thread_id());
+        });
+    if (box != nullptr) {
+      previous_box = box;
+      previous_box_time = box->GetTimerInfo().end();
     }
   }
   return previous_box;
@@ -600,18 +606,14 @@ const TextBox* TimeGraph::FindNextFunctionCall(uint64_t function_id, uint64_t cu
   std::vector<std::shared_ptr<TimerChain>> chains = GetAllThreadTrackTimerChains();
   for (auto& chain : chains) {
     if (!chain) continue;
-    for (const auto& block : *chain) {
-      if (!block.Intersects(current_time, next_box_time)) continue;
-      for (uint64_t i = 0; i < block.size(); i++) {
-        const TextBox& box = block[i];
-        auto box_time = box.GetTimerInfo().end();
-        if ((box.GetTimerInfo().function_id() == function_id) &&
-            (!thread_id || thread_id.value() == box.GetTimerInfo().thread_id()) &&
-            (box_time > current_time) && (next_box_time > box_time)) {
-          next_box = &box;
-          next_box_time = box_time;
-        }
-      }
+    const TextBox* box = chain->FindFirstElementEndingBetween(
+        current_time, next_box_time, [function_id, thread_id](const TextBox& candidate) {
+          return candidate.GetTimerInfo().function_id() == function_id &&
+                 (!thread_id || thread_id.value() == candidate.GetTimerInfo().thread_id());
+        });
+    if (box != nullptr) {
+      next_box = box;
+      next_box_time = box->GetTimerInfo().end();
     }
   }
   return next_box;
@@ -622,14 +624,36 @@ void TimeGraph::RequestUpdatePrimitives() {
   RequestRedraw();
 }
 
+void TimeGraph::RequestUpdatePrimitivesForNewData() {
+  new_data_update_primitives_requested_ = true;
+}
+
+bool TimeGraph::IsRedrawNeeded() const {
+  if (background_update_primitives_.has_value()) {
+    return background_update_primitives_->IsFinished();
+  }
+  return redraw_requested_ || new_data_update_primitives_requested_;
+}
+
 // UpdatePrimitives updates all the drawable track timers in the timegraph's batcher
-void TimeGraph::UpdatePrimitives(Batcher* /*batcher*/, uint64_t /*min_tick*/, uint64_t /*max_tick*/,
-                                 PickingMode picking_mode, float /*z_offset*/) {
-  ORBIT_SCOPE_FUNCTION;
-  CHECK(app_->GetStringManager() != nullptr);
+void TimeGraph::UpdatePrimitivesOnUiThread(PickingMode picking_mode) {
+  CHECK(std::this_thread::get_id() == ui_thread_id_);
+  CHECK(!background_update_primitives_.has_value());
+  orbit_gl::UpdatePrimitivesContext context = PrepareUpdatePrimitives(front_buffers_.get());
+  UpdatePrimitivesOfTracks(front_buffers_.get(), context, picking_mode);
+  // Coordinates from CaptureWindows could need an update if we modified the vertical size of some
+  // track.
+  GetCanvas()->UpdateWorldTopLeftY();
 
-  batcher_.StartNewFrame();
-  text_renderer_static_.Clear();
+  update_primitives_requested_ = false;
+  update_primitives_time_statistics_.AddFrameTimeNs(last_update_primitives_duration_ns_);
+}
+
+// Reads everything the update of the tracks needs from the UI thread, so that the update itself can
+// run in the background.
+orbit_gl::UpdatePrimitivesContext TimeGraph::PrepareUpdatePrimitives(PrimitiveBuffers* buffers) {
+  // The update covers all data added until now.
+  new_data_update_primitives_requested_ = false;
 
   if (capture_data_) {
     capture_min_timestamp_ =
@@ -641,17 +665,70 @@ void TimeGraph::UpdatePrimitives(Batcher* /*batcher*/, uint64_t /*min_tick*/, ui
   time_window_us_ = max_time_us_ - min_time_us_;
   world_start_x_ = canvas_->GetWorldTopLeftX();
   world_width_ = canvas_->GetWorldWidth();
-  uint64_t min_tick = GetTickFromUs(min_time_us_);
-  uint64_t max_tick = GetTickFromUs(max_time_us_);
 
+  // Sorting reads the capture state of the app.
   track_manager_->SortTracks();
   track_manager_->UpdateMovingTrackSorting();
-  track_manager_->UpdateTracks(&batcher_, min_tick, max_tick, picking_mode);
-  // Coordinates from CaptureWindows could need an update if we modified the vertical size of some
-  // track.
-  GetCanvas()->UpdateWorldTopLeftY();
 
-  update_primitives_requested_ = false;
+  orbit_gl::UpdatePrimitivesContext context;
+  context.text_renderer = &buffers->text_renderer;
+  context.selected_text_box = app_->selected_text_box();
+  context.highlighted_function_id = app_->GetFunctionIdToHighlight();
+  context.selected_thread_id = app_->selected_thread_id();
+  if (capture_data_) {
+    for (const auto& [function_id, unused_function] : capture_data_->instrumented_functions()) {
+      if (app_->IsFunctionVisible(function_id)) context.visible_function_ids.insert(function_id);
+    }
+  }
+  return context;
+}
+
+void TimeGraph::UpdatePrimitivesOfTracks(PrimitiveBuffers* buffers,
+                                         const orbit_gl::UpdatePrimitivesContext& context,
+                                         PickingMode picking_mode) {
+  ORBIT_SCOPE("TimeGraph::UpdatePrimitives");
+  CHECK(app_->GetStringManager() != nullptr);
+  Timer update_timer;
+
+  buffers->batcher.StartNewFrame();
+  buffers->text_renderer.Clear();
+
+  uint64_t min_tick = GetTickFromUs(min_time_us_);
+  uint64_t max_tick = GetTickFromUs(max_time_us_);
+
+  track_manager_->UpdateTracks(&buffers->batcher, context, min_tick, max_tick, picking_mode);
+
+  last_update_primitives_duration_ns_ = update_timer.ElapsedNanos();
+}
+
+void TimeGraph::StartBackgroundUpdatePrimitives(bool zoom_to_capture_end) {
+  CHECK(std::this_thread::get_id() == ui_thread_id_);
+  if (background_update_primitives_.has_value()) return;
+  if (!new_data_update_primitives_requested_ && !zoom_to_capture_end) return;
+
+  if (zoom_to_capture_end) ZoomToCaptureEnd();
+  PrimitiveBuffers* buffers = back_buffers_.get();
+  orbit_gl::UpdatePrimitivesContext context = PrepareUpdatePrimitives(buffers);
+  // Initializing the text renderer needs the OpenGl context of the UI thread.
+  buffers->text_renderer.Init();
+  background_update_primitives_ = app_->GetThreadPool()->Schedule(
+      [this, buffers, context = std::move(context)] {
+        UpdatePrimitivesOfTracks(buffers, context, PickingMode::kNone);
+      });
+}
+
+void TimeGraph::FinishBackgroundUpdatePrimitives() {
+  if (std::this_thread::get_id() != ui_thread_id_) return;
+  if (!background_update_primitives_.has_value()) return;
+  ORBIT_SCOPE_FUNCTION;
+  background_update_primitives_->Wait();
+  background_update_primitives_.reset();
+
+  std::swap(front_buffers_, back_buffers_);
+  GetCanvas()->UpdateWorldTopLeftY();
+  update_primitives_time_statistics_.AddFrameTimeNs(last_update_primitives_duration_ns_);
+  // The frame on screen doesn't show the primitives that are now presented yet.
+  RequestRedraw();
 }
 
 void TimeGraph::SelectCallstacks(float world_start, float world_end, int32_t thread_id) {
@@ -684,13 +761,17 @@ const std::vector<CallstackEvent>& TimeGraph::GetSelectedCallstackEvents(int32_t
   return selected_callstack_events_per_thread_[tid];
 }
 
-void TimeGraph::Draw(GlCanvas* canvas, PickingMode picking_mode, float z_offset) {
+void TimeGraph::Draw(GlCanvas* canvas, PickingMode picking_mode, float /*z_offset*/) {
   ORBIT_SCOPE("TimeGraph::Draw");
   current_mouse_time_ns_ = GetTickFromWorld(canvas_->GetMouseX());
 
+  // CaptureWindow hands off background builds before it handles any event, including the paint
+  // event that draws this frame.
+  CHECK(!background_update_primitives_.has_value());
+
   const bool picking = picking_mode != PickingMode::kNone;
   if ((!picking && update_primitives_requested_) || picking) {
-    UpdatePrimitives(nullptr, 0, 0, picking_mode, z_offset);
+    UpdatePrimitivesOnUiThread(picking_mode);
   }
 
   DrawTracks(canvas, picking_mode);
@@ -984,7 +1065,7 @@ const TextBox* TimeGraph::FindDown(const TextBox* from) {
 
 void TimeGraph::DrawText(GlCanvas* canvas, float layer) {
   if (draw_text_) {
-    text_renderer_static_.RenderLayer(canvas->GetBatcher(), layer);
+    GetTextRenderer()->RenderLayer(canvas->GetBatcher(), layer);
   }
 }
 
@@ -7,11 +7,13 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <atomic>
 #include <cstdint>
 #include <map>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "AccessibleTimeGraph.h"
@@ -20,16 +22,20 @@
 #include "CaptureViewElement.h"
 #include "CoreMath.h"
 #include "CoreUtils.h"
+#include "FrameTimeStatistics.h"
 #include "ManualInstrumentationManager.h"
 #include "OrbitAccessibility/AccessibleInterface.h"
+#include "OrbitBase/Future.h"
 #include "OrbitClientModel/CaptureData.h"
 #include "PickingManager.h"
 #include "TextBox.h"
 #include "TextRenderer.h"
 #include "TimeGraphLayout.h"
+#include "Timer.h"
 #include "TimerChain.h"
 #include "Track.h"
 #include "TrackManager.h"
+#include "UpdatePrimitivesContext.h"
 #include "absl/container/flat_hash_map.h"
 #include "capture_data.pb.h"
 
@@ -48,8 +54,16 @@ class TimeGraph : public orbit_gl::CaptureViewElement {
   void DrawText(GlCanvas* canvas, float layer);
 
   void RequestUpdatePrimitives();
-  void UpdatePrimitives(Batcher* /*batcher*/, uint64_t /*min_tick*/, uint64_t /*max_tick*/,
-                        PickingMode /*picking_mode*/, float /*z_offset*/ = 0) override;
+
+  // Primitives for new capture data are built on the thread pool of the app, into a second batcher
+  // and text renderer, while the previous ones keep being presented. Called on the UI thread after
+  // a frame has been drawn, this starts such a build if new data arrived or, while following the
+  // end of the capture with `zoom_to_capture_end`, always.
+  void StartBackgroundUpdatePrimitives(bool zoom_to_capture_end);
+  // The background build accesses the tracks, so the UI thread hands it off before it handles an
+  // event or otherwise accesses the time graph: this waits for a running build and presents its
+  // primitives. CaptureWindow is the only caller. Does nothing on other threads.
+  void FinishBackgroundUpdatePrimitives();
   void SelectCallstacks(float world_start, float world_end, int32_t thread_id);
   const std::vector<orbit_client_protos::CallstackEvent>& GetSelectedCallstackEvents(int32_t tid);
 
@@ -104,7 +118,7 @@ class TimeGraph : public orbit_gl::CaptureViewElement {
   [[nodiscard]] double GetCaptureTimeSpanUs() const;
   [[nodiscard]] double GetCurrentTimeSpanUs() const;
   void RequestRedraw();
-  [[nodiscard]] bool IsRedrawNeeded() const { return redraw_requested_; }
+  [[nodiscard]] bool IsRedrawNeeded() const;
   void SetThreadFilter(const std::string& filter);
 
   [[nodiscard]] bool IsFullyVisible(uint64_t min, uint64_t max) const;
@@ -112,9 +126,13 @@ class TimeGraph : public orbit_gl::CaptureViewElement {
   [[nodiscard]] bool IsVisible(VisibilityType vis_type, uint64_t min, uint64_t max) const;
 
   [[nodiscard]] int GetNumDrawnTextBoxes() { return num_drawn_text_boxes_; }
-  [[nodiscard]] TextRenderer* GetTextRenderer() { return &text_renderer_static_; }
+  [[nodiscard]] const FrameTimeStatistics& GetUpdatePrimitivesTimeStatistics() const {
+    return update_primitives_time_statistics_;
+  }
+  // The batcher and text renderer of the primitives being presented.
+  [[nodiscard]] TextRenderer* GetTextRenderer() { return &front_buffers_->text_renderer; }
+  [[nodiscard]] Batcher& GetBatcher() { return front_buffers_->batcher; }
   [[nodiscard]] GlCanvas* GetCanvas() { return canvas_; }
-  [[nodiscard]] Batcher& GetBatcher() { return batcher_; }
   [[nodiscard]] std::vector<std::shared_ptr<TimerChain>> GetAllTimerChains() const;
   [[nodiscard]] std::vector<std::shared_ptr<TimerChain>> GetAllThreadTrackTimerChains() const;
   [[nodiscard]] std::vector<std::shared_ptr<TimerChain>> GetAllSerializableTimerChains() const;
@@ -183,7 +201,23 @@ class TimeGraph : public orbit_gl::CaptureViewElement {
   void ProcessMemoryTrackingTimer(const orbit_client_protos::TimerInfo& timer_info);
 
  private:
-  TextRenderer text_renderer_static_;
+  struct PrimitiveBuffers {
+    PrimitiveBuffers() : batcher(BatcherId::kTimeGraph) {}
+    Batcher batcher;
+    TextRenderer text_renderer;
+  };
+
+  void RequestUpdatePrimitivesForNewData();
+  // Like ZoomAll, without requesting an update of the primitives.
+  void ZoomToCaptureEnd();
+  // Updates the primitives being presented. No background build may be running.
+  void UpdatePrimitivesOnUiThread(PickingMode picking_mode);
+  [[nodiscard]] orbit_gl::UpdatePrimitivesContext PrepareUpdatePrimitives(
+      PrimitiveBuffers* buffers);
+  void UpdatePrimitivesOfTracks(PrimitiveBuffers* buffers,
+                                const orbit_gl::UpdatePrimitivesContext& context,
+                                PickingMode picking_mode);
+
   TextRenderer* text_renderer_ = nullptr;
   GlCanvas* canvas_ = nullptr;
   int num_drawn_text_boxes_ = 0;
@@ -214,10 +248,19 @@ class TimeGraph : public orbit_gl::CaptureViewElement {
   // timeline.
   bool update_primitives_requested_ = false;
   bool redraw_requested_ = false;
+  // Set from the threads that add capture data. Unlike update_primitives_requested_, it doesn't
+  // imply redraw_requested_: the primitives for new data are built in the background.
+  std::atomic<bool> new_data_update_primitives_requested_ = false;
+
+  FrameTimeStatistics update_primitives_time_statistics_;
+  uint64_t last_update_primitives_duration_ns_ = 0;
 
   bool draw_text_ = true;
 
-  Batcher batcher_;
+  std::unique_ptr<PrimitiveBuffers> front_buffers_;
+  std::unique_ptr<PrimitiveBuffers> back_buffers_;
+  std::optional<orbit_base::Future<void>> background_update_primitives_;
+  std::thread::id ui_thread_id_;
 
   std::unique_ptr<TrackManager> track_manager_;
 
@@ -5,6 +5,7 @@
 #include "TimerChain.h"
 
 #include <algorithm>
+#include <optional>
 
 #include "OrbitBase/Logging.h"
 #include "capture_data.pb.h"
@@ -16,6 +17,10 @@ void TimerBlock::Add(const TextBox& item) {
     }
 
     chain_->current_ = next_;
+    {
+      absl::MutexLock lock(&chain_->mutex_);
+      chain_->blocks_.push_back(next_);
+    }
     ++chain_->num_blocks_;
     next_->Add(item);
     return;
@@ -45,47 +50,215 @@ TimerChain::~TimerChain() {
   }
 }
 
-TimerBlock* TimerChain::GetBlockContaining(const TextBox* element) const {
-  TimerBlock* block = root_;
-  while (block) {
-    uint32_t size = block->size_;
-    if (size != 0) {
-      TextBox* begin = &block->data_[0];
-      TextBox* end = &block->data_[size - 1];
-      if (begin <= element && end >= element) {
-        return block;
+void TimerChain::push_back(const TextBox& item) {
+  const orbit_client_protos::TimerInfo& timer_info = item.GetTimerInfo();
+  if (timer_info.start() < last_start_ || timer_info.end() < last_end_) {
+    is_time_ordered_ = false;
+  }
+  last_start_ = std::max(last_start_, timer_info.start());
+  last_end_ = std::max(last_end_, timer_info.end());
+  current_->Add(item);
+}
+
+bool TimerChain::IsTimeOrdered() const { return is_time_ordered_; }
+
+template <typename Predicate>
+TimerChain::Position TimerChain::FindFirst(Predicate&& predicate) const {
+  if (!is_time_ordered_) {
+    for (size_t block_index = 0; block_index < blocks_.size(); ++block_index) {
+      const TimerBlock* block = blocks_[block_index];
+      for (size_t element_index = 0; element_index < block->size_; ++element_index) {
+        if (predicate(block->data_[element_index])) return {block_index, element_index};
       }
     }
-    block = block->next_;
+    return {blocks_.size(), 0};
   }
 
-  return nullptr;
+  // All blocks but the last one are full, and only the root block can be empty (if the chain is
+  // empty). Find the first block whose last element satisfies the predicate, then the first
+  // element within that block.
+  auto block_it =
+      std::partition_point(blocks_.begin(), blocks_.end(), [&](const TimerBlock* block) {
+        return block->size_ == 0 || !predicate(block->data_[block->size_ - 1]);
+      });
+  if (block_it == blocks_.end()) return {blocks_.size(), 0};
+
+  const TimerBlock* block = *block_it;
+  const TextBox* element_it =
+      std::partition_point(&block->data_[0], &block->data_[0] + block->size_,
+                           [&](const TextBox& box) { return !predicate(box); });
+  return {static_cast<size_t>(block_it - blocks_.begin()),
+          static_cast<size_t>(element_it - &block->data_[0])};
+}
+
+std::optional<TimerChain::Position> TimerChain::FindPosition(const TextBox* element) const {
+  auto position_in_block = [element](const TimerBlock* block) -> std::optional<size_t> {
+    if (block->size_ == 0) return std::nullopt;
+    const TextBox* begin = &block->data_[0];
+    const TextBox* end = begin + block->size_;
+    if (begin <= element && element < end) return element - begin;
+    return std::nullopt;
+  };
+
+  // Blocks are not contiguous in memory, but if the chain is time-ordered the element can only be
+  // in the blocks spanning its start timestamp.
+  size_t first_block_index = 0;
+  if (is_time_ordered_) {
+    const uint64_t start = element->GetTimerInfo().start();
+    first_block_index = FindFirst([start](const TextBox& box) {
+                          return box.GetTimerInfo().start() >= start;
+                        }).block_index;
+  }
+
+  for (size_t block_index = first_block_index; block_index < blocks_.size(); ++block_index) {
+    std::optional<size_t> element_index = position_in_block(blocks_[block_index]);
+    if (element_index.has_value()) return Position{block_index, element_index.value()};
+  }
+  return std::nullopt;
+}
+
+TextBox* TimerChain::GetElementAt(Position position) const {
+  if (position.block_index >= blocks_.size()) return nullptr;
+  TimerBlock* block = blocks_[position.block_index];
+  if (position.element_index >= block->size_) return nullptr;
+  return &block->data_[position.element_index];
+}
+
+TextBox* TimerChain::GetElementBeforePosition(Position position) const {
+  if (position.element_index > 0) {
+    return GetElementAt({position.block_index, position.element_index - 1});
+  }
+  if (position.block_index == 0) return nullptr;
+  TimerBlock* previous_block = blocks_[position.block_index - 1];
+  if (previous_block->size_ == 0) return nullptr;
+  return &previous_block->data_[previous_block->size_ - 1];
+}
+
+TimerBlock* TimerChain::GetBlockContaining(const TextBox* element) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  std::optional<Position> position = FindPosition(element);
+  if (!position.has_value()) return nullptr;
+  return blocks_[position->block_index];
 }
 
 TextBox* TimerChain::GetElementAfter(const TextBox* element) const {
-  auto block = GetBlockContaining(element);
-  if (block) {
-    TextBox* begin = &block->data_[0];
-    uint32_t index = element - begin;
-    if (index < block->size_ - 1) {
-      return &block->data_[++index];
+  absl::ReaderMutexLock lock(&mutex_);
+  std::optional<Position> position = FindPosition(element);
+  if (!position.has_value()) return nullptr;
+  TextBox* next = GetElementAt({position->block_index, position->element_index + 1});
+  if (next != nullptr) return next;
+  return GetElementAt({position->block_index + 1, 0});
+}
+
+TextBox* TimerChain::GetElementBefore(const TextBox* element) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  std::optional<Position> position = FindPosition(element);
+  if (!position.has_value()) return nullptr;
+  return GetElementBeforePosition(position.value());
+}
+
+const TextBox* TimerChain::GetFirstElementStartingAfter(uint64_t time) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return GetElementAt(
+      FindFirst([time](const TextBox& box) { return box.GetTimerInfo().start() > time; }));
+}
+
+const TextBox* TimerChain::GetLastElementStartingAtOrBefore(uint64_t time) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return GetElementBeforePosition(
+      FindFirst([time](const TextBox& box) { return box.GetTimerInfo().start() > time; }));
+}
+
+const TextBox* TimerChain::GetFirstElementEndingAfter(uint64_t time) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return GetElementAt(
+      FindFirst([time](const TextBox& box) { return box.GetTimerInfo().end() > time; }));
+}
+
+const TextBox* TimerChain::GetLastElementEndingBefore(uint64_t time) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return GetElementBeforePosition(
+      FindFirst([time](const TextBox& box) { return box.GetTimerInfo().end() >= time; }));
+}
+
+const TextBox* TimerChain::FindLastElementEndingBetween(
+    uint64_t min_end, uint64_t max_end,
+    const std::function<bool(const TextBox&)>& predicate) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  if (!is_time_ordered_) {
+    const TextBox* last = nullptr;
+    for (const TimerBlock* block : blocks_) {
+      if (!block->Intersects(min_end, max_end)) continue;
+      for (size_t i = 0; i < block->size_; ++i) {
+        const TextBox& box = block->data_[i];
+        const uint64_t end = box.GetTimerInfo().end();
+        if (end > min_end && end < max_end && predicate(box)) {
+          if (last == nullptr || end > last->GetTimerInfo().end()) last = &box;
+        }
+      }
+    }
+    return last;
+  }
+
+  // Walk backwards from the last element ending before max_end, and stop at the first match or at
+  // the first element (respectively block) that ends too early.
+  const Position end_position =
+      FindFirst([max_end](const TextBox& box) { return box.GetTimerInfo().end() >= max_end; });
+  size_t element_end = end_position.element_index;
+  for (size_t block_index = std::min(end_position.block_index + 1, blocks_.size());
+       block_index-- > 0;) {
+    const TimerBlock* block = blocks_[block_index];
+    if (block_index != end_position.block_index) element_end = block->size_;
+    if (!block->Intersects(min_end, max_end)) {
+      if (block->size_ > 0 && block->max_timestamp_ <= min_end) return nullptr;
+      continue;
     }
-    if (block->next_ && block->next_->size_) {
-      return &block->next_->data_[0];
+    for (size_t i = element_end; i-- > 0;) {
+      const TextBox& box = block->data_[i];
+      if (box.GetTimerInfo().end() <= min_end) return nullptr;
+      if (predicate(box)) return &box;
     }
   }
   return nullptr;
 }
 
-TextBox* TimerChain::GetElementBefore(const TextBox* element) const {
-  auto block = GetBlockContaining(element);
-  if (block) {
-    TextBox* begin = &block->data_[0];
-    uint32_t index = element - begin;
-    if (index > 0) {
-      return &block->data_[--index];
+const TextBox* TimerChain::FindFirstElementEndingBetween(
+    uint64_t min_end, uint64_t max_end,
+    const std::function<bool(const TextBox&)>& predicate) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  if (!is_time_ordered_) {
+    const TextBox* first = nullptr;
+    for (const TimerBlock* block : blocks_) {
+      if (!block->Intersects(min_end, max_end)) continue;
+      for (size_t i = 0; i < block->size_; ++i) {
+        const TextBox& box = block->data_[i];
+        const uint64_t end = box.GetTimerInfo().end();
+        if (end > min_end && end < max_end && predicate(box)) {
+          if (first == nullptr || end < first->GetTimerInfo().end()) first = &box;
+        }
+      }
+    }
+    return first;
+  }
+
+  // Walk forward from the first element ending after min_end, and stop at the first match or at the
+  // first element (respectively block) that ends too late.
+  const Position begin_position =
+      FindFirst([min_end](const TextBox& box) { return box.GetTimerInfo().end() > min_end; });
+  size_t element_begin = begin_position.element_index;
+  for (size_t block_index = begin_position.block_index; block_index < blocks_.size();
+       ++block_index) {
+    const TimerBlock* block = blocks_[block_index];
+    if (block_index != begin_position.block_index) element_begin = 0;
+    if (!block->Intersects(min_end, max_end)) {
+      if (block->size_ > 0 && block->min_timestamp_ >= max_end) return nullptr;
+      continue;
+    }
+    for (size_t i = element_begin; i < block->size_; ++i) {
+      const TextBox& box = block->data_[i];
+      if (box.GetTimerInfo().end() >= max_end) return nullptr;
+      if (predicate(box)) return &box;
     }
-    if (block->prev_) return &block->prev_->data_[block->prev_->size_ - 1];
   }
   return nullptr;
 }
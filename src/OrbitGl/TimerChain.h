@@ -8,11 +8,15 @@
 #include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <iosfwd>
 #include <limits>
+#include <optional>
+#include <vector>
 
 #include "OrbitBase/Logging.h"
 #include "TextBox.h"
+#include "absl/synchronization/mutex.h"
 
 static constexpr int kBlockSize = 1024;
 class TimerChain;
@@ -102,6 +106,13 @@ class TimerChainIterator {
 // is a difference compared with BlockChain in how the iterators work: Here,
 // the iterator runs over blocks, in BlockChain the iterator runs over the
 // individually stored elements.
+//
+// In addition, the chain keeps an index of its blocks. As long as timers are
+// added in non-decreasing order of both their start and end timestamps (which
+// is the case for timers on the same depth of a thread track), the index allows
+// to look up elements by time in O(log n) using a binary search over the blocks
+// followed by a binary search within the block. If timers are added out of
+// order, the time-based lookups fall back to a linear scan in insertion order.
 class TimerChain {
   friend class TimerBlock;
 
@@ -109,11 +120,12 @@ class TimerChain {
   TimerChain() : num_blocks_(1), num_items_(0) {
     root_ = new TimerBlock(this, nullptr);
     current_ = root_;
+    blocks_.push_back(root_);
   }
 
   ~TimerChain();
 
-  void push_back(const TextBox& item) { current_->Add(item); }
+  void push_back(const TextBox& item);
   [[nodiscard]] bool empty() const { return num_items_ == 0; }
   [[nodiscard]] uint64_t size() const { return num_items_; }
 
@@ -123,6 +135,33 @@ class TimerChain {
 
   [[nodiscard]] TextBox* GetElementBefore(const TextBox* element) const;
 
+  // Returns true if all elements were added in non-decreasing order of both
+  // start and end timestamps, i.e., if the time-based lookups below are
+  // answered with a binary search.
+  [[nodiscard]] bool IsTimeOrdered() const;
+
+  // Returns the first element with a start timestamp greater than `time`.
+  [[nodiscard]] const TextBox* GetFirstElementStartingAfter(uint64_t time) const;
+
+  // Returns the last element with a start timestamp not greater than `time`.
+  [[nodiscard]] const TextBox* GetLastElementStartingAtOrBefore(uint64_t time) const;
+
+  // Returns the first element with an end timestamp greater than `time`.
+  [[nodiscard]] const TextBox* GetFirstElementEndingAfter(uint64_t time) const;
+
+  // Returns the last element with an end timestamp less than `time`.
+  [[nodiscard]] const TextBox* GetLastElementEndingBefore(uint64_t time) const;
+
+  // Return the element with the greatest (respectively smallest) end timestamp in the open
+  // interval (min_end, max_end) for which `predicate` returns true, or nullptr. The chain is
+  // searched under a single lock, and blocks that don't intersect the interval are skipped.
+  [[nodiscard]] const TextBox* FindLastElementEndingBetween(
+      uint64_t min_end, uint64_t max_end,
+      const std::function<bool(const TextBox&)>& predicate) const;
+  [[nodiscard]] const TextBox* FindFirstElementEndingBetween(
+      uint64_t min_end, uint64_t max_end,
+      const std::function<bool(const TextBox&)>& predicate) const;
+
   [[nodiscard]] TextBox* GetLast() { return current_->GetLast(); }
 
   [[nodiscard]] TimerChainIterator begin() { return TimerChainIterator(root_); }
@@ -130,10 +169,36 @@ class TimerChain {
   [[nodiscard]] TimerChainIterator end() { return TimerChainIterator(nullptr); }
 
  private:
+  // Position of an element in the chain: index into blocks_ and index into the
+  // block. A block index equal to blocks_.size() denotes the end of the chain.
+  struct Position {
+    size_t block_index;
+    size_t element_index;
+  };
+
+  // Returns the position of the first element for which `predicate` returns
+  // true. `predicate` must be monotonic over the chain if it is time-ordered.
+  // The following helpers require mutex_ to be held.
+  template <typename Predicate>
+  [[nodiscard]] Position FindFirst(Predicate&& predicate) const;
+  [[nodiscard]] std::optional<Position> FindPosition(const TextBox* element) const;
+  [[nodiscard]] TextBox* GetElementAt(Position position) const;
+  [[nodiscard]] TextBox* GetElementBeforePosition(Position position) const;
+
   TimerBlock* root_;
   TimerBlock* current_;
   uint64_t num_blocks_;
   uint64_t num_items_;
+
+  // Guards the block index, which grows in push_back while lookups might happen
+  // concurrently from the UI thread. It is only taken by push_back when a new
+  // block is appended.
+  mutable absl::Mutex mutex_;
+  std::vector<TimerBlock*> blocks_;
+  std::atomic<bool> is_time_ordered_ = true;
+  // Only accessed by the thread that adds elements.
+  uint64_t last_start_ = 0;
+  uint64_t last_end_ = 0;
 };
 
 #endif  // ORBIT_GL_TIMER_CHAIN_H_
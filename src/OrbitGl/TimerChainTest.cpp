@@ -0,0 +1,174 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+
+#include "TextBox.h"
+#include "TimerChain.h"
+#include "capture_data.pb.h"
+
+using orbit_client_protos::TimerInfo;
+
+namespace {
+
+TextBox MakeTextBox(uint64_t start, uint64_t end) {
+  TimerInfo timer_info;
+  timer_info.set_start(start);
+  timer_info.set_end(end);
+  TextBox text_box;
+  text_box.SetTimerInfo(timer_info);
+  return text_box;
+}
+
+// Adds `num_timers` consecutive timers [10 * i + 10, 10 * i + 15] to `chain`, spanning several
+// blocks for large enough values of `num_timers`.
+void AddOrderedTimers(TimerChain* chain, uint64_t num_timers) {
+  for (uint64_t i = 0; i < num_timers; ++i) {
+    chain->push_back(MakeTextBox(10 * i + 10, 10 * i + 15));
+  }
+}
+
+}  // namespace
+
+TEST(TimerChain, EmptyChain) {
+  TimerChain chain;
+  EXPECT_TRUE(chain.IsTimeOrdered());
+  EXPECT_EQ(chain.GetFirstElementStartingAfter(0), nullptr);
+  EXPECT_EQ(chain.GetLastElementStartingAtOrBefore(100), nullptr);
+  EXPECT_EQ(chain.GetFirstElementEndingAfter(0), nullptr);
+  EXPECT_EQ(chain.GetLastElementEndingBefore(100), nullptr);
+}
+
+TEST(TimerChain, TimeLookupsOnOrderedChain) {
+  TimerChain chain;
+  constexpr uint64_t kNumTimers = 3 * kBlockSize + 7;
+  AddOrderedTimers(&chain, kNumTimers);
+  EXPECT_TRUE(chain.IsTimeOrdered());
+
+  const TextBox* box = chain.GetFirstElementStartingAfter(0);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().start(), 10);
+
+  // Exactly on a start timestamp: "after" is strict, "at or before" is not.
+  box = chain.GetFirstElementStartingAfter(10 * kBlockSize + 10);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().start(), 10 * kBlockSize + 20);
+  box = chain.GetLastElementStartingAtOrBefore(10 * kBlockSize + 10);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().start(), 10 * kBlockSize + 10);
+
+  // Crossing a block boundary.
+  box = chain.GetLastElementStartingAtOrBefore(10 * kBlockSize + 5);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().start(), 10 * kBlockSize);
+
+  box = chain.GetFirstElementEndingAfter(2005);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().end(), 2015);
+  box = chain.GetLastElementEndingBefore(2005);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().end(), 1995);
+
+  // The last timer is found even if no timer starts after it.
+  box = chain.GetLastElementStartingAtOrBefore(100 * kNumTimers);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().start(), 10 * kNumTimers);
+  EXPECT_EQ(chain.GetFirstElementStartingAfter(100 * kNumTimers), nullptr);
+  EXPECT_EQ(chain.GetLastElementStartingAtOrBefore(5), nullptr);
+}
+
+TEST(TimerChain, ElementAfterAndBeforeAcrossBlocks) {
+  TimerChain chain;
+  AddOrderedTimers(&chain, 2 * kBlockSize + 1);
+
+  const TextBox* first = chain.GetFirstElementStartingAfter(0);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(chain.GetElementBefore(first), nullptr);
+
+  uint64_t count = 1;
+  const TextBox* previous = first;
+  for (const TextBox* box = chain.GetElementAfter(first); box != nullptr;
+       box = chain.GetElementAfter(box)) {
+    EXPECT_GT(box->GetTimerInfo().start(), previous->GetTimerInfo().start());
+    EXPECT_EQ(chain.GetElementBefore(box), previous);
+    EXPECT_NE(chain.GetBlockContaining(box), nullptr);
+    previous = box;
+    ++count;
+  }
+  EXPECT_EQ(count, chain.size());
+
+  TextBox not_in_chain = MakeTextBox(10, 15);
+  EXPECT_EQ(chain.GetBlockContaining(&not_in_chain), nullptr);
+  EXPECT_EQ(chain.GetElementAfter(&not_in_chain), nullptr);
+}
+
+TEST(TimerChain, TimeLookupsFallBackOnUnorderedChain) {
+  TimerChain chain;
+  chain.push_back(MakeTextBox(30, 40));
+  chain.push_back(MakeTextBox(10, 20));
+  chain.push_back(MakeTextBox(50, 60));
+  EXPECT_FALSE(chain.IsTimeOrdered());
+
+  // Lookups follow insertion order.
+  const TextBox* box = chain.GetFirstElementStartingAfter(35);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().start(), 50);
+  box = chain.GetLastElementStartingAtOrBefore(35);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().start(), 10);
+
+  box = chain.GetFirstElementStartingAfter(5);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(chain.GetElementAfter(box)->GetTimerInfo().start(), 10);
+}
+
+TEST(TimerChain, FindElementEndingBetweenAcrossBlocks) {
+  TimerChain chain;
+  AddOrderedTimers(&chain, 3 * kBlockSize);
+  // Timer i ends at 10 * i + 15. Only every 700th timer matches.
+  auto matches = [](const TextBox& box) { return (box.GetTimerInfo().end() - 15) % 7000 == 0; };
+
+  const TextBox* box = chain.FindLastElementEndingBetween(0, 10 * 2000 + 15, matches);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().end(), 10 * 1400 + 15);
+  box = chain.FindFirstElementEndingBetween(10 * 1400 + 15, 10 * 3000, matches);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().end(), 10 * 2100 + 15);
+
+  // The bounds are exclusive.
+  EXPECT_EQ(chain.FindLastElementEndingBetween(10 * 1400 + 15, 10 * 2100 + 15, matches), nullptr);
+  EXPECT_EQ(chain.FindFirstElementEndingBetween(10 * 1400 + 15, 10 * 2100 + 15, matches), nullptr);
+
+  auto all = [](const TextBox& /*box*/) { return true; };
+  box = chain.FindLastElementEndingBetween(0, std::numeric_limits<uint64_t>::max(), all);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().end(), 10 * (3 * kBlockSize - 1) + 15);
+  box = chain.FindFirstElementEndingBetween(0, std::numeric_limits<uint64_t>::max(), all);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().end(), 15);
+  EXPECT_EQ(chain.FindLastElementEndingBetween(0, 15, all), nullptr);
+  EXPECT_EQ(chain.FindFirstElementEndingBetween(10 * (3 * kBlockSize - 1) + 15,
+                                                std::numeric_limits<uint64_t>::max(), all),
+            nullptr);
+}
+
+TEST(TimerChain, FindElementEndingBetweenOnUnorderedChain) {
+  TimerChain chain;
+  chain.push_back(MakeTextBox(30, 40));
+  chain.push_back(MakeTextBox(10, 20));
+  chain.push_back(MakeTextBox(50, 60));
+  chain.push_back(MakeTextBox(0, 35));
+  EXPECT_FALSE(chain.IsTimeOrdered());
+
+  auto all = [](const TextBox& /*box*/) { return true; };
+  const TextBox* box = chain.FindLastElementEndingBetween(0, 50, all);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().end(), 40);
+  box = chain.FindFirstElementEndingBetween(20, 100, all);
+  ASSERT_NE(box, nullptr);
+  EXPECT_EQ(box->GetTimerInfo().end(), 35);
+}
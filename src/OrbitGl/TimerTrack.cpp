@@ -32,7 +32,6 @@ const Color TimerTrack::kHighlightColor = Color(100, 181, 246, 255);
 TimerTrack::TimerTrack(CaptureViewElement* parent, TimeGraph* time_graph, TimeGraphLayout* layout,
                        OrbitApp* app, const CaptureData* capture_data)
     : Track(parent, time_graph, layout, capture_data), app_{app} {
-  text_renderer_ = time_graph->GetTextRenderer();
 }
 
 void TimerTrack::Draw(GlCanvas* canvas, PickingMode picking_mode, float z_offset) {
@@ -171,17 +170,17 @@ bool TimerTrack::DrawTimer(const TextBox* prev_text_box, const TextBox* next_tex
       current_text_box->SetSize(size);
 
       SetTimesliceText(current_timer_info, draw_data.world_start_x, draw_data.z_offset,
-                       current_text_box);
+                       current_text_box, draw_data.context->text_renderer);
     }
   }
 
   uint64_t function_id = current_timer_info.function_id();
 
-  bool is_selected = current_text_box == draw_data.selected_textbox;
+  bool is_selected = current_text_box == draw_data.context->selected_text_box;
   bool is_highlighted = !is_selected && function_id != orbit_grpc_protos::kInvalidFunctionId &&
-                        function_id == draw_data.highlighted_function_id;
+                        function_id == draw_data.context->highlighted_function_id;
 
-  Color color = GetTimerColor(current_timer_info, is_selected, is_highlighted);
+  Color color = GetTimerColor(current_timer_info, is_selected, is_highlighted, *draw_data.context);
 
   bool is_visible_width = elapsed_us * draw_data.inv_time_window * draw_data.canvas->GetWidth() > 1;
 
@@ -234,7 +233,9 @@ bool TimerTrack::DrawTimer(const TextBox* prev_text_box, const TextBox* next_tex
   return true;
 }
 
-void TimerTrack::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
+void TimerTrack::UpdatePrimitives(Batcher* batcher,
+                                  const orbit_gl::UpdatePrimitivesContext& context,
+                                  uint64_t min_tick, uint64_t max_tick,
                                   PickingMode /*picking_mode*/, float z_offset) {
   UpdateBoxHeight();
 
@@ -247,6 +248,7 @@ void TimerTrack::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t
 
   draw_data.batcher = batcher;
   draw_data.canvas = time_graph_->GetCanvas();
+  draw_data.context = &context;
 
   draw_data.world_start_x = draw_data.canvas->GetWorldTopLeftX();
   draw_data.world_width = draw_data.canvas->GetWorldWidth();
@@ -256,8 +258,6 @@ void TimerTrack::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t
   draw_data.z = GlCanvas::kZValueBox + z_offset;
 
   std::vector<std::shared_ptr<TimerChain>> chains_by_depth = GetTimers();
-  draw_data.selected_textbox = app_->selected_text_box();
-  draw_data.highlighted_function_id = app_->GetFunctionIdToHighlight();
 
   // We minimize overdraw when drawing lines for small events by discarding
   // events that would just draw over an already drawn line. When zoomed in
@@ -360,37 +360,13 @@ std::vector<std::shared_ptr<TimerChain>> TimerTrack::GetTimers() const {
 const TextBox* TimerTrack::GetFirstAfterTime(uint64_t time, uint32_t depth) const {
   std::shared_ptr<TimerChain> chain = GetTimers(depth);
   if (chain == nullptr) return nullptr;
-
-  // TODO: do better than linear search...
-  for (TimerChainIterator it = chain->begin(); it != chain->end(); ++it) {
-    for (size_t k = 0; k < it->size(); ++k) {
-      const TextBox& text_box = (*it)[k];
-      if (text_box.GetTimerInfo().start() > time) {
-        return &text_box;
-      }
-    }
-  }
-  return nullptr;
+  return chain->GetFirstElementStartingAfter(time);
 }
 
 const TextBox* TimerTrack::GetFirstBeforeTime(uint64_t time, uint32_t depth) const {
   std::shared_ptr<TimerChain> chain = GetTimers(depth);
   if (chain == nullptr) return nullptr;
-
-  const TextBox* text_box = nullptr;
-
-  // TODO: do better than linear search...
-  for (TimerChainIterator it = chain->begin(); it != chain->end(); ++it) {
-    for (size_t k = 0; k < it->size(); ++k) {
-      const TextBox& box = (*it)[k];
-      if (box.GetTimerInfo().start() > time) {
-        return text_box;
-      }
-      text_box = &box;
-    }
-  }
-
-  return nullptr;
+  return chain->GetLastElementStartingAtOrBefore(time);
 }
 
 std::shared_ptr<TimerChain> TimerTrack::GetTimers(uint32_t depth) const {
@@ -432,8 +408,8 @@ float TimerTrack::GetHeaderHeight() const { return layout_->GetEventTrackHeight(
 
 internal::DrawData TimerTrack::GetDrawData(uint64_t min_tick, uint64_t max_tick, float z_offset,
                                            Batcher* batcher, TimeGraph* time_graph,
-                                           bool is_collapsed, const TextBox* selected_textbox,
-                                           uint64_t highlighted_function_id) {
+                                           bool is_collapsed,
+                                           const orbit_gl::UpdatePrimitivesContext& context) {
   internal::DrawData draw_data;
   draw_data.min_tick = min_tick;
   draw_data.max_tick = max_tick;
@@ -445,8 +421,7 @@ internal::DrawData TimerTrack::GetDrawData(uint64_t min_tick, uint64_t max_tick,
   draw_data.inv_time_window = 1.0 / time_graph->GetTimeWindowUs();
   draw_data.is_collapsed = is_collapsed;
   draw_data.z = GlCanvas::kZValueBox + z_offset;
-  draw_data.selected_textbox = selected_textbox;
-  draw_data.highlighted_function_id = highlighted_function_id;
+  draw_data.context = &context;
 
   uint64_t time_window_ns = static_cast<uint64_t>(1000 * time_graph->GetTimeWindowUs());
   draw_data.ns_per_pixel = time_window_ns / draw_data.canvas->GetWidth();
@@ -24,6 +24,7 @@
 #include "TimerChain.h"
 #include "TracepointThreadBar.h"
 #include "Track.h"
+#include "UpdatePrimitivesContext.h"
 #include "absl/synchronization/mutex.h"
 #include "capture_data.pb.h"
 
@@ -34,12 +35,11 @@ namespace internal {
 struct DrawData {
   uint64_t min_tick;
   uint64_t max_tick;
-  uint64_t highlighted_function_id;
   uint64_t ns_per_pixel;
   uint64_t min_timegraph_tick;
   Batcher* batcher;
   GlCanvas* canvas;
-  const TextBox* selected_textbox;
+  const orbit_gl::UpdatePrimitivesContext* context;
   double inv_time_window;
   float world_start_x;
   float world_width;
@@ -61,8 +61,9 @@ class TimerTrack : public Track {
   [[nodiscard]] std::string GetTooltip() const override;
 
   // Track
-  void UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
-                        PickingMode /*picking_mode*/, float z_offset = 0) override;
+  void UpdatePrimitives(Batcher* batcher, const orbit_gl::UpdatePrimitivesContext& context,
+                        uint64_t min_tick, uint64_t max_tick, PickingMode /*picking_mode*/,
+                        float z_offset = 0) override;
   [[nodiscard]] Type GetType() const override { return kTimerTrack; }
 
   [[nodiscard]] std::vector<std::shared_ptr<TimerChain>> GetTimers() const override;
@@ -98,11 +99,13 @@ class TimerTrack : public Track {
 
  protected:
   [[nodiscard]] virtual bool IsTimerActive(
-      const orbit_client_protos::TimerInfo& /*timer_info*/) const {
+      const orbit_client_protos::TimerInfo& /*timer_info*/,
+      const orbit_gl::UpdatePrimitivesContext& /*context*/) const {
     return true;
   }
-  [[nodiscard]] virtual Color GetTimerColor(const orbit_client_protos::TimerInfo& timer_info,
-                                            bool is_selected, bool is_highlighted) const = 0;
+  [[nodiscard]] virtual Color GetTimerColor(
+      const orbit_client_protos::TimerInfo& timer_info, bool is_selected, bool is_highlighted,
+      const orbit_gl::UpdatePrimitivesContext& context) const = 0;
   [[nodiscard]] virtual bool TimerFilter(
       const orbit_client_protos::TimerInfo& /*timer_info*/) const {
     return true;
@@ -118,15 +121,13 @@ class TimerTrack : public Track {
   [[nodiscard]] std::shared_ptr<TimerChain> GetTimers(uint32_t depth) const;
 
   virtual void SetTimesliceText(const orbit_client_protos::TimerInfo& /*timer*/, float /*min_x*/,
-                                float /*z_offset*/, TextBox* /*text_box*/) {}
+                                float /*z_offset*/, TextBox* /*text_box*/,
+                                TextRenderer* /*text_renderer*/) {}
 
-  [[nodiscard]] static internal::DrawData GetDrawData(uint64_t min_tick, uint64_t max_tick,
-                                                      float z_offset, Batcher* batcher,
-                                                      TimeGraph* time_graph, bool is_collapsed,
-                                                      const TextBox* selected_textbox,
-                                                      uint64_t highlighted_function_id);
+  [[nodiscard]] static internal::DrawData GetDrawData(
+      uint64_t min_tick, uint64_t max_tick, float z_offset, Batcher* batcher,
+      TimeGraph* time_graph, bool is_collapsed, const orbit_gl::UpdatePrimitivesContext& context);
 
-  TextRenderer* text_renderer_ = nullptr;
   uint32_t depth_ = 0;
   mutable absl::Mutex mutex_;
   int visible_timer_count_ = 0;
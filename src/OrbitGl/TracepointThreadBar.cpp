@@ -50,9 +50,11 @@ void TracepointThreadBar::Draw(GlCanvas* canvas, PickingMode picking_mode, float
   ui_batcher->AddBox(box, color, shared_from_this());
 }
 
-void TracepointThreadBar::UpdatePrimitives(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
+void TracepointThreadBar::UpdatePrimitives(Batcher* batcher,
+                                           const orbit_gl::UpdatePrimitivesContext& context,
+                                           uint64_t min_tick, uint64_t max_tick,
                                            PickingMode picking_mode, float z_offset) {
-  ThreadBar::UpdatePrimitives(batcher, min_tick, max_tick, picking_mode, z_offset);
+  ThreadBar::UpdatePrimitives(batcher, context, min_tick, max_tick, picking_mode, z_offset);
 
   float z = GlCanvas::kZValueEvent + z_offset;
   float track_height = layout_->GetEventTrackHeight();
@@ -184,7 +184,9 @@ void Track::Draw(GlCanvas* canvas, PickingMode picking_mode, float z_offset) {
   }
 }
 
-void Track::UpdatePrimitives(Batcher* /*batcher*/, uint64_t /*t_min*/, uint64_t /*t_max*/,
+void Track::UpdatePrimitives(Batcher* /*batcher*/,
+                             const orbit_gl::UpdatePrimitivesContext& /*context*/,
+                             uint64_t /*t_min*/, uint64_t /*t_max*/,
                              PickingMode /*  picking_mode*/, float /*z_offset*/) {}
 
 void Track::SetPinned(bool value) { pinned_ = value; }
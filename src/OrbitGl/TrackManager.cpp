@@ -259,8 +259,9 @@ int TrackManager::FindMovingTrackIndex() {
   return -1;
 }
 
-void TrackManager::UpdateTracks(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
-                                PickingMode picking_mode) {
+void TrackManager::UpdateTracks(Batcher* batcher,
+                                const orbit_gl::UpdatePrimitivesContext& context,
+                                uint64_t min_tick, uint64_t max_tick, PickingMode picking_mode) {
   // Make sure track tab fits in the viewport.
   float current_y = -layout_->GetSchedulerTrackOffset() - layout_->GetTrackTabHeight();
   float pinned_tracks_height = 0.f;
@@ -277,7 +278,7 @@ void TrackManager::UpdateTracks(Batcher* batcher, uint64_t min_tick, uint64_t ma
                                             layout_->GetTopMargin() -
                                             layout_->GetSchedulerTrackOffset());
     }
-    track->UpdatePrimitives(batcher, min_tick, max_tick, picking_mode, z_offset);
+    track->UpdatePrimitives(batcher, context, min_tick, max_tick, picking_mode, z_offset);
     const float height = (track->GetHeight() + layout_->GetSpaceBetweenTracks());
     current_y -= height;
     pinned_tracks_height += height;
@@ -293,7 +294,7 @@ void TrackManager::UpdateTracks(Batcher* batcher, uint64_t min_tick, uint64_t ma
     if (!track->IsMoving()) {
       track->SetPos(track->GetPos()[0], current_y);
     }
-    track->UpdatePrimitives(batcher, min_tick, max_tick, picking_mode, z_offset);
+    track->UpdatePrimitives(batcher, context, min_tick, max_tick, picking_mode, z_offset);
     current_y -= (track->GetHeight() + layout_->GetSpaceBetweenTracks());
   }
 
@@ -25,6 +25,7 @@
 #include "ThreadTrack.h"
 #include "Timer.h"
 #include "Track.h"
+#include "UpdatePrimitivesContext.h"
 #include "capture_data.pb.h"
 
 class OrbitApp;
@@ -49,8 +50,8 @@ class TrackManager {
   void SortTracks();
   void SetFilter(const std::string& filter);
 
-  void UpdateTracks(Batcher* batcher, uint64_t min_tick, uint64_t max_tick,
-                    PickingMode picking_mode);
+  void UpdateTracks(Batcher* batcher, const orbit_gl::UpdatePrimitivesContext& context,
+                    uint64_t min_tick, uint64_t max_tick, PickingMode picking_mode);
   [[nodiscard]] float GetTracksTotalHeight() const { return tracks_total_height_; }
 
   [[nodiscard]] uint32_t GetNumTimers() const;
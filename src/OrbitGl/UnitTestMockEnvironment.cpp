@@ -18,3 +18,8 @@ ABSL_FLAG(bool, enable_frame_pointer_validator, false, "Enable validation of fra
 ABSL_FLAG(bool, show_return_values, false, "Show return values on time slices");
 ABSL_FLAG(bool, enable_tracepoint_feature, false,
           "Enable the setting of the panel of kernel tracepoints");
+ABSL_FLAG(bool, filter_tracepoints_in_kernel, false,
+          "Drop the scheduling and task tracepoint records of other processes in the kernel with "
+          "eBPF. The filters are attached to the tracepoints themselves, so while a capture runs, "
+          "other perf users on the host lose the sched_switch, sched_wakeup and task_* records "
+          "of other processes");
@@ -0,0 +1,37 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_GL_UPDATE_PRIMITIVES_CONTEXT_H_
+#define ORBIT_GL_UPDATE_PRIMITIVES_CONTEXT_H_
+
+#include <stdint.h>
+
+#include "GrpcProtos/Constants.h"
+#include "OrbitBase/ThreadConstants.h"
+#include "TextBox.h"
+#include "TextRenderer.h"
+#include "absl/container/flat_hash_set.h"
+
+namespace orbit_gl {
+
+// Everything the tracks need from the app while they update their primitives. The selection state
+// of the app may only be read on the UI thread, so TimeGraph takes this snapshot there and the
+// update itself, which may run on the thread pool, only reads the snapshot.
+struct UpdatePrimitivesContext {
+  [[nodiscard]] bool IsFunctionVisible(uint64_t function_id) const {
+    return visible_function_ids.contains(function_id);
+  }
+
+  // The text renderer that belongs to the batcher being updated.
+  TextRenderer* text_renderer = nullptr;
+  const TextBox* selected_text_box = nullptr;
+  uint64_t highlighted_function_id = orbit_grpc_protos::kInvalidFunctionId;
+  int32_t selected_thread_id = orbit_base::kAllProcessThreadsTid;
+  // The instrumented functions for which OrbitApp::IsFunctionVisible holds.
+  absl::flat_hash_set<uint64_t> visible_function_ids;
+};
+
+}  // namespace orbit_gl
+
+#endif  // ORBIT_GL_UPDATE_PRIMITIVES_CONTEXT_H_
@@ -183,12 +183,21 @@ void CaptureEventProducer::ConnectAndReceiveCommandsThread() {
       switch (response.command_case()) {
         case ReceiveCommandsAndSendEventsResponse::kStartCaptureCommand: {
           LOG("ProducerSideService sent StartCaptureCommand");
+          shared_memory_ring_buffers_supported_ =
+              response.start_capture_command().shared_memory_ring_buffers_supported();
+          interned_api_event_names_supported_ =
+              response.start_capture_command().interned_api_event_names_supported();
+          tsc_api_event_timestamps_supported_ =
+              response.start_capture_command().tsc_api_event_timestamps_supported();
+          // The id of the new capture is published before IsCapturing returns true for it.
           if (last_command_ == ReceiveCommandsAndSendEventsResponse::kCaptureFinishedCommand) {
+            ++capture_id_;
             last_command_ = ReceiveCommandsAndSendEventsResponse::kStartCaptureCommand;
             OnCaptureStart(response.start_capture_command().capture_options());
           } else if (last_command_ == ReceiveCommandsAndSendEventsResponse::kStopCaptureCommand) {
             last_command_ = ReceiveCommandsAndSendEventsResponse::kCaptureFinishedCommand;
             OnCaptureFinished();
+            ++capture_id_;
             last_command_ = ReceiveCommandsAndSendEventsResponse::kStartCaptureCommand;
             OnCaptureStart(response.start_capture_command().capture_options());
           }
@@ -201,6 +210,10 @@ void CaptureEventProducer::ConnectAndReceiveCommandsThread() {
             OnCaptureStop();
           } else if (last_command_ ==
                      ReceiveCommandsAndSendEventsResponse::kCaptureFinishedCommand) {
+            shared_memory_ring_buffers_supported_ = false;
+            interned_api_event_names_supported_ = false;
+            tsc_api_event_timestamps_supported_ = false;
+            ++capture_id_;
             last_command_ = ReceiveCommandsAndSendEventsResponse::kStartCaptureCommand;
             OnCaptureStart(orbit_grpc_protos::CaptureOptions{});
             last_command_ = ReceiveCommandsAndSendEventsResponse::kStopCaptureCommand;
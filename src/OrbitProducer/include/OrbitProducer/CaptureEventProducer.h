@@ -31,6 +31,29 @@ class CaptureEventProducer {
            orbit_grpc_protos::ReceiveCommandsAndSendEventsResponse::kStartCaptureCommand;
   }
 
+  // Returns an id that changes on every capture start. It is updated before IsCapturing returns
+  // true for the new capture, so a thread that sees the capture also sees its id.
+  [[nodiscard]] uint64_t GetCaptureId() const { return capture_id_; }
+
+  // Returns whether ProducerSideService reads events from the shared memory ring buffers of
+  // ProducerSideChannel/SharedMemoryRingBuffer.h in the current capture, as an alternative to
+  // sending them with SendCaptureEvents. Valid from OnCaptureStart.
+  [[nodiscard]] bool AreSharedMemoryRingBuffersSupported() const {
+    return shared_memory_ring_buffers_supported_;
+  }
+
+  // Returns whether ProducerSideService resolves the interned names of ApiEvents in the current
+  // capture. Valid from OnCaptureStart.
+  [[nodiscard]] bool AreInternedApiEventNamesSupported() const {
+    return interned_api_event_names_supported_;
+  }
+
+  // Returns whether ProducerSideService converts ApiEvent timestamps taken from the time stamp
+  // counter in the current capture. Valid from OnCaptureStart.
+  [[nodiscard]] bool AreTscApiEventTimestampsSupported() const {
+    return tsc_api_event_timestamps_supported_;
+  }
+
   // This method allows to specify how frequently a reconnection with the service should
   // be attempted when the connection fails or is interrupted. The default is 4 seconds.
   void SetReconnectionDelayMs(uint64_t ms) { reconnection_delay_ms_ = ms; }
@@ -77,6 +100,11 @@ class CaptureEventProducer {
   std::atomic<orbit_grpc_protos::ReceiveCommandsAndSendEventsResponse::CommandCase> last_command_ =
       orbit_grpc_protos::ReceiveCommandsAndSendEventsResponse::kCaptureFinishedCommand;
 
+  std::atomic<uint64_t> capture_id_ = 0;
+  std::atomic<bool> shared_memory_ring_buffers_supported_ = false;
+  std::atomic<bool> interned_api_event_names_supported_ = false;
+  std::atomic<bool> tsc_api_event_timestamps_supported_ = false;
+
   bool shutdown_requested_ = false;
   absl::Mutex shutdown_requested_mutex_;
 
@@ -57,6 +57,18 @@ class LockFreeBufferCaptureEventProducer : public CaptureEventProducer {
     lock_free_queue_.enqueue(std::move(event));
   }
 
+  // A thread that enqueues many events can create a token to enqueue them into its own sub-queue of
+  // the lock-free queue, which saves looking that sub-queue up on every call. The internal thread
+  // still dequeues from all sub-queues in bulk. The token must not outlive this object.
+  [[nodiscard]] moodycamel::ProducerToken CreateProducerToken() {
+    return moodycamel::ProducerToken{lock_free_queue_};
+  }
+
+  void EnqueueIntermediateEvent(const moodycamel::ProducerToken& producer_token,
+                                const IntermediateEventT& event) {
+    lock_free_queue_.enqueue(producer_token, event);
+  }
+
   bool EnqueueIntermediateEventIfCapturing(
       const std::function<IntermediateEventT()>& event_builder_if_capturing) {
     if (IsCapturing()) {
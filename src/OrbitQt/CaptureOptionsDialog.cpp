@@ -39,6 +39,15 @@ void CaptureOptionsDialog::SetCollectThreadStates(bool collect_thread_state) {
   ui_->threadStateCheckBox->setChecked(collect_thread_state);
 }
 
+bool CaptureOptionsDialog::GetEnableUserSpaceInstrumentation() const {
+  return ui_->userSpaceInstrumentationCheckBox->isChecked();
+}
+
+void CaptureOptionsDialog::SetEnableUserSpaceInstrumentation(
+    bool enable_user_space_instrumentation) {
+  ui_->userSpaceInstrumentationCheckBox->setChecked(enable_user_space_instrumentation);
+}
+
 void CaptureOptionsDialog::SetLimitLocalMarkerDepthPerCommandBuffer(
     bool limit_local_marker_depth_per_command_buffer) {
   ui_->localMarkerDepthCheckBox->setChecked(limit_local_marker_depth_per_command_buffer);
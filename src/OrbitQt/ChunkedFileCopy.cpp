@@ -0,0 +1,314 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ChunkedFileCopy.h"
+
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_format.h>
+#include <absl/strings/str_split.h>
+#include <openssl/sha.h>
+
+#include <algorithm>
+#include <array>
+#include <system_error>
+#include <utility>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/WriteStringToFile.h"
+
+namespace orbit_qt {
+
+namespace {
+
+ErrorMessageOr<std::string> ReadFileRegion(const orbit_base::unique_fd& fd,
+                                           const std::filesystem::path& file_path, uint64_t offset,
+                                           uint64_t size) {
+  std::string data(size, '\0');
+  OUTCOME_TRY(num_bytes_read,
+              orbit_base::ReadFullyAtOffset(fd, data.data(), size, static_cast<int64_t>(offset)));
+  if (num_bytes_read != size) {
+    return ErrorMessage{absl::StrFormat("Unable to read %u bytes at offset %u from \"%s\"", size,
+                                        offset, file_path.string())};
+  }
+  return data;
+}
+
+ErrorMessageOr<std::string> ReadFileRegion(const std::filesystem::path& file_path, uint64_t offset,
+                                           uint64_t size) {
+  OUTCOME_TRY(fd, orbit_base::OpenFileForReading(file_path));
+  return ReadFileRegion(fd, file_path, offset, size);
+}
+
+uint64_t GetChunkSize(uint64_t file_size, uint64_t chunk_index) {
+  return std::min(kCopyChunkSize, file_size - chunk_index * kCopyChunkSize);
+}
+
+// Returns true if `text` is "<number>-<number>".
+bool IsPairOfNumbers(std::string_view text) {
+  const size_t separator = text.find('-', 1);
+  if (separator == std::string_view::npos) return false;
+  int64_t first = 0;
+  int64_t second = 0;
+  return absl::SimpleAtoi(text.substr(0, separator), &first) &&
+         absl::SimpleAtoi(text.substr(separator + 1), &second);
+}
+
+}  // namespace
+
+uint64_t GetNumCopyChunks(uint64_t file_size) {
+  return (file_size + kCopyChunkSize - 1) / kCopyChunkSize;
+}
+
+std::string HashCopyChunk(std::string_view data) {
+  std::array<unsigned char, SHA256_DIGEST_LENGTH> digest{};
+  SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest.data());
+  std::string result;
+  result.reserve(2 * digest.size());
+  for (unsigned char byte : digest) {
+    absl::StrAppendFormat(&result, "%02x", byte);
+  }
+  return result;
+}
+
+ErrorMessageOr<LocalFileChunkIndex> LocalFileChunkIndex::Load(
+    std::filesystem::path index_file_path) {
+  LocalFileChunkIndex index{std::move(index_file_path)};
+  std::error_code error;
+  if (!std::filesystem::exists(index.index_file_path_, error)) return index;
+
+  OUTCOME_TRY(content, orbit_base::ReadFileToString(index.index_file_path_));
+  for (std::string_view line : absl::StrSplit(content, '\n', absl::SkipWhitespace())) {
+    std::vector<std::string_view> fields = absl::StrSplit(line, absl::MaxSplits(' ', 3));
+    Chunk chunk;
+    if (fields.size() != 4 || !absl::SimpleAtoi(fields[1], &chunk.location.offset) ||
+        !absl::SimpleAtoi(fields[2], &chunk.size)) {
+      ERROR("Ignoring malformed line in chunk index \"%s\": %s", index.index_file_path_.string(),
+            line);
+      continue;
+    }
+    chunk.location.file_path = std::filesystem::path{std::string{fields[3]}};
+    if (!std::filesystem::exists(chunk.location.file_path, error)) continue;
+    index.chunks_by_hash_[fields[0]].push_back(std::move(chunk));
+  }
+  return index;
+}
+
+std::optional<LocalFileChunkIndex::ChunkLocation> LocalFileChunkIndex::FindChunk(
+    const std::string& hash, uint64_t size) const {
+  auto it = chunks_by_hash_.find(hash);
+  if (it == chunks_by_hash_.end()) return std::nullopt;
+  for (const Chunk& chunk : it->second) {
+    if (chunk.size != size) continue;
+    ErrorMessageOr<std::string> data_or_error =
+        ReadFileRegion(chunk.location.file_path, chunk.location.offset, chunk.size);
+    if (data_or_error.has_value() && HashCopyChunk(data_or_error.value()) == hash) {
+      return chunk.location;
+    }
+  }
+  return std::nullopt;
+}
+
+ErrorMessageOr<void> LocalFileChunkIndex::AddFile(const std::filesystem::path& file_path,
+                                                  uint64_t file_size,
+                                                  const std::vector<std::string>& chunk_hashes) {
+  CHECK(chunk_hashes.size() == GetNumCopyChunks(file_size));
+  for (auto it = chunks_by_hash_.begin(); it != chunks_by_hash_.end();) {
+    std::vector<Chunk>& chunks = it->second;
+    chunks.erase(std::remove_if(chunks.begin(), chunks.end(),
+                                [&file_path](const Chunk& chunk) {
+                                  return chunk.location.file_path == file_path;
+                                }),
+                 chunks.end());
+    // absl::flat_hash_map::erase doesn't return an iterator.
+    if (chunks.empty()) {
+      chunks_by_hash_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+
+  for (uint64_t chunk_index = 0; chunk_index < chunk_hashes.size(); ++chunk_index) {
+    Chunk chunk;
+    chunk.location.file_path = file_path;
+    chunk.location.offset = chunk_index * kCopyChunkSize;
+    chunk.size = GetChunkSize(file_size, chunk_index);
+    chunks_by_hash_[chunk_hashes[chunk_index]].push_back(std::move(chunk));
+  }
+  return Save();
+}
+
+ErrorMessageOr<void> LocalFileChunkIndex::Save() const {
+  std::string content;
+  for (const auto& [hash, chunks] : chunks_by_hash_) {
+    for (const Chunk& chunk : chunks) {
+      absl::StrAppendFormat(&content, "%s %u %u %s\n", hash, chunk.location.offset, chunk.size,
+                            chunk.location.file_path.string());
+    }
+  }
+  return orbit_base::WriteStringToFile(index_file_path_, content);
+}
+
+uint64_t ChunkedCopyPlan::GetNumReusedBytes() const {
+  uint64_t num_reused_bytes = 0;
+  for (uint64_t chunk_index = 0; chunk_index < reused_chunks.size(); ++chunk_index) {
+    if (reused_chunks[chunk_index].has_value()) {
+      num_reused_bytes += GetChunkSize(file_size, chunk_index);
+    }
+  }
+  return num_reused_bytes;
+}
+
+ChunkedCopyPlan PlanChunkedCopy(uint64_t file_size,
+                                const std::vector<std::string>& remote_chunk_hashes,
+                                const LocalFileChunkIndex& index, size_t min_num_download_ranges) {
+  const uint64_t num_chunks = GetNumCopyChunks(file_size);
+  const bool has_hashes = remote_chunk_hashes.size() == num_chunks;
+
+  ChunkedCopyPlan plan;
+  plan.file_size = file_size;
+  plan.reused_chunks.resize(num_chunks);
+
+  // Ranges of chunks to download, as [begin, end) chunk indices.
+  std::vector<std::pair<uint64_t, uint64_t>> chunk_ranges;
+  for (uint64_t chunk_index = 0; chunk_index < num_chunks; ++chunk_index) {
+    if (has_hashes) {
+      plan.reused_chunks[chunk_index] = index.FindChunk(remote_chunk_hashes[chunk_index],
+                                                        GetChunkSize(file_size, chunk_index));
+      if (plan.reused_chunks[chunk_index].has_value()) continue;
+    }
+    if (!chunk_ranges.empty() && chunk_ranges.back().second == chunk_index) {
+      chunk_ranges.back().second = chunk_index + 1;
+    } else {
+      chunk_ranges.emplace_back(chunk_index, chunk_index + 1);
+    }
+  }
+
+  while (chunk_ranges.size() < min_num_download_ranges) {
+    auto largest = std::max_element(
+        chunk_ranges.begin(), chunk_ranges.end(), [](const auto& lhs, const auto& rhs) {
+          return lhs.second - lhs.first < rhs.second - rhs.first;
+        });
+    if (largest == chunk_ranges.end() || largest->second - largest->first < 2) break;
+    const uint64_t middle = largest->first + (largest->second - largest->first) / 2;
+    const uint64_t end = largest->second;
+    largest->second = middle;
+    chunk_ranges.emplace(largest + 1, middle, end);
+  }
+
+  for (const auto& [begin_chunk, end_chunk] : chunk_ranges) {
+    plan.download_ranges.push_back(ChunkedCopyPlan::Range{
+        begin_chunk * kCopyChunkSize, std::min(file_size, end_chunk * kCopyChunkSize)});
+  }
+  return plan;
+}
+
+ErrorMessageOr<std::vector<std::string>> AssembleChunkedCopy(
+    const ChunkedCopyPlan& plan, const std::vector<std::filesystem::path>& range_file_paths,
+    const std::vector<std::string>& remote_chunk_hashes, const std::filesystem::path& destination) {
+  CHECK(range_file_paths.size() == plan.download_ranges.size());
+  const std::filesystem::path temporary_path = destination.string() + ".tmp";
+  const bool has_hashes = remote_chunk_hashes.size() == plan.reused_chunks.size();
+
+  auto assemble = [&]() -> ErrorMessageOr<std::vector<std::string>> {
+    OUTCOME_TRY(destination_fd, orbit_base::OpenFileForWriting(temporary_path));
+    std::vector<std::string> chunk_hashes;
+    chunk_hashes.reserve(plan.reused_chunks.size());
+    size_t range_index = 0;
+    orbit_base::unique_fd range_fd;
+
+    for (uint64_t chunk_index = 0; chunk_index < plan.reused_chunks.size(); ++chunk_index) {
+      const uint64_t chunk_begin = chunk_index * kCopyChunkSize;
+      const uint64_t chunk_size = GetChunkSize(plan.file_size, chunk_index);
+      std::string data;
+      if (plan.reused_chunks[chunk_index].has_value()) {
+        const LocalFileChunkIndex::ChunkLocation& location =
+            plan.reused_chunks[chunk_index].value();
+        OUTCOME_TRY(chunk_data, ReadFileRegion(location.file_path, location.offset, chunk_size));
+        data = std::move(chunk_data);
+      } else {
+        while (range_index < plan.download_ranges.size() &&
+               plan.download_ranges[range_index].end <= chunk_begin) {
+          ++range_index;
+          range_fd.release();
+        }
+        if (range_index == plan.download_ranges.size() ||
+            plan.download_ranges[range_index].begin > chunk_begin) {
+          return ErrorMessage{absl::StrFormat("Chunk %u is neither reused nor downloaded",
+                                              chunk_index)};
+        }
+        const std::filesystem::path& range_file_path = range_file_paths[range_index];
+        if (!range_fd.valid()) {
+          OUTCOME_TRY(fd, orbit_base::OpenFileForReading(range_file_path));
+          range_fd = std::move(fd);
+        }
+        OUTCOME_TRY(chunk_data,
+                    ReadFileRegion(range_fd, range_file_path,
+                                   chunk_begin - plan.download_ranges[range_index].begin,
+                                   chunk_size));
+        data = std::move(chunk_data);
+      }
+
+      std::string hash = HashCopyChunk(data);
+      if (has_hashes && hash != remote_chunk_hashes[chunk_index]) {
+        return ErrorMessage{absl::StrFormat(
+            "Chunk %u of \"%s\" doesn't match the remote file", chunk_index, destination.string())};
+      }
+      OUTCOME_TRY(orbit_base::WriteFully(destination_fd, data));
+      chunk_hashes.push_back(std::move(hash));
+    }
+    return chunk_hashes;
+  };
+
+  ErrorMessageOr<std::vector<std::string>> result = assemble();
+  std::error_code error;
+  if (result.has_error()) {
+    std::filesystem::remove(temporary_path, error);
+    return result;
+  }
+  std::filesystem::rename(temporary_path, destination, error);
+  if (error) {
+    std::filesystem::remove(temporary_path, error);
+    return ErrorMessage{absl::StrFormat("Unable to rename \"%s\" to \"%s\": %s",
+                                        temporary_path.string(), destination.string(),
+                                        error.message())};
+  }
+  return result;
+}
+
+std::filesystem::path GetDownloadRangeFilePath(const std::filesystem::path& destination,
+                                               uint64_t remote_file_size,
+                                               int64_t remote_modification_time,
+                                               const ChunkedCopyPlan::Range& range) {
+  return absl::StrFormat("%s.%u-%d.range%u-%u", destination.string(), remote_file_size,
+                         remote_modification_time, range.begin, range.end);
+}
+
+void RemoveDownloadRangeFilesExcept(const std::filesystem::path& destination,
+                                    const std::vector<std::filesystem::path>& keep) {
+  const std::string prefix = destination.filename().string() + ".";
+  std::error_code error;
+  std::filesystem::directory_iterator it{destination.parent_path(), error};
+  if (error) return;
+
+  std::vector<std::filesystem::path> to_remove;
+  for (const std::filesystem::directory_entry& entry : it) {
+    const std::string file_name = entry.path().filename().string();
+    if (!absl::StartsWith(file_name, prefix)) continue;
+    std::vector<std::string_view> parts =
+        absl::StrSplit(std::string_view{file_name}.substr(prefix.size()), ".range");
+    if (parts.size() != 2 || !IsPairOfNumbers(parts[0]) || !IsPairOfNumbers(parts[1])) continue;
+    if (std::find(keep.begin(), keep.end(), entry.path()) != keep.end()) continue;
+    to_remove.push_back(entry.path());
+  }
+
+  for (const std::filesystem::path& path : to_remove) {
+    LOG("Removing stale download range file \"%s\"", path.string());
+    std::filesystem::remove(path, error);
+  }
+}
+
+}  // namespace orbit_qt
@@ -0,0 +1,126 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_QT_CHUNKED_FILE_COPY_H_
+#define ORBIT_QT_CHUNKED_FILE_COPY_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "OrbitBase/Result.h"
+
+// Helpers for copying a remote file in chunks, reusing the chunks that are already present in
+// local files. A chunk is identified by the SHA-256 of its content, so that a new version of a
+// file of which most parts did not change only needs the changed chunks to be transferred.
+
+namespace orbit_qt {
+
+constexpr uint64_t kCopyChunkSize = 4 * 1024 * 1024;
+
+// Returns the number of chunks of a file of `file_size` bytes. The last chunk can be shorter.
+[[nodiscard]] uint64_t GetNumCopyChunks(uint64_t file_size);
+
+// Returns the SHA-256 of `data` as a lowercase hex string, as printed by sha256sum.
+[[nodiscard]] std::string HashCopyChunk(std::string_view data);
+
+// Index of the chunks of files that were copied earlier. It is stored as a text file with one line
+// per chunk: "<sha256> <offset> <size> <file path>". Files can be modified or deleted after they
+// were indexed, so FindChunk verifies the content before returning a chunk.
+class LocalFileChunkIndex {
+ public:
+  struct ChunkLocation {
+    std::filesystem::path file_path;
+    uint64_t offset = 0;
+  };
+
+  // A missing index file results in an empty index. Entries of files that don't exist anymore are
+  // dropped.
+  [[nodiscard]] static ErrorMessageOr<LocalFileChunkIndex> Load(
+      std::filesystem::path index_file_path);
+
+  [[nodiscard]] bool IsEmpty() const { return chunks_by_hash_.empty(); }
+
+  // Returns a region of a local file that currently has `size` bytes with the SHA-256 `hash`.
+  [[nodiscard]] std::optional<ChunkLocation> FindChunk(const std::string& hash,
+                                                       uint64_t size) const;
+
+  // Replaces the entries of `file_path` by its chunks, chunk i having the hash `chunk_hashes[i]`,
+  // and saves the index.
+  [[nodiscard]] ErrorMessageOr<void> AddFile(const std::filesystem::path& file_path,
+                                             uint64_t file_size,
+                                             const std::vector<std::string>& chunk_hashes);
+
+ private:
+  struct Chunk {
+    ChunkLocation location;
+    uint64_t size = 0;
+  };
+
+  explicit LocalFileChunkIndex(std::filesystem::path index_file_path)
+      : index_file_path_(std::move(index_file_path)) {}
+
+  [[nodiscard]] ErrorMessageOr<void> Save() const;
+
+  std::filesystem::path index_file_path_;
+  absl::flat_hash_map<std::string, std::vector<Chunk>> chunks_by_hash_;
+};
+
+// How a remote file is put together locally: every chunk is either reused from a local file or
+// belongs to a byte range that is downloaded.
+struct ChunkedCopyPlan {
+  struct Range {
+    uint64_t begin = 0;
+    uint64_t end = 0;
+  };
+
+  uint64_t file_size = 0;
+  // One entry per chunk, the local location of its content or nullopt if it is downloaded.
+  std::vector<std::optional<LocalFileChunkIndex::ChunkLocation>> reused_chunks;
+  // Sorted, non-overlapping ranges that cover all the chunks that are downloaded.
+  std::vector<Range> download_ranges;
+
+  [[nodiscard]] uint64_t GetNumReusedBytes() const;
+};
+
+// Plans the copy of a remote file of `file_size` bytes. `remote_chunk_hashes` holds the SHA-256 of
+// every chunk of the remote file, or is empty if the remote could not compute them, in which case
+// all chunks are downloaded. Contiguous chunks to download are merged into ranges, then the largest
+// ranges are split at chunk boundaries until there are at least `min_num_download_ranges` (if the
+// chunks allow it), so that ranges can be downloaded in parallel.
+[[nodiscard]] ChunkedCopyPlan PlanChunkedCopy(uint64_t file_size,
+                                              const std::vector<std::string>& remote_chunk_hashes,
+                                              const LocalFileChunkIndex& index,
+                                              size_t min_num_download_ranges);
+
+// Writes `destination` from the reused chunks and the downloaded ranges, range
+// `plan.download_ranges[i]` being stored in `range_file_paths[i]`. Every chunk is verified against
+// `remote_chunk_hashes` if it holds one hash per chunk. The file is written next to `destination`
+// first and renamed at the end, so that chunks can be reused from an older version of
+// `destination` itself. Returns the hashes of all chunks of `destination`.
+[[nodiscard]] ErrorMessageOr<std::vector<std::string>> AssembleChunkedCopy(
+    const ChunkedCopyPlan& plan, const std::vector<std::filesystem::path>& range_file_paths,
+    const std::vector<std::string>& remote_chunk_hashes, const std::filesystem::path& destination);
+
+// Returns the path of the file next to `destination` that holds the downloaded `range` of a remote
+// file. The path contains the size and the modification time of the remote file, so that a range
+// downloaded from an earlier version of the remote file is never resumed.
+[[nodiscard]] std::filesystem::path GetDownloadRangeFilePath(
+    const std::filesystem::path& destination, uint64_t remote_file_size,
+    int64_t remote_modification_time, const ChunkedCopyPlan::Range& range);
+
+// Deletes the range files of `destination` (see GetDownloadRangeFilePath) that are not in `keep`,
+// i.e., the ones of an earlier version of the remote file or of a different plan.
+void RemoveDownloadRangeFilesExcept(const std::filesystem::path& destination,
+                                    const std::vector<std::filesystem::path>& keep);
+
+}  // namespace orbit_qt
+
+#endif  // ORBIT_QT_CHUNKED_FILE_COPY_H_
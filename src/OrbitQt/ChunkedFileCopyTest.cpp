@@ -0,0 +1,179 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "ChunkedFileCopy.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/TemporaryFile.h"
+#include "OrbitBase/WriteStringToFile.h"
+
+namespace orbit_qt {
+
+namespace {
+
+class ChunkedFileCopyTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto temporary_file_or_error = orbit_base::TemporaryFile::Create();
+    ASSERT_TRUE(temporary_file_or_error.has_value());
+    temporary_file_ = std::move(temporary_file_or_error.value());
+    directory_ = temporary_file_->file_path().string() + "_dir";
+    std::filesystem::create_directory(directory_);
+  }
+
+  void TearDown() override {
+    std::error_code error;
+    std::filesystem::remove_all(directory_, error);
+  }
+
+  [[nodiscard]] std::vector<std::string> HashChunks(const std::string& content) const {
+    std::vector<std::string> hashes;
+    for (uint64_t offset = 0; offset < content.size(); offset += kCopyChunkSize) {
+      hashes.push_back(HashCopyChunk(std::string_view{content}.substr(offset, kCopyChunkSize)));
+    }
+    return hashes;
+  }
+
+  std::optional<orbit_base::TemporaryFile> temporary_file_;
+  std::filesystem::path directory_;
+};
+
+// Returns `num_chunks` chunks, the last one being incomplete, with distinct content.
+std::string MakeContent(uint64_t num_chunks, char first_character) {
+  std::string content;
+  for (uint64_t i = 0; i < num_chunks; ++i) {
+    content.append(i + 1 < num_chunks ? kCopyChunkSize : kCopyChunkSize / 3,
+                   static_cast<char>(first_character + i));
+  }
+  return content;
+}
+
+}  // namespace
+
+TEST(ChunkedFileCopy, HashCopyChunkMatchesSha256sum) {
+  EXPECT_EQ(HashCopyChunk(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  EXPECT_EQ(HashCopyChunk("abc"),
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST(ChunkedFileCopy, PlanWithoutHashesDownloadsEverything) {
+  auto index_or_error = LocalFileChunkIndex::Load("/does/not/exist/chunk_index.txt");
+  ASSERT_TRUE(index_or_error.has_value());
+  EXPECT_TRUE(index_or_error.value().IsEmpty());
+
+  const uint64_t file_size = 10 * kCopyChunkSize + 1;
+  ChunkedCopyPlan plan = PlanChunkedCopy(file_size, {}, index_or_error.value(), 4);
+  EXPECT_EQ(plan.GetNumReusedBytes(), 0);
+  ASSERT_EQ(plan.download_ranges.size(), 4);
+  EXPECT_EQ(plan.download_ranges.front().begin, 0);
+  EXPECT_EQ(plan.download_ranges.back().end, file_size);
+  for (size_t i = 1; i < plan.download_ranges.size(); ++i) {
+    EXPECT_EQ(plan.download_ranges[i - 1].end, plan.download_ranges[i].begin);
+    EXPECT_EQ(plan.download_ranges[i].begin % kCopyChunkSize, 0);
+  }
+
+  // A single chunk can't be split.
+  plan = PlanChunkedCopy(kCopyChunkSize, {}, index_or_error.value(), 4);
+  EXPECT_EQ(plan.download_ranges.size(), 1);
+}
+
+TEST_F(ChunkedFileCopyTest, ReusesUnchangedChunksOfThePreviousVersion) {
+  const std::filesystem::path destination = directory_ / "file";
+  const std::filesystem::path index_path = directory_ / "chunk_index.txt";
+
+  // Previous version, copied earlier and indexed.
+  const std::string old_content = MakeContent(4, 'a');
+  ASSERT_TRUE(orbit_base::WriteStringToFile(destination, old_content).has_value());
+  {
+    auto index_or_error = LocalFileChunkIndex::Load(index_path);
+    ASSERT_TRUE(index_or_error.has_value());
+    ASSERT_TRUE(index_or_error.value()
+                    .AddFile(destination, old_content.size(), HashChunks(old_content))
+                    .has_value());
+  }
+
+  // New version: chunk 1 changed and a chunk was inserted before the last one.
+  const std::string new_content = old_content.substr(0, kCopyChunkSize) +
+                                  std::string(kCopyChunkSize, 'x') +
+                                  old_content.substr(2 * kCopyChunkSize, kCopyChunkSize) +
+                                  std::string(kCopyChunkSize, 'y') +
+                                  old_content.substr(3 * kCopyChunkSize);
+  const std::vector<std::string> new_hashes = HashChunks(new_content);
+
+  auto index_or_error = LocalFileChunkIndex::Load(index_path);
+  ASSERT_TRUE(index_or_error.has_value());
+  EXPECT_FALSE(index_or_error.value().IsEmpty());
+  ChunkedCopyPlan plan = PlanChunkedCopy(new_content.size(), new_hashes, index_or_error.value(), 1);
+
+  ASSERT_EQ(plan.reused_chunks.size(), 5);
+  EXPECT_TRUE(plan.reused_chunks[0].has_value());
+  EXPECT_FALSE(plan.reused_chunks[1].has_value());
+  EXPECT_TRUE(plan.reused_chunks[2].has_value());
+  EXPECT_FALSE(plan.reused_chunks[3].has_value());
+  EXPECT_TRUE(plan.reused_chunks[4].has_value());
+  EXPECT_EQ(plan.GetNumReusedBytes(), 2 * kCopyChunkSize + kCopyChunkSize / 3);
+  ASSERT_EQ(plan.download_ranges.size(), 2);
+
+  // Simulate the download of the ranges.
+  std::vector<std::filesystem::path> range_file_paths;
+  for (const ChunkedCopyPlan::Range& range : plan.download_ranges) {
+    range_file_paths.push_back(
+        GetDownloadRangeFilePath(destination, new_content.size(), 42, range));
+    ASSERT_TRUE(orbit_base::WriteStringToFile(
+                    range_file_paths.back(),
+                    std::string_view{new_content}.substr(range.begin, range.end - range.begin))
+                    .has_value());
+  }
+
+  auto hashes_or_error = AssembleChunkedCopy(plan, range_file_paths, new_hashes, destination);
+  ASSERT_TRUE(hashes_or_error.has_value()) << hashes_or_error.error().message();
+  EXPECT_EQ(hashes_or_error.value(), new_hashes);
+  auto content_or_error = orbit_base::ReadFileToString(destination);
+  ASSERT_TRUE(content_or_error.has_value());
+  EXPECT_EQ(content_or_error.value(), new_content);
+}
+
+TEST_F(ChunkedFileCopyTest, AssembleFailsOnMismatchingChunk) {
+  const std::filesystem::path destination = directory_ / "file";
+  const std::string content = MakeContent(2, 'a');
+  std::vector<std::string> hashes = HashChunks(content);
+  hashes[1] = HashCopyChunk("something else");
+
+  auto index_or_error = LocalFileChunkIndex::Load(directory_ / "chunk_index.txt");
+  ASSERT_TRUE(index_or_error.has_value());
+  ChunkedCopyPlan plan = PlanChunkedCopy(content.size(), hashes, index_or_error.value(), 1);
+  ASSERT_EQ(plan.download_ranges.size(), 1);
+  const std::filesystem::path range_file_path =
+      GetDownloadRangeFilePath(destination, content.size(), 42, plan.download_ranges[0]);
+  ASSERT_TRUE(orbit_base::WriteStringToFile(range_file_path, content).has_value());
+
+  EXPECT_TRUE(AssembleChunkedCopy(plan, {range_file_path}, hashes, destination).has_error());
+  EXPECT_FALSE(std::filesystem::exists(destination));
+  EXPECT_FALSE(std::filesystem::exists(destination.string() + ".tmp"));
+}
+
+TEST_F(ChunkedFileCopyTest, RemovesStaleDownloadRangeFiles) {
+  const std::filesystem::path destination = directory_ / "file";
+  const std::filesystem::path current =
+      GetDownloadRangeFilePath(destination, 100, 42, ChunkedCopyPlan::Range{0, 100});
+  const std::filesystem::path stale =
+      GetDownloadRangeFilePath(destination, 100, 41, ChunkedCopyPlan::Range{0, 100});
+  const std::filesystem::path unrelated = directory_ / "file.txt";
+  for (const std::filesystem::path& path : {current, stale, unrelated}) {
+    ASSERT_TRUE(orbit_base::WriteStringToFile(path, "content").has_value());
+  }
+
+  RemoveDownloadRangeFilesExcept(destination, {current});
+  EXPECT_TRUE(std::filesystem::exists(current));
+  EXPECT_FALSE(std::filesystem::exists(stale));
+  EXPECT_TRUE(std::filesystem::exists(unrelated));
+}
+
+}  // namespace orbit_qt
@@ -46,13 +46,19 @@ OrbitGLWidget::OrbitGLWidget(QWidget* parent) : QOpenGLWidget(parent) {
 }
 
 bool OrbitGLWidget::eventFilter(QObject* /*object*/, QEvent* event) {
+  if (!gl_canvas_) return false;
+
+  // Drawing, resizing and input access the canvas, so this is where the canvas finishes work that
+  // must not overlap with them. Other events, like the update requests of the refresh timer, don't
+  // wait for that work.
   if (event->type() == QEvent::Paint) {
-    if (gl_canvas_) {
-      gl_canvas_->PreRender();
-      if (!gl_canvas_->IsRedrawNeeded()) {
-        return true;
-      }
+    gl_canvas_->PreRender();
+    if (!gl_canvas_->IsRedrawNeeded()) {
+      return true;
     }
+    gl_canvas_->PreEvent();
+  } else if (event->type() == QEvent::Resize || dynamic_cast<QInputEvent*>(event) != nullptr) {
+    gl_canvas_->PreEvent();
   }
 
   return false;
@@ -207,6 +213,8 @@ void OrbitGLWidget::paintGL() {
 }
 
 void OrbitGLWidget::TakeScreenShot() {
+  // Grabbing the framebuffer draws the canvas again, outside of a paint event.
+  gl_canvas_->PreEvent();
   QImage img = this->grabFramebuffer();
   QImageWriter writer("screenshot", "jpg");
   writer.write(img);
@@ -273,6 +281,7 @@ void OrbitGLWidget::showContextMenu() {
 }
 
 void OrbitGLWidget::OnMenuClicked(int a_Index) {
+  gl_canvas_->PreEvent();
   const std::vector<std::string>& menu = gl_canvas_->GetContextMenu();
   gl_canvas_->OnContextMenu(menu[a_Index], a_Index);
 }
@@ -881,6 +881,8 @@ const QString OrbitMainWindow::kLimitLocalMarkerDepthPerCommandBufferSettingsKey
     "LimitLocalMarkerDepthPerCommandBuffer"};
 const QString OrbitMainWindow::kMaxLocalMarkerDepthPerCommandBufferSettingsKey{
     "MaxLocalMarkerDepthPerCommandBuffer"};
+const QString OrbitMainWindow::kEnableUserSpaceInstrumentationSettingKey{
+    "EnableUserSpaceInstrumentation"};
 
 constexpr uint64_t kMemorySamplingPeriodMsDefaultValue = 100;
 constexpr uint64_t kMemoryWarningThresholdKbDefaultValue = 1024 * 1024 * 8;  // 8Gb
@@ -915,6 +917,9 @@ void OrbitMainWindow::LoadCaptureOptionsIntoApp() {
         settings.value(kMaxLocalMarkerDepthPerCommandBufferSettingsKey, 0).toULongLong();
   }
   app_->SetMaxLocalMarkerDepthPerCommandBuffer(max_local_marker_depth_per_command_buffer);
+
+  app_->SetEnableUserSpaceInstrumentation(
+      settings.value(kEnableUserSpaceInstrumentationSettingKey, false).toBool());
 }
 
 void OrbitMainWindow::on_actionCaptureOptions_triggered() {
@@ -937,6 +942,8 @@ void OrbitMainWindow::on_actionCaptureOptions_triggered() {
       settings.value(kLimitLocalMarkerDepthPerCommandBufferSettingsKey, false).toBool());
   dialog.SetMaxLocalMarkerDepthPerCommandBuffer(
       settings.value(kMaxLocalMarkerDepthPerCommandBufferSettingsKey, 0).toULongLong());
+  dialog.SetEnableUserSpaceInstrumentation(
+      settings.value(kEnableUserSpaceInstrumentationSettingKey, false).toBool());
 
   int result = dialog.exec();
   if (result != QDialog::Accepted) {
@@ -953,6 +960,8 @@ void OrbitMainWindow::on_actionCaptureOptions_triggered() {
                     dialog.GetLimitLocalMarkerDepthPerCommandBuffer());
   settings.setValue(kMaxLocalMarkerDepthPerCommandBufferSettingsKey,
                     QString::number(dialog.GetMaxLocalMarkerDepthPerCommandBuffer()));
+  settings.setValue(kEnableUserSpaceInstrumentationSettingKey,
+                    dialog.GetEnableUserSpaceInstrumentation());
   LoadCaptureOptionsIntoApp();
 }
 
@@ -1250,11 +1259,13 @@ void OrbitMainWindow::OnStadiaConnectionError(std::error_code error) {
 void OrbitMainWindow::SetTarget(const orbit_qt::StadiaTarget& target) {
   const orbit_qt::StadiaConnection* connection = target.GetConnection();
   ServiceDeployManager* service_deploy_manager = connection->GetServiceDeployManager();
-  app_->SetSecureCopyCallback([service_deploy_manager](std::string_view source,
-                                                       std::string_view destination) {
-    CHECK(service_deploy_manager != nullptr);
-    return service_deploy_manager->CopyFileToLocal(std::string{source}, std::string{destination});
-  });
+  app_->SetSecureCopyCallback(
+      [service_deploy_manager](std::string_view source, std::string_view destination,
+                               OrbitApp::SecureCopyProgressCallback progress_callback) {
+        CHECK(service_deploy_manager != nullptr);
+        return service_deploy_manager->CopyFileToLocal(
+            std::string{source}, std::string{destination}, std::move(progress_callback));
+      });
 
   QObject::connect(service_deploy_manager, &ServiceDeployManager::socketErrorOccurred, this,
                    &OrbitMainWindow::OnStadiaConnectionError, Qt::UniqueConnection);
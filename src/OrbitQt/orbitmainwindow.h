@@ -174,6 +174,7 @@ class OrbitMainWindow final : public QMainWindow, public orbit_gl::MainWindowInt
   static const QString kMemoryWarningThresholdKbSettingKey;
   static const QString kLimitLocalMarkerDepthPerCommandBufferSettingsKey;
   static const QString kMaxLocalMarkerDepthPerCommandBufferSettingsKey;
+  static const QString kEnableUserSpaceInstrumentationSettingKey;
   void LoadCaptureOptionsIntoApp();
 
   [[nodiscard]] bool ConfirmExit();
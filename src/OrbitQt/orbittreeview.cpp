@@ -65,6 +65,7 @@ void OrbitTreeView::Initialize(DataView* data_view, SelectionType selection_type
 
   model_ = std::make_unique<OrbitTableModel>(data_view, /*parent=*/nullptr, text_alignment);
   setModel(model_.get());
+  data_view->SetUiRefreshCallback([this](RefreshMode refresh_mode) { Refresh(refresh_mode); });
   header()->resizeSections(QHeaderView::ResizeToContents);
 
   if (!model_->IsSortingAllowed()) {
@@ -94,23 +95,35 @@ void OrbitTreeView::Initialize(DataView* data_view, SelectionType selection_type
   }
 }
 
+OrbitTreeView::~OrbitTreeView() { ClearRefreshCallback(); }
+
 void OrbitTreeView::Deinitialize() {
   timer_.reset();
+  ClearRefreshCallback();
   setModel(nullptr);
   model_.reset();
 }
 
 void OrbitTreeView::SetDataModel(DataView* data_view) {
+  ClearRefreshCallback();
   model_ = std::make_unique<OrbitTableModel>();
   model_->SetDataView(data_view);
   setModel(model_.get());
+  data_view->SetUiRefreshCallback([this](RefreshMode refresh_mode) { Refresh(refresh_mode); });
 }
 
 void OrbitTreeView::ClearDataModel() {
+  ClearRefreshCallback();
   setModel(nullptr);
   model_.reset();
 }
 
+void OrbitTreeView::ClearRefreshCallback() {
+  if (model_ != nullptr && model_->GetDataView() != nullptr) {
+    model_->GetDataView()->SetUiRefreshCallback(nullptr);
+  }
+}
+
 void OrbitTreeView::OnSort(int section, Qt::SortOrder order) {
   if (model_ == nullptr) {
     return;
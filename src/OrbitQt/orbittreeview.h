@@ -32,6 +32,7 @@ class OrbitTreeView : public QTreeView {
   Q_OBJECT
  public:
   explicit OrbitTreeView(QWidget* parent = nullptr);
+  ~OrbitTreeView() override;
   void Initialize(DataView* data_view, SelectionType selection_type, FontType font_type,
                   bool uniform_row_height = true,
                   QFlags<Qt::AlignmentFlag> text_alignment = Qt::AlignVCenter | Qt::AlignLeft);
@@ -66,6 +67,9 @@ class OrbitTreeView : public QTreeView {
   void OnRowsSelected(std::vector<int>& rows);
 
  private:
+  // Data views are owned by OrbitApp and may outlive this tree view.
+  void ClearRefreshCallback();
+
   std::unique_ptr<OrbitTableModel> model_;
   std::unique_ptr<QTimer> timer_;
   std::vector<OrbitTreeView*> links_;
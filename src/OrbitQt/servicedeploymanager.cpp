@@ -6,15 +6,24 @@
 
 #include <absl/flags/declare.h>
 #include <absl/flags/flag.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
+#include <absl/strings/str_replace.h>
 #include <absl/strings/str_split.h>
+#include <absl/synchronization/mutex.h>
 
 #include <QApplication>
 #include <QEventLoop>
 #include <QMetaObject>
 #include <Qt>
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <system_error>
 #include <thread>
 #include <type_traits>
@@ -22,6 +31,7 @@
 #include <variant>
 #include <vector>
 
+#include "ChunkedFileCopy.h"
 #include "Error.h"
 #include "EventLoop.h"
 #include "OrbitBase/Future.h"
@@ -41,6 +51,8 @@ static const std::string kDebDestinationPath = "/tmp/orbitprofiler.deb";
 static const std::string kSigDestinationPath = "/tmp/orbitprofiler.deb.asc";
 static const std::string_view kSshWatchdogPassphrase = "start_watchdog";
 static const std::chrono::milliseconds kSshWatchdogInterval(1000);
+static constexpr size_t kNumParallelCopyStreams = 4;
+static const std::string kChunkIndexFileName = "chunk_index.txt";
 
 namespace orbit_qt {
 
@@ -64,6 +76,11 @@ template <typename Func>
       [loop]() { loop->error(make_error_code(Error::kUserCanceledServiceDeployment)); })};
 }
 
+// Quotes `argument` for the remote shell.
+std::string QuoteForShell(std::string_view argument) {
+  return absl::StrCat("'", absl::StrReplaceAll(argument, {{"'", R"('\'')"}}), "'");
+}
+
 void PrintAsOrbitService(const std::string& buffer) {
   std::vector<std::string_view> lines = absl::StrSplit(buffer, '\n');
   for (const auto& line : lines) {
@@ -281,63 +298,264 @@ outcome::result<void> ServiceDeployManager::CopyOrbitServicePackage() {
   return outcome::success();
 }
 
-ErrorMessageOr<void> ServiceDeployManager::CopyFileToLocal(std::string source,
-                                                           std::string destination) {
+ErrorMessageOr<void> ServiceDeployManager::CopyFileToLocal(
+    std::string source, std::string destination, CopyProgressCallback progress_callback) {
   orbit_base::Promise<ErrorMessageOr<void>> promise;
   auto future = promise.GetFuture();
 
+  // Progress is reported on the calling thread through `progress_context`. If the wait below is
+  // aborted, the background task keeps running after this method returns, so it only posts updates
+  // while `progress_context` is alive. Updates that are still queued are dropped with it.
+  struct ProgressForwarding {
+    absl::Mutex mutex;
+    QObject* context ABSL_GUARDED_BY(mutex) = nullptr;
+  };
+  QObject progress_context;
+  auto progress_forwarding = std::make_shared<ProgressForwarding>();
+  CopyProgressCallback forward_progress = nullptr;
+  if (progress_callback) {
+    {
+      absl::MutexLock lock(&progress_forwarding->mutex);
+      progress_forwarding->context = &progress_context;
+    }
+    forward_progress = [progress_forwarding, progress_callback = std::move(progress_callback)](
+                           uint64_t bytes_copied, uint64_t bytes_total) {
+      absl::MutexLock lock(&progress_forwarding->mutex);
+      if (progress_forwarding->context == nullptr) return;
+      QMetaObject::invokeMethod(progress_forwarding->context,
+                                [progress_callback, bytes_copied, bytes_total] {
+                                  progress_callback(bytes_copied, bytes_total);
+                                });
+    };
+  }
+
   DeferToBackgroundThreadAndWait(
       this, [this, source = std::move(source), destination = std::move(destination),
+             forward_progress = std::move(forward_progress),
              promise = std::move(promise)]() mutable {
-        promise.SetResult(CopyFileToLocalImpl(source, destination));
+        promise.SetResult(CopyFileToLocalImpl(source, destination, forward_progress));
       });
 
+  {
+    absl::MutexLock lock(&progress_forwarding->mutex);
+    progress_forwarding->context = nullptr;
+  }
+
   if (!future.IsFinished()) return ErrorMessage{"Copy operation was aborted."};
 
   return future.Get();
 }
 
-ErrorMessageOr<void> ServiceDeployManager::CopyFileToLocalImpl(std::string_view source,
-                                                               std::string_view destination) {
+ErrorMessageOr<ServiceDeployManager::RemoteFileInfo> ServiceDeployManager::GetRemoteFileInfo(
+    std::string_view source, bool with_chunk_hashes) {
   CHECK(QThread::currentThread() == thread());
-  LOG("Copying remote \"%s\" to local \"%s\"", source, destination);
-
-  auto sftp_channel = StartSftpChannel();
 
-  if (!sftp_channel) {
-    return ErrorMessage(
-        absl::StrFormat(R"(Unable to start sftp channel to copy the remote "%s" to "%s": %s)",
-                        source, destination, sftp_channel.error().message()));
+  // The first line of the output holds the size and the modification time of the file, each
+  // following line the hash of one chunk, as printed by sha256sum. split reads the file once and
+  // pipes each chunk into its own sha256sum, one after the other, so the hashes are in order.
+  const std::string quoted_source = QuoteForShell(source);
+  std::string command = absl::StrFormat("stat -L -c '%%s %%Y' %s", quoted_source);
+  if (with_chunk_hashes) {
+    absl::StrAppendFormat(&command, " && split -b %u --filter='sha256sum | cut -d\" \" -f1' -- %s",
+                          kCopyChunkSize, quoted_source);
   }
 
-  orbit_ssh_qt::SftpCopyToLocalOperation operation{&session_.value(), sftp_channel.value().get()};
+  orbit_ssh_qt::Task task{&session_.value(), command};
+  std::string output;
 
   EventLoop loop{};
-  auto quit_handler =
-      ConnectQuitHandler(&loop, &operation, &orbit_ssh_qt::SftpCopyToLocalOperation::stopped);
-  auto error_handler = ConnectErrorHandler(&loop, &operation,
-                                           &orbit_ssh_qt::SftpCopyToLocalOperation::errorOccurred);
+  QObject::connect(&task, &orbit_ssh_qt::Task::readyReadStdOut, &loop,
+                   [&output, &task]() { output += task.ReadStdOut(); });
+  QObject::connect(&task, &orbit_ssh_qt::Task::finished, &loop, &EventLoop::exit);
+  auto error_handler = ConnectErrorHandler(&loop, &task, &orbit_ssh_qt::Task::errorOccurred);
   auto cancel_handler = ConnectCancelHandler(&loop, this);
 
-  operation.CopyFileToLocal(source, destination);
+  task.Start();
 
   auto result = loop.exec();
   if (!result) {
-    return ErrorMessage(absl::StrFormat(R"(Error copying remote "%s" to "%s": %s)", source,
-                                        destination, result.error().message()));
+    return ErrorMessage{absl::StrFormat(R"(Unable to look up the remote "%s": %s)", source,
+                                        result.error().message())};
+  }
+  if (result.value() != 0) {
+    return ErrorMessage{absl::StrFormat(R"(Unable to look up the remote "%s", exit code: %d)",
+                                        source, result.value())};
+  }
+  output += task.ReadStdOut();
+
+  std::vector<std::string_view> lines = absl::StrSplit(output, '\n', absl::SkipWhitespace());
+  RemoteFileInfo info;
+  std::vector<std::string_view> size_and_time =
+      absl::StrSplit(lines.empty() ? std::string_view{} : lines[0], ' ');
+  if (size_and_time.size() != 2 || !absl::SimpleAtoi(size_and_time[0], &info.size) ||
+      !absl::SimpleAtoi(size_and_time[1], &info.modification_time)) {
+    return ErrorMessage{absl::StrFormat(R"(Unable to look up the remote "%s": unexpected output)",
+                                        source)};
   }
 
-  auto sftp_channel_stop_result = StopSftpChannel(sftp_channel.value().get());
+  if (with_chunk_hashes) {
+    for (size_t i = 1; i < lines.size(); ++i) info.chunk_hashes.emplace_back(lines[i]);
+    if (info.chunk_hashes.size() != GetNumCopyChunks(info.size)) {
+      // The file changed while it was hashed. Nothing can be reused then.
+      ERROR("Got %u chunk hashes instead of %u for the remote \"%s\"", info.chunk_hashes.size(),
+            GetNumCopyChunks(info.size), source);
+      info.chunk_hashes.clear();
+    }
+  }
+  return info;
+}
 
-  if (!sftp_channel_stop_result) {
-    std::string sftp_error_message =
-        absl::StrFormat(R"(Error closing sftp channel (after copied remote "%s" to "%s": %s))",
-                        source, destination, sftp_channel_stop_result.error().message());
-    ERROR("%s", sftp_error_message);
-    return ErrorMessage(
-        absl::StrFormat("Download of file %s failed: %s", source, sftp_error_message));
+ErrorMessageOr<void> ServiceDeployManager::CopyFileToLocalImpl(
+    std::string_view source, std::string_view destination,
+    const CopyProgressCallback& progress_callback) {
+  CHECK(QThread::currentThread() == thread());
+  LOG("Copying remote \"%s\" to local \"%s\"", source, destination);
+
+  const std::filesystem::path destination_path{std::string{destination}};
+  OUTCOME_TRY(index,
+              LocalFileChunkIndex::Load(destination_path.parent_path() / kChunkIndexFileName));
+
+  // Hashing the remote file reads all of it on the remote, which only pays off if local chunks can
+  // be reused.
+  OUTCOME_TRY(remote_file, GetRemoteFileInfo(source, !index.IsEmpty()));
+  const ChunkedCopyPlan plan =
+      PlanChunkedCopy(remote_file.size, remote_file.chunk_hashes, index, kNumParallelCopyStreams);
+  const uint64_t num_reused_bytes = plan.GetNumReusedBytes();
+  LOG("Reusing %u of %u bytes (%.1f%%) of the remote \"%s\" from local files", num_reused_bytes,
+      remote_file.size,
+      remote_file.size == 0 ? 0.0 : 100.0 * num_reused_bytes / remote_file.size, source);
+
+  std::vector<std::filesystem::path> range_file_paths;
+  for (const ChunkedCopyPlan::Range& range : plan.download_ranges) {
+    range_file_paths.push_back(GetDownloadRangeFilePath(
+        destination_path, remote_file.size, remote_file.modification_time, range));
   }
+  RemoveDownloadRangeFilesExcept(destination_path, range_file_paths);
+
+  OUTCOME_TRY(DownloadFileRanges(source, plan.download_ranges, range_file_paths, num_reused_bytes,
+                                 remote_file.size, progress_callback));
 
+  OUTCOME_TRY(chunk_hashes, AssembleChunkedCopy(plan, range_file_paths, remote_file.chunk_hashes,
+                                                destination_path));
+  std::error_code error;
+  for (const std::filesystem::path& range_file_path : range_file_paths) {
+    std::filesystem::remove(range_file_path, error);
+  }
+
+  auto add_result = index.AddFile(destination_path, remote_file.size, chunk_hashes);
+  if (add_result.has_error()) {
+    ERROR("Adding \"%s\" to the chunk index: %s", destination, add_result.error().message());
+  }
+  return outcome::success();
+}
+
+ErrorMessageOr<void> ServiceDeployManager::DownloadFileRanges(
+    std::string_view source, const std::vector<ChunkedCopyPlan::Range>& ranges,
+    const std::vector<std::filesystem::path>& range_file_paths, uint64_t num_reused_bytes,
+    uint64_t file_size, const CopyProgressCallback& progress_callback) {
+  CHECK(QThread::currentThread() == thread());
+  if (ranges.empty()) {
+    if (progress_callback) progress_callback(num_reused_bytes, file_size);
+    return outcome::success();
+  }
+
+  std::vector<std::unique_ptr<orbit_ssh_qt::SftpChannel>> sftp_channels;
+  ErrorMessageOr<void> result = DownloadFileRangesOverChannels(
+      source, ranges, range_file_paths, num_reused_bytes, file_size, progress_callback,
+      &sftp_channels);
+
+  // The channels are stopped on every path, also after an error or a cancellation, so that no
+  // channel is left open on the session.
+  for (auto& sftp_channel : sftp_channels) {
+    auto sftp_channel_stop_result = StopSftpChannel(sftp_channel.get());
+    if (!sftp_channel_stop_result) {
+      std::string sftp_error_message =
+          absl::StrFormat(R"(Error closing sftp channel (after copying the remote "%s": %s))",
+                          source, sftp_channel_stop_result.error().message());
+      ERROR("%s", sftp_error_message);
+      if (!result.has_error()) {
+        result = ErrorMessage(
+            absl::StrFormat("Download of file %s failed: %s", source, sftp_error_message));
+      }
+    }
+  }
+  return result;
+}
+
+ErrorMessageOr<void> ServiceDeployManager::DownloadFileRangesOverChannels(
+    std::string_view source, const std::vector<ChunkedCopyPlan::Range>& ranges,
+    const std::vector<std::filesystem::path>& range_file_paths, uint64_t num_reused_bytes,
+    uint64_t file_size, const CopyProgressCallback& progress_callback,
+    std::vector<std::unique_ptr<orbit_ssh_qt::SftpChannel>>* sftp_channels) {
+  // Throughput of a single sftp channel is bound by the round trips of its read requests, so
+  // the ranges are copied over separate channels at the same time. Each channel copies the next
+  // range that is not started yet when it is done with the previous one.
+  const size_t num_channels = std::min(kNumParallelCopyStreams, ranges.size());
+  for (size_t i = 0; i < num_channels; ++i) {
+    auto sftp_channel = StartSftpChannel();
+    if (!sftp_channel) {
+      return ErrorMessage(
+          absl::StrFormat(R"(Unable to start sftp channel to copy the remote "%s": %s)", source,
+                          sftp_channel.error().message()));
+    }
+    sftp_channels->push_back(std::move(sftp_channel.value()));
+  }
+
+  EventLoop loop{};
+  auto cancel_handler = ConnectCancelHandler(&loop, this);
+
+  std::vector<uint64_t> bytes_copied(ranges.size(), 0);
+  size_t next_range_index = 0;
+  size_t num_stopped_operations = 0;
+  std::vector<std::unique_ptr<orbit_ssh_qt::SftpCopyToLocalOperation>> operations;
+  std::vector<orbit_ssh_qt::ScopedConnection> connections;
+
+  std::function<void(orbit_ssh_qt::SftpChannel*)> start_next_range =
+      [&](orbit_ssh_qt::SftpChannel* sftp_channel) {
+        if (next_range_index == ranges.size()) return;
+        const size_t range_index = next_range_index++;
+        auto& operation = operations.emplace_back(
+            std::make_unique<orbit_ssh_qt::SftpCopyToLocalOperation>(&session_.value(),
+                                                                     sftp_channel));
+
+        connections.push_back(ConnectErrorHandler(
+            &loop, operation.get(), &orbit_ssh_qt::SftpCopyToLocalOperation::errorOccurred));
+        connections.emplace_back(QObject::connect(
+            operation.get(), &orbit_ssh_qt::SftpCopyToLocalOperation::stopped, &loop,
+            [&, sftp_channel]() {
+              if (++num_stopped_operations == ranges.size()) {
+                loop.quit();
+                return;
+              }
+              // Queued, so that the next operation doesn't start from within a signal of the
+              // previous one on the same channel.
+              QMetaObject::invokeMethod(
+                  &loop, [&, sftp_channel]() { start_next_range(sftp_channel); },
+                  Qt::QueuedConnection);
+            }));
+        connections.emplace_back(QObject::connect(
+            operation.get(), &orbit_ssh_qt::SftpCopyToLocalOperation::progress, &loop,
+            [&, range_index](uint64_t range_bytes_copied, uint64_t /*range_bytes_total*/) {
+              bytes_copied[range_index] = range_bytes_copied;
+              if (!progress_callback) return;
+              progress_callback(
+                  std::accumulate(bytes_copied.begin(), bytes_copied.end(), num_reused_bytes),
+                  file_size);
+            }));
+
+        operation->CopyFileRangeToLocal(std::string{source}, range_file_paths[range_index],
+                                        ranges[range_index].begin, ranges[range_index].end);
+      };
+
+  for (auto& sftp_channel : *sftp_channels) {
+    start_next_range(sftp_channel.get());
+  }
+
+  auto result = loop.exec();
+  if (!result) {
+    return ErrorMessage(absl::StrFormat(R"(Error copying the remote "%s": %s)", source,
+                                        result.error().message()));
+  }
   return outcome::success();
 }
 
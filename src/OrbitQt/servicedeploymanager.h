@@ -12,13 +12,17 @@
 #include <QString>
 #include <QThread>
 #include <QTimer>
+#include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <outcome.hpp>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <vector>
 
+#include "ChunkedFileCopy.h"
 #include "DeploymentConfigurations.h"
 #include "OrbitBase/Result.h"
 #include "OrbitSsh/Context.h"
@@ -47,8 +51,16 @@ class ServiceDeployManager : public QObject {
 
   outcome::result<GrpcPort> Exec();
 
-  // This method copies remote source file to local destination.
-  ErrorMessageOr<void> CopyFileToLocal(std::string source, std::string destination);
+  using CopyProgressCallback = std::function<void(uint64_t bytes_copied, uint64_t bytes_total)>;
+
+  // This method copies remote source file to local destination. The file is transferred in
+  // chunks: chunks whose content is already present in a file copied earlier to the directory of
+  // `destination` are reused, the others are downloaded in ranges over parallel sftp channels.
+  // Ranges of an interrupted copy are kept next to `destination` and are resumed by the next copy
+  // of the same version of the file. `progress_callback` (if set) is called on the calling thread
+  // while it waits for the copy to finish.
+  ErrorMessageOr<void> CopyFileToLocal(std::string source, std::string destination,
+                                       CopyProgressCallback progress_callback = nullptr);
 
   void Shutdown();
   void Cancel();
@@ -85,7 +97,27 @@ class ServiceDeployManager : public QObject {
       const std::string& source, const std::string& dest,
       orbit_ssh_qt::SftpCopyToRemoteOperation::FileMode dest_mode);
 
-  ErrorMessageOr<void> CopyFileToLocalImpl(std::string_view source, std::string_view destination);
+  struct RemoteFileInfo {
+    uint64_t size = 0;
+    int64_t modification_time = 0;
+    // The SHA-256 of every chunk of the file, or empty if they were not requested or could not be
+    // computed.
+    std::vector<std::string> chunk_hashes;
+  };
+  ErrorMessageOr<RemoteFileInfo> GetRemoteFileInfo(std::string_view source,
+                                                   bool with_chunk_hashes);
+  ErrorMessageOr<void> CopyFileToLocalImpl(std::string_view source, std::string_view destination,
+                                           const CopyProgressCallback& progress_callback);
+  ErrorMessageOr<void> DownloadFileRanges(
+      std::string_view source, const std::vector<ChunkedCopyPlan::Range>& ranges,
+      const std::vector<std::filesystem::path>& range_file_paths, uint64_t num_reused_bytes,
+      uint64_t file_size, const CopyProgressCallback& progress_callback);
+  // Starts the channels, which are added to `sftp_channels` to be stopped by the caller.
+  ErrorMessageOr<void> DownloadFileRangesOverChannels(
+      std::string_view source, const std::vector<ChunkedCopyPlan::Range>& ranges,
+      const std::vector<std::filesystem::path>& range_file_paths, uint64_t num_reused_bytes,
+      uint64_t file_size, const CopyProgressCallback& progress_callback,
+      std::vector<std::unique_ptr<orbit_ssh_qt::SftpChannel>>* sftp_channels);
   outcome::result<GrpcPort> ExecImpl();
 
   void StartWatchdog();
@@ -80,4 +80,26 @@ outcome::result<size_t> SftpFile::Write(std::string_view data) {
   return outcome::success(result);
 }
 
+void SftpFile::Seek(uint64_t offset) { libssh2_sftp_seek64(file_ptr_.get(), offset); }
+
+outcome::result<uint64_t> SftpFile::GetSize() {
+  LIBSSH2_SFTP_ATTRIBUTES attributes{};
+  const auto result = libssh2_sftp_fstat_ex(file_ptr_.get(), &attributes, 0);
+
+  if (result < 0) {
+    if (result != LIBSSH2_ERROR_EAGAIN) {
+      ERROR("Unable to stat sftp file \"%s\": %s", filepath_,
+            LibSsh2SessionLastError(session_->GetRawSessionPtr()).second);
+    }
+    return static_cast<Error>(result);
+  }
+
+  if ((attributes.flags & LIBSSH2_SFTP_ATTR_SIZE) == 0) {
+    ERROR("Remote did not report the size of sftp file \"%s\"", filepath_);
+    return Error::kSftpProtocol;
+  }
+
+  return outcome::success(attributes.filesize);
+}
+
 }  // namespace orbit_ssh
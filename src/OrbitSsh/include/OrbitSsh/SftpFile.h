@@ -43,6 +43,10 @@ class SftpFile {
   outcome::result<std::string> Read(size_t max_length_in_bytes);
   outcome::result<void> Close();
   outcome::result<size_t> Write(std::string_view data);
+  // Moves the position of the next Read or Write to `offset` bytes from the beginning of the file.
+  // This does not involve any communication with the remote, so it cannot fail.
+  void Seek(uint64_t offset);
+  outcome::result<uint64_t> GetSize();
 
   [[nodiscard]] LIBSSH2_SFTP_HANDLE* GetRawFilePtr() const noexcept { return file_ptr_.get(); }
 
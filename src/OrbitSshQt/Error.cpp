@@ -24,6 +24,10 @@ std::string ErrorCategory::message(int condition) const {
       return "The local socket was closed.";
     case Error::kCouldNotOpenFile:
       return "Could not open file.";
+    case Error::kCouldNotWriteFile:
+      return "Could not write file.";
+    case Error::kRemoteFileTruncated:
+      return "The remote file is shorter than expected.";
   }
 
   return absl::StrFormat("Unkown error condition: %i.", condition);
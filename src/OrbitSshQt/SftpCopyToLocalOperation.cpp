@@ -8,6 +8,7 @@
 #include <stddef.h>
 
 #include <QIODevice>
+#include <algorithm>
 #include <string>
 #include <utility>
 
@@ -32,6 +33,21 @@ void SftpCopyToLocalOperation::CopyFileToLocal(std::filesystem::path source,
                                                std::filesystem::path destination) {
   source_ = std::move(source);
   destination_ = std::move(destination);
+  copy_range_ = false;
+
+  SetState(State::kNoOperation);
+  OnEvent();
+}
+
+void SftpCopyToLocalOperation::CopyFileRangeToLocal(std::filesystem::path source,
+                                                    std::filesystem::path destination,
+                                                    uint64_t range_begin, uint64_t range_end) {
+  CHECK(range_begin <= range_end);
+  source_ = std::move(source);
+  destination_ = std::move(destination);
+  copy_range_ = true;
+  range_begin_ = range_begin;
+  range_end_ = range_end;
 
   SetState(State::kNoOperation);
   OnEvent();
@@ -63,27 +79,56 @@ outcome::result<void> SftpCopyToLocalOperation::startup() {
     }
     case State::kStarted:
     case State::kRemoteFileOpened: {
+      OUTCOME_TRY(file_size, sftp_file_->GetSize());
+      if (!copy_range_) {
+        range_begin_ = 0;
+        range_end_ = file_size;
+      } else if (file_size < range_end_) {
+        return Error::kRemoteFileTruncated;
+      }
+      SetState(State::kRemoteFileSizeRetrieved);
+      ABSL_FALLTHROUGH_INTENDED;
+    }
+    case State::kRemoteFileSizeRetrieved: {
       local_file_.setFileName(QString::fromStdString(destination_.string()));
-      const auto open_result = local_file_.open(QIODevice::WriteOnly);
+      position_ = range_begin_;
+
+      bool open_result = false;
+      if (copy_range_ && local_file_.exists() &&
+          static_cast<uint64_t>(local_file_.size()) <= range_end_ - range_begin_) {
+        open_result = local_file_.open(QIODevice::WriteOnly | QIODevice::Append);
+        position_ += local_file_.size();
+      } else {
+        open_result = local_file_.open(QIODevice::WriteOnly | QIODevice::Truncate);
+      }
       if (!open_result) {
         return Error::kCouldNotOpenFile;
       }
+
+      sftp_file_->Seek(position_);
+      emit progress(position_ - range_begin_, range_end_ - range_begin_);
       SetState(State::kLocalFileOpened);
       ABSL_FALLTHROUGH_INTENDED;
     }
     case State::kLocalFileOpened: {
-      constexpr size_t kReadBufferMaxSize = 1 * 1024 * 1024;
+      constexpr uint64_t kReadBufferMaxSize = 1 * 1024 * 1024;
 
-      while (true) {
-        OUTCOME_TRY(read_buffer, sftp_file_->Read(kReadBufferMaxSize));
+      while (position_ < range_end_) {
+        OUTCOME_TRY(read_buffer,
+                    sftp_file_->Read(std::min(kReadBufferMaxSize, range_end_ - position_)));
         if (read_buffer.empty()) {
-          // This is end of file
-          SetState(State::kLocalFileWritten);
-          break;
+          // The file was truncated on the remote while we were copying it.
+          return Error::kRemoteFileTruncated;
         }
 
-        local_file_.write(read_buffer.data(), read_buffer.size());
+        if (local_file_.write(read_buffer.data(), read_buffer.size()) !=
+            static_cast<qint64>(read_buffer.size())) {
+          return Error::kCouldNotWriteFile;
+        }
+        position_ += read_buffer.size();
+        emit progress(position_ - range_begin_, range_end_ - range_begin_);
       }
+      SetState(State::kLocalFileWritten);
       ABSL_FALLTHROUGH_INTENDED;
     }
     case State::kLocalFileWritten: {
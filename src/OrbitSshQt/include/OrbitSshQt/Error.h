@@ -18,7 +18,9 @@ enum class Error {
   kCouldNotListen,
   kRemoteSocketClosed,
   kLocalSocketClosed,
-  kCouldNotOpenFile
+  kCouldNotOpenFile,
+  kCouldNotWriteFile,
+  kRemoteFileTruncated
 };
 
 struct ErrorCategory : std::error_category {
@@ -27,6 +27,7 @@ enum class SftpCopyToLocalOperationState {
   kNoOperation,
   kStarted,
   kRemoteFileOpened,
+  kRemoteFileSizeRetrieved,
   kLocalFileOpened,
   kLocalFileWritten,
   kLocalFileClosed,
@@ -40,7 +41,10 @@ enum class SftpCopyToLocalOperationState {
   SftpCopyToRemoteOperation represents a file operation in the SSH-SFTP
   subsystem. It needs an established SftpChannel for operation.
 
-  This operation implements remote -> local copying.
+  This operation implements remote -> local copying. Either a whole file or a
+  byte range of it is copied, so that the ranges of a large file can be copied
+  by several operations in parallel (each on its own channel). Copying a range
+  resumes an earlier, interrupted copy of the same range.
 */
 class SftpCopyToLocalOperation
     : public StateMachineHelper<SftpCopyToLocalOperation, details::SftpCopyToLocalOperationState> {
@@ -52,8 +56,19 @@ class SftpCopyToLocalOperation
 
   void CopyFileToLocal(std::filesystem::path source, std::filesystem::path destination);
 
+  // Copies the bytes [`range_begin`, `range_end`) of `source` to `destination`. If `destination`
+  // already exists, it is considered to be the beginning of that range from an earlier attempt and
+  // only the rest of the range is copied. The caller has to make sure that `destination` was
+  // written from the same version of `source`, for example by naming it after the size and the
+  // modification time of `source`. Fails with Error::kRemoteFileTruncated if `source` has less
+  // than `range_end` bytes.
+  void CopyFileRangeToLocal(std::filesystem::path source, std::filesystem::path destination,
+                            uint64_t range_begin, uint64_t range_end);
+
  signals:
   void started();
+  // Emitted after each chunk written to `destination`. Both values refer to the copied range only.
+  void progress(uint64_t bytes_copied, uint64_t bytes_total);
   void stopped();
   void aboutToShutdown();
   void errorOccurred(std::error_code);
@@ -70,6 +85,12 @@ class SftpCopyToLocalOperation
 
   std::filesystem::path source_;
   std::filesystem::path destination_;
+  bool copy_range_ = false;
+
+  // The range of the remote file covered by this operation and the current read position.
+  uint64_t range_begin_ = 0;
+  uint64_t range_end_ = 0;
+  uint64_t position_ = 0;
 
   void HandleChannelShutdown();
   void HandleEagain();
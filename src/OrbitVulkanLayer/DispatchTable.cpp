@@ -35,45 +35,31 @@ void DispatchTable::CreateInstanceDispatchTable(
   dispatch_table.DebugReportMessageEXT = absl::bit_cast<PFN_vkDebugReportMessageEXT>(
       next_get_instance_proc_addr_function(instance, "vkDebugReportMessageEXT"));
 
+  auto entry = std::make_unique<InstanceEntry>();
+  entry->dispatch_table = dispatch_table;
+  entry->supports_debug_utils_extension = dispatch_table.CreateDebugUtilsMessengerEXT != nullptr &&
+                                         dispatch_table.DestroyDebugUtilsMessengerEXT != nullptr &&
+                                         dispatch_table.SubmitDebugUtilsMessageEXT != nullptr;
+  entry->supports_debug_report_extension = dispatch_table.CreateDebugReportCallbackEXT != nullptr &&
+                                          dispatch_table.DestroyDebugReportCallbackEXT != nullptr &&
+                                          dispatch_table.DebugReportMessageEXT != nullptr;
+  entry->instance = instance;
+
   void* key = GetDispatchTableKey(instance);
-  {
-    absl::WriterMutexLock lock(&mutex_);
-    CHECK(!instance_dispatch_table_.contains(key));
-    instance_dispatch_table_[key] = dispatch_table;
-
-    CHECK(!instance_supports_debug_utils_extension_.contains(key));
-    instance_supports_debug_utils_extension_[key] =
-        dispatch_table.CreateDebugUtilsMessengerEXT != nullptr &&
-        dispatch_table.DestroyDebugUtilsMessengerEXT != nullptr &&
-        dispatch_table.SubmitDebugUtilsMessageEXT != nullptr;
-
-    CHECK(!instance_supports_debug_report_extension_.contains(key));
-    instance_supports_debug_report_extension_[key] =
-        dispatch_table.CreateDebugReportCallbackEXT != nullptr &&
-        dispatch_table.DestroyDebugReportCallbackEXT != nullptr &&
-        dispatch_table.DebugReportMessageEXT != nullptr;
-
-    CHECK(!instance_dispatchable_object_to_instance_.contains(key));
-    instance_dispatchable_object_to_instance_[key] = instance;
-  }
+  absl::MutexLock lock(&mutex_);
+  const InstanceEntry* entry_pointer = entry.get();
+  CHECK(instance_entries_.emplace(key, std::move(entry)).second);
+  UpdateSnapshot([key, entry_pointer](Snapshot* snapshot) {
+    snapshot->instances.emplace(key, entry_pointer);
+  });
 }
 
 void DispatchTable::RemoveInstanceDispatchTable(VkInstance instance) {
   void* key = GetDispatchTableKey(instance);
-  {
-    absl::WriterMutexLock lock(&mutex_);
-    CHECK(instance_dispatch_table_.contains(key));
-    instance_dispatch_table_.erase(key);
-
-    CHECK(instance_supports_debug_utils_extension_.contains(key));
-    instance_supports_debug_utils_extension_.erase(key);
-
-    CHECK(instance_supports_debug_report_extension_.contains(key));
-    instance_supports_debug_report_extension_.erase(key);
-
-    CHECK(instance_dispatchable_object_to_instance_.contains(key));
-    instance_dispatchable_object_to_instance_.erase(key);
-  }
+  absl::MutexLock lock(&mutex_);
+  CHECK(instance_entries_.contains(key));
+  UpdateSnapshot([key](Snapshot* snapshot) { snapshot->instances.erase(key); });
+  instance_entries_.erase(key);
 }
 
 void DispatchTable::CreateDeviceDispatchTable(
@@ -152,47 +138,44 @@ void DispatchTable::CreateDeviceDispatchTable(
   dispatch_table.CmdDebugMarkerInsertEXT = absl::bit_cast<PFN_vkCmdDebugMarkerInsertEXT>(
       next_get_device_proc_addr_function(device, "vkCmdDebugMarkerInsertEXT"));
 
+  auto entry = std::make_unique<DeviceEntry>();
+  entry->dispatch_table = dispatch_table;
+  entry->supports_debug_utils_extension = dispatch_table.CmdBeginDebugUtilsLabelEXT != nullptr &&
+                                         dispatch_table.CmdEndDebugUtilsLabelEXT != nullptr &&
+                                         dispatch_table.SetDebugUtilsObjectNameEXT != nullptr &&
+                                         dispatch_table.SetDebugUtilsObjectTagEXT != nullptr &&
+                                         dispatch_table.QueueBeginDebugUtilsLabelEXT != nullptr &&
+                                         dispatch_table.QueueEndDebugUtilsLabelEXT != nullptr &&
+                                         dispatch_table.QueueInsertDebugUtilsLabelEXT != nullptr &&
+                                         dispatch_table.CmdInsertDebugUtilsLabelEXT != nullptr;
+  entry->supports_debug_marker_extension = dispatch_table.CmdDebugMarkerBeginEXT != nullptr &&
+                                          dispatch_table.CmdDebugMarkerEndEXT != nullptr &&
+                                          dispatch_table.DebugMarkerSetObjectTagEXT != nullptr &&
+                                          dispatch_table.DebugMarkerSetObjectNameEXT != nullptr &&
+                                          dispatch_table.CmdDebugMarkerInsertEXT != nullptr;
+
   void* key = GetDispatchTableKey(device);
-  {
-    absl::WriterMutexLock lock(&mutex_);
-    CHECK(!device_dispatch_table_.contains(key));
-    device_dispatch_table_[key] = dispatch_table;
-
-    CHECK(!device_supports_debug_utils_extension_.contains(key));
-    device_supports_debug_utils_extension_[key] =
-        dispatch_table.CmdBeginDebugUtilsLabelEXT != nullptr &&
-        dispatch_table.CmdEndDebugUtilsLabelEXT != nullptr &&
-        dispatch_table.SetDebugUtilsObjectNameEXT != nullptr &&
-        dispatch_table.SetDebugUtilsObjectTagEXT != nullptr &&
-        dispatch_table.QueueBeginDebugUtilsLabelEXT != nullptr &&
-        dispatch_table.QueueEndDebugUtilsLabelEXT != nullptr &&
-        dispatch_table.QueueInsertDebugUtilsLabelEXT != nullptr &&
-        dispatch_table.CmdInsertDebugUtilsLabelEXT != nullptr;
-
-    CHECK(!device_supports_debug_marker_extension_.contains(key));
-    device_supports_debug_marker_extension_[key] =
-        dispatch_table.CmdDebugMarkerBeginEXT != nullptr &&
-        dispatch_table.CmdDebugMarkerEndEXT != nullptr &&
-        dispatch_table.DebugMarkerSetObjectTagEXT != nullptr &&
-        dispatch_table.DebugMarkerSetObjectNameEXT != nullptr &&
-        dispatch_table.CmdDebugMarkerInsertEXT != nullptr;
-  }
+  absl::MutexLock lock(&mutex_);
+  const DeviceEntry* entry_pointer = entry.get();
+  CHECK(device_entries_.emplace(key, std::move(entry)).second);
+  UpdateSnapshot(
+      [key, entry_pointer](Snapshot* snapshot) { snapshot->devices.emplace(key, entry_pointer); });
 }
 
 void DispatchTable::RemoveDeviceDispatchTable(VkDevice device) {
   void* key = GetDispatchTableKey(device);
-  {
-    absl::WriterMutexLock lock(&mutex_);
-
-    CHECK(device_dispatch_table_.contains(key));
-    device_dispatch_table_.erase(key);
-
-    CHECK(device_supports_debug_utils_extension_.contains(key));
-    device_supports_debug_utils_extension_.erase(key);
+  absl::MutexLock lock(&mutex_);
+  CHECK(device_entries_.contains(key));
+  UpdateSnapshot([key](Snapshot* snapshot) { snapshot->devices.erase(key); });
+  device_entries_.erase(key);
+}
 
-    CHECK(device_supports_debug_marker_extension_.contains(key));
-    device_supports_debug_marker_extension_.erase(key);
-  }
+void DispatchTable::UpdateSnapshot(const std::function<void(Snapshot*)>& modify) {
+  auto snapshot = std::make_unique<Snapshot>(*snapshot_);
+  modify(snapshot.get());
+  current_snapshot_.store(snapshot.get());
+  snapshot_readers_.WaitForReadersOfReplacedSnapshot();
+  snapshot_ = std::move(snapshot);
 }
 
 }  // namespace orbit_vulkan_layer
\ No newline at end of file
@@ -10,7 +10,13 @@
 #include <absl/container/flat_hash_set.h>
 #include <absl/synchronization/mutex.h>
 
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
 #include "OrbitBase/Logging.h"
+#include "SnapshotReaders.h"
 
 // clang-format off
 #include <vulkan/vulkan.h> // IWYU pragma: keep
@@ -28,12 +34,14 @@ namespace orbit_vulkan_layer {
  * For functions provided by extensions it also provides predicate functions to check if the
  * extension is available.
  *
- * Thread-Safety: This class is internally synchronized (using read/write locks) and can be safely
- * accessed from different threads.
+ * Thread-Safety: This class is internally synchronized and can be safely accessed from different
+ * threads. Look-ups don't take any lock: they read a copy-on-write snapshot of the tables.
  */
 class DispatchTable {
  public:
-  DispatchTable() = default;
+  DispatchTable() : snapshot_{std::make_unique<Snapshot>()} {
+    current_snapshot_ = snapshot_.get();
+  }
 
   void CreateInstanceDispatchTable(VkInstance instance,
                                    PFN_vkGetInstanceProcAddr next_get_instance_proc_addr_function);
@@ -45,235 +53,151 @@ class DispatchTable {
 
   template <typename DispatchableType>
   PFN_vkDestroyDevice DestroyDevice(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).DestroyDevice != nullptr);
-      return device_dispatch_table_.at(key).DestroyDevice;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.DestroyDevice != nullptr);
+    return dispatch_table.DestroyDevice;
   }
 
   template <typename DispatchableType>
   PFN_vkDestroyInstance DestroyInstance(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatch_table_.contains(key));
-      CHECK(instance_dispatch_table_.at(key).DestroyInstance != nullptr);
-      return instance_dispatch_table_.at(key).DestroyInstance;
-    }
+    const auto& dispatch_table = GetInstanceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.DestroyInstance != nullptr);
+    return dispatch_table.DestroyInstance;
   }
 
   template <typename DispatchableType>
   PFN_vkEnumerateDeviceExtensionProperties EnumerateDeviceExtensionProperties(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatch_table_.contains(key));
-      CHECK(instance_dispatch_table_.at(key).EnumerateDeviceExtensionProperties != nullptr);
-      return instance_dispatch_table_.at(key).EnumerateDeviceExtensionProperties;
-    }
+    const auto& dispatch_table = GetInstanceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.EnumerateDeviceExtensionProperties != nullptr);
+    return dispatch_table.EnumerateDeviceExtensionProperties;
   }
 
   template <typename DispatchableType>
   PFN_vkGetPhysicalDeviceProperties GetPhysicalDeviceProperties(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatch_table_.contains(key));
-      CHECK(instance_dispatch_table_.at(key).GetPhysicalDeviceProperties != nullptr);
-      return instance_dispatch_table_.at(key).GetPhysicalDeviceProperties;
-    }
+    const auto& dispatch_table = GetInstanceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.GetPhysicalDeviceProperties != nullptr);
+    return dispatch_table.GetPhysicalDeviceProperties;
   }
 
   template <typename DispatchableType>
   PFN_vkGetInstanceProcAddr GetInstanceProcAddr(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatch_table_.contains(key));
-      CHECK(instance_dispatch_table_.at(key).GetInstanceProcAddr != nullptr);
-      return instance_dispatch_table_.at(key).GetInstanceProcAddr;
-    }
+    const auto& dispatch_table = GetInstanceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.GetInstanceProcAddr != nullptr);
+    return dispatch_table.GetInstanceProcAddr;
   }
 
   template <typename DispatchableType>
   PFN_vkGetDeviceProcAddr GetDeviceProcAddr(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).GetDeviceProcAddr != nullptr);
-      return device_dispatch_table_.at(key).GetDeviceProcAddr;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.GetDeviceProcAddr != nullptr);
+    return dispatch_table.GetDeviceProcAddr;
   }
 
   template <typename DispatchableType>
   PFN_vkResetCommandPool ResetCommandPool(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).ResetCommandPool != nullptr);
-      return device_dispatch_table_.at(key).ResetCommandPool;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.ResetCommandPool != nullptr);
+    return dispatch_table.ResetCommandPool;
   }
 
   template <typename DispatchableType>
   PFN_vkAllocateCommandBuffers AllocateCommandBuffers(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).AllocateCommandBuffers != nullptr);
-      return device_dispatch_table_.at(key).AllocateCommandBuffers;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.AllocateCommandBuffers != nullptr);
+    return dispatch_table.AllocateCommandBuffers;
   }
 
   template <typename DispatchableType>
   PFN_vkFreeCommandBuffers FreeCommandBuffers(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).FreeCommandBuffers != nullptr);
-      return device_dispatch_table_.at(key).FreeCommandBuffers;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.FreeCommandBuffers != nullptr);
+    return dispatch_table.FreeCommandBuffers;
   }
 
   template <typename DispatchableType>
   PFN_vkBeginCommandBuffer BeginCommandBuffer(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).BeginCommandBuffer != nullptr);
-      return device_dispatch_table_.at(key).BeginCommandBuffer;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.BeginCommandBuffer != nullptr);
+    return dispatch_table.BeginCommandBuffer;
   }
 
   template <typename DispatchableType>
   PFN_vkEndCommandBuffer EndCommandBuffer(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).EndCommandBuffer != nullptr);
-      return device_dispatch_table_.at(key).EndCommandBuffer;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.EndCommandBuffer != nullptr);
+    return dispatch_table.EndCommandBuffer;
   }
 
   template <typename DispatchableType>
   PFN_vkResetCommandBuffer ResetCommandBuffer(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).ResetCommandBuffer != nullptr);
-      return device_dispatch_table_.at(key).ResetCommandBuffer;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.ResetCommandBuffer != nullptr);
+    return dispatch_table.ResetCommandBuffer;
   }
 
   template <typename DispatchableType>
   PFN_vkGetDeviceQueue GetDeviceQueue(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).GetDeviceQueue != nullptr);
-      return device_dispatch_table_.at(key).GetDeviceQueue;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.GetDeviceQueue != nullptr);
+    return dispatch_table.GetDeviceQueue;
   }
 
   template <typename DispatchableType>
   PFN_vkGetDeviceQueue2 GetDeviceQueue2(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).GetDeviceQueue2 != nullptr);
-      return device_dispatch_table_.at(key).GetDeviceQueue2;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.GetDeviceQueue2 != nullptr);
+    return dispatch_table.GetDeviceQueue2;
   }
 
   template <typename DispatchableType>
   PFN_vkQueueSubmit QueueSubmit(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).QueueSubmit != nullptr);
-      return device_dispatch_table_.at(key).QueueSubmit;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.QueueSubmit != nullptr);
+    return dispatch_table.QueueSubmit;
   }
 
   template <typename DispatchableType>
   PFN_vkQueuePresentKHR QueuePresentKHR(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).QueuePresentKHR != nullptr);
-      return device_dispatch_table_.at(key).QueuePresentKHR;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.QueuePresentKHR != nullptr);
+    return dispatch_table.QueuePresentKHR;
   }
 
   template <typename DispatchableType>
   PFN_vkCreateQueryPool CreateQueryPool(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).CreateQueryPool != nullptr);
-      return device_dispatch_table_.at(key).CreateQueryPool;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.CreateQueryPool != nullptr);
+    return dispatch_table.CreateQueryPool;
   }
 
   template <typename DispatchableType>
   PFN_vkDestroyQueryPool DestroyQueryPool(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).DestroyQueryPool != nullptr);
-      return device_dispatch_table_.at(key).DestroyQueryPool;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.DestroyQueryPool != nullptr);
+    return dispatch_table.DestroyQueryPool;
   }
 
   template <typename DispatchableType>
   PFN_vkResetQueryPoolEXT ResetQueryPoolEXT(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).ResetQueryPoolEXT != nullptr);
-      return device_dispatch_table_.at(key).ResetQueryPoolEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.ResetQueryPoolEXT != nullptr);
+    return dispatch_table.ResetQueryPoolEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkGetQueryPoolResults GetQueryPoolResults(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).GetQueryPoolResults != nullptr);
-      return device_dispatch_table_.at(key).GetQueryPoolResults;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.GetQueryPoolResults != nullptr);
+    return dispatch_table.GetQueryPoolResults;
   }
 
   template <typename DispatchableType>
   PFN_vkCmdWriteTimestamp CmdWriteTimestamp(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).CmdWriteTimestamp != nullptr);
-      return device_dispatch_table_.at(key).CmdWriteTimestamp;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.CmdWriteTimestamp != nullptr);
+    return dispatch_table.CmdWriteTimestamp;
   }
 
   // ----------------------------------------------------------------------------
@@ -281,69 +205,44 @@ class DispatchTable {
   // ----------------------------------------------------------------------------
   template <typename DispatchableType>
   PFN_vkCmdDebugMarkerBeginEXT CmdDebugMarkerBeginEXT(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).CmdDebugMarkerBeginEXT != nullptr);
-      return device_dispatch_table_.at(key).CmdDebugMarkerBeginEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.CmdDebugMarkerBeginEXT != nullptr);
+    return dispatch_table.CmdDebugMarkerBeginEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkCmdDebugMarkerEndEXT CmdDebugMarkerEndEXT(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).CmdDebugMarkerEndEXT != nullptr);
-      return device_dispatch_table_.at(key).CmdDebugMarkerEndEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.CmdDebugMarkerEndEXT != nullptr);
+    return dispatch_table.CmdDebugMarkerEndEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkCmdDebugMarkerInsertEXT CmdDebugMarkerInsertEXT(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).CmdDebugMarkerInsertEXT != nullptr);
-      return device_dispatch_table_.at(key).CmdDebugMarkerInsertEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.CmdDebugMarkerInsertEXT != nullptr);
+    return dispatch_table.CmdDebugMarkerInsertEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkDebugMarkerSetObjectTagEXT DebugMarkerSetObjectTagEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).DebugMarkerSetObjectTagEXT != nullptr);
-      return device_dispatch_table_.at(key).DebugMarkerSetObjectTagEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.DebugMarkerSetObjectTagEXT != nullptr);
+    return dispatch_table.DebugMarkerSetObjectTagEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkDebugMarkerSetObjectNameEXT DebugMarkerSetObjectNameEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).DebugMarkerSetObjectNameEXT != nullptr);
-      return device_dispatch_table_.at(key).DebugMarkerSetObjectNameEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.DebugMarkerSetObjectNameEXT != nullptr);
+    return dispatch_table.DebugMarkerSetObjectNameEXT;
   }
 
   template <typename DispatchableType>
   bool IsDebugMarkerExtensionSupported(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_supports_debug_marker_extension_.contains(key));
-      return device_supports_debug_marker_extension_.at(key);
-    }
+    return GetDeviceEntry(dispatchable_object).supports_debug_marker_extension;
   }
 
   // ----------------------------------------------------------------------------
@@ -352,150 +251,96 @@ class DispatchTable {
   template <typename DispatchableType>
   PFN_vkCmdBeginDebugUtilsLabelEXT CmdBeginDebugUtilsLabelEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).CmdBeginDebugUtilsLabelEXT != nullptr);
-      return device_dispatch_table_.at(key).CmdBeginDebugUtilsLabelEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.CmdBeginDebugUtilsLabelEXT != nullptr);
+    return dispatch_table.CmdBeginDebugUtilsLabelEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkCmdEndDebugUtilsLabelEXT CmdEndDebugUtilsLabelEXT(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).CmdEndDebugUtilsLabelEXT != nullptr);
-      return device_dispatch_table_.at(key).CmdEndDebugUtilsLabelEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.CmdEndDebugUtilsLabelEXT != nullptr);
+    return dispatch_table.CmdEndDebugUtilsLabelEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkCmdInsertDebugUtilsLabelEXT CmdInsertDebugUtilsLabelEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).CmdInsertDebugUtilsLabelEXT != nullptr);
-      return device_dispatch_table_.at(key).CmdInsertDebugUtilsLabelEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.CmdInsertDebugUtilsLabelEXT != nullptr);
+    return dispatch_table.CmdInsertDebugUtilsLabelEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkSetDebugUtilsObjectNameEXT SetDebugUtilsObjectNameEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).SetDebugUtilsObjectNameEXT != nullptr);
-      return device_dispatch_table_.at(key).SetDebugUtilsObjectNameEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.SetDebugUtilsObjectNameEXT != nullptr);
+    return dispatch_table.SetDebugUtilsObjectNameEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkSetDebugUtilsObjectTagEXT SetDebugUtilsObjectTagEXT(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).SetDebugUtilsObjectTagEXT != nullptr);
-      return device_dispatch_table_.at(key).SetDebugUtilsObjectTagEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.SetDebugUtilsObjectTagEXT != nullptr);
+    return dispatch_table.SetDebugUtilsObjectTagEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkQueueBeginDebugUtilsLabelEXT QueueBeginDebugUtilsLabelEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).QueueBeginDebugUtilsLabelEXT != nullptr);
-      return device_dispatch_table_.at(key).QueueBeginDebugUtilsLabelEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.QueueBeginDebugUtilsLabelEXT != nullptr);
+    return dispatch_table.QueueBeginDebugUtilsLabelEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkQueueEndDebugUtilsLabelEXT QueueEndDebugUtilsLabelEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).QueueEndDebugUtilsLabelEXT != nullptr);
-      return device_dispatch_table_.at(key).QueueEndDebugUtilsLabelEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.QueueEndDebugUtilsLabelEXT != nullptr);
+    return dispatch_table.QueueEndDebugUtilsLabelEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkQueueInsertDebugUtilsLabelEXT QueueInsertDebugUtilsLabelEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_dispatch_table_.contains(key));
-      CHECK(device_dispatch_table_.at(key).QueueInsertDebugUtilsLabelEXT != nullptr);
-      return device_dispatch_table_.at(key).QueueInsertDebugUtilsLabelEXT;
-    }
+    const auto& dispatch_table = GetDeviceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.QueueInsertDebugUtilsLabelEXT != nullptr);
+    return dispatch_table.QueueInsertDebugUtilsLabelEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkCreateDebugUtilsMessengerEXT CreateDebugUtilsMessengerEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatch_table_.contains(key));
-      CHECK(instance_dispatch_table_.at(key).CreateDebugUtilsMessengerEXT != nullptr);
-      return instance_dispatch_table_.at(key).CreateDebugUtilsMessengerEXT;
-    }
+    const auto& dispatch_table = GetInstanceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.CreateDebugUtilsMessengerEXT != nullptr);
+    return dispatch_table.CreateDebugUtilsMessengerEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkDestroyDebugUtilsMessengerEXT DestroyDebugUtilsMessengerEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatch_table_.contains(key));
-      CHECK(instance_dispatch_table_.at(key).DestroyDebugUtilsMessengerEXT != nullptr);
-      return instance_dispatch_table_.at(key).DestroyDebugUtilsMessengerEXT;
-    }
+    const auto& dispatch_table = GetInstanceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.DestroyDebugUtilsMessengerEXT != nullptr);
+    return dispatch_table.DestroyDebugUtilsMessengerEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkSubmitDebugUtilsMessageEXT SubmitDebugUtilsMessageEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatch_table_.contains(key));
-      CHECK(instance_dispatch_table_.at(key).SubmitDebugUtilsMessageEXT != nullptr);
-      return instance_dispatch_table_.at(key).SubmitDebugUtilsMessageEXT;
-    }
+    const auto& dispatch_table = GetInstanceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.SubmitDebugUtilsMessageEXT != nullptr);
+    return dispatch_table.SubmitDebugUtilsMessageEXT;
   }
 
   template <typename DispatchableType>
   bool IsDebugUtilsExtensionSupported(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(device_supports_debug_utils_extension_.contains(key));
-      return device_supports_debug_utils_extension_.at(key);
-    }
+    return GetDeviceEntry(dispatchable_object).supports_debug_utils_extension;
   }
 
   bool IsDebugUtilsExtensionSupported(VkInstance instance) {
-    void* key = GetDispatchTableKey(instance);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_supports_debug_utils_extension_.contains(key));
-      return instance_supports_debug_utils_extension_.at(key);
-    }
+    return GetInstanceEntry(instance).supports_debug_utils_extension;
   }
 
   // ----------------------------------------------------------------------------
@@ -504,55 +349,33 @@ class DispatchTable {
   template <typename DispatchableType>
   PFN_vkCreateDebugReportCallbackEXT CreateDebugReportCallbackEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatch_table_.contains(key));
-      CHECK(instance_dispatch_table_.at(key).CreateDebugReportCallbackEXT != nullptr);
-      return instance_dispatch_table_.at(key).CreateDebugReportCallbackEXT;
-    }
+    const auto& dispatch_table = GetInstanceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.CreateDebugReportCallbackEXT != nullptr);
+    return dispatch_table.CreateDebugReportCallbackEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkDestroyDebugReportCallbackEXT DestroyDebugReportCallbackEXT(
       DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatch_table_.contains(key));
-      CHECK(instance_dispatch_table_.at(key).DestroyDebugReportCallbackEXT != nullptr);
-      return instance_dispatch_table_.at(key).DestroyDebugReportCallbackEXT;
-    }
+    const auto& dispatch_table = GetInstanceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.DestroyDebugReportCallbackEXT != nullptr);
+    return dispatch_table.DestroyDebugReportCallbackEXT;
   }
 
   template <typename DispatchableType>
   PFN_vkDebugReportMessageEXT DebugReportMessageEXT(DispatchableType dispatchable_object) {
-    void* key = GetDispatchTableKey(dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatch_table_.contains(key));
-      CHECK(instance_dispatch_table_.at(key).DebugReportMessageEXT != nullptr);
-      return instance_dispatch_table_.at(key).DebugReportMessageEXT;
-    }
+    const auto& dispatch_table = GetInstanceDispatchTable(dispatchable_object);
+    CHECK(dispatch_table.DebugReportMessageEXT != nullptr);
+    return dispatch_table.DebugReportMessageEXT;
   }
 
   bool IsDebugReportExtensionSupported(VkInstance instance) {
-    void* key = GetDispatchTableKey(instance);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_supports_debug_report_extension_.contains(key));
-      return instance_supports_debug_report_extension_.at(key);
-    }
+    return GetInstanceEntry(instance).supports_debug_report_extension;
   }
 
   template <typename DispatchableType>
   VkInstance GetInstance(DispatchableType instance_dispatchable_object) {
-    void* key = GetDispatchTableKey(instance_dispatchable_object);
-    {
-      absl::ReaderMutexLock lock(&mutex_);
-      CHECK(instance_dispatchable_object_to_instance_.contains(key));
-      return instance_dispatchable_object_to_instance_.at(key);
-    }
+    return GetInstanceEntry(instance_dispatchable_object).instance;
   }
 
  private:
@@ -570,22 +393,79 @@ class DispatchTable {
     return dispatch;
   }
 
+  struct InstanceEntry {
+    VkLayerInstanceDispatchTable dispatch_table;
+    bool supports_debug_utils_extension;
+    bool supports_debug_report_extension;
+    VkInstance instance;
+  };
+
+  struct DeviceEntry {
+    VkLayerDispatchTable dispatch_table;
+    bool supports_debug_marker_extension;
+    bool supports_debug_utils_extension;
+  };
+
   // Dispatch tables required for routing instance and device calls onto the next
-  // layer in the dispatch chain among our handling of functions we intercept.
-  absl::flat_hash_map<void*, VkLayerInstanceDispatchTable> instance_dispatch_table_;
-  absl::flat_hash_map<void*, VkLayerDispatchTable> device_dispatch_table_;
+  // layer in the dispatch chain among our handling of functions we intercept. The entries are owned
+  // by instance_entries_ and device_entries_.
+  struct Snapshot {
+    absl::flat_hash_map<void*, const InstanceEntry*> instances;
+    absl::flat_hash_map<void*, const DeviceEntry*> devices;
+  };
+
+  template <typename DispatchableType>
+  const InstanceEntry& GetInstanceEntry(DispatchableType dispatchable_object) {
+    const size_t reader_shard_index = snapshot_readers_.BeginRead();
+    const Snapshot* snapshot = current_snapshot_.load();
+    auto it = snapshot->instances.find(GetDispatchTableKey(dispatchable_object));
+    CHECK(it != snapshot->instances.end());
+    const InstanceEntry* entry = it->second;
+    snapshot_readers_.EndRead(reader_shard_index);
+    return *entry;
+  }
+
+  template <typename DispatchableType>
+  const VkLayerInstanceDispatchTable& GetInstanceDispatchTable(
+      DispatchableType dispatchable_object) {
+    return GetInstanceEntry(dispatchable_object).dispatch_table;
+  }
+
+  template <typename DispatchableType>
+  const DeviceEntry& GetDeviceEntry(DispatchableType dispatchable_object) {
+    const size_t reader_shard_index = snapshot_readers_.BeginRead();
+    const Snapshot* snapshot = current_snapshot_.load();
+    auto it = snapshot->devices.find(GetDispatchTableKey(dispatchable_object));
+    CHECK(it != snapshot->devices.end());
+    const DeviceEntry* entry = it->second;
+    snapshot_readers_.EndRead(reader_shard_index);
+    return *entry;
+  }
 
-  absl::flat_hash_map<void*, bool> device_supports_debug_marker_extension_;
-  absl::flat_hash_map<void*, bool> device_supports_debug_utils_extension_;
-  absl::flat_hash_map<void*, bool> instance_supports_debug_utils_extension_;
-  absl::flat_hash_map<void*, bool> instance_supports_debug_report_extension_;
+  template <typename DispatchableType>
+  const VkLayerDispatchTable& GetDeviceDispatchTable(DispatchableType dispatchable_object) {
+    return GetDeviceEntry(dispatchable_object).dispatch_table;
+  }
 
-  absl::flat_hash_map<void*, VkInstance> instance_dispatchable_object_to_instance_;
+  // Publishes a modified copy of the current snapshot. `modify` is called with the copy. Returns
+  // once no thread can be reading the previous snapshot anymore, which is then freed.
+  void UpdateSnapshot(const std::function<void(Snapshot*)>& modify)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
-  // Must protect access to dispatch tables above by mutex since the Vulkan
-  // application may be calling these functions from different threads.
-  // However, they are usually filled once (per device/instance) at the beginning
-  // and afterwards we only read that data. So we use read/write locks.
+  // The Vulkan application may call the accessors from different threads, but the tables are
+  // usually only modified once per device/instance at the beginning. So the accessors read an
+  // immutable snapshot without taking any lock, and modifications publish a new snapshot. The
+  // previous snapshot is freed once snapshot_readers_ tells that nobody reads it anymore.
+  std::atomic<const Snapshot*> current_snapshot_;
+  SnapshotReaders snapshot_readers_;
+  std::unique_ptr<const Snapshot> snapshot_ ABSL_GUARDED_BY(mutex_);
+  // An entry is only freed after it was removed from the current snapshot. By the rules of Vulkan,
+  // the instance or device, and the objects created from it, can't be in use by then.
+  absl::flat_hash_map<void*, std::unique_ptr<const InstanceEntry>> instance_entries_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<void*, std::unique_ptr<const DeviceEntry>> device_entries_
+      ABSL_GUARDED_BY(mutex_);
+  // Serializes modifications.
   absl::Mutex mutex_;
 };
 
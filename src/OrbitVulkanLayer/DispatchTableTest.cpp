@@ -4,6 +4,10 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "DispatchTable.h"
 
 namespace orbit_vulkan_layer {
@@ -1219,4 +1223,46 @@ TEST(DispatchTable, CanCallDebugMarkerSetObjectNameEXT) {
   EXPECT_EQ(result, VK_SUCCESS);
 }
 
+// Looks up functions from several threads while the main thread keeps creating and removing a
+// second device, which replaces and frees the snapshot the other threads are reading.
+TEST(DispatchTable, ConcurrentLookupsWhileDevicesAreCreatedAndRemoved) {
+  // The two devices need to start with different pointers to be told apart.
+  void* some_dispatch_table_pointer = &some_dispatch_table_pointer;
+  auto device = absl::bit_cast<VkDevice>(&some_dispatch_table_pointer);
+  void* other_dispatch_table_pointer = &other_dispatch_table_pointer;
+  auto other_device = absl::bit_cast<VkDevice>(&other_dispatch_table_pointer);
+  static constexpr PFN_vkVoidFunction kFunction = +[]() {};
+  PFN_vkGetDeviceProcAddr next_get_device_proc_addr_function =
+      +[](VkDevice /*device*/, const char * /*name*/) -> PFN_vkVoidFunction { return kFunction; };
+
+  DispatchTable dispatch_table = {};
+  dispatch_table.CreateDeviceDispatchTable(device, next_get_device_proc_addr_function);
+
+  constexpr int kNumThreads = 4;
+  std::atomic<bool> devices_done{false};
+  std::atomic<uint64_t> num_failed_lookups{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&] {
+      while (!devices_done) {
+        if (absl::bit_cast<PFN_vkVoidFunction>(dispatch_table.QueueSubmit(device)) != kFunction ||
+            !dispatch_table.IsDebugUtilsExtensionSupported(device)) {
+          ++num_failed_lookups;
+        }
+      }
+    });
+  }
+  constexpr int kNumDeviceCreations = 100;
+  for (int i = 0; i < kNumDeviceCreations; ++i) {
+    dispatch_table.CreateDeviceDispatchTable(other_device, next_get_device_proc_addr_function);
+    EXPECT_EQ(absl::bit_cast<PFN_vkVoidFunction>(dispatch_table.QueueSubmit(other_device)),
+              kFunction);
+    dispatch_table.RemoveDeviceDispatchTable(other_device);
+  }
+  devices_done = true;
+  for (std::thread& thread : threads) thread.join();
+
+  EXPECT_EQ(num_failed_lookups, 0);
+}
+
 }  // namespace orbit_vulkan_layer
\ No newline at end of file
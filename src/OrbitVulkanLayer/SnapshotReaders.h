@@ -0,0 +1,70 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_VULKAN_LAYER_SNAPSHOT_READERS_H_
+#define ORBIT_VULKAN_LAYER_SNAPSHOT_READERS_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace orbit_vulkan_layer {
+
+// Tracks the threads reading an immutable snapshot that is published through an atomic pointer, so
+// that the writer can free a snapshot it replaced once nobody reads it anymore.
+//
+// A reader calls `BeginRead` before loading the pointer to the snapshot and `EndRead` once it is
+// done with the snapshot. The writer stores the pointer to the new snapshot and then calls
+// `WaitForReadersOfReplacedSnapshot`. Both the load and the store must be sequentially consistent.
+//
+// The readers are counted in a few shards on separate cache lines, so that threads reading at the
+// same time don't contend on one. A reader that loaded the replaced snapshot counted itself in its
+// shard before, so once every shard has been seen at zero after the store, that reader is done.
+class SnapshotReaders {
+ public:
+  // Returns the shard to pass to `EndRead`.
+  [[nodiscard]] size_t BeginRead() {
+    const size_t shard_index = GetShardIndex();
+    shards_[shard_index].num_readers.fetch_add(1);
+    return shard_index;
+  }
+
+  void EndRead(size_t shard_index) {
+    shards_[shard_index].num_readers.fetch_sub(1, std::memory_order_release);
+  }
+
+  // Reads are expected to be short, so each shard is soon seen at zero. With more than
+  // `kNumShards` reading threads, several of them share a shard, and as long as their reads keep
+  // overlapping the shard never drops to zero. The writer then spins, yielding, until they pause.
+  // Readers never take the writer's lock, so this can only delay the rare writes, not deadlock.
+  void WaitForReadersOfReplacedSnapshot() const {
+    for (const Shard& shard : shards_) {
+      while (shard.num_readers.load() != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> num_readers{0};
+  };
+  static constexpr size_t kNumShards = 16;
+
+  // Threads are assigned shards round-robin.
+  [[nodiscard]] static size_t GetShardIndex() {
+    static std::atomic<size_t> next_shard_index{0};
+    thread_local const size_t shard_index =
+        next_shard_index.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+    return shard_index;
+  }
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+}  // namespace orbit_vulkan_layer
+
+#endif  // ORBIT_VULKAN_LAYER_SNAPSHOT_READERS_H_
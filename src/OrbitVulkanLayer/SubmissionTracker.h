@@ -7,13 +7,21 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/hash/hash.h>
 #include <absl/synchronization/mutex.h>
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <functional>
+#include <optional>
 #include <queue>
 #include <stack>
+#include <thread>
+#include <utility>
 
+#include "Api/EncodedEvent.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Profiling.h"
 #include "OrbitBase/ThreadUtils.h"
@@ -29,16 +37,20 @@ namespace orbit_vulkan_layer {
  * timestamp commands (`VkCmdWriteTimestamp`). The same is done for debug marker begins and ends.
  * All that data will be gathered together at a queue submission (`VkQueueSubmit`).
  *
- * Upon every `VkQueuePresentKHR` it will check if the last timestamp of a certain submission is
- * already available, and if so, it will assume that all timestamps are available and it will send
- * the results over to the `VulkanLayerProducer`.
+ * Upon every `VkQueuePresentKHR` it will request a layer-owned thread to check which submissions
+ * have all their timestamps available, and to send the results over to the `VulkanLayerProducer`.
+ * This keeps reading back the timestamps off the present call.
  *
  * See also `DispatchTable` (for vulkan dispatch), `TimerQueryPool` (to manage the timestamp slots),
  * and `DeviceManager` (to retrieve device properties).
  *
- * Thread-Safety: This class is internally synchronized (using read/write locks), and can be
- * safely accessed from different threads. This is needed, as in Vulkan submits and command buffer
- * modifications can happen from multiple threads.
+ * Thread-Safety: This class is internally synchronized, and can be safely accessed from different
+ * threads. This is needed, as in Vulkan submits and command buffer modifications can happen from
+ * multiple threads. The state of command buffers and command pools is partitioned into shards by
+ * their handles, each with its own lock. As Vulkan requires recording into a command buffer to be
+ * externally synchronized, threads recording different command buffers only meet on the lock of a
+ * shard by chance. Only the submit and present path (and capture start and finish) coordinate
+ * across threads, using `mutex_`.
  */
 template <class DispatchTable, class DeviceManager, class TimerQueryPool>
 class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
@@ -143,10 +155,27 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     CHECK(device_manager_ != nullptr);
   }
 
+  ~SubmissionTracker() override {
+    std::thread readback_thread;
+    {
+      absl::MutexLock lock(&readback_mutex_);
+      readback_thread_shutdown_requested_ = true;
+      readback_thread = std::move(readback_thread_);
+    }
+    if (readback_thread.joinable()) {
+      readback_thread.join();
+    }
+  }
+
   // Sets a producer to be used to enqueue capture events and asks if we are capturing.
   // We will also register ourselves as CaptureStatusListener, in order to get notified on
   // capture finish (OnCaptureFinished). That's when we will reset the open query slots.
   void SetVulkanLayerProducer(VulkanLayerProducer* vulkan_layer_producer) {
+    // The readback thread uses the producer while it completes submits.
+    absl::MutexLock lock(&readback_mutex_);
+    while (device_in_readback_.has_value()) {
+      readback_done_.Wait(&readback_mutex_);
+    }
     // De-register from the previous VulkanLayerProducer.
     if (vulkan_layer_producer_ != nullptr) {
       vulkan_layer_producer_->SetCaptureStatusListener(nullptr);
@@ -162,58 +191,70 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   // markers will be discarded. If set to to std::numeric_limits<uint32_t>::max(), no debug marker
   // will be discarded.
   void SetMaxLocalMarkerDepthPerCommandBuffer(uint32_t max_local_marker_depth_per_command_buffer) {
-    max_local_marker_depth_per_command_buffer_ = max_local_marker_depth_per_command_buffer;
+    max_local_marker_depth_per_command_buffer_.store(max_local_marker_depth_per_command_buffer,
+                                                     std::memory_order_relaxed);
   }
 
   void TrackCommandBuffers(VkDevice device, VkCommandPool pool,
                            const VkCommandBuffer* command_buffers, uint32_t count) {
-    absl::WriterMutexLock lock(&mutex_);
-    auto associated_cbs_it = pool_to_command_buffers_.find(pool);
-    if (associated_cbs_it == pool_to_command_buffers_.end()) {
-      associated_cbs_it = pool_to_command_buffers_.try_emplace(pool).first;
+    {
+      Shard& pool_shard = GetShard(pool);
+      absl::MutexLock lock(&pool_shard.mutex);
+      absl::flat_hash_set<VkCommandBuffer>& associated_command_buffers =
+          pool_shard.pool_to_command_buffers[pool];
+      associated_command_buffers.insert(command_buffers, command_buffers + count);
     }
     for (uint32_t i = 0; i < count; ++i) {
       VkCommandBuffer cb = command_buffers[i];
-      associated_cbs_it->second.insert(cb);
-      command_buffer_to_device_[cb] = device;
+      Shard& shard = GetShard(cb);
+      absl::MutexLock lock(&shard.mutex);
+      shard.command_buffer_to_device[cb] = device;
     }
   }
 
   void UntrackCommandBuffers(VkDevice device, VkCommandPool pool,
                              const VkCommandBuffer* command_buffers, uint32_t count) {
-    absl::WriterMutexLock lock(&mutex_);
-    CHECK(pool_to_command_buffers_.contains(pool));
-    absl::flat_hash_set<VkCommandBuffer>& associated_command_buffers =
-        pool_to_command_buffers_.at(pool);
+    {
+      Shard& pool_shard = GetShard(pool);
+      absl::MutexLock lock(&pool_shard.mutex);
+      CHECK(pool_shard.pool_to_command_buffers.contains(pool));
+      absl::flat_hash_set<VkCommandBuffer>& associated_command_buffers =
+          pool_shard.pool_to_command_buffers.at(pool);
+      for (uint32_t i = 0; i < count; ++i) {
+        associated_command_buffers.erase(command_buffers[i]);
+      }
+      if (associated_command_buffers.empty()) {
+        pool_shard.pool_to_command_buffers.erase(pool);
+      }
+    }
     for (uint32_t i = 0; i < count; ++i) {
       VkCommandBuffer command_buffer = command_buffers[i];
-      associated_command_buffers.erase(command_buffer);
+      Shard& shard = GetShard(command_buffer);
+      absl::MutexLock lock(&shard.mutex);
 
       // vkFreeCommandBuffers (and thus this method) can be also called on command bufers in
       // "recording" or executable state and has similar effect as vkResetCommandBuffer has.
-      // In `OnCaptureFinished`, we reset all the timer slots left in `command_buffer_to_state_`.
+      // In `OnCaptureFinished`, we reset all the timer slots left in `command_buffer_to_state`.
       // If we would not reset them here and clear the state, we would try to reset those command
       // buffers there. However, the mapping to the device (which is needed) would be missing.
-      if (command_buffer_to_state_.contains(command_buffer)) {
+      if (shard.command_buffer_to_state.contains(command_buffer)) {
         // Note: This will "rollback" the slot indices (rather then actually resetting them on the
         // Gpu). This is fine, as we remove the command buffer state right after submission. Thus,
         // There can not be a value in the respective slot.
-        ResetCommandBufferUnsafe(command_buffer);
+        ResetCommandBufferUnsafe(&shard, command_buffer);
 
-        command_buffer_to_state_.erase(command_buffer);
+        shard.command_buffer_to_state.erase(command_buffer);
       }
 
-      CHECK(command_buffer_to_device_.contains(command_buffer));
-      CHECK(command_buffer_to_device_.at(command_buffer) == device);
-      command_buffer_to_device_.erase(command_buffer);
-    }
-    if (associated_command_buffers.empty()) {
-      pool_to_command_buffers_.erase(pool);
+      CHECK(shard.command_buffer_to_device.contains(command_buffer));
+      CHECK(shard.command_buffer_to_device.at(command_buffer) == device);
+      shard.command_buffer_to_device.erase(command_buffer);
     }
   }
 
   void MarkCommandBufferBegin(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
+    Shard& shard = GetShard(command_buffer);
+    absl::MutexLock lock(&shard.mutex);
     // Even when we are not capturing we create state for this command buffer to allow the
     // debug marker tracking. In order to compute the correct depth of a debug marker and being able
     // to match an "end" marker with the corresponding "begin" marker, we maintain a stack of all
@@ -223,33 +264,34 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     // submission. We will not write timestamps in this case and thus don't store any information
     // other than the debug markers then.
     {
-      if (command_buffer_to_state_.contains(command_buffer)) {
+      if (shard.command_buffer_to_state.contains(command_buffer)) {
         // We end up in this case, if we have used the command buffer before and want to write new
         // commands to it without resetting the command buffer. Per specification,
         // "vkBeginCommandBuffer" does also reset the command buffer, in addition to putting it
         // into the executable state.
-        ResetCommandBufferUnsafe(command_buffer);
+        ResetCommandBufferUnsafe(&shard, command_buffer);
       }
-      command_buffer_to_state_[command_buffer] = {};
+      shard.command_buffer_to_state[command_buffer] = {};
     }
     if (!is_capturing_) {
       return;
     }
 
     uint32_t slot_index;
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
-      CHECK(command_buffer_to_state_.contains(command_buffer));
-      command_buffer_to_state_.at(command_buffer).command_buffer_begin_slot_index =
+    if (RecordTimestamp(shard, command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
+      CHECK(shard.command_buffer_to_state.contains(command_buffer));
+      shard.command_buffer_to_state.at(command_buffer).command_buffer_begin_slot_index =
           std::make_optional(slot_index);
     }
   }
 
   void MarkCommandBufferEnd(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
+    Shard& shard = GetShard(command_buffer);
+    absl::MutexLock lock(&shard.mutex);
     if (!is_capturing_) {
       return;
     }
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    if (!shard.command_buffer_to_state.contains(command_buffer)) {
       ERROR_ONCE(
           "Calling vkEndCommandBuffer on a command buffer that is in the initial state "
           "(i.e. either freshly allocated or reset with vkResetCommandBuffer).");
@@ -257,33 +299,35 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     uint32_t slot_index;
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &slot_index)) {
+    if (RecordTimestamp(shard, command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &slot_index)) {
       // MarkCommandBufferBegin/End are called from within the same submit, and as the
       // `MarkCommandBufferBegin` will always insert the state, we can assume that it is there.
-      CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& command_buffer_state = command_buffer_to_state_.at(command_buffer);
+      CHECK(shard.command_buffer_to_state.contains(command_buffer));
+      CommandBufferState& command_buffer_state = shard.command_buffer_to_state.at(command_buffer);
       command_buffer_state.command_buffer_end_slot_index = std::make_optional(slot_index);
     }
   }
 
   void MarkDebugMarkerBegin(VkCommandBuffer command_buffer, const char* text, Color color) {
-    absl::WriterMutexLock lock(&mutex_);
+    Shard& shard = GetShard(command_buffer);
+    absl::MutexLock lock(&shard.mutex);
     // It is ensured by the Vulkan spec. that `text` must not be nullptr.
     CHECK(text != nullptr);
     bool marker_depth_exceeds_maximum;
     {
-      if (!command_buffer_to_state_.contains(command_buffer)) {
+      if (!shard.command_buffer_to_state.contains(command_buffer)) {
         ERROR_ONCE(
             "Calling vkCmdDebugMarkerBeginEXT/vkCmdBeginDebugUtilsLabelEXT on a command buffer "
             "that is in the initial state (i.e. either freshly allocated or reset with "
             "vkResetCommandBuffer).");
         return;
       }
-      CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+      CHECK(shard.command_buffer_to_state.contains(command_buffer));
+      CommandBufferState& state = shard.command_buffer_to_state.at(command_buffer);
       ++state.local_marker_stack_size;
       marker_depth_exceeds_maximum =
-          state.local_marker_stack_size > max_local_marker_depth_per_command_buffer_;
+          state.local_marker_stack_size >
+          max_local_marker_depth_per_command_buffer_.load(std::memory_order_relaxed);
       Marker marker{.type = MarkerType::kDebugMarkerBegin,
                     .label_name = std::string(text),
                     .color = color,
@@ -296,28 +340,30 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     uint32_t slot_index;
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
-      CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    if (RecordTimestamp(shard, command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &slot_index)) {
+      CHECK(shard.command_buffer_to_state.contains(command_buffer));
+      CommandBufferState& state = shard.command_buffer_to_state.at(command_buffer);
       state.markers.back().slot_index = std::make_optional(slot_index);
     }
   }
 
   void MarkDebugMarkerEnd(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
+    Shard& shard = GetShard(command_buffer);
+    absl::MutexLock lock(&shard.mutex);
     bool marker_depth_exceeds_maximum;
 
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    if (!shard.command_buffer_to_state.contains(command_buffer)) {
       ERROR_ONCE(
           "Calling vkCmdDebugMarkerEndEXT/vkCmdEndDebugUtilsLabelEXT on a command buffer "
           "that is in the initial state (i.e. either freshly allocated or reset with "
           "vkResetCommandBuffer).");
       return;
     }
-    CHECK(command_buffer_to_state_.contains(command_buffer));
-    CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    CHECK(shard.command_buffer_to_state.contains(command_buffer));
+    CommandBufferState& state = shard.command_buffer_to_state.at(command_buffer);
     marker_depth_exceeds_maximum =
-        state.local_marker_stack_size > max_local_marker_depth_per_command_buffer_;
+        state.local_marker_stack_size >
+        max_local_marker_depth_per_command_buffer_.load(std::memory_order_relaxed);
     Marker marker{.type = MarkerType::kDebugMarkerEnd, .cut_off = marker_depth_exceeds_maximum};
     state.markers.emplace_back(std::move(marker));
     // We might see more "ends" than "begins", as the "begins" can be on a different command
@@ -331,9 +377,9 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     uint32_t slot_index;
-    if (RecordTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &slot_index)) {
-      CHECK(command_buffer_to_state_.contains(command_buffer));
-      CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    if (RecordTimestamp(shard, command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &slot_index)) {
+      CHECK(shard.command_buffer_to_state.contains(command_buffer));
+      CommandBufferState& state = shard.command_buffer_to_state.at(command_buffer);
       state.markers.back().slot_index = std::make_optional(slot_index);
     }
   }
@@ -375,7 +421,7 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       for (uint32_t command_buffer_index = 0; command_buffer_index < submit_info.commandBufferCount;
            ++command_buffer_index) {
         VkCommandBuffer command_buffer = submit_info.pCommandBuffers[command_buffer_index];
-        PersistSingleCommandBufferOnSubmit(device, command_buffer, &queue_submission,
+        PersistSingleCommandBufferOnSubmit(&device, command_buffer, &queue_submission,
                                            &submitted_submit_info, &query_slots_not_needed_to_read);
       }
     }
@@ -428,12 +474,15 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       for (uint32_t command_buffer_index = 0; command_buffer_index < submit_info.commandBufferCount;
            ++command_buffer_index) {
         VkCommandBuffer command_buffer = submit_info.pCommandBuffers[command_buffer_index];
+        Shard& shard = GetShard(command_buffer);
+        absl::MutexLock shard_lock(&shard.mutex);
         if (device == VK_NULL_HANDLE) {
-          CHECK(command_buffer_to_device_.contains(command_buffer));
-          device = command_buffer_to_device_.at(command_buffer);
+          CHECK(shard.command_buffer_to_device.contains(command_buffer));
+          device = shard.command_buffer_to_device.at(command_buffer);
         }
-        PersistDebugMarkersOfASingleCommandBufferOnSubmit(
-            command_buffer, &queue_submission_optional, &markers, &marker_slots_not_needed_to_read);
+        PersistDebugMarkersOfASingleCommandBufferOnSubmit(shard, command_buffer,
+                                                          &queue_submission_optional, &markers,
+                                                          &marker_slots_not_needed_to_read);
       }
     }
 
@@ -453,6 +502,30 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
         std::move(queue_submission_optional.value()));
   }
 
+  // Asks the readback thread to call `CompleteSubmits` for `device`, and returns right away. The
+  // thread is started on the first request. Requests for a device that has not been processed yet
+  // are merged. When capturing, the time from the earliest of the merged requests until
+  // `CompleteSubmits` returned is sent to the `VulkanLayerProducer` as a value of the
+  // "Vulkan readback latency (ns)" track.
+  void RequestCompleteSubmits(VkDevice device) {
+    const uint64_t request_timestamp_ns = orbit_base::CaptureTimestampNs();
+    absl::MutexLock lock(&readback_mutex_);
+    readback_requests_.try_emplace(device, request_timestamp_ns);
+    if (!readback_thread_.joinable()) {
+      readback_thread_ = std::thread{&SubmissionTracker::ReadbackThreadMain, this};
+    }
+  }
+
+  // Drops a pending request for `device` and waits until the readback thread is done with it.
+  // Must be called before the device is destroyed.
+  void CancelCompleteSubmits(VkDevice device) {
+    absl::MutexLock lock(&readback_mutex_);
+    readback_requests_.erase(device);
+    while (device_in_readback_ == device) {
+      readback_done_.Wait(&readback_mutex_);
+    }
+  }
+
   // This method is responsible for retrieving all the timestamps for the "completed" submissions,
   // for transforming the information of those submissions (in particular about the command buffers
   // and debug markers) into the `GpuQueueSubmission` proto, and for sending it to the
@@ -462,12 +535,14 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   // with the oldest CPU timestamp, until we encounter the first "incomplete" submission.
   // This way, we ensure that we will send the submission information per queue ordered by the
   // CPU timestamp.
+  // The timestamps of all pending submissions are read upfront, with one `vkGetQueryPoolResults`
+  // call per range of consecutive slots (see `QueryAvailableGpuTimestampsNs`).
   // Beside the timestamps of command buffers and the meta information of the submission, the proto
   // also contains the debug markers, "begin" (even if submitted in a different submission) and
   // "end", that got completed in this submission.
   // See also `WriteMetaInfo`, `WriteCommandBufferTimings` and `WriteDebugMarkers`.
   // This method also resets all the timer slots that have been read.
-  // It is assumed to be called periodically, e.g. on `vkQueuePresentKHR`.
+  // It is called periodically by the readback thread, see `RequestCompleteSubmits`.
   void CompleteSubmits(VkDevice device) {
     absl::WriterMutexLock lock(&mutex_);
     VkQueryPool query_pool = timer_query_pool_->GetQueryPool(device);
@@ -480,34 +555,51 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     const float timestamp_period =
         device_manager_->GetPhysicalDeviceProperties(physical_device).limits.timestampPeriod;
 
-    std::vector<uint32_t> query_slots_done_reading = {};
-    std::vector<QueueSubmission> submissions_to_send = {};
-
-    // The submits of a specific queue in `submissions_queue_` are sorted by "pre submission CPU"
-    // timestamp and we want to make sure we send events to the client in that order. Therefore, we
-    // stop as soon as a query failed.
+    // Take all pending submissions out of the priority queues, ordered by "pre submission CPU"
+    // timestamp, to collect the slots of all of them before reading any timestamp.
+    std::vector<std::pair<SubmissionPriorityQueue*, std::vector<QueueSubmission>>>
+        ordered_submissions_per_queue;
+    std::vector<uint32_t> slots_to_query;
     for (auto& [unused_queue, submissions] : queue_to_submission_priority_queue_) {
+      std::vector<QueueSubmission>& ordered_submissions =
+          ordered_submissions_per_queue.emplace_back(&submissions, std::vector<QueueSubmission>{})
+              .second;
       while (!submissions.empty()) {
-        QueueSubmission completed_submission = submissions.top();
+        ordered_submissions.push_back(submissions.top());
         submissions.pop();
+        CollectSlotsToQuery(ordered_submissions.back(), &slots_to_query);
+      }
+    }
+    const absl::flat_hash_map<uint32_t, uint64_t> available_timestamps =
+        QueryAvailableGpuTimestampsNs(device, query_pool, std::move(slots_to_query),
+                                      timestamp_period);
+
+    std::vector<uint32_t> query_slots_done_reading = {};
+    std::vector<QueueSubmission> submissions_to_send = {};
+
+    // We want to make sure we send events to the client in the order of the "pre submission CPU"
+    // timestamp. Therefore, we stop as soon as a query failed, and put that submission and all
+    // later ones back.
+    for (auto& [submissions, ordered_submissions] : ordered_submissions_per_queue) {
+      auto submission_it = ordered_submissions.begin();
+      for (; submission_it != ordered_submissions.end(); ++submission_it) {
+        QueueSubmission& completed_submission = *submission_it;
         bool command_buffer_queries_succeeded = QueryCommandBufferTimestamps(
-            &completed_submission, &query_slots_done_reading, device, query_pool, timestamp_period);
+            &completed_submission, &query_slots_done_reading, available_timestamps);
 
         // We only need to read the debug marker timestamps, if querying the command buffers
         // succeeded.
         bool marker_queries_succeeded = false;
         if (command_buffer_queries_succeeded) {
-          marker_queries_succeeded =
-              QueryDebugMarkerTimestamps(&completed_submission, &query_slots_done_reading, device,
-                                         query_pool, timestamp_period);
+          marker_queries_succeeded = QueryDebugMarkerTimestamps(
+              &completed_submission, &query_slots_done_reading, available_timestamps);
         }
 
-        if (command_buffer_queries_succeeded && marker_queries_succeeded) {
-          submissions_to_send.emplace_back(std::move(completed_submission));
-        } else {
-          submissions.emplace(std::move(completed_submission));
-          break;
-        }
+        if (!command_buffer_queries_succeeded || !marker_queries_succeeded) break;
+        submissions_to_send.emplace_back(std::move(completed_submission));
+      }
+      for (; submission_it != ordered_submissions.end(); ++submission_it) {
+        submissions->emplace(std::move(*submission_it));
       }
     }
 
@@ -533,19 +625,21 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   }
 
   void ResetCommandBuffer(VkCommandBuffer command_buffer) {
-    absl::WriterMutexLock lock(&mutex_);
-    ResetCommandBufferUnsafe(command_buffer);
+    Shard& shard = GetShard(command_buffer);
+    absl::MutexLock lock(&shard.mutex);
+    ResetCommandBufferUnsafe(&shard, command_buffer);
   }
 
   void ResetCommandPool(VkCommandPool command_pool) {
     absl::flat_hash_set<VkCommandBuffer> command_buffers;
     {
-      absl::ReaderMutexLock lock(&mutex_);
-      if (!pool_to_command_buffers_.contains(command_pool)) {
+      Shard& pool_shard = GetShard(command_pool);
+      absl::MutexLock lock(&pool_shard.mutex);
+      if (!pool_shard.pool_to_command_buffers.contains(command_pool)) {
         return;
       }
-      CHECK(pool_to_command_buffers_.contains(command_pool));
-      command_buffers = pool_to_command_buffers_.at(command_pool);
+      CHECK(pool_shard.pool_to_command_buffers.contains(command_pool));
+      command_buffers = pool_shard.pool_to_command_buffers.at(command_pool);
     }
     for (const auto& command_buffer : command_buffers) {
       ResetCommandBuffer(command_buffer);
@@ -554,41 +648,46 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
   void OnCaptureStart(orbit_grpc_protos::CaptureOptions capture_options) override {
     absl::WriterMutexLock lock(&mutex_);
+    LockAllShards();
     SetMaxLocalMarkerDepthPerCommandBuffer(
         capture_options.max_local_marker_depth_per_command_buffer());
     is_capturing_ = true;
+    UnlockAllShards();
   }
 
   void OnCaptureStop() override {}
 
   void OnCaptureFinished() override {
     absl::WriterMutexLock lock(&mutex_);
+    LockAllShards();
     std::vector<uint32_t> slots_not_needed_to_read_anymore;
 
     VkDevice device = VK_NULL_HANDLE;
 
-    for (auto& [command_buffer, command_buffer_state] : command_buffer_to_state_) {
-      if (command_buffer_state.pre_submission_cpu_timestamp.has_value()) continue;
-      if (device == VK_NULL_HANDLE) {
-        CHECK(command_buffer_to_device_.contains(command_buffer));
-        device = command_buffer_to_device_.at(command_buffer);
-      }
-      if (command_buffer_state.command_buffer_begin_slot_index.has_value()) {
-        slots_not_needed_to_read_anymore.push_back(
-            command_buffer_state.command_buffer_begin_slot_index.value());
-        command_buffer_state.command_buffer_begin_slot_index.reset();
-      }
+    for (Shard& shard : shards_) {
+      for (auto& [command_buffer, command_buffer_state] : shard.command_buffer_to_state) {
+        if (command_buffer_state.pre_submission_cpu_timestamp.has_value()) continue;
+        if (device == VK_NULL_HANDLE) {
+          CHECK(shard.command_buffer_to_device.contains(command_buffer));
+          device = shard.command_buffer_to_device.at(command_buffer);
+        }
+        if (command_buffer_state.command_buffer_begin_slot_index.has_value()) {
+          slots_not_needed_to_read_anymore.push_back(
+              command_buffer_state.command_buffer_begin_slot_index.value());
+          command_buffer_state.command_buffer_begin_slot_index.reset();
+        }
 
-      if (command_buffer_state.command_buffer_end_slot_index.has_value()) {
-        slots_not_needed_to_read_anymore.push_back(
-            command_buffer_state.command_buffer_end_slot_index.value());
-        command_buffer_state.command_buffer_end_slot_index.reset();
-      }
+        if (command_buffer_state.command_buffer_end_slot_index.has_value()) {
+          slots_not_needed_to_read_anymore.push_back(
+              command_buffer_state.command_buffer_end_slot_index.value());
+          command_buffer_state.command_buffer_end_slot_index.reset();
+        }
 
-      for (Marker& marker : command_buffer_state.markers) {
-        if (marker.slot_index.has_value()) {
-          slots_not_needed_to_read_anymore.push_back(marker.slot_index.value());
-          marker.slot_index.reset();
+        for (Marker& marker : command_buffer_state.markers) {
+          if (marker.slot_index.has_value()) {
+            slots_not_needed_to_read_anymore.push_back(marker.slot_index.value());
+            marker.slot_index.reset();
+          }
         }
       }
     }
@@ -597,6 +696,7 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     is_capturing_ = false;
+    UnlockAllShards();
   }
 
  private:
@@ -640,13 +740,43 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     uint32_t local_marker_stack_size;
   };
 
-  bool RecordTimestamp(VkCommandBuffer command_buffer, VkPipelineStageFlagBits pipeline_stage_flags,
-                       uint32_t* slot_index) {
-    mutex_.AssertReaderHeld();
+  // The state of the command buffers and command pools whose handles hash to this shard. A shard
+  // is aligned to a cache line of its own, such that threads recording command buffers in different
+  // shards don't slow each other down.
+  struct alignas(64) Shard {
+    absl::Mutex mutex;
+    absl::flat_hash_map<VkCommandPool, absl::flat_hash_set<VkCommandBuffer>>
+        pool_to_command_buffers;
+    absl::flat_hash_map<VkCommandBuffer, VkDevice> command_buffer_to_device;
+    absl::flat_hash_map<VkCommandBuffer, CommandBufferState> command_buffer_to_state;
+  };
+
+  template <typename Handle>
+  [[nodiscard]] Shard& GetShard(Handle handle) {
+    return shards_[absl::Hash<Handle>{}(handle) % kNumShards];
+  }
+
+  // Used when the state of all command buffers is accessed at once, or when `is_capturing_` is
+  // modified. The shards are always locked in the same order, after `mutex_`.
+  void LockAllShards() {
+    for (Shard& shard : shards_) {
+      shard.mutex.Lock();
+    }
+  }
+
+  void UnlockAllShards() {
+    for (auto it = shards_.rbegin(); it != shards_.rend(); ++it) {
+      it->mutex.Unlock();
+    }
+  }
+
+  bool RecordTimestamp(const Shard& shard, VkCommandBuffer command_buffer,
+                       VkPipelineStageFlagBits pipeline_stage_flags, uint32_t* slot_index) {
+    shard.mutex.AssertReaderHeld();
     VkDevice device;
     {
-      CHECK(command_buffer_to_device_.contains(command_buffer));
-      device = command_buffer_to_device_.at(command_buffer);
+      CHECK(shard.command_buffer_to_device.contains(command_buffer));
+      device = shard.command_buffer_to_device.at(command_buffer);
     }
 
     VkQueryPool query_pool = timer_query_pool_->GetQueryPool(device);
@@ -660,20 +790,129 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     return true;
   }
 
-  std::optional<uint64_t> QueryGpuTimestampNs(VkDevice device, VkQueryPool query_pool,
-                                              uint32_t slot_index, float timestamp_period) {
-    static constexpr VkDeviceSize kResultStride = sizeof(uint64_t);
+  void ReadbackThreadMain() {
+    orbit_base::SetCurrentThreadName("OrbitVkReadback");
+    absl::MutexLock lock(&readback_mutex_);
+    while (true) {
+      readback_mutex_.Await(absl::Condition(
+          +[](SubmissionTracker* self) {
+            return self->readback_thread_shutdown_requested_ || !self->readback_requests_.empty();
+          },
+          this));
+      if (readback_thread_shutdown_requested_) {
+        return;
+      }
+      auto request_it = readback_requests_.begin();
+      const VkDevice device = request_it->first;
+      const uint64_t request_timestamp_ns = request_it->second;
+      readback_requests_.erase(request_it);
+      device_in_readback_ = device;
+
+      readback_mutex_.Unlock();
+      CompleteSubmits(device);
+      SendReadbackLatency(orbit_base::CaptureTimestampNs() - request_timestamp_ns);
+      readback_mutex_.Lock();
+
+      device_in_readback_.reset();
+      readback_done_.SignalAll();
+    }
+  }
 
-    uint64_t timestamp = 0;
-    VkResult result_status = dispatch_table_->GetQueryPoolResults(device)(
-        device, query_pool, slot_index, 1, sizeof(timestamp), &timestamp, kResultStride,
-        VK_QUERY_RESULT_64_BIT);
+  void SendReadbackLatency(uint64_t latency_ns) {
+    if (vulkan_layer_producer_ == nullptr || !vulkan_layer_producer_->IsCapturing()) {
+      return;
+    }
+    orbit_api::EncodedEvent encoded_event(orbit_api::kTrackUint64, "Vulkan readback latency (ns)",
+                                          latency_ns);
+    orbit_grpc_protos::ProducerCaptureEvent capture_event;
+    orbit_grpc_protos::ApiEvent* api_event = capture_event.mutable_api_event();
+    api_event->set_pid(orbit_base::GetCurrentProcessId());
+    api_event->set_tid(orbit_base::GetCurrentThreadId());
+    api_event->set_timestamp_ns(orbit_base::CaptureTimestampNs());
+    api_event->set_r0(encoded_event.args[0]);
+    api_event->set_r1(encoded_event.args[1]);
+    api_event->set_r2(encoded_event.args[2]);
+    api_event->set_r3(encoded_event.args[3]);
+    api_event->set_r4(encoded_event.args[4]);
+    api_event->set_r5(encoded_event.args[5]);
+    vulkan_layer_producer_->EnqueueCaptureEvent(std::move(capture_event));
+  }
 
-    if (result_status != VK_SUCCESS) {
-      return std::nullopt;
+  // Appends the slots of `submission` whose timestamps have not been read yet to `slots`.
+  static void CollectSlotsToQuery(const QueueSubmission& submission, std::vector<uint32_t>* slots) {
+    for (const auto& submit_info : submission.submit_infos) {
+      for (const auto& command_buffer : submit_info.command_buffers) {
+        if (!command_buffer.end_timestamp.has_value()) {
+          CHECK(command_buffer.command_buffer_end_slot_index.has_value());
+          slots->push_back(command_buffer.command_buffer_end_slot_index.value());
+        }
+        if (command_buffer.command_buffer_begin_slot_index.has_value() &&
+            !command_buffer.begin_timestamp.has_value()) {
+          slots->push_back(command_buffer.command_buffer_begin_slot_index.value());
+        }
+      }
+    }
+    for (const auto& marker_slice : submission.completed_markers) {
+      if (!marker_slice.end_info.timestamp.has_value()) {
+        slots->push_back(marker_slice.end_info.slot_index);
+      }
+      if (marker_slice.begin_info.has_value() && !marker_slice.begin_info->timestamp.has_value()) {
+        slots->push_back(marker_slice.begin_info->slot_index);
+      }
     }
+  }
 
-    return static_cast<uint64_t>(static_cast<double>(timestamp) * timestamp_period);
+  // Reads the timestamps of `slots` with one `vkGetQueryPoolResults` call per range of consecutive
+  // slots, and returns the ones that are available, converted to nanoseconds, by slot index.
+  // Ranges are not merged across gaps, as the slots in between might be reset concurrently.
+  [[nodiscard]] absl::flat_hash_map<uint32_t, uint64_t> QueryAvailableGpuTimestampsNs(
+      VkDevice device, VkQueryPool query_pool, std::vector<uint32_t> slots,
+      float timestamp_period) {
+    struct QueryResult {
+      uint64_t timestamp;
+      uint64_t availability;
+    };
+    static constexpr VkDeviceSize kResultStride = sizeof(QueryResult);
+
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+    absl::flat_hash_map<uint32_t, uint64_t> timestamps;
+    std::vector<QueryResult> results;
+    size_t range_begin = 0;
+    while (range_begin < slots.size()) {
+      size_t range_end = range_begin + 1;
+      while (range_end < slots.size() && slots[range_end] == slots[range_end - 1] + 1) {
+        ++range_end;
+      }
+      const auto query_count = static_cast<uint32_t>(range_end - range_begin);
+      results.assign(query_count, QueryResult{0, 0});
+      // With VK_QUERY_RESULT_WITH_AVAILABILITY_BIT, VK_NOT_READY only means that some of the
+      // queries in the range are not available yet. The others are still written.
+      VkResult result_status = dispatch_table_->GetQueryPoolResults(device)(
+          device, query_pool, slots[range_begin], query_count, query_count * sizeof(QueryResult),
+          results.data(), kResultStride,
+          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+      if (result_status == VK_SUCCESS || result_status == VK_NOT_READY) {
+        for (uint32_t i = 0; i < query_count; ++i) {
+          if (results[i].availability == 0) continue;
+          timestamps.emplace(slots[range_begin] + i,
+                             static_cast<uint64_t>(static_cast<double>(results[i].timestamp) *
+                                                   timestamp_period));
+        }
+      }
+      range_begin = range_end;
+    }
+    return timestamps;
+  }
+
+  [[nodiscard]] static std::optional<uint64_t> GetGpuTimestampNs(
+      const absl::flat_hash_map<uint32_t, uint64_t>& available_timestamps, uint32_t slot_index) {
+    auto it = available_timestamps.find(slot_index);
+    if (it == available_timestamps.end()) {
+      return std::nullopt;
+    }
+    return it->second;
   }
 
   static void WriteMetaInfo(const SubmissionMetaInformation& meta_info,
@@ -684,17 +923,15 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     target_proto->set_post_submission_cpu_timestamp(meta_info.post_submission_cpu_timestamp);
   }
 
-  [[nodiscard]] bool QuerySingleCommandBufferTimestamps(SubmittedCommandBuffer* command_buffer,
-                                                        std::vector<uint32_t>* query_slots_to_reset,
-                                                        VkDevice device, VkQueryPool query_pool,
-                                                        float timestamp_period) {
+  [[nodiscard]] bool QuerySingleCommandBufferTimestamps(
+      SubmittedCommandBuffer* command_buffer, std::vector<uint32_t>* query_slots_to_reset,
+      const absl::flat_hash_map<uint32_t, uint64_t>& available_timestamps) {
     CHECK(command_buffer != nullptr);
 
     if (!command_buffer->end_timestamp.has_value()) {
       CHECK(command_buffer->command_buffer_end_slot_index.has_value());
       uint32_t slot_index = command_buffer->command_buffer_end_slot_index.value();
-      std::optional<uint64_t> end_timestamp =
-          QueryGpuTimestampNs(device, query_pool, slot_index, timestamp_period);
+      std::optional<uint64_t> end_timestamp = GetGpuTimestampNs(available_timestamps, slot_index);
       if (end_timestamp.has_value()) {
         command_buffer->end_timestamp = end_timestamp;
         query_slots_to_reset->push_back(slot_index);
@@ -711,8 +948,7 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
     if (!command_buffer->begin_timestamp.has_value()) {
       uint32_t slot_index = command_buffer->command_buffer_begin_slot_index.value();
-      std::optional<uint64_t> begin_timestamp =
-          QueryGpuTimestampNs(device, query_pool, slot_index, timestamp_period);
+      std::optional<uint64_t> begin_timestamp = GetGpuTimestampNs(available_timestamps, slot_index);
       if (begin_timestamp.has_value()) {
         command_buffer->begin_timestamp = begin_timestamp;
         query_slots_to_reset->push_back(slot_index);
@@ -724,29 +960,27 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     return true;
   }
 
-  [[nodiscard]] bool QueryCommandBufferTimestamps(QueueSubmission* completed_submission,
-                                                  std::vector<uint32_t>* query_slots_to_reset,
-                                                  VkDevice device, VkQueryPool query_pool,
-                                                  float timestamp_period) {
+  [[nodiscard]] bool QueryCommandBufferTimestamps(
+      QueueSubmission* completed_submission, std::vector<uint32_t>* query_slots_to_reset,
+      const absl::flat_hash_map<uint32_t, uint64_t>& available_timestamps) {
     for (auto& completed_submit : completed_submission->submit_infos) {
       for (auto& completed_command_buffer : completed_submit.command_buffers) {
         bool queries_succeeded = QuerySingleCommandBufferTimestamps(
-            &completed_command_buffer, query_slots_to_reset, device, query_pool, timestamp_period);
+            &completed_command_buffer, query_slots_to_reset, available_timestamps);
         if (!queries_succeeded) return false;
       }
     }
     return true;
   }
 
-  [[nodiscard]] bool QuerySingleDebugMarkerTimestamps(SubmittedMarkerSlice* marker_slice,
-                                                      std::vector<uint32_t>* query_slots_to_reset,
-                                                      VkDevice device, VkQueryPool query_pool,
-                                                      float timestamp_period) {
+  [[nodiscard]] bool QuerySingleDebugMarkerTimestamps(
+      SubmittedMarkerSlice* marker_slice, std::vector<uint32_t>* query_slots_to_reset,
+      const absl::flat_hash_map<uint32_t, uint64_t>& available_timestamps) {
     CHECK(marker_slice != nullptr);
 
     if (!marker_slice->end_info.timestamp.has_value()) {
-      std::optional<uint64_t> end_timestamp = QueryGpuTimestampNs(
-          device, query_pool, marker_slice->end_info.slot_index, timestamp_period);
+      std::optional<uint64_t> end_timestamp =
+          GetGpuTimestampNs(available_timestamps, marker_slice->end_info.slot_index);
       if (end_timestamp.has_value()) {
         marker_slice->end_info.timestamp = end_timestamp;
         query_slots_to_reset->push_back(marker_slice->end_info.slot_index);
@@ -760,8 +994,8 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
 
     if (!marker_slice->begin_info->timestamp.has_value()) {
-      std::optional<uint64_t> begin_timestamp = QueryGpuTimestampNs(
-          device, query_pool, marker_slice->begin_info->slot_index, timestamp_period);
+      std::optional<uint64_t> begin_timestamp =
+          GetGpuTimestampNs(available_timestamps, marker_slice->begin_info->slot_index);
       if (begin_timestamp.has_value()) {
         marker_slice->begin_info->timestamp = begin_timestamp;
         query_slots_to_reset->push_back(marker_slice->begin_info->slot_index);
@@ -772,13 +1006,12 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     return true;
   }
 
-  [[nodiscard]] bool QueryDebugMarkerTimestamps(QueueSubmission* completed_submission,
-                                                std::vector<uint32_t>* query_slots_to_reset,
-                                                VkDevice device, VkQueryPool query_pool,
-                                                float timestamp_period) {
+  [[nodiscard]] bool QueryDebugMarkerTimestamps(
+      QueueSubmission* completed_submission, std::vector<uint32_t>* query_slots_to_reset,
+      const absl::flat_hash_map<uint32_t, uint64_t>& available_timestamps) {
     for (auto& marker_slice : completed_submission->completed_markers) {
       bool queries_succeeded = QuerySingleDebugMarkerTimestamps(
-          &marker_slice, query_slots_to_reset, device, query_pool, timestamp_period);
+          &marker_slice, query_slots_to_reset, available_timestamps);
       if (!queries_succeeded) return false;
     }
     return true;
@@ -862,16 +1095,17 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     return has_at_least_one_timestamp;
   }
 
-  // This method does not acquire a lock and MUST NOT be called without holding the `mutex_`.
-  void ResetCommandBufferUnsafe(VkCommandBuffer command_buffer) {
-    mutex_.AssertHeld();
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+  // This method does not acquire a lock and MUST NOT be called without holding the mutex of the
+  // `shard` of the command buffer.
+  void ResetCommandBufferUnsafe(Shard* shard, VkCommandBuffer command_buffer) {
+    shard->mutex.AssertHeld();
+    if (!shard->command_buffer_to_state.contains(command_buffer)) {
       return;
     }
-    CHECK(command_buffer_to_state_.contains(command_buffer));
-    CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
-    CHECK(command_buffer_to_device_.contains(command_buffer));
-    VkDevice device = command_buffer_to_device_.at(command_buffer);
+    CHECK(shard->command_buffer_to_state.contains(command_buffer));
+    CommandBufferState& state = shard->command_buffer_to_state.at(command_buffer);
+    CHECK(shard->command_buffer_to_device.contains(command_buffer));
+    VkDevice device = shard->command_buffer_to_device.at(command_buffer);
     std::vector<uint32_t> query_slots_to_reset{};
     if (state.command_buffer_begin_slot_index.has_value()) {
       query_slots_to_reset.push_back(state.command_buffer_begin_slot_index.value());
@@ -890,26 +1124,29 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
       timer_query_pool_->RollbackPendingQuerySlots(device, query_slots_to_reset);
     }
 
-    command_buffer_to_state_.erase(command_buffer);
+    shard->command_buffer_to_state.erase(command_buffer);
   }
 
-  void PersistSingleCommandBufferOnSubmit(VkDevice device, VkCommandBuffer command_buffer,
+  void PersistSingleCommandBufferOnSubmit(VkDevice* device, VkCommandBuffer command_buffer,
                                           QueueSubmission* queue_submission,
                                           SubmitInfo* submitted_submit_info,
                                           std::vector<uint32_t>* query_slots_not_needed_to_read) {
     mutex_.AssertHeld();
+    CHECK(device != nullptr);
     CHECK(queue_submission != nullptr);
     CHECK(submitted_submit_info != nullptr);
     CHECK(query_slots_not_needed_to_read != nullptr);
 
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    Shard& shard = GetShard(command_buffer);
+    absl::MutexLock lock(&shard.mutex);
+    if (!shard.command_buffer_to_state.contains(command_buffer)) {
       ERROR_ONCE(
           "Calling vkQueueSubmit on a command buffer that is in the initial state (i.e. "
           "either freshly allocated or reset with vkResetCommandBuffer).");
       return;
     }
-    CHECK(command_buffer_to_state_.contains(command_buffer));
-    CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    CHECK(shard.command_buffer_to_state.contains(command_buffer));
+    CommandBufferState& state = shard.command_buffer_to_state.at(command_buffer);
     bool has_been_submitted_before = state.pre_submission_cpu_timestamp.has_value();
 
     // Mark that this command buffer in the current state was already submitted. If the command
@@ -923,8 +1160,9 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     state.pre_submission_cpu_timestamp =
         queue_submission->meta_information.pre_submission_cpu_timestamp;
 
-    if (device == VK_NULL_HANDLE) {
-      device = command_buffer_to_device_.at(command_buffer);
+    if (*device == VK_NULL_HANDLE) {
+      CHECK(shard.command_buffer_to_device.contains(command_buffer));
+      *device = shard.command_buffer_to_device.at(command_buffer);
     }
 
     // If we haven't recorded neither the end nor the begin of a command buffer, we have no
@@ -952,21 +1190,23 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   }
 
   void PersistDebugMarkersOfASingleCommandBufferOnSubmit(
-      VkCommandBuffer command_buffer, std::optional<QueueSubmission>* queue_submission_optional,
-      QueueMarkerState* markers, std::vector<uint32_t>* marker_slots_not_needed_to_read) {
+      const Shard& shard, VkCommandBuffer command_buffer,
+      std::optional<QueueSubmission>* queue_submission_optional, QueueMarkerState* markers,
+      std::vector<uint32_t>* marker_slots_not_needed_to_read) {
     mutex_.AssertHeld();
+    shard.mutex.AssertReaderHeld();
     CHECK(queue_submission_optional != nullptr);
     CHECK(markers != nullptr);
     CHECK(marker_slots_not_needed_to_read != nullptr);
 
-    if (!command_buffer_to_state_.contains(command_buffer)) {
+    if (!shard.command_buffer_to_state.contains(command_buffer)) {
       ERROR_ONCE(
           "Calling vkQueueSubmit on a command buffer that is in the initial state (i.e. "
           "either freshly allocated or reset with vkResetCommandBuffer).");
       return;
     }
-    CHECK(command_buffer_to_state_.contains(command_buffer));
-    const CommandBufferState& state = command_buffer_to_state_.at(command_buffer);
+    CHECK(shard.command_buffer_to_state.contains(command_buffer));
+    const CommandBufferState& state = shard.command_buffer_to_state.at(command_buffer);
 
     for (const Marker& marker : state.markers) {
       std::optional<SubmittedMarker> submitted_marker = std::nullopt;
@@ -1030,21 +1270,23 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
     }
   }
 
-  absl::Mutex mutex_;
-  absl::flat_hash_map<VkCommandPool, absl::flat_hash_set<VkCommandBuffer>> pool_to_command_buffers_;
-  absl::flat_hash_map<VkCommandBuffer, VkDevice> command_buffer_to_device_;
+  // Many more than the number of threads that record command buffers concurrently, such that they
+  // rarely end up in the same shard.
+  static constexpr size_t kNumShards = 64;
+  std::array<Shard, kNumShards> shards_;
 
-  absl::flat_hash_map<VkCommandBuffer, CommandBufferState> command_buffer_to_state_;
+  // Guards the per-queue state below and serializes the submit and present path.
+  absl::Mutex mutex_;
 
   static constexpr auto kPreSubmissionCpuTimestampComparator =
       [](const QueueSubmission& lhs, const QueueSubmission& rhs) -> bool {
     return lhs.meta_information.pre_submission_cpu_timestamp >
            rhs.meta_information.pre_submission_cpu_timestamp;
   };
-  absl::flat_hash_map<VkQueue,
-                      std::priority_queue<QueueSubmission, std::vector<QueueSubmission>,
-                                          std::function<bool(QueueSubmission, QueueSubmission)>>>
-      queue_to_submission_priority_queue_;
+  using SubmissionPriorityQueue =
+      std::priority_queue<QueueSubmission, std::vector<QueueSubmission>,
+                          std::function<bool(QueueSubmission, QueueSubmission)>>;
+  absl::flat_hash_map<VkQueue, SubmissionPriorityQueue> queue_to_submission_priority_queue_;
 
   absl::flat_hash_map<VkQueue, QueueMarkerState> queue_to_markers_;
 
@@ -1054,7 +1296,8 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
 
   // We use std::numeric_limits<uint32_t>::max() to disable filtering of markers and 0 to discard
   // all debug markers.
-  uint32_t max_local_marker_depth_per_command_buffer_ = std::numeric_limits<uint32_t>::max();
+  std::atomic<uint32_t> max_local_marker_depth_per_command_buffer_ =
+      std::numeric_limits<uint32_t>::max();
   VulkanLayerProducer* vulkan_layer_producer_ = nullptr;
 
   // This boolean is precisely true between a call to OnCaptureStart and OnCaptureFinished. In
@@ -1063,7 +1306,18 @@ class SubmissionTracker : public VulkanLayerProducer::CaptureStatusListener {
   // command buffers and debug markers. A consistent state allows proper cleanup of query slots
   // either in OnCaptureFinished or when completing submits. Note that calling
   // vulkan_layer_producer_->IsCapturing() is not a correct replacement for checking this boolean.
+  // It is only modified while holding `mutex_` and the mutexes of all shards, so holding any of
+  // them is enough to read it.
   bool is_capturing_ = false;
+
+  // State of the readback thread, see `RequestCompleteSubmits`.
+  absl::Mutex readback_mutex_;
+  absl::CondVar readback_done_;
+  // The timestamp of the earliest pending request, by device.
+  absl::flat_hash_map<VkDevice, uint64_t> readback_requests_ ABSL_GUARDED_BY(readback_mutex_);
+  std::optional<VkDevice> device_in_readback_ ABSL_GUARDED_BY(readback_mutex_);
+  bool readback_thread_shutdown_requested_ ABSL_GUARDED_BY(readback_mutex_) = false;
+  std::thread readback_thread_ ABSL_GUARDED_BY(readback_mutex_);
 };
 
 }  // namespace orbit_vulkan_layer
@@ -3,11 +3,18 @@
 // found in the LICENSE file.
 
 #include <absl/base/casts.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/synchronization/notification.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <array>
+#include <atomic>
+#include <optional>
+#include <thread>
+#include <vector>
 
+#include "Api/EncodedEvent.h"
 #include "OrbitBase/ThreadUtils.h"
 #include "SubmissionTracker.h"
 #include "VulkanLayerProducer.h"
@@ -193,38 +200,61 @@ class SubmissionTrackerTest : public ::testing::Test {
   static constexpr uint64_t kTimestamp6 = 16;
   static constexpr uint64_t kTimestamp7 = 17;
 
-  const PFN_vkGetQueryPoolResults mock_get_query_pool_results_function_all_ready_ =
-      +[](VkDevice /*device*/, VkQueryPool /*queryPool*/, uint32_t first_query,
-          uint32_t query_count, size_t /*dataSize*/, void* data, VkDeviceSize /*stride*/,
-          VkQueryResultFlags flags) -> VkResult {
-    EXPECT_EQ(query_count, 1);
-    EXPECT_NE((flags & VK_QUERY_RESULT_64_BIT), 0);
-    switch (first_query) {
+  [[nodiscard]] static uint64_t TimestampOfSlot(uint32_t slot_index) {
+    switch (slot_index) {
       case kSlotIndex1:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp1;
-        break;
+        return kTimestamp1;
       case kSlotIndex2:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp2;
-        break;
+        return kTimestamp2;
       case kSlotIndex3:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp3;
-        break;
+        return kTimestamp3;
       case kSlotIndex4:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp4;
-        break;
+        return kTimestamp4;
       case kSlotIndex5:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp5;
-        break;
+        return kTimestamp5;
       case kSlotIndex6:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp6;
-        break;
+        return kTimestamp6;
       case kSlotIndex7:
-        *absl::bit_cast<uint64_t*>(data) = kTimestamp7;
-        break;
+        return kTimestamp7;
       default:
         UNREACHABLE();
     }
-    return VK_SUCCESS;
+  }
+
+  // Writes the timestamp and the availability of the queries `first_query` to
+  // `first_query + query_count - 1`, of which only `unavailable_slot` is not available.
+  static VkResult WriteQueryResults(uint32_t first_query, uint32_t query_count, void* data,
+                                    VkDeviceSize stride, VkQueryResultFlags flags,
+                                    std::optional<uint32_t> unavailable_slot) {
+    EXPECT_NE((flags & VK_QUERY_RESULT_64_BIT), 0);
+    EXPECT_NE((flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT), 0);
+    EXPECT_GE(stride, 2 * sizeof(uint64_t));
+    VkResult result = VK_SUCCESS;
+    for (uint32_t i = 0; i < query_count; ++i) {
+      auto* result_data = absl::bit_cast<uint64_t*>(static_cast<char*>(data) + i * stride);
+      if (first_query + i == unavailable_slot) {
+        result_data[1] = 0;
+        result = VK_NOT_READY;
+        continue;
+      }
+      result_data[0] = TimestampOfSlot(first_query + i);
+      result_data[1] = 1;
+    }
+    return result;
+  }
+
+  const PFN_vkGetQueryPoolResults mock_get_query_pool_results_function_all_ready_ =
+      +[](VkDevice /*device*/, VkQueryPool /*queryPool*/, uint32_t first_query,
+          uint32_t query_count, size_t /*dataSize*/, void* data, VkDeviceSize stride,
+          VkQueryResultFlags flags) -> VkResult {
+    return WriteQueryResults(first_query, query_count, data, stride, flags, std::nullopt);
+  };
+
+  const PFN_vkGetQueryPoolResults mock_get_query_pool_results_function_slot3_not_ready_ =
+      +[](VkDevice /*device*/, VkQueryPool /*queryPool*/, uint32_t first_query,
+          uint32_t query_count, size_t /*dataSize*/, void* data, VkDeviceSize stride,
+          VkQueryResultFlags flags) -> VkResult {
+    return WriteQueryResults(first_query, query_count, data, stride, flags, kSlotIndex3);
   };
 
   const PFN_vkGetQueryPoolResults mock_get_query_pool_results_function_not_ready_ =
@@ -578,12 +608,9 @@ TEST_F(SubmissionTrackerTest, WillRetryCompletingSubmissionsWhenTimestampQueryFa
 
   ExpectFourNextReadyQuerySlotCalls();
   EXPECT_CALL(dispatch_table_, GetQueryPoolResults)
-      // The first two calls should succeed to complete the first submission.
-      .WillOnce(Return(mock_get_query_pool_results_function_all_ready_))
-      .WillOnce(Return(mock_get_query_pool_results_function_all_ready_))
-      // Fail on the second submission so that we retry on the second call.
-      .WillOnce(Return(mock_get_query_pool_results_function_all_ready_))
-      .WillOnce(Return(mock_get_query_pool_results_function_not_ready_))
+      // The timestamps of both submissions are read at once. Fail on the second submission the
+      // first time, so that we retry on the second call.
+      .WillOnce(Return(mock_get_query_pool_results_function_slot3_not_ready_))
       .WillRepeatedly(Return(mock_get_query_pool_results_function_all_ready_));
 
   std::vector<uint32_t> actual_slots_done_reading1;
@@ -649,9 +676,8 @@ TEST_F(SubmissionTrackerTest, WillRetryCompletingSubmissionsWhenTimestampQueryFa
 
   EXPECT_THAT(actual_slots_done_reading1,
               UnorderedElementsAre(kSlotIndex1, kSlotIndex2, kSlotIndex4));
-  // We failed on the 4th GetQuerySlots call above, which belongs to the "begin" timestamp of the
-  // second command buffer (note that the order of calls when querying for timestamps is to query
-  // for the end timestamp first). Therefore, this must be kSlotIndex3.
+  // kSlotIndex3 belongs to the "begin" timestamp of the second command buffer, whose "end"
+  // timestamp in kSlotIndex4 was already read on the first call.
   EXPECT_THAT(actual_slots_done_reading2, UnorderedElementsAre(kSlotIndex3));
 
   ExpectSingleCommandBufferSubmissionEq(actual_capture_events[0], pre_submit_times[0],
@@ -660,6 +686,57 @@ TEST_F(SubmissionTrackerTest, WillRetryCompletingSubmissionsWhenTimestampQueryFa
                                         post_submit_times[1], tid, pid, kTimestamp3, kTimestamp4);
 }
 
+TEST_F(SubmissionTrackerTest, CompletesSubmissionsAndReportsLatencyOnTheReadbackThread) {
+  ExpectTwoNextReadyQuerySlotCalls();
+  EXPECT_CALL(dispatch_table_, GetQueryPoolResults)
+      .WillRepeatedly(Return(mock_get_query_pool_results_function_all_ready_));
+  EXPECT_CALL(timer_query_pool_, MarkQuerySlotsDoneReading).Times(1);
+  absl::Mutex mutex;
+  std::vector<orbit_grpc_protos::ProducerCaptureEvent> actual_capture_events;
+  absl::Notification latency_sent;
+  auto mock_enqueue_capture_event = [&](orbit_grpc_protos::ProducerCaptureEvent&& capture_event) {
+    absl::MutexLock lock(&mutex);
+    bool is_latency = capture_event.has_api_event();
+    actual_capture_events.push_back(std::move(capture_event));
+    if (is_latency) latency_sent.Notify();
+    return true;
+  };
+  EXPECT_CALL(*producer_, EnqueueCaptureEvent)
+      .Times(2)
+      .WillRepeatedly(Invoke(mock_enqueue_capture_event));
+
+  producer_->StartCapture();
+  tracker_.TrackCommandBuffers(device_, command_pool_, &command_buffer_, 1);
+  tracker_.MarkCommandBufferBegin(command_buffer_);
+  tracker_.MarkCommandBufferEnd(command_buffer_);
+  pid_t tid = orbit_base::GetCurrentThreadId();
+  pid_t pid = orbit_base::GetCurrentProcessId();
+  uint64_t pre_submit_time = orbit_base::CaptureTimestampNs();
+  std::optional<QueueSubmission> queue_submission_optional =
+      tracker_.PersistCommandBuffersOnSubmit(queue_, 1, &submit_info_);
+  tracker_.PersistDebugMarkersOnSubmit(queue_, 1, &submit_info_, queue_submission_optional);
+  uint64_t post_submit_time = orbit_base::CaptureTimestampNs();
+  uint64_t request_time = orbit_base::CaptureTimestampNs();
+  tracker_.RequestCompleteSubmits(device_);
+
+  ASSERT_TRUE(latency_sent.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  tracker_.CancelCompleteSubmits(device_);
+  uint64_t latency_upper_bound = orbit_base::CaptureTimestampNs() - request_time;
+
+  absl::MutexLock lock(&mutex);
+  ASSERT_EQ(actual_capture_events.size(), 2);
+  ExpectSingleCommandBufferSubmissionEq(actual_capture_events[0], pre_submit_time, post_submit_time,
+                                        tid, pid, kTimestamp1, kTimestamp2);
+  const orbit_grpc_protos::ApiEvent& api_event = actual_capture_events[1].api_event();
+  EXPECT_EQ(api_event.pid(), pid);
+  EXPECT_NE(api_event.tid(), tid);
+  orbit_api::EncodedEvent encoded_event(api_event.r0(), api_event.r1(), api_event.r2(),
+                                        api_event.r3(), api_event.r4(), api_event.r5());
+  EXPECT_EQ(encoded_event.Type(), orbit_api::kTrackUint64);
+  EXPECT_STREQ(encoded_event.event.name, "Vulkan readback latency (ns)");
+  EXPECT_LE(encoded_event.event.data, latency_upper_bound);
+}
+
 TEST_F(SubmissionTrackerTest, StopCaptureBeforeSubmissionWillResetTheSlots) {
   ExpectTwoNextReadyQuerySlotCalls();
   EXPECT_CALL(dispatch_table_, GetQueryPoolResults).Times(0);
@@ -1863,4 +1940,56 @@ TEST_F(SubmissionTrackerTest, WillWriteTimestampEvenWhenCommandBufferIsNotInInit
 
   EXPECT_THAT(actual_slots_to_reset, UnorderedElementsAre(kSlotIndex1, kSlotIndex2));
 }
+
+TEST_F(SubmissionTrackerTest, CommandBuffersCanBeRecordedOnManyThreadsConcurrently) {
+  static constexpr int kNumThreads = 8;
+  static constexpr int kNumRecordingsPerThread = 1'000;
+  static std::atomic<uint32_t> next_slot_index = 0;
+  next_slot_index = 0;
+  EXPECT_CALL(timer_query_pool_, NextReadyQuerySlot)
+      .Times(4 * kNumThreads * kNumRecordingsPerThread)
+      .WillRepeatedly(Invoke([](VkDevice /*device*/, uint32_t* allocated_slot) {
+        *allocated_slot = next_slot_index++;
+        return true;
+      }));
+  // Beginning a command buffer again rolls back the slots of the previous recording.
+  EXPECT_CALL(timer_query_pool_, RollbackPendingQuerySlots)
+      .Times(kNumThreads * (kNumRecordingsPerThread - 1));
+  EXPECT_CALL(dispatch_table_, CmdWriteTimestamp)
+      .WillRepeatedly(Return(dummy_write_timestamp_function));
+
+  std::vector<VkCommandBuffer> command_buffers;
+  for (int i = 0; i < kNumThreads; ++i) {
+    command_buffers.push_back(absl::bit_cast<VkCommandBuffer>(static_cast<uintptr_t>(i + 1)));
+  }
+
+  producer_->StartCapture();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([this, i, command_buffer = command_buffers[i]] {
+      VkCommandPool command_pool = absl::bit_cast<VkCommandPool>(static_cast<uintptr_t>(i + 1));
+      tracker_.TrackCommandBuffers(device_, command_pool, &command_buffer, 1);
+      for (int recording = 0; recording < kNumRecordingsPerThread; ++recording) {
+        tracker_.MarkCommandBufferBegin(command_buffer);
+        tracker_.MarkDebugMarkerBegin(command_buffer, "Marker", {});
+        tracker_.MarkDebugMarkerEnd(command_buffer);
+        tracker_.MarkCommandBufferEnd(command_buffer);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  VkSubmitInfo submit_info = submit_info_;
+  submit_info.commandBufferCount = kNumThreads;
+  submit_info.pCommandBuffers = command_buffers.data();
+  std::optional<QueueSubmission> queue_submission_optional =
+      tracker_.PersistCommandBuffersOnSubmit(queue_, 1, &submit_info);
+  tracker_.PersistDebugMarkersOnSubmit(queue_, 1, &submit_info, queue_submission_optional);
+
+  ASSERT_TRUE(queue_submission_optional.has_value());
+  ASSERT_EQ(queue_submission_optional->submit_infos.size(), 1);
+  EXPECT_EQ(queue_submission_optional->submit_infos[0].command_buffers.size(), kNumThreads);
+}
 }  // namespace orbit_vulkan_layer
@@ -6,16 +6,20 @@
 #define ORBIT_VULKAN_LAYER_TIMER_QUERY_POOL_H_
 
 #include <absl/container/flat_hash_map.h>
-#include <absl/container/flat_hash_set.h>
 #include <absl/synchronization/mutex.h>
 #include <vulkan/vulkan.h>
 
-#include <fstream>
-#include <numeric>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <vector>
 
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/Profiling.h"
+#include "SnapshotReaders.h"
 
 namespace orbit_vulkan_layer {
 
@@ -52,13 +56,18 @@ namespace orbit_vulkan_layer {
 // MarkQuerySlotDoneReading                   MarkQuerySlotForReset
 //
 //
-// Thread-Safety: This class is internally synchronized (using read/write locks) and can be safely
-// accessed from different threads.
+// Thread-Safety: This class is internally synchronized and can be safely accessed from different
+// threads. Only creating and destroying the pool of a device takes a lock. Retrieving and freeing
+// slots is lock-free: the state of each slot is an atomic, and the free slots of a device form a
+// lock-free stack, as command buffers get recorded on many threads at once.
 template <class DispatchTable>
 class TimerQueryPool {
  public:
   explicit TimerQueryPool(DispatchTable* dispatch_table, uint32_t num_timer_query_slots)
-      : dispatch_table_(dispatch_table), num_timer_query_slots_(num_timer_query_slots) {}
+      : dispatch_table_(dispatch_table), num_timer_query_slots_(num_timer_query_slots) {
+    CHECK(num_timer_query_slots_ < kNoSlot);
+    current_snapshot_ = snapshot_.get();
+  }
 
   // Creates and resets a vulkan `VkQueryPool`, ready to use for timestamp queries.
   void InitializeTimerQueryPool(VkDevice device) {
@@ -77,39 +86,32 @@ class TimerQueryPool {
 
     dispatch_table_->ResetQueryPoolEXT(device)(device, query_pool, 0, num_timer_query_slots_);
 
-    {
-      absl::WriterMutexLock lock(&mutex_);
-      CHECK(!device_to_query_pool_.contains(device));
-      device_to_query_pool_[device] = query_pool;
-      std::vector<SlotState> slots{num_timer_query_slots_};
-      std::fill(slots.begin(), slots.end(), SlotState::kReadyForQueryIssue);
-      device_to_query_slots_[device] = slots;
-      std::vector<uint32_t> free_slots(num_timer_query_slots_);
-      // At the beginning all slot indices in [0, num_timer_query_slots) are free.
-      std::iota(free_slots.begin(), free_slots.end(), 0);
-      device_to_free_slots_[device] = free_slots;
-    }
+    auto device_pool = std::make_unique<DevicePool>(query_pool, num_timer_query_slots_);
+    absl::MutexLock lock(&mutex_);
+    auto snapshot = std::make_unique<Snapshot>(*snapshot_);
+    snapshot->emplace(device, device_pool.get());
+    CHECK(device_pools_.emplace(device, std::move(device_pool)).second);
+    PublishSnapshot(std::move(snapshot));
   }
 
   // Destroys the VkQueryPool for the given device
   void DestroyTimerQueryPool(VkDevice device) {
-    absl::WriterMutexLock lock(&mutex_);
-    CHECK(device_to_query_pool_.contains(device));
-    VkQueryPool query_pool = device_to_query_pool_.at(device);
-    device_to_query_slots_.erase(device);
-    device_to_free_slots_.erase(device);
+    absl::MutexLock lock(&mutex_);
+    auto device_pool_it = device_pools_.find(device);
+    CHECK(device_pool_it != device_pools_.end());
+    VkQueryPool query_pool = device_pool_it->second->query_pool;
+    auto snapshot = std::make_unique<Snapshot>(*snapshot_);
+    snapshot->erase(device);
+    PublishSnapshot(std::move(snapshot));
+    device_pools_.erase(device_pool_it);
 
     dispatch_table_->DestroyQueryPool(device)(device, query_pool, nullptr);
-
-    device_to_query_pool_.erase(device);
   }
 
   // Retrieves the query pool for a given device. Note that the pool must be initialized using
   // `InitializeTimerQueryPool` before.
   [[nodiscard]] VkQueryPool GetQueryPool(VkDevice device) {
-    absl::ReaderMutexLock lock(&mutex_);
-    CHECK(device_to_query_pool_.contains(device));
-    return device_to_query_pool_.at(device);
+    return GetDevicePool(device)->query_pool;
   }
 
   // Returns a free query slot from the device's pool if one still exists. It returns `false` if all
@@ -119,18 +121,14 @@ class TimerQueryPool {
   // Note that the pool must be initialized using `InitializeTimerQueryPool` before.
   // See also `ResetQuerySlots` to make occupied slots available again.
   [[nodiscard]] bool NextReadyQuerySlot(VkDevice device, uint32_t* allocated_index) {
-    absl::WriterMutexLock lock(&mutex_);
-    CHECK(device_to_free_slots_.contains(device));
-    CHECK(device_to_query_slots_.contains(device));
-    std::vector<uint32_t>& free_slots = device_to_free_slots_.at(device);
-    if (free_slots.empty()) {
+    DevicePool* device_pool = GetDevicePool(device);
+    if (!device_pool->PopFreeSlot(allocated_index)) {
       return false;
     }
-    *allocated_index = free_slots.back();
-    free_slots.pop_back();
 
-    CHECK(device_to_query_slots_.at(device)[*allocated_index] == SlotState::kReadyForQueryIssue);
-    device_to_query_slots_.at(device)[*allocated_index] = SlotState::kQueryPendingOnGpu;
+    std::atomic<SlotState>& slot_state = device_pool->slot_states[*allocated_index];
+    CHECK(slot_state.load() == SlotState::kReadyForQueryIssue);
+    slot_state.store(SlotState::kQueryPendingOnGpu);
     return true;
   }
 
@@ -149,24 +147,21 @@ class TimerQueryPool {
     if (slot_indices.empty()) {
       return;
     }
-    absl::WriterMutexLock lock(&mutex_);
-    CHECK(device_to_query_slots_.contains(device));
-    std::vector<SlotState>& slot_states = device_to_query_slots_.at(device);
-    CHECK(device_to_free_slots_.contains(device));
-    std::vector<uint32_t>& free_slots = device_to_free_slots_.at(device);
+    DevicePool* device_pool = GetDevicePool(device);
+    std::vector<uint32_t> slots_to_reset;
     for (uint32_t slot_index : slot_indices) {
       CHECK(slot_index < num_timer_query_slots_);
-      const SlotState& current_state = slot_states[slot_index];
-      if (current_state == SlotState::kQueryPendingOnGpu) {
-        slot_states[slot_index] = SlotState::kDoneReading;
+      // Whichever of `MarkQuerySlotsDoneReading` and `MarkQuerySlotsForReset` comes second frees
+      // the slot.
+      SlotState current_state = SlotState::kQueryPendingOnGpu;
+      if (device_pool->slot_states[slot_index].compare_exchange_strong(current_state,
+                                                                       SlotState::kDoneReading)) {
         continue;
       }
       CHECK(current_state == SlotState::kResetRequested);
-      slot_states[slot_index] = SlotState::kReadyForQueryIssue;
-      free_slots.push_back(slot_index);
-      VkQueryPool query_pool = device_to_query_pool_.at(device);
-      dispatch_table_->ResetQueryPoolEXT(device)(device, query_pool, slot_index, 1);
+      slots_to_reset.push_back(slot_index);
     }
+    ResetAndFreeSlots(device, device_pool, &slots_to_reset);
   }
 
   // Marks that the underlying slots are not used by any command buffer anymore
@@ -184,24 +179,19 @@ class TimerQueryPool {
     if (slot_indices.empty()) {
       return;
     }
-    absl::WriterMutexLock lock(&mutex_);
-    CHECK(device_to_query_slots_.contains(device));
-    std::vector<SlotState>& slot_states = device_to_query_slots_.at(device);
-    CHECK(device_to_free_slots_.contains(device));
-    std::vector<uint32_t>& free_slots = device_to_free_slots_.at(device);
+    DevicePool* device_pool = GetDevicePool(device);
+    std::vector<uint32_t> slots_to_reset;
     for (uint32_t slot_index : slot_indices) {
       CHECK(slot_index < num_timer_query_slots_);
-      const SlotState& current_state = slot_states[slot_index];
-      if (current_state == SlotState::kQueryPendingOnGpu) {
-        slot_states[slot_index] = SlotState::kResetRequested;
+      SlotState current_state = SlotState::kQueryPendingOnGpu;
+      if (device_pool->slot_states[slot_index].compare_exchange_strong(
+              current_state, SlotState::kResetRequested)) {
         continue;
       }
       CHECK(current_state == SlotState::kDoneReading);
-      slot_states[slot_index] = SlotState::kReadyForQueryIssue;
-      free_slots.push_back(slot_index);
-      VkQueryPool query_pool = device_to_query_pool_.at(device);
-      dispatch_table_->ResetQueryPoolEXT(device)(device, query_pool, slot_index, 1);
+      slots_to_reset.push_back(slot_index);
     }
+    ResetAndFreeSlots(device, device_pool, &slots_to_reset);
   }
 
   // Resets an occupied slot to be ready for queries again. It will *not* call to Vulkan to reset
@@ -216,17 +206,15 @@ class TimerQueryPool {
     if (slot_indices.empty()) {
       return;
     }
-    absl::WriterMutexLock lock(&mutex_);
-    CHECK(device_to_query_slots_.contains(device));
-    std::vector<SlotState>& slot_states = device_to_query_slots_.at(device);
-    CHECK(device_to_free_slots_.contains(device));
-    std::vector<uint32_t>& free_slots = device_to_free_slots_.at(device);
-    for (uint32_t slot_index : slot_indices) {
+    DevicePool* device_pool = GetDevicePool(device);
+    // In reverse, such that the slots are retrieved again in the order they were retrieved before.
+    for (auto it = slot_indices.rbegin(); it != slot_indices.rend(); ++it) {
+      const uint32_t slot_index = *it;
       CHECK(slot_index < num_timer_query_slots_);
-      const SlotState& current_state = slot_states[slot_index];
-      CHECK(current_state == SlotState::kQueryPendingOnGpu);
-      slot_states[slot_index] = SlotState::kReadyForQueryIssue;
-      free_slots.push_back(slot_index);
+      SlotState current_state = SlotState::kQueryPendingOnGpu;
+      CHECK(device_pool->slot_states[slot_index].compare_exchange_strong(
+          current_state, SlotState::kReadyForQueryIssue));
+      device_pool->PushFreeSlot(slot_index);
     }
   }
 
@@ -238,14 +226,125 @@ class TimerQueryPool {
     kResetRequested = 3
   };
 
+  static constexpr uint32_t kNoSlot = std::numeric_limits<uint32_t>::max();
+
+  // The slots of the `VkQueryPool` of one device. The free slots form a lock-free stack, linked
+  // through `next_free_slot`. Its head packs the index of the top slot (low 32 bits) with a counter
+  // that is incremented on every modification (high 32 bits), such that a slot that is popped and
+  // pushed again between the load of the head and the compare-and-swap is noticed (ABA problem).
+  struct DevicePool {
+    DevicePool(VkQueryPool query_pool, uint32_t num_slots)
+        : query_pool(query_pool),
+          slot_states(new std::atomic<SlotState>[num_slots]),
+          next_free_slot(new std::atomic<uint32_t>[num_slots]) {
+      // At the beginning all slot indices in [0, num_slots) are free.
+      for (uint32_t slot_index = 0; slot_index < num_slots; ++slot_index) {
+        slot_states[slot_index].store(SlotState::kReadyForQueryIssue, std::memory_order_relaxed);
+        next_free_slot[slot_index].store(slot_index + 1 < num_slots ? slot_index + 1 : kNoSlot,
+                                         std::memory_order_relaxed);
+      }
+      free_slots_head.store(num_slots > 0 ? 0 : kNoSlot, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool PopFreeSlot(uint32_t* slot_index) {
+      uint64_t head = free_slots_head.load(std::memory_order_acquire);
+      while (true) {
+        const auto top = static_cast<uint32_t>(head);
+        if (top == kNoSlot) {
+          return false;
+        }
+        const uint64_t new_head =
+            NextHead(head, next_free_slot[top].load(std::memory_order_relaxed));
+        if (free_slots_head.compare_exchange_weak(head, new_head, std::memory_order_acquire,
+                                                  std::memory_order_acquire)) {
+          *slot_index = top;
+          return true;
+        }
+      }
+    }
+
+    void PushFreeSlot(uint32_t slot_index) {
+      uint64_t head = free_slots_head.load(std::memory_order_relaxed);
+      while (true) {
+        next_free_slot[slot_index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        if (free_slots_head.compare_exchange_weak(head, NextHead(head, slot_index),
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed)) {
+          return;
+        }
+      }
+    }
+
+    [[nodiscard]] static uint64_t NextHead(uint64_t head, uint32_t top) {
+      return ((head >> 32) + 1) << 32 | top;
+    }
+
+    const VkQueryPool query_pool;
+    const std::unique_ptr<std::atomic<SlotState>[]> slot_states;
+    const std::unique_ptr<std::atomic<uint32_t>[]> next_free_slot;
+    std::atomic<uint64_t> free_slots_head;
+  };
+
+  using Snapshot = absl::flat_hash_map<VkDevice, DevicePool*>;
+
+  // Resets the content of the given slots with one call to Vulkan per range of consecutive slot
+  // indices, and makes them ready for queries again. They are freed in descending order, such that
+  // they are retrieved in ascending order, which keeps the slots used by a command buffer and thus
+  // the ranges of slots read by the `SubmissionTracker` contiguous.
+  void ResetAndFreeSlots(VkDevice device, DevicePool* device_pool,
+                         std::vector<uint32_t>* slot_indices) {
+    if (slot_indices->empty()) {
+      return;
+    }
+    std::sort(slot_indices->begin(), slot_indices->end());
+    size_t range_begin = 0;
+    while (range_begin < slot_indices->size()) {
+      size_t range_end = range_begin + 1;
+      while (range_end < slot_indices->size() &&
+             (*slot_indices)[range_end] == (*slot_indices)[range_end - 1] + 1) {
+        ++range_end;
+      }
+      dispatch_table_->ResetQueryPoolEXT(device)(device, device_pool->query_pool,
+                                                 (*slot_indices)[range_begin],
+                                                 static_cast<uint32_t>(range_end - range_begin));
+      range_begin = range_end;
+    }
+    for (auto it = slot_indices->rbegin(); it != slot_indices->rend(); ++it) {
+      device_pool->slot_states[*it].store(SlotState::kReadyForQueryIssue);
+      device_pool->PushFreeSlot(*it);
+    }
+  }
+
+  // The pool stays valid until the pool of `device` is destroyed, which by the rules of Vulkan
+  // can't happen while the device is in use.
+  [[nodiscard]] DevicePool* GetDevicePool(VkDevice device) {
+    const size_t reader_shard_index = snapshot_readers_.BeginRead();
+    const Snapshot* snapshot = current_snapshot_.load();
+    auto it = snapshot->find(device);
+    CHECK(it != snapshot->end());
+    DevicePool* device_pool = it->second;
+    snapshot_readers_.EndRead(reader_shard_index);
+    return device_pool;
+  }
+
+  // Replaces the current snapshot and frees the previous one once nobody reads it anymore.
+  void PublishSnapshot(std::unique_ptr<const Snapshot> snapshot)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    current_snapshot_.store(snapshot.get());
+    snapshot_readers_.WaitForReadersOfReplacedSnapshot();
+    snapshot_ = std::move(snapshot);
+  }
+
   DispatchTable* dispatch_table_;
   const uint32_t num_timer_query_slots_;
 
+  // Only taken to initialize or destroy the pool of a device. Like in `DispatchTable`, look-ups
+  // read an immutable snapshot of the map from devices to pools, without taking any lock.
   absl::Mutex mutex_;
-
-  absl::flat_hash_map<VkDevice, VkQueryPool> device_to_query_pool_;
-  absl::flat_hash_map<VkDevice, std::vector<SlotState>> device_to_query_slots_;
-  absl::flat_hash_map<VkDevice, std::vector<uint32_t>> device_to_free_slots_;
+  std::atomic<const Snapshot*> current_snapshot_;
+  SnapshotReaders snapshot_readers_;
+  std::unique_ptr<const Snapshot> snapshot_ ABSL_GUARDED_BY(mutex_) = std::make_unique<Snapshot>();
+  absl::flat_hash_map<VkDevice, std::unique_ptr<DevicePool>> device_pools_ ABSL_GUARDED_BY(mutex_);
 };
 }  // namespace orbit_vulkan_layer
 
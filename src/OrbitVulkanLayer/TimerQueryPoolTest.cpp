@@ -3,9 +3,13 @@
 // found in the LICENSE file.
 
 #include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+#include <vector>
+
 #include "TimerQueryPool.h"
 
 using ::testing::Return;
@@ -109,6 +113,38 @@ TEST(TimerQueryPool, DestroyPoolForDeviceWillCallDestroyQueryPool) {
   EXPECT_TRUE(was_called);
 }
 
+TEST(TimerQueryPool, PoolCanBeInitializedAgainAfterDestroyingIt) {
+  MockDispatchTable dispatch_table;
+  static constexpr uint32_t kNumSlots = 4;
+  TimerQueryPool<MockDispatchTable> query_pool(&dispatch_table, kNumSlots);
+  VkDevice device = {};
+
+  EXPECT_CALL(dispatch_table, CreateQueryPool)
+      .WillRepeatedly(Return(dummy_create_query_pool_function));
+  EXPECT_CALL(dispatch_table, ResetQueryPoolEXT)
+      .WillRepeatedly(Return(dummy_reset_query_pool_function));
+  PFN_vkDestroyQueryPool dummy_destroy_query_pool_function =
+      +[](VkDevice /*device*/, VkQueryPool /*query_pool*/,
+          const VkAllocationCallbacks* /*allocator*/) {};
+  EXPECT_CALL(dispatch_table, DestroyQueryPool)
+      .WillRepeatedly(Return(dummy_destroy_query_pool_function));
+
+  query_pool.InitializeTimerQueryPool(device);
+  uint32_t slot;
+  for (uint32_t i = 0; i < kNumSlots; ++i) {
+    ASSERT_TRUE(query_pool.NextReadyQuerySlot(device, &slot));
+  }
+  EXPECT_FALSE(query_pool.NextReadyQuerySlot(device, &slot));
+  query_pool.DestroyTimerQueryPool(device);
+
+  // A new device can get the handle of a destroyed one. It gets a new pool with all slots free.
+  query_pool.InitializeTimerQueryPool(device);
+  for (uint32_t i = 0; i < kNumSlots; ++i) {
+    ASSERT_TRUE(query_pool.NextReadyQuerySlot(device, &slot));
+    EXPECT_EQ(slot, i);
+  }
+}
+
 TEST(TimerQueryPool, QueryPoolCanBeRetrievedAfterInitialization) {
   MockDispatchTable dispatch_table;
   static constexpr uint32_t kNumSlots = 4;
@@ -419,4 +455,131 @@ TEST(TimerQueryPool, CanRepeatadlyRetrieveAndResetSlots) {
   }
 }
 
+TEST(TimerQueryPool, ResetsConsecutiveSlotsWithASingleCall) {
+  MockDispatchTable dispatch_table;
+  static constexpr uint32_t kNumSlots = 4;
+  TimerQueryPool<MockDispatchTable> query_pool(&dispatch_table, kNumSlots);
+  VkDevice device = {};
+  EXPECT_CALL(dispatch_table, CreateQueryPool)
+      .WillRepeatedly(Return(dummy_create_query_pool_function));
+
+  PFN_vkResetQueryPoolEXT mock_reset_query_pool_function =
+      +[](VkDevice /*device*/, VkQueryPool /*query_pool*/, uint32_t first_query,
+          uint32_t query_count) {
+        EXPECT_EQ(first_query, 0);
+        EXPECT_EQ(query_count, kNumSlots);
+      };
+  // Once on initialization and once for all slots.
+  EXPECT_CALL(dispatch_table, ResetQueryPoolEXT)
+      .Times(2)
+      .WillRepeatedly(Return(mock_reset_query_pool_function));
+
+  query_pool.InitializeTimerQueryPool(device);
+  std::vector<uint32_t> slots;
+  for (uint32_t i = 0; i < kNumSlots; ++i) {
+    uint32_t slot;
+    ASSERT_TRUE(query_pool.NextReadyQuerySlot(device, &slot));
+    slots.push_back(slot);
+  }
+
+  query_pool.MarkQuerySlotsDoneReading(device, slots);
+  query_pool.MarkQuerySlotsForReset(device, {slots.rbegin(), slots.rend()});
+}
+
+TEST(TimerQueryPool, FreedSlotsAreRetrievedInAscendingOrder) {
+  MockDispatchTable dispatch_table;
+  static constexpr uint32_t kNumSlots = 4;
+  TimerQueryPool<MockDispatchTable> query_pool(&dispatch_table, kNumSlots);
+  VkDevice device = {};
+  EXPECT_CALL(dispatch_table, CreateQueryPool)
+      .WillRepeatedly(Return(dummy_create_query_pool_function));
+  EXPECT_CALL(dispatch_table, ResetQueryPoolEXT)
+      .WillRepeatedly(Return(dummy_reset_query_pool_function));
+
+  query_pool.InitializeTimerQueryPool(device);
+  std::vector<uint32_t> slots;
+  for (uint32_t i = 0; i < kNumSlots; ++i) {
+    uint32_t slot;
+    ASSERT_TRUE(query_pool.NextReadyQuerySlot(device, &slot));
+    EXPECT_EQ(slot, i);
+    slots.push_back(slot);
+  }
+
+  query_pool.MarkQuerySlotsForReset(device, {3, 1});
+  query_pool.MarkQuerySlotsForReset(device, {0, 2});
+  query_pool.MarkQuerySlotsDoneReading(device, {2, 0, 3, 1});
+
+  for (uint32_t i = 0; i < kNumSlots; ++i) {
+    uint32_t slot;
+    ASSERT_TRUE(query_pool.NextReadyQuerySlot(device, &slot));
+    EXPECT_EQ(slot, i);
+  }
+}
+
+TEST(TimerQueryPool, SlotsAreUniqueWhenRetrievedAndResetFromManyThreads) {
+  MockDispatchTable dispatch_table;
+  static constexpr uint32_t kNumSlots = 64;
+  static constexpr int kNumThreads = 8;
+  static constexpr int kNumIterationsPerThread = 10'000;
+  TimerQueryPool<MockDispatchTable> query_pool(&dispatch_table, kNumSlots);
+  VkDevice device = {};
+  EXPECT_CALL(dispatch_table, CreateQueryPool)
+      .WillRepeatedly(Return(dummy_create_query_pool_function));
+  EXPECT_CALL(dispatch_table, ResetQueryPoolEXT)
+      .WillRepeatedly(Return(dummy_reset_query_pool_function));
+
+  query_pool.InitializeTimerQueryPool(device);
+
+  absl::Mutex mutex;
+  absl::flat_hash_set<uint32_t> slots_in_use;
+  auto retrieve_and_reset_slots = [&](int thread_index) {
+    for (int i = 0; i < kNumIterationsPerThread; ++i) {
+      uint32_t slot_index;
+      if (!query_pool.NextReadyQuerySlot(device, &slot_index)) {
+        continue;
+      }
+      {
+        absl::MutexLock lock(&mutex);
+        EXPECT_TRUE(slots_in_use.insert(slot_index).second);
+      }
+      std::vector<uint32_t> reset_slots{slot_index};
+      // The slot is in use until it is freed by the calls below. The lock is held until it is
+      // erased, so that another thread that retrieves it right after it was freed only inserts it
+      // afterwards. Retrievals still run concurrently with the calls.
+      absl::MutexLock lock(&mutex);
+      // The two calls needed for an actual reset come in different orders, like they do from the
+      // submit and the reset path of command buffers.
+      if ((thread_index + i) % 3 == 0) {
+        query_pool.RollbackPendingQuerySlots(device, reset_slots);
+      } else if ((thread_index + i) % 3 == 1) {
+        query_pool.MarkQuerySlotsDoneReading(device, reset_slots);
+        query_pool.MarkQuerySlotsForReset(device, reset_slots);
+      } else {
+        query_pool.MarkQuerySlotsForReset(device, reset_slots);
+        query_pool.MarkQuerySlotsDoneReading(device, reset_slots);
+      }
+      slots_in_use.erase(slot_index);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int thread_index = 0; thread_index < kNumThreads; ++thread_index) {
+    threads.emplace_back(retrieve_and_reset_slots, thread_index);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // All slots must be free again.
+  absl::flat_hash_set<uint32_t> slots;
+  for (uint32_t i = 0; i < kNumSlots; ++i) {
+    uint32_t slot;
+    ASSERT_TRUE(query_pool.NextReadyQuerySlot(device, &slot));
+    slots.insert(slot);
+  }
+  EXPECT_EQ(slots.size(), kNumSlots);
+  uint32_t slot;
+  EXPECT_FALSE(query_pool.NextReadyQuerySlot(device, &slot));
+}
+
 }  // namespace orbit_vulkan_layer
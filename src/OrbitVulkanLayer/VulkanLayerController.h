@@ -215,6 +215,7 @@ class VulkanLayerController {
   void OnDestroyDevice(VkDevice device, const VkAllocationCallbacks* allocator) {
     PFN_vkDestroyDevice destroy_device_function = dispatch_table_.DestroyDevice(device);
     CHECK(destroy_device_function != nullptr);
+    submission_tracker_.CancelCompleteSubmits(device);
     device_manager_.UntrackLogicalDevice(device);
     timer_query_pool_.DestroyTimerQueryPool(device);
     dispatch_table_.RemoveDeviceDispatchTable(device);
@@ -305,7 +306,7 @@ class VulkanLayerController {
   }
 
   [[nodiscard]] VkResult OnQueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* present_info) {
-    submission_tracker_.CompleteSubmits(queue_manager_.GetDeviceOfQueue(queue));
+    submission_tracker_.RequestCompleteSubmits(queue_manager_.GetDeviceOfQueue(queue));
     return dispatch_table_.QueuePresentKHR(queue)(queue, present_info);
   }
 
@@ -123,7 +123,8 @@ class MockSubmissionTracker {
               (VkQueue, uint32_t, const VkSubmitInfo* submits));
   MOCK_METHOD(void, PersistDebugMarkersOnSubmit,
               (VkQueue, uint32_t, const VkSubmitInfo*, std::optional<QueueSubmission>));
-  MOCK_METHOD(void, CompleteSubmits, (VkDevice));
+  MOCK_METHOD(void, RequestCompleteSubmits, (VkDevice));
+  MOCK_METHOD(void, CancelCompleteSubmits, (VkDevice));
   MOCK_METHOD(void, MarkDebugMarkerBegin, (VkCommandBuffer, const char*, Color));
   MOCK_METHOD(void, MarkDebugMarkerEnd, (VkCommandBuffer));
 };
@@ -722,6 +723,8 @@ TEST_F(VulkanLayerControllerTest, WillCleanUpOnDestroyDevice) {
   EXPECT_CALL(*device_manager, UntrackLogicalDevice).Times(1);
   const MockTimerQueryPool* query_pool = controller_.timer_query_pool();
   EXPECT_CALL(*query_pool, DestroyTimerQueryPool).Times(1);
+  const MockSubmissionTracker* submission_tracker = controller_.submission_tracker();
+  EXPECT_CALL(*submission_tracker, CancelCompleteSubmits).Times(1);
 
   VkDevice device = {};
 
@@ -898,7 +901,7 @@ TEST_F(VulkanLayerControllerTest, ForwardsOnQueuePresentKHRToSubmissionTracker)
   EXPECT_CALL(*dispatch_table, QueuePresentKHR).Times(1).WillOnce(Return(fake_queue_present));
 
   const MockSubmissionTracker* submission_tracker = controller_.submission_tracker();
-  EXPECT_CALL(*submission_tracker, CompleteSubmits).Times(1);
+  EXPECT_CALL(*submission_tracker, RequestCompleteSubmits).Times(1);
   VkDevice device = {};
   const MockQueueManager* queue_manager = controller_.queue_manager();
   EXPECT_CALL(*queue_manager, GetDeviceOfQueue).Times(1).WillOnce(Return(device));
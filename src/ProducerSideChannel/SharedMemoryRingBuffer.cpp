@@ -0,0 +1,217 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ProducerSideChannel/SharedMemoryRingBuffer.h"
+
+#include <absl/strings/str_format.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/SafeStrerror.h"
+#include "OrbitBase/ThreadUtils.h"
+
+namespace orbit_producer_side_channel {
+
+// The layout of the beginning of the file. The records follow at offset `kRecordsOffset`. The write
+// index and the read index are on separate cache lines as they are written by different processes.
+struct SharedMemoryRingBufferHeader {
+  std::atomic<uint64_t> magic;
+  SharedMemoryRecordType record_type;
+  uint32_t record_size;
+  uint64_t capacity;
+  int32_t pid;
+  std::atomic<uint32_t> closed;
+  alignas(64) std::atomic<uint64_t> write_index;
+  alignas(64) std::atomic<uint64_t> read_index;
+};
+
+namespace {
+
+// Written last by `Create`, so that `Open` never sees a partially initialized header.
+constexpr uint64_t kMagic = 0x4f524249'5452'4e47;  // "ORBITRNG"
+constexpr uint64_t kRecordsOffset = 256;
+// The size of the memfd can't change after `Create`, so a mapping of it can never become invalid.
+constexpr int kRequiredSeals = F_SEAL_SHRINK | F_SEAL_GROW;
+static_assert(sizeof(SharedMemoryRingBufferHeader) <= kRecordsOffset);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+[[nodiscard]] bool IsPowerOfTwo(uint64_t value) { return value != 0 && (value & (value - 1)) == 0; }
+
+[[nodiscard]] ErrorMessageOr<void*> MapFile(const orbit_base::unique_fd& fd, uint64_t size,
+                                            std::string_view name) {
+  void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+  if (mapping == MAP_FAILED) {
+    return ErrorMessage(absl::StrFormat("Unable to map \"%s\": %s", name, SafeStrerror(errno)));
+  }
+  return mapping;
+}
+
+}  // namespace
+
+SharedMemoryRingBuffer::SharedMemoryRingBuffer(std::filesystem::path path, orbit_base::unique_fd fd,
+                                               void* mapping, uint64_t mapping_size,
+                                               SharedMemoryRecordType record_type,
+                                               uint32_t record_size, uint64_t capacity, pid_t pid)
+    : path_{std::move(path)},
+      fd_{std::move(fd)},
+      mapping_{mapping},
+      mapping_size_{mapping_size},
+      record_type_{record_type},
+      record_size_{record_size},
+      capacity_{capacity},
+      pid_{pid} {}
+
+SharedMemoryRingBuffer::~SharedMemoryRingBuffer() {
+  if (munmap(mapping_, mapping_size_) != 0) {
+    ERROR("Unable to unmap \"%s\": %s", path_.string(), SafeStrerror(errno));
+  }
+}
+
+ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> SharedMemoryRingBuffer::Create(
+    std::string_view name, SharedMemoryRecordType record_type, uint32_t record_size,
+    uint64_t capacity) {
+  CHECK(record_size > 0);
+  CHECK(IsPowerOfTwo(capacity));
+  const uint64_t mapping_size = kRecordsOffset + capacity * record_size;
+
+  orbit_base::unique_fd fd{
+      memfd_create(std::string{name}.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING)};
+  if (!fd.valid()) {
+    return ErrorMessage(absl::StrFormat("Unable to create \"%s\": %s", name, SafeStrerror(errno)));
+  }
+  if (ftruncate(fd.get(), mapping_size) != 0) {
+    return ErrorMessage(absl::StrFormat("Unable to resize \"%s\": %s", name, SafeStrerror(errno)));
+  }
+  if (fcntl(fd.get(), F_ADD_SEALS, kRequiredSeals | F_SEAL_SEAL) != 0) {
+    return ErrorMessage(absl::StrFormat("Unable to seal \"%s\": %s", name, SafeStrerror(errno)));
+  }
+  OUTCOME_TRY(mapping, MapFile(fd, mapping_size, name));
+
+  const pid_t pid = orbit_base::GetCurrentProcessId();
+  auto* header = new (mapping) SharedMemoryRingBufferHeader{};
+  header->record_type = record_type;
+  header->record_size = record_size;
+  header->capacity = capacity;
+  header->pid = pid;
+  header->magic.store(kMagic, std::memory_order_release);
+
+  std::filesystem::path path = absl::StrFormat("/proc/%d/fd/%d", pid, fd.get());
+  return std::unique_ptr<SharedMemoryRingBuffer>(new SharedMemoryRingBuffer(
+      std::move(path), std::move(fd), mapping, mapping_size, record_type, record_size, capacity,
+      pid));
+}
+
+ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> SharedMemoryRingBuffer::Open(
+    const std::filesystem::path& path) {
+  orbit_base::unique_fd fd{TEMP_FAILURE_RETRY(open(path.string().c_str(), O_RDWR | O_CLOEXEC))};
+  if (!fd.valid()) {
+    return ErrorMessage(
+        absl::StrFormat("Unable to open \"%s\": %s", path.string(), SafeStrerror(errno)));
+  }
+  struct stat file_stat {};
+  if (fstat(fd.get(), &file_stat) != 0) {
+    return ErrorMessage(
+        absl::StrFormat("Unable to stat \"%s\": %s", path.string(), SafeStrerror(errno)));
+  }
+  if (!S_ISREG(file_stat.st_mode)) {
+    return ErrorMessage(absl::StrFormat("\"%s\" is not a regular file.", path.string()));
+  }
+  // Only once the size is sealed, it can be trusted to stay the one from `fstat`.
+  const int seals = fcntl(fd.get(), F_GET_SEALS);
+  if (seals == -1 || (seals & kRequiredSeals) != kRequiredSeals) {
+    return ErrorMessage(
+        absl::StrFormat("\"%s\" is not sealed against resizing.", path.string()));
+  }
+  const auto mapping_size = static_cast<uint64_t>(file_stat.st_size);
+  if (mapping_size < kRecordsOffset) {
+    return ErrorMessage(absl::StrFormat("\"%s\" is not initialized yet.", path.string()));
+  }
+  OUTCOME_TRY(mapping, MapFile(fd, mapping_size, path.string()));
+
+  const auto* header = static_cast<const SharedMemoryRingBufferHeader*>(mapping);
+  if (header->magic.load(std::memory_order_acquire) != kMagic) {
+    munmap(mapping, mapping_size);
+    return ErrorMessage(absl::StrFormat("\"%s\" is not initialized yet.", path.string()));
+  }
+  const SharedMemoryRecordType record_type = header->record_type;
+  const uint32_t record_size = header->record_size;
+  const uint64_t capacity = header->capacity;
+  const pid_t pid = header->pid;
+  if (record_size == 0 || !IsPowerOfTwo(capacity) ||
+      capacity > (mapping_size - kRecordsOffset) / record_size ||
+      kRecordsOffset + capacity * record_size != mapping_size) {
+    munmap(mapping, mapping_size);
+    return ErrorMessage(absl::StrFormat("\"%s\" has an invalid header.", path.string()));
+  }
+
+  return std::unique_ptr<SharedMemoryRingBuffer>(new SharedMemoryRingBuffer(
+      path, std::move(fd), mapping, mapping_size, record_type, record_size, capacity, pid));
+}
+
+SharedMemoryRingBufferHeader* SharedMemoryRingBuffer::header() const {
+  return static_cast<SharedMemoryRingBufferHeader*>(mapping_);
+}
+
+uint8_t* SharedMemoryRingBuffer::records() const {
+  return static_cast<uint8_t*>(mapping_) + kRecordsOffset;
+}
+
+bool SharedMemoryRingBuffer::TryWrite(const void* record) {
+  SharedMemoryRingBufferHeader* header = this->header();
+  const uint64_t write_index = header->write_index.load(std::memory_order_relaxed);
+  if (write_index - cached_read_index_ >= capacity_) {
+    cached_read_index_ = header->read_index.load(std::memory_order_acquire);
+    if (write_index - cached_read_index_ >= capacity_) return false;
+  }
+  std::memcpy(records() + (write_index & (capacity_ - 1)) * record_size_, record, record_size_);
+  header->write_index.store(write_index + 1, std::memory_order_release);
+  return true;
+}
+
+ErrorMessageOr<uint64_t> SharedMemoryRingBuffer::Read(void* records, uint64_t max_records) {
+  SharedMemoryRingBufferHeader* header = this->header();
+  const uint64_t read_index = header->read_index.load(std::memory_order_relaxed);
+  const uint64_t write_index = header->write_index.load(std::memory_order_acquire);
+  const uint64_t available = write_index - read_index;
+  if (available > capacity_) {
+    return ErrorMessage(absl::StrFormat("\"%s\" has inconsistent indices (read %u, write %u).",
+                                        path_.string(), read_index, write_index));
+  }
+
+  const uint64_t num_records = std::min(available, max_records);
+  const uint64_t first_slot = read_index & (capacity_ - 1);
+  const uint64_t num_records_before_wrap = std::min(num_records, capacity_ - first_slot);
+  std::memcpy(records, this->records() + first_slot * record_size_,
+              num_records_before_wrap * record_size_);
+  std::memcpy(static_cast<uint8_t*>(records) + num_records_before_wrap * record_size_,
+              this->records(), (num_records - num_records_before_wrap) * record_size_);
+  header->read_index.store(read_index + num_records, std::memory_order_release);
+  return num_records;
+}
+
+bool SharedMemoryRingBuffer::IsEmpty() const {
+  return header()->read_index.load(std::memory_order_acquire) ==
+         header()->write_index.load(std::memory_order_acquire);
+}
+
+void SharedMemoryRingBuffer::Close() { header()->closed.store(1, std::memory_order_release); }
+
+bool SharedMemoryRingBuffer::IsClosed() const {
+  return header()->closed.load(std::memory_order_acquire) != 0;
+}
+
+}  // namespace orbit_producer_side_channel
@@ -0,0 +1,183 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_format.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Result.h"
+#include "ProducerSideChannel/SharedMemoryRingBuffer.h"
+
+namespace orbit_producer_side_channel {
+
+namespace {
+
+struct TestRecord {
+  uint64_t value;
+  uint64_t value_squared;
+};
+
+[[nodiscard]] std::unique_ptr<SharedMemoryRingBuffer> CreateRingBuffer(uint64_t capacity) {
+  ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> ring_buffer =
+      SharedMemoryRingBuffer::Create("orbit-shared-memory-ring-buffer-test",
+                                     SharedMemoryRecordType::kApiEvent, sizeof(TestRecord),
+                                     capacity);
+  EXPECT_TRUE(ring_buffer.has_value()) << ring_buffer.error().message();
+  return std::move(ring_buffer.value());
+}
+
+[[nodiscard]] std::unique_ptr<SharedMemoryRingBuffer> OpenRingBuffer(
+    const std::filesystem::path& path) {
+  ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> ring_buffer =
+      SharedMemoryRingBuffer::Open(path);
+  EXPECT_TRUE(ring_buffer.has_value()) << ring_buffer.error().message();
+  return std::move(ring_buffer.value());
+}
+
+}  // namespace
+
+TEST(SharedMemoryRingBuffer, WriteAndRead) {
+  std::unique_ptr<SharedMemoryRingBuffer> writer = CreateRingBuffer(16);
+  std::unique_ptr<SharedMemoryRingBuffer> reader = OpenRingBuffer(writer->path());
+
+  EXPECT_EQ(reader->record_type(), SharedMemoryRecordType::kApiEvent);
+  EXPECT_EQ(reader->record_size(), sizeof(TestRecord));
+  EXPECT_EQ(reader->capacity(), 16);
+  EXPECT_EQ(reader->pid(), getpid());
+  EXPECT_TRUE(reader->IsEmpty());
+
+  EXPECT_TRUE(writer->TryWrite(TestRecord{1, 1}));
+  EXPECT_TRUE(writer->TryWrite(TestRecord{2, 4}));
+  EXPECT_TRUE(writer->TryWrite(TestRecord{3, 9}));
+  EXPECT_FALSE(reader->IsEmpty());
+
+  std::vector<TestRecord> records(16);
+  ErrorMessageOr<uint64_t> num_records = reader->Read(records.data(), records.size());
+  ASSERT_TRUE(num_records.has_value()) << num_records.error().message();
+  ASSERT_EQ(num_records.value(), 3);
+  for (uint64_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(records[i].value, i + 1);
+    EXPECT_EQ(records[i].value_squared, (i + 1) * (i + 1));
+  }
+  EXPECT_TRUE(reader->IsEmpty());
+  EXPECT_TRUE(writer->IsEmpty());
+}
+
+TEST(SharedMemoryRingBuffer, RejectsWritesWhenFullAndWrapsAround) {
+  std::unique_ptr<SharedMemoryRingBuffer> writer = CreateRingBuffer(4);
+  std::unique_ptr<SharedMemoryRingBuffer> reader = OpenRingBuffer(writer->path());
+
+  for (uint64_t i = 0; i < 4; ++i) {
+    EXPECT_TRUE(writer->TryWrite(TestRecord{i, i * i}));
+  }
+  EXPECT_FALSE(writer->TryWrite(TestRecord{4, 16}));
+
+  std::vector<TestRecord> records(4);
+  ErrorMessageOr<uint64_t> num_records = reader->Read(records.data(), 3);
+  ASSERT_TRUE(num_records.has_value());
+  EXPECT_EQ(num_records.value(), 3);
+
+  EXPECT_TRUE(writer->TryWrite(TestRecord{4, 16}));
+  EXPECT_TRUE(writer->TryWrite(TestRecord{5, 25}));
+  EXPECT_TRUE(writer->TryWrite(TestRecord{6, 36}));
+  EXPECT_FALSE(writer->TryWrite(TestRecord{7, 49}));
+
+  num_records = reader->Read(records.data(), records.size());
+  ASSERT_TRUE(num_records.has_value());
+  ASSERT_EQ(num_records.value(), 4);
+  for (uint64_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(records[i].value, i + 3);
+  }
+}
+
+TEST(SharedMemoryRingBuffer, RejectsRecordsOfWrongSize) {
+  std::unique_ptr<SharedMemoryRingBuffer> writer = CreateRingBuffer(4);
+  EXPECT_FALSE(writer->TryWrite(uint64_t{42}));
+  EXPECT_TRUE(writer->IsEmpty());
+}
+
+TEST(SharedMemoryRingBuffer, CloseIsVisibleToReader) {
+  std::unique_ptr<SharedMemoryRingBuffer> writer = CreateRingBuffer(4);
+  std::unique_ptr<SharedMemoryRingBuffer> reader = OpenRingBuffer(writer->path());
+  EXPECT_FALSE(reader->IsClosed());
+  writer->Close();
+  EXPECT_TRUE(reader->IsClosed());
+}
+
+TEST(SharedMemoryRingBuffer, CantBeResized) {
+  std::unique_ptr<SharedMemoryRingBuffer> writer = CreateRingBuffer(4);
+  EXPECT_EQ(writer->path().string(), absl::StrFormat("/proc/%d/fd/%d", getpid(), writer->fd()));
+  EXPECT_NE(ftruncate(writer->fd(), 0), 0);
+  EXPECT_NE(ftruncate(writer->fd(), 1024 * 1024), 0);
+}
+
+TEST(SharedMemoryRingBuffer, OpenFailsForInvalidFiles) {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() /
+      absl::StrFormat("orbit-shared-memory-ring-buffer-test-%d", getpid());
+  std::filesystem::remove(path);
+  EXPECT_TRUE(SharedMemoryRingBuffer::Open(path).has_error());
+
+  // A regular file could be truncated while it is mapped.
+  {
+    std::ofstream file{path, std::ios::binary};
+    file << std::string(4096, '\0');
+  }
+  ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> ring_buffer =
+      SharedMemoryRingBuffer::Open(path);
+  std::filesystem::remove(path);
+  ASSERT_TRUE(ring_buffer.has_error());
+  EXPECT_NE(ring_buffer.error().message().find("not sealed"), std::string::npos);
+
+  // A sealed memfd without a valid header.
+  orbit_base::unique_fd fd{memfd_create("orbit-shared-memory-ring-buffer-test", MFD_ALLOW_SEALING)};
+  ASSERT_TRUE(fd.valid());
+  ASSERT_EQ(ftruncate(fd.get(), 4096), 0);
+  ASSERT_EQ(fcntl(fd.get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW), 0);
+  ring_buffer = SharedMemoryRingBuffer::Open(absl::StrFormat("/proc/self/fd/%d", fd.get()));
+  ASSERT_TRUE(ring_buffer.has_error());
+  EXPECT_NE(ring_buffer.error().message().find("not initialized"), std::string::npos);
+}
+
+TEST(SharedMemoryRingBuffer, ConcurrentWriterAndReader) {
+  std::unique_ptr<SharedMemoryRingBuffer> writer = CreateRingBuffer(64);
+  std::unique_ptr<SharedMemoryRingBuffer> reader = OpenRingBuffer(writer->path());
+
+  constexpr uint64_t kNumRecords = 100'000;
+  std::thread writer_thread{[&writer] {
+    for (uint64_t i = 0; i < kNumRecords; ++i) {
+      while (!writer->TryWrite(TestRecord{i, i * i})) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+
+  std::vector<TestRecord> records(16);
+  uint64_t expected_value = 0;
+  while (expected_value < kNumRecords) {
+    ErrorMessageOr<uint64_t> num_records = reader->Read(records.data(), records.size());
+    ASSERT_TRUE(num_records.has_value()) << num_records.error().message();
+    if (num_records.value() == 0) std::this_thread::yield();
+    for (uint64_t i = 0; i < num_records.value(); ++i) {
+      ASSERT_EQ(records[i].value, expected_value);
+      ASSERT_EQ(records[i].value_squared, expected_value * expected_value);
+      ++expected_value;
+    }
+  }
+  writer_thread.join();
+  EXPECT_TRUE(reader->IsEmpty());
+}
+
+}  // namespace orbit_producer_side_channel
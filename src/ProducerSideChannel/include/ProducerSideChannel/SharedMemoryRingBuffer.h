@@ -0,0 +1,121 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef PRODUCER_SIDE_CHANNEL_SHARED_MEMORY_RING_BUFFER_H_
+#define PRODUCER_SIDE_CHANNEL_SHARED_MEMORY_RING_BUFFER_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "OrbitBase/File.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_producer_side_channel {
+
+// Names of ring buffers start with this prefix. OrbitService finds the ring buffers of the target
+// process among its file descriptors, "/proc/<pid>/fd/<fd>" linking to "/memfd:<name> (deleted)".
+constexpr std::string_view kSharedMemoryRingBufferNamePrefix = "orbit-producer-ring-";
+
+// Identifies the format of the records in a ring buffer, so that OrbitService knows how to turn
+// them into ProducerCaptureEvents.
+enum class SharedMemoryRecordType : uint32_t {
+  kInvalid = 0,
+  // orbit_api::ApiEvent from Api/EncodedEvent.h.
+  kApiEvent = 1,
+};
+
+struct SharedMemoryRingBufferHeader;
+
+// A single-producer single-consumer ring buffer of fixed size records in shared memory. A producer
+// in the target process creates the ring buffer with `Create` and writes records with `TryWrite`,
+// OrbitService maps the same memory with `Open` and reads the records with `Read`. The records are
+// written as they are, i.e., no serialization happens in the target process.
+//
+// The memory is a memfd that is sealed against resizing, so the creating process can't make the
+// mapping of the reader fault (SIGBUS) by truncating it, and it never appears in the file system.
+//
+// Each instance must only be written to by one thread and only be read from by one thread; writer
+// and reader are typically in different processes.
+class SharedMemoryRingBuffer {
+ public:
+  // Creates the memfd `name` for a ring buffer of `capacity` records of `record_size` bytes each.
+  // `capacity` must be a power of two.
+  [[nodiscard]] static ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> Create(
+      std::string_view name, SharedMemoryRecordType record_type, uint32_t record_size,
+      uint64_t capacity);
+
+  // Maps an existing ring buffer, `path` usually being "/proc/<pid>/fd/<fd>". Files that are not
+  // sealed against resizing are refused. As the memory can be modified by the process that created
+  // it at any time, the header is validated here and the indices are validated on every `Read`.
+  [[nodiscard]] static ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> Open(
+      const std::filesystem::path& path);
+
+  ~SharedMemoryRingBuffer();
+  SharedMemoryRingBuffer(const SharedMemoryRingBuffer&) = delete;
+  SharedMemoryRingBuffer& operator=(const SharedMemoryRingBuffer&) = delete;
+
+  // Copies `record_size()` bytes from `record` into the ring buffer. Returns false and leaves the
+  // ring buffer untouched if it is full.
+  [[nodiscard]] bool TryWrite(const void* record);
+  template <typename Record>
+  [[nodiscard]] bool TryWrite(const Record& record) {
+    static_assert(std::is_trivially_copyable_v<Record>);
+    return sizeof(Record) == record_size_ && TryWrite(static_cast<const void*>(&record));
+  }
+
+  // Moves up to `max_records` records into `records`, which needs to have room for
+  // `max_records * record_size()` bytes. Returns the number of records read, or an error if the
+  // indices in shared memory are inconsistent.
+  [[nodiscard]] ErrorMessageOr<uint64_t> Read(void* records, uint64_t max_records);
+
+  [[nodiscard]] bool IsEmpty() const;
+
+  // Marks that no more records will be written, e.g., because the writing thread exited. The reader
+  // unmaps the ring buffer once it read the remaining records.
+  void Close();
+  [[nodiscard]] bool IsClosed() const;
+
+  // For the creator of the ring buffer, this is the path under which other processes can open it.
+  [[nodiscard]] const std::filesystem::path& path() const { return path_; }
+  [[nodiscard]] int fd() const { return fd_.get(); }
+  [[nodiscard]] SharedMemoryRecordType record_type() const { return record_type_; }
+  [[nodiscard]] uint32_t record_size() const { return record_size_; }
+  [[nodiscard]] uint64_t capacity() const { return capacity_; }
+  [[nodiscard]] pid_t pid() const { return pid_; }
+
+ private:
+  SharedMemoryRingBuffer(std::filesystem::path path, orbit_base::unique_fd fd, void* mapping,
+                         uint64_t mapping_size, SharedMemoryRecordType record_type,
+                         uint32_t record_size, uint64_t capacity, pid_t pid);
+
+  [[nodiscard]] SharedMemoryRingBufferHeader* header() const;
+  [[nodiscard]] uint8_t* records() const;
+
+  std::filesystem::path path_;
+  // Kept open so that OrbitService can find the ring buffer among the file descriptors of the
+  // process that created it.
+  orbit_base::unique_fd fd_;
+  void* mapping_;
+  uint64_t mapping_size_;
+  // Copies of the values in the header: the other process could modify the header, so these are
+  // the values that are trusted.
+  SharedMemoryRecordType record_type_;
+  uint32_t record_size_;
+  uint64_t capacity_;
+  pid_t pid_;
+  // The writer's last observation of the read index. The writer only needs to load the read index
+  // (which lives on a cache line written by the other process) when this one says the ring buffer
+  // is full.
+  uint64_t cached_read_index_ = 0;
+};
+
+}  // namespace orbit_producer_side_channel
+
+#endif  // PRODUCER_SIDE_CHANNEL_SHARED_MEMORY_RING_BUFFER_H_
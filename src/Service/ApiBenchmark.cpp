@@ -0,0 +1,229 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the overhead of an ORBIT_SCOPE, i.e., of a pair of kScopeStart and kScopeStop events,
+// for each way the producer of liborbit can send its events: through the lock-free queue and gRPC,
+// through shared memory ring buffers, with names sent inline or interned, and with timestamps from
+// CLOCK_MONOTONIC or the time stamp counter. This process plays the role of OrbitService for the
+// producer of liborbit, which it links. OrbitService must not be running at the same time, as its
+// producer side socket is used.
+
+// Call the functions of liborbit directly instead of loading them with dlopen.
+#define ORBIT_API_INTERNAL_IMPL
+#include "Api/Orbit.h"
+
+#include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
+#include <grpcpp/grpcpp.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
+#include "ProducerEventProcessor.h"
+#include "ProducerSideChannel/ProducerSideChannel.h"
+#include "SharedMemoryRingBufferReader.h"
+#include "capture.pb.h"
+#include "producer_side_services.grpc.pb.h"
+
+namespace {
+
+using orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest;
+using orbit_grpc_protos::ReceiveCommandsAndSendEventsResponse;
+
+// ORBIT_SCOPEs are measured in batches, with a pause in between in which OrbitService (here
+// SharedMemoryRingBufferReader) can empty the ring buffers, as they would otherwise overflow.
+constexpr uint64_t kNumBatches = 256;
+constexpr uint64_t kScopesPerBatch = 2048;
+constexpr std::chrono::milliseconds kPauseBetweenBatches{3};
+
+// Sends the capture commands requested with StartCapture and StopCapture to the producer that
+// connects, and counts the events it sends over gRPC.
+class FakeProducerSideService final : public orbit_grpc_protos::ProducerSideService::Service {
+ public:
+  grpc::Status ReceiveCommandsAndSendEvents(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<ReceiveCommandsAndSendEventsResponse,
+                               ReceiveCommandsAndSendEventsRequest>* stream) override {
+    std::thread receive_events_thread{[this, stream] {
+      ReceiveCommandsAndSendEventsRequest request;
+      while (stream->Read(&request)) {
+        num_events_ += request.buffered_capture_events().capture_events_size();
+        if (request.has_all_events_sent()) all_events_sent_ = true;
+      }
+    }};
+
+    absl::MutexLock lock{&mutex_};
+    producer_connected_ = true;
+    while (true) {
+      mutex_.Await(absl::Condition(
+          +[](FakeProducerSideService* self) {
+            return self->pending_command_.has_value() || self->shutdown_requested_;
+          },
+          this));
+      if (shutdown_requested_) break;
+      CHECK(stream->Write(pending_command_.value()));
+      pending_command_.reset();
+    }
+
+    context->TryCancel();
+    receive_events_thread.join();
+    return grpc::Status::OK;
+  }
+
+  void WaitForProducer() {
+    absl::MutexLock lock{&mutex_};
+    FAIL_IF(!mutex_.AwaitWithTimeout(absl::Condition(&producer_connected_), absl::Seconds(10)),
+            "The producer of liborbit did not connect.");
+  }
+
+  void StartCapture(bool shared_memory_ring_buffers_supported,
+                    bool interned_api_event_names_supported,
+                    bool tsc_api_event_timestamps_supported) {
+    ReceiveCommandsAndSendEventsResponse command;
+    auto* start_capture_command = command.mutable_start_capture_command();
+    start_capture_command->set_shared_memory_ring_buffers_supported(
+        shared_memory_ring_buffers_supported);
+    start_capture_command->set_interned_api_event_names_supported(
+        interned_api_event_names_supported);
+    start_capture_command->set_tsc_api_event_timestamps_supported(
+        tsc_api_event_timestamps_supported);
+    all_events_sent_ = false;
+    SendCommand(std::move(command));
+  }
+
+  // Returns once the producer has sent all its events.
+  void StopCapture() {
+    ReceiveCommandsAndSendEventsResponse stop_command;
+    stop_command.mutable_stop_capture_command();
+    SendCommand(std::move(stop_command));
+    while (!all_events_sent_) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ReceiveCommandsAndSendEventsResponse capture_finished_command;
+    capture_finished_command.mutable_capture_finished_command();
+    SendCommand(std::move(capture_finished_command));
+  }
+
+  void Shutdown() {
+    absl::MutexLock lock{&mutex_};
+    shutdown_requested_ = true;
+  }
+
+  [[nodiscard]] uint64_t GetNumEvents() const { return num_events_; }
+
+ private:
+  void SendCommand(ReceiveCommandsAndSendEventsResponse command) {
+    absl::MutexLock lock{&mutex_};
+    mutex_.Await(absl::Condition(
+        +[](FakeProducerSideService* self) { return !self->pending_command_.has_value(); }, this));
+    pending_command_ = std::move(command);
+  }
+
+  absl::Mutex mutex_;
+  bool producer_connected_ ABSL_GUARDED_BY(mutex_) = false;
+  std::optional<ReceiveCommandsAndSendEventsResponse> pending_command_ ABSL_GUARDED_BY(mutex_);
+  bool shutdown_requested_ ABSL_GUARDED_BY(mutex_) = false;
+  std::atomic<uint64_t> num_events_ = 0;
+  std::atomic<bool> all_events_sent_ = false;
+};
+
+// Counts the events that SharedMemoryRingBufferReader reads from the ring buffers.
+class CountingProducerEventProcessor : public orbit_service::ProducerEventProcessor {
+ public:
+  void ProcessEvent(uint64_t /*producer_id*/,
+                    orbit_grpc_protos::ProducerCaptureEvent /*event*/) override {
+    num_events_ += 1;
+  }
+
+  [[nodiscard]] uint64_t GetNumEvents() const { return num_events_; }
+
+ private:
+  std::atomic<uint64_t> num_events_ = 0;
+};
+
+[[nodiscard]] double MeasureNsPerScope() {
+  uint64_t duration_ns = 0;
+  for (uint64_t batch = 0; batch < kNumBatches; ++batch) {
+    const uint64_t start_ns = orbit_base::CaptureTimestampNs();
+    for (uint64_t i = 0; i < kScopesPerBatch; ++i) {
+      ORBIT_SCOPE("BenchmarkedScope");
+    }
+    duration_ns += orbit_base::CaptureTimestampNs() - start_ns;
+    std::this_thread::sleep_for(kPauseBetweenBatches);
+  }
+  return static_cast<double>(duration_ns) / (kNumBatches * kScopesPerBatch);
+}
+
+struct Configuration {
+  const char* name;
+  bool shared_memory_ring_buffers_supported;
+  bool interned_api_event_names_supported;
+  bool tsc_api_event_timestamps_supported;
+};
+
+}  // namespace
+
+int main() {
+  FakeProducerSideService producer_side_service;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(
+      absl::StrFormat("unix:%s", orbit_producer_side_channel::kProducerSideUnixDomainSocketPath),
+      grpc::InsecureServerCredentials());
+  builder.RegisterService(&producer_side_service);
+  std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+  FAIL_IF(server == nullptr, "Unable to listen on \"%s\". Is OrbitService running?",
+          orbit_producer_side_channel::kProducerSideUnixDomainSocketPath);
+
+  // The first call into liborbit creates its producer, which then connects.
+  {
+    ORBIT_SCOPE("Connect");
+  }
+  producer_side_service.WaitForProducer();
+  const double not_capturing_ns = MeasureNsPerScope();
+
+  const std::vector<Configuration> configurations{
+      {"gRPC", false, false, false},
+      {"gRPC, interned names", false, true, false},
+      {"ring buffers", true, false, false},
+      {"ring buffers, interned names", true, true, false},
+      {"ring buffers, interned names, TSC", true, true, true},
+  };
+  std::vector<double> capturing_ns;
+  std::vector<uint64_t> num_events;
+  for (const Configuration& configuration : configurations) {
+    CountingProducerEventProcessor producer_event_processor;
+    orbit_service::SharedMemoryRingBufferReader ring_buffer_reader;
+    ring_buffer_reader.Start(&producer_event_processor);
+    const uint64_t num_grpc_events_before = producer_side_service.GetNumEvents();
+    producer_side_service.StartCapture(configuration.shared_memory_ring_buffers_supported,
+                                       configuration.interned_api_event_names_supported,
+                                       configuration.tsc_api_event_timestamps_supported);
+
+    // There is no notification for when the producer has received the command.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    capturing_ns.push_back(MeasureNsPerScope());
+
+    producer_side_service.StopCapture();
+    ring_buffer_reader.Stop();
+    num_events.push_back(producer_side_service.GetNumEvents() - num_grpc_events_before +
+                         producer_event_processor.GetNumEvents());
+  }
+
+  producer_side_service.Shutdown();
+  server->Shutdown();
+
+  LOG("Overhead per ORBIT_SCOPE (%u scopes, %u events expected per capture):",
+      kNumBatches * kScopesPerBatch, 2 * kNumBatches * kScopesPerBatch);
+  LOG("  %-36s %8.1f ns", "not capturing:", not_capturing_ns);
+  for (size_t i = 0; i < configurations.size(); ++i) {
+    LOG("  %-36s %8.1f ns (%u events received)", absl::StrFormat("%s:", configurations[i].name),
+        capturing_ns[i], num_events[i]);
+  }
+  return 0;
+}
@@ -27,8 +27,10 @@
 
 namespace orbit_service {
 
+using orbit_grpc_protos::CaptureOptions;
 using orbit_grpc_protos::CaptureRequest;
 using orbit_grpc_protos::CaptureResponse;
+using orbit_grpc_protos::InstrumentedFunction;
 
 namespace {
 
@@ -159,6 +161,19 @@ class GrpcCaptureEventSender final : public CaptureEventSender {
   uint64_t total_number_of_bytes_sent_ = 0;
 };
 
+// Removes the functions with ids in `function_ids` from the instrumented functions in
+// `capture_options`.
+void RemoveInstrumentedFunctions(const absl::flat_hash_set<uint64_t>& function_ids,
+                                 CaptureOptions* capture_options) {
+  auto* instrumented_functions = capture_options->mutable_instrumented_functions();
+  instrumented_functions->erase(
+      std::remove_if(instrumented_functions->begin(), instrumented_functions->end(),
+                     [&function_ids](const InstrumentedFunction& function) {
+                       return function_ids.contains(function.function_id());
+                     }),
+      instrumented_functions->end());
+}
+
 }  // namespace
 
 // LinuxTracingHandler::Stop is blocking, until all perf_event_open events have been processed
@@ -215,7 +230,27 @@ grpc::Status CaptureServiceImpl::Capture(
   reader_writer->Read(&request);
   LOG("Read CaptureRequest from Capture's gRPC stream: starting capture");
 
-  tracing_handler.Start(request.capture_options());
+  // Functions instrumented in user space are not instrumented with uprobes. All remaining functions
+  // still are.
+  CaptureOptions linux_tracing_capture_options = request.capture_options();
+  const bool use_user_space_instrumentation =
+      request.capture_options().dynamic_instrumentation_method() ==
+      CaptureOptions::kUserSpaceInstrumentation;
+  if (use_user_space_instrumentation) {
+    auto instrumented_function_ids =
+        instrumentation_manager_->InstrumentProcess(request.capture_options());
+    if (instrumented_function_ids.has_error()) {
+      ERROR("Unable to instrument functions in user space, falling back to uprobes: %s",
+            instrumented_function_ids.error().message());
+    } else {
+      LOG("Instrumented %u of %u functions in user space", instrumented_function_ids.value().size(),
+          request.capture_options().instrumented_functions_size());
+      RemoveInstrumentedFunctions(instrumented_function_ids.value(),
+                                  &linux_tracing_capture_options);
+    }
+  }
+
+  tracing_handler.Start(linux_tracing_capture_options);
   memory_info_handler.Start(request.capture_options());
   for (CaptureStartStopListener* listener : capture_start_stop_listeners_) {
     listener->OnCaptureStartRequested(request.capture_options(), producer_event_processor.get());
@@ -228,6 +263,15 @@ grpc::Status CaptureServiceImpl::Capture(
   }
   LOG("Client finished writing on Capture's gRPC stream: stopping capture");
 
+  if (use_user_space_instrumentation) {
+    auto uninstrument_result =
+        instrumentation_manager_->UninstrumentProcess(linux_tracing_capture_options.pid());
+    if (uninstrument_result.has_error()) {
+      ERROR("Unable to remove user space instrumentation: %s",
+            uninstrument_result.error().message());
+    }
+  }
+
   StopInternalProducersAndCaptureStartStopListenersInParallel(
       &tracing_handler, &memory_info_handler, &capture_start_stop_listeners_);
 
@@ -8,8 +8,10 @@
 #include <grpcpp/grpcpp.h>
 
 #include <atomic>
+#include <memory>
 
 #include "CaptureStartStopListener.h"
+#include "UserSpaceInstrumentation/InstrumentationManager.h"
 #include "absl/container/flat_hash_set.h"
 #include "services.grpc.pb.h"
 #include "services.pb.h"
@@ -29,6 +31,10 @@ class CaptureServiceImpl final : public orbit_grpc_protos::CaptureService::Servi
  private:
   std::atomic<bool> is_capturing = false;
   absl::flat_hash_set<CaptureStartStopListener*> capture_start_stop_listeners_;
+  // Outlives single captures, as the instrumentation is reused in subsequent captures.
+  std::unique_ptr<orbit_user_space_instrumentation::InstrumentationManager>
+      instrumentation_manager_ =
+          orbit_user_space_instrumentation::InstrumentationManager::Create();
 };
 
 }  // namespace orbit_service
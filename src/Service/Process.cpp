@@ -14,7 +14,7 @@
 #include <string>
 #include <utility>
 
-#include "ElfUtils/ElfFile.h"
+#include "ElfUtils/ElfMetadata.h"
 #include "OrbitBase/ExecutablePath.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ReadFileToString.h"
@@ -46,6 +46,11 @@ void Process::UpdateCpuUsage(utils::Jiffies process_cpu_time, utils::TotalCpuTim
 }
 
 ErrorMessageOr<Process> Process::FromPid(pid_t pid) {
+  return FromPid(pid, utils::GetCumulativeTotalCpuTime());
+}
+
+ErrorMessageOr<Process> Process::FromPid(
+    pid_t pid, const std::optional<utils::TotalCpuTime>& total_cpu_time) {
   const auto path = std::filesystem::path{"/proc"} / std::to_string(pid);
 
   if (!std::filesystem::is_directory(path)) {
@@ -70,7 +75,6 @@ ErrorMessageOr<Process> Process::FromPid(pid_t pid) {
   process.set_pid(pid);
   process.set_name(name);
 
-  const auto total_cpu_time = utils::GetCumulativeTotalCpuTime();
   const auto cpu_time = utils::GetCumulativeCpuTimeFromProcess(process.pid());
   if (cpu_time && total_cpu_time) {
     process.UpdateCpuUsage(cpu_time.value(), total_cpu_time.value());
@@ -95,9 +99,11 @@ ErrorMessageOr<Process> Process::FromPid(pid_t pid) {
   if (!file_path_result.has_error()) {
     process.set_full_path(file_path_result.value());
 
-    const auto& elf_file = orbit_elf_utils::ElfFile::Create(file_path_result.value());
-    if (!elf_file.has_error()) {
-      process.set_is_64_bit(elf_file.value()->Is64Bit());
+    // Only the headers are read. Mapping the whole executable would dominate the cost of
+    // creating a process entry.
+    const auto elf_metadata = orbit_elf_utils::ReadElfMetadata(file_path_result.value());
+    if (!elf_metadata.has_error()) {
+      process.set_is_64_bit(elf_metadata.value().is_64_bit);
     } else {
       LOG("Warning: Unable to parse the executable \"%s\" as elf file. (pid: %d)",
           file_path_result.value(), pid);
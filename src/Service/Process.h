@@ -7,6 +7,8 @@
 
 #include <sys/types.h>
 
+#include <optional>
+
 #include "OrbitBase/Result.h"
 #include "ServiceUtils.h"
 #include "process.pb.h"
@@ -22,6 +24,10 @@ class Process : public orbit_grpc_protos::ProcessInfo {
   // Creates a `Process` by reading details from the `/proc` filesystem.
   // This might fail due to a non existing pid or due to permission problems.
   static ErrorMessageOr<Process> FromPid(pid_t pid);
+  // Same as above, but uses `total_cpu_time` for the initial CPU usage instead of reading
+  // /proc/stat again. Used when creating many processes at once.
+  static ErrorMessageOr<Process> FromPid(pid_t pid,
+                                         const std::optional<utils::TotalCpuTime>& total_cpu_time);
 
  private:
   utils::Jiffies previous_process_cpu_time_ = {};
@@ -19,6 +19,10 @@ namespace orbit_service {
 
 ErrorMessageOr<void> ProcessList::Refresh() {
   absl::flat_hash_map<pid_t, Process> updated_processes{};
+  updated_processes.reserve(processes_.size());
+
+  // The total CPU time is the same for all processes, so /proc/stat is only read once per refresh.
+  const auto total_cpu_time = utils::GetCumulativeTotalCpuTime();
 
   // TODO(b/161423785): This for loop should be refactored. For example, when
   //  parts are in a separate function, OUTCOME_TRY could be used to simplify
@@ -35,6 +39,13 @@ ErrorMessageOr<void> ProcessList::Refresh() {
           absl::StrFormat("Unable to iterate /proc directory: %s", error.message()));
     }
 
+    // Most entries of /proc are processes, so the name is checked before the type of the entry.
+    const std::filesystem::path& path = it->path();
+    std::string folder_name = path.filename().string();
+
+    int32_t pid;
+    if (!absl::SimpleAtoi(folder_name, &pid)) continue;
+
     bool is_directory = it->is_directory(error);
     if (error) {
       ERROR("Unable to stat \"%s\" directory entry: %s", it->path(), error.message());
@@ -43,18 +54,13 @@ ErrorMessageOr<void> ProcessList::Refresh() {
 
     if (!is_directory) continue;
 
-    const std::filesystem::path& path = it->path();
-    std::string folder_name = path.filename().string();
-
-    int32_t pid;
-    if (!absl::SimpleAtoi(folder_name, &pid)) continue;
-
     const auto iter = processes_.find(pid);
 
+    // Known processes only need their CPU usage updated. The name, command line and executable
+    // are only read for processes that were not seen in the previous refresh.
     if (iter != processes_.end()) {
       auto process = processes_.extract(iter);
 
-      const auto total_cpu_time = utils::GetCumulativeTotalCpuTime();
       const auto cpu_time = utils::GetCumulativeCpuTimeFromProcess(process.key());
       if (cpu_time && total_cpu_time) {
         process.mapped().UpdateCpuUsage(cpu_time.value(), total_cpu_time.value());
@@ -68,7 +74,7 @@ ErrorMessageOr<void> ProcessList::Refresh() {
       continue;
     }
 
-    auto process_or_error = Process::FromPid(pid);
+    auto process_or_error = Process::FromPid(pid, total_cpu_time);
 
     if (process_or_error.has_error()) {
       // We don't fail in this case. This could be a permission problem which is restricted to a
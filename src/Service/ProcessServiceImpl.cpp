@@ -39,6 +39,7 @@ using orbit_grpc_protos::ProcessInfo;
 
 Status ProcessServiceImpl::GetProcessList(ServerContext*, const GetProcessListRequest*,
                                           GetProcessListResponse* response) {
+  std::vector<ProcessInfo> processes;
   {
     absl::MutexLock lock(&mutex_);
 
@@ -46,15 +47,16 @@ Status ProcessServiceImpl::GetProcessList(ServerContext*, const GetProcessListRe
     if (refresh_result.has_error()) {
       return Status(StatusCode::INTERNAL, refresh_result.error().message());
     }
+    processes = process_list_.GetProcesses();
   }
 
-  const std::vector<ProcessInfo>& processes = process_list_.GetProcesses();
   if (processes.empty()) {
     return Status(StatusCode::NOT_FOUND, "Error while getting processes.");
   }
 
-  for (const auto& process_info : process_list_.GetProcesses()) {
-    *(response->add_processes()) = process_info;
+  response->mutable_processes()->Reserve(processes.size());
+  for (ProcessInfo& process_info : processes) {
+    *(response->add_processes()) = std::move(process_info);
   }
 
   return Status::OK;
@@ -6,7 +6,14 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <tuple>
+
+#include "Api/EncodedEvent.h"
 #include "OrbitBase/Logging.h"
+#include "TscConverter.h"
 #include "capture.pb.h"
 
 namespace orbit_service {
@@ -68,7 +75,11 @@ class ProducerEventProcessorImpl : public ProducerEventProcessor {
  public:
   ProducerEventProcessorImpl() = delete;
   explicit ProducerEventProcessorImpl(CaptureEventBuffer* capture_event_buffer)
-      : capture_event_buffer_{capture_event_buffer} {}
+      : capture_event_buffer_{capture_event_buffer} {
+    // Producers only send timestamps from the time stamp counter if it is the clock source. The
+    // calibration blocks for a short time, so this is done before the first event is processed.
+    if (TscConverter::IsTscClockSource()) tsc_converter_ = std::make_unique<TscConverter>();
+  }
 
   void ProcessEvent(uint64_t producer_id, ProducerCaptureEvent event) override;
 
@@ -91,7 +102,11 @@ class ProducerEventProcessorImpl : public ProducerEventProcessor {
   void ProcessThreadStateSlice(ThreadStateSlice* thread_state_slice);
   void ProcessFullTracepointEvent(FullTracepointEvent* full_tracepoint_event);
   void ProcessSystemMemoryUsage(SystemMemoryUsage* system_memory_usage);
-  void ProcessApiEvent(ApiEvent* api_event);
+  // Remaps the interned name of an ApiEvent, if it has one, to a client string id. The names
+  // themselves are sent by the Orbit API in orbit_api::kInternString events, which are not
+  // forwarded to the client. Also converts timestamps taken from the time stamp counter.
+  void ProcessApiEvent(uint64_t producer_id, ApiEvent* api_event);
+  void ProcessApiInternString(uint64_t producer_id, const orbit_api::ApiEvent& api_event);
 
   void SendInternedStringEvent(uint64_t key, std::string value);
 
@@ -109,6 +124,14 @@ class ProducerEventProcessorImpl : public ProducerEventProcessor {
   // <producer_id, producer_string_id> -> client_string_id
   absl::flat_hash_map<std::pair<uint64_t, uint64_t>, uint64_t>
       producer_interned_string_id_to_client_string_id_;
+  // <producer_id, tid, producer_string_id> -> the part of the name received so far
+  absl::flat_hash_map<std::tuple<uint64_t, int32_t, uint64_t>, std::string> partial_api_names_;
+  // Guards the two maps above. Also held while sending the InternedString for a newly assigned
+  // client_string_id, so that events that use that id can't be sent before it.
+  absl::Mutex interned_string_mutex_;
+
+  // Null if the time stamp counter is not the clock source.
+  std::unique_ptr<TscConverter> tsc_converter_;
 };
 
 void ProducerEventProcessorImpl::ProcessFullAddressInfo(FullAddressInfo* full_address_info) {
@@ -165,6 +188,7 @@ void ProducerEventProcessorImpl::ProcessFullGpuJob(FullGpuJob* full_gpu_job_even
 void ProducerEventProcessorImpl::ProcessGpuQueueSubmission(
     uint64_t producer_id, GpuQueueSubmission* gpu_queue_submission) {
   // Translate debug marker keys
+  absl::MutexLock lock{&interned_string_mutex_};
   for (GpuDebugMarker& mutable_marker : *gpu_queue_submission->mutable_completed_markers()) {
     auto it = producer_interned_string_id_to_client_string_id_.find(
         {producer_id, mutable_marker.text_key()});
@@ -240,6 +264,7 @@ void ProducerEventProcessorImpl::ProcessCallstackSample(uint64_t producer_id,
 
 void ProducerEventProcessorImpl::ProcessInternedString(uint64_t producer_id,
                                                        InternedString* interned_string) {
+  absl::MutexLock lock{&interned_string_mutex_};
   // TODO(http://b/180235290): replace with error message
   CHECK(!producer_interned_string_id_to_client_string_id_.contains(
       {producer_id, interned_string->key()}));
@@ -320,12 +345,82 @@ void ProducerEventProcessorImpl::ProcessSystemMemoryUsage(SystemMemoryUsage* sys
   capture_event_buffer_->AddEvent(std::move(event));
 }
 
-void ProducerEventProcessorImpl::ProcessApiEvent(ApiEvent* api_event) {
+void ProducerEventProcessorImpl::ProcessApiEvent(uint64_t producer_id, ApiEvent* api_event) {
+  if ((api_event->timestamp_ns() & orbit_api::kTscTimestampBit) != 0) {
+    if (tsc_converter_ == nullptr) {
+      ERROR("Dropping ApiEvent with a timestamp from the time stamp counter: it is not supported");
+      return;
+    }
+    api_event->set_timestamp_ns(tsc_converter_->ToCaptureTimestampNs(
+        api_event->timestamp_ns() & ~orbit_api::kTscTimestampBit));
+  }
+
+  orbit_api::EncodedEvent encoded_event{api_event->r0(), api_event->r1(), api_event->r2(),
+                                        api_event->r3(), api_event->r4(), api_event->r5()};
+  if (encoded_event.Type() == orbit_api::kInternString) {
+    orbit_api::ApiEvent raw_api_event;
+    raw_api_event.pid = api_event->pid();
+    raw_api_event.tid = api_event->tid();
+    raw_api_event.timestamp_ns = api_event->timestamp_ns();
+    raw_api_event.encoded_event = encoded_event;
+    ProcessApiInternString(producer_id, raw_api_event);
+    return;
+  }
+
+  if (encoded_event.HasInternedName()) {
+    uint64_t client_string_id = 0;  // 0 is the invalid id.
+    {
+      absl::MutexLock lock{&interned_string_mutex_};
+      auto it = producer_interned_string_id_to_client_string_id_.find(
+          {producer_id, encoded_event.InternedNameKey()});
+      if (it != producer_interned_string_id_to_client_string_id_.end()) {
+        client_string_id = it->second;
+      } else {
+        ERROR("Unknown interned name %#x in ApiEvent", encoded_event.InternedNameKey());
+      }
+    }
+    encoded_event.SetInternedNameKey(client_string_id);
+    api_event->set_r0(encoded_event.args[0]);
+    api_event->set_r1(encoded_event.args[1]);
+  }
+
   ClientCaptureEvent event;
   *event.mutable_api_event() = std::move(*api_event);
   capture_event_buffer_->AddEvent(std::move(event));
 }
 
+void ProducerEventProcessorImpl::ProcessApiInternString(uint64_t producer_id,
+                                                        const orbit_api::ApiEvent& api_event) {
+  constexpr size_t kChunkSize = orbit_api::kMaxEventStringSize - 1;
+  const orbit_api::Event& event = api_event.encoded_event.event;
+  const uint64_t producer_string_id = event.data;
+  const auto offset = static_cast<uint32_t>(event.color);
+  const std::string_view chunk{event.name, strnlen(event.name, kChunkSize)};
+
+  absl::MutexLock lock{&interned_string_mutex_};
+  std::string& name = partial_api_names_[{producer_id, api_event.tid, producer_string_id}];
+  // A producer restarts from the beginning if it failed to send some of the chunks.
+  if (offset == 0) name.clear();
+  if (offset != name.size()) {
+    ERROR("Unexpected chunk of interned name %#x", producer_string_id);
+    partial_api_names_.erase({producer_id, api_event.tid, producer_string_id});
+    return;
+  }
+  name.append(chunk);
+  if (chunk.size() == kChunkSize) return;
+
+  // Producers share the key of a name between threads and, with shared memory ring buffers,
+  // between processes, so the same name can be received more than once.
+  if (!producer_interned_string_id_to_client_string_id_.contains(
+          {producer_id, producer_string_id})) {
+    auto [client_string_id, assigned] = string_pool_.GetOrAssignId(name);
+    producer_interned_string_id_to_client_string_id_.emplace(
+        std::make_pair(producer_id, producer_string_id), client_string_id);
+    if (assigned) SendInternedStringEvent(client_string_id, name);
+  }
+  partial_api_names_.erase({producer_id, api_event.tid, producer_string_id});
+}
+
 void ProducerEventProcessorImpl::ProcessEvent(uint64_t producer_id, ProducerCaptureEvent event) {
   switch (event.event_case()) {
     case ProducerCaptureEvent::kInternedCallstack:
@@ -374,7 +469,7 @@ void ProducerEventProcessorImpl::ProcessEvent(uint64_t producer_id, ProducerCapt
       ProcessSystemMemoryUsage(event.mutable_system_memory_usage());
       break;
     case ProducerCaptureEvent::kApiEvent:
-      ProcessApiEvent(event.mutable_api_event());
+      ProcessApiEvent(producer_id, event.mutable_api_event());
       break;
     case ProducerCaptureEvent::EVENT_NOT_SET:
       UNREACHABLE();
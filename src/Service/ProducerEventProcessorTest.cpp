@@ -7,7 +7,13 @@
 #include <gtest/gtest.h>
 #include <stdint.h>
 
+#include <string>
+#include <vector>
+
+#include "Api/EncodedEvent.h"
+#include "OrbitBase/Profiling.h"
 #include "ProducerEventProcessor.h"
+#include "TscConverter.h"
 #include "capture.pb.h"
 
 namespace orbit_service {
@@ -1289,4 +1295,116 @@ TEST(ProducerEventProcessor, TwoInternedCallstacksSameProducerSameKey) {
   EXPECT_DEATH(producer_event_processor->ProcessEvent(1, event2), "");
 }
 
-}  // namespace orbit_service
\ No newline at end of file
+static ProducerCaptureEvent CreateApiEvent(const orbit_api::ApiEvent& raw_api_event) {
+  ProducerCaptureEvent event;
+  orbit_grpc_protos::ApiEvent* api_event = event.mutable_api_event();
+  api_event->set_pid(raw_api_event.pid);
+  api_event->set_tid(raw_api_event.tid);
+  api_event->set_timestamp_ns(raw_api_event.timestamp_ns);
+  api_event->set_r0(raw_api_event.encoded_event.args[0]);
+  api_event->set_r1(raw_api_event.encoded_event.args[1]);
+  api_event->set_r2(raw_api_event.encoded_event.args[2]);
+  api_event->set_r3(raw_api_event.encoded_event.args[3]);
+  api_event->set_r4(raw_api_event.encoded_event.args[4]);
+  api_event->set_r5(raw_api_event.encoded_event.args[5]);
+  return event;
+}
+
+static orbit_api::EncodedEvent GetEncodedEvent(const orbit_grpc_protos::ApiEvent& api_event) {
+  return orbit_api::EncodedEvent{api_event.r0(), api_event.r1(), api_event.r2(),
+                                 api_event.r3(), api_event.r4(), api_event.r5()};
+}
+
+static std::vector<ProducerCaptureEvent> CreateApiInternStringEvents(int32_t tid, uint64_t key,
+                                                                     const std::string& name) {
+  constexpr size_t kChunkSize = orbit_api::kMaxEventStringSize - 1;
+  std::vector<ProducerCaptureEvent> events;
+  for (size_t offset = 0; offset <= name.size(); offset += kChunkSize) {
+    events.push_back(CreateApiEvent(orbit_api::ApiEvent{
+        kPid1, tid, kTimestampNs1, orbit_api::kInternString, name.c_str() + offset, key,
+        static_cast<orbit_api_color>(offset)}));
+  }
+  return events;
+}
+
+TEST(ProducerEventProcessor, ApiEventWithInternedName) {
+  MockCaptureEventBuffer buffer;
+  auto producer_event_processor = ProducerEventProcessor::Create(&buffer);
+
+  // Longer than kMaxEventStringSize, so that it is sent in two chunks.
+  const std::string name = "A scope name that doesn't fit into an orbit_api::Event";
+  std::vector<ProducerCaptureEvent> intern_events =
+      CreateApiInternStringEvents(kTid1, kKey1, name);
+  ASSERT_EQ(intern_events.size(), 2);
+
+  ClientCaptureEvent interned_string_event;
+  EXPECT_CALL(buffer, AddEvent).Times(1).WillOnce(SaveArg<0>(&interned_string_event));
+  for (const ProducerCaptureEvent& event : intern_events) {
+    producer_event_processor->ProcessEvent(kDefaultProducerId, event);
+  }
+  ASSERT_EQ(interned_string_event.event_case(), ClientCaptureEvent::kInternedString);
+  const uint64_t client_key = interned_string_event.interned_string().key();
+  EXPECT_NE(client_key, orbit_grpc_protos::kInvalidInternId);
+  EXPECT_EQ(interned_string_event.interned_string().intern(), name);
+
+  // Another thread sending the same name doesn't cause a second InternedString.
+  EXPECT_CALL(buffer, AddEvent).Times(0);
+  for (const ProducerCaptureEvent& event : CreateApiInternStringEvents(kTid2, kKey1, name)) {
+    producer_event_processor->ProcessEvent(kDefaultProducerId, event);
+  }
+
+  orbit_api::ApiEvent scope_start{kPid1, kTid2, kTimestampNs2, orbit_api::kScopeStart,
+                                  /*name=*/nullptr, /*data=*/0, kOrbitColorRed};
+  scope_start.encoded_event.SetInternedNameKey(kKey1);
+  ClientCaptureEvent client_api_event;
+  EXPECT_CALL(buffer, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_api_event));
+  producer_event_processor->ProcessEvent(kDefaultProducerId, CreateApiEvent(scope_start));
+
+  ASSERT_EQ(client_api_event.event_case(), ClientCaptureEvent::kApiEvent);
+  EXPECT_EQ(client_api_event.api_event().tid(), kTid2);
+  EXPECT_EQ(client_api_event.api_event().timestamp_ns(), kTimestampNs2);
+  orbit_api::EncodedEvent encoded_event = GetEncodedEvent(client_api_event.api_event());
+  EXPECT_EQ(encoded_event.Type(), orbit_api::kScopeStart);
+  EXPECT_EQ(encoded_event.event.color, kOrbitColorRed);
+  ASSERT_TRUE(encoded_event.HasInternedName());
+  EXPECT_EQ(encoded_event.InternedNameKey(), client_key);
+}
+
+TEST(ProducerEventProcessor, ApiEventWithUnknownInternedName) {
+  MockCaptureEventBuffer buffer;
+  auto producer_event_processor = ProducerEventProcessor::Create(&buffer);
+
+  orbit_api::ApiEvent track_int{kPid1, kTid1, kTimestampNs1, orbit_api::kTrackInt};
+  track_int.encoded_event.SetInternedNameKey(kKey1);
+  ClientCaptureEvent client_api_event;
+  EXPECT_CALL(buffer, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_api_event));
+  producer_event_processor->ProcessEvent(kDefaultProducerId, CreateApiEvent(track_int));
+
+  ASSERT_EQ(client_api_event.event_case(), ClientCaptureEvent::kApiEvent);
+  orbit_api::EncodedEvent encoded_event = GetEncodedEvent(client_api_event.api_event());
+  ASSERT_TRUE(encoded_event.HasInternedName());
+  EXPECT_EQ(encoded_event.InternedNameKey(), orbit_grpc_protos::kInvalidInternId);
+}
+
+TEST(ProducerEventProcessor, ApiEventWithTscTimestamp) {
+  if (!TscConverter::IsTscClockSource()) {
+    GTEST_SKIP() << "The time stamp counter is not the clock source of the kernel";
+  }
+  MockCaptureEventBuffer buffer;
+  auto producer_event_processor = ProducerEventProcessor::Create(&buffer);
+
+  const uint64_t before_ns = orbit_base::CaptureTimestampNs();
+  orbit_api::ApiEvent scope_stop{kPid1, kTid1, orbit_base::ReadTsc() | orbit_api::kTscTimestampBit,
+                                 orbit_api::kScopeStop};
+  const uint64_t after_ns = orbit_base::CaptureTimestampNs();
+  ClientCaptureEvent client_api_event;
+  EXPECT_CALL(buffer, AddEvent).Times(1).WillOnce(SaveArg<0>(&client_api_event));
+  producer_event_processor->ProcessEvent(kDefaultProducerId, CreateApiEvent(scope_stop));
+
+  ASSERT_EQ(client_api_event.event_case(), ClientCaptureEvent::kApiEvent);
+  constexpr uint64_t kToleranceNs = 10'000;
+  EXPECT_GE(client_api_event.api_event().timestamp_ns(), before_ns - kToleranceNs);
+  EXPECT_LE(client_api_event.api_event().timestamp_ns(), after_ns + kToleranceNs);
+}
+
+}  // namespace orbit_service
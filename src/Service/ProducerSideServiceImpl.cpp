@@ -12,6 +12,7 @@
 
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ThreadUtils.h"
+#include "TscConverter.h"
 #include "capture.pb.h"
 
 namespace orbit_service {
@@ -27,6 +28,13 @@ void ProducerSideServiceImpl::OnCaptureStartRequested(
     absl::WriterMutexLock lock{&producer_event_processor_mutex_};
     producer_event_processor_ = producer_event_processor;
   }
+  {
+    absl::MutexLock lock{&shared_memory_ring_buffer_reader_mutex_};
+    if (shared_memory_ring_buffer_reader_.IsRunning()) {
+      shared_memory_ring_buffer_reader_.Stop();
+    }
+    shared_memory_ring_buffer_reader_.Start(producer_event_processor, capture_options.pid());
+  }
   {
     absl::MutexLock lock{&service_state_mutex_};
     service_state_.capture_status = CaptureStatus::kCaptureStarted;
@@ -62,6 +70,15 @@ void ProducerSideServiceImpl::OnCaptureStopRequested() {
     service_state_.producers_remaining = 0;
   }
 
+  {
+    // Producers have waited for their shared memory ring buffers to be read before sending
+    // AllEventsSent, so stopping the reader now doesn't lose events.
+    absl::MutexLock lock{&shared_memory_ring_buffer_reader_mutex_};
+    if (shared_memory_ring_buffer_reader_.IsRunning()) {
+      shared_memory_ring_buffer_reader_.Stop();
+    }
+  }
+
   {
     absl::WriterMutexLock lock{&producer_event_processor_mutex_};
     producer_event_processor_ = nullptr;
@@ -84,6 +101,13 @@ void ProducerSideServiceImpl::OnExitRequest() {
     }
   }
 
+  {
+    absl::MutexLock lock{&shared_memory_ring_buffer_reader_mutex_};
+    if (shared_memory_ring_buffer_reader_.IsRunning()) {
+      shared_memory_ring_buffer_reader_.Stop();
+    }
+  }
+
   {
     absl::WriterMutexLock lock{&producer_event_processor_mutex_};
     producer_event_processor_ = nullptr;
@@ -148,6 +172,12 @@ static bool SendStartCaptureCommand(
     orbit_grpc_protos::CaptureOptions capture_options) {
   orbit_grpc_protos::ReceiveCommandsAndSendEventsResponse command;
   *command.mutable_start_capture_command()->mutable_capture_options() = std::move(capture_options);
+  command.mutable_start_capture_command()->set_shared_memory_ring_buffers_supported(true);
+  command.mutable_start_capture_command()->set_interned_api_event_names_supported(true);
+  // Producers can only use the time stamp counter if it is synchronized across CPUs.
+  static const bool tsc_is_clock_source = TscConverter::IsTscClockSource();
+  command.mutable_start_capture_command()->set_tsc_api_event_timestamps_supported(
+      tsc_is_clock_source);
   if (!stream->Write(command)) {
     ERROR("Sending StartCaptureCommand to CaptureEventProducer");
     LOG("Terminating call to ReceiveCommandsAndSendEvents as Write failed");
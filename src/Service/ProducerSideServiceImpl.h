@@ -16,6 +16,7 @@
 #include "CaptureStartStopListener.h"
 #include "GrpcProtos/Constants.h"
 #include "ProducerEventProcessor.h"
+#include "SharedMemoryRingBufferReader.h"
 #include "capture.pb.h"
 #include "producer_side_services.grpc.pb.h"
 #include "producer_side_services.pb.h"
@@ -30,6 +31,9 @@ namespace orbit_service {
 // As OnCaptureStopRequested waits for the remaining CaptureEvents, SetMaxWaitForAllCaptureEventsMs
 // allows to specify a timeout for that method.
 // OnExitRequest disconnects all producers, preparing this service for shutdown.
+// During a capture, it also reads the events that producers of the target process write into shared
+// memory ring buffers (see SharedMemoryRingBufferReader), which producers are told about in the
+// StartCaptureCommand.
 class ProducerSideServiceImpl final : public orbit_grpc_protos::ProducerSideService::Service,
                                       public CaptureStartStopListener {
  public:
@@ -91,6 +95,9 @@ class ProducerSideServiceImpl final : public orbit_grpc_protos::ProducerSideServ
   ProducerEventProcessor* producer_event_processor_ = nullptr;
   absl::Mutex producer_event_processor_mutex_;
 
+  SharedMemoryRingBufferReader shared_memory_ring_buffer_reader_;
+  absl::Mutex shared_memory_ring_buffer_reader_mutex_;
+
   std::atomic<uint64_t> producer_id_counter_ = orbit_grpc_protos::kExternalProducerStartingId;
 
   uint64_t max_wait_for_all_events_sent_ms_ = 10'000;
@@ -0,0 +1,208 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SharedMemoryRingBufferReader.h"
+
+#include <absl/strings/match.h>
+#include <absl/strings/str_format.h>
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "Api/EncodedEvent.h"
+#include "GrpcProtos/Constants.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ThreadUtils.h"
+#include "capture.pb.h"
+
+namespace orbit_service {
+
+using orbit_grpc_protos::ProducerCaptureEvent;
+using orbit_producer_side_channel::kSharedMemoryRingBufferNamePrefix;
+using orbit_producer_side_channel::SharedMemoryRecordType;
+using orbit_producer_side_channel::SharedMemoryRingBuffer;
+
+namespace {
+
+constexpr std::chrono::milliseconds kReadInterval{1};
+constexpr std::chrono::milliseconds kUpdateRingBuffersInterval{100};
+constexpr uint64_t kMaxRecordsPerRead = 1024;
+
+[[nodiscard]] ProducerCaptureEvent CreateApiEvent(const orbit_api::ApiEvent& raw_api_event) {
+  ProducerCaptureEvent capture_event;
+  auto* api_event = capture_event.mutable_api_event();
+  api_event->set_timestamp_ns(raw_api_event.timestamp_ns);
+  api_event->set_pid(raw_api_event.pid);
+  api_event->set_tid(raw_api_event.tid);
+  api_event->set_r0(raw_api_event.encoded_event.args[0]);
+  api_event->set_r1(raw_api_event.encoded_event.args[1]);
+  api_event->set_r2(raw_api_event.encoded_event.args[2]);
+  api_event->set_r3(raw_api_event.encoded_event.args[3]);
+  api_event->set_r4(raw_api_event.encoded_event.args[4]);
+  api_event->set_r5(raw_api_event.encoded_event.args[5]);
+  return capture_event;
+}
+
+// Returns whether the file descriptor `fd_path` in /proc/<pid>/fd refers to a memfd created for a
+// ring buffer.
+[[nodiscard]] bool IsRingBufferMemfd(const std::filesystem::path& fd_path) {
+  std::error_code error;
+  const std::string target = std::filesystem::read_symlink(fd_path, error).string();
+  return !error &&
+         absl::StartsWith(target, absl::StrFormat("/memfd:%s", kSharedMemoryRingBufferNamePrefix));
+}
+
+}  // namespace
+
+SharedMemoryRingBufferReader::~SharedMemoryRingBufferReader() {
+  if (IsRunning()) Stop();
+}
+
+void SharedMemoryRingBufferReader::Start(ProducerEventProcessor* producer_event_processor,
+                                         pid_t pid) {
+  CHECK(producer_event_processor != nullptr);
+  CHECK(!IsRunning());
+  producer_event_processor_ = producer_event_processor;
+  pid_ = pid;
+  stop_requested_ = false;
+
+  // Producers can write after `Stop` drained their ring buffers, or before any capture. Those
+  // records don't belong to this capture: map the ring buffers anew and skip what they hold, before
+  // the producers are told that the capture started. Inodes ignored before can have been reused.
+  ring_buffers_.clear();
+  ignored_inodes_.clear();
+  UpdateRingBuffers();
+  ReadRingBuffers(/*discard_records=*/true);
+
+  thread_ = std::thread{&SharedMemoryRingBufferReader::ReaderThread, this};
+}
+
+void SharedMemoryRingBufferReader::Stop() {
+  CHECK(IsRunning());
+  stop_requested_ = true;
+  thread_.join();
+  producer_event_processor_ = nullptr;
+}
+
+void SharedMemoryRingBufferReader::ReaderThread() {
+  orbit_base::SetCurrentThreadName("SMRBReader");
+
+  auto last_update = std::chrono::steady_clock::now() - kUpdateRingBuffersInterval;
+  while (!stop_requested_) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_update >= kUpdateRingBuffersInterval) {
+      UpdateRingBuffers();
+      last_update = now;
+    }
+    ReadRingBuffers();
+    std::this_thread::sleep_for(kReadInterval);
+  }
+
+  // Producers wait for their ring buffers to be read before they notify that they have sent all
+  // their events, so at this point there should only be few events left.
+  UpdateRingBuffers();
+  ReadRingBuffers();
+}
+
+void SharedMemoryRingBufferReader::UpdateRingBuffers() {
+  // The ring buffers of the target process are found among its file descriptors. Stat-ing the
+  // process also tells whether it still exists, and which user it belongs to.
+  const std::string process_path = absl::StrFormat("/proc/%d", pid_);
+  struct stat process_stat {};
+  const bool process_exists = stat(process_path.c_str(), &process_stat) == 0;
+
+  // Drop the ring buffers of exited threads, or of the exited process, once they have been read.
+  // Whether the writes have ended needs to be checked before whether the ring buffer is empty, as
+  // records written in between would be lost otherwise.
+  for (auto it = ring_buffers_.begin(); it != ring_buffers_.end();) {
+    SharedMemoryRingBuffer* ring_buffer = it->second.get();
+    const bool is_closed = ring_buffer->IsClosed();
+    if ((is_closed || !process_exists) && ring_buffer->IsEmpty()) {
+      // The producer keeps the memfd of a closed ring buffer open for a while. Don't map it again.
+      if (is_closed) ignored_inodes_.insert(it->first);
+      ring_buffers_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  if (!process_exists) return;
+
+  std::error_code error;
+  std::filesystem::directory_iterator directory_iterator{process_path + "/fd", error};
+  if (error) {
+    ERROR("Listing the file descriptors of process %d: %s", pid_, error.message());
+    return;
+  }
+  for (const std::filesystem::directory_entry& entry : directory_iterator) {
+    if (!IsRingBufferMemfd(entry.path())) continue;
+    struct stat file_stat {};
+    if (stat(entry.path().c_str(), &file_stat) != 0 || ring_buffers_.contains(file_stat.st_ino) ||
+        ignored_inodes_.contains(file_stat.st_ino)) {
+      continue;
+    }
+    // Memfds can be passed between processes: only read the ones of the user of the target process.
+    if (file_stat.st_uid != process_stat.st_uid) {
+      ERROR("Ignoring \"%s\" as it belongs to a different user", entry.path().string());
+      ignored_inodes_.insert(file_stat.st_ino);
+      continue;
+    }
+    // This fails if the producer has only created the memfd but not initialized it yet. Try again
+    // on the next update in that case.
+    ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> ring_buffer =
+        SharedMemoryRingBuffer::Open(entry.path());
+    if (ring_buffer.has_error()) continue;
+    if (ring_buffer.value()->pid() != pid_) {
+      ERROR("Ignoring \"%s\" as it was created by process %d", entry.path().string(),
+            ring_buffer.value()->pid());
+      ignored_inodes_.insert(file_stat.st_ino);
+      continue;
+    }
+    LOG("Reading events from shared memory ring buffer \"%s\"", entry.path().string());
+    ring_buffers_.emplace(file_stat.st_ino, std::move(ring_buffer.value()));
+  }
+}
+
+void SharedMemoryRingBufferReader::ReadRingBuffers(bool discard_records) {
+  for (auto it = ring_buffers_.begin(); it != ring_buffers_.end();) {
+    if (ReadRingBuffer(it->second.get(), discard_records)) {
+      ++it;
+    } else {
+      ignored_inodes_.insert(it->first);
+      ring_buffers_.erase(it++);
+    }
+  }
+}
+
+bool SharedMemoryRingBufferReader::ReadRingBuffer(SharedMemoryRingBuffer* ring_buffer,
+                                                  bool discard_records) {
+  if (ring_buffer->record_type() != SharedMemoryRecordType::kApiEvent ||
+      ring_buffer->record_size() != sizeof(orbit_api::ApiEvent)) {
+    ERROR("Unsupported records in \"%s\"", ring_buffer->path().string());
+    return false;
+  }
+
+  records_.resize(kMaxRecordsPerRead * ring_buffer->record_size());
+  while (true) {
+    ErrorMessageOr<uint64_t> num_records = ring_buffer->Read(records_.data(), kMaxRecordsPerRead);
+    if (num_records.has_error()) {
+      ERROR("Reading shared memory ring buffer: %s", num_records.error().message());
+      return false;
+    }
+    for (uint64_t i = 0; !discard_records && i < num_records.value(); ++i) {
+      orbit_api::ApiEvent api_event;
+      std::memcpy(&api_event, records_.data() + i * sizeof(orbit_api::ApiEvent),
+                  sizeof(orbit_api::ApiEvent));
+      producer_event_processor_->ProcessEvent(orbit_grpc_protos::kSharedMemoryProducerId,
+                                              CreateApiEvent(api_event));
+    }
+    if (num_records.value() < kMaxRecordsPerRead) return true;
+  }
+}
+
+}  // namespace orbit_service
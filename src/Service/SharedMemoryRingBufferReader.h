@@ -0,0 +1,71 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_SERVICE_SHARED_MEMORY_RING_BUFFER_READER_H_
+#define ORBIT_SERVICE_SHARED_MEMORY_RING_BUFFER_READER_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ProducerEventProcessor.h"
+#include "ProducerSideChannel/SharedMemoryRingBuffer.h"
+
+namespace orbit_service {
+
+// Reads the events that producers write into shared memory ring buffers
+// (orbit_producer_side_channel::SharedMemoryRingBuffer) and passes them to a
+// ProducerEventProcessor. While started, a thread reads all ring buffers every millisecond and
+// looks for new ones among the file descriptors of the target process every 100 milliseconds. Only
+// ring buffers that are owned by the user of the target process and that were created by the target
+// process itself are read. A ring buffer is dropped once it is closed by its producer and empty, or
+// once the target process has exited and it is empty. Records that are already in the ring buffers
+// when the reader is started were written before the capture and are discarded.
+class SharedMemoryRingBufferReader {
+ public:
+  SharedMemoryRingBufferReader() = default;
+  ~SharedMemoryRingBufferReader();
+
+  SharedMemoryRingBufferReader(const SharedMemoryRingBufferReader&) = delete;
+  SharedMemoryRingBufferReader& operator=(const SharedMemoryRingBufferReader&) = delete;
+
+  // Starts reading the ring buffers of process `pid`. Producers must only be told that the capture
+  // started after this returns, as records written before are discarded.
+  void Start(ProducerEventProcessor* producer_event_processor, pid_t pid);
+  // Reads the events that are still in the ring buffers and stops the thread.
+  void Stop();
+  [[nodiscard]] bool IsRunning() const { return thread_.joinable(); }
+
+ private:
+  void ReaderThread();
+  void UpdateRingBuffers();
+  // Reads all ring buffers, and passes their records on unless `discard_records` is set.
+  void ReadRingBuffers(bool discard_records = false);
+  // Returns false if the ring buffer can't be read anymore.
+  [[nodiscard]] bool ReadRingBuffer(
+      orbit_producer_side_channel::SharedMemoryRingBuffer* ring_buffer, bool discard_records);
+
+  ProducerEventProcessor* producer_event_processor_ = nullptr;
+  pid_t pid_ = -1;
+  std::thread thread_;
+  std::atomic<bool> stop_requested_ = false;
+
+  // Only accessed by the reader thread. Ring buffers are identified by the inode of their memfd, as
+  // file descriptor numbers are reused.
+  absl::flat_hash_map<ino_t, std::unique_ptr<orbit_producer_side_channel::SharedMemoryRingBuffer>>
+      ring_buffers_;
+  // Ring buffers that are not valid, whose records can't be decoded or that were closed and read.
+  absl::flat_hash_set<ino_t> ignored_inodes_;
+  std::vector<uint8_t> records_;
+};
+
+}  // namespace orbit_service
+
+#endif  // ORBIT_SERVICE_SHARED_MEMORY_RING_BUFFER_READER_H_
@@ -0,0 +1,222 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Api/EncodedEvent.h"
+#include "GrpcProtos/Constants.h"
+#include "OrbitBase/Result.h"
+#include "ProducerEventProcessor.h"
+#include "ProducerSideChannel/SharedMemoryRingBuffer.h"
+#include "SharedMemoryRingBufferReader.h"
+#include "capture.pb.h"
+
+namespace orbit_service {
+
+using orbit_grpc_protos::ProducerCaptureEvent;
+using orbit_producer_side_channel::kSharedMemoryRingBufferNamePrefix;
+using orbit_producer_side_channel::SharedMemoryRecordType;
+using orbit_producer_side_channel::SharedMemoryRingBuffer;
+
+namespace {
+
+class RecordingProducerEventProcessor : public ProducerEventProcessor {
+ public:
+  void ProcessEvent(uint64_t producer_id, ProducerCaptureEvent event) override {
+    absl::MutexLock lock{&mutex_};
+    producer_ids_.push_back(producer_id);
+    events_.push_back(std::move(event));
+  }
+
+  [[nodiscard]] std::vector<ProducerCaptureEvent> GetEvents() {
+    absl::MutexLock lock{&mutex_};
+    return events_;
+  }
+  [[nodiscard]] std::vector<uint64_t> GetProducerIds() {
+    absl::MutexLock lock{&mutex_};
+    return producer_ids_;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::vector<uint64_t> producer_ids_;
+  std::vector<ProducerCaptureEvent> events_;
+};
+
+[[nodiscard]] std::unique_ptr<SharedMemoryRingBuffer> CreateApiEventRingBuffer(
+    std::string_view name) {
+  ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> ring_buffer =
+      SharedMemoryRingBuffer::Create(
+          absl::StrFormat("%s%s", kSharedMemoryRingBufferNamePrefix, name),
+          SharedMemoryRecordType::kApiEvent, sizeof(orbit_api::ApiEvent), 64);
+  EXPECT_TRUE(ring_buffer.has_value()) << ring_buffer.error().message();
+  return std::move(ring_buffer.value());
+}
+
+}  // namespace
+
+TEST(SharedMemoryRingBufferReader, ReadsApiEventsFromAllRingBuffers) {
+  std::unique_ptr<SharedMemoryRingBuffer> ring_buffer1 = CreateApiEventRingBuffer("1");
+  std::unique_ptr<SharedMemoryRingBuffer> ring_buffer2 = CreateApiEventRingBuffer("2");
+
+  RecordingProducerEventProcessor producer_event_processor;
+  SharedMemoryRingBufferReader reader;
+  reader.Start(&producer_event_processor, getpid());
+
+  orbit_api::ApiEvent api_event1{42, 43, 1000, orbit_api::kScopeStart, "Scope", 0, kOrbitColorRed};
+  orbit_api::ApiEvent api_event2{42, 44, 2000, orbit_api::kTrackInt, "Track", 7};
+  EXPECT_TRUE(ring_buffer1->TryWrite(api_event1));
+  EXPECT_TRUE(ring_buffer2->TryWrite(api_event2));
+
+  // A ring buffer created while the reader is running is also found.
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  std::unique_ptr<SharedMemoryRingBuffer> ring_buffer3 = CreateApiEventRingBuffer("3");
+  orbit_api::ApiEvent api_event3{42, 45, 3000, orbit_api::kScopeStop};
+  EXPECT_TRUE(ring_buffer3->TryWrite(api_event3));
+
+  reader.Stop();
+  EXPECT_TRUE(ring_buffer1->IsEmpty());
+  EXPECT_TRUE(ring_buffer2->IsEmpty());
+  EXPECT_TRUE(ring_buffer3->IsEmpty());
+
+  std::vector<ProducerCaptureEvent> events = producer_event_processor.GetEvents();
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_THAT(producer_event_processor.GetProducerIds(),
+              testing::Each(orbit_grpc_protos::kSharedMemoryProducerId));
+  std::sort(events.begin(), events.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.api_event().timestamp_ns() < rhs.api_event().timestamp_ns();
+  });
+  const std::vector<orbit_api::ApiEvent> expected_events{api_event1, api_event2, api_event3};
+  for (size_t i = 0; i < events.size(); ++i) {
+    const orbit_api::ApiEvent& expected = expected_events[i];
+    ASSERT_TRUE(events[i].has_api_event());
+    const orbit_grpc_protos::ApiEvent& actual = events[i].api_event();
+    EXPECT_EQ(actual.timestamp_ns(), expected.timestamp_ns);
+    EXPECT_EQ(actual.pid(), expected.pid);
+    EXPECT_EQ(actual.tid(), expected.tid);
+    EXPECT_EQ(actual.r0(), expected.encoded_event.args[0]);
+    EXPECT_EQ(actual.r1(), expected.encoded_event.args[1]);
+    EXPECT_EQ(actual.r2(), expected.encoded_event.args[2]);
+    EXPECT_EQ(actual.r3(), expected.encoded_event.args[3]);
+    EXPECT_EQ(actual.r4(), expected.encoded_event.args[4]);
+    EXPECT_EQ(actual.r5(), expected.encoded_event.args[5]);
+  }
+}
+
+TEST(SharedMemoryRingBufferReader, DropsClosedRingBuffersOnceRead) {
+  std::unique_ptr<SharedMemoryRingBuffer> closed_ring_buffer = CreateApiEventRingBuffer("closed");
+  std::unique_ptr<SharedMemoryRingBuffer> open_ring_buffer = CreateApiEventRingBuffer("open");
+
+  RecordingProducerEventProcessor producer_event_processor;
+  SharedMemoryRingBufferReader reader;
+  reader.Start(&producer_event_processor, getpid());
+  EXPECT_TRUE(
+      closed_ring_buffer->TryWrite(orbit_api::ApiEvent{42, 43, 1000, orbit_api::kScopeStop}));
+  closed_ring_buffer->Close();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  EXPECT_EQ(producer_event_processor.GetEvents().size(), 1);
+
+  // A misbehaving producer writing after closing: the closed ring buffer is not read anymore.
+  EXPECT_TRUE(
+      closed_ring_buffer->TryWrite(orbit_api::ApiEvent{42, 43, 2000, orbit_api::kScopeStop}));
+  EXPECT_TRUE(open_ring_buffer->TryWrite(orbit_api::ApiEvent{42, 44, 3000, orbit_api::kScopeStop}));
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  reader.Stop();
+
+  EXPECT_EQ(producer_event_processor.GetEvents().size(), 2);
+  EXPECT_FALSE(closed_ring_buffer->IsEmpty());
+  EXPECT_TRUE(open_ring_buffer->IsEmpty());
+}
+
+TEST(SharedMemoryRingBufferReader, DiscardsRecordsWrittenBeforeStart) {
+  std::unique_ptr<SharedMemoryRingBuffer> ring_buffer = CreateApiEventRingBuffer("stale");
+  EXPECT_TRUE(ring_buffer->TryWrite(orbit_api::ApiEvent{42, 43, 1000, orbit_api::kScopeStop}));
+
+  RecordingProducerEventProcessor first_producer_event_processor;
+  SharedMemoryRingBufferReader reader;
+  reader.Start(&first_producer_event_processor, getpid());
+  EXPECT_TRUE(ring_buffer->IsEmpty());
+  EXPECT_TRUE(ring_buffer->TryWrite(orbit_api::ApiEvent{42, 43, 2000, orbit_api::kScopeStop}));
+  reader.Stop();
+
+  // Written after the first capture was stopped, so this belongs to neither capture.
+  EXPECT_TRUE(ring_buffer->TryWrite(orbit_api::ApiEvent{42, 43, 3000, orbit_api::kScopeStop}));
+
+  RecordingProducerEventProcessor second_producer_event_processor;
+  reader.Start(&second_producer_event_processor, getpid());
+  EXPECT_TRUE(ring_buffer->TryWrite(orbit_api::ApiEvent{42, 43, 4000, orbit_api::kScopeStop}));
+  reader.Stop();
+
+  std::vector<ProducerCaptureEvent> first_events = first_producer_event_processor.GetEvents();
+  ASSERT_EQ(first_events.size(), 1);
+  EXPECT_EQ(first_events[0].api_event().timestamp_ns(), 2000);
+  std::vector<ProducerCaptureEvent> second_events = second_producer_event_processor.GetEvents();
+  ASSERT_EQ(second_events.size(), 1);
+  EXPECT_EQ(second_events[0].api_event().timestamp_ns(), 4000);
+}
+
+TEST(SharedMemoryRingBufferReader, IgnoresOtherMemfds) {
+  ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> unsupported_ring_buffer =
+      SharedMemoryRingBuffer::Create(
+          absl::StrFormat("%sunsupported", kSharedMemoryRingBufferNamePrefix),
+          SharedMemoryRecordType::kApiEvent, sizeof(uint64_t), 64);
+  ASSERT_TRUE(unsupported_ring_buffer.has_value());
+  EXPECT_TRUE(unsupported_ring_buffer.value()->TryWrite(uint64_t{1}));
+  ErrorMessageOr<std::unique_ptr<SharedMemoryRingBuffer>> unrelated_ring_buffer =
+      SharedMemoryRingBuffer::Create("unrelated", SharedMemoryRecordType::kApiEvent,
+                                     sizeof(orbit_api::ApiEvent), 64);
+  ASSERT_TRUE(unrelated_ring_buffer.has_value());
+  EXPECT_TRUE(unrelated_ring_buffer.value()->TryWrite(orbit_api::ApiEvent{}));
+
+  RecordingProducerEventProcessor producer_event_processor;
+  SharedMemoryRingBufferReader reader;
+  reader.Start(&producer_event_processor, getpid());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  reader.Stop();
+
+  EXPECT_TRUE(producer_event_processor.GetEvents().empty());
+  EXPECT_FALSE(unsupported_ring_buffer.value()->IsEmpty());
+  EXPECT_FALSE(unrelated_ring_buffer.value()->IsEmpty());
+}
+
+TEST(SharedMemoryRingBufferReader, OnlyReadsRingBuffersCreatedByTheTargetProcess) {
+  std::unique_ptr<SharedMemoryRingBuffer> ring_buffer = CreateApiEventRingBuffer("parent");
+  EXPECT_TRUE(ring_buffer->TryWrite(orbit_api::ApiEvent{42, 43, 1000, orbit_api::kScopeStop}));
+
+  // The child inherits the memfd of the ring buffer, but didn't create it.
+  const pid_t child_pid = fork();
+  ASSERT_NE(child_pid, -1);
+  if (child_pid == 0) {
+    pause();
+    _exit(0);
+  }
+
+  RecordingProducerEventProcessor producer_event_processor;
+  SharedMemoryRingBufferReader reader;
+  reader.Start(&producer_event_processor, child_pid);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  reader.Stop();
+
+  kill(child_pid, SIGKILL);
+  waitpid(child_pid, nullptr, 0);
+
+  EXPECT_TRUE(producer_event_processor.GetEvents().empty());
+  EXPECT_FALSE(ring_buffer->IsEmpty());
+}
+
+}  // namespace orbit_service
@@ -0,0 +1,125 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "TscConverter.h"
+
+#include <absl/strings/ascii.h>
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/Result.h"
+
+namespace orbit_service {
+
+TscConverter::TscConverter(std::function<uint64_t()> read_tsc,
+                           std::function<uint64_t()> read_timestamp_ns)
+    : read_tsc_{std::move(read_tsc)}, read_timestamp_ns_{std::move(read_timestamp_ns)} {
+  const Calibration initial_calibration{TakeCalibrationPoint(), 0.0, 0};
+  std::this_thread::sleep_for(kInitialCalibrationDuration);
+  const Calibration calibration = Calibrate(initial_calibration);
+  if (calibration.ns_per_tick == 0.0) {
+    ERROR("Calibrating the time stamp counter: it did not advance");
+  }
+  StoreCalibration(calibration);
+}
+
+uint64_t TscConverter::ToCaptureTimestampNs(uint64_t tsc) {
+  Calibration calibration = LoadCalibration();
+  const CalibrationPoint& calibration_point = calibration.calibration_point;
+  if (tsc > calibration_point.tsc &&
+      tsc - calibration_point.tsc >= calibration.recalibration_interval_ticks &&
+      !recalibrating_.exchange(true, std::memory_order_acquire)) {
+    // Another thread might have recalibrated between LoadCalibration and winning recalibrating_.
+    calibration = Calibrate(LoadCalibration());
+    StoreCalibration(calibration);
+    recalibrating_.store(false, std::memory_order_release);
+  }
+  // `tsc` can be older than the calibration point.
+  const auto delta_ticks = static_cast<int64_t>(tsc - calibration_point.tsc);
+  const auto delta_ns = std::llround(static_cast<double>(delta_ticks) * calibration.ns_per_tick);
+  return calibration_point.timestamp_ns + delta_ns;
+}
+
+bool TscConverter::IsTscClockSource() {
+  ErrorMessageOr<std::string> clock_source = orbit_base::ReadFileToString(
+      "/sys/devices/system/clocksource/clocksource0/current_clocksource");
+  if (clock_source.has_error()) {
+    ERROR("Reading the current clock source: %s", clock_source.error().message());
+    return false;
+  }
+  return absl::StripAsciiWhitespace(clock_source.value()) == "tsc";
+}
+
+TscConverter::CalibrationPoint TscConverter::TakeCalibrationPoint() const {
+  // Bracket the read of the time stamp counter with two reads of the clock and keep the tightest of
+  // a few attempts, so that being interrupted in between doesn't affect the calibration.
+  constexpr int kAttempts = 5;
+  CalibrationPoint best_calibration_point{};
+  uint64_t best_window_ns = std::numeric_limits<uint64_t>::max();
+  for (int i = 0; i < kAttempts; ++i) {
+    const uint64_t before_ns = read_timestamp_ns_();
+    const uint64_t tsc = read_tsc_();
+    const uint64_t after_ns = read_timestamp_ns_();
+    if (after_ns - before_ns < best_window_ns) {
+      best_window_ns = after_ns - before_ns;
+      best_calibration_point = {tsc, before_ns + best_window_ns / 2};
+    }
+  }
+  return best_calibration_point;
+}
+
+TscConverter::Calibration TscConverter::Calibrate(const Calibration& last_calibration) const {
+  const CalibrationPoint& last_calibration_point = last_calibration.calibration_point;
+  const CalibrationPoint calibration_point = TakeCalibrationPoint();
+  if (calibration_point.tsc <= last_calibration_point.tsc ||
+      calibration_point.timestamp_ns <= last_calibration_point.timestamp_ns) {
+    return last_calibration;
+  }
+  const double ns_per_tick =
+      static_cast<double>(calibration_point.timestamp_ns - last_calibration_point.timestamp_ns) /
+      static_cast<double>(calibration_point.tsc - last_calibration_point.tsc);
+  const auto recalibration_interval_ticks = static_cast<uint64_t>(
+      std::chrono::nanoseconds{kRecalibrationInterval}.count() / ns_per_tick);
+  return Calibration{calibration_point, ns_per_tick, recalibration_interval_ticks};
+}
+
+TscConverter::Calibration TscConverter::LoadCalibration() const {
+  Calibration calibration{};
+  uint64_t sequence_before = 0;
+  uint64_t sequence_after = 0;
+  do {
+    sequence_before = sequence_.load(std::memory_order_acquire);
+    calibration.calibration_point.tsc = calibration_tsc_.load(std::memory_order_relaxed);
+    calibration.calibration_point.timestamp_ns =
+        calibration_timestamp_ns_.load(std::memory_order_relaxed);
+    calibration.ns_per_tick = ns_per_tick_.load(std::memory_order_relaxed);
+    calibration.recalibration_interval_ticks =
+        recalibration_interval_ticks_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    sequence_after = sequence_.load(std::memory_order_relaxed);
+  } while (sequence_before != sequence_after || (sequence_before & 1) != 0);
+  return calibration;
+}
+
+void TscConverter::StoreCalibration(const Calibration& calibration) {
+  const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  calibration_tsc_.store(calibration.calibration_point.tsc, std::memory_order_relaxed);
+  calibration_timestamp_ns_.store(calibration.calibration_point.timestamp_ns,
+                                  std::memory_order_relaxed);
+  ns_per_tick_.store(calibration.ns_per_tick, std::memory_order_relaxed);
+  recalibration_interval_ticks_.store(calibration.recalibration_interval_ticks,
+                                      std::memory_order_relaxed);
+  sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+}  // namespace orbit_service
@@ -0,0 +1,76 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef ORBIT_SERVICE_TSC_CONVERTER_H_
+#define ORBIT_SERVICE_TSC_CONVERTER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include "OrbitBase/Profiling.h"
+
+namespace orbit_service {
+
+// Converts values of the time stamp counter, as read by orbit_base::ReadTsc, to timestamps of
+// orbit_base::CaptureTimestampNs. The conversion is calibrated when the converter is created and
+// recalibrated as values at least kRecalibrationInterval newer than the last calibration point
+// are converted, so that it follows the adjustments NTP makes to CLOCK_MONOTONIC.
+//
+// ToCaptureTimestampNs is thread-safe and lock-free. The calibration is published with a sequence
+// lock: readers only retry while it is being replaced, and only one thread at a time recalibrates,
+// the others keep converting with the previous calibration in the meantime.
+class TscConverter {
+ public:
+  static constexpr std::chrono::milliseconds kInitialCalibrationDuration{10};
+  static constexpr std::chrono::milliseconds kRecalibrationInterval{100};
+
+  // Blocks for kInitialCalibrationDuration to take the first two calibration points.
+  TscConverter() : TscConverter{&orbit_base::ReadTsc, &orbit_base::CaptureTimestampNs} {}
+  // For tests.
+  TscConverter(std::function<uint64_t()> read_tsc, std::function<uint64_t()> read_timestamp_ns);
+
+  [[nodiscard]] uint64_t ToCaptureTimestampNs(uint64_t tsc);
+
+  // Returns whether the time stamp counter is the clock source of the kernel. Only then is it known
+  // to tick at a constant rate and to be synchronized across CPUs, so that values read by different
+  // threads of different processes can be converted.
+  [[nodiscard]] static bool IsTscClockSource();
+
+ private:
+  struct CalibrationPoint {
+    uint64_t tsc;
+    uint64_t timestamp_ns;
+  };
+
+  struct Calibration {
+    CalibrationPoint calibration_point;
+    double ns_per_tick;
+    uint64_t recalibration_interval_ticks;
+  };
+
+  [[nodiscard]] CalibrationPoint TakeCalibrationPoint() const;
+  // Returns the calibration from `last_calibration` to a new calibration point, or
+  // `last_calibration` if the clocks did not advance.
+  [[nodiscard]] Calibration Calibrate(const Calibration& last_calibration) const;
+  [[nodiscard]] Calibration LoadCalibration() const;
+  // Must only be called by the thread that set recalibrating_, or by the constructor.
+  void StoreCalibration(const Calibration& calibration);
+
+  std::function<uint64_t()> read_tsc_;
+  std::function<uint64_t()> read_timestamp_ns_;
+
+  // Odd while StoreCalibration is replacing the fields below.
+  std::atomic<uint64_t> sequence_{0};
+  std::atomic<uint64_t> calibration_tsc_{0};
+  std::atomic<uint64_t> calibration_timestamp_ns_{0};
+  std::atomic<double> ns_per_tick_{0.0};
+  std::atomic<uint64_t> recalibration_interval_ticks_{0};
+  std::atomic<bool> recalibrating_{false};
+};
+
+}  // namespace orbit_service
+
+#endif  // ORBIT_SERVICE_TSC_CONVERTER_H_
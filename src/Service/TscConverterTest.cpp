@@ -0,0 +1,120 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "OrbitBase/Profiling.h"
+#include "TscConverter.h"
+
+namespace orbit_service {
+
+namespace {
+
+// A clock and a time stamp counter that advance by one nanosecond on every read, so that
+// calibration points are exact.
+class FakeClocks {
+ public:
+  [[nodiscard]] uint64_t ReadTsc() { return TscAt(now_ns_++); }
+  [[nodiscard]] uint64_t ReadTimestampNs() { return now_ns_++; }
+
+  [[nodiscard]] uint64_t TscAt(uint64_t timestamp_ns) const {
+    return tsc_at_rate_change_ + (timestamp_ns - ns_at_rate_change_) * ticks_per_ns_;
+  }
+  [[nodiscard]] uint64_t now_ns() const { return now_ns_; }
+
+  void Advance(std::chrono::nanoseconds duration) { now_ns_ += duration.count(); }
+  void SetTicksPerNs(uint64_t ticks_per_ns) {
+    tsc_at_rate_change_ = TscAt(now_ns_);
+    ns_at_rate_change_ = now_ns_;
+    ticks_per_ns_ = ticks_per_ns;
+  }
+
+ private:
+  uint64_t now_ns_ = 1'000'000'000;
+  uint64_t ns_at_rate_change_ = 0;
+  uint64_t tsc_at_rate_change_ = 5'000;
+  uint64_t ticks_per_ns_ = 3;
+};
+
+[[nodiscard]] TscConverter CreateConverter(FakeClocks* clocks) {
+  return TscConverter{[clocks] { return clocks->ReadTsc(); },
+                      [clocks] { return clocks->ReadTimestampNs(); }};
+}
+
+}  // namespace
+
+TEST(TscConverter, ConvertsTscToCaptureTimestamps) {
+  FakeClocks clocks;
+  TscConverter converter = CreateConverter(&clocks);
+
+  const uint64_t now_ns = clocks.now_ns();
+  EXPECT_NEAR(converter.ToCaptureTimestampNs(clocks.TscAt(now_ns)), now_ns, 1);
+  EXPECT_NEAR(converter.ToCaptureTimestampNs(clocks.TscAt(now_ns - 12'345)), now_ns - 12'345, 1);
+  EXPECT_NEAR(converter.ToCaptureTimestampNs(clocks.TscAt(now_ns + 54'321)), now_ns + 54'321, 1);
+}
+
+TEST(TscConverter, FollowsChangesOfTheRate) {
+  FakeClocks clocks;
+  TscConverter converter = CreateConverter(&clocks);
+
+  clocks.SetTicksPerNs(2);
+  // The first recalibration happens across the change.
+  clocks.Advance(2 * TscConverter::kRecalibrationInterval);
+  (void)converter.ToCaptureTimestampNs(clocks.TscAt(clocks.now_ns()));
+  clocks.Advance(2 * TscConverter::kRecalibrationInterval);
+  const uint64_t now_ns = clocks.now_ns();
+  EXPECT_NEAR(converter.ToCaptureTimestampNs(clocks.TscAt(now_ns)), now_ns, 1);
+  EXPECT_NEAR(converter.ToCaptureTimestampNs(clocks.TscAt(now_ns - 12'345)), now_ns - 12'345, 1);
+}
+
+TEST(TscConverter, ConvertsConcurrentlyWhileRecalibrating) {
+  std::atomic<uint64_t> now_ns{1'000'000'000};
+  constexpr uint64_t kTicksPerNs = 3;
+  TscConverter converter{[&now_ns] { return kTicksPerNs * now_ns.fetch_add(1); },
+                         [&now_ns] { return now_ns.fetch_add(1); }};
+
+  constexpr int kNumThreads = 4;
+  constexpr int kNumConversionsPerThread = 10'000;
+  // Large enough for some of the conversions to recalibrate.
+  constexpr uint64_t kStepNs =
+      std::chrono::nanoseconds{TscConverter::kRecalibrationInterval}.count() / 100;
+  std::vector<std::thread> threads;
+  std::atomic<int> num_wrong_conversions{0};
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < kNumConversionsPerThread; ++j) {
+        const uint64_t timestamp_ns = now_ns.fetch_add(kStepNs);
+        const uint64_t converted_ns = converter.ToCaptureTimestampNs(kTicksPerNs * timestamp_ns);
+        if (converted_ns + 1 < timestamp_ns || converted_ns > timestamp_ns + 1) {
+          ++num_wrong_conversions;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(num_wrong_conversions, 0);
+}
+
+TEST(TscConverter, ConvertsTheTimeStampCounterOfThisMachine) {
+  if (!TscConverter::IsTscClockSource()) {
+    GTEST_SKIP() << "The time stamp counter is not the clock source of the kernel";
+  }
+  TscConverter converter;
+
+  const uint64_t before_ns = orbit_base::CaptureTimestampNs();
+  const uint64_t tsc = orbit_base::ReadTsc();
+  const uint64_t after_ns = orbit_base::CaptureTimestampNs();
+  const uint64_t timestamp_ns = converter.ToCaptureTimestampNs(tsc);
+  constexpr uint64_t kToleranceNs = 10'000;
+  EXPECT_GE(timestamp_ns, before_ns - kToleranceNs);
+  EXPECT_LE(timestamp_ns, after_ns + kToleranceNs);
+}
+
+}  // namespace orbit_service
@@ -8,12 +8,18 @@
 #include <absl/strings/numbers.h>
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_split.h>
+#include <absl/synchronization/mutex.h>
+#include <fcntl.h>
 #include <sys/ptrace.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <string>
 
+#include "OrbitBase/File.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ReadFileToString.h"
 #include "OrbitBase/SafeStrerror.h"
@@ -22,36 +28,120 @@ namespace orbit_user_space_instrumentation {
 
 using orbit_base::ReadFileToString;
 
-[[nodiscard]] ErrorMessageOr<std::vector<uint8_t>> ReadTraceesMemory(pid_t pid,
-                                                                     uint64_t address_start,
-                                                                     uint64_t length) {
-  // Round up length to next multiple of eight.
-  length = ((length + 7) / 8) * 8;
-  std::vector<uint8_t> bytes(length);
+namespace {
+
+// Reads `length` bytes with one `PTRACE_PEEKDATA` per eight bytes. `length` is a multiple of eight.
+[[nodiscard]] ErrorMessageOr<void> ReadTraceesMemoryWithPtrace(pid_t pid, uint64_t address_start,
+                                                               uint64_t length, uint8_t* bytes) {
   for (size_t i = 0; i < length / 8; i++) {
+    // PTRACE_PEEKDATA returns the data, so errors can only be told apart using errno.
+    errno = 0;
     const uint64_t data = ptrace(PTRACE_PEEKDATA, pid, address_start + i * 8, NULL);
     if (errno) {
       return ErrorMessage(
           absl::StrFormat("Failed to PTRACE_PEEKDATA for pid %d with errno %d: \"%s\"", pid, errno,
                           SafeStrerror(errno)));
     }
-    std::memcpy(bytes.data() + (i * sizeof(uint64_t)), &data, 8);
+    std::memcpy(bytes + (i * sizeof(uint64_t)), &data, 8);
   }
-  return bytes;
+  return outcome::success();
 }
 
-[[nodiscard]] ErrorMessageOr<void> WriteTraceesMemory(pid_t pid, uint64_t address_start,
-                                                      const std::vector<uint8_t>& bytes) {
-  size_t pos = 0;
-  do {
-    // Pack 8 bytes for writing into `data`.
+// Writes `length` bytes with one `PTRACE_POKEDATA` per eight bytes. If `length` is not a multiple
+// of eight the last word is read first, so the bytes following the range are preserved.
+[[nodiscard]] ErrorMessageOr<void> WriteTraceesMemoryWithPtrace(pid_t pid, uint64_t address_start,
+                                                                const uint8_t* bytes,
+                                                                uint64_t length) {
+  for (uint64_t pos = 0; pos < length; pos += sizeof(uint64_t)) {
     uint64_t data = 0;
-    std::memcpy(&data, bytes.data() + pos, sizeof(uint64_t));
+    const uint64_t num_bytes = std::min<uint64_t>(sizeof(uint64_t), length - pos);
+    if (num_bytes < sizeof(uint64_t)) {
+      std::vector<uint8_t> last_word(sizeof(uint64_t));
+      OUTCOME_TRY(ReadTraceesMemoryWithPtrace(pid, address_start + pos, sizeof(uint64_t),
+                                              last_word.data()));
+      std::memcpy(&data, last_word.data(), sizeof(uint64_t));
+    }
+    std::memcpy(&data, bytes + pos, num_bytes);
     if (ptrace(PTRACE_POKEDATA, pid, address_start + pos, data) == -1) {
       return ErrorMessage(absl::StrFormat("Failed to PTRACE_POKEDATA for pid: %d.", pid));
     }
-    pos += sizeof(uint64_t);
-  } while (pos < bytes.size());
+  }
+  return outcome::success();
+}
+
+// The file descriptor of `/proc/<pid>/mem` of the tracee written last. Instrumenting a process
+// writes into it many times in a row, so the file is only opened once per tracee.
+struct ProcPidMemFd {
+  absl::Mutex mutex;
+  pid_t pid ABSL_GUARDED_BY(mutex) = -1;
+  orbit_base::unique_fd fd ABSL_GUARDED_BY(mutex);
+};
+
+[[nodiscard]] ProcPidMemFd& GetProcPidMemFd() {
+  static auto* proc_pid_mem_fd = new ProcPidMemFd();
+  return *proc_pid_mem_fd;
+}
+
+// Writes through `/proc/<pid>/mem`. Unlike `process_vm_writev` this ignores the page protections
+// (like ptrace does), so it can write into read-only code as well as into writable memory with a
+// single system call. Returns the number of bytes written.
+[[nodiscard]] uint64_t WriteTraceesMemoryWithProcPidMem(pid_t pid, uint64_t address_start,
+                                                        const uint8_t* bytes, uint64_t length) {
+  ProcPidMemFd& proc_pid_mem_fd = GetProcPidMemFd();
+  absl::MutexLock lock(&proc_pid_mem_fd.mutex);
+  // A cached file descriptor can belong to an earlier process with the same pid, which makes the
+  // write fail. Hence a failed write with a cached file descriptor is retried with a new one.
+  bool is_cached = proc_pid_mem_fd.pid == pid && proc_pid_mem_fd.fd.valid();
+  while (true) {
+    if (!is_cached) {
+      proc_pid_mem_fd.pid = pid;
+      proc_pid_mem_fd.fd = orbit_base::unique_fd{TEMP_FAILURE_RETRY(
+          open(absl::StrFormat("/proc/%d/mem", pid).c_str(), O_WRONLY | O_CLOEXEC))};
+      if (!proc_pid_mem_fd.fd.valid()) return 0;
+    }
+    uint64_t pos = 0;
+    while (pos < length) {
+      const ssize_t result =
+          TEMP_FAILURE_RETRY(pwrite64(proc_pid_mem_fd.fd.get(), bytes + pos, length - pos,
+                                      static_cast<off64_t>(address_start + pos)));
+      if (result <= 0) break;
+      pos += result;
+    }
+    if (pos > 0 || !is_cached) return pos;
+    is_cached = false;
+  }
+}
+
+}  // namespace
+
+[[nodiscard]] ErrorMessageOr<std::vector<uint8_t>> ReadTraceesMemory(pid_t pid,
+                                                                     uint64_t address_start,
+                                                                     uint64_t length) {
+  // Round up length to next multiple of eight.
+  length = ((length + 7) / 8) * 8;
+  std::vector<uint8_t> bytes(length);
+
+  // Read everything with one system call if possible. Fall back to ptrace if `process_vm_readv` is
+  // not available, e.g. because it is blocked by seccomp.
+  iovec local_iov{bytes.data(), length};
+  iovec remote_iov{absl::bit_cast<void*>(address_start), length};
+  if (process_vm_readv(pid, &local_iov, 1, &remote_iov, 1, 0) == static_cast<ssize_t>(length)) {
+    return bytes;
+  }
+  OUTCOME_TRY(ReadTraceesMemoryWithPtrace(pid, address_start, length, bytes.data()));
+  return bytes;
+}
+
+[[nodiscard]] ErrorMessageOr<void> WriteTraceesMemory(pid_t pid, uint64_t address_start,
+                                                      const std::vector<uint8_t>& bytes) {
+  // `/proc/<pid>/mem` writes code as well as writable memory like trampolines with one system call.
+  // Whatever remains, e.g. because `/proc` is not accessible, is written with ptrace.
+  const uint64_t pos =
+      WriteTraceesMemoryWithProcPidMem(pid, address_start, bytes.data(), bytes.size());
+  if (pos < bytes.size()) {
+    OUTCOME_TRY(WriteTraceesMemoryWithPtrace(pid, address_start + pos, bytes.data() + pos,
+                                             bytes.size() - pos));
+  }
   return outcome::success();
 }
 
@@ -69,9 +159,9 @@ using orbit_base::ReadFileToString;
     const std::vector<std::string> addresses = absl::StrSplit(tokens[0], '-');
     if (addresses.size() != 2) continue;
     AddressRange result;
-    if (!absl::numbers_internal::safe_strtou64_base(addresses[0], &result.first, 16)) continue;
-    if (!absl::numbers_internal::safe_strtou64_base(addresses[1], &result.second, 16)) continue;
-    if (exclude_address >= result.first && exclude_address < result.second) continue;
+    if (!absl::numbers_internal::safe_strtou64_base(addresses[0], &result.start, 16)) continue;
+    if (!absl::numbers_internal::safe_strtou64_base(addresses[1], &result.end, 16)) continue;
+    if (exclude_address >= result.start && exclude_address < result.end) continue;
     return result;
   }
   return ErrorMessage(absl::StrFormat("Unable to locate executable memory area in pid: %d", pid));
@@ -10,20 +10,22 @@
 #include <cstdint>
 #include <vector>
 
+#include "AddressRange.h"
 #include "OrbitBase/Result.h"
 
 namespace orbit_user_space_instrumentation {
 
 // Read `length` bytes from process `pid` starting at `address_start`. `length` will be rounded up
-// to a multiple of eight.
+// to a multiple of eight. Uses a single `process_vm_readv` and falls back to `PTRACE_PEEKDATA`.
 // Assumes we are already attached to the tracee `pid` e.g. using `AttachAndStopProcess`.
 [[nodiscard]] ErrorMessageOr<std::vector<uint8_t>> ReadTraceesMemory(pid_t pid,
                                                                      uint64_t address_start,
                                                                      uint64_t length);
 
-// Write `bytes` into memory of process `pid` starting from `address_start`.
-// Note that we write multiples of eight bytes at once. If length of `bytes` is not a multiple of
-// eight the remaining bytes are zeroed out.
+// Write `bytes` into memory of process `pid` starting from `address_start`. Exactly `bytes.size()`
+// bytes are written, the memory following them is left untouched. Writes go through
+// `/proc/<pid>/mem`, which also works for read-only memory like code, and fall back to
+// `PTRACE_POKEDATA`. The file descriptor of `/proc/<pid>/mem` is kept open for subsequent writes.
 // Assumes we are already attached to the tracee `pid` e.g. using `AttachAndStopProcess`.
 [[nodiscard]] ErrorMessageOr<void> WriteTraceesMemory(pid_t pid, uint64_t address_start,
                                                       const std::vector<uint8_t>& bytes);
@@ -34,7 +36,6 @@ namespace orbit_user_space_instrumentation {
 // is probably helping stability.
 // Optionally one can specify `exclude_address`. This prevents the method from returning an address
 // range containing `exclude_address`.
-using AddressRange = std::pair<uint64_t, uint64_t>;
 [[nodiscard]] ErrorMessageOr<AddressRange> GetFirstExecutableMemoryRegion(
     pid_t pid, uint64_t exclude_address = 0);
 
@@ -9,13 +9,16 @@
 #include <sys/wait.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <random>
 #include <vector>
 
 #include "AccessTraceesMemory.h"
+#include "AllocateInTracee.h"
 #include "Attach.h"
 #include "OrbitBase/Logging.h"
 #include "RegisterState.h"
@@ -36,7 +39,7 @@ TEST(AccessTraceesMemoryTest, ReadWriteRestore) {
 
   auto result_memory_region = GetFirstExecutableMemoryRegion(pid);
   CHECK(result_memory_region.has_value());
-  const uint64_t address_start = result_memory_region.value().first;
+  const uint64_t address_start = result_memory_region.value().start;
 
   constexpr uint64_t kMemorySize = 4 * 1024;
   auto result_backup = ReadTraceesMemory(pid, address_start, kMemorySize);
@@ -63,4 +66,128 @@ TEST(AccessTraceesMemoryTest, ReadWriteRestore) {
   waitpid(pid, NULL, 0);
 }
 
+TEST(AccessTraceesMemoryTest, WriteLeavesFollowingBytesUntouched) {
+  pid_t pid = fork();
+  CHECK(pid != -1);
+  if (pid == 0) {
+    while (true) {
+    }
+  }
+  CHECK(AttachAndStopProcess(pid).has_value());
+
+  auto result_memory_region = GetFirstExecutableMemoryRegion(pid);
+  CHECK(result_memory_region.has_value());
+  const uint64_t address_start = result_memory_region.value().start;
+
+  constexpr uint64_t kMemorySize = 16;
+  auto result_backup = ReadTraceesMemory(pid, address_start, kMemorySize);
+  CHECK(result_backup.has_value());
+
+  // Three bytes into read-only code: `/proc/<pid>/mem` ignores the page protections, and the
+  // `PTRACE_POKEDATA` fallback has to preserve the bytes after the last partial word.
+  const std::vector<uint8_t> new_data{0x01, 0x02, 0x03};
+  CHECK(!WriteTraceesMemory(pid, address_start, new_data).has_error());
+
+  auto result_read_back = ReadTraceesMemory(pid, address_start, kMemorySize);
+  CHECK(result_read_back.has_value());
+  std::vector<uint8_t> expected = result_backup.value();
+  std::copy(new_data.begin(), new_data.end(), expected.begin());
+  EXPECT_EQ(expected, result_read_back.value());
+
+  CHECK(WriteTraceesMemory(pid, address_start, result_backup.value()).has_value());
+
+  CHECK(!DetachAndContinueProcess(pid).has_error());
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+}
+
+// Performs the memory accesses of instrumenting `kNumFunctions` functions while the tracee is
+// stopped: reading each function, writing its trampoline and overwriting its first bytes with a
+// jump. Logs the time needed, which is the time the instrumented process is stopped for, next to
+// the time needed when accessing the memory word by word with ptrace. Timings vary too much between
+// machines to compare them here.
+TEST(AccessTraceesMemoryTest, StopTheWorldTimeForInstrumentingManyFunctions) {
+  pid_t pid = fork();
+  CHECK(pid != -1);
+  if (pid == 0) {
+    while (true) {
+    }
+  }
+  CHECK(AttachAndStopProcess(pid).has_value());
+
+  constexpr uint64_t kNumFunctions = 1000;
+  constexpr uint64_t kFunctionSize = 64;
+  constexpr uint64_t kTrampolineSize = 128;
+  constexpr uint64_t kJumpSize = 5;
+
+  auto result_memory_region = GetFirstExecutableMemoryRegion(pid);
+  CHECK(result_memory_region.has_value());
+  const uint64_t code_start = result_memory_region.value().start;
+  const uint64_t num_functions = std::min(
+      kNumFunctions, (result_memory_region.value().end - code_start) / kFunctionSize);
+  auto result_backup = ReadTraceesMemory(pid, code_start, num_functions * kFunctionSize);
+  CHECK(result_backup.has_value());
+
+  auto result_trampolines = AllocateInTracee(pid, 0, num_functions * kTrampolineSize);
+  CHECK(result_trampolines.has_value());
+  const uint64_t trampolines_start = result_trampolines.value();
+
+  const std::vector<uint8_t> trampoline(kTrampolineSize, 0x90);
+  const std::vector<uint8_t> jump(kJumpSize, 0xcc);
+
+  // Baseline: the same accesses with one ptrace call per eight bytes.
+  const auto baseline_start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < num_functions; ++i) {
+    const uint64_t function_address = code_start + i * kFunctionSize;
+    for (uint64_t offset = 0; offset < kFunctionSize; offset += 8) {
+      ptrace(PTRACE_PEEKDATA, pid, function_address + offset, NULL);
+    }
+    uint64_t trampoline_word = 0;
+    std::memcpy(&trampoline_word, trampoline.data(), sizeof(trampoline_word));
+    for (uint64_t offset = 0; offset < kTrampolineSize; offset += 8) {
+      ASSERT_NE(ptrace(PTRACE_POKEDATA, pid, trampolines_start + i * kTrampolineSize + offset,
+                       trampoline_word),
+                -1);
+    }
+    const uint64_t code_word = ptrace(PTRACE_PEEKDATA, pid, function_address, NULL);
+    ASSERT_NE(ptrace(PTRACE_POKEDATA, pid, function_address, code_word), -1);
+  }
+  const auto baseline_duration = std::chrono::steady_clock::now() - baseline_start;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < num_functions; ++i) {
+    const uint64_t function_address = code_start + i * kFunctionSize;
+    auto result_function = ReadTraceesMemory(pid, function_address, kFunctionSize);
+    ASSERT_TRUE(result_function.has_value());
+    ASSERT_FALSE(
+        WriteTraceesMemory(pid, trampolines_start + i * kTrampolineSize, trampoline).has_error());
+    ASSERT_FALSE(WriteTraceesMemory(pid, function_address, jump).has_error());
+  }
+  const auto duration = std::chrono::steady_clock::now() - start;
+  // Locally the bulk accesses are about six times faster than the baseline.
+  LOG("Memory accesses for instrumenting %u functions took %.3f ms (%.3f ms word by word).",
+      num_functions, std::chrono::duration<double, std::milli>(duration).count(),
+      std::chrono::duration<double, std::milli>(baseline_duration).count());
+
+  auto result_trampolines_read_back =
+      ReadTraceesMemory(pid, trampolines_start, num_functions * kTrampolineSize);
+  CHECK(result_trampolines_read_back.has_value());
+  EXPECT_EQ(result_trampolines_read_back.value(),
+            std::vector<uint8_t>(num_functions * kTrampolineSize, 0x90));
+  auto result_code_read_back = ReadTraceesMemory(pid, code_start, num_functions * kFunctionSize);
+  CHECK(result_code_read_back.has_value());
+  std::vector<uint8_t> expected_code = result_backup.value();
+  for (uint64_t i = 0; i < num_functions; ++i) {
+    std::copy(jump.begin(), jump.end(), expected_code.begin() + i * kFunctionSize);
+  }
+  EXPECT_EQ(expected_code, result_code_read_back.value());
+
+  CHECK(WriteTraceesMemory(pid, code_start, result_backup.value()).has_value());
+  CHECK(!FreeInTracee(pid, trampolines_start, num_functions * kTrampolineSize).has_error());
+
+  CHECK(!DetachAndContinueProcess(pid).has_error());
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+}
+
 }  // namespace orbit_user_space_instrumentation
\ No newline at end of file
@@ -0,0 +1,22 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef USER_SPACE_INSTRUMENTATION_ADDRESS_RANGE_H_
+#define USER_SPACE_INSTRUMENTATION_ADDRESS_RANGE_H_
+
+#include <cstdint>
+
+namespace orbit_user_space_instrumentation {
+
+// Half open range of addresses [start, end).
+struct AddressRange {
+  AddressRange() = default;
+  AddressRange(uint64_t s, uint64_t e) : start(s), end(e) {}
+  uint64_t start;
+  uint64_t end;
+};
+
+}  // namespace orbit_user_space_instrumentation
+
+#endif  // USER_SPACE_INSTRUMENTATION_ADDRESS_RANGE_H_
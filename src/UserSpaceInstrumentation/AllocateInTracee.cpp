@@ -54,7 +54,7 @@ namespace {
     return ErrorMessage(absl::StrFormat("Failed to find executable memory region: \"%s\"",
                                         result_memory_region.error().message()));
   }
-  const uint64_t address_start = result_memory_region.value().first;
+  const uint64_t address_start = result_memory_region.value().start;
 
   // Backup first 8 bytes.
   auto result_backup_code = ReadTraceesMemory(pid, address_start, 8);
@@ -74,6 +74,9 @@ namespace {
   RegisterState registers_for_syscall = original_registers;
   registers_for_syscall.GetGeneralPurposeRegisters()->x86_64.rip = address_start;
   registers_for_syscall.GetGeneralPurposeRegisters()->x86_64.rax = syscall;
+  // Don't let the kernel restart a system call the tracee might have been stopped in (compare
+  // `ExecuteOrDie` in InjectLibraryInTracee.cpp).
+  registers_for_syscall.GetGeneralPurposeRegisters()->x86_64.orig_rax = -1;
   // Register list for arguments can be found e.g. in the glibc wrapper:
   // https://github.com/bminor/glibc/blob/master/sysdeps/unix/sysv/linux/x86_64/syscall.S#L30
   registers_for_syscall.GetGeneralPurposeRegisters()->x86_64.rdi = arg_0;
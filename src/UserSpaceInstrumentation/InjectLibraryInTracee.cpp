@@ -33,6 +33,11 @@ using orbit_elf_utils::ReadModules;
 // Size of the small amount of memory we need in the tracee to write machine code into.
 constexpr uint64_t kCodeScratchPadSize = 1024;
 
+// Size of the area below the stack pointer that leaf functions may use without adjusting the stack
+// pointer, and the alignment of the stack pointer required before a function call (System V ABI).
+constexpr uint64_t kRedZoneSize = 128;
+constexpr uint64_t kStackAlignment = 16;
+
 constexpr const char* kLibcSoname = "libc.so.6";
 constexpr const char* kLibdlSoname = "libdl.so.2";
 constexpr const char* kDlopenInLibdl = "dlopen";
@@ -81,8 +86,17 @@ ErrorMessageOr<uint64_t> ExecuteOrDie(pid_t pid, uint64_t address_code, uint64_t
   RegisterState original_registers;
   OUTCOME_TRY(original_registers.BackupRegisters(pid));
 
+  // The tracee might be stopped anywhere, e.g. in a leaf function using the red zone below the
+  // stack pointer, and with a stack pointer that is not aligned. Skip the red zone and align the
+  // stack pointer as required for the function call in `code`.
   RegisterState registers_set_rip = original_registers;
   registers_set_rip.GetGeneralPurposeRegisters()->x86_64.rip = address_code;
+  uint64_t& rsp = registers_set_rip.GetGeneralPurposeRegisters()->x86_64.rsp;
+  rsp = (rsp - kRedZoneSize) & ~(kStackAlignment - 1);
+  // If the tracee was stopped in an interrupted system call, the kernel would restart that system
+  // call (by moving the instruction pointer back to the `syscall` instruction) when the tracee
+  // continues. Prevent that; the restart still happens when the original registers get restored.
+  registers_set_rip.GetGeneralPurposeRegisters()->x86_64.orig_rax = -1;
   OUTCOME_TRY(registers_set_rip.RestoreRegisters());
   if (ptrace(PTRACE_CONT, pid, 0, 0) != 0) {
     FATAL("Unable to continue tracee with PTRACE_CONT.");
@@ -267,6 +281,48 @@ ErrorMessageOr<uint64_t> FindFunctionAddressWithFallback(pid_t pid, std::string_
   return outcome::success();
 }
 
+ErrorMessageOr<void> CallFunctionWithStringInTracee(pid_t pid, void* function_address,
+                                                    std::string_view argument) {
+  // Allocate small memory area in the tracee. This is used for the code and the argument.
+  const uint64_t argument_length = argument.length() + 1;  // Include terminating zero.
+  const uint64_t memory_size = kCodeScratchPadSize + argument_length;
+  OUTCOME_TRY(address_code, AllocateInTracee(pid, 0, memory_size));
+
+  // Write the argument into memory at address_code with offset of kCodeScratchPadSize.
+  std::vector<uint8_t> argument_as_vector(argument_length, 0);
+  memcpy(argument_as_vector.data(), argument.data(), argument.length());
+  const uint64_t address_argument = address_code + kCodeScratchPadSize;
+  auto result_write_argument = WriteTraceesMemory(pid, address_argument, argument_as_vector);
+  if (result_write_argument.has_error()) {
+    FreeMemoryOrDie(pid, address_code, memory_size);
+    return result_write_argument.error();
+  }
+
+  // We want to do the following in the tracee:
+  // function(argument);
+  // The address of the argument goes to rdi. Then we load the address of the function into rax and
+  // do the call. Assembly in Intel syntax (destination first), machine code on the right:
+
+  // movabsq rdi, address_argument    48 bf address_argument
+  // movabsq rax, function_address    48 b8 function_address
+  // call rax                         ff d0
+  // int3                             cc
+  MachineCode code;
+  code.AppendBytes({0x48, 0xbf})
+      .AppendImmediate64(address_argument)
+      .AppendBytes({0x48, 0xb8})
+      .AppendImmediate64(absl::bit_cast<uint64_t>(function_address))
+      .AppendBytes({0xff, 0xd0})
+      .AppendBytes({0xcc});
+
+  auto return_value_or_error = ExecuteOrDie(pid, address_code, memory_size, code);
+  if (return_value_or_error.has_error()) {
+    FreeMemoryOrDie(pid, address_code, memory_size);
+    return return_value_or_error.error();
+  }
+  return outcome::success();
+}
+
 ErrorMessageOr<uint64_t> FindFunctionAddress(pid_t pid, std::string_view function_name,
                                              std::string_view module_soname) {
   auto modules = ReadModules(pid);
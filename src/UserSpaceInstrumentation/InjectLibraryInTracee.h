@@ -23,6 +23,12 @@ namespace orbit_user_space_instrumentation {
 [[nodiscard]] ErrorMessageOr<void*> DlsymInTracee(pid_t pid, void* handle, std::string_view symbol);
 [[nodiscard]] ErrorMessageOr<void> DlcloseInTracee(pid_t pid, void* handle);
 
+// Calls `void function(const char* argument)` at `function_address` in the tracee, passing a copy
+// of `argument` that lives in the tracee during the call.
+[[nodiscard]] ErrorMessageOr<void> CallFunctionWithStringInTracee(pid_t pid,
+                                                                  void* function_address,
+                                                                  std::string_view argument);
+
 // Returns the absolute virtual address of a function in a module of a process as resolved by the
 // dynsym section of the file that module is associated with.
 // The function name has to match the symbol name exactly. The module name needs match the soname
@@ -0,0 +1,391 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "UserSpaceInstrumentation/InstrumentationManager.h"
+
+#include <absl/base/casts.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_format.h>
+#include <absl/strings/str_join.h>
+#include <absl/strings/str_split.h>
+#include <capstone/capstone.h>
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "AccessTraceesMemory.h"
+#include "AllocateInTracee.h"
+#include "Attach.h"
+#include "ElfUtils/ElfFile.h"
+#include "InjectLibraryInTracee.h"
+#include "OrbitBase/ExecutablePath.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/UniqueResource.h"
+#include "ProducerSideChannel/ProducerSideChannel.h"
+#include "Trampoline.h"
+
+namespace orbit_user_space_instrumentation {
+
+using absl::numbers_internal::safe_strtou64_base;
+using orbit_grpc_protos::CaptureOptions;
+using orbit_grpc_protos::InstrumentedFunction;
+
+namespace {
+
+constexpr const char* kLibName = "libOrbitUserSpaceInstrumentation.so";
+constexpr const char* kEntryPayloadFunctionName = "EntryPayload";
+constexpr const char* kExitPayloadFunctionName = "ExitPayload";
+constexpr const char* kInitializeInstrumentationFunctionName = "InitializeInstrumentation";
+
+// The complete code of a function is read from the tracee to check for jumps into the bytes
+// overwritten by the jump into the trampoline. Larger functions are left to uprobes.
+constexpr uint64_t kMaxFunctionSize = 64 * 1024;
+
+// The payload library is deployed next to OrbitService. In the build tree it is in the "lib"
+// directory next to the "bin" directory.
+std::filesystem::path GetLibraryPath() {
+  const std::filesystem::path executable_dir = orbit_base::GetExecutableDir();
+  std::error_code error;
+  if (std::filesystem::exists(executable_dir / kLibName, error)) {
+    return executable_dir / kLibName;
+  }
+  return executable_dir / ".." / "lib" / kLibName;
+}
+
+struct ExecutableMapping {
+  AddressRange address_range;
+  uint64_t offset = 0;
+  std::string file_path;
+};
+
+// Returns the executable file mappings of process `pid` as listed in /proc/pid/maps.
+ErrorMessageOr<std::vector<ExecutableMapping>> ReadExecutableMappings(pid_t pid) {
+  OUTCOME_TRY(maps, orbit_base::ReadFileToString(absl::StrFormat("/proc/%d/maps", pid)));
+  std::vector<ExecutableMapping> result;
+  const std::vector<std::string> lines = absl::StrSplit(maps, '\n', absl::SkipEmpty());
+  for (const auto& line : lines) {
+    const std::vector<std::string> tokens = absl::StrSplit(line, ' ', absl::SkipEmpty());
+    if (tokens.size() < 6 || tokens[1].size() != 4 || tokens[1][2] != 'x') continue;
+    const std::vector<std::string> addresses = absl::StrSplit(tokens[0], '-');
+    if (addresses.size() != 2) continue;
+    ExecutableMapping mapping;
+    if (!safe_strtou64_base(addresses[0], &mapping.address_range.start, 16) ||
+        !safe_strtou64_base(addresses[1], &mapping.address_range.end, 16) ||
+        !safe_strtou64_base(tokens[2], &mapping.offset, 16)) {
+      continue;
+    }
+    mapping.file_path = absl::StrJoin(tokens.begin() + 5, tokens.end(), " ");
+    result.push_back(std::move(mapping));
+  }
+  return result;
+}
+
+[[nodiscard]] const ExecutableMapping* FindMappingContainingFileOffset(
+    const std::vector<ExecutableMapping>& mappings, const std::string& file_path,
+    uint64_t file_offset) {
+  for (const ExecutableMapping& mapping : mappings) {
+    if (mapping.file_path != file_path || file_offset < mapping.offset ||
+        file_offset - mapping.offset >= mapping.address_range.end - mapping.address_range.start) {
+      continue;
+    }
+    return &mapping;
+  }
+  return nullptr;
+}
+
+// The return address of an instrumented function points to the return trampoline while the function
+// executes, so an exception can't be unwound through it. Functions in modules that catch exceptions
+// or run cleanups while exceptions propagate are therefore not instrumented.
+[[nodiscard]] bool MayUnwindExceptions(const std::string& file_path) {
+  ErrorMessageOr<std::unique_ptr<orbit_elf_utils::ElfFile>> elf_file =
+      orbit_elf_utils::ElfFile::Create(file_path);
+  return elf_file.has_error() || elf_file.value()->HasGccExceptTable();
+}
+
+}  // namespace
+
+// The state of the user space instrumentation in one process: the addresses of the payloads in the
+// injected library, the trampolines and the currently instrumented functions.
+class InstrumentedProcess {
+ public:
+  // Injects the payload library into process `pid`, initializes it to send its events to the
+  // producer side channel at `producer_side_unix_domain_socket_path` and creates the return
+  // trampoline. Assumes we are already attached to the tracee `pid`.
+  [[nodiscard]] static ErrorMessageOr<std::unique_ptr<InstrumentedProcess>> Create(
+      pid_t pid, std::string_view producer_side_unix_domain_socket_path);
+
+  // Returns false if the process ended (and its pid might have been reused) since the payload
+  // library was injected.
+  [[nodiscard]] bool IsPayloadLibraryLoaded() const;
+
+  // Instruments the functions in `capture_options` and returns the ids of the functions that were
+  // instrumented. Assumes we are already attached to the tracee.
+  [[nodiscard]] ErrorMessageOr<absl::flat_hash_set<uint64_t>> InstrumentFunctions(
+      const CaptureOptions& capture_options);
+
+  // Restores the beginnings of all instrumented functions. Assumes we are already attached to the
+  // tracee.
+  [[nodiscard]] ErrorMessageOr<void> UninstrumentFunctions();
+
+ private:
+  struct FunctionToInstrument {
+    uint64_t function_id;
+    uint64_t address;
+    uint64_t size;
+  };
+
+  // Trampolines are placed in chunks of memory within reach of a 32 bit offset from the code of
+  // the module.
+  struct TrampolineMemoryChunk {
+    uint64_t address = 0;
+    uint64_t size = 0;
+    uint64_t used = 0;
+  };
+
+  explicit InstrumentedProcess(pid_t pid) : pid_{pid} {}
+
+  // Makes sure the current chunk of trampoline memory for `code_range` has room for
+  // `num_trampolines` trampolines.
+  [[nodiscard]] ErrorMessageOr<void> ReserveTrampolineMemory(const AddressRange& code_range,
+                                                             uint64_t num_trampolines);
+
+  [[nodiscard]] ErrorMessageOr<void> InstrumentFunction(
+      const FunctionToInstrument& function, const AddressRange& code_range, csh capstone_handle,
+      absl::flat_hash_map<uint64_t, uint64_t>& relocation_map);
+
+  pid_t pid_;
+  uint64_t entry_payload_function_address_ = 0;
+  uint64_t exit_payload_function_address_ = 0;
+  uint64_t return_trampoline_address_ = 0;
+
+  // Keyed by the start address of the code range.
+  absl::flat_hash_map<uint64_t, TrampolineMemoryChunk> trampoline_memory_;
+  // Trampolines are kept when a function gets uninstrumented and reused when it gets instrumented
+  // again. Maps function address to trampoline address.
+  absl::flat_hash_map<uint64_t, uint64_t> trampoline_map_;
+  // Maps the address of each instrumented function to the bytes overwritten by the jump into the
+  // trampoline.
+  absl::flat_hash_map<uint64_t, std::vector<uint8_t>> original_bytes_;
+};
+
+ErrorMessageOr<std::unique_ptr<InstrumentedProcess>> InstrumentedProcess::Create(
+    pid_t pid, std::string_view producer_side_unix_domain_socket_path) {
+  std::unique_ptr<InstrumentedProcess> process{new InstrumentedProcess(pid)};
+  OUTCOME_TRY(library_handle, DlopenInTracee(pid, GetLibraryPath(), RTLD_NOW));
+  OUTCOME_TRY(entry_payload_function_address,
+              DlsymInTracee(pid, library_handle, kEntryPayloadFunctionName));
+  process->entry_payload_function_address_ =
+      absl::bit_cast<uint64_t>(entry_payload_function_address);
+  OUTCOME_TRY(exit_payload_function_address,
+              DlsymInTracee(pid, library_handle, kExitPayloadFunctionName));
+  process->exit_payload_function_address_ =
+      absl::bit_cast<uint64_t>(exit_payload_function_address);
+  OUTCOME_TRY(initialize_instrumentation_function_address,
+              DlsymInTracee(pid, library_handle, kInitializeInstrumentationFunctionName));
+  OUTCOME_TRY(CallFunctionWithStringInTracee(pid, initialize_instrumentation_function_address,
+                                             producer_side_unix_domain_socket_path));
+
+  // The entry payload writes the absolute address of the return trampoline into the stack, so it
+  // can be placed anywhere.
+  OUTCOME_TRY(return_trampoline_address, AllocateInTracee(pid, 0, GetReturnTrampolineSize()));
+  process->return_trampoline_address_ = return_trampoline_address;
+  OUTCOME_TRY(CreateReturnTrampoline(pid, process->exit_payload_function_address_,
+                                     process->return_trampoline_address_));
+  return process;
+}
+
+bool InstrumentedProcess::IsPayloadLibraryLoaded() const {
+  ErrorMessageOr<std::string> maps =
+      orbit_base::ReadFileToString(absl::StrFormat("/proc/%d/maps", pid_));
+  return maps.has_value() && absl::StrContains(maps.value(), kLibName);
+}
+
+ErrorMessageOr<void> InstrumentedProcess::ReserveTrampolineMemory(const AddressRange& code_range,
+                                                                  uint64_t num_trampolines) {
+  const uint64_t size_needed = num_trampolines * GetMaxTrampolineSize();
+  TrampolineMemoryChunk& chunk = trampoline_memory_[code_range.start];
+  if (chunk.size - chunk.used >= size_needed) return outcome::success();
+
+  // The rest of the current chunk is not used anymore.
+  const uint64_t page_size = sysconf(_SC_PAGE_SIZE);
+  const uint64_t chunk_size = (size_needed + page_size - 1) / page_size * page_size;
+  OUTCOME_TRY(address, AllocateMemoryForTrampolines(pid_, code_range, chunk_size));
+  chunk = {address, chunk_size, 0};
+  return outcome::success();
+}
+
+ErrorMessageOr<void> InstrumentedProcess::InstrumentFunction(
+    const FunctionToInstrument& function, const AddressRange& code_range, csh capstone_handle,
+    absl::flat_hash_map<uint64_t, uint64_t>& relocation_map) {
+  OUTCOME_TRY(function_code, ReadTraceesMemory(pid_, function.address, function.size));
+  function_code.resize(function.size);
+
+  // The function id is part of the trampoline, so an existing trampoline is rewritten in place.
+  const auto existing_trampoline = trampoline_map_.find(function.address);
+  const bool is_new_trampoline = existing_trampoline == trampoline_map_.end();
+  TrampolineMemoryChunk& chunk = trampoline_memory_[code_range.start];
+  const uint64_t trampoline_address =
+      is_new_trampoline ? chunk.address + chunk.used : existing_trampoline->second;
+  OUTCOME_TRY(CreateTrampoline(pid_, function.address, function_code, trampoline_address,
+                               entry_payload_function_address_, return_trampoline_address_,
+                               function.function_id, capstone_handle, relocation_map));
+  if (is_new_trampoline) {
+    chunk.used += GetMaxTrampolineSize();
+    trampoline_map_.emplace(function.address, trampoline_address);
+  }
+
+  OUTCOME_TRY(original_bytes,
+              orbit_user_space_instrumentation::InstrumentFunction(pid_, function.address,
+                                                                   trampoline_address));
+  original_bytes_.emplace(function.address, std::move(original_bytes));
+  return outcome::success();
+}
+
+ErrorMessageOr<absl::flat_hash_set<uint64_t>> InstrumentedProcess::InstrumentFunctions(
+    const CaptureOptions& capture_options) {
+  OUTCOME_TRY(mappings, ReadExecutableMappings(pid_));
+  absl::flat_hash_map<const ExecutableMapping*, std::vector<FunctionToInstrument>>
+      functions_by_mapping;
+  for (const InstrumentedFunction& function : capture_options.instrumented_functions()) {
+    // Functions with special semantics are left to uprobes, and so are functions of unknown size.
+    if (function.function_type() != InstrumentedFunction::kRegular ||
+        function.function_size() == 0 || function.function_size() > kMaxFunctionSize) {
+      continue;
+    }
+    const ExecutableMapping* mapping =
+        FindMappingContainingFileOffset(mappings, function.file_path(), function.file_offset());
+    if (mapping == nullptr) continue;
+    const uint64_t address =
+        mapping->address_range.start + function.file_offset() - mapping->offset;
+    functions_by_mapping[mapping].push_back(
+        {function.function_id(), address, function.function_size()});
+  }
+
+  csh temp_handle;
+  if (cs_open(CS_ARCH_X86, CS_MODE_64, &temp_handle) != CS_ERR_OK) {
+    return ErrorMessage("Unable to open capstone.");
+  }
+  orbit_base::unique_resource capstone_handle{temp_handle, [](csh handle) { cs_close(&handle); }};
+  cs_option(capstone_handle, CS_OPT_DETAIL, CS_OPT_ON);
+
+  absl::flat_hash_set<uint64_t> instrumented_function_ids;
+  absl::flat_hash_map<uint64_t, uint64_t> relocation_map;
+  for (const auto& [mapping, functions] : functions_by_mapping) {
+    if (MayUnwindExceptions(mapping->file_path)) {
+      LOG("Falling back to uprobes for the functions in \"%s\": exceptions might be unwound "
+          "through them",
+          mapping->file_path);
+      continue;
+    }
+    uint64_t num_new_trampolines = 0;
+    for (const FunctionToInstrument& function : functions) {
+      if (!trampoline_map_.contains(function.address)) ++num_new_trampolines;
+    }
+    ErrorMessageOr<void> reserve_result =
+        ReserveTrampolineMemory(mapping->address_range, num_new_trampolines);
+    if (reserve_result.has_error()) {
+      ERROR("Unable to allocate memory for trampolines for \"%s\": %s", mapping->file_path,
+            reserve_result.error().message());
+      continue;
+    }
+
+    for (const FunctionToInstrument& function : functions) {
+      if (original_bytes_.contains(function.address)) continue;
+      ErrorMessageOr<void> result =
+          InstrumentFunction(function, mapping->address_range, capstone_handle, relocation_map);
+      if (result.has_error()) {
+        LOG("Falling back to uprobes for function at %#x in \"%s\": %s", function.address,
+            mapping->file_path, result.error().message());
+        continue;
+      }
+      instrumented_function_ids.insert(function.function_id);
+    }
+  }
+
+  ErrorMessageOr<void> move_result =
+      MoveInstructionPointersOutOfOverwrittenCode(pid_, relocation_map);
+  if (move_result.has_error()) {
+    OUTCOME_TRY(UninstrumentFunctions());
+    return move_result.error();
+  }
+  return instrumented_function_ids;
+}
+
+ErrorMessageOr<void> InstrumentedProcess::UninstrumentFunctions() {
+  ErrorMessageOr<void> result = outcome::success();
+  for (const auto& [function_address, original_bytes] : original_bytes_) {
+    ErrorMessageOr<void> write_result = WriteTraceesMemory(pid_, function_address, original_bytes);
+    if (write_result.has_error()) {
+      ERROR("Unable to restore function at %#x: %s", function_address,
+            write_result.error().message());
+      result = write_result.error();
+    }
+  }
+  original_bytes_.clear();
+  return result;
+}
+
+std::unique_ptr<InstrumentationManager> InstrumentationManager::Create() {
+  return Create(std::string(orbit_producer_side_channel::kProducerSideUnixDomainSocketPath));
+}
+
+std::unique_ptr<InstrumentationManager> InstrumentationManager::Create(
+    std::string producer_side_unix_domain_socket_path) {
+  return std::unique_ptr<InstrumentationManager>(
+      new InstrumentationManager(std::move(producer_side_unix_domain_socket_path)));
+}
+
+InstrumentationManager::InstrumentationManager(std::string producer_side_unix_domain_socket_path)
+    : producer_side_unix_domain_socket_path_{std::move(producer_side_unix_domain_socket_path)} {}
+
+InstrumentationManager::~InstrumentationManager() = default;
+
+ErrorMessageOr<absl::flat_hash_set<uint64_t>> InstrumentationManager::InstrumentProcess(
+    const CaptureOptions& capture_options) {
+  const pid_t pid = capture_options.pid();
+
+  // Forget about processes that ended.
+  for (auto it = process_map_.begin(); it != process_map_.end();) {
+    std::error_code error;
+    if (!std::filesystem::exists(absl::StrFormat("/proc/%d", it->first), error)) {
+      process_map_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+
+  OUTCOME_TRY(AttachAndStopProcess(pid));
+  ErrorMessageOr<absl::flat_hash_set<uint64_t>> result =
+      [&]() -> ErrorMessageOr<absl::flat_hash_set<uint64_t>> {
+    auto it = process_map_.find(pid);
+    if (it == process_map_.end() || !it->second->IsPayloadLibraryLoaded()) {
+      OUTCOME_TRY(process,
+                  InstrumentedProcess::Create(pid, producer_side_unix_domain_socket_path_));
+      it = process_map_.insert_or_assign(pid, std::move(process)).first;
+    }
+    return it->second->InstrumentFunctions(capture_options);
+  }();
+  OUTCOME_TRY(DetachAndContinueProcess(pid));
+  return result;
+}
+
+ErrorMessageOr<void> InstrumentationManager::UninstrumentProcess(pid_t pid) {
+  auto it = process_map_.find(pid);
+  if (it == process_map_.end()) return outcome::success();
+
+  OUTCOME_TRY(AttachAndStopProcess(pid));
+  ErrorMessageOr<void> result = it->second->UninstrumentFunctions();
+  OUTCOME_TRY(DetachAndContinueProcess(pid));
+  return result;
+}
+
+}  // namespace orbit_user_space_instrumentation
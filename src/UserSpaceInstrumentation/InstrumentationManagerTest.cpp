@@ -0,0 +1,213 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+#include <dlfcn.h>
+#include <gmock/gmock.h>
+#include <grpcpp/grpcpp.h>
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "ElfUtils/ElfFile.h"
+#include "OrbitBase/ExecutablePath.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Result.h"
+#include "OrbitProducer/FakeProducerSideService.h"
+#include "UserSpaceInstrumentation/InstrumentationManager.h"
+#include "capture.pb.h"
+#include "symbol.pb.h"
+
+namespace orbit_user_space_instrumentation {
+
+namespace {
+
+using orbit_grpc_protos::CaptureOptions;
+using orbit_grpc_protos::FunctionCall;
+using orbit_grpc_protos::InstrumentedFunction;
+using orbit_grpc_protos::ModuleSymbols;
+using orbit_grpc_protos::ProducerCaptureEvent;
+using orbit_grpc_protos::SymbolInfo;
+
+constexpr uint64_t kFunctionId = 42;
+constexpr const char* kTestLibName = "libUserSpaceInstrumentationTestLib.so";
+constexpr const char* kFunctionName = "TripleAndDecrement";
+
+// The path of the test library as it appears in /proc/pid/maps.
+std::filesystem::path GetTestLibPath() {
+  return std::filesystem::canonical(orbit_base::GetExecutableDir() / ".." / "lib" / kTestLibName);
+}
+
+// Forks a child that loads the test library and calls `TripleAndDecrement` in an endless loop. The
+// child exits if the function ever returns a wrong result. Returns when the library is loaded.
+pid_t ForkChildCallingTripleAndDecrement() {
+  int pipe_fds[2];
+  CHECK(pipe(pipe_fds) == 0);
+  pid_t pid = fork();
+  CHECK(pid != -1);
+  if (pid == 0) {
+    close(pipe_fds[0]);
+    void* library_handle = dlopen(GetTestLibPath().c_str(), RTLD_NOW);
+    if (library_handle == nullptr) exit(1);
+    auto* triple_and_decrement =
+        reinterpret_cast<int (*)(int)>(dlsym(library_handle, kFunctionName));
+    if (triple_and_decrement == nullptr) exit(1);
+    const char loaded = 1;
+    if (write(pipe_fds[1], &loaded, sizeof(loaded)) != sizeof(loaded)) exit(1);
+    int i = 0;
+    while (true) {
+      i = (i + 1) & 0xff;
+      if (triple_and_decrement(i) != 3 * i - 1) exit(1);
+    }
+  }
+  close(pipe_fds[1]);
+  char loaded = 0;
+  CHECK(read(pipe_fds[0], &loaded, sizeof(loaded)) == sizeof(loaded));
+  close(pipe_fds[0]);
+  return pid;
+}
+
+// Returns capture options for process `pid` with `TripleAndDecrement` as instrumented function.
+CaptureOptions CreateCaptureOptions(pid_t pid) {
+  const std::filesystem::path library_path = GetTestLibPath();
+  auto elf_file = orbit_elf_utils::ElfFile::Create(library_path);
+  CHECK(elf_file.has_value());
+  ErrorMessageOr<ModuleSymbols> symbols = elf_file.value()->LoadSymbolsFromDynsym();
+  CHECK(symbols.has_value());
+  const SymbolInfo* symbol = nullptr;
+  for (const SymbolInfo& symbol_info : symbols.value().symbol_infos()) {
+    if (symbol_info.name() == kFunctionName) symbol = &symbol_info;
+  }
+  CHECK(symbol != nullptr);
+
+  CaptureOptions capture_options;
+  capture_options.set_pid(pid);
+  InstrumentedFunction* instrumented_function = capture_options.add_instrumented_functions();
+  instrumented_function->set_file_path(library_path.string());
+  instrumented_function->set_file_offset(symbol->address() - symbols.value().load_bias());
+  instrumented_function->set_function_id(kFunctionId);
+  instrumented_function->set_function_size(symbol->size());
+  return capture_options;
+}
+
+void KillChild(pid_t pid) {
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+}
+
+}  // namespace
+
+TEST(InstrumentationManagerTest, InstrumentAndUninstrument) {
+  const pid_t pid = ForkChildCallingTripleAndDecrement();
+  const CaptureOptions capture_options = CreateCaptureOptions(pid);
+
+  // Instrument twice to also cover reusing the payload library and the trampoline.
+  std::unique_ptr<InstrumentationManager> instrumentation_manager =
+      InstrumentationManager::Create();
+  for (int i = 0; i < 2; ++i) {
+    auto instrumented_function_ids = instrumentation_manager->InstrumentProcess(capture_options);
+    ASSERT_TRUE(instrumented_function_ids.has_value())
+        << instrumented_function_ids.error().message();
+    EXPECT_TRUE(instrumented_function_ids.value().contains(kFunctionId));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    ErrorMessageOr<void> result = instrumentation_manager->UninstrumentProcess(pid);
+    ASSERT_FALSE(result.has_error()) << result.error().message();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  // The child is still running: it neither crashed nor observed a wrong result.
+  EXPECT_EQ(waitpid(pid, nullptr, WNOHANG), 0);
+
+  KillChild(pid);
+}
+
+TEST(InstrumentationManagerTest, SendsFunctionCallsOfInstrumentedFunction) {
+  const pid_t pid = ForkChildCallingTripleAndDecrement();
+  const CaptureOptions capture_options = CreateCaptureOptions(pid);
+
+  // Plays the role of OrbitService, which receives the events of the payload library.
+  const std::string socket_path =
+      absl::StrFormat("/tmp/orbit-user-space-instrumentation-test-%d", getpid());
+  orbit_producer::FakeProducerSideService fake_service;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(absl::StrFormat("unix:%s", socket_path),
+                           grpc::InsecureServerCredentials());
+  builder.RegisterService(&fake_service);
+  std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+  ASSERT_NE(server, nullptr);
+
+  absl::Mutex mutex;
+  std::vector<FunctionCall> function_calls;
+  bool all_events_sent = false;
+  EXPECT_CALL(fake_service, OnCaptureEventsReceived)
+      .WillRepeatedly([&](const std::vector<ProducerCaptureEvent>& events) {
+        absl::MutexLock lock(&mutex);
+        for (const ProducerCaptureEvent& event : events) {
+          if (event.has_function_call()) function_calls.push_back(event.function_call());
+        }
+      });
+  EXPECT_CALL(fake_service, OnAllEventsSentReceived).Times(1).WillOnce([&]() {
+    absl::MutexLock lock(&mutex);
+    all_events_sent = true;
+  });
+
+  std::unique_ptr<InstrumentationManager> instrumentation_manager =
+      InstrumentationManager::Create(socket_path);
+  auto instrumented_function_ids = instrumentation_manager->InstrumentProcess(capture_options);
+  ASSERT_TRUE(instrumented_function_ids.has_value())
+      << instrumented_function_ids.error().message();
+  EXPECT_TRUE(instrumented_function_ids.value().contains(kFunctionId));
+
+  // Leave some time for the producer of the payload library to connect.
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  fake_service.SendStartCaptureCommand(capture_options);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  fake_service.SendStopCaptureCommand();
+  {
+    absl::MutexLock lock(&mutex);
+    EXPECT_TRUE(mutex.AwaitWithTimeout(absl::Condition(&all_events_sent), absl::Seconds(5)));
+  }
+
+  ErrorMessageOr<void> result = instrumentation_manager->UninstrumentProcess(pid);
+  EXPECT_FALSE(result.has_error()) << result.error().message();
+  EXPECT_EQ(waitpid(pid, nullptr, WNOHANG), 0);
+  KillChild(pid);
+
+  fake_service.FinishAndDisallowRpc();
+  server->Shutdown();
+  server->Wait();
+  std::error_code error;
+  std::filesystem::remove(socket_path, error);
+
+  absl::MutexLock lock(&mutex);
+  ASSERT_FALSE(function_calls.empty());
+  for (const FunctionCall& function_call : function_calls) {
+    EXPECT_EQ(function_call.pid(), pid);
+    EXPECT_EQ(function_call.tid(), pid);
+    EXPECT_EQ(function_call.function_id(), kFunctionId);
+    EXPECT_EQ(function_call.depth(), 0);
+    EXPECT_LE(function_call.duration_ns(), function_call.end_timestamp_ns());
+    // The child calls the function with arguments from 1 to 255.
+    const auto return_value = static_cast<int32_t>(function_call.return_value());
+    EXPECT_GE(return_value, 2);
+    EXPECT_LE(return_value, 3 * 255 - 1);
+    EXPECT_EQ((return_value + 1) % 3, 0);
+  }
+}
+
+}  // namespace orbit_user_space_instrumentation
@@ -0,0 +1,128 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "OrbitUserSpaceInstrumentation.h"
+
+#include <absl/base/casts.h>
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
+#include "OrbitBase/ThreadUtils.h"
+#include "OrbitProducer/LockFreeBufferCaptureEventProducer.h"
+#include "ProducerSideChannel/ProducerSideChannel.h"
+#include "capture.pb.h"
+
+namespace {
+
+struct FunctionCallEvent {
+  pid_t pid;
+  pid_t tid;
+  uint64_t function_id;
+  uint64_t timestamp_on_entry_ns;
+  uint64_t timestamp_on_exit_ns;
+  int32_t depth;
+  uint64_t return_value;
+};
+
+// Relays the function calls recorded by the payloads to OrbitService.
+class LockFreeUserSpaceInstrumentationEventProducer
+    : public orbit_producer::LockFreeBufferCaptureEventProducer<FunctionCallEvent> {
+ public:
+  explicit LockFreeUserSpaceInstrumentationEventProducer(
+      std::string_view producer_side_unix_domain_socket_path) {
+    BuildAndStart(orbit_producer_side_channel::CreateProducerSideChannel(
+        producer_side_unix_domain_socket_path));
+  }
+
+  ~LockFreeUserSpaceInstrumentationEventProducer() { ShutdownAndWait(); }
+
+ protected:
+  [[nodiscard]] orbit_grpc_protos::ProducerCaptureEvent* TranslateIntermediateEvent(
+      FunctionCallEvent&& raw_event, google::protobuf::Arena* arena) override {
+    auto* capture_event =
+        google::protobuf::Arena::CreateMessage<orbit_grpc_protos::ProducerCaptureEvent>(arena);
+    auto* function_call = capture_event->mutable_function_call();
+    function_call->set_pid(raw_event.pid);
+    function_call->set_tid(raw_event.tid);
+    function_call->set_function_id(raw_event.function_id);
+    function_call->set_duration_ns(raw_event.timestamp_on_exit_ns -
+                                   raw_event.timestamp_on_entry_ns);
+    function_call->set_end_timestamp_ns(raw_event.timestamp_on_exit_ns);
+    function_call->set_depth(raw_event.depth);
+    function_call->set_return_value(raw_event.return_value);
+    return capture_event;
+  }
+};
+
+// Created by InitializeInstrumentation when the library gets injected, before any function is
+// instrumented, so that the payloads never create it (and its thread and gRPC channel) on a thread
+// of the target that just entered an instrumented function.
+std::unique_ptr<LockFreeUserSpaceInstrumentationEventProducer> capture_event_producer;
+
+struct OpenFunctionCall {
+  uint64_t return_address;
+  uint64_t function_id;
+  uint64_t timestamp_on_entry_ns;
+};
+
+// The functions entered by this thread that did not return yet. The initial-exec model keeps the
+// payloads from calling into the dynamic linker to access the thread local variables.
+thread_local std::vector<OpenFunctionCall> open_function_calls
+    __attribute__((tls_model("initial-exec")));
+
+// Guards against recursion: functions called by the payloads themselves (e.g. malloc) could be
+// instrumented as well.
+thread_local bool is_in_payload __attribute__((tls_model("initial-exec"))) = false;
+
+}  // namespace
+
+void InitializeInstrumentation(const char* producer_side_unix_domain_socket_path) {
+  if (capture_event_producer != nullptr) return;
+  capture_event_producer = std::make_unique<LockFreeUserSpaceInstrumentationEventProducer>(
+      producer_side_unix_domain_socket_path);
+}
+
+void EntryPayload(uint64_t return_address_location, uint64_t function_id,
+                  uint64_t return_trampoline_address) {
+  if (is_in_payload) return;
+  is_in_payload = true;
+
+  if (capture_event_producer != nullptr && capture_event_producer->IsCapturing()) {
+    auto* return_address = absl::bit_cast<uint64_t*>(return_address_location);
+    open_function_calls.push_back(
+        {*return_address, function_id, orbit_base::CaptureTimestampNs()});
+    *return_address = return_trampoline_address;
+  }
+
+  is_in_payload = false;
+}
+
+uint64_t ExitPayload(uint64_t return_value) {
+  const uint64_t timestamp_on_exit_ns = orbit_base::CaptureTimestampNs();
+  CHECK(!open_function_calls.empty());
+  const OpenFunctionCall function_call = open_function_calls.back();
+  open_function_calls.pop_back();
+
+  const bool was_in_payload = is_in_payload;
+  is_in_payload = true;
+
+  static pid_t pid = orbit_base::GetCurrentProcessId();
+  thread_local pid_t tid = orbit_base::GetCurrentThreadId();
+  capture_event_producer->EnqueueIntermediateEventIfCapturing([&] {
+    return FunctionCallEvent{pid,
+                             tid,
+                             function_call.function_id,
+                             function_call.timestamp_on_entry_ns,
+                             timestamp_on_exit_ns,
+                             static_cast<int32_t>(open_function_calls.size()),
+                             return_value};
+  });
+
+  is_in_payload = was_in_payload;
+  return function_call.return_address;
+}
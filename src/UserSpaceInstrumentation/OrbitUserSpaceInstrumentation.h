@@ -0,0 +1,31 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef USER_SPACE_INSTRUMENTATION_ORBIT_USER_SPACE_INSTRUMENTATION_H_
+#define USER_SPACE_INSTRUMENTATION_ORBIT_USER_SPACE_INSTRUMENTATION_H_
+
+#include <cstdint>
+
+// The payload functions called by the trampolines of functions instrumented in user space (compare
+// `CreateTrampoline` and `CreateReturnTrampoline` in Trampoline.h). The library built from this
+// code gets injected into the target process by `InstrumentationManager`. The payloads record the
+// function calls and send them to OrbitService as FunctionCall events.
+
+// Called once by `InstrumentationManager` right after injecting the library, before any function
+// gets instrumented. Creates the producer that sends the events to OrbitService over the Unix
+// domain socket at `producer_side_unix_domain_socket_path`.
+extern "C" void InitializeInstrumentation(const char* producer_side_unix_domain_socket_path);
+
+// Called on entry of the function with id `function_id`. `return_address_location` is the address
+// of the return address of the function on the stack. If a capture is running, the payload
+// remembers the return address and replaces it by `return_trampoline_address` such that
+// `ExitPayload` gets called when the function returns.
+extern "C" void EntryPayload(uint64_t return_address_location, uint64_t function_id,
+                             uint64_t return_trampoline_address);
+
+// Called by the return trampoline when a function recorded by `EntryPayload` returns.
+// `return_value` is the content of rax. Returns the original return address of the function.
+extern "C" uint64_t ExitPayload(uint64_t return_value);
+
+#endif  // USER_SPACE_INSTRUMENTATION_ORBIT_USER_SPACE_INSTRUMENTATION_H_
@@ -7,21 +7,308 @@
 #include <absl/strings/numbers.h>
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_split.h>
+#include <cpuid.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 
+#include "AccessTraceesMemory.h"
 #include "AllocateInTracee.h"
+#include "MachineCode.h"
 #include "OrbitBase/ExecuteCommand.h"
+#include "OrbitBase/GetProcessIds.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ReadFileToString.h"
+#include "RegisterState.h"
 
 namespace orbit_user_space_instrumentation {
 
 using absl::numbers_internal::safe_strtou64_base;
 using orbit_base::ReadFileToString;
 
+namespace {
+
+// The beginning of an instrumented function is overwritten by a relative jump with a 32 bit offset
+// into the trampoline.
+constexpr uint64_t kSizeOfJmpRel32 = 5;
+
+// The jump into the trampoline overwrites at most five instructions. A relocated instruction takes
+// at most 16 bytes (compare `RelocateInstruction`).
+constexpr uint64_t kMaxRelocatedPrologueSize = kSizeOfJmpRel32 * 16;
+
+constexpr uint64_t kTrampolineAlignment = 16;
+
+// The trampolines save the general purpose registers used for passing parameters to a function:
+// rax (number of vector registers used for varargs), rcx, rdx, rsi, rdi, r8, r9, r10 (static chain
+// pointer) and r11 (scratch register that might be used by e.g. the plt).
+constexpr uint64_t kNumSavedGeneralPurposeRegisters = 9;
+
+// The payloads are regular compiled code that may use any vector register, and arguments and return
+// values are also passed in the upper halves of the ymm and zmm registers (__m256, __m512) and on
+// the x87 register stack (long double). So the trampolines save the complete x87, SSE, AVX and
+// AVX-512 state with xsave (fxsave on processors without xsave, which have neither AVX nor
+// AVX-512). These are the state components requested from xsave: x87, SSE, AVX, opmask, ZMM_Hi256
+// and Hi16_ZMM.
+constexpr uint32_t kXsaveStateComponents = 0xe7;
+// Size of the legacy region and the header of the xsave area, which is also the size of the fxsave
+// area. The header immediately follows the legacy region.
+constexpr uint32_t kXsaveLegacyRegionSize = 512;
+constexpr uint32_t kXsaveHeaderSize = 64;
+constexpr uint8_t kXsaveAreaAlignment = 64;
+
+struct ExtendedStateSaveArea {
+  bool use_xsave = false;
+  uint32_t size = 0;
+};
+
+// Returns how the trampolines save the extended processor state on this machine, and the size of
+// the save area (a multiple of its alignment). The tracee runs on the same machine as OrbitService.
+[[nodiscard]] const ExtendedStateSaveArea& GetExtendedStateSaveArea() {
+  static const ExtendedStateSaveArea kSaveArea = []() {
+    ExtendedStateSaveArea save_area{false, kXsaveLegacyRegionSize};
+    uint32_t eax = 0;
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0 || (ecx & bit_OSXSAVE) == 0) {
+      return save_area;
+    }
+    save_area.use_xsave = true;
+    save_area.size = kXsaveLegacyRegionSize + kXsaveHeaderSize;
+    // Leaf 0xd, sub-leaf 0 lists the state components supported by the processor in eax, sub-leaf
+    // i the size (eax) and the offset (ebx) of component i in the standard format.
+    __get_cpuid_count(0xd, 0, &eax, &ebx, &ecx, &edx);
+    const uint32_t supported_state_components = eax & kXsaveStateComponents;
+    for (uint32_t component = 2; component < 8; ++component) {
+      if ((supported_state_components & (1u << component)) == 0) continue;
+      uint32_t component_size = 0;
+      uint32_t component_offset = 0;
+      __get_cpuid_count(0xd, component, &component_size, &component_offset, &ecx, &edx);
+      save_area.size = std::max(save_area.size, component_offset + component_size);
+    }
+    save_area.size =
+        (save_area.size + kXsaveAreaAlignment - 1) / kXsaveAreaAlignment * kXsaveAreaAlignment;
+    return save_area;
+  }();
+  return kSaveArea;
+}
+
+// Appends the machine code to save the extended processor state (see `GetExtendedStateSaveArea`)
+// below the stack pointer, and leaves the stack pointer at the save area. Overwrites rax and rdx,
+// so these need to be backed up before. Xsave leaves the bits of the header of the save area that
+// belong to components not saved untouched, and xrstor faults on unexpected bits in the header, so
+// the header is cleared first.
+// and rsp, 0xffffffffffffffc0                  48 83 e4 c0
+// sub rsp, save_area_size                      48 81 ec save_area_size
+// with xsave:
+//   mov qword ptr [rsp + 0x200], 0             48 c7 84 24 00 02 00 00 00 00 00 00
+//   ...
+//   mov qword ptr [rsp + 0x238], 0             48 c7 84 24 38 02 00 00 00 00 00 00
+//   mov eax, kXsaveStateComponents             b8 kXsaveStateComponents
+//   xor edx, edx                               31 d2
+//   xsave64 [rsp]                              48 0f ae 24 24
+// without xsave:
+//   fxsave64 [rsp]                             48 0f ae 04 24
+void AppendSaveExtendedState(MachineCode& code) {
+  const ExtendedStateSaveArea& save_area = GetExtendedStateSaveArea();
+  code.AppendBytes({0x48, 0x83, 0xe4, static_cast<uint8_t>(-kXsaveAreaAlignment)})
+      .AppendBytes({0x48, 0x81, 0xec})
+      .AppendImmediate32(save_area.size);
+  if (!save_area.use_xsave) {
+    code.AppendBytes({0x48, 0x0f, 0xae, 0x04, 0x24});
+    return;
+  }
+  for (uint32_t offset = 0; offset < kXsaveHeaderSize; offset += sizeof(uint64_t)) {
+    code.AppendBytes({0x48, 0xc7, 0x84, 0x24})
+        .AppendImmediate32(kXsaveLegacyRegionSize + offset)
+        .AppendImmediate32(0);
+  }
+  code.AppendBytes({0xb8})
+      .AppendImmediate32(kXsaveStateComponents)
+      .AppendBytes({0x31, 0xd2})
+      .AppendBytes({0x48, 0x0f, 0xae, 0x24, 0x24});
+}
+
+// Appends the machine code to restore the extended processor state saved by
+// `AppendSaveExtendedState`. The stack pointer needs to point to the save area. Overwrites rax and
+// rdx.
+// with xsave:
+//   mov eax, kXsaveStateComponents             b8 kXsaveStateComponents
+//   xor edx, edx                               31 d2
+//   xrstor64 [rsp]                             48 0f ae 2c 24
+// without xsave:
+//   fxrstor64 [rsp]                            48 0f ae 0c 24
+void AppendRestoreExtendedState(MachineCode& code) {
+  if (!GetExtendedStateSaveArea().use_xsave) {
+    code.AppendBytes({0x48, 0x0f, 0xae, 0x0c, 0x24});
+    return;
+  }
+  code.AppendBytes({0xb8})
+      .AppendImmediate32(kXsaveStateComponents)
+      .AppendBytes({0x31, 0xd2})
+      .AppendBytes({0x48, 0x0f, 0xae, 0x2c, 0x24});
+}
+
+// Appends the machine code to back up the frame pointer, the general purpose registers used for
+// passing parameters and the extended processor state. Also aligns the stack pointer as required
+// for calling the payload.
+// push rbp                         55
+// mov rbp, rsp                     48 89 e5
+// push rax                         50
+// push rcx                         51
+// push rdx                         52
+// push rsi                         56
+// push rdi                         57
+// push r8                          41 50
+// push r9                          41 51
+// push r10                         41 52
+// push r11                         41 53
+// (see AppendSaveExtendedState)
+void AppendBackupCode(MachineCode& trampoline) {
+  trampoline.AppendBytes({0x55})
+      .AppendBytes({0x48, 0x89, 0xe5})
+      .AppendBytes({0x50, 0x51, 0x52, 0x56, 0x57})
+      .AppendBytes({0x41, 0x50, 0x41, 0x51, 0x41, 0x52, 0x41, 0x53});
+  AppendSaveExtendedState(trampoline);
+}
+
+// Appends the machine code to call the entry payload. The location of the return address is right
+// above the backed up frame pointer.
+// lea rdi, [rbp + 8]                           48 8d 7d 08
+// mov rsi, function_id                         48 be function_id
+// mov rdx, return_trampoline_address           48 ba return_trampoline_address
+// mov rax, entry_payload_function_address      48 b8 entry_payload_function_address
+// call rax                                     ff d0
+void AppendCallToEntryPayload(uint64_t entry_payload_function_address,
+                              uint64_t return_trampoline_address, uint64_t function_id,
+                              MachineCode& trampoline) {
+  trampoline.AppendBytes({0x48, 0x8d, 0x7d, 0x08})
+      .AppendBytes({0x48, 0xbe})
+      .AppendImmediate64(function_id)
+      .AppendBytes({0x48, 0xba})
+      .AppendImmediate64(return_trampoline_address)
+      .AppendBytes({0x48, 0xb8})
+      .AppendImmediate64(entry_payload_function_address)
+      .AppendBytes({0xff, 0xd0});
+}
+
+// Appends the machine code to restore the registers backed up by `AppendBackupCode`.
+// (see AppendRestoreExtendedState)
+// lea rsp, [rbp - 0x48]            48 8d 65 b8
+// pop r11                          41 5b
+// pop r10                          41 5a
+// pop r9                           41 59
+// pop r8                           41 58
+// pop rdi                          5f
+// pop rsi                          5e
+// pop rdx                          5a
+// pop rcx                          59
+// pop rax                          58
+// pop rbp                          5d
+void AppendRestoreCode(MachineCode& trampoline) {
+  AppendRestoreExtendedState(trampoline);
+  constexpr auto kOffsetOfSavedRegisters =
+      static_cast<int8_t>(-8 * static_cast<int64_t>(kNumSavedGeneralPurposeRegisters));
+  trampoline.AppendBytes({0x48, 0x8d, 0x65, static_cast<uint8_t>(kOffsetOfSavedRegisters)})
+      .AppendBytes({0x41, 0x5b, 0x41, 0x5a, 0x41, 0x59, 0x41, 0x58})
+      .AppendBytes({0x5f, 0x5e, 0x5a, 0x59, 0x58})
+      .AppendBytes({0x5d});
+}
+
+// Appends a relative jump from `address` (the address the jump instruction is placed at) to
+// `target`.
+// jmp rel32                        e9 rel32
+ErrorMessageOr<void> AppendJmpRel32(uint64_t address, uint64_t target, MachineCode& code) {
+  const int64_t offset = static_cast<int64_t>(target - (address + kSizeOfJmpRel32));
+  if (offset > INT32_MAX || offset < INT32_MIN) {
+    return ErrorMessage(absl::StrFormat(
+        "Unable to jump from %#x to %#x with a 32 bit offset.", address, target));
+  }
+  code.AppendBytes({0xe9}).AppendImmediate32(static_cast<uint32_t>(static_cast<int32_t>(offset)));
+  return outcome::success();
+}
+
+// Appends the complete return trampoline. The slot for the original return address is reserved
+// on the stack before anything else; the exit payload returns the original return address and the
+// final `ret` pops it from that slot. The return value of the function can be in rax and rdx, in
+// the vector registers (including the upper halves of ymm0 and zmm0) and in st0 and st1, so these
+// are all backed up. The x87 register stack has to be empty when the exit payload gets called, so
+// it is reinitialized after the state was saved.
+// push rax                                     50
+// push rbp                                     55
+// mov rbp, rsp                                 48 89 e5
+// push rax                                     50
+// push rdx                                     52
+// (see AppendSaveExtendedState)
+// fninit                                       db e3
+// mov rdi, [rbp - 8]                           48 8b 7d f8
+// mov rax, exit_payload_function_address       48 b8 exit_payload_function_address
+// call rax                                     ff d0
+// mov [rbp + 8], rax                           48 89 45 08
+// (see AppendRestoreExtendedState)
+// lea rsp, [rbp - 0x10]                        48 8d 65 f0
+// pop rdx                                      5a
+// pop rax                                      58
+// pop rbp                                      5d
+// ret                                          c3
+void AppendReturnTrampoline(uint64_t exit_payload_function_address, MachineCode& code) {
+  code.AppendBytes({0x50})
+      .AppendBytes({0x55})
+      .AppendBytes({0x48, 0x89, 0xe5})
+      .AppendBytes({0x50, 0x52});
+  AppendSaveExtendedState(code);
+  code.AppendBytes({0xdb, 0xe3})
+      .AppendBytes({0x48, 0x8b, 0x7d, 0xf8})
+      .AppendBytes({0x48, 0xb8})
+      .AppendImmediate64(exit_payload_function_address)
+      .AppendBytes({0xff, 0xd0})
+      .AppendBytes({0x48, 0x89, 0x45, 0x08});
+  AppendRestoreExtendedState(code);
+  code.AppendBytes({0x48, 0x8d, 0x65, 0xf0})
+      .AppendBytes({0x5a, 0x58, 0x5d})
+      .AppendBytes({0xc3});
+}
+
+// Disassembles the complete `function` and checks that there is no relative jump or call targeting
+// the first `kSizeOfJmpRel32` bytes of the function (except for the very first byte which stays a
+// valid instruction boundary).
+ErrorMessageOr<void> CheckForRelativeJumpIntoOverwrittenBytes(uint64_t function_address,
+                                                             const std::vector<uint8_t>& function,
+                                                             csh capstone_handle) {
+  std::unique_ptr<cs_insn, void (*)(cs_insn*)> instruction{
+      cs_malloc(capstone_handle), [](cs_insn* insn) { cs_free(insn, 1); }};
+  const uint8_t* code_pointer = function.data();
+  size_t code_size = function.size();
+  uint64_t disassemble_address = function_address;
+  while (code_size > 0) {
+    if (!cs_disasm_iter(capstone_handle, &code_pointer, &code_size, &disassemble_address,
+                        instruction.get())) {
+      return ErrorMessage(absl::StrFormat("Unable to disassemble function at %#x at offset %#x.",
+                                          function_address,
+                                          disassemble_address - function_address));
+    }
+    if (!cs_insn_group(capstone_handle, instruction.get(), CS_GRP_JUMP) &&
+        !cs_insn_group(capstone_handle, instruction.get(), CS_GRP_CALL)) {
+      continue;
+    }
+    const cs_x86& x86 = instruction->detail->x86;
+    if (x86.op_count != 1 || x86.operands[0].type != X86_OP_IMM) continue;
+    const auto target = static_cast<uint64_t>(x86.operands[0].imm);
+    if (target > function_address && target < function_address + kSizeOfJmpRel32) {
+      return ErrorMessage(absl::StrFormat(
+          "Function at %#x contains a relative jump into its first %u bytes (at %#x).",
+          function_address, kSizeOfJmpRel32, instruction->address));
+    }
+  }
+  return outcome::success();
+}
+
+}  // namespace
+
 bool DoAddressRangesOverlap(const AddressRange& a, const AddressRange& b) {
   return !(b.end <= a.start || b.start >= a.end);
 }
@@ -158,4 +445,198 @@ ErrorMessageOr<uint64_t> AllocateMemoryForTrampolines(pid_t pid, const AddressRa
   return AllocateInTracee(pid, address_range.start, size);
 }
 
+ErrorMessageOr<std::vector<uint8_t>> RelocateInstruction(cs_insn* instruction,
+                                                         uint64_t new_address) {
+  const cs_x86& x86 = instruction->detail->x86;
+  MachineCode result;
+  if ((x86.modrm & 0xc7) == 0x05) {
+    // Rip relative addressing is encoded as mod = 00 and r/m = 101 in the ModR/M byte (compare
+    // "Intel 64 and IA-32 Architectures Software Developer’s Manual, Volume 2", section 2.2.1.6).
+    // The 32 bit displacement directly follows the ModR/M byte and is relative to the address of
+    // the next instruction.
+    const uint64_t target = instruction->address + instruction->size + x86.disp;
+    const int64_t new_displacement =
+        static_cast<int64_t>(target - (new_address + instruction->size));
+    if (new_displacement > INT32_MAX || new_displacement < INT32_MIN) {
+      return ErrorMessage(absl::StrFormat(
+          "While relocating instruction at %#x to %#x: rip relative target %#x is out of reach.",
+          instruction->address, new_address, target));
+    }
+    std::vector<uint8_t> code(instruction->bytes, instruction->bytes + instruction->size);
+    const auto old_displacement = static_cast<int32_t>(x86.disp);
+    for (size_t i = 1; i + sizeof(int32_t) <= code.size(); ++i) {
+      if (code[i - 1] == x86.modrm &&
+          memcmp(code.data() + i, &old_displacement, sizeof(int32_t)) == 0) {
+        const auto displacement = static_cast<int32_t>(new_displacement);
+        memcpy(code.data() + i, &displacement, sizeof(int32_t));
+        return code;
+      }
+    }
+    return ErrorMessage(absl::StrFormat(
+        "While relocating instruction at %#x: unable to locate the displacement.",
+        instruction->address));
+  }
+
+  if (x86.opcode[0] == 0xeb || x86.opcode[0] == 0xe9) {
+    // Relative jump (rel8 or rel32). Jump to the absolute address instead.
+    // jmp [rip + 0]                ff 25 00 00 00 00
+    // .quad target                 8 bytes
+    CHECK(x86.op_count == 1 && x86.operands[0].type == X86_OP_IMM);
+    result.AppendBytes({0xff, 0x25, 0x00, 0x00, 0x00, 0x00})
+        .AppendImmediate64(static_cast<uint64_t>(x86.operands[0].imm));
+    return result.GetResultAsVector();
+  }
+
+  if (x86.opcode[0] == 0xe8) {
+    // Relative call (rel32). Call the absolute address instead; the return address points to the
+    // short jump over the absolute address.
+    // call [rip + 2]               ff 15 02 00 00 00
+    // jmp $ + 10                   eb 08
+    // .quad target                 8 bytes
+    CHECK(x86.op_count == 1 && x86.operands[0].type == X86_OP_IMM);
+    result.AppendBytes({0xff, 0x15, 0x02, 0x00, 0x00, 0x00})
+        .AppendBytes({0xeb, 0x08})
+        .AppendImmediate64(static_cast<uint64_t>(x86.operands[0].imm));
+    return result.GetResultAsVector();
+  }
+
+  if ((x86.opcode[0] & 0xf0) == 0x70 || (x86.opcode[0] == 0x0f && (x86.opcode[1] & 0xf0) == 0x80)) {
+    // Conditional jump (rel8 or rel32). The lowest four bits of the opcode encode the condition,
+    // flipping the lowest bit inverts it. Jump over an absolute jump if the inverted condition is
+    // met.
+    // j!cc $ + 16                  7x 0e
+    // jmp [rip + 0]                ff 25 00 00 00 00
+    // .quad target                 8 bytes
+    CHECK(x86.op_count == 1 && x86.operands[0].type == X86_OP_IMM);
+    const uint8_t condition = (x86.opcode[0] == 0x0f ? x86.opcode[1] : x86.opcode[0]) & 0x0f;
+    result.AppendBytes({static_cast<uint8_t>(0x70 | (condition ^ 0x01)), 0x0e})
+        .AppendBytes({0xff, 0x25, 0x00, 0x00, 0x00, 0x00})
+        .AppendImmediate64(static_cast<uint64_t>(x86.operands[0].imm));
+    return result.GetResultAsVector();
+  }
+
+  if ((x86.opcode[0] & 0xfc) == 0xe0) {
+    // loopne, loope, loop, jrcxz: only rel8 versions exist.
+    return ErrorMessage(absl::StrFormat(
+        "Relocating a loop or jrcxz instruction (at %#x) is not supported.", instruction->address));
+  }
+
+  return std::vector<uint8_t>(instruction->bytes, instruction->bytes + instruction->size);
+}
+
+uint64_t GetMaxTrampolineSize() {
+  static const uint64_t kMaxTrampolineSize = []() {
+    MachineCode trampoline;
+    AppendBackupCode(trampoline);
+    AppendCallToEntryPayload(0, 0, 0, trampoline);
+    AppendRestoreCode(trampoline);
+    const uint64_t size =
+        trampoline.GetResultAsVector().size() + kMaxRelocatedPrologueSize + kSizeOfJmpRel32;
+    return (size + kTrampolineAlignment - 1) / kTrampolineAlignment * kTrampolineAlignment;
+  }();
+  return kMaxTrampolineSize;
+}
+
+ErrorMessageOr<uint64_t> CreateTrampoline(pid_t pid, uint64_t function_address,
+                                          const std::vector<uint8_t>& function,
+                                          uint64_t trampoline_address,
+                                          uint64_t entry_payload_function_address,
+                                          uint64_t return_trampoline_address, uint64_t function_id,
+                                          csh capstone_handle,
+                                          absl::flat_hash_map<uint64_t, uint64_t>& relocation_map) {
+  if (function.size() < kSizeOfJmpRel32) {
+    return ErrorMessage(absl::StrFormat(
+        "Function at %#x is too small to be instrumented (%u bytes).", function_address,
+        function.size()));
+  }
+  OUTCOME_TRY(CheckForRelativeJumpIntoOverwrittenBytes(function_address, function,
+                                                       capstone_handle));
+
+  MachineCode trampoline;
+  AppendBackupCode(trampoline);
+  AppendCallToEntryPayload(entry_payload_function_address, return_trampoline_address,
+                           function_id, trampoline);
+  AppendRestoreCode(trampoline);
+
+  // Relocate the instructions that get overwritten by the jump into the trampoline.
+  std::unique_ptr<cs_insn, void (*)(cs_insn*)> instruction{
+      cs_malloc(capstone_handle), [](cs_insn* insn) { cs_free(insn, 1); }};
+  const uint8_t* code_pointer = function.data();
+  size_t code_size = function.size();
+  uint64_t disassemble_address = function_address;
+  std::vector<std::pair<uint64_t, uint64_t>> relocations;
+  uint64_t relocated_bytes = 0;
+  while (relocated_bytes < kSizeOfJmpRel32) {
+    if (!cs_disasm_iter(capstone_handle, &code_pointer, &code_size, &disassemble_address,
+                        instruction.get())) {
+      return ErrorMessage(
+          absl::StrFormat("Unable to disassemble the beginning of the function at %#x.",
+                          function_address));
+    }
+    const uint64_t relocated_address = trampoline_address + trampoline.GetResultAsVector().size();
+    OUTCOME_TRY(relocated_instruction, RelocateInstruction(instruction.get(), relocated_address));
+    trampoline.AppendBytes(relocated_instruction);
+    // A thread halted at the very beginning of the function will just take the jump into the
+    // trampoline, so there is no need to move it.
+    if (instruction->address != function_address) {
+      relocations.emplace_back(instruction->address, relocated_address);
+    }
+    relocated_bytes += instruction->size;
+  }
+
+  const uint64_t address_after_prologue = function_address + relocated_bytes;
+  OUTCOME_TRY(AppendJmpRel32(trampoline_address + trampoline.GetResultAsVector().size(),
+                             address_after_prologue, trampoline));
+  CHECK(trampoline.GetResultAsVector().size() <= GetMaxTrampolineSize());
+
+  OUTCOME_TRY(WriteTraceesMemory(pid, trampoline_address, trampoline.GetResultAsVector()));
+  for (const auto& [original_address, relocated_address] : relocations) {
+    relocation_map.insert_or_assign(original_address, relocated_address);
+  }
+  return address_after_prologue;
+}
+
+uint64_t GetReturnTrampolineSize() {
+  static const uint64_t kReturnTrampolineSize = []() {
+    MachineCode code;
+    AppendReturnTrampoline(0, code);
+    return (code.GetResultAsVector().size() + kTrampolineAlignment - 1) / kTrampolineAlignment *
+           kTrampolineAlignment;
+  }();
+  return kReturnTrampolineSize;
+}
+
+ErrorMessageOr<void> CreateReturnTrampoline(pid_t pid, uint64_t exit_payload_function_address,
+                                            uint64_t return_trampoline_address) {
+  MachineCode code;
+  AppendReturnTrampoline(exit_payload_function_address, code);
+  return WriteTraceesMemory(pid, return_trampoline_address, code.GetResultAsVector());
+}
+
+ErrorMessageOr<std::vector<uint8_t>> InstrumentFunction(pid_t pid, uint64_t function_address,
+                                                        uint64_t trampoline_address) {
+  OUTCOME_TRY(original_bytes, ReadTraceesMemory(pid, function_address, sizeof(uint64_t)));
+  MachineCode jump;
+  OUTCOME_TRY(AppendJmpRel32(function_address, trampoline_address, jump));
+  std::vector<uint8_t> code = original_bytes;
+  std::copy(jump.GetResultAsVector().begin(), jump.GetResultAsVector().end(), code.begin());
+  OUTCOME_TRY(WriteTraceesMemory(pid, function_address, code));
+  return original_bytes;
+}
+
+ErrorMessageOr<void> MoveInstructionPointersOutOfOverwrittenCode(
+    pid_t pid, const absl::flat_hash_map<uint64_t, uint64_t>& relocation_map) {
+  for (pid_t tid : orbit_base::GetTidsOfProcess(pid)) {
+    RegisterState registers;
+    OUTCOME_TRY(registers.BackupRegisters(tid));
+    if (registers.GetBitness() != RegisterState::Bitness::k64Bit) continue;
+    uint64_t& rip = registers.GetGeneralPurposeRegisters()->x86_64.rip;
+    auto relocation = relocation_map.find(rip);
+    if (relocation == relocation_map.end()) continue;
+    rip = relocation->second;
+    OUTCOME_TRY(registers.RestoreRegisters());
+  }
+  return outcome::success();
+}
+
 }  // namespace orbit_user_space_instrumentation
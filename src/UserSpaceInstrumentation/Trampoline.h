@@ -5,6 +5,8 @@
 #ifndef USER_SPACE_INSTRUMENTATION_TRAMPOLINE_H_
 #define USER_SPACE_INSTRUMENTATION_TRAMPOLINE_H_
 
+#include <absl/container/flat_hash_map.h>
+#include <capstone/capstone.h>
 #include <sys/types.h>
 
 #include <cstdint>
@@ -12,17 +14,11 @@
 #include <utility>
 #include <vector>
 
+#include "AddressRange.h"
 #include "OrbitBase/Result.h"
 
 namespace orbit_user_space_instrumentation {
 
-struct AddressRange {
-  AddressRange() = default;
-  AddressRange(uint64_t s, uint64_t e) : start(s), end(e) {}
-  uint64_t start;
-  uint64_t end;
-};
-
 // Returns true if the ranges overlap (touching ranges do not count as overlapping). Assumes that
 // the ranges are well formed (.first < .second).
 [[nodiscard]] bool DoAddressRangesOverlap(const AddressRange& a, const AddressRange& b);
@@ -62,6 +58,75 @@ struct AddressRange {
                                                                     const AddressRange& code_range,
                                                                     uint64_t size);
 
+// Returns the machine code of `instruction` relocated from `instruction->address` to
+// `new_address`. Relative addressing (rip relative operands, relative jumps and calls) is adjusted
+// such that the relocated instruction behaves exactly like the original one. Relative jumps and
+// calls are rewritten as indirect jumps and calls to absolute addresses; conditional jumps become a
+// conditional short jump with the inverted condition around an absolute jump. Returns an error
+// for instructions that cannot be relocated (e.g. `loop` or `jrcxz`, or rip relative operands
+// whose target is out of reach of a 32 bit displacement from `new_address`).
+// `instruction` needs to be disassembled with CS_OPT_DETAIL turned on.
+[[nodiscard]] ErrorMessageOr<std::vector<uint8_t>> RelocateInstruction(cs_insn* instruction,
+                                                                       uint64_t new_address);
+
+// Returns an upper bound for the size of the trampolines created by `CreateTrampoline`.
+[[nodiscard]] uint64_t GetMaxTrampolineSize();
+
+// Creates a trampoline for the function at `function_address` at `trampoline_address` in the
+// tracee. `function` contains the machine code of the complete function as read from the tracee
+// (its length is the size of the function). The trampoline backs up the general purpose registers
+// used for passing parameters and the complete x87 and vector register state, calls
+// `entry_payload_function_address` with the location of the return address on the stack,
+// `function_id` and `return_trampoline_address` as parameters, and restores the registers.
+// It then executes the instructions of the function that will be overwritten by the jump into the
+// trampoline (relocated to the trampoline) and jumps back into the function right behind them.
+// `relocation_map` receives the mapping from the addresses of the relocated instructions in the
+// function to their addresses in the trampoline (compare
+// `MoveInstructionPointersOutOfOverwrittenCode`).
+// Returns the address in the function where the trampoline jumps back to.
+// Fails if the function is too small to be overwritten with a jump, if the overwritten instructions
+// cannot be relocated or if there is a relative jump in the function targeting the overwritten
+// bytes.
+// Assumes we are already attached to the tracee `pid` e.g. using `AttachAndStopProcess`.
+[[nodiscard]] ErrorMessageOr<uint64_t> CreateTrampoline(
+    pid_t pid, uint64_t function_address, const std::vector<uint8_t>& function,
+    uint64_t trampoline_address, uint64_t entry_payload_function_address,
+    uint64_t return_trampoline_address, uint64_t function_id, csh capstone_handle,
+    absl::flat_hash_map<uint64_t, uint64_t>& relocation_map);
+
+// Returns the size of the return trampoline created by `CreateReturnTrampoline`.
+[[nodiscard]] uint64_t GetReturnTrampolineSize();
+
+// Creates the return trampoline at `return_trampoline_address` in the tracee. The entry payload
+// overwrites the return address of an instrumented function with the address of the return
+// trampoline. So when the function returns, the return trampoline backs up all registers that can
+// hold the return value (rax, rdx, the complete x87 and vector register state), calls
+// `exit_payload_function_address` with the integer return value as parameter and restores the
+// registers. The exit payload returns the original return address which
+// the return trampoline finally returns to. One return trampoline can be shared by all instrumented
+// functions.
+// Assumes we are already attached to the tracee `pid` e.g. using `AttachAndStopProcess`.
+[[nodiscard]] ErrorMessageOr<void> CreateReturnTrampoline(pid_t pid,
+                                                          uint64_t exit_payload_function_address,
+                                                          uint64_t return_trampoline_address);
+
+// Overwrites the beginning of the function at `function_address` with a jump into the trampoline at
+// `trampoline_address`. Returns the original bytes that were overwritten (this is a multiple of
+// eight bytes; compare `WriteTraceesMemory`) such that the function can be restored with
+// `WriteTraceesMemory`.
+// Assumes we are already attached to the tracee `pid` e.g. using `AttachAndStopProcess`.
+[[nodiscard]] ErrorMessageOr<std::vector<uint8_t>> InstrumentFunction(pid_t pid,
+                                                                      uint64_t function_address,
+                                                                      uint64_t trampoline_address);
+
+// When the beginning of a function gets overwritten with a jump into its trampoline, a thread of
+// the tracee might be halted with its instruction pointer inside the overwritten bytes. This
+// function moves the instruction pointers of all such threads of process `pid` to the relocated
+// instruction in the trampoline as given by `relocation_map` (compare `CreateTrampoline`).
+// Assumes we are already attached to the tracee `pid` e.g. using `AttachAndStopProcess`.
+[[nodiscard]] ErrorMessageOr<void> MoveInstructionPointersOutOfOverwrittenCode(
+    pid_t pid, const absl::flat_hash_map<uint64_t, uint64_t>& relocation_map);
+
 }  // namespace orbit_user_space_instrumentation
 
 #endif  // USER_SPACE_INSTRUMENTATION_TRAMPOLINE_H_
\ No newline at end of file
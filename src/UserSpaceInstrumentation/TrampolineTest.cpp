@@ -4,6 +4,8 @@
 
 #include <absl/strings/numbers.h>
 #include <absl/strings/str_split.h>
+#include <capstone/capstone.h>
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <cstdint>
@@ -16,6 +18,7 @@
 #include "ElfUtils/LinuxMap.h"
 #include "OrbitBase/Logging.h"
 #include "OrbitBase/ReadFileToString.h"
+#include "OrbitBase/Result.h"
 #include "Trampoline.h"
 
 namespace orbit_user_space_instrumentation {
@@ -256,4 +259,106 @@ TEST(TrampolineTest, AllocateMemoryForTrampolines) {
   waitpid(pid, nullptr, 0);
 }
 
+class RelocateInstructionTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    CHECK(cs_open(CS_ARCH_X86, CS_MODE_64, &capstone_handle_) == CS_ERR_OK);
+    CHECK(cs_option(capstone_handle_, CS_OPT_DETAIL, CS_OPT_ON) == CS_ERR_OK);
+    instruction_ = cs_malloc(capstone_handle_);
+    CHECK(instruction_ != nullptr);
+  }
+
+  void TearDown() override {
+    cs_free(instruction_, 1);
+    cs_close(&capstone_handle_);
+  }
+
+  // Disassembles the single instruction in `code` placed at `address` into `instruction_`.
+  void Disassemble(const std::vector<uint8_t>& code, uint64_t address) {
+    const uint8_t* code_pointer = code.data();
+    size_t code_size = code.size();
+    CHECK(cs_disasm_iter(capstone_handle_, &code_pointer, &code_size, &address, instruction_));
+    CHECK(code_size == 0);
+  }
+
+  csh capstone_handle_ = 0;
+  cs_insn* instruction_ = nullptr;
+};
+
+TEST_F(RelocateInstructionTest, RipRelativeAddressing) {
+  // add rax, [rip + 0x969]
+  Disassemble({0x48, 0x03, 0x05, 0x69, 0x09, 0x00, 0x00}, 0x0100000000);
+  ErrorMessageOr<std::vector<uint8_t>> result = RelocateInstruction(instruction_, 0x0100010000);
+  ASSERT_TRUE(result.has_value()) << result.error().message();
+  // The displacement is 0x969 - 0x10000 = 0xffff0969 now.
+  EXPECT_THAT(result.value(), testing::ElementsAre(0x48, 0x03, 0x05, 0x69, 0x09, 0xff, 0xff));
+
+  // The target is out of reach of a 32 bit displacement from the new address.
+  result = RelocateInstruction(instruction_, 0x0200000000);
+  ASSERT_TRUE(result.has_error());
+  EXPECT_THAT(result.error().message(), testing::HasSubstr("out of reach"));
+}
+
+TEST_F(RelocateInstructionTest, UnconditionalJumps) {
+  // jmp $ + 10
+  Disassemble({0xeb, 0x08}, 0x0100000000);
+  ErrorMessageOr<std::vector<uint8_t>> result = RelocateInstruction(instruction_, 0x0200000000);
+  ASSERT_TRUE(result.has_value()) << result.error().message();
+  EXPECT_THAT(result.value(), testing::ElementsAre(0xff, 0x25, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00,
+                                                   0x00, 0x00, 0x01, 0x00, 0x00, 0x00));
+
+  // jmp $ + 0x04030206
+  Disassemble({0xe9, 0x01, 0x02, 0x03, 0x04}, 0x0100000000);
+  result = RelocateInstruction(instruction_, 0x0200000000);
+  ASSERT_TRUE(result.has_value()) << result.error().message();
+  EXPECT_THAT(result.value(), testing::ElementsAre(0xff, 0x25, 0x00, 0x00, 0x00, 0x00, 0x06, 0x02,
+                                                   0x03, 0x04, 0x01, 0x00, 0x00, 0x00));
+}
+
+TEST_F(RelocateInstructionTest, Call) {
+  // call $ + 0x04030206
+  Disassemble({0xe8, 0x01, 0x02, 0x03, 0x04}, 0x0100000000);
+  ErrorMessageOr<std::vector<uint8_t>> result = RelocateInstruction(instruction_, 0x0200000000);
+  ASSERT_TRUE(result.has_value()) << result.error().message();
+  EXPECT_THAT(result.value(),
+              testing::ElementsAre(0xff, 0x15, 0x02, 0x00, 0x00, 0x00, 0xeb, 0x08, 0x06, 0x02,
+                                   0x03, 0x04, 0x01, 0x00, 0x00, 0x00));
+}
+
+TEST_F(RelocateInstructionTest, ConditionalJumps) {
+  // je $ + 10
+  Disassemble({0x74, 0x08}, 0x0100000000);
+  ErrorMessageOr<std::vector<uint8_t>> result = RelocateInstruction(instruction_, 0x0200000000);
+  ASSERT_TRUE(result.has_value()) << result.error().message();
+  // jne $ + 16; jmp [rip + 0]; .quad target
+  EXPECT_THAT(result.value(),
+              testing::ElementsAre(0x75, 0x0e, 0xff, 0x25, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00,
+                                   0x00, 0x00, 0x01, 0x00, 0x00, 0x00));
+
+  // jge $ + 0x04030207
+  Disassemble({0x0f, 0x8d, 0x01, 0x02, 0x03, 0x04}, 0x0100000000);
+  result = RelocateInstruction(instruction_, 0x0200000000);
+  ASSERT_TRUE(result.has_value()) << result.error().message();
+  // jl $ + 16; jmp [rip + 0]; .quad target
+  EXPECT_THAT(result.value(),
+              testing::ElementsAre(0x7c, 0x0e, 0xff, 0x25, 0x00, 0x00, 0x00, 0x00, 0x07, 0x02,
+                                   0x03, 0x04, 0x01, 0x00, 0x00, 0x00));
+}
+
+TEST_F(RelocateInstructionTest, LoopIsUnsupported) {
+  // loop $ + 10
+  Disassemble({0xe2, 0x08}, 0x0100000000);
+  ErrorMessageOr<std::vector<uint8_t>> result = RelocateInstruction(instruction_, 0x0200000000);
+  ASSERT_TRUE(result.has_error());
+  EXPECT_THAT(result.error().message(), testing::HasSubstr("not supported"));
+}
+
+TEST_F(RelocateInstructionTest, OtherInstructionsAreCopied) {
+  // mov rbp, rsp
+  Disassemble({0x48, 0x89, 0xe5}, 0x0100000000);
+  ErrorMessageOr<std::vector<uint8_t>> result = RelocateInstruction(instruction_, 0x0200000000);
+  ASSERT_TRUE(result.has_value()) << result.error().message();
+  EXPECT_THAT(result.value(), testing::ElementsAre(0x48, 0x89, 0xe5));
+}
+
 }  // namespace orbit_user_space_instrumentation
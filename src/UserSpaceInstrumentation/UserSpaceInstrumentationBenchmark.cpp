@@ -0,0 +1,242 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares the overhead of a call to an instrumented function with user space instrumentation and
+// with uprobes. A child process calls a small function in a loop and measures the time per call,
+// first without instrumentation, then with the function instrumented in user space, then with
+// uprobes. This process plays the role of OrbitService: it instruments the child and receives the
+// resulting events. Uprobes require the same privileges as OrbitService. The benchmarked function
+// is `TripleAndDecrement` in libUserSpaceInstrumentationTestLib.so, as functions in modules with
+// exception handling code (like this executable) are not instrumented in user space.
+
+#include <absl/strings/str_format.h>
+#include <dlfcn.h>
+#include <grpcpp/grpcpp.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "ElfUtils/ElfFile.h"
+#include "LinuxTracing/Tracer.h"
+#include "LinuxTracing/TracerListener.h"
+#include "OrbitBase/ExecutablePath.h"
+#include "OrbitBase/Logging.h"
+#include "OrbitBase/Profiling.h"
+#include "OrbitBase/Result.h"
+#include "UserSpaceInstrumentation/InstrumentationManager.h"
+#include "capture.pb.h"
+#include "producer_side_services.grpc.pb.h"
+#include "symbol.pb.h"
+
+namespace {
+
+using orbit_grpc_protos::CaptureOptions;
+using orbit_grpc_protos::InstrumentedFunction;
+using orbit_grpc_protos::ReceiveCommandsAndSendEventsRequest;
+using orbit_grpc_protos::ReceiveCommandsAndSendEventsResponse;
+using orbit_user_space_instrumentation::InstrumentationManager;
+
+constexpr uint64_t kNumCalls = 1'000'000;
+constexpr uint64_t kFunctionId = 1;
+constexpr const char* kLibName = "libUserSpaceInstrumentationTestLib.so";
+constexpr const char* kFunctionName = "TripleAndDecrement";
+
+// The path of the library containing the benchmarked function as it appears in /proc/pid/maps.
+[[nodiscard]] std::filesystem::path GetLibraryPath() {
+  return std::filesystem::canonical(orbit_base::GetExecutableDir() / ".." / "lib" / kLibName);
+}
+
+// Starts a capture in every producer that connects and counts the FunctionCall events received.
+class CountingProducerSideService final : public orbit_grpc_protos::ProducerSideService::Service {
+ public:
+  grpc::Status ReceiveCommandsAndSendEvents(
+      grpc::ServerContext* /*context*/,
+      grpc::ServerReaderWriter<ReceiveCommandsAndSendEventsResponse,
+                               ReceiveCommandsAndSendEventsRequest>* stream) override {
+    ReceiveCommandsAndSendEventsResponse command;
+    command.mutable_start_capture_command();
+    if (!stream->Write(command)) return grpc::Status::CANCELLED;
+    num_producers_capturing_ += 1;
+
+    ReceiveCommandsAndSendEventsRequest request;
+    while (stream->Read(&request)) {
+      for (const auto& event : request.buffered_capture_events().capture_events()) {
+        if (event.has_function_call()) num_function_calls_ += 1;
+      }
+    }
+    return grpc::Status::OK;
+  }
+
+  [[nodiscard]] uint64_t GetNumProducersCapturing() const { return num_producers_capturing_; }
+  [[nodiscard]] uint64_t GetNumFunctionCalls() const { return num_function_calls_; }
+
+ private:
+  std::atomic<uint64_t> num_producers_capturing_ = 0;
+  std::atomic<uint64_t> num_function_calls_ = 0;
+};
+
+class CountingTracerListener : public orbit_linux_tracing::TracerListener {
+ public:
+  void OnSchedulingSlice(orbit_grpc_protos::SchedulingSlice /*scheduling_slice*/) override {}
+  void OnCallstackSample(orbit_grpc_protos::FullCallstackSample /*callstack_sample*/) override {}
+  void OnFunctionCall(orbit_grpc_protos::FunctionCall /*function_call*/) override {
+    num_function_calls_ += 1;
+  }
+  void OnIntrospectionScope(
+      orbit_grpc_protos::IntrospectionScope /*introspection_scope*/) override {}
+  void OnGpuJob(orbit_grpc_protos::FullGpuJob /*gpu_job*/) override {}
+  void OnThreadName(orbit_grpc_protos::ThreadName /*thread_name*/) override {}
+  void OnThreadStateSlice(orbit_grpc_protos::ThreadStateSlice /*thread_state_slice*/) override {}
+  void OnAddressInfo(orbit_grpc_protos::FullAddressInfo /*full_address_info*/) override {}
+  void OnTracepointEvent(orbit_grpc_protos::FullTracepointEvent /*tracepoint_event*/) override {}
+  void OnModuleUpdate(orbit_grpc_protos::ModuleUpdateEvent /*module_update_event*/) override {}
+
+  [[nodiscard]] uint64_t GetNumFunctionCalls() const { return num_function_calls_; }
+
+ private:
+  std::atomic<uint64_t> num_function_calls_ = 0;
+};
+
+// Runs in the child process: for each byte read from `command_fd` calls the benchmarked function
+// `kNumCalls` times and writes the elapsed nanoseconds to `result_fd`.
+[[noreturn]] void RunChild(int command_fd, int result_fd) {
+  void* library_handle = dlopen(GetLibraryPath().c_str(), RTLD_NOW);
+  FAIL_IF(library_handle == nullptr, "Unable to load \"%s\".", kLibName);
+  auto* benchmarked_function = reinterpret_cast<int (*)(int)>(dlsym(library_handle, kFunctionName));
+  FAIL_IF(benchmarked_function == nullptr, "Unable to find \"%s\".", kFunctionName);
+
+  char command = 0;
+  while (read(command_fd, &command, 1) == 1) {
+    volatile int sum = 0;
+    const uint64_t start_ns = orbit_base::CaptureTimestampNs();
+    for (uint64_t i = 0; i < kNumCalls; ++i) {
+      sum = sum + benchmarked_function(static_cast<int>(i & 0xff));
+    }
+    const uint64_t duration_ns = orbit_base::CaptureTimestampNs() - start_ns;
+    if (write(result_fd, &duration_ns, sizeof(duration_ns)) != sizeof(duration_ns)) break;
+  }
+  _exit(0);
+}
+
+[[nodiscard]] double MeasureNsPerCall(int command_fd, int result_fd) {
+  const char command = 'r';
+  CHECK(write(command_fd, &command, 1) == 1);
+  uint64_t duration_ns = 0;
+  CHECK(read(result_fd, &duration_ns, sizeof(duration_ns)) == sizeof(duration_ns));
+  return static_cast<double>(duration_ns) / kNumCalls;
+}
+
+// Fills in the InstrumentedFunction for the benchmarked function.
+[[nodiscard]] ErrorMessageOr<InstrumentedFunction> GetBenchmarkedFunction() {
+  const std::filesystem::path library_path = GetLibraryPath();
+  OUTCOME_TRY(elf_file, orbit_elf_utils::ElfFile::Create(library_path));
+  OUTCOME_TRY(symbols, elf_file->LoadSymbolsFromDynsym());
+  for (const auto& symbol : symbols.symbol_infos()) {
+    if (symbol.name() != kFunctionName) continue;
+    InstrumentedFunction function;
+    function.set_file_path(library_path.string());
+    function.set_file_offset(symbol.address() - symbols.load_bias());
+    function.set_function_id(kFunctionId);
+    function.set_function_size(symbol.size());
+    return function;
+  }
+  return ErrorMessage(absl::StrFormat("Unable to find \"%s\" in the symbols.", kFunctionName));
+}
+
+}  // namespace
+
+int main() {
+  auto function_or_error = GetBenchmarkedFunction();
+  FAIL_IF(function_or_error.has_error(), "%s", function_or_error.error().message());
+
+  int command_pipe[2];
+  int result_pipe[2];
+  CHECK(pipe(command_pipe) == 0);
+  CHECK(pipe(result_pipe) == 0);
+  const pid_t pid = fork();
+  CHECK(pid != -1);
+  if (pid == 0) RunChild(command_pipe[0], result_pipe[1]);
+  const int command_fd = command_pipe[1];
+  const int result_fd = result_pipe[0];
+
+  // The server is only started after forking, so the child does not inherit any gRPC state. It
+  // listens on its own socket, so OrbitService can keep running.
+  const std::string socket_path =
+      absl::StrFormat("/tmp/orbit-user-space-instrumentation-benchmark-%d", getpid());
+  CountingProducerSideService producer_side_service;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(absl::StrFormat("unix:%s", socket_path),
+                           grpc::InsecureServerCredentials());
+  builder.RegisterService(&producer_side_service);
+  std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+  FAIL_IF(server == nullptr, "Unable to listen on \"%s\".", socket_path);
+
+  CaptureOptions capture_options;
+  capture_options.set_pid(pid);
+  *capture_options.add_instrumented_functions() = function_or_error.value();
+
+  // Warm up, then measure without instrumentation.
+  (void)MeasureNsPerCall(command_fd, result_fd);
+  const double baseline_ns = MeasureNsPerCall(command_fd, result_fd);
+
+  // User space instrumentation. The payload library connects to the producer side service in this
+  // process once it got injected.
+  std::unique_ptr<InstrumentationManager> instrumentation_manager =
+      InstrumentationManager::Create(socket_path);
+  auto instrumented_function_ids = instrumentation_manager->InstrumentProcess(capture_options);
+  FAIL_IF(instrumented_function_ids.has_error(), "Unable to instrument: %s",
+          instrumented_function_ids.error().message());
+  FAIL_IF(!instrumented_function_ids.value().contains(kFunctionId),
+          "\"%s\" could not be instrumented in user space.", kFunctionName);
+  const auto wait_start = std::chrono::steady_clock::now();
+  while (producer_side_service.GetNumProducersCapturing() == 0 &&
+         std::chrono::steady_clock::now() - wait_start < std::chrono::seconds(10)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  FAIL_IF(producer_side_service.GetNumProducersCapturing() == 0,
+          "The payload library did not connect.");
+  const double user_space_instrumentation_ns = MeasureNsPerCall(command_fd, result_fd);
+  auto uninstrument_result = instrumentation_manager->UninstrumentProcess(pid);
+  FAIL_IF(uninstrument_result.has_error(), "Unable to uninstrument: %s",
+          uninstrument_result.error().message());
+
+  // Uprobes.
+  CountingTracerListener tracer_listener;
+  orbit_linux_tracing::Tracer tracer{capture_options};
+  tracer.SetListener(&tracer_listener);
+  tracer.Start();
+  // There is no notification for when the uprobes are opened.
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  const double uprobes_ns = MeasureNsPerCall(command_fd, result_fd);
+  tracer.Stop();
+
+  close(command_fd);
+  waitpid(pid, nullptr, 0);
+  server->Shutdown();
+  std::error_code error;
+  std::filesystem::remove(socket_path, error);
+
+  LOG("Overhead per call (%u calls):", kNumCalls);
+  LOG("  no instrumentation:         %8.1f ns", baseline_ns);
+  LOG("  user space instrumentation: %8.1f ns (+%.1f ns, %u events received)",
+      user_space_instrumentation_ns, user_space_instrumentation_ns - baseline_ns,
+      producer_side_service.GetNumFunctionCalls());
+  if (tracer_listener.GetNumFunctionCalls() == 0) {
+    LOG("  uprobes:                    no events received, uprobes are not available");
+  } else {
+    LOG("  uprobes:                    %8.1f ns (+%.1f ns, %u events received)", uprobes_ns,
+        uprobes_ns - baseline_ns, tracer_listener.GetNumFunctionCalls());
+  }
+  return 0;
+}
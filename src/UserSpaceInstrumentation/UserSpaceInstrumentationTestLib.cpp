@@ -4,4 +4,6 @@
 
 #include "UserSpaceInstrumentationTestLib.h"
 
-int TrivialFunction() { return 42; }
\ No newline at end of file
+int TrivialFunction() { return 42; }
+
+int TripleAndDecrement(int i) { return 3 * i - 1; }
@@ -11,4 +11,7 @@
 // Returns 42.
 extern "C" int TrivialFunction();
 
+// Returns 3 * i - 1. Instrumented by the tests of InstrumentationManager.
+extern "C" int TripleAndDecrement(int i);
+
 #endif  // USER_SPACE_INSTRUMENTATION_TEST_LIB_H_
\ No newline at end of file
@@ -0,0 +1,65 @@
+// Copyright (c) 2021 The Orbit Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef USER_SPACE_INSTRUMENTATION_INSTRUMENTATION_MANAGER_H_
+#define USER_SPACE_INSTRUMENTATION_INSTRUMENTATION_MANAGER_H_
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <sys/types.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "OrbitBase/Result.h"
+#include "capture.pb.h"
+
+namespace orbit_user_space_instrumentation {
+
+class InstrumentedProcess;
+
+// Instruments functions in user space as a low overhead alternative to uprobes: the beginning of
+// an instrumented function is overwritten with a jump into a trampoline that calls into a payload
+// library injected into the target process (libOrbitUserSpaceInstrumentation.so). The payloads
+// record entry and exit of the function and send FunctionCall events to OrbitService.
+//
+// The payload library, the trampolines and the return trampoline stay in the target process after a
+// capture; only the jumps into the trampolines are removed. This keeps threads that are inside an
+// instrumented function at that point safe, and makes instrumenting the same functions in the next
+// capture cheap.
+//
+// Limitations: the return address of an instrumented function is replaced while the function
+// executes, so exceptions can't be unwound through an instrumented function. Functions in modules
+// with exception handling code (a .gcc_except_table section) are left to uprobes for that reason.
+// Functions left by longjmp leave stale entries behind. Only 64 bit processes are supported.
+class InstrumentationManager {
+ public:
+  // The payload library sends its events over the producer side channel at
+  // `producer_side_unix_domain_socket_path`, by default the one OrbitService listens on.
+  [[nodiscard]] static std::unique_ptr<InstrumentationManager> Create();
+  [[nodiscard]] static std::unique_ptr<InstrumentationManager> Create(
+      std::string producer_side_unix_domain_socket_path);
+  ~InstrumentationManager();
+
+  // Instruments the functions in `capture_options.instrumented_functions()` in the process
+  // `capture_options.pid()`. Returns the ids of the functions that were instrumented. The remaining
+  // functions (e.g. functions too small to be overwritten with a jump) are expected to be
+  // instrumented with uprobes.
+  [[nodiscard]] ErrorMessageOr<absl::flat_hash_set<uint64_t>> InstrumentProcess(
+      const orbit_grpc_protos::CaptureOptions& capture_options);
+
+  // Removes the jumps into the trampolines from all functions instrumented in process `pid`.
+  [[nodiscard]] ErrorMessageOr<void> UninstrumentProcess(pid_t pid);
+
+ private:
+  explicit InstrumentationManager(std::string producer_side_unix_domain_socket_path);
+
+  std::string producer_side_unix_domain_socket_path_;
+  absl::flat_hash_map<pid_t, std::unique_ptr<InstrumentedProcess>> process_map_;
+};
+
+}  // namespace orbit_user_space_instrumentation
+
+#endif  // USER_SPACE_INSTRUMENTATION_INSTRUMENTATION_MANAGER_H_